@@ -5,6 +5,8 @@ class Prices
     this.req   = [];
     this.sub   = [];
     this.reuse = [];
+    this.acc   = {};
+    this.ids   = [];
     this.fact  = [ 0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9, 1e-10 ];
   }
   send( msg, callback ) {
@@ -28,46 +30,57 @@ class Prices
   on_notify( msg ) {
     this.sub[msg.params.subscription]( msg );
   }
-  draw_cell( cell, txt, color ) {
-    cell.textContent = txt;
-    cell.style.color = color;
+  on_dashboard( msg ) {
+    // one message per slot carrying only the fields that changed.
+    // prices are referred to by id once their account has been seen
+    let res = msg.params.result;
+    for( let i = 0; i != res.length; ++i ) {
+      let upd = res[i];
+      if ( 'account' in upd ) {
+        this.ids[upd.id] = this.acc[upd.account];
+      }
+      let pxa = this.ids[upd.id];
+      if ( pxa ) {
+        this.on_price( pxa, upd );
+      }
+    }
   }
-  on_price( pxa, msg ) {
+  on_price( pxa, upd ) {
     let tab = document.getElementById( "prices" );
     let row = tab.rows[pxa.idx];
-    let res = msg.params.result;
-    let col = 0;
     let expo = -pxa.price_exponent;
-    let px   = res.price * this.fact[expo];
-    let conf = res.conf * this.fact[expo];
-    let twap = res.twap * this.fact[expo];
-    let twac = res.twac * this.fact[expo];
-    let color = 'cornsilk';
-    if ( res.status == 'unknown' ) {
-      color = '#c0392b';
+    let fact = this.fact[expo];
+    if ( 'status' in upd ) {
+      let color = upd.status == 'unknown' ? '#c0392b' : 'cornsilk';
+      for( let col = 0; col != row.cells.length; ++col ) {
+        row.cells[col].style.color = color;
+      }
+      row.cells[8].textContent = upd.status;
     }
-    row.cells[col++].style.color = color;
-    row.cells[col++].style.color = color;
-    row.cells[col++].style.color = color;
-    row.cells[col++].style.color = color;
-    this.draw_cell( row.cells[col++], px.toFixed(expo), color );
-    this.draw_cell( row.cells[col++], conf.toFixed(expo), color );
-    this.draw_cell( row.cells[col++], twap.toFixed(expo), color );
-    this.draw_cell( row.cells[col++], twac.toFixed(expo), color );
-    this.draw_cell( row.cells[col++], res.status, color );
-    this.draw_cell( row.cells[col++], res.num_qt, color );
-    this.draw_cell( row.cells[col++], res.valid_slot, color );
-    this.draw_cell( row.cells[col++], res.pub_slot, color );
-    row.cells[col++].style.color = color;
-    row.cells[col++].style.color = color;
-    row.cells[col++].style.color = color;
-  }
-  get_price( sym, msg ) {
-    let sub_id = msg.result.subscription;
-    while( sub_id < this.sub.length ) {
-      this.sub.append( 0 )
+    if ( 'price' in upd ) {
+      row.cells[4].textContent = (upd.price * fact).toFixed(expo);
     }
-    this.sub[sub_id] = this.on_price.bind( this, sym );
+    if ( 'conf' in upd ) {
+      row.cells[5].textContent = (upd.conf * fact).toFixed(expo);
+    }
+    if ( 'twap' in upd ) {
+      row.cells[6].textContent = (upd.twap * fact).toFixed(expo);
+    }
+    if ( 'twac' in upd ) {
+      row.cells[7].textContent = (upd.twac * fact).toFixed(expo);
+    }
+    if ( 'num_qt' in upd ) {
+      row.cells[9].textContent = upd.num_qt;
+    }
+    if ( 'valid_slot' in upd ) {
+      row.cells[10].textContent = upd.valid_slot;
+    }
+    if ( 'pub_slot' in upd ) {
+      row.cells[11].textContent = upd.pub_slot;
+    }
+  }
+  get_dashboard( msg ) {
+    this.sub[msg.result.subscription] = this.on_dashboard.bind( this );
   }
   get_title( att, title ) {
     let td = document.createElement( 'TD' )
@@ -109,16 +122,12 @@ class Prices
         row.appendChild( this.get_title( att, 'tenor') );
         row.appendChild( this.get_title( att, 'quote_currency') );
         row.appendChild( this.get_title( att, 'description') );
-        let msg = {
-          'method' : 'subscribe_price',
-          'params' : {
-            'account' : pxa['account']
-           }
-        };
         pxa.idx = k;
-        this.send( msg, this.get_price.bind( this, pxa ) );
+        this.acc[pxa['account']] = pxa;
       }
     }
+    this.send( { 'method' : 'subscribe_dashboard' },
+               this.get_dashboard.bind( this ) );
   }
 }
 
@@ -0,0 +1,151 @@
+#include "acc_poll.hpp"
+#include "rpc_client.hpp"
+#include <algorithm>
+
+#define PC_POLL_MIN_INTERVAL  (400L*PC_NSECS_IN_MSEC)
+#define PC_POLL_MAX_INTERVAL  (12800L*PC_NSECS_IN_MSEC)
+
+using namespace pc;
+
+static uint64_t hash_data( str txt )
+{
+  uint64_t h = 14695981039346656037UL;
+  for( size_t i = 0; i != txt.len_; ++i ) {
+    h = ( h ^ (uint8_t)txt.str_[i] ) * 1099511628211UL;
+  }
+  return h;
+}
+
+acc_poll::acc_poll()
+: min_intv_( PC_POLL_MIN_INTERVAL ),
+  max_intv_( PC_POLL_MAX_INTERVAL ),
+  slot_( 0UL ),
+  num_poll_( 0UL ),
+  num_chg_( 0UL )
+{
+}
+
+void acc_poll::set_min_interval( int64_t intv )
+{
+  min_intv_ = intv;
+}
+
+int64_t acc_poll::get_min_interval() const
+{
+  return min_intv_;
+}
+
+void acc_poll::set_max_interval( int64_t intv )
+{
+  max_intv_ = intv;
+}
+
+int64_t acc_poll::get_max_interval() const
+{
+  return max_intv_;
+}
+
+void acc_poll::add_account( const pub_key& acc, bool is_fast, int64_t ts )
+{
+  if ( amap_.find( acc ) ) {
+    return;
+  }
+  amap_.ref( amap_.add( acc ) ) = static_cast< uint32_t >( evec_.size() );
+  entry e;
+  e.acc_     = acc;
+  e.intv_    = is_fast ? min_intv_ : std::max( min_intv_, max_intv_ );
+  e.next_ts_ = ts + e.intv_;
+  e.slot_    = 0UL;
+  e.hash_    = 0UL;
+  evec_.push_back( e );
+}
+
+unsigned acc_poll::get_num_accounts() const
+{
+  return static_cast< unsigned >( evec_.size() );
+}
+
+acc_poll::entry *acc_poll::get_entry( const pub_key& acc )
+{
+  acc_map_t::iter_t it = amap_.find( acc );
+  return it ? &evec_[amap_.obj( it )] : nullptr;
+}
+
+bool acc_poll::build( rpc::get_multiple_accounts *req, int64_t ts )
+{
+  due_.clear();
+  for( uint32_t i = 0; i != evec_.size(); ++i ) {
+    if ( evec_[i].next_ts_ <= ts ) {
+      due_.push_back( i );
+    }
+  }
+  if ( due_.empty() ) {
+    return false;
+  }
+  size_t num = std::min( due_.size(),
+      static_cast< size_t >( rpc::get_multiple_accounts::max_accounts ) );
+  std::partial_sort( due_.begin(), due_.begin() + (long)num, due_.end(),
+      [this]( uint32_t a, uint32_t b ) {
+        return evec_[a].next_ts_ < evec_[b].next_ts_;
+      } );
+  req->clear_accounts();
+  req->set_min_slot( slot_ );
+  for( size_t i = 0; i != num; ++i ) {
+    // not due again until answered or retried
+    entry& e = evec_[due_[i]];
+    e.next_ts_ = ts + max_intv_;
+    req->add_account( e.acc_ );
+  }
+  return true;
+}
+
+bool acc_poll::update( rpc::get_multiple_accounts *req, int64_t ts )
+{
+  slot_ = std::max( slot_, req->get_slot() );
+  entry *e = get_entry( *req->get_account() );
+  if ( !e ) {
+    return true;
+  }
+  ++num_poll_;
+  if ( req->get_slot() <= e->slot_ ) {
+    e->next_ts_ = ts + e->intv_;
+    return false;
+  }
+  e->slot_ = req->get_slot();
+  uint64_t h = hash_data( req->get_data_text() );
+  bool is_chg = h != e->hash_;
+  e->hash_ = h;
+  if ( is_chg ) {
+    e->intv_ = std::max( min_intv_, e->intv_ / 2 );
+    ++num_chg_;
+  } else {
+    e->intv_ = std::min( max_intv_, e->intv_ * 2 );
+  }
+  e->next_ts_ = ts + e->intv_;
+  return is_chg;
+}
+
+void acc_poll::retry( rpc::get_multiple_accounts *req, int64_t ts )
+{
+  for( unsigned i = 0; i != req->get_num_accounts(); ++i ) {
+    entry *e = get_entry( req->get_account_key( i ) );
+    if ( e ) {
+      e->next_ts_ = ts + min_intv_;
+    }
+  }
+}
+
+uint64_t acc_poll::get_slot() const
+{
+  return slot_;
+}
+
+uint64_t acc_poll::get_num_poll() const
+{
+  return num_poll_;
+}
+
+uint64_t acc_poll::get_num_change() const
+{
+  return num_chg_;
+}
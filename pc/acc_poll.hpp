@@ -0,0 +1,98 @@
+#pragma once
+
+#include <pc/key_pair.hpp>
+#include <pc/hash_map.hpp>
+#include <vector>
+
+namespace pc
+{
+
+  namespace rpc
+  {
+    class get_multiple_accounts;
+  }
+
+  // polls account data with getMultipleAccounts when the rpc node is
+  // used without websockets. each account has its own interval that is
+  // halved when a poll finds its data changed and doubled when not,
+  // within the minimum and maximum interval. requests carry the latest
+  // slot seen as minContextSlot so that a node lagging behind fails
+  // rather than serve older data, and replies that are not newer or
+  // not changed are not dispatched
+  class acc_poll
+  {
+  public:
+
+    acc_poll();
+
+    // bounds of the per-account polling interval in nanoseconds
+    void set_min_interval( int64_t );
+    int64_t get_min_interval() const;
+    void set_max_interval( int64_t );
+    int64_t get_max_interval() const;
+
+    // poll account from ts at the minimum interval if it is expected to
+    // change often (prices) or the maximum otherwise. accounts already
+    // polled are left as they are
+    void add_account( const pub_key&, bool is_fast, int64_t ts );
+    unsigned get_num_accounts() const;
+
+    // add accounts due at ts to request, most overdue first. false if
+    // none are due
+    bool build( rpc::get_multiple_accounts *, int64_t ts );
+
+    // reply for the current account of request at ts. false if its data
+    // is from a slot already seen or unchanged
+    bool update( rpc::get_multiple_accounts *, int64_t ts );
+
+    // request failed and its accounts are due again after the minimum
+    // interval
+    void retry( rpc::get_multiple_accounts *, int64_t ts );
+
+    // latest slot of any reply
+    uint64_t get_slot() const;
+
+    // accounts polled and found changed
+    uint64_t get_num_poll() const;
+    uint64_t get_num_change() const;
+
+  private:
+
+    struct trait_account {
+      typedef uint32_t        idx_t;
+      typedef pub_key         key_t;
+      typedef const pub_key&  keyref_t;
+      typedef uint32_t        val_t;
+      struct hash_t {
+        idx_t operator() ( keyref_t a ) {
+          uint64_t *i = (uint64_t*)a.data();
+          return static_cast< idx_t >( *i );
+        }
+      };
+    };
+
+    struct entry {
+      pub_key  acc_;
+      int64_t  next_ts_;  // time of next poll
+      int64_t  intv_;     // current interval
+      uint64_t slot_;     // slot of data last seen
+      uint64_t hash_;     // hash of data last seen
+    };
+
+    typedef open_hash_map<trait_account> acc_map_t;
+    typedef std::vector<entry>           entry_vec_t;
+    typedef std::vector<uint32_t>        idx_vec_t;
+
+    entry *get_entry( const pub_key& );
+
+    int64_t     min_intv_;
+    int64_t     max_intv_;
+    uint64_t    slot_;
+    uint64_t    num_poll_;
+    uint64_t    num_chg_;
+    acc_map_t   amap_;    // entry index by account
+    entry_vec_t evec_;
+    idx_vec_t   due_;     // scratch list of due entries
+  };
+
+}
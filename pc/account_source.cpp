@@ -0,0 +1,51 @@
+#include "account_source.hpp"
+
+using namespace pc;
+
+account_source::account_source()
+: pgm_( nullptr ),
+  cmt_( commitment::e_confirmed )
+{
+}
+
+account_source::~account_source()
+{
+}
+
+void account_source::set_sub( rpc_sub *sub )
+{
+  upd_.set_sub( sub );
+}
+
+rpc_sub *account_source::get_sub() const
+{
+  return upd_.get_sub();
+}
+
+void account_source::set_program( pub_key *pgm )
+{
+  pgm_ = pgm;
+}
+
+pub_key *account_source::get_program() const
+{
+  return pgm_;
+}
+
+void account_source::set_commitment( commitment cmt )
+{
+  cmt_ = cmt;
+}
+
+commitment account_source::get_commitment() const
+{
+  return cmt_;
+}
+
+void account_source::on_account( const pub_key& acc, uint64_t slot,
+                                 uint64_t lamports,
+                                 const char *data, size_t len )
+{
+  upd_.set_update( acc, slot, lamports, data, len );
+  upd_.dispatch();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <pc/rpc_client.hpp>
+
+namespace pc
+{
+
+  // streaming source of raw program account updates (e.g. a geyser grpc
+  // feed) used in place of rpc program subscriptions. implementations
+  // own their transport and hand decoded account bytes to on_account()
+  class account_source : public error
+  {
+  public:
+
+    account_source();
+    virtual ~account_source();
+
+    // account update callback
+    void set_sub( rpc_sub * );
+    rpc_sub *get_sub() const;
+
+    // program whose accounts are streamed
+    void set_program( pub_key * );
+    pub_key *get_program() const;
+
+    // commitment level of streamed updates
+    void set_commitment( commitment );
+    commitment get_commitment() const;
+
+    // connect and subscribe to program accounts
+    virtual bool init() = 0;
+
+    // make progress on the connection and dispatch received updates.
+    // called from the manager poll loop and must not block
+    virtual void poll() = 0;
+
+    // disconnect
+    virtual void close() = 0;
+
+    // connected and subscribed
+    virtual bool get_is_connect() const = 0;
+
+  protected:
+
+    // dispatch one account update to the callback
+    void on_account( const pub_key& acc, uint64_t slot, uint64_t lamports,
+                     const char *data, size_t len );
+
+  private:
+    pub_key                 *pgm_;
+    commitment               cmt_;
+    rpc::raw_account_update  upd_;
+  };
+
+}
@@ -0,0 +1,26 @@
+// scratch memory upd_aggregate.h expects at the start of the bpf heap
+// (per thread as managers may aggregate on different threads)
+static thread_local char agg_heap[ 16384 ];
+#define PC_HEAP_START (agg_heap)
+
+#include "aggregate.hpp"
+
+// upd_aggregate.h compiles the price model in with it. rename it so it
+// does not clash with the copy linked into libpc or with programs that
+// include upd_aggregate.h themselves
+#define price_model_core pc_aggregate_price_model_core
+#include <oracle/upd_aggregate.h>
+#undef price_model_core
+
+static_assert( sizeof( pc_qset_t ) <= sizeof( agg_heap ),
+               "aggregation heap too small" );
+
+bool pc::aggregate_price( pc_price_t *ptr, uint64_t slot, int64_t ts )
+{
+  return upd_aggregate( ptr, slot, ts );
+}
+
+void pc::aggregate_twap( pc_price_t *ptr, int64_t nslots )
+{
+  upd_twap( ptr, nslots );
+}
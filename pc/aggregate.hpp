@@ -0,0 +1,16 @@
+#pragma once
+
+#include <oracle/oracle.h>
+
+namespace pc
+{
+
+  // run the on-chain aggregation of the price account for an update in
+  // slot (see upd_aggregate.h). updates the aggregate in place and
+  // returns false if there were too few valid quotes
+  bool aggregate_price( pc_price_t *, uint64_t slot, int64_t ts );
+
+  // update the twap and twac of an account by nslots (see upd_twap)
+  void aggregate_twap( pc_price_t *, int64_t nslots );
+
+}
@@ -5,14 +5,9 @@ using namespace pc;
 ///////////////////////////////////////////////////////////////////////////
 // attr_dict
 
-attr_dict::pos::pos()
-: idx_( 0 ), len_ ( 0 ) {
-}
-
 void attr_dict::clear()
 {
   num_ = 0;
-  abuf_.clear();
   avec_.clear();
 }
 
@@ -24,9 +19,7 @@ unsigned attr_dict::get_num_attr() const
 bool attr_dict::get_attr( attr_id aid, str& val ) const
 {
   if ( aid.get_id() >= avec_.size()  ) return false;
-  const pos& p = avec_[aid.get_id()];
-  val.str_ = &abuf_[p.idx_];
-  val.len_ = p.len_;
+  val = attr_val_set::inst().get_str( avec_[aid.get_id()] );
   return val.len_ != 0;
 }
 
@@ -46,11 +39,7 @@ void attr_dict::add_ref( attr_id aid, str val )
   if ( aid.get_id() >= avec_.size() ) {
     avec_.resize( 1 + aid.get_id() );
   }
-  pos& p = avec_[aid.get_id()];
-  p.idx_ = abuf_.size();
-  p.len_ = val.len_;
-  abuf_.resize( abuf_.size() + p.len_ );
-  __builtin_memcpy( &abuf_[p.idx_], val.str_, p.len_ );
+  avec_[aid.get_id()] = attr_val_set::inst().add_val( val );
   ++num_;
 }
 
@@ -120,6 +109,53 @@ void attr_dict::write_json( json_wtr& wtr ) const
   }
 }
 
+///////////////////////////////////////////////////////////////////////////
+// attr_val_set
+
+attr_val_set::attr_val_set()
+: num_( 1U )
+{
+  __builtin_memset( blk_, 0, sizeof( blk_ ) );
+}
+
+attr_val_set::~attr_val_set()
+{
+  for( str *blk: blk_ ) {
+    delete [] blk;
+  }
+}
+
+uint32_t attr_val_set::add_val( str v )
+{
+  if ( !v.len_ ) {
+    return 0U;
+  }
+  std::lock_guard<std::mutex> lk( mtx_ );
+  val_map_t::iter_t it = vmap_.find( v );
+  if ( it ) {
+    return vmap_.obj( it );
+  }
+  uint32_t id = num_;
+  if ( id / blk_len == max_blk ) {
+    return 0U;
+  }
+  str*& blk = blk_[id / blk_len];
+  if ( !blk ) {
+    blk = new str[blk_len];
+  }
+  str k = vbuf_.add_attr( v );
+  blk[id % blk_len] = k;
+  it = vmap_.add( k );
+  vmap_.ref( it ) = id;
+  ++num_;
+  return id;
+}
+
+unsigned attr_val_set::get_num_val() const
+{
+  return num_ - 1U;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // attr_id_set
 
@@ -128,7 +164,7 @@ attr_id_set::attr_id_set()
 {
 }
 
-str attr_id_set::attr_wtr::add_attr( str v )
+str attr_wtr::add_attr( str v )
 {
   char *tgt = reserve( v.len_ );
   __builtin_memcpy( tgt, v.str_, v.len_ );
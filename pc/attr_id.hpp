@@ -5,6 +5,7 @@
 #include <pc/misc.hpp>
 #include <pc/jtree.hpp>
 #include <oracle/oracle.h>
+#include <mutex>
 
 namespace pc
 {
@@ -27,7 +28,9 @@ namespace pc
     uint32_t  id_;
   };
 
-  // dictionary of attribute values corresponding to attribute ids
+  // dictionary of attribute values corresponding to attribute ids.
+  // values are held as ids interned by attr_val_set so that the many
+  // products sharing a value keep a single copy of it
   class attr_dict
   {
   public:
@@ -63,19 +66,22 @@ namespace pc
 
   private:
 
-    struct pos { pos(); uint16_t idx_, len_; };
-
-    typedef std::vector<char> abuf_t;
-    typedef std::vector<pos>  attr_t;
+    typedef std::vector<uint32_t> attr_t;
 
     void add_ref( attr_id aid, str val );
     void clear();
 
-    abuf_t   abuf_;
-    attr_t   avec_;
+    attr_t   avec_;  // value id by attribute id
     unsigned num_;
   };
 
+  // append-only storage of interned attribute text
+  class attr_wtr : public net_wtr
+  {
+  public:
+    str add_attr( str );
+  };
+
   // manager unique set of attribute ids
   class attr_id_set
   {
@@ -103,11 +109,6 @@ namespace pc
 
     attr_id_set();
 
-    class attr_wtr : public net_wtr {
-    public:
-      str add_attr( str );
-    };
-
     struct trait_str {
       static const size_t hsize_ = 307UL;
       typedef uint32_t   idx_t;
@@ -132,6 +133,74 @@ namespace pc
     uint32_t   aid_;
   };
 
+  // attribute values interned once across all products. values are
+  // never released so their text remains valid for the life of the
+  // process. adding is serialized as the products of secondary networks
+  // are decoded on their own threads
+  class attr_val_set
+  {
+  public:
+
+    // get or add id of value (0 for the empty value)
+    uint32_t add_val( str );
+
+    // value of id returned by add_val
+    str get_str( uint32_t ) const;
+
+    // number of distinct values
+    unsigned get_num_val() const;
+
+    // singleton instance
+    static attr_val_set& inst();
+
+  private:
+
+    attr_val_set();
+    ~attr_val_set();
+
+    static const uint32_t blk_len = 4096; // values per block
+    static const uint32_t max_blk = 4096; // blocks
+
+    struct trait_val {
+      static const size_t hsize_ = 4093UL;
+      typedef uint32_t   idx_t;
+      typedef str        key_t;
+      typedef str        keyref_t;
+      typedef uint32_t   val_t;
+      struct hash_t {
+        idx_t operator() ( keyref_t s ) {
+          // values often share a long prefix (Crypto.BTC/USD...)
+          uint32_t h = 2166136261U;
+          for( size_t i = 0; i != s.len_; ++i ) {
+            h = ( h ^ (uint8_t)s.str_[i] ) * 16777619U;
+          }
+          return h;
+        }
+      };
+    };
+
+    typedef hash_map<trait_val> val_map_t;
+
+    std::mutex mtx_;
+    val_map_t  vmap_;
+    attr_wtr   vbuf_;
+    str       *blk_[max_blk]; // values by id in fixed blocks
+    uint32_t   num_;
+  };
+
+  inline str attr_val_set::get_str( uint32_t id ) const
+  {
+    // blocks never move so readers need not synchronize with adds of
+    // other values
+    str *blk = id ? blk_[id / blk_len] : nullptr;
+    return blk ? blk[id % blk_len] : str();
+  }
+
+  inline attr_val_set& attr_val_set::inst() {
+    static attr_val_set vset;
+    return vset;
+  }
+
   inline unsigned attr_id_set::get_num_attr_id() const
   {
     return aid_;
@@ -0,0 +1,127 @@
+#include "cap_filter.hpp"
+#include <stdlib.h>
+
+using namespace pc;
+
+bool cap_filter::term::match( price *ptr ) const
+{
+  if ( is_acc_ ) {
+    return *ptr->get_account() == acc_;
+  }
+  if ( !id_.is_valid() ) {
+    id_ = attr_id( str( key_ ) );
+  }
+  str val;
+  return ptr->get_attr( id_, val ) && val == str( val_ );
+}
+
+cap_filter::cap_filter()
+: gen_( 1U ),
+  is_pause_( false ),
+  is_full_( false ),
+  num_skip_( 0UL )
+{
+}
+
+bool cap_filter::add_term( str txt )
+{
+  term t;
+  t.text_.assign( txt.str_, txt.len_ );
+  t.rate_ = 1U;
+  std::string spec = t.text_;
+  size_t pos = spec.rfind( '@' );
+  if ( pos != std::string::npos ) {
+    const char *rtxt = spec.c_str() + pos + 1;
+    char *end = nullptr;
+    unsigned long rate = ::strtoul( rtxt, &end, 10 );
+    if ( end == rtxt || *end != '\0' || rate > UINT32_MAX ) {
+      return false;
+    }
+    t.rate_ = static_cast< uint32_t >( rate );
+    spec.resize( pos );
+  }
+  pos = spec.find( '=' );
+  t.is_acc_ = pos == std::string::npos;
+  if ( t.is_acc_ ) {
+    if ( (int)pub_key::len != t.acc_.dec_base58(
+           (const uint8_t*)spec.c_str(), (int)spec.size() ) ) {
+      return false;
+    }
+  } else {
+    t.key_ = spec.substr( 0, pos );
+    t.val_ = spec.substr( pos + 1 );
+    if ( t.key_.empty() ) {
+      return false;
+    }
+  }
+  tvec_.push_back( t );
+  reset();
+  return true;
+}
+
+unsigned cap_filter::get_num_term() const
+{
+  return static_cast< unsigned >( tvec_.size() );
+}
+
+std::string cap_filter::get_term( unsigned i ) const
+{
+  return tvec_[i].text_;
+}
+
+void cap_filter::clear()
+{
+  tvec_.clear();
+  reset();
+}
+
+void cap_filter::set_is_paused( bool is_pause )
+{
+  is_pause_ = is_pause;
+}
+
+bool cap_filter::get_is_paused() const
+{
+  return is_pause_;
+}
+
+void cap_filter::set_is_full( bool is_full )
+{
+  is_full_ = is_full;
+}
+
+bool cap_filter::get_is_full() const
+{
+  return is_full_;
+}
+
+void cap_filter::reset()
+{
+  ++gen_;
+}
+
+uint64_t cap_filter::get_num_skip() const
+{
+  return num_skip_;
+}
+
+cap_filter::state& cap_filter::refresh( price *ptr )
+{
+  unsigned idx = ptr->get_arena_index();
+  if ( idx >= svec_.size() ) {
+    svec_.resize( idx + 1, state() );
+  }
+  state& st = svec_[idx];
+  st.gen_  = gen_;
+  st.rate_ = 0U;
+  for( const term& t: tvec_ ) {
+    if ( t.match( ptr ) ) {
+      st.rate_ = t.rate_;
+      break;
+    }
+  }
+
+  // first update after a change of terms is captured
+  st.cnt_ = st.rate_ ? st.rate_ - 1U : 0U;
+  return st;
+}
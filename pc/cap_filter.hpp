@@ -0,0 +1,103 @@
+#pragma once
+
+#include <pc/request.hpp>
+#include <string>
+#include <vector>
+
+namespace pc
+{
+
+  // selects the price updates written to the capture. prices are chosen
+  // by a list of terms, each a price account or a product attribute
+  // value with a sample rate, and the first term matching a price sets
+  // one in how many of its aggregate updates are captured. prices
+  // matching no term are not captured and without terms all are. the
+  // decision is kept per price until the terms or product attributes
+  // change so that filtered updates cost a counter on the loop
+  class cap_filter
+  {
+  public:
+
+    cap_filter();
+
+    // add term <price account>[@<rate>] or <attribute>=<value>[@<rate>]
+    // capturing one in rate updates of matching prices (default 1 - all,
+    // 0 - none). false if the term is malformed
+    bool add_term( str );
+    unsigned get_num_term() const;
+    std::string get_term( unsigned ) const;
+    void clear();
+
+    // price capture paused (default false)
+    void set_is_paused( bool );
+    bool get_is_paused() const;
+
+    // capture all updates of all prices regardless of the terms
+    // (default false)
+    void set_is_full( bool );
+    bool get_is_full() const;
+
+    // product attributes changed and prices are matched again
+    void reset();
+
+    // capture this aggregate update of price
+    bool get_is_capture( price * );
+
+    // price updates not captured
+    uint64_t get_num_skip() const;
+
+  private:
+
+    struct term {
+      std::string     text_;
+      bool            is_acc_;
+      pub_key         acc_;
+      std::string     key_;
+      mutable attr_id id_;
+      std::string     val_;
+      uint32_t        rate_;
+      bool match( price * ) const;
+    };
+
+    struct state {
+      uint32_t gen_;   // generation of terms rate_ was matched against
+      uint32_t rate_;  // capture one in rate_ updates (0 - none)
+      uint32_t cnt_;   // updates since last captured
+    };
+
+    typedef std::vector<term>  term_vec_t;
+    typedef std::vector<state> state_vec_t;
+
+    state& refresh( price * );
+
+    term_vec_t  tvec_;
+    state_vec_t svec_;     // by price arena index
+    uint32_t    gen_;
+    bool        is_pause_;
+    bool        is_full_;
+    uint64_t    num_skip_;
+  };
+
+  inline bool cap_filter::get_is_capture( price *ptr )
+  {
+    if ( PC_UNLIKELY( is_pause_ ) ) {
+      ++num_skip_;
+      return false;
+    }
+    if ( PC_LIKELY( tvec_.empty() || is_full_ ) ) {
+      return true;
+    }
+    unsigned idx = ptr->get_arena_index();
+    state *st = idx < svec_.size() ? &svec_[idx] : nullptr;
+    if ( PC_UNLIKELY( !st || st->gen_ != gen_ ) ) {
+      st = &refresh( ptr );
+    }
+    if ( st->rate_ && ++st->cnt_ >= st->rate_ ) {
+      st->cnt_ = 0;
+      return true;
+    }
+    ++num_skip_;
+    return false;
+  }
+
+}
@@ -1,4 +1,7 @@
 #include "capture.hpp"
+#include "log.hpp"
+#include <zstd.h>
+#include <algorithm>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -11,7 +14,28 @@ capture::capture()
   is_run_( true ),
   is_wtr_( false ),
   fd_(-1),
-  zfd_( nullptr )
+  zfd_( nullptr ),
+  dict_( nullptr ),
+  cxt_( nullptr ),
+  is_zst_( false ),
+  zlvl_( zstd_dict::level ),
+  zthr_( 0U ),
+  dint_( 0U ),
+  is_blk_( false ),
+  bsz_( 1024*1024 ),
+  slot_( 0UL ),
+  boff_( 0UL ),
+  rint_( 0U ),
+  rsize_( 0UL ),
+  rper_( 0L ),
+  fsz_( 0UL ),
+  sint_( 0U ),
+  sync_ts_( 0L ),
+  is_dirty_( false ),
+  max_pend_( 0U ),
+  is_drop_( true ),
+  ndrop_( 0UL ),
+  cpu_( -1 )
 {
 }
 
@@ -30,12 +54,10 @@ capture::~capture()
   }
   reuse_.clear();
   done_.clear();
-  if ( zfd_ ) {
-    ::gzclose( zfd_ );
-  }
-  if ( fd_ > 0 ) {
-    ::close( fd_ );
-    fd_ = -1;
+  close_file();
+  if ( cxt_ ) {
+    ZSTD_freeCCtx( (ZSTD_CCtx*)cxt_ );
+    cxt_ = nullptr;
   }
 }
 
@@ -49,6 +71,137 @@ std::string capture::get_file() const
   return file_;
 }
 
+void capture::set_zstd_dict( const zstd_dict *dict )
+{
+  dict_ = dict;
+}
+
+const zstd_dict *capture::get_zstd_dict() const
+{
+  return dict_;
+}
+
+void capture::set_zstd_level( int level )
+{
+  zlvl_ = level;
+}
+
+int capture::get_zstd_level() const
+{
+  return zlvl_;
+}
+
+void capture::set_zstd_threads( unsigned num )
+{
+  zthr_ = num;
+}
+
+unsigned capture::get_zstd_threads() const
+{
+  return zthr_;
+}
+
+void capture::set_delta_interval( unsigned num )
+{
+  dint_ = num;
+}
+
+unsigned capture::get_delta_interval() const
+{
+  return dint_;
+}
+
+void capture::set_block_size( size_t len )
+{
+  bsz_ = len;
+}
+
+size_t capture::get_block_size() const
+{
+  return bsz_;
+}
+
+void capture::set_slot( uint64_t slot )
+{
+  slot_ = slot;
+}
+
+uint64_t capture::get_slot() const
+{
+  return slot_;
+}
+
+void capture::set_rotate_interval( unsigned secs )
+{
+  rint_ = secs;
+}
+
+unsigned capture::get_rotate_interval() const
+{
+  return rint_;
+}
+
+void capture::set_rotate_size( uint64_t len )
+{
+  rsize_ = len;
+}
+
+uint64_t capture::get_rotate_size() const
+{
+  return rsize_;
+}
+
+void capture::set_sync_interval( unsigned ms )
+{
+  sint_ = ms;
+}
+
+unsigned capture::get_sync_interval() const
+{
+  return sint_;
+}
+
+void capture::set_max_pending( unsigned num )
+{
+  max_pend_ = num;
+}
+
+unsigned capture::get_max_pending() const
+{
+  return max_pend_;
+}
+
+void capture::set_is_drop( bool is_drop )
+{
+  is_drop_ = is_drop;
+}
+
+bool capture::get_is_drop() const
+{
+  return is_drop_;
+}
+
+void capture::set_cpu( int cpu )
+{
+  cpu_ = cpu;
+}
+
+int capture::get_cpu() const
+{
+  return cpu_;
+}
+
+uint64_t capture::get_num_dropped() const
+{
+  return ndrop_;
+}
+
+unsigned capture::get_num_pending()
+{
+  std::lock_guard<std::mutex> lck( mtx_ );
+  return static_cast< unsigned >( pend_.size() );
+}
+
 static void run_capture( capture *ptr )
 {
   ptr->run();
@@ -58,8 +211,62 @@ bool capture::init()
 {
   std::string file = file_;
   size_t flen = file.length();
-  if ( flen >=3 && file.substr(flen-3) != ".gz" ) {
-    file += ".gz";
+  is_blk_ = flen >= 4 && file.substr( flen-4 ) == ".pcb";
+  is_zst_ = !is_blk_ && !dict_ && flen >= 4 && file.substr( flen-4 ) == ".zst";
+  sfx_ = is_blk_ ? ".pcb" : ( dict_ || is_zst_ ? ".zst" : ".gz" );
+  size_t slen = sfx_.length();
+  if ( flen >= slen && file.substr( flen-slen ) == sfx_ ) {
+    file = file.substr( 0, flen-slen );
+  }
+  path_ = file;
+  if ( dict_ && !is_blk_ ) {
+    cxt_ = ZSTD_createCCtx();
+    if ( !cxt_ ) {
+      return set_err_msg( "failed to create compression context" );
+    }
+  } else if ( is_zst_ || is_blk_ ) {
+    ZSTD_CCtx *cxt = ZSTD_createCCtx();
+    cxt_ = cxt;
+    if ( !cxt ) {
+      return set_err_msg( "failed to create compression context" );
+    }
+    if ( ZSTD_isError( ZSTD_CCtx_setParameter(
+            cxt, ZSTD_c_compressionLevel, zlvl_ ) ) ) {
+      return set_err_msg(
+          "invalid zstd compression level=" + std::to_string( zlvl_ ) );
+    }
+    // nbWorkers fails if libzstd was built without thread support
+    if ( zthr_ && ZSTD_isError( ZSTD_CCtx_setParameter(
+            cxt, ZSTD_c_nbWorkers, static_cast< int >( zthr_ ) ) ) ) {
+      return set_err_msg( "zstd compression threads not supported" );
+    }
+  }
+  if ( !open_file( get_now() ) ) {
+    return false;
+  }
+  thrd_ = std::thread( run_capture, this );
+  if ( cpu_ >= 0 && !set_thread_cpu( thrd_.native_handle(), cpu_ ) ) {
+    return set_err_msg( "failed to pin capture thread to cpu=" +
+        std::to_string( cpu_ ), errno );
+  }
+  return true;
+}
+
+bool capture::open_file( int64_t ts )
+{
+  // rotated files are named by the time of their first record
+  std::string file = path_ + sfx_;
+  if ( rint_ || rsize_ ) {
+    char tbuf[32];
+    time_t secs = static_cast< time_t >( ts / PC_NSECS_IN_SEC );
+    struct tm tm[1];
+    gmtime_r( &secs, tm );
+    strftime( tbuf, sizeof( tbuf ), "%Y%m%dT%H%M%S", tm );
+    file = path_ + "." + tbuf + sfx_;
+    struct stat fst[1];
+    for( unsigned i = 1; 0 == ::stat( file.c_str(), fst ); ++i ) {
+      file = path_ + "." + tbuf + "_" + std::to_string( i ) + sfx_;
+    }
   }
   // check if file already exists
   struct stat fst[1];
@@ -72,20 +279,88 @@ bool capture::init()
     return set_err_msg(
         "failed to create capture file=" + file, errno  );
   }
-  zfd_ = ::gzdopen( fd_, "w" );
-  if ( !zfd_ ) {
-    return set_err_msg(
-        "failed to create capture file=" + file, errno  );
+  cfile_ = file;
+  if ( rint_ ) {
+    rper_ = ts / ( rint_ * PC_NSECS_IN_SEC );
   }
-  static const size_t gzb_sz = 128*1024;
-  if ( 0 != gzbuffer( zfd_, gzb_sz ) ) {
-    return set_err_msg(
-        "failed to set compression buffer file=" + file );
+  fsz_ = 0UL;
+  sync_ts_ = ts;
+  is_dirty_ = false;
+
+  // delta and block state do not cross files
+  dmap_.clear();
+  dvec_.clear();
+  if ( is_blk_ ) {
+    uint64_t magic = blk_magic;
+    write_file( (const char*)&magic, sizeof( magic ) );
+    boff_ = sizeof( magic );
+    bidx_.clear();
+    bmap_.clear();
+    bkey_.clear();
+    bacc_.clear();
+  } else if ( is_zst_ ) {
+    ZSTD_CCtx_reset( (ZSTD_CCtx*)cxt_, ZSTD_reset_session_only );
+  } else if ( !dict_ ) {
+    zfd_ = ::gzdopen( fd_, "w" );
+    if ( !zfd_ ) {
+      return set_err_msg(
+          "failed to create capture file=" + file, errno  );
+    }
+    static const size_t gzb_sz = 128*1024;
+    if ( 0 != gzbuffer( zfd_, gzb_sz ) ) {
+      return set_err_msg(
+          "failed to set compression buffer file=" + file );
+    }
   }
-  thrd_ = std::thread( run_capture, this );
   return true;
 }
 
+void capture::close_file()
+{
+  if ( fd_ < 0 ) {
+    return;
+  }
+  if ( is_blk_ ) {
+    write_block();
+    write_index();
+  } else if ( is_zst_ ) {
+    end_stream();
+  }
+  // gzclose also closes the file so sync through a duplicate
+  int fd = fd_;
+  if ( zfd_ ) {
+    fd = sint_ ? ::dup( fd_ ) : -1;
+    ::gzclose( zfd_ );
+    zfd_ = nullptr;
+  }
+  if ( sint_ && fd >= 0 ) {
+    ::fdatasync( fd );
+  }
+  if ( fd >= 0 ) {
+    ::close( fd );
+  }
+  fd_ = -1;
+}
+
+bool capture::is_rotate( const cap_buf *ptr )
+{
+  int64_t ts = ((const int64_t*)ptr->buf_)[0];
+  if ( rint_ && ts / ( rint_ * PC_NSECS_IN_SEC ) != rper_ ) {
+    return true;
+  }
+  uint64_t len = zfd_ ? static_cast< uint64_t >( gzoffset( zfd_ ) ) : fsz_;
+  return rsize_ && len >= rsize_;
+}
+
+void capture::sync_file( int64_t ts )
+{
+  if ( is_dirty_ && ts - sync_ts_ >= sint_ * PC_NSECS_IN_MSEC ) {
+    ::fdatasync( fd_ );
+    sync_ts_ = ts;
+    is_dirty_ = false;
+  }
+}
+
 capture::cap_buf *capture::alloc()
 {
   if ( !reuse_.empty() ) {
@@ -95,6 +370,8 @@ capture::cap_buf *capture::alloc()
     curr_ = (cap_buf*)malloc( max_size );
   }
   curr_->size_ = 0;
+  curr_->slot_ = slot_;
+  curr_->num_  = 0;
   return curr_;
 }
 
@@ -116,6 +393,7 @@ void capture::write( pc_pub_key_t *kptr, pc_acc_t *aptr )
   tgt += sizeof( pc_pub_key_t );
   __builtin_memcpy( tgt, aptr, aptr->size_ );
   curr_->size_ += tlen;
+  ++curr_->num_;
 }
 
 void capture::flush()
@@ -125,6 +403,22 @@ void capture::flush()
   }
   buf_vec_t done;
   mtx_.lock();
+  if ( max_pend_ ) {
+    // never wait on the capture thread unless asked to
+    while( pend_.size() >= max_pend_ && !is_drop_ ) {
+      mtx_.unlock();
+      struct timespec ts[1] = { { 0, 100000 } };
+      clock_nanosleep( CLOCK_REALTIME, 0, ts, NULL );
+      mtx_.lock();
+    }
+    if ( pend_.size() >= max_pend_ ) {
+      mtx_.unlock();
+      ndrop_ += curr_->num_;
+      reuse_.push_back( curr_ );
+      curr_ = nullptr;
+      return;
+    }
+  }
   pend_.push_back( curr_ );
   done_.swap( done );
   is_wtr_ = true;
@@ -149,17 +443,49 @@ void capture::run()
 
       // write to file
       for( cap_buf *ptr: pend ) {
-        char *buf = ptr->buf_;
-        size_t sz = ptr->size_;
-        while( sz > 0 ) {
-          int num = ::gzwrite( zfd_, buf, sz );
-          if ( num > 0 ) {
-            buf += num;
-            sz  -= static_cast< unsigned >( num );
-          } else {
-            break;
+        const char *buf = ptr->buf_;
+        size_t len = ptr->size_;
+        if ( PC_UNLIKELY( ( rint_ || rsize_ ) && ptr->num_ &&
+                          is_rotate( ptr ) ) ) {
+          close_file();
+          int64_t ts = ((const int64_t*)ptr->buf_)[0];
+          if ( !open_file( ts ) ) {
+            PC_LOG_ERR( "failed to rotate capture" )
+              .add( "err", get_err_msg() )
+              .end();
+            close_file();
+            reset_err();
+            if ( rint_ ) {
+              rper_ = ts / ( rint_ * PC_NSECS_IN_SEC );
+            }
           }
         }
+        if ( fd_ < 0 ) {
+          ndrop_ += ptr->num_;
+          continue;
+        }
+        is_dirty_ = true;
+        if ( is_blk_ && blk_.size() >= bsz_ ) {
+          write_block();
+        }
+        if ( dint_ ) {
+          encode_delta( buf, len );
+          buf = dbuf_.data();
+          len = dbuf_.size();
+        }
+        if ( is_blk_ ) {
+          add_chunk( ptr, buf, len );
+        } else if ( dict_ ) {
+          write_zstd( buf, len );
+        } else if ( is_zst_ ) {
+          write_stream( buf, len );
+        } else {
+          write_gz( buf, len );
+        }
+      }
+
+      if ( sint_ && fd_ >= 0 ) {
+        sync_file( get_now() );
       }
 
       // send buffers back to reuse
@@ -171,8 +497,319 @@ void capture::run()
     } else if ( !is_run_ ) {
       break;
     } else {
+      if ( sint_ && fd_ >= 0 ) {
+        sync_file( get_now() );
+      }
       // sleep a bit
       clock_nanosleep( CLOCK_REALTIME, 0, ts, NULL );
     }
   }
 }
+
+void capture::write_gz( const char *buf, size_t sz )
+{
+  while( sz > 0 ) {
+    int num = ::gzwrite( zfd_, buf, sz );
+    if ( num > 0 ) {
+      buf += num;
+      sz  -= static_cast< unsigned >( num );
+    } else {
+      break;
+    }
+  }
+}
+
+void capture::write_zstd( const char *buf, size_t len )
+{
+  // compress each record as its own frame using account type dictionary
+  ZSTD_CCtx *cxt = (ZSTD_CCtx*)cxt_;
+  static const size_t hdr_sz = sizeof( int64_t ) + sizeof( pc_pub_key_t );
+  size_t zlen = 0;
+  for( size_t pos = 0; pos < len; ) {
+    const pc_acc_t *aptr = (const pc_acc_t*)&buf[pos+hdr_sz];
+    size_t rlen = hdr_sz + aptr->size_;
+    size_t left = ZSTD_compressBound( rlen );
+    if ( zbuf_.size() < zlen + sizeof( uint32_t ) + left ) {
+      zbuf_.resize( zlen + sizeof( uint32_t ) + left );
+    }
+    const ZSTD_CDict *cdict = (const ZSTD_CDict*)dict_->get_cdict(
+        aptr->type_ );
+    size_t flen = cdict ?
+      ZSTD_compress_usingCDict( cxt, &zbuf_[zlen+sizeof( uint32_t )], left,
+                                &buf[pos], rlen, cdict ) :
+      ZSTD_compressCCtx( cxt, &zbuf_[zlen+sizeof( uint32_t )], left,
+                         &buf[pos], rlen, zstd_dict::level );
+    pos += rlen;
+    if ( ZSTD_isError( flen ) ) {
+      continue;
+    }
+    uint32_t len32 = static_cast< uint32_t >( flen );
+    __builtin_memcpy( &zbuf_[zlen], &len32, sizeof( len32 ) );
+    zlen += sizeof( uint32_t ) + flen;
+  }
+  write_file( zbuf_.data(), zlen );
+}
+
+void capture::write_stream( const char *buf, size_t len )
+{
+  // with worker threads compression happens in the background and
+  // output is returned as jobs complete
+  ZSTD_CCtx *cxt = (ZSTD_CCtx*)cxt_;
+  if ( zbuf_.empty() ) {
+    zbuf_.resize( ZSTD_CStreamOutSize() );
+  }
+  ZSTD_inBuffer in = { buf, len, 0 };
+  while( in.pos != in.size ) {
+    ZSTD_outBuffer out = { zbuf_.data(), zbuf_.size(), 0 };
+    size_t rc = ZSTD_compressStream2( cxt, &out, &in, ZSTD_e_continue );
+    if ( ZSTD_isError( rc ) ) {
+      break;
+    }
+    write_file( zbuf_.data(), out.pos );
+  }
+}
+
+void capture::end_stream()
+{
+  ZSTD_CCtx *cxt = (ZSTD_CCtx*)cxt_;
+  if ( !cxt || fd_ < 0 ) {
+    return;
+  }
+  if ( zbuf_.empty() ) {
+    zbuf_.resize( ZSTD_CStreamOutSize() );
+  }
+  ZSTD_inBuffer in = { nullptr, 0, 0 };
+  for(;;) {
+    ZSTD_outBuffer out = { zbuf_.data(), zbuf_.size(), 0 };
+    size_t rc = ZSTD_compressStream2( cxt, &out, &in, ZSTD_e_end );
+    if ( ZSTD_isError( rc ) ) {
+      break;
+    }
+    write_file( zbuf_.data(), out.pos );
+    if ( rc == 0 ) {
+      break;
+    }
+  }
+}
+
+void capture::add_chunk( const cap_buf *ptr, const char *buf, size_t len )
+{
+  // index the time, slot and accounts of the raw records
+  static const size_t hdr_sz = sizeof( int64_t ) + sizeof( pc_pub_key_t );
+  if ( ptr->size_ == 0 ) {
+    return;
+  }
+  uint32_t blk = static_cast< uint32_t >( bidx_.size() );
+  if ( blk_.empty() ) {
+    int64_t ts = ((const int64_t*)ptr->buf_)[0];
+    bidx_.push_back( blk_idx{ boff_, ts, ts, ptr->slot_, ptr->slot_ } );
+  } else {
+    --blk;
+  }
+  blk_idx& idx = bidx_.back();
+  for( size_t pos = 0; pos < ptr->size_; ) {
+    const char *rec = &ptr->buf_[pos];
+    const pc_acc_t *aptr = (const pc_acc_t*)&rec[hdr_sz];
+    const pub_key& key = *(const pub_key*)&rec[sizeof( int64_t )];
+    acc_map_t::iter_t it = bmap_.find( key );
+    if ( !it ) {
+      it = bmap_.add( key );
+      bmap_.ref( it ) = static_cast< uint32_t >( bacc_.size() );
+      bkey_.push_back( key );
+      bacc_.resize( bacc_.size() + 1 );
+    }
+    blk_list_t& lst = bacc_[bmap_.obj( it )];
+    if ( lst.empty() || lst.back() != blk ) {
+      lst.push_back( blk );
+    }
+    idx.ts1_ = ((const int64_t*)rec)[0];
+    pos += hdr_sz + aptr->size_;
+  }
+  idx.slot1_ = ptr->slot_;
+  blk_chunk chk = { ptr->slot_, len };
+  blk_.insert( blk_.end(), (const char*)&chk, (const char*)&chk + sizeof( chk ) );
+  blk_.insert( blk_.end(), buf, buf + len );
+}
+
+void capture::write_block()
+{
+  if ( blk_.empty() ) {
+    return;
+  }
+  ZSTD_CCtx *cxt = (ZSTD_CCtx*)cxt_;
+  size_t bound = ZSTD_compressBound( blk_.size() );
+  if ( zbuf_.size() < sizeof( blk_hdr ) + bound ) {
+    zbuf_.resize( sizeof( blk_hdr ) + bound );
+  }
+  blk_hdr *hdr = (blk_hdr*)zbuf_.data();
+  size_t zlen = ZSTD_compress2( cxt, &zbuf_[sizeof( blk_hdr )], bound,
+                                blk_.data(), blk_.size() );
+  if ( ZSTD_isError( zlen ) ) {
+    // a block that fails to compress is kept in the index as empty
+    PC_LOG_ERR( "failed to compress capture block" )
+      .add( "file", cfile_ )
+      .add( "lost_bytes", blk_.size() )
+      .add( "err", ZSTD_getErrorName( zlen ) )
+      .end();
+    zlen = 0;
+  }
+  hdr->zlen_ = zlen;
+  hdr->len_  = zlen ? blk_.size() : 0UL;
+  write_file( zbuf_.data(), sizeof( blk_hdr ) + zlen );
+  boff_ += sizeof( blk_hdr ) + zlen;
+  blk_.clear();
+  dmap_.clear();
+  dvec_.clear();
+}
+
+void capture::write_index()
+{
+  std::vector<char> buf;
+  buf.insert( buf.end(), (const char*)bidx_.data(),
+              (const char*)( bidx_.data() + bidx_.size() ) );
+  uint32_t pos = 0;
+  for( size_t i = 0; i != bacc_.size(); ++i ) {
+    blk_acc acc;
+    __builtin_memcpy( &acc.acc_, bkey_[i].data(), sizeof( pc_pub_key_t ) );
+    acc.pos_ = pos;
+    acc.num_ = static_cast< uint32_t >( bacc_[i].size() );
+    buf.insert( buf.end(), (const char*)&acc,
+                (const char*)&acc + sizeof( acc ) );
+    pos += acc.num_;
+  }
+  for( const blk_list_t& lst: bacc_ ) {
+    buf.insert( buf.end(), (const char*)lst.data(),
+                (const char*)( lst.data() + lst.size() ) );
+  }
+  blk_tail tail = { boff_, static_cast< uint32_t >( bidx_.size() ),
+                    static_cast< uint32_t >( bacc_.size() ), blk_magic };
+  buf.insert( buf.end(), (const char*)&tail,
+              (const char*)&tail + sizeof( tail ) );
+  write_file( buf.data(), buf.size() );
+}
+
+void capture::write_file( const char *buf, size_t len )
+{
+  fsz_ += len;
+  while( len > 0 ) {
+    ssize_t num = ::write( fd_, buf, len );
+    if ( num > 0 ) {
+      buf += num;
+      len -= static_cast< size_t >( num );
+    } else {
+      break;
+    }
+  }
+}
+
+// account word i of len bytes. the last word is zero-padded
+static uint64_t get_word( const char *buf, size_t i, size_t len )
+{
+  uint64_t res = 0UL;
+  size_t pos = i * sizeof( uint64_t );
+  __builtin_memcpy( &res, &buf[pos],
+                    std::min( sizeof( uint64_t ), len - pos ) );
+  return res;
+}
+
+void capture::encode_delta( const char *buf, size_t len )
+{
+  static const size_t hdr_sz = sizeof( int64_t ) + sizeof( pc_pub_key_t );
+  dbuf_.clear();
+  if ( PC_UNLIKELY( dvec_.empty() ) ) {
+    // start of delta capture
+    dbuf_.resize( hdr_sz + sizeof( cap_delta ), '\0' );
+    cap_delta *dptr = (cap_delta*)&dbuf_[hdr_sz];
+    dptr->hdr_.magic_ = delta_magic;
+    dptr->hdr_.ver_   = PC_VERSION;
+    dptr->hdr_.size_  = sizeof( cap_delta );
+  }
+  for( size_t pos = 0; pos < len; ) {
+    const pc_acc_t *aptr = (const pc_acc_t*)&buf[pos+hdr_sz];
+    size_t alen = aptr->size_;
+    size_t rlen = hdr_sz + alen;
+    const pub_key& key = *(const pub_key*)&buf[pos+sizeof( int64_t )];
+    acc_map_t::iter_t it = dmap_.find( key );
+    if ( !it ) {
+      it = dmap_.add( key );
+      dmap_.ref( it ) = static_cast< uint32_t >( dvec_.size() );
+      dvec_.push_back( delta_acc{ {}, 0UL, 0U } );
+    }
+    delta_acc& acc = dvec_[dmap_.obj( it )];
+    if ( acc.num_ && acc.num_ < dint_ && acc.len_ == alen &&
+         add_delta( &buf[pos], acc ) ) {
+      ++acc.num_;
+    } else {
+      dbuf_.insert( dbuf_.end(), &buf[pos], &buf[pos+rlen] );
+      size_t nw = ( alen + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t );
+      acc.prev_.resize( nw );
+      for( size_t i = 0; i != nw; ++i ) {
+        acc.prev_[i] = get_word( (const char*)aptr, i, alen );
+      }
+      acc.len_ = alen;
+      acc.num_ = 1;
+    }
+    pos += rlen;
+  }
+}
+
+bool capture::add_delta( const char *rec, delta_acc& acc )
+{
+  // runs of changed words. runs one unchanged word apart are merged as
+  // the word costs no more than another run header
+  static const size_t hdr_sz = sizeof( int64_t ) + sizeof( pc_pub_key_t );
+  const char *aptr = &rec[hdr_sz];
+  const size_t alen = acc.len_;
+  const size_t nw = acc.prev_.size();
+  const uint64_t *prev = acc.prev_.data();
+  size_t start = dbuf_.size();
+  size_t pos = start + hdr_sz + sizeof( cap_delta );
+  size_t max_pos = start + hdr_sz + alen;
+  dbuf_.resize( pos );
+  __builtin_memcpy( &dbuf_[start], rec, hdr_sz );
+  uint32_t nrun = 0;
+  for( size_t i = 0; i < nw; ) {
+    if ( get_word( aptr, i, alen ) == prev[i] ) {
+      ++i;
+      continue;
+    }
+    size_t j = i + 1;
+    while( j < nw ) {
+      if ( get_word( aptr, j, alen ) != prev[j] ) {
+        ++j;
+      } else if ( j + 1 < nw && get_word( aptr, j+1, alen ) != prev[j+1] ) {
+        j += 2;
+      } else {
+        break;
+      }
+    }
+    size_t rlen = sizeof( cap_run ) + ( j - i ) * sizeof( uint64_t );
+    if ( pos + rlen >= max_pos ) {
+      dbuf_.resize( start );
+      return false;
+    }
+    dbuf_.resize( pos + rlen );
+    cap_run run = { static_cast< uint32_t >( i ),
+                    static_cast< uint32_t >( j - i ) };
+    __builtin_memcpy( &dbuf_[pos], &run, sizeof( run ) );
+    pos += sizeof( run );
+    for( ; i != j; ++i ) {
+      uint64_t val = get_word( aptr, i, alen );
+      __builtin_memcpy( &dbuf_[pos], &val, sizeof( val ) );
+      pos += sizeof( val );
+    }
+    ++nrun;
+  }
+  cap_delta *dptr = (cap_delta*)&dbuf_[start + hdr_sz];
+  const pc_acc_t *hptr = (const pc_acc_t*)aptr;
+  dptr->hdr_.magic_ = delta_magic;
+  dptr->hdr_.ver_   = hptr->ver_;
+  dptr->hdr_.type_  = hptr->type_;
+  dptr->hdr_.size_  = static_cast< uint32_t >( pos - start - hdr_sz );
+  dptr->len_        = static_cast< uint32_t >( alen );
+  dptr->num_        = nrun;
+  for( size_t i = 0; i != nw; ++i ) {
+    acc.prev_[i] = get_word( aptr, i, alen );
+  }
+  return true;
+}
@@ -2,6 +2,9 @@
 
 #include <pc/misc.hpp>
 #include <pc/error.hpp>
+#include <pc/hash_map.hpp>
+#include <pc/key_pair.hpp>
+#include <pc/zstd_dict.hpp>
 #include <oracle/oracle.h>
 #include <vector>
 #include <atomic>
@@ -12,7 +15,13 @@
 namespace pc
 {
 
-  // capture aggregate price update
+  // capture aggregate price update. written as a gzip stream, as a zstd
+  // stream if the file ends in .zst or, when zstd dictionaries are
+  // provided, as one length-prefixed zstd frame per record compressed
+  // with the dictionary of its account type (.zst). files ending in .pcb
+  // are written as independently compressed blocks with an index that
+  // replay uses to seek by time or slot and to read a single account.
+  // rotation, syncing and compression all happen on the capture thread
   class capture : public error
   {
   public:
@@ -23,6 +32,64 @@ namespace pc
     void set_file( const std::string& );
     std::string get_file() const;
 
+    // zstd dictionaries to compress records with (optional)
+    void set_zstd_dict( const zstd_dict * );
+    const zstd_dict *get_zstd_dict() const;
+
+    // zstd stream compression level (default 3)
+    void set_zstd_level( int );
+    int get_zstd_level() const;
+
+    // zstd stream compression worker threads (default 0 - compress on
+    // the capture thread)
+    void set_zstd_threads( unsigned );
+    unsigned get_zstd_threads() const;
+
+    // write accounts as the changes since the previous record of the
+    // account, with the full account every num records per account
+    // (default 0 - always full accounts)
+    void set_delta_interval( unsigned num );
+    unsigned get_delta_interval() const;
+
+    // uncompressed size of .pcb capture blocks (default 1MB)
+    void set_block_size( size_t );
+    size_t get_block_size() const;
+
+    // slot of records written from now on
+    void set_slot( uint64_t );
+    uint64_t get_slot() const;
+
+    // start a new file every secs seconds (on multiples of the interval)
+    // or once the file reaches len bytes (default 0 - never). rotated
+    // file names have the utc time of their first record before the
+    // suffix
+    void set_rotate_interval( unsigned secs );
+    unsigned get_rotate_interval() const;
+    void set_rotate_size( uint64_t len );
+    uint64_t get_rotate_size() const;
+
+    // fdatasync written data at most every ms milliseconds and before
+    // closing a file (default 0 - never)
+    void set_sync_interval( unsigned ms );
+    unsigned get_sync_interval() const;
+
+    // buffers queued for the capture thread before flush drops the
+    // buffer or waits for the queue to drain (default 0 - unbounded)
+    void set_max_pending( unsigned num );
+    unsigned get_max_pending() const;
+    void set_is_drop( bool );
+    bool get_is_drop() const;
+
+    // pin capture thread to cpu (default -1 - no pinning)
+    void set_cpu( int );
+    int get_cpu() const;
+
+    // records dropped by a full queue or a file that failed to open
+    uint64_t get_num_dropped() const;
+
+    // buffers queued for the capture thread
+    unsigned get_num_pending();
+
     // start capture thread
     bool init();
 
@@ -35,19 +102,119 @@ namespace pc
   public:
     void run();
 
+    // a delta record replaces the account content with a cap_delta
+    // followed by num_ runs of changed 8-byte words of the account,
+    // each a cap_run and its words. a delta capture starts with a
+    // cap_delta without account (len_ zero) so that replay keeps the
+    // full records deltas refer to
+    static const uint32_t delta_magic = 0xa1b2c3d5;
+
+    struct PC_PACKED cap_delta {
+      pc_acc_t hdr_;   // magic_ is delta_magic, size_ the delta length
+      uint32_t len_;   // account length
+      uint32_t num_;   // number of runs
+    };
+
+    struct PC_PACKED cap_run {
+      uint32_t off_;   // first word
+      uint32_t num_;   // number of words
+    };
+
+    // a block capture starts with blk_magic followed by blocks, each a
+    // blk_hdr and a zstd frame of chunks. a chunk is a blk_chunk and the
+    // records of one slot. delta state does not cross blocks. the file
+    // ends with the index: a blk_idx per block, a blk_acc per account,
+    // the block numbers of all accounts and a blk_tail. captures that
+    // were not closed have no index
+    static const uint64_t blk_magic = 0x31306b6c62637970UL; // "pycblk01"
+
+    struct PC_PACKED blk_hdr {
+      uint64_t zlen_;  // compressed length
+      uint64_t len_;   // uncompressed length
+    };
+
+    struct PC_PACKED blk_chunk {
+      uint64_t slot_;
+      uint64_t size_;  // length of records
+    };
+
+    struct PC_PACKED blk_idx {
+      uint64_t off_;   // file offset of blk_hdr
+      int64_t  ts0_;   // time of first and last record
+      int64_t  ts1_;
+      uint64_t slot0_; // slot of first and last record
+      uint64_t slot1_;
+    };
+
+    struct PC_PACKED blk_acc {
+      pc_pub_key_t acc_;
+      uint32_t     pos_; // first block number of account
+      uint32_t     num_; // number of blocks with account
+    };
+
+    struct PC_PACKED blk_tail {
+      uint64_t idx_off_; // file offset of first blk_idx
+      uint32_t nblk_;
+      uint32_t nacc_;
+      uint64_t magic_;   // blk_magic
+    };
+
   private:
 
+    struct delta_acc {
+      std::vector<uint64_t> prev_;  // previous account content
+      size_t                len_;   // previous account length
+      unsigned              num_;   // records since full account
+    };
+
+    struct trait_account {
+      typedef uint32_t        idx_t;
+      typedef pub_key         key_t;
+      typedef const pub_key&  keyref_t;
+      typedef uint32_t        val_t;
+      struct hash_t {
+        idx_t operator() ( keyref_t a ) {
+          uint64_t *i = (uint64_t*)a.data();
+          return *i;
+        }
+      };
+    };
+
+    typedef open_hash_map<trait_account> acc_map_t;
+    typedef std::vector<delta_acc>       delta_vec_t;
+    typedef std::vector<blk_idx>         blk_vec_t;
+    typedef std::vector<uint32_t>        blk_list_t;
+    typedef std::vector<blk_list_t>      acc_blk_t;
+    typedef std::vector<pub_key>         key_vec_t;
+
     struct PC_PACKED cap_buf {
       uint64_t size_;
+      uint64_t slot_;
+      uint64_t num_;   // number of records
       char     buf_[];
     };
 
     static const uint64_t max_size = 32*1024;
 
     cap_buf *alloc();
+    bool open_file( int64_t ts );
+    void close_file();
+    bool is_rotate( const cap_buf * );
+    void sync_file( int64_t ts );
+    void write_gz( const char *, size_t );
+    void write_zstd( const char *, size_t );
+    void write_stream( const char *, size_t );
+    void encode_delta( const char *, size_t );
+    bool add_delta( const char *, delta_acc& );
+    void end_stream();
+    void add_chunk( const cap_buf *, const char *, size_t );
+    void write_block();
+    void write_index();
+    void write_file( const char *, size_t );
 
     typedef std::vector<cap_buf*> buf_vec_t;
     typedef std::atomic<bool> atomic_t;
+    typedef std::atomic<uint64_t> count_t;
 
     cap_buf    *curr_;
     std::mutex  mtx_;
@@ -59,6 +226,39 @@ namespace pc
     buf_vec_t   reuse_;
     int         fd_;
     gzFile      zfd_;
+    const zstd_dict *dict_;
+    void       *cxt_;
+    bool        is_zst_; // zstd stream
+    int         zlvl_;
+    unsigned    zthr_;
+    unsigned    dint_;   // full account interval of delta records
+    acc_map_t   dmap_;   // delta state index by account
+    delta_vec_t dvec_;
+    std::vector<char> dbuf_;
+    std::vector<char> zbuf_;
+    bool        is_blk_; // block capture
+    size_t      bsz_;    // uncompressed block size
+    uint64_t    slot_;
+    uint64_t    boff_;   // file offset of next block
+    std::vector<char> blk_;
+    blk_vec_t   bidx_;   // block index
+    acc_map_t   bmap_;   // block numbers index by account
+    key_vec_t   bkey_;
+    acc_blk_t   bacc_;
+    std::string path_;   // file name before suffix
+    std::string sfx_;
+    std::string cfile_;  // file being written
+    unsigned    rint_;   // rotation interval
+    uint64_t    rsize_;  // rotation size
+    int64_t     rper_;   // rotation period of file
+    uint64_t    fsz_;    // bytes written to file
+    unsigned    sint_;   // sync interval
+    int64_t     sync_ts_;
+    bool        is_dirty_; // written since last sync
+    unsigned    max_pend_;
+    bool        is_drop_;
+    count_t     ndrop_;
+    int         cpu_;
     std::string file_;
   };
 
@@ -0,0 +1,477 @@
+#include "col_file.hpp"
+#include <zstd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define PC_COL_GROUP_ROWS 65536U
+
+using namespace pc;
+
+static void add_varint( std::vector<char>& buf, uint64_t val )
+{
+  while( val >= 0x80UL ) {
+    buf.push_back( (char)( ( val & 0x7fUL ) | 0x80UL ) );
+    val >>= 7;
+  }
+  buf.push_back( (char)val );
+}
+
+static bool get_varint( const char *&ptr, const char *end, uint64_t& val )
+{
+  val = 0UL;
+  for( unsigned sh = 0; ptr != end && sh < 64; sh += 7 ) {
+    uint64_t b = (uint8_t)*ptr++;
+    val |= ( b & 0x7fUL ) << sh;
+    if ( !( b & 0x80UL ) ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void add_str( std::vector<char>& buf, const std::string& val )
+{
+  uint32_t len = static_cast< uint32_t >( val.length() );
+  buf.insert( buf.end(), (const char*)&len, (const char*)&len + sizeof( len ) );
+  buf.insert( buf.end(), val.begin(), val.end() );
+}
+
+template<class T>
+static void add_pod( std::vector<char>& buf, T val )
+{
+  buf.insert( buf.end(), (const char*)&val, (const char*)&val + sizeof( val ) );
+}
+
+///////////////////////////////////////////////////////////////////////////
+// col_writer
+
+col_writer::col_writer()
+: fd_( -1 ),
+  zlvl_( 3 ),
+  grows_( PC_COL_GROUP_ROWS ),
+  off_( 0UL ),
+  cxt_( nullptr )
+{
+}
+
+col_writer::~col_writer()
+{
+  close();
+  if ( cxt_ ) {
+    ZSTD_freeCCtx( (ZSTD_CCtx*)cxt_ );
+    cxt_ = nullptr;
+  }
+}
+
+void col_writer::set_file( const std::string& file )
+{
+  file_ = file;
+}
+
+std::string col_writer::get_file() const
+{
+  return file_;
+}
+
+void col_writer::set_zstd_level( int level )
+{
+  zlvl_ = level;
+}
+
+int col_writer::get_zstd_level() const
+{
+  return zlvl_;
+}
+
+void col_writer::set_group_rows( uint32_t num )
+{
+  grows_ = num ? num : 1U;
+}
+
+uint32_t col_writer::get_group_rows() const
+{
+  return grows_;
+}
+
+unsigned col_writer::add_table( const std::string& name )
+{
+  tvec_.resize( tvec_.size() + 1 );
+  tvec_.back().name_ = name;
+  tvec_.back().num_  = 0UL;
+  return static_cast< unsigned >( tvec_.size() - 1 );
+}
+
+unsigned col_writer::add_column( unsigned tbl, const std::string& name,
+                                 col_enc enc )
+{
+  col_vec_t& cols = tvec_[tbl].cols_;
+  cols.resize( cols.size() + 1 );
+  cols.back().name_ = name;
+  cols.back().enc_  = enc;
+  cols.back().val_  = 0L;
+  return static_cast< unsigned >( cols.size() - 1 );
+}
+
+bool col_writer::init()
+{
+  fd_ = ::open( file_.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644 );
+  if ( fd_ < 0 ) {
+    return set_err_msg( "failed to create file=" + file_, errno );
+  }
+  cxt_ = ZSTD_createCCtx();
+  if ( !cxt_ ) {
+    return set_err_msg( "failed to create compression context" );
+  }
+  uint64_t magic = col_magic;
+  write_file( (const char*)&magic, sizeof( magic ) );
+  off_ = sizeof( magic );
+  return true;
+}
+
+uint32_t col_writer::get_dict_id( unsigned tbl, unsigned col, str val )
+{
+  column& cl = tvec_[tbl].cols_[col];
+  std::string key = val.as_string();
+  dict_map_t::iter_t it = cl.dmap_.find( key );
+  if ( it ) {
+    return cl.dmap_.obj( it );
+  }
+  uint32_t id = static_cast< uint32_t >( cl.dvec_.size() );
+  cl.dmap_.ref( cl.dmap_.add( key ) ) = id;
+  cl.dvec_.push_back( key );
+  return id;
+}
+
+void col_writer::set( unsigned tbl, unsigned col, int64_t val )
+{
+  tvec_[tbl].cols_[col].val_ = val;
+}
+
+void col_writer::add_row( unsigned tbl )
+{
+  // unset values repeat those of the previous row
+  table& tb = tvec_[tbl];
+  for( column& cl: tb.cols_ ) {
+    cl.vals_.push_back( cl.val_ );
+  }
+  ++tb.num_;
+  if ( tb.cols_.size() && tb.cols_[0].vals_.size() >= grows_ ) {
+    write_group( tb );
+  }
+}
+
+uint64_t col_writer::get_num_rows( unsigned tbl ) const
+{
+  return tvec_[tbl].num_;
+}
+
+void col_writer::write_group( table& tb )
+{
+  if ( tb.cols_.empty() || tb.cols_[0].vals_.empty() ) {
+    return;
+  }
+  std::vector<char> buf;
+  col_grp grp = { static_cast< uint32_t >( &tb - tvec_.data() ),
+                  static_cast< uint32_t >( tb.cols_[0].vals_.size() ) };
+  add_pod( buf, grp );
+  ZSTD_CCtx *cxt = (ZSTD_CCtx*)cxt_;
+  for( column& cl: tb.cols_ ) {
+    ebuf_.clear();
+    int64_t prev = 0L;
+    for( int64_t val: cl.vals_ ) {
+      if ( cl.enc_ == e_col_delta ) {
+        uint64_t diff = (uint64_t)val - (uint64_t)prev;
+        add_varint( ebuf_, ( diff << 1 ) ^ (uint64_t)( (int64_t)diff >> 63 ) );
+        prev = val;
+      } else {
+        add_varint( ebuf_, (uint64_t)val );
+      }
+    }
+    cl.vals_.clear();
+    size_t bound = ZSTD_compressBound( ebuf_.size() );
+    if ( zbuf_.size() < bound ) {
+      zbuf_.resize( bound );
+    }
+    size_t zlen = ZSTD_compressCCtx( cxt, zbuf_.data(), bound,
+                                     ebuf_.data(), ebuf_.size(), zlvl_ );
+    // store encoded values if they fail to compress
+    const char *src = zbuf_.data();
+    if ( ZSTD_isError( zlen ) ) {
+      src = ebuf_.data();
+      zlen = 0;
+    }
+    col_chunk chk = { static_cast< uint32_t >( zlen ),
+                      static_cast< uint32_t >( ebuf_.size() ) };
+    add_pod( buf, chk );
+    buf.insert( buf.end(), src, src + ( zlen ? zlen : ebuf_.size() ) );
+  }
+  write_file( buf.data(), buf.size() );
+}
+
+void col_writer::write_schema()
+{
+  std::vector<char> buf;
+  add_pod( buf, static_cast< uint32_t >( tvec_.size() ) );
+  for( const table& tb: tvec_ ) {
+    add_str( buf, tb.name_ );
+    add_pod( buf, tb.num_ );
+    add_pod( buf, static_cast< uint32_t >( tb.cols_.size() ) );
+    for( const column& cl: tb.cols_ ) {
+      add_str( buf, cl.name_ );
+      add_pod( buf, cl.enc_ );
+      add_pod( buf, static_cast< uint32_t >( cl.dvec_.size() ) );
+      for( const std::string& val: cl.dvec_ ) {
+        add_str( buf, val );
+      }
+    }
+  }
+  col_tail tail = { off_, col_magic };
+  add_pod( buf, tail );
+  write_file( buf.data(), buf.size() );
+}
+
+bool col_writer::close()
+{
+  if ( fd_ < 0 ) {
+    return true;
+  }
+  for( table& tb: tvec_ ) {
+    write_group( tb );
+  }
+  write_schema();
+  bool is_ok = !get_is_err();
+  if ( 0 != ::close( fd_ ) && is_ok ) {
+    is_ok = set_err_msg( "failed to close file=" + file_, errno );
+  }
+  fd_ = -1;
+  return is_ok;
+}
+
+void col_writer::write_file( const char *buf, size_t len )
+{
+  off_ += len;
+  while( len > 0 ) {
+    ssize_t num = ::write( fd_, buf, len );
+    if ( num > 0 ) {
+      buf += num;
+      len -= static_cast< size_t >( num );
+    } else {
+      set_err_msg( "failed to write file=" + file_, errno );
+      break;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+// col_reader
+
+void col_reader::set_file( const std::string& file )
+{
+  mmap_.set_file( file );
+}
+
+std::string col_reader::get_file() const
+{
+  return mmap_.get_file();
+}
+
+bool col_reader::init()
+{
+  if ( !mmap_.init() ) {
+    return set_err_msg( "failed to map file=" + get_file() );
+  }
+  const char *buf = mmap_.data();
+  size_t len = mmap_.size();
+  col_tail tail;
+  uint64_t magic = 0UL;
+  if ( len < sizeof( magic ) + sizeof( tail ) ) {
+    return set_err_msg( "invalid columnar file=" + get_file() );
+  }
+  __builtin_memcpy( &magic, buf, sizeof( magic ) );
+  __builtin_memcpy( &tail, &buf[len - sizeof( tail )], sizeof( tail ) );
+  if ( magic != col_magic || tail.magic_ != col_magic ||
+       tail.off_ < sizeof( magic ) || tail.off_ > len - sizeof( tail ) ) {
+    return set_err_msg( "invalid columnar file=" + get_file() );
+  }
+
+  // schema and dictionaries
+  const char *ptr = &buf[tail.off_];
+  const char *end = &buf[len - sizeof( tail )];
+  auto get = [&]( void *tgt, size_t sz ) {
+    if ( (size_t)( end - ptr ) < sz ) {
+      return false;
+    }
+    __builtin_memcpy( tgt, ptr, sz );
+    ptr += sz;
+    return true;
+  };
+  auto get_str = [&]( std::string& val ) {
+    uint32_t slen = 0;
+    if ( !get( &slen, sizeof( slen ) ) || (size_t)( end - ptr ) < slen ) {
+      return false;
+    }
+    val.assign( ptr, slen );
+    ptr += slen;
+    return true;
+  };
+  uint32_t ntbl = 0;
+  tvec_.clear();
+  if ( !get( &ntbl, sizeof( ntbl ) ) ) {
+    return set_err_msg( "corrupt columnar file=" + get_file() );
+  }
+  for( uint32_t i = 0; i != ntbl; ++i ) {
+    tvec_.resize( tvec_.size() + 1 );
+    table& tb = tvec_.back();
+    uint32_t ncol = 0;
+    if ( !get_str( tb.name_ ) || !get( &tb.num_, sizeof( tb.num_ ) ) ||
+         !get( &ncol, sizeof( ncol ) ) ) {
+      return set_err_msg( "corrupt columnar file=" + get_file() );
+    }
+    for( uint32_t j = 0; j != ncol; ++j ) {
+      tb.cols_.resize( tb.cols_.size() + 1 );
+      column& cl = tb.cols_.back();
+      uint32_t ndict = 0;
+      if ( !get_str( cl.name_ ) || !get( &cl.enc_, sizeof( cl.enc_ ) ) ||
+           !get( &ndict, sizeof( ndict ) ) ) {
+        return set_err_msg( "corrupt columnar file=" + get_file() );
+      }
+      for( uint32_t k = 0; k != ndict; ++k ) {
+        cl.dict_.resize( cl.dict_.size() + 1 );
+        if ( !get_str( cl.dict_.back() ) ) {
+          return set_err_msg( "corrupt columnar file=" + get_file() );
+        }
+      }
+    }
+  }
+
+  // index row groups by table
+  for( uint64_t off = sizeof( magic ); off != tail.off_; ) {
+    col_grp grp;
+    if ( tail.off_ - off < sizeof( grp ) ) {
+      return set_err_msg( "corrupt columnar file=" + get_file() );
+    }
+    __builtin_memcpy( &grp, &buf[off], sizeof( grp ) );
+    if ( grp.tbl_ >= tvec_.size() ) {
+      return set_err_msg( "corrupt columnar file=" + get_file() );
+    }
+    table& tb = tvec_[grp.tbl_];
+    tb.grps_.push_back( off );
+    off += sizeof( grp );
+    for( size_t j = 0; j != tb.cols_.size(); ++j ) {
+      col_chunk chk;
+      if ( tail.off_ - off < sizeof( chk ) ) {
+        return set_err_msg( "corrupt columnar file=" + get_file() );
+      }
+      __builtin_memcpy( &chk, &buf[off], sizeof( chk ) );
+      uint64_t clen = chk.zlen_ ? chk.zlen_ : chk.len_;
+      if ( tail.off_ - off - sizeof( chk ) < clen ) {
+        return set_err_msg( "corrupt columnar file=" + get_file() );
+      }
+      off += sizeof( chk ) + clen;
+    }
+  }
+  return true;
+}
+
+unsigned col_reader::get_num_tables() const
+{
+  return static_cast< unsigned >( tvec_.size() );
+}
+
+std::string col_reader::get_table_name( unsigned tbl ) const
+{
+  return tvec_[tbl].name_;
+}
+
+unsigned col_reader::get_table( const std::string& name ) const
+{
+  unsigned i = 0;
+  for( ; i != tvec_.size() && tvec_[i].name_ != name; ++i );
+  return i;
+}
+
+unsigned col_reader::get_num_columns( unsigned tbl ) const
+{
+  return static_cast< unsigned >( tvec_[tbl].cols_.size() );
+}
+
+std::string col_reader::get_column_name( unsigned tbl, unsigned col ) const
+{
+  return tvec_[tbl].cols_[col].name_;
+}
+
+unsigned col_reader::get_column( unsigned tbl, const std::string& name ) const
+{
+  const std::vector<column>& cols = tvec_[tbl].cols_;
+  unsigned i = 0;
+  for( ; i != cols.size() && cols[i].name_ != name; ++i );
+  return i;
+}
+
+col_enc col_reader::get_column_enc( unsigned tbl, unsigned col ) const
+{
+  return tvec_[tbl].cols_[col].enc_;
+}
+
+uint64_t col_reader::get_num_rows( unsigned tbl ) const
+{
+  return tvec_[tbl].num_;
+}
+
+const std::vector<std::string>& col_reader::get_dict(
+    unsigned tbl, unsigned col ) const
+{
+  return tvec_[tbl].cols_[col].dict_;
+}
+
+bool col_reader::get_values( unsigned tbl, unsigned col,
+                             std::vector<int64_t>& vals )
+{
+  // chunk offsets were checked by init
+  const table& tb = tvec_[tbl];
+  const char *buf = mmap_.data();
+  bool is_delta = tb.cols_[col].enc_ == e_col_delta;
+  vals.clear();
+  vals.reserve( tb.num_ );
+  for( uint64_t off: tb.grps_ ) {
+    col_grp grp;
+    __builtin_memcpy( &grp, &buf[off], sizeof( grp ) );
+    off += sizeof( grp );
+    col_chunk chk;
+    for( unsigned j = 0; ; ++j ) {
+      __builtin_memcpy( &chk, &buf[off], sizeof( chk ) );
+      if ( j == col ) {
+        break;
+      }
+      off += sizeof( chk ) + ( chk.zlen_ ? chk.zlen_ : chk.len_ );
+    }
+    const char *ptr = &buf[off + sizeof( chk )];
+    if ( chk.zlen_ ) {
+      ebuf_.resize( chk.len_ );
+      size_t len = ZSTD_decompress( ebuf_.data(), ebuf_.size(),
+                                    ptr, chk.zlen_ );
+      if ( ZSTD_isError( len ) || len != chk.len_ ) {
+        return set_err_msg( "corrupt columnar file=" + get_file() );
+      }
+      ptr = ebuf_.data();
+    }
+    const char *end = ptr + chk.len_;
+    int64_t prev = 0L;
+    for( uint32_t i = 0; i != grp.nrow_; ++i ) {
+      uint64_t val;
+      if ( !get_varint( ptr, end, val ) ) {
+        return set_err_msg( "corrupt columnar file=" + get_file() );
+      }
+      if ( is_delta ) {
+        uint64_t diff = ( val >> 1 ) ^ ( ~( val & 1UL ) + 1UL );
+        prev = (int64_t)( (uint64_t)prev + diff );
+        vals.push_back( prev );
+      } else {
+        vals.push_back( (int64_t)val );
+      }
+    }
+  }
+  return true;
+}
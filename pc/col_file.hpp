@@ -0,0 +1,189 @@
+#pragma once
+
+#include <pc/error.hpp>
+#include <pc/hash_map.hpp>
+#include <pc/mem_map.hpp>
+#include <pc/misc.hpp>
+#include <vector>
+
+namespace pc
+{
+
+  // column encodings. delta columns store the zigzag varint difference
+  // from the previous row of the group, dictionary columns the varint
+  // index of the value in the column dictionary
+  enum col_enc : uint8_t {
+    e_col_delta = 0,
+    e_col_dict  = 1
+  };
+
+  // columnar export file. the file starts with col_magic followed by row
+  // groups of one table each, a col_grp and one zstd compressed chunk per
+  // column of the table. the schema and dictionaries follow the last
+  // group and the file ends with a col_tail
+  static const uint64_t col_magic = 0x31306c6f63637970UL; // "pyccol01"
+
+  struct PC_PACKED col_grp {
+    uint32_t tbl_;    // table number
+    uint32_t nrow_;   // rows in group
+  };
+
+  struct PC_PACKED col_chunk {
+    uint32_t zlen_;   // compressed length
+    uint32_t len_;    // encoded length
+  };
+
+  struct PC_PACKED col_tail {
+    uint64_t off_;    // file offset of schema
+    uint64_t magic_;  // col_magic
+  };
+
+  // writer of columnar tables. the schema is declared before init and
+  // rows are added one value per column
+  class col_writer : public error
+  {
+  public:
+
+    col_writer();
+    ~col_writer();
+
+    void set_file( const std::string& );
+    std::string get_file() const;
+
+    // zstd compression level of column chunks (default 3)
+    void set_zstd_level( int );
+    int get_zstd_level() const;
+
+    // rows per group (default 65536)
+    void set_group_rows( uint32_t );
+    uint32_t get_group_rows() const;
+
+    // add table or column of table and return its number
+    unsigned add_table( const std::string& name );
+    unsigned add_column( unsigned tbl, const std::string& name, col_enc );
+
+    // create file
+    bool init();
+
+    // dictionary index of value of dictionary column
+    uint32_t get_dict_id( unsigned tbl, unsigned col, str val );
+
+    // set value of column in current row of table
+    void set( unsigned tbl, unsigned col, int64_t val );
+
+    // add current row of table
+    void add_row( unsigned tbl );
+
+    // number of rows added to table
+    uint64_t get_num_rows( unsigned tbl ) const;
+
+    // write remaining groups, schema and dictionaries
+    bool close();
+
+  private:
+
+    struct trait_str {
+      typedef uint32_t           idx_t;
+      typedef std::string        key_t;
+      typedef const std::string& keyref_t;
+      typedef uint32_t           val_t;
+      struct hash_t {
+        idx_t operator() ( keyref_t s ) {
+          uint32_t h = 2166136261U;
+          for( char c: s ) {
+            h = ( h ^ (uint8_t)c ) * 16777619U;
+          }
+          return h;
+        }
+      };
+    };
+
+    typedef open_hash_map<trait_str> dict_map_t;
+    typedef std::vector<std::string> dict_vec_t;
+    typedef std::vector<int64_t>     val_vec_t;
+
+    struct column {
+      std::string name_;
+      col_enc     enc_;
+      val_vec_t   vals_;   // values of current group
+      int64_t     val_;    // value of current row
+      dict_map_t  dmap_;
+      dict_vec_t  dvec_;
+    };
+
+    typedef std::vector<column> col_vec_t;
+
+    struct table {
+      std::string name_;
+      col_vec_t   cols_;
+      uint64_t    num_;    // rows added
+    };
+
+    typedef std::vector<table> tbl_vec_t;
+
+    void write_group( table& );
+    void write_schema();
+    void write_file( const char *, size_t );
+
+    int               fd_;
+    int               zlvl_;
+    uint32_t          grows_;
+    uint64_t          off_;
+    void             *cxt_;
+    tbl_vec_t         tvec_;
+    std::vector<char> ebuf_;
+    std::vector<char> zbuf_;
+    std::string       file_;
+  };
+
+  // reader of columnar tables. columns are decoded whole
+  class col_reader : public error
+  {
+  public:
+
+    void set_file( const std::string& );
+    std::string get_file() const;
+
+    // map file and read schema
+    bool init();
+
+    // schema. table and column lookups by name return the number of
+    // tables or columns if not found
+    unsigned get_num_tables() const;
+    std::string get_table_name( unsigned tbl ) const;
+    unsigned get_table( const std::string& name ) const;
+    unsigned get_num_columns( unsigned tbl ) const;
+    std::string get_column_name( unsigned tbl, unsigned col ) const;
+    unsigned get_column( unsigned tbl, const std::string& name ) const;
+    col_enc get_column_enc( unsigned tbl, unsigned col ) const;
+    uint64_t get_num_rows( unsigned tbl ) const;
+
+    // decoded values of column or dictionary indices of a dictionary
+    // column
+    bool get_values( unsigned tbl, unsigned col, std::vector<int64_t>& );
+
+    // dictionary of column
+    const std::vector<std::string>& get_dict( unsigned tbl,
+                                              unsigned col ) const;
+
+  private:
+
+    struct column {
+      std::string              name_;
+      col_enc                  enc_;
+      std::vector<std::string> dict_;
+    };
+
+    struct table {
+      std::string            name_;
+      std::vector<column>    cols_;
+      std::vector<uint64_t>  grps_;  // file offset of groups
+      uint64_t               num_;
+    };
+
+    mem_map            mmap_;
+    std::vector<table> tvec_;
+    std::vector<char>  ebuf_;
+  };
+
+}
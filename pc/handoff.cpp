@@ -0,0 +1,343 @@
+#include "handoff.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define PC_HANDOFF_TIMEOUT_MS 2000
+
+using namespace pc;
+
+///////////////////////////////////////////////////////////////////////////
+// handoff_wtr
+
+void handoff_wtr::add( uint64_t val )
+{
+  buf_.append( (const char*)&val, sizeof( val ) );
+}
+
+void handoff_wtr::add( const pub_key& key )
+{
+  buf_.append( (const char*)key.data(), pub_key::len );
+}
+
+void handoff_wtr::add( str val )
+{
+  add( (uint64_t)val.len_ );
+  buf_.append( val.str_, val.len_ );
+}
+
+const std::string& handoff_wtr::get() const
+{
+  return buf_;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// handoff_rdr
+
+handoff_rdr::handoff_rdr( const std::string& buf )
+: buf_( buf ),
+  pos_( 0UL )
+{
+}
+
+bool handoff_rdr::get( uint64_t& val )
+{
+  if ( buf_.size() - pos_ < sizeof( val ) ) {
+    pos_ = buf_.size() + 1UL;
+    return false;
+  }
+  __builtin_memcpy( &val, &buf_[pos_], sizeof( val ) );
+  pos_ += sizeof( val );
+  return true;
+}
+
+bool handoff_rdr::get( pub_key& key )
+{
+  if ( buf_.size() - pos_ < pub_key::len ) {
+    pos_ = buf_.size() + 1UL;
+    return false;
+  }
+  key.init_from_buf( (const uint8_t*)&buf_[pos_] );
+  pos_ += pub_key::len;
+  return true;
+}
+
+bool handoff_rdr::get( std::string& val )
+{
+  uint64_t len = 0;
+  if ( !get( len ) || buf_.size() - pos_ < len ) {
+    pos_ = buf_.size() + 1UL;
+    return false;
+  }
+  val.assign( &buf_[pos_], len );
+  pos_ += len;
+  return true;
+}
+
+bool handoff_rdr::get_is_end() const
+{
+  return pos_ == buf_.size();
+}
+
+///////////////////////////////////////////////////////////////////////////
+// handoff
+
+static bool set_handoff_addr( const std::string& file, sockaddr_un& addr )
+{
+  __builtin_memset( &addr, 0, sizeof( addr ) );
+  addr.sun_family = AF_UNIX;
+  if ( file.size() >= sizeof( addr.sun_path ) ) {
+    return false;
+  }
+  __builtin_memcpy( addr.sun_path, file.c_str(), file.size() );
+  return true;
+}
+
+static void set_handoff_timeout( int fd )
+{
+  // both sides block on each other for at most this long
+  timeval tv;
+  tv.tv_sec  = PC_HANDOFF_TIMEOUT_MS / 1000;
+  tv.tv_usec = ( PC_HANDOFF_TIMEOUT_MS % 1000 ) * 1000;
+  ::setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof( tv ) );
+  ::setsockopt( fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof( tv ) );
+}
+
+handoff::handoff()
+: is_recv_( false ),
+  lfd_( -1 )
+{
+}
+
+handoff::~handoff()
+{
+}
+
+void handoff::set_file( const std::string& file )
+{
+  file_ = file;
+}
+
+std::string handoff::get_file() const
+{
+  return file_;
+}
+
+bool handoff::init()
+{
+  close();
+  reset_err();
+  sockaddr_un addr;
+  if ( !set_handoff_addr( file_, addr ) ) {
+    return set_err_msg( "handoff file path too long file=" + file_ );
+  }
+  int fd = ::socket( AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0 );
+  if ( fd < 0 ) {
+    return set_err_msg( "failed to construct handoff socket", errno );
+  }
+  ::unlink( file_.c_str() );
+  if ( 0 != ::bind( fd, (sockaddr*)&addr, sizeof( addr ) ) ) {
+    ::close( fd );
+    return set_err_msg( "failed to bind handoff file=" + file_, errno );
+  }
+  set_fd( fd );
+  return net_listen::init();
+}
+
+bool handoff::get_is_recv() const
+{
+  return is_recv_;
+}
+
+int handoff::get_listen_fd() const
+{
+  return lfd_;
+}
+
+handoff::conn_vec_t& handoff::get_conns()
+{
+  return cvec_;
+}
+
+void handoff::close_conns()
+{
+  if ( lfd_ >= 0 ) {
+    ::close( lfd_ );
+    lfd_ = -1;
+  }
+  for( conn& cn: cvec_ ) {
+    ::close( cn.fd_ );
+  }
+  cvec_.clear();
+}
+
+bool handoff::recv()
+{
+  is_recv_ = false;
+  lfd_ = -1;
+  cvec_.clear();
+  sockaddr_un addr;
+  if ( !set_handoff_addr( file_, addr ) ) {
+    return set_err_msg( "handoff file path too long file=" + file_ );
+  }
+  int fd = ::socket( AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0 );
+  if ( fd < 0 ) {
+    return set_err_msg( "failed to construct handoff socket", errno );
+  }
+
+  // nothing to take over without a running process
+  if ( 0 != ::connect( fd, (sockaddr*)&addr, sizeof( addr ) ) ) {
+    int err = errno;
+    ::close( fd );
+    if ( err == ENOENT || err == ECONNREFUSED ) {
+      return true;
+    }
+    return set_err_msg( "failed to connect to handoff file=" + file_, err );
+  }
+  set_handoff_timeout( fd );
+
+  // listening socket, then each connection with its state in chunks
+  rec_hdr hdr;
+  std::string buf;
+  uint32_t ver = 0;
+  bool is_ok = recv_rec( fd, hdr, lfd_, buf ) && hdr.type_ == e_begin &&
+    buf.size() == sizeof( ver );
+  if ( is_ok ) {
+    __builtin_memcpy( &ver, buf.data(), sizeof( ver ) );
+    is_ok = ver == version;
+  }
+  for( uint64_t i = 0, num = hdr.len_; is_ok && i != num; ++i ) {
+    conn cn;
+    is_ok = recv_rec( fd, hdr, cn.fd_, cn.state_ );
+    if ( cn.fd_ >= 0 ) {
+      cvec_.push_back( cn );
+    }
+    is_ok = is_ok && hdr.type_ == e_conn && cn.fd_ >= 0;
+    uint64_t len = hdr.len_;
+    while( is_ok && cvec_.back().state_.size() < len ) {
+      int rfd = -1;
+      is_ok = recv_rec( fd, hdr, rfd, buf ) && hdr.type_ == e_data;
+      if ( rfd >= 0 ) {
+        ::close( rfd );
+        is_ok = false;
+      }
+      cvec_.back().state_ += buf;
+    }
+    is_ok = is_ok && cvec_.back().state_.size() == len;
+  }
+  if ( is_ok ) {
+    int rfd = -1;
+    is_ok = recv_rec( fd, hdr, rfd, buf ) && hdr.type_ == e_end;
+  }
+
+  // the running process lets go of its sockets on our acknowledgement
+  char ack = 1;
+  is_ok = is_ok && 1 == ::send( fd, &ack, 1, MSG_NOSIGNAL );
+  ::close( fd );
+  if ( !is_ok ) {
+    close_conns();
+    if ( !get_is_err() ) {
+      set_err_msg( "invalid handoff from file=" + file_ );
+    }
+    return false;
+  }
+  is_recv_ = true;
+  return true;
+}
+
+bool handoff::send( int fd, int listen_fd, const conn_vec_t& cvec )
+{
+  int flags = ::fcntl( fd, F_GETFL, 0 );
+  ::fcntl( fd, F_SETFL, flags & ~O_NONBLOCK );
+  set_handoff_timeout( fd );
+  uint32_t ver = version;
+  bool is_ok = send_rec( fd, e_begin, cvec.size(), listen_fd,
+                         (const char*)&ver, sizeof( ver ) );
+  for( const conn& cn: cvec ) {
+    const std::string& st = cn.state_;
+    size_t len = std::min( st.size(), chunk_len );
+    is_ok = is_ok && send_rec( fd, e_conn, st.size(), cn.fd_, st.data(), len );
+    for( size_t pos = len; is_ok && pos != st.size(); pos += len ) {
+      len = std::min( st.size() - pos, chunk_len );
+      is_ok = send_rec( fd, e_data, 0UL, -1, &st[pos], len );
+    }
+  }
+  is_ok = is_ok && send_rec( fd, e_end, 0UL, -1, nullptr, 0UL );
+  char ack = 0;
+  if ( is_ok && ( 1 != ::recv( fd, &ack, 1, 0 ) || ack != 1 ) ) {
+    is_ok = set_err_msg( "no handoff acknowledgement", errno );
+  }
+  ::close( fd );
+  return is_ok;
+}
+
+bool handoff::send_rec( int fd, rec_t type, uint64_t len, int sfd,
+                        const char *buf, size_t buf_len )
+{
+  rec_hdr hdr;
+  hdr.magic_ = magic;
+  hdr.type_  = type;
+  hdr.len_   = len;
+  iovec iov[2];
+  iov[0].iov_base = &hdr;
+  iov[0].iov_len  = sizeof( hdr );
+  iov[1].iov_base = (void*)buf;
+  iov[1].iov_len  = buf_len;
+  msghdr msg;
+  __builtin_memset( &msg, 0, sizeof( msg ) );
+  msg.msg_iov    = iov;
+  msg.msg_iovlen = buf_len ? 2 : 1;
+  char cbuf[CMSG_SPACE( sizeof( int ) )];
+  if ( sfd >= 0 ) {
+    __builtin_memset( cbuf, 0, sizeof( cbuf ) );
+    msg.msg_control    = cbuf;
+    msg.msg_controllen = sizeof( cbuf );
+    cmsghdr *cm = CMSG_FIRSTHDR( &msg );
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type  = SCM_RIGHTS;
+    cm->cmsg_len   = CMSG_LEN( sizeof( int ) );
+    __builtin_memcpy( CMSG_DATA( cm ), &sfd, sizeof( int ) );
+  }
+  ssize_t rc = ::sendmsg( fd, &msg, MSG_NOSIGNAL );
+  if ( rc != (ssize_t)( sizeof( hdr ) + buf_len ) ) {
+    return set_err_msg( "failed to send handoff", errno );
+  }
+  return true;
+}
+
+bool handoff::recv_rec( int fd, rec_hdr& hdr, int& rfd, std::string& buf )
+{
+  rfd = -1;
+  buf.resize( sizeof( hdr ) + chunk_len );
+  iovec iov[1];
+  iov[0].iov_base = &buf[0];
+  iov[0].iov_len  = buf.size();
+  char cbuf[CMSG_SPACE( sizeof( int ) )];
+  msghdr msg;
+  __builtin_memset( &msg, 0, sizeof( msg ) );
+  msg.msg_iov        = iov;
+  msg.msg_iovlen     = 1;
+  msg.msg_control    = cbuf;
+  msg.msg_controllen = sizeof( cbuf );
+  ssize_t rc = ::recvmsg( fd, &msg, MSG_CMSG_CLOEXEC );
+  for( cmsghdr *cm = CMSG_FIRSTHDR( &msg ); rc >= 0 && cm;
+       cm = CMSG_NXTHDR( &msg, cm ) ) {
+    if ( cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS ) {
+      __builtin_memcpy( &rfd, CMSG_DATA( cm ), sizeof( int ) );
+    }
+  }
+  if ( rc < (ssize_t)sizeof( hdr ) || ( msg.msg_flags & MSG_CTRUNC ) ) {
+    return set_err_msg( "failed to receive handoff", rc < 0 ? errno : 0 );
+  }
+  __builtin_memcpy( &hdr, buf.data(), sizeof( hdr ) );
+  if ( hdr.magic_ != magic ) {
+    return set_err_msg( "invalid handoff from file=" + file_ );
+  }
+  buf.erase( 0, sizeof( hdr ) );
+  buf.resize( static_cast< size_t >( rc ) - sizeof( hdr ) );
+  return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <pc/net_socket.hpp>
+#include <string>
+#include <vector>
+
+namespace pc
+{
+
+  // state of a handed over connection written as a flat byte string
+  class handoff_wtr
+  {
+  public:
+    void add( uint64_t );
+    void add( const pub_key& );
+    void add( str );
+    const std::string& get() const;
+
+  private:
+    std::string buf_;
+  };
+
+  // read back state written by handoff_wtr. every get fails once the
+  // state is exhausted or malformed
+  class handoff_rdr
+  {
+  public:
+    handoff_rdr( const std::string& );
+    bool get( uint64_t& );
+    bool get( pub_key& );
+    bool get( std::string& );
+
+    // all state has been read
+    bool get_is_end() const;
+
+  private:
+    const std::string& buf_;
+    size_t             pos_;
+  };
+
+  // zero-downtime restart. a running pythd listens for its successor on
+  // a unix socket at the handoff file. a successor started with the same
+  // file connects on init and is sent the listening socket and the user
+  // connections with the state of each (SCM_RIGHTS). the running process
+  // saves its account snapshot for the successor to load first and only
+  // lets go of its sockets once the successor has acknowledged them
+  class handoff : public net_listen
+  {
+  public:
+
+    handoff();
+    ~handoff();
+
+    // unix socket path
+    void set_file( const std::string& );
+    std::string get_file() const;
+
+    // listen for a successor (replacing any stale socket file)
+    bool init() override;
+
+    // connection handed over and its state
+    struct conn {
+      int         fd_;
+      std::string state_;
+    };
+
+    typedef std::vector<conn> conn_vec_t;
+
+    // take over the sockets of the running process. returns false on
+    // error and true with get_is_recv() false if none is running
+    bool recv();
+    bool get_is_recv() const;
+
+    // sockets received from the running process. the caller takes over
+    // the listening socket (-1 if none) and the connections
+    int get_listen_fd() const;
+    conn_vec_t& get_conns();
+
+    // send the listening socket (-1 if none) and connections to the
+    // successor connected on fd. fd is closed in any case. the sockets
+    // sent stay open and may only be closed once this returns true
+    bool send( int fd, int listen_fd, const conn_vec_t& );
+
+  private:
+
+    static const uint32_t magic     = 0x70796864; // "pyhd"
+    static const uint32_t version   = 2U;
+    static const size_t   chunk_len = 32768UL;    // state per message
+
+    typedef enum { e_begin = 0, e_conn, e_data, e_end } rec_t;
+
+    struct rec_hdr {
+      uint32_t magic_;
+      uint32_t type_;
+      uint64_t len_;  // connections on e_begin or state of e_conn
+    };
+
+    bool send_rec( int fd, rec_t, uint64_t len, int sfd,
+                   const char *buf, size_t buf_len );
+    bool recv_rec( int fd, rec_hdr&, int& rfd, std::string& buf );
+    void close_conns();
+
+    std::string file_;
+    bool        is_recv_;
+    int         lfd_;    // received listening socket
+    conn_vec_t  cvec_;   // received connections
+  };
+
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <pc/huge_page.hpp>
+#include <utility>
 #include <vector>
+#include <stdint.h>
 #include <stdlib.h>
 
 namespace pc
@@ -39,7 +42,7 @@ namespace pc
       val_t val_;
     };
 
-    typedef std::vector<node> node_vec_t;
+    typedef std::vector<node,huge_allocator<node>> node_vec_t;
 
     node_vec_t nvec_;
     idx_t      htab_[hsize_];
@@ -130,4 +133,191 @@ namespace pc
     __builtin_memset( htab_, 0 , sizeof( htab_ ) );
   }
 
+  // open-addressing hash map based on type trait T using robin hood
+  // linear probing over a power-of-two table that doubles in size at 7/8
+  // load. T::hsize_ is not used; the table starts at min_size slots.
+  // iterators remain valid only until the next add or del
+  template<class T>
+  class open_hash_map
+  {
+  public:
+
+    typedef typename T::idx_t    idx_t;
+    typedef typename T::key_t    key_t;
+    typedef typename T::keyref_t keyref_t;
+    typedef typename T::val_t    val_t;
+    typedef typename T::hash_t   hash_t;
+
+    static const size_t min_size = 16UL;
+
+  private:
+
+    struct slot {
+      uint32_t dist_;  // probe distance plus one or zero if empty
+      key_t    key_;
+      val_t    val_;
+    };
+
+  public:
+
+    typedef slot *iter_t;
+
+    open_hash_map( hash_t hfn = hash_t() );
+
+    iter_t find( keyref_t );
+    iter_t add( keyref_t );
+    const val_t &const_ref( iter_t ) const;
+    val_t &ref( iter_t );
+    val_t  obj( iter_t );
+    void   del( iter_t );
+    size_t size() const;
+    size_t capacity() const;
+    void   clear();
+
+  private:
+
+    typedef std::vector<slot,huge_allocator<slot>> slot_vec_t;
+
+    size_t home( keyref_t );
+    void   grow();
+
+    slot_vec_t svec_;
+    size_t     mask_;
+    unsigned   shift_;
+    hash_t     hfn_;
+    size_t     nval_;
+  };
+
+  template<class T>
+  open_hash_map<T>::open_hash_map( hash_t hfn )
+  : svec_( min_size ),
+    mask_( min_size - 1 ),
+    shift_( static_cast< unsigned >( 64 - __builtin_ctzl( min_size ) ) ),
+    hfn_( hfn ),
+    nval_( 0 )
+  {
+  }
+
+  template<class T>
+  size_t open_hash_map<T>::home( keyref_t k )
+  {
+    // fibonacci hashing spreads trait hashes that only vary in low or
+    // high bits across the whole table
+    return ( (uint64_t)hfn_( k ) * 0x9e3779b97f4a7c15UL ) >> shift_;
+  }
+
+  template<class T>
+  typename open_hash_map<T>::iter_t open_hash_map<T>::find( keyref_t k )
+  {
+    size_t i = home( k );
+    for( uint32_t d = 1; ; ++d, i = ( i + 1 ) & mask_ ) {
+      slot& s = svec_[i];
+      if ( s.dist_ < d ) {
+        return nullptr;
+      }
+      if ( s.dist_ == d && k == s.key_ ) {
+        return &s;
+      }
+    }
+  }
+
+  template<class T>
+  typename open_hash_map<T>::iter_t open_hash_map<T>::add( keyref_t k )
+  {
+    if ( 8 * ( nval_ + 1 ) > 7 * svec_.size() ) {
+      grow();
+    }
+    slot ins;
+    ins.dist_ = 1;
+    ins.key_  = k;
+    ins.val_  = val_t();
+    iter_t res = nullptr;
+    for( size_t i = home( k ); ; i = ( i + 1 ) & mask_, ++ins.dist_ ) {
+      slot& s = svec_[i];
+      if ( !s.dist_ ) {
+        s = ins;
+        res = res ? res : &s;
+        break;
+      }
+      // take the slot from an entry closer to its home and carry on
+      // inserting the displaced entry
+      if ( s.dist_ < ins.dist_ ) {
+        std::swap( s, ins );
+        res = res ? res : &s;
+      }
+    }
+    ++nval_;
+    return res;
+  }
+
+  template<class T>
+  void open_hash_map<T>::del( iter_t it )
+  {
+    // shift following entries back one slot until an empty slot or an
+    // entry already in its home slot
+    size_t i = static_cast< size_t >( it - svec_.data() );
+    for( size_t j = ( i + 1 ) & mask_; svec_[j].dist_ > 1;
+         i = j, j = ( j + 1 ) & mask_ ) {
+      svec_[i] = svec_[j];
+      --svec_[i].dist_;
+    }
+    svec_[i].dist_ = 0;
+    svec_[i].val_  = val_t();
+    --nval_;
+  }
+
+  template<class T>
+  void open_hash_map<T>::grow()
+  {
+    slot_vec_t svec( 2 * svec_.size() );
+    svec.swap( svec_ );
+    mask_ = svec_.size() - 1;
+    --shift_;
+    nval_ = 0;
+    for( slot& s: svec ) {
+      if ( s.dist_ ) {
+        ref( add( s.key_ ) ) = s.val_;
+      }
+    }
+  }
+
+  template<class T>
+  const typename T::val_t &open_hash_map<T>::const_ref( iter_t i ) const
+  {
+    return i->val_;
+  }
+
+  template<class T>
+  typename T::val_t &open_hash_map<T>::ref( iter_t i )
+  {
+    return i->val_;
+  }
+
+  template<class T>
+  typename T::val_t open_hash_map<T>::obj( iter_t i )
+  {
+    return i->val_;
+  }
+
+  template<class T>
+  size_t open_hash_map<T>::size() const
+  {
+    return nval_;
+  }
+
+  template<class T>
+  size_t open_hash_map<T>::capacity() const
+  {
+    return svec_.size();
+  }
+
+  template<class T>
+  void open_hash_map<T>::clear()
+  {
+    slot_vec_t( min_size ).swap( svec_ );
+    mask_  = min_size - 1;
+    shift_ = static_cast< unsigned >( 64 - __builtin_ctzl( min_size ) );
+    nval_  = 0;
+  }
+
 }
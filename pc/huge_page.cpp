@@ -0,0 +1,124 @@
+#include "huge_page.hpp"
+
+#include <atomic>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+using namespace pc;
+
+namespace
+{
+  typedef enum { e_heap, e_huge, e_thp } map_t;
+
+  // header in the 64 bytes before each allocation
+  struct hdr
+  {
+    char    *map_;   // start of mapping or heap block
+    size_t   len_;   // mapping length
+    map_t    type_;
+  };
+
+  const size_t hdr_len = 64UL;
+
+  std::atomic<bool>     is_huge_( false );
+  std::atomic<uint64_t> huge_len_( 0UL );
+  std::atomic<uint64_t> thp_len_( 0UL );
+}
+
+void huge_page::set_enabled( bool is_huge )
+{
+  is_huge_ = is_huge;
+}
+
+bool huge_page::get_enabled()
+{
+  return is_huge_;
+}
+
+uint64_t huge_page::get_huge_len()
+{
+  return huge_len_;
+}
+
+uint64_t huge_page::get_thp_len()
+{
+  return thp_len_;
+}
+
+static char *map_pages( size_t len, map_t& type )
+{
+  // reserved huge pages first
+  void *ptr = ::mmap( nullptr, len, PROT_READ|PROT_WRITE,
+                      MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0 );
+  if ( ptr != MAP_FAILED ) {
+    type = e_huge;
+    huge_len_ += len;
+    return static_cast< char* >( ptr );
+  }
+
+  // otherwise transparent huge pages over a huge page aligned range
+  const size_t page_len = huge_page::page_len;
+  ptr = ::mmap( nullptr, len + page_len, PROT_READ|PROT_WRITE,
+                MAP_PRIVATE|MAP_ANONYMOUS, -1, 0 );
+  if ( ptr == MAP_FAILED ) {
+    return nullptr;
+  }
+  char *raw = static_cast< char* >( ptr );
+  uintptr_t off = reinterpret_cast< uintptr_t >( raw ) & ( page_len - 1 );
+  size_t head = off ? page_len - off : 0UL;
+  if ( head ) {
+    ::munmap( raw, head );
+  }
+  if ( page_len - head ) {
+    ::munmap( raw + head + len, page_len - head );
+  }
+  ::madvise( raw + head, len, MADV_HUGEPAGE );
+  type = e_thp;
+  thp_len_ += len;
+  return raw + head;
+}
+
+void *huge_page::alloc( size_t len )
+{
+  size_t tot = len + hdr_len;
+  char *ptr = nullptr;
+  map_t type = e_heap;
+  if ( len >= min_len && is_huge_.load( std::memory_order_relaxed ) ) {
+    tot = ( tot + page_len - 1 ) & ~( page_len - 1 );
+    ptr = map_pages( tot, type );
+  }
+  if ( !ptr ) {
+    void *blk = nullptr;
+    if ( ::posix_memalign( &blk, hdr_len, tot ) ) {
+      throw std::bad_alloc();
+    }
+    ptr = static_cast< char* >( blk );
+    type = e_heap;
+  }
+  hdr *hptr = reinterpret_cast< hdr* >( ptr );
+  hptr->map_  = ptr;
+  hptr->len_  = tot;
+  hptr->type_ = type;
+  return ptr + hdr_len;
+}
+
+void huge_page::dealloc( void *ptr )
+{
+  if ( !ptr ) {
+    return;
+  }
+  hdr *hptr = reinterpret_cast< hdr* >( static_cast< char* >( ptr ) - hdr_len );
+  switch( hptr->type_ ) {
+    case e_heap:
+      ::free( hptr->map_ );
+      break;
+    case e_huge:
+      huge_len_ -= hptr->len_;
+      ::munmap( hptr->map_, hptr->len_ );
+      break;
+    case e_thp:
+      thp_len_ -= hptr->len_;
+      ::munmap( hptr->map_, hptr->len_ );
+      break;
+  }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+
+namespace pc
+{
+
+  // allocation of large tables and arenas from 2MB huge pages to cut
+  // tlb misses (off by default). once enabled, allocations of at least
+  // min_len are mapped from pages reserved for MAP_HUGETLB or, if there
+  // are none, from 2MB aligned memory advised to transparent huge pages.
+  // smaller allocations and all allocations while disabled come from
+  // the heap. allocations are 64 byte aligned
+  class huge_page
+  {
+  public:
+
+    // huge page size
+    static const size_t page_len = 2UL * 1024UL * 1024UL;
+
+    // largest allocation that fits in one huge page
+    static const size_t fit_len = page_len - 64UL;
+
+    // smallest allocation mapped from huge pages
+    static const size_t min_len = page_len / 2UL;
+
+    // use huge pages for allocations from now on
+    static void set_enabled( bool );
+    static bool get_enabled();
+
+    // allocate or release memory. alloc throws std::bad_alloc on failure
+    static void *alloc( size_t len );
+    static void dealloc( void * );
+
+    // bytes currently mapped from reserved or transparent huge pages
+    static uint64_t get_huge_len();
+    static uint64_t get_thp_len();
+  };
+
+  // std::allocator equivalent over huge_page for container storage
+  template<class T>
+  struct huge_allocator
+  {
+    typedef T value_type;
+
+    huge_allocator() {}
+    template<class U> huge_allocator( const huge_allocator<U>& ) {}
+
+    T *allocate( size_t num ) {
+      return static_cast< T* >( huge_page::alloc( num * sizeof( T ) ) );
+    }
+    void deallocate( T *ptr, size_t ) {
+      huge_page::dealloc( ptr );
+    }
+  };
+
+  template<class T, class U>
+  inline bool operator==( const huge_allocator<T>&, const huge_allocator<U>& )
+  {
+    return true;
+  }
+
+  template<class T, class U>
+  inline bool operator!=( const huge_allocator<T>&, const huge_allocator<U>& )
+  {
+    return false;
+  }
+
+}
@@ -1,6 +1,13 @@
 #include "jtree.hpp"
 #include <ctype.h>
 #include <stdlib.h>
+#include <algorithm>
+
+#if defined( __x86_64__ )
+#include <immintrin.h>
+#elif defined( __ARM_NEON )
+#include <arm_neon.h>
+#endif
 
 using namespace pc;
 
@@ -9,80 +16,304 @@ jtree::jtree()
 {
 }
 
+///////////////////////////////////////////////////////////////////////////
+// structural index
+//
+// the first pass classifies the message 64 bytes at a time into
+// bitmaps of quotes, backslashes, whitespace and operators. escaped
+// and in-string characters are masked out using carries between blocks
+// so that only operators, real quotes and the first byte of every
+// scalar (number or keyword) run remain. the second pass walks these
+// positions to build the tree - string contents are never touched
+
+namespace
+{
+  struct jblock
+  {
+    uint64_t qt_; // quotes
+    uint64_t bs_; // backslashes
+    uint64_t ws_; // whitespace
+    uint64_t op_; // {}[]:,
+  };
+
+  inline bool is_jws( char c )
+  {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  }
+
+  inline bool is_jop( char c )
+  {
+    return c == '{' || c == '}' || c == '[' || c == ']' ||
+           c == ':' || c == ',';
+  }
+
+#if defined( __SSE2__ )
+  inline uint64_t jt_mask16( __m128i v )
+  {
+    return (uint64_t)(uint32_t)_mm_movemask_epi8( v );
+  }
+
+  void jt_classify_sse2( const char *ptr, jblock& b )
+  {
+    b.qt_ = b.bs_ = b.ws_ = b.op_ = 0UL;
+    for( unsigned i=0; i != 64; i += 16 ) {
+      __m128i v = _mm_loadu_si128( (const __m128i*)&ptr[i] );
+      __m128i qt = _mm_cmpeq_epi8( v, _mm_set1_epi8( '"' ) );
+      __m128i bs = _mm_cmpeq_epi8( v, _mm_set1_epi8( '\\' ) );
+      __m128i ws = _mm_or_si128(
+          _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( ' ' ) ),
+                        _mm_cmpeq_epi8( v, _mm_set1_epi8( '\t' ) ) ),
+          _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '\n' ) ),
+                        _mm_cmpeq_epi8( v, _mm_set1_epi8( '\r' ) ) ) );
+      __m128i op = _mm_or_si128(
+          _mm_or_si128(
+            _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '{' ) ),
+                          _mm_cmpeq_epi8( v, _mm_set1_epi8( '}' ) ) ),
+            _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '[' ) ),
+                          _mm_cmpeq_epi8( v, _mm_set1_epi8( ']' ) ) ) ),
+          _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( ':' ) ),
+                        _mm_cmpeq_epi8( v, _mm_set1_epi8( ',' ) ) ) );
+      b.qt_ |= jt_mask16( qt ) << i;
+      b.bs_ |= jt_mask16( bs ) << i;
+      b.ws_ |= jt_mask16( ws ) << i;
+      b.op_ |= jt_mask16( op ) << i;
+    }
+  }
+#endif
+
+#if defined( __x86_64__ )
+  __attribute__(( target( "avx2" ) ))
+  inline uint64_t jt_mask32( __m256i v )
+  {
+    return (uint64_t)(uint32_t)_mm256_movemask_epi8( v );
+  }
+
+  __attribute__(( target( "avx2" ) ))
+  void jt_classify_avx2( const char *ptr, jblock& b )
+  {
+    // nibble lookup tables - a byte is whitespace (operator) if the table
+    // entry at its low nibble equals the byte (the byte with 0x20 set)
+    const __m256i ws_tbl = _mm256_setr_epi8(
+        ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100,
+        '\r', 100, 100,
+        ' ', 100, 100, 100, 17, 100, 113, 2, 100, '\t', '\n', 112, 100,
+        '\r', 100, 100 );
+    const __m256i op_tbl = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, ':', '{', ',', '}', 0, 0 );
+    b.qt_ = b.bs_ = b.ws_ = b.op_ = 0UL;
+    for( unsigned i=0; i != 64; i += 32 ) {
+      __m256i v = _mm256_loadu_si256( (const __m256i*)&ptr[i] );
+      __m256i qt = _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '"' ) );
+      __m256i bs = _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\\' ) );
+      __m256i ws = _mm256_cmpeq_epi8( v, _mm256_shuffle_epi8( ws_tbl, v ) );
+      __m256i op = _mm256_cmpeq_epi8(
+          _mm256_or_si256( v, _mm256_set1_epi8( 0x20 ) ),
+          _mm256_shuffle_epi8( op_tbl, v ) );
+      b.qt_ |= jt_mask32( qt ) << i;
+      b.bs_ |= jt_mask32( bs ) << i;
+      b.ws_ |= jt_mask32( ws ) << i;
+      b.op_ |= jt_mask32( op ) << i;
+    }
+  }
+
+  bool get_has_avx2()
+  {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+  }
+
+  const bool has_avx2 = get_has_avx2();
+#endif
+
+#if defined( __aarch64__ ) && defined( __ARM_NEON )
+  inline uint64_t jt_mask64(
+      uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d )
+  {
+    const uint8x16_t bit = {
+      0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+      0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+    uint8x16_t s0 = vpaddq_u8( vandq_u8( a, bit ), vandq_u8( b, bit ) );
+    uint8x16_t s1 = vpaddq_u8( vandq_u8( c, bit ), vandq_u8( d, bit ) );
+    s0 = vpaddq_u8( s0, s1 );
+    s0 = vpaddq_u8( s0, s0 );
+    return vgetq_lane_u64( vreinterpretq_u64_u8( s0 ), 0 );
+  }
+
+  void jt_classify_neon( const char *ptr, jblock& b )
+  {
+    uint8x16_t qt[4], bs[4], ws[4], op[4];
+    for( unsigned i=0; i != 4; ++i ) {
+      uint8x16_t v = vld1q_u8( (const uint8_t*)&ptr[16*i] );
+      qt[i] = vceqq_u8( v, vdupq_n_u8( '"' ) );
+      bs[i] = vceqq_u8( v, vdupq_n_u8( '\\' ) );
+      ws[i] = vorrq_u8(
+          vorrq_u8( vceqq_u8( v, vdupq_n_u8( ' ' ) ),
+                    vceqq_u8( v, vdupq_n_u8( '\t' ) ) ),
+          vorrq_u8( vceqq_u8( v, vdupq_n_u8( '\n' ) ),
+                    vceqq_u8( v, vdupq_n_u8( '\r' ) ) ) );
+      op[i] = vorrq_u8(
+          vorrq_u8(
+            vorrq_u8( vceqq_u8( v, vdupq_n_u8( '{' ) ),
+                      vceqq_u8( v, vdupq_n_u8( '}' ) ) ),
+            vorrq_u8( vceqq_u8( v, vdupq_n_u8( '[' ) ),
+                      vceqq_u8( v, vdupq_n_u8( ']' ) ) ) ),
+          vorrq_u8( vceqq_u8( v, vdupq_n_u8( ':' ) ),
+                    vceqq_u8( v, vdupq_n_u8( ',' ) ) ) );
+    }
+    b.qt_ = jt_mask64( qt[0], qt[1], qt[2], qt[3] );
+    b.bs_ = jt_mask64( bs[0], bs[1], bs[2], bs[3] );
+    b.ws_ = jt_mask64( ws[0], ws[1], ws[2], ws[3] );
+    b.op_ = jt_mask64( op[0], op[1], op[2], op[3] );
+  }
+#endif
+
+#if !defined( __SSE2__ ) && !( defined( __aarch64__ ) && defined( __ARM_NEON ) )
+  void jt_classify_scalar( const char *ptr, jblock& b )
+  {
+    b.qt_ = b.bs_ = b.ws_ = b.op_ = 0UL;
+    for( unsigned i=0; i != 64; ++i ) {
+      uint64_t bit = 1UL << i;
+      char c = ptr[i];
+      if ( c == '"' ) b.qt_ |= bit;
+      else if ( c == '\\' ) b.bs_ |= bit;
+      else if ( is_jws( c ) ) b.ws_ |= bit;
+      else if ( is_jop( c ) ) b.op_ |= bit;
+    }
+  }
+#endif
+
+  inline void jt_classify( const char *ptr, jblock& b )
+  {
+#if defined( __x86_64__ )
+    if ( has_avx2 ) {
+      jt_classify_avx2( ptr, b );
+      return;
+    }
+#endif
+#if defined( __SSE2__ )
+    jt_classify_sse2( ptr, b );
+#elif defined( __aarch64__ ) && defined( __ARM_NEON )
+    jt_classify_neon( ptr, b );
+#else
+    jt_classify_scalar( ptr, b );
+#endif
+  }
+
+  // characters preceded by an odd-length run of backslashes
+  inline uint64_t jt_escaped( uint64_t bs, uint64_t& carry )
+  {
+    const uint64_t even = 0x5555555555555555UL;
+    bs &= ~carry;
+    uint64_t follows = ( bs << 1 ) | carry;
+    uint64_t odd_starts = bs & ~even & ~follows;
+    uint64_t even_seq;
+    carry = __builtin_add_overflow( odd_starts, bs, &even_seq ) ? 1UL : 0UL;
+    return ( even ^ ( even_seq << 1 ) ) & follows;
+  }
+
+  // bit i set if odd number of bits set at or below i
+  inline uint64_t jt_prefix_xor( uint64_t x )
+  {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+  }
+
+  inline bool is_jnum( char c )
+  {
+    return isdigit( c ) || c == '.' || c == '-' || c == 'e' || c == '+';
+  }
+
+}
+
+size_t jtree::index( const char *cptr, size_t sz )
+{
+  // room for every position so blocks can be written without checks
+  if ( ix_.size() < sz + 64 ) {
+    ix_.resize( sz + 64 );
+  }
+  uint32_t *ix = ix_.data();
+  size_t num = 0;
+  uint64_t esc = 0UL, ins = 0UL, sca = 0UL;
+  char tail[64];
+  for( size_t i=0; i < sz; i += 64 ) {
+    // pad final block with whitespace
+    const char *ptr = &cptr[i];
+    if ( sz - i < 64 ) {
+      __builtin_memset( tail, ' ', sizeof( tail ) );
+      __builtin_memcpy( tail, ptr, sz - i );
+      ptr = tail;
+    }
+    jblock b;
+    jt_classify( ptr, b );
+    uint64_t qt = b.qt_ & ~jt_escaped( b.bs_, esc );
+    uint64_t in_str = jt_prefix_xor( qt ) ^ ins;
+    ins = 0UL - ( in_str >> 63 );
+    uint64_t scalar = ~( b.ws_ | b.op_ | qt | in_str );
+    uint64_t starts = scalar & ~( ( scalar << 1 ) | sca );
+    sca = scalar >> 63;
+    uint64_t bits = ( b.op_ & ~in_str ) | qt | starts;
+    while( bits ) {
+      ix[num++] = (uint32_t)( i + (size_t)__builtin_ctzl( bits ) );
+      bits &= bits - 1;
+    }
+  }
+  return num;
+}
+
 void jtree::parse( const char *cptr, size_t sz )
 {
   buf_ = cptr;
   key_ = 0;
   nv_.resize(1);
   st_.clear();
-
-  typedef enum { e_start, e_string, e_number, e_keyword } state_t;
-  state_t st = e_start;
-  const char *txt=nullptr, *end = &cptr[sz];
-  for(;;) {
-    switch(st) {
-      case e_start: {
-        for(;;++cptr) {
-          if( cptr==end ) return;
-          if (*cptr == '{' ) {
-            parse_start_object();
-          } else if ( *cptr == '[' ) {
-            parse_start_array();
-          } else if (*cptr == '}' ) {
-            parse_end_object();
-          } else if ( *cptr == ']' ) {
-            parse_end_array();
-          } else if ( *cptr == '"' ) {
-            st = e_string; txt=cptr+1; break;
-          } else if ( *cptr == '-' || *cptr == '.' || isdigit(*cptr)) {
-            st = e_number; txt=cptr; break;
-          } else if ( *cptr == 't' || *cptr == 'f' || *cptr == 'n' ) {
-            st = e_keyword; txt=cptr; break;
-          }
-        }
-        ++cptr;
-        break;
-      }
-
-      case e_string: {
-        for(;;++cptr) {
-          if( cptr==end ) return;
-          if (*cptr == '"' ) {
-            st = e_start;
-            const char *etxt = cptr;
-            // peek if this is a key
-            for(++cptr;;++cptr) {
-              if( cptr==end ) return;
-              if ( *cptr == ':' ) {
-                parse_key( txt, etxt );
-                break;
-              } else if ( !isspace(*cptr) ) {
-                parse_string( txt, etxt );
-                break;
-              }
-            }
-            break;
-          }
+  km_.clear();
+  ko_.clear();
+  ke_.clear();
+  const size_t num = index( cptr, sz );
+  const char *end = &cptr[sz];
+  const uint32_t *ix = ix_.data();
+  for( size_t i=0; i != num; ++i ) {
+    const char *ptr = &cptr[ix[i]];
+    switch( *ptr ) {
+      case '{': parse_start_object(); break;
+      case '[': parse_start_array(); break;
+      case '}': parse_end_object(); break;
+      case ']': parse_end_array(); break;
+      case ':':
+      case ',': break;
+      case '"': {
+        // next position is the closing quote then the next
+        // non-whitespace character
+        if ( i+2 >= num ) return;
+        const char *etxt = &cptr[ix[++i]];
+        if ( cptr[ix[i+1]] == ':' ) {
+          parse_key( ptr+1, etxt );
+        } else {
+          parse_string( ptr+1, etxt );
         }
         break;
       }
-
-      case e_number: {
-        for(;;++cptr) {
-          if( cptr==end ) return;
-          if ( !isdigit(*cptr) && *cptr!='.' &&
-               *cptr!='-' && *cptr!='e' && *cptr!='+' ) {
-            st = e_start; parse_number( txt, cptr );break;
-          }
-        }
-        break;
-      }
-
-      case e_keyword:{
-        for(;;++cptr) {
-          if ( cptr==end ) return;
-          if (!isalpha(*cptr) ) {
-            st = e_start; parse_keyword( txt, cptr ); break;
+      default: {
+        // scalar run up to whitespace, operator or quote
+        while( ptr != end && !is_jws( *ptr ) && !is_jop( *ptr ) &&
+               *ptr != '"' ) {
+          const char *txt = ptr;
+          if ( *ptr == '-' || *ptr == '.' || isdigit( *ptr ) ) {
+            for( ++ptr; ptr != end && is_jnum( *ptr ); ++ptr );
+            if ( ptr == end ) return;
+            parse_number( txt, ptr );
+          } else if ( *ptr == 't' || *ptr == 'f' || *ptr == 'n' ) {
+            for( ++ptr; ptr != end && isalpha( *ptr ); ++ptr );
+            if ( ptr == end ) return;
+            parse_keyword( txt, ptr );
+          } else {
+            ++ptr;
           }
         }
         break;
@@ -181,16 +412,97 @@ void jtree::parse_keyword( const char *txt, const char *end)
   parse_string( txt, end );
 }
 
+uint32_t jtree::hash_key( str key )
+{
+  // fnv-1a
+  uint32_t h = 2166136261U;
+  for( size_t i=0; i != key.len_; ++i ) {
+    h = ( h ^ (uint8_t)key.str_[i] ) * 16777619U;
+  }
+  return h;
+}
+
+void jtree::add_kobj( uint32_t obj ) const
+{
+  if ( km_.size() < nv_.size() ) {
+    km_.resize( nv_.size(), 0 );
+  }
+  kobj ko;
+  ko.beg_ = (uint32_t)ke_.size();
+  for( uint32_t it=get_first(obj); it; it = get_next(it) ) {
+    ke_.push_back( { hash_key( get_str( get_key( it ) ) ), it } );
+  }
+  ko.num_ = (uint32_t)ke_.size() - ko.beg_;
+  // ties stay in document order so the first duplicate key wins
+  std::sort( ke_.begin() + ko.beg_, ke_.end(),
+      []( const kent& a, const kent& b ) {
+        return a.hash_ < b.hash_ || ( a.hash_ == b.hash_ && a.kv_ < b.kv_ );
+      } );
+  ko_.push_back( ko );
+  km_[obj] = (uint32_t)ko_.size();
+}
+
+uint32_t jtree::find_kobj( const kobj& ko, str key ) const
+{
+  uint32_t h = hash_key( key );
+  const kent *it = &ke_[ko.beg_], *end = &it[ko.num_];
+  it = std::lower_bound( it, end, h,
+      []( const kent& a, uint32_t h ) { return a.hash_ < h; } );
+  for( ; it != end && it->hash_ == h; ++it ) {
+    if ( key == get_str( get_key( it->kv_ ) ) ) {
+      return get_val( it->kv_ );
+    }
+  }
+  return 0;
+}
+
 uint32_t jtree::find_val( uint32_t obj, str key ) const
 {
-  for(uint32_t it=get_first(obj); it; it = get_next(it) ) {
-    if ( e_keyval == get_type( it ) ) {
-      if ( key == get_str( get_key( it ) ) ) {
-        return get_val( it );
-      }
-    } else {
+  if ( obj < km_.size() && km_[obj] ) {
+    return find_kobj( ko_[km_[obj]-1], key );
+  }
+  uint32_t num = 0, res = 0;
+  for(uint32_t it=get_first(obj); it; it = get_next(it), ++num ) {
+    if ( e_keyval != get_type( it ) ) {
+      return 0;
+    }
+    if ( key == get_str( get_key( it ) ) ) {
+      res = get_val( it );
       break;
     }
   }
-  return 0;
+  // scanned deep into a large object - hash it for next time
+  if ( num >= min_keys ) {
+    add_kobj( obj );
+  }
+  return res;
+}
+
+void jtree::find_vals( uint32_t obj, const str *keys,
+                       uint32_t *res, unsigned num ) const
+{
+  if ( obj < km_.size() && km_[obj] ) {
+    const kobj& ko = ko_[km_[obj]-1];
+    for( unsigned i=0; i != num; ++i ) {
+      res[i] = find_kobj( ko, keys[i] );
+    }
+    return;
+  }
+  for( unsigned i=0; i != num; ++i ) {
+    res[i] = 0;
+  }
+  unsigned left = num;
+  for(uint32_t it=get_first(obj); left && it; it = get_next(it) ) {
+    if ( e_keyval != get_type( it ) ) {
+      break;
+    }
+    str kstr = get_str( get_key( it ) );
+    for( unsigned i=0; i != num; ++i ) {
+      if ( !res[i] && keys[i] == kstr ) {
+        res[i] = get_val( it );
+        --left;
+        break;
+      }
+    }
+  }
 }
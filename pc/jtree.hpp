@@ -44,8 +44,17 @@ namespace pc
     str      get_str( uint32_t ) const;
 
     // find value in object associated with key
+    // objects with many keys get a hashed key table on first lookup
     uint32_t find_val( uint32_t obj, str key ) const;
 
+    // find values of several keys with one pass over object
+    // res[i] is set to 0 if keys[i] is not found
+    void find_vals( uint32_t obj, const str *keys,
+                    uint32_t *res, unsigned num ) const;
+    template<unsigned N>
+    void find_vals( uint32_t obj, const str (&keys)[N],
+                    uint32_t (&res)[N] ) const;
+
   public:
 
     void parse_start_object();
@@ -69,6 +78,17 @@ namespace pc
       };
     };
 
+    // build structural index of message into ix_ - returns its size
+    size_t index( const char *, size_t );
+
+    // hashed key table of object
+    struct kent { uint32_t hash_; uint32_t kv_; };
+    struct kobj { uint32_t beg_; uint32_t num_; };
+    static const uint32_t min_keys = 8; // smallest object to hash
+    static uint32_t hash_key( str );
+    void add_kobj( uint32_t obj ) const;
+    uint32_t find_kobj( const kobj&, str key ) const;
+
     uint32_t new_node( type_t, uint32_t, uint32_t );
     void add( uint32_t );
     void add_obj( uint32_t );
@@ -76,8 +96,14 @@ namespace pc
 
     typedef std::vector<node>     node_vec_t;
     typedef std::vector<uint32_t> stack_t;
+    typedef std::vector<kent>     kent_vec_t;
+    typedef std::vector<kobj>     kobj_vec_t;
     node_vec_t nv_;
     stack_t    st_;
+    stack_t    ix_;   // structural positions
+    mutable stack_t    km_; // node to 1+index in ko_ (lazily sized)
+    mutable kobj_vec_t ko_; // hashed objects
+    mutable kent_vec_t ke_; // key tables sorted by hash
     uint32_t   key_;
     const char*buf_;
   };
@@ -147,4 +173,11 @@ namespace pc
     return buf_[n.p_] == 't';
   }
 
+  template<unsigned N>
+  inline void jtree::find_vals( uint32_t obj, const str (&keys)[N],
+                                uint32_t (&res)[N] ) const
+  {
+    find_vals( obj, keys, res, N );
+  }
+
 }
@@ -3,6 +3,9 @@
 #include "mem_map.hpp"
 #include "misc.hpp"
 #include <openssl/evp.h>
+#ifdef PC_HAS_SODIUM
+#include <sodium.h>
+#endif
 
 #include <assert.h>
 
@@ -56,19 +59,19 @@ bool hash::init_from_file( const std::string& file )
   if ( !mp.init() ) {
     return false;
   }
-  pc::dec_base58( (const uint8_t*)mp.data(), mp.size(), pk_ );
+  dec_base58( (const uint8_t*)mp.data(), (int)mp.size() );
   return true;
 }
 
 bool hash::init_from_text( const std::string& buf )
 {
-  pc::dec_base58( (const uint8_t*)buf.c_str(), buf.length(), pk_ );
+  dec_base58( (const uint8_t*)buf.c_str(), (int)buf.length() );
   return true;
 }
 
 bool hash::init_from_text( str buf )
 {
-  pc::dec_base58( (const uint8_t*)buf.str_, buf.len_, pk_ );
+  dec_base58( (const uint8_t*)buf.str_, (int)buf.len_ );
   return true;
 }
 
@@ -79,6 +82,9 @@ void hash::init_from_buf( const uint8_t *pk )
 
 int hash::enc_base58( char *buf, int buflen ) const
 {
+  if ( PC_LIKELY( buflen > 44 ) ) {
+    return pc::enc_base58_32( pk_, buf );
+  }
   return pc::enc_base58( pk_, len, buf, buflen );
 }
 
@@ -93,7 +99,13 @@ int hash::enc_base58( std::string& res ) const
 
 int hash::dec_base58( const uint8_t *buf, int buflen )
 {
-  return pc::dec_base58( buf, buflen, pk_ );
+  // anything but the text of a key (such as a trailing newline) is
+  // decoded as before
+  int n = pc::dec_base58_32( buf, buflen, pk_ );
+  if ( PC_UNLIKELY( n < 0 ) ) {
+    n = pc::dec_base58( buf, buflen, pk_ );
+  }
+  return n;
 }
 
 pub_key::pub_key()
@@ -165,23 +177,56 @@ void key_pair::get_pub_key( pub_key& pk ) const
 }
 
 key_cache::key_cache()
-: ptr_( nullptr )
+: ptr_( nullptr ),
+  ctx_( nullptr )
 {
+  __builtin_memset( sk_, 0, sizeof( sk_ ) );
 }
 
 key_cache::~key_cache()
 {
-  if ( ptr_ ) {
-    EVP_PKEY_free( (EVP_PKEY*)ptr_ );
-    ptr_ = nullptr;
-  }
+  reset();
+}
+
+void key_cache::reset()
+{
+  EVP_MD_CTX_free( (EVP_MD_CTX*)ctx_ );
+  EVP_PKEY_free( (EVP_PKEY*)ptr_ );
+  ctx_ = nullptr;
+  ptr_ = nullptr;
+  __builtin_memset( sk_, 0, sizeof( sk_ ) );
 }
 
 void key_cache::set( const key_pair& pk )
 {
+  init( pk.data() );
+}
+
+void key_cache::init( const uint8_t *sk )
+{
+  reset();
   EVP_PKEY *pkey = EVP_PKEY_new_raw_private_key(
-      EVP_PKEY_ED25519, NULL, pk.data(), pub_key::len );
+      EVP_PKEY_ED25519, NULL, sk, pub_key::len );
   ptr_ = (void*)pkey;
+  if ( pkey ) {
+    ctx_ = (void*)EVP_MD_CTX_new();
+    __builtin_memcpy( sk_, sk, sizeof( sk_ ) );
+  }
+#ifdef PC_HAS_SODIUM
+  // idempotent and thread-safe
+  if ( sodium_init() < 0 ) {
+    reset();
+  }
+#endif
+}
+
+void key_cache::set( const key_cache& kc )
+{
+  if ( kc.ptr_ ) {
+    init( kc.sk_ );
+  } else {
+    reset();
+  }
 }
 
 void *key_cache::get() const
@@ -189,6 +234,44 @@ void *key_cache::get() const
   return ptr_;
 }
 
+#ifdef PC_HAS_SODIUM
+
+bool key_cache::sign(
+    const uint8_t *msg, uint32_t msg_len, uint8_t *sig ) const
+{
+  if ( !ptr_ ) {
+    return false;
+  }
+  return 0 == crypto_sign_ed25519_detached( sig, NULL, msg, msg_len, sk_ );
+}
+
+const char *key_cache::get_backend()
+{
+  return "libsodium";
+}
+
+#else
+
+bool key_cache::sign(
+    const uint8_t *msg, uint32_t msg_len, uint8_t *sig ) const
+{
+  // re-initializing the digest context is cheaper than a new one
+  EVP_MD_CTX *mctx = (EVP_MD_CTX*)ctx_;
+  if ( !mctx ||
+       !EVP_DigestSignInit( mctx, NULL, NULL, NULL, (EVP_PKEY*)ptr_ ) ) {
+    return false;
+  }
+  size_t sig_len[1] = { signature::len };
+  return 0 != EVP_DigestSign( mctx, sig, sig_len, msg, msg_len );
+}
+
+const char *key_cache::get_backend()
+{
+  return "openssl";
+}
+
+#endif
+
 void signature::init_from_buf( const uint8_t *buf )
 {
   __builtin_memcpy( sig_, buf, len );
@@ -196,16 +279,22 @@ void signature::init_from_buf( const uint8_t *buf )
 
 bool signature::init_from_text( const std::string& buf )
 {
-  pc::dec_base58( (const uint8_t*)buf.c_str(), buf.length(), sig_ );
+  const uint8_t *txt = (const uint8_t*)buf.c_str();
+  if ( PC_UNLIKELY( pc::dec_base58_64( txt, (int)buf.length(), sig_ ) < 0 ) ) {
+    pc::dec_base58( txt, (int)buf.length(), sig_ );
+  }
   return true;
 }
 
-int signature::enc_base58( char *buf, int buflen )
+int signature::enc_base58( char *buf, int buflen ) const
 {
+  if ( PC_LIKELY( buflen > 88 ) ) {
+    return pc::enc_base58_64( sig_, buf );
+  }
   return pc::enc_base58( sig_, len, buf, buflen );
 }
 
-int signature::enc_base58( std::string& res )
+int signature::enc_base58( std::string& res ) const
 {
   char buf[256];
   int n = enc_base58( buf, 256 );
@@ -236,18 +325,7 @@ bool signature::sign(
 bool signature::sign(
     const uint8_t* msg, uint32_t msg_len, const key_cache& kp )
 {
-  EVP_PKEY *pkey = (EVP_PKEY*)kp.get();
-  if ( !pkey ) {
-    return false;
-  }
-  EVP_MD_CTX *mctx = EVP_MD_CTX_new();
-  int rc = EVP_DigestSignInit( mctx, NULL, NULL, NULL, pkey );
-  if ( rc ) {
-    size_t sig_len[1] = { len };
-    rc = EVP_DigestSign( mctx, sig_, sig_len, msg, msg_len );
-  }
-  EVP_MD_CTX_free( mctx );
-  return rc != 0;
+  return kp.sign( msg, msg_len, sig_ );
 }
 
 bool signature::verify(
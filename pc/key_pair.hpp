@@ -72,7 +72,8 @@ namespace pc
     uint8_t pk_[len];
   };
 
-  // opaque ssl key handle
+  // signing key prepared once for repeated signatures. holds the ssl
+  // key and digest context (or libsodium secret key if built with it)
   class key_cache
   {
   public:
@@ -80,8 +81,25 @@ namespace pc
     ~key_cache();
     void set( const key_pair& );
     void *get() const;
+
+    // prepare the key of another cache (e.g. for use on another thread)
+    void set( const key_cache& );
+
+    // sign message with cached key
+    bool sign( const uint8_t *msg, uint32_t msg_len, uint8_t *sig ) const;
+
+    // name of signing implementation
+    static const char *get_backend();
+
   private:
-    void *ptr_;
+    key_cache( const key_cache& );
+    key_cache& operator=( const key_cache& );
+    void init( const uint8_t *sk );
+    void reset();
+
+    void   *ptr_;               // EVP_PKEY
+    void   *ctx_;               // EVP_MD_CTX reused across signatures
+    uint8_t sk_[key_pair::len]; // libsodium secret key (seed + pub_key)
   };
 
   // digital signature
@@ -96,8 +114,8 @@ namespace pc
     bool init_from_text( const std::string& buf );
 
     // encode to text buffer
-    int enc_base58( char *buf, int buflen );
-    int enc_base58( std::string& );
+    int enc_base58( char *buf, int buflen ) const;
+    int enc_base58( std::string& ) const;
 
     // sign message given key_pair
     bool sign( const uint8_t* msg, uint32_t msg_len,
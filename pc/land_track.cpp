@@ -0,0 +1,195 @@
+#include "land_track.hpp"
+#include "rpc_client.hpp"
+
+// price updates tracked before the oldest are dropped
+#define PC_LAND_MAX_ENTRY 8192
+
+// slots before a transaction is first queried and before one that is
+// not found is counted as lost
+#define PC_LAND_MIN_AGE   2
+#define PC_LAND_EXPIRE    64
+
+using namespace pc;
+
+const uint32_t land_track::no_query;
+const unsigned land_track::max_group;
+
+land_track::land_track()
+: intv_( 0U ),
+  is_pend_( false ),
+  beg_( 0UL ),
+  qend_( 0UL ),
+  end_( 0UL ),
+  num_land_( 0UL ),
+  num_lost_( 0UL ),
+  num_drop_( 0UL ),
+  bnum_( 0U ),
+  bland_( 0U ),
+  bslots_( 0UL ),
+  lslot_( 0UL ),
+  lpub_( 0UL ),
+  evec_( PC_LAND_MAX_ENTRY )
+{
+  __builtin_memset( glnd_, 0, sizeof( glnd_ ) );
+  __builtin_memset( glost_, 0, sizeof( glost_ ) );
+  __builtin_memset( gslots_, 0, sizeof( gslots_ ) );
+}
+
+void land_track::set_interval( unsigned intv )
+{
+  intv_ = intv;
+}
+
+unsigned land_track::get_interval() const
+{
+  return intv_;
+}
+
+bool land_track::get_is_pending() const
+{
+  return is_pend_;
+}
+
+uint64_t land_track::get_num_land() const
+{
+  return num_land_;
+}
+
+uint64_t land_track::get_num_lost() const
+{
+  return num_lost_;
+}
+
+uint64_t land_track::get_num_drop() const
+{
+  return num_drop_;
+}
+
+uint64_t land_track::get_group_land( unsigned grp ) const
+{
+  return glnd_[grp];
+}
+
+uint64_t land_track::get_group_lost( unsigned grp ) const
+{
+  return glost_[grp];
+}
+
+uint64_t land_track::get_group_slots( unsigned grp ) const
+{
+  return gslots_[grp];
+}
+
+unsigned land_track::get_batch_num() const
+{
+  return bnum_;
+}
+
+double land_track::get_batch_rate() const
+{
+  return bnum_ ? (100.*bland_)/bnum_ : 0.;
+}
+
+double land_track::get_batch_slots() const
+{
+  return bland_ ? double( bslots_ )/bland_ : 0.;
+}
+
+uint64_t land_track::get_land_slot() const
+{
+  return lslot_;
+}
+
+uint64_t land_track::get_land_pub_slot() const
+{
+  return lpub_;
+}
+
+void land_track::add_sent(
+    const signature& sig, pub_stats *st, uint64_t pub_slot, unsigned grp )
+{
+  if ( PC_UNLIKELY( end_ - beg_ == evec_.size() ) ) {
+    if ( !evec_[beg_%evec_.size()].done_ ) {
+      ++num_drop_;
+    }
+    ++beg_;
+  }
+  entry& e = evec_[end_++%evec_.size()];
+  e.sig_  = sig;
+  e.st_   = st;
+  e.slot_ = pub_slot;
+  e.qidx_ = no_query;
+  e.grp_  = grp < max_group ? grp : 0U;
+  e.done_ = false;
+}
+
+bool land_track::build( rpc::get_signature_statuses *req, uint64_t slot )
+{
+  // updates of a batch are added together and share the signature
+  req->clear_signatures();
+  const signature *prev = nullptr;
+  uint64_t i = beg_;
+  for( ; i != end_; ++i ) {
+    entry& e = evec_[i%evec_.size()];
+    if ( e.done_ ) {
+      continue;
+    }
+    if ( e.slot_ + PC_LAND_MIN_AGE > slot ) {
+      break;
+    }
+    if ( !prev || 0 != __builtin_memcmp(
+           e.sig_.data(), prev->data(), signature::len ) ) {
+      if ( req->get_num_signatures() ==
+           rpc::get_signature_statuses::max_signatures ) {
+        break;
+      }
+      req->add_signature( e.sig_ );
+      prev = &e.sig_;
+    }
+    e.qidx_ = req->get_num_signatures() - 1;
+  }
+  qend_ = i;
+  is_pend_ = req->get_num_signatures() != 0;
+  return is_pend_;
+}
+
+void land_track::update( rpc::get_signature_statuses *req, uint64_t slot )
+{
+  is_pend_ = false;
+  bnum_ = bland_ = 0U;
+  bslots_ = 0UL;
+  const bool is_err = req->get_is_err();
+  for( uint64_t i = beg_; i < qend_; ++i ) {
+    entry& e = evec_[i%evec_.size()];
+    if ( e.done_ || e.qidx_ == no_query ) {
+      continue;
+    }
+    uint64_t lslot = is_err ? 0UL : req->get_slot( e.qidx_ );
+    bool is_fail = !is_err && req->get_is_tx_err( e.qidx_ );
+    e.qidx_ = no_query;
+    if ( lslot && !is_fail ) {
+      uint64_t dslot = lslot > e.slot_ ? lslot - e.slot_ : 0UL;
+      e.st_->add_land( e.slot_, dslot );
+      ++num_land_;
+      ++bland_;
+      bslots_ += dslot;
+      ++glnd_[e.grp_];
+      gslots_[e.grp_] += dslot;
+      if ( lslot > lslot_ ) {
+        lslot_ = lslot;
+        lpub_  = e.slot_;
+      }
+    } else if ( is_fail || ( !is_err && e.slot_ + PC_LAND_EXPIRE < slot ) ) {
+      e.st_->inc_lost();
+      ++num_lost_;
+      ++glost_[e.grp_];
+    } else {
+      continue;
+    }
+    e.done_ = true;
+    ++bnum_;
+  }
+  while( beg_ != end_ && evec_[beg_%evec_.size()].done_ ) {
+    ++beg_;
+  }
+}
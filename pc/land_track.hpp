@@ -0,0 +1,103 @@
+#pragma once
+
+#include <pc/key_pair.hpp>
+#include <pc/pub_stats.hpp>
+#include <vector>
+
+namespace pc
+{
+
+  namespace rpc
+  {
+    class get_signature_statuses;
+  }
+
+  // tracks whether price update transactions landed by querying the
+  // status of their signatures in batches. updates of a transaction are
+  // tracked separately so that landing is also known per symbol. a
+  // transaction not found after some slots is counted as lost
+  class land_track
+  {
+  public:
+
+    land_track();
+
+    // slots between status queries (default 0 or off)
+    void set_interval( unsigned );
+    unsigned get_interval() const;
+
+    // groups that landing is also counted by (e.g. batch strategy)
+    static const unsigned max_group = 8;
+
+    // update of stats published in pub_slot sent in transaction sig and
+    // counted in group grp
+    void add_sent( const signature& sig, pub_stats *, uint64_t pub_slot,
+                   unsigned grp = 0 );
+
+    // query sent and not yet answered
+    bool get_is_pending() const;
+
+    // add the oldest unresolved signatures to query at slot. false if
+    // there is nothing to ask for
+    bool build( rpc::get_signature_statuses *, uint64_t slot );
+
+    // apply the reply to the last query
+    void update( rpc::get_signature_statuses *, uint64_t slot );
+
+    // cumulative price updates that landed, were lost or dropped as too
+    // many were unresolved
+    uint64_t get_num_land() const;
+    uint64_t get_num_lost() const;
+    uint64_t get_num_drop() const;
+
+    // cumulative price updates of group that landed or were lost and
+    // the total of their slots from publish to landing
+    uint64_t get_group_land( unsigned grp ) const;
+    uint64_t get_group_lost( unsigned grp ) const;
+    uint64_t get_group_slots( unsigned grp ) const;
+
+    // price updates resolved by the last reply, percent of those that
+    // landed and their mean latency in slots
+    unsigned get_batch_num() const;
+    double   get_batch_rate() const;
+    double   get_batch_slots() const;
+
+    // latest landing slot and publish slot of its update
+    uint64_t get_land_slot() const;
+    uint64_t get_land_pub_slot() const;
+
+  private:
+
+    static const uint32_t no_query = (uint32_t)-1;
+
+    struct entry {
+      signature  sig_;
+      pub_stats *st_;
+      uint64_t   slot_;   // publish slot
+      uint32_t   qidx_;   // index in pending query
+      uint32_t   grp_;
+      bool       done_;
+    };
+
+    typedef std::vector<entry> entry_vec_t;
+
+    unsigned    intv_;
+    bool        is_pend_;
+    uint64_t    beg_;     // oldest unresolved
+    uint64_t    qend_;    // end of pending query
+    uint64_t    end_;
+    uint64_t    num_land_;
+    uint64_t    num_lost_;
+    uint64_t    num_drop_;
+    unsigned    bnum_;
+    unsigned    bland_;
+    uint64_t    bslots_;
+    uint64_t    lslot_;
+    uint64_t    lpub_;
+    uint64_t    glnd_[max_group];
+    uint64_t    glost_[max_group];
+    uint64_t    gslots_[max_group];
+    entry_vec_t evec_;    // entries by sequence modulo size
+  };
+
+}
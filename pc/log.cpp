@@ -1,15 +1,71 @@
 #include "log.hpp"
 #include "misc.hpp"
 #include <unistd.h>
+#include <sys/eventfd.h>
 #include <atomic>
 #include <thread>
 #include <mutex>
 #include <fstream>
 #include <iostream>
 
+#define PC_LOG_RING_SIZE (1UL<<20)
+#define PC_LOG_REC_SIZE  1024UL
+#define PC_LOG_MAX_RING  64U
+#define PC_LOG_WRAP      0xffffffffU
+#define PC_NSECS_PER_MS  1000000L
+#define PC_NSECS_PER_SEC 1000000000L
+
 namespace pc
 {
 
+  // binary record types
+  enum : uint8_t {
+    e_log_str = 0,
+    e_log_i64 = 1,
+    e_log_u64 = 2,
+    e_log_f64 = 3,
+    e_log_pub = 4,
+    e_log_sig = 5
+  };
+
+  // binary record header followed by topic and arguments. each argument
+  // is a type, key length, key and value. string values are prefixed by
+  // a uint16_t length
+  struct PC_PACKED log_rec
+  {
+    uint32_t len_;    // record length or PC_LOG_WRAP
+    int64_t  ts_;
+    uint8_t  lvl_;
+    uint8_t  tlen_;   // topic length
+  };
+
+  // single producer, single consumer ring of binary records. records
+  // are contiguous and aligned to 8 bytes. the producer is the thread
+  // holding the ring which passes it on to a new thread when it exits
+  class log_ring
+  {
+  public:
+    log_ring();
+    char *reserve();
+    void commit( size_t len );
+    typedef std::atomic<uint64_t> seq_t;
+    seq_t    head_;   // written by producer
+    seq_t    tail_;   // written by log thread
+    seq_t    drop_;   // lines dropped on full ring
+    uint64_t rdrop_;  // drops reported by log thread
+    uint64_t pad_;    // bytes skipped by reserve to wrap around
+    bool     is_free_; // not held by a thread, guarded by log_impl::mtx_
+    char     buf_[PC_LOG_RING_SIZE];
+  };
+
+  // ring held by the calling thread until it exits
+  struct log_ring_ref
+  {
+    ~log_ring_ref();
+    log_ring *ring_ = nullptr;
+    bool      is_full_ = false;
+  };
+
   class log_impl
   {
   public:
@@ -18,35 +74,128 @@ namespace pc
     void start();
     void stop();
     void run();
+    bool set_cpu( int );
     void add( net_wtr& wtr );
     bool set_log_file( const std::string& );
+    log_ring *get_ring();
+    void put_ring( log_ring * );
+    unsigned get_num_ring();
+    void wake();
 
   private:
     typedef std::vector<net_buf*> buf_vec_t;
     typedef std::atomic<bool> atomic_t;
+    bool has_work();
+    bool drain();
+    bool drain( log_ring * );
+    void format( const char *, size_t );
+    void write( net_wtr& );
     atomic_t      is_run_;
     atomic_t      is_wtr_;
+    atomic_t      is_wait_;
+    int           efd_;
     std::mutex    mtx_;
     std::thread   thrd_;
+    int           cpu_;
     buf_vec_t     logv_;
     buf_vec_t     reuse_;
     std::ostream *strm_;
     std::ofstream logf_;
+    log_wtr       wtr_;
+    // rings are never freed since threads still running at exit may
+    // be logging into them
+    std::atomic<unsigned> nring_;
+    log_ring     *rings_[PC_LOG_MAX_RING];
   };
 
 }
 
 using namespace pc;
 
+static const char spaces[] =
+"                                                                         ";
+
+static int log_pid = getpid();
+
+static void add_header( log_wtr& wtr, int64_t ts, str topic, int lvl )
+{
+  char tbuf[32];
+  nsecs_to_utc6( ts, tbuf );
+  wtr.add( '[' );
+  wtr.add( str( tbuf, 27 ) );
+  wtr.add( ' ' );
+  wtr.add_i64( log_pid );
+  wtr.add( ' ' );
+  switch(lvl) {
+    case PC_LOG_DBG_LVL: wtr.add( "DBG" );break;
+    case PC_LOG_INF_LVL: wtr.add( "INF" );break;
+    case PC_LOG_WRN_LVL: wtr.add( "WRN" );break;
+    case PC_LOG_ERR_LVL: wtr.add( "ERR" );break;
+  }
+  wtr.add( ' ' );
+  const size_t topic_len = 40;
+  size_t len = std::min( topic.len_, topic_len );
+  wtr.add( str( topic.str_, len ) );
+  if ( len < topic_len ) {
+    wtr.add( str( spaces, topic_len-len ) );
+  }
+  wtr.add( ']' );
+  wtr.add( ' ' );
+}
+
 static void run_log( log_impl *iptr )
 {
   iptr->run();
 }
 
+log_ring::log_ring()
+: head_( 0UL ),
+  tail_( 0UL ),
+  drop_( 0UL ),
+  rdrop_( 0UL ),
+  pad_( 0UL ),
+  is_free_( false )
+{
+}
+
+char *log_ring::reserve()
+{
+  uint64_t hd = head_.load( std::memory_order_relaxed );
+  uint64_t tl = tail_.load( std::memory_order_acquire );
+  size_t pos = hd % PC_LOG_RING_SIZE;
+  size_t pad = PC_LOG_RING_SIZE - pos;
+  if ( pad >= PC_LOG_REC_SIZE ) {
+    pad = 0;
+  }
+  if ( PC_LOG_RING_SIZE - ( hd - tl ) < pad + PC_LOG_REC_SIZE ) {
+    drop_.store( drop_.load( std::memory_order_relaxed ) + 1,
+                 std::memory_order_relaxed );
+    return nullptr;
+  }
+  pad_ = pad;
+  if ( pad ) {
+    uint32_t wrap = PC_LOG_WRAP;
+    __builtin_memcpy( &buf_[pos], &wrap, sizeof( wrap ) );
+    pos = 0;
+  }
+  return &buf_[pos];
+}
+
+void log_ring::commit( size_t len )
+{
+  uint64_t hd = head_.load( std::memory_order_relaxed );
+  head_.store( hd + pad_ + ( ( len + 7UL ) & ~7UL ),
+               std::memory_order_release );
+}
+
 log_impl::log_impl()
 : is_run_( true ),
   is_wtr_( false ),
-  strm_( &std::cerr )
+  is_wait_( false ),
+  efd_( ::eventfd( 0, EFD_CLOEXEC ) ),
+  cpu_( -1 ),
+  strm_( &std::cerr ),
+  nring_( 0U )
 {
 }
 
@@ -70,23 +219,91 @@ void log_impl::start()
 {
   if ( !thrd_.joinable() ) {
     thrd_ = std::thread( run_log, this );
+    if ( cpu_ >= 0 ) {
+      set_thread_cpu( thrd_.native_handle(), cpu_ );
+    }
   }
 }
 
+bool log_impl::set_cpu( int cpu )
+{
+  cpu_ = cpu;
+  start();
+  return set_thread_cpu( thrd_.native_handle(), cpu );
+}
+
 void log_impl::stop()
 {
   is_run_ = false;
   if ( thrd_.joinable() ) {
+    uint64_t one = 1UL;
+    ssize_t rc = ::write( efd_, &one, sizeof( one ) );
+    (void)rc;
     thrd_.join();
   }
   for( net_buf *ptr: reuse_ ) {
     while( ptr ) {
       net_buf *nxt = ptr->next_;
-      delete ptr;
+      ptr->dealloc();
       ptr = nxt;
     }
   }
   reuse_.clear();
+  log::set_binary( false );
+  if ( efd_ >= 0 ) {
+    ::close( efd_ );
+    efd_ = -1;
+  }
+}
+
+log_ring *log_impl::get_ring()
+{
+  static thread_local log_ring_ref ref;
+  if ( PC_UNLIKELY( !ref.ring_ && !ref.is_full_ ) ) {
+    // take the ring of an exited thread or register a new one. threads
+    // beyond the maximum format their lines themselves
+    std::lock_guard<std::mutex> lck( mtx_ );
+    unsigned nring = nring_.load( std::memory_order_relaxed );
+    for( unsigned i = 0; i != nring && !ref.ring_; ++i ) {
+      if ( rings_[i]->is_free_ ) {
+        ref.ring_ = rings_[i];
+        ref.ring_->is_free_ = false;
+      }
+    }
+    if ( ref.ring_ ) {
+      return ref.ring_;
+    }
+    if ( nring != PC_LOG_MAX_RING ) {
+      ref.ring_ = rings_[nring] = new log_ring;
+      nring_.store( nring + 1, std::memory_order_release );
+    } else {
+      ref.is_full_ = true;
+    }
+  }
+  return ref.ring_;
+}
+
+void log_impl::put_ring( log_ring *ring )
+{
+  // lines already in the ring are still drained by the log thread
+  std::lock_guard<std::mutex> lck( mtx_ );
+  ring->is_free_ = true;
+}
+
+unsigned log_impl::get_num_ring()
+{
+  return nring_.load( std::memory_order_relaxed );
+}
+
+void log_impl::wake()
+{
+  // pairs with fence in run before log thread checks for work
+  std::atomic_thread_fence( std::memory_order_seq_cst );
+  if ( is_wait_.load( std::memory_order_relaxed ) ) {
+    uint64_t one = 1UL;
+    ssize_t rc = ::write( efd_, &one, sizeof( one ) );
+    (void)rc;
+  }
 }
 
 void log_impl::add( net_wtr& wtr )
@@ -99,6 +316,7 @@ void log_impl::add( net_wtr& wtr )
   reuse.swap( reuse_ );
   is_wtr_ = true;
   mtx_.unlock();
+  wake();
   for( net_buf *ptr: reuse ) {
     while( ptr ) {
       net_buf *nxt = ptr->next_;
@@ -108,47 +326,204 @@ void log_impl::add( net_wtr& wtr )
   }
 }
 
+bool log_impl::has_work()
+{
+  if ( is_wtr_ || !is_run_ ) {
+    return true;
+  }
+  unsigned nring = nring_.load( std::memory_order_acquire );
+  for( unsigned i = 0; i != nring; ++i ) {
+    log_ring *ring = rings_[i];
+    if ( ring->head_.load( std::memory_order_acquire ) !=
+         ring->tail_.load( std::memory_order_relaxed ) ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void log_impl::write( net_wtr& wtr )
+{
+  net_buf *hd, *tl;
+  wtr.detach( hd, tl );
+  for( net_buf *ptr = hd; ptr; ) {
+    net_buf *nxt = ptr->next_;
+    strm_->write( ptr->buf_, ptr->size_ );
+    ptr->dealloc();
+    ptr = nxt;
+  }
+  (*strm_) << std::endl;
+  wtr.reset();
+}
+
+void log_impl::format( const char *buf, size_t len )
+{
+  const log_rec *rec = (const log_rec*)buf;
+  int64_t ts;
+  __builtin_memcpy( &ts, &buf[offsetof(log_rec,ts_)], sizeof( ts ) );
+  size_t pos = sizeof( log_rec ) + rec->tlen_;
+  add_header( wtr_, ts, str( &buf[sizeof(log_rec)], rec->tlen_ ),
+              rec->lvl_ );
+  for( bool is_first = true; pos < len; is_first = false ) {
+    uint8_t type = (uint8_t)buf[pos++];
+    size_t klen = (uint8_t)buf[pos++];
+    if ( !is_first ) {
+      wtr_.add( ',' );
+    }
+    wtr_.add( str( &buf[pos], klen ) );
+    wtr_.add( '=' );
+    pos += klen;
+    switch( type ) {
+      case e_log_str: {
+        uint16_t vlen;
+        __builtin_memcpy( &vlen, &buf[pos], sizeof( vlen ) );
+        wtr_.add( str( &buf[pos+sizeof(vlen)], vlen ) );
+        pos += sizeof( vlen ) + vlen;
+        break;
+      }
+      case e_log_i64: {
+        int64_t val;
+        __builtin_memcpy( &val, &buf[pos], sizeof( val ) );
+        wtr_.add_i64( val );
+        pos += sizeof( val );
+        break;
+      }
+      case e_log_u64: {
+        uint64_t val;
+        __builtin_memcpy( &val, &buf[pos], sizeof( val ) );
+        wtr_.add_u64( val );
+        pos += sizeof( val );
+        break;
+      }
+      case e_log_f64: {
+        double val;
+        __builtin_memcpy( &val, &buf[pos], sizeof( val ) );
+        wtr_.add_f64( val );
+        pos += sizeof( val );
+        break;
+      }
+      case e_log_pub: {
+        std::string res;
+        ((const pub_key*)&buf[pos])->enc_base58( res );
+        wtr_.add( res );
+        pos += sizeof( pub_key );
+        break;
+      }
+      case e_log_sig: {
+        char sbuf[128];
+        int n = ((const signature*)&buf[pos])->enc_base58(
+            sbuf, sizeof( sbuf ) );
+        wtr_.add( str( sbuf, static_cast< size_t >( n ) ) );
+        pos += sizeof( signature );
+        break;
+      }
+    }
+  }
+  write( wtr_ );
+}
+
+bool log_impl::drain( log_ring *ring )
+{
+  uint64_t tl = ring->tail_.load( std::memory_order_relaxed );
+  uint64_t hd = ring->head_.load( std::memory_order_acquire );
+  uint64_t drop = ring->drop_.load( std::memory_order_relaxed );
+  if ( drop != ring->rdrop_ ) {
+    add_header( wtr_, get_now(), "dropped log lines", PC_LOG_WRN_LVL );
+    wtr_.add( "num=" );
+    wtr_.add_u64( drop - ring->rdrop_ );
+    write( wtr_ );
+    ring->rdrop_ = drop;
+  }
+  if ( tl == hd ) {
+    return false;
+  }
+  while( tl != hd ) {
+    size_t pos = tl % PC_LOG_RING_SIZE;
+    uint32_t len;
+    __builtin_memcpy( &len, &ring->buf_[pos], sizeof( len ) );
+    if ( len == PC_LOG_WRAP ) {
+      tl += PC_LOG_RING_SIZE - pos;
+      continue;
+    }
+    format( &ring->buf_[pos], len );
+    tl += ( len + 7UL ) & ~7UL;
+    ring->tail_.store( tl, std::memory_order_release );
+  }
+  ring->tail_.store( tl, std::memory_order_release );
+  return true;
+}
+
+bool log_impl::drain()
+{
+  bool is_work = false;
+  if ( is_wtr_ ) {
+    // get buffers to log
+    buf_vec_t logv;
+    mtx_.lock();
+    is_wtr_ = false;
+    logv_.swap( logv );
+    mtx_.unlock();
+
+    // write the buffers to stderr
+    for( net_buf *ptr: logv ) {
+      while( ptr ) {
+        net_buf *nxt = ptr->next_;
+        strm_->write( ptr->buf_, ptr->size_ );
+        ptr = nxt;
+      }
+      (*strm_) << std::endl;
+    }
+
+    // send buffers back
+    mtx_.lock();
+    std::copy( logv.begin(), logv.end(), std::back_inserter( reuse_ ) );
+    mtx_.unlock();
+    is_work = true;
+  }
+  unsigned nring = nring_.load( std::memory_order_acquire );
+  for( unsigned i = 0; i != nring; ++i ) {
+    is_work = drain( rings_[i] ) || is_work;
+  }
+  return is_work;
+}
+
 void log_impl::run()
 {
   struct timespec ts[1];
   ts->tv_sec  = 0;
   ts->tv_nsec = 1000000;
-  buf_vec_t logv;
   for(;;) {
-    if ( is_wtr_ ) {
-      // get buffers to log
-      mtx_.lock();
-      is_wtr_ = false;
-      logv_.swap( logv );
-      mtx_.unlock();
-
-      // write the buffers to stderr
-      for( net_buf *ptr: logv ) {
-        while( ptr ) {
-          net_buf *nxt = ptr->next_;
-          strm_->write( ptr->buf_, ptr->size_ );
-          ptr = nxt;
-        }
-        (*strm_) << std::endl;
-      }
-
-      // send buffers back
-      mtx_.lock();
-      std::copy( logv.begin(), logv.end(), std::back_inserter( reuse_ ) );
-      mtx_.unlock();
-      logv.clear();
+    if ( drain() ) {
+      continue;
     } else if ( !is_run_ ) {
       break;
-    } else {
-      // sleep a bit
-      clock_nanosleep( CLOCK_REALTIME, 0, ts, NULL );
     }
+
+    // wait for writers to wake us up
+    is_wait_.store( true, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    if ( !has_work() ) {
+      uint64_t val;
+      if ( efd_ < 0 || ::read( efd_, &val, sizeof( val ) ) < 0 ) {
+        clock_nanosleep( CLOCK_REALTIME, 0, ts, NULL );
+      }
+    }
+    is_wait_.store( false, std::memory_order_relaxed );
   }
 }
 
 int log::level_ = 0;
+static std::atomic<bool> is_bin_( false );
 static log_impl impl_;
 
+log_ring_ref::~log_ring_ref()
+{
+  if ( ring_ ) {
+    impl_.put_ring( ring_ );
+    ring_ = nullptr;
+  }
+}
+
 void log::set_level( int t )
 {
   level_ = 1;
@@ -159,6 +534,26 @@ void log::set_level( int t )
   impl_.start();
 }
 
+void log::set_binary( bool is_bin )
+{
+  is_bin_ = is_bin;
+}
+
+bool log::get_is_binary()
+{
+  return is_bin_;
+}
+
+unsigned log::get_num_ring()
+{
+  return impl_.get_num_ring();
+}
+
+bool log::set_cpu( int cpu )
+{
+  return impl_.set_cpu( cpu );
+}
+
 bool log::set_log_file( const std::string& log_file )
 {
   return impl_.set_log_file( log_file );
@@ -169,23 +564,22 @@ log_line log::add( str topic, int level )
   return log_line( topic, level );
 }
 
-static const char spaces[] =
-"                                                                         ";
-
-static int log_pid = getpid();
-
 void log_wtr::add_i64( int64_t val )
 {
-  char *buf = reserve( 32 );
-  sprintf( buf, "%ld", val );
-  advance( __builtin_strlen( buf ) );
+  if ( val < 0 ) {
+    add( '-' );
+    add_u64( 0UL - static_cast< uint64_t >( val ) );
+  } else {
+    add_u64( static_cast< uint64_t >( val ) );
+  }
 }
 
 void log_wtr::add_u64( uint64_t val )
 {
-  char *buf = reserve( 32 );
-  sprintf( buf, "%lu", val );
-  advance( __builtin_strlen( buf ) );
+  size_t len = uint_len( val );
+  char *buf = reserve( len );
+  uint_to_str( val, &buf[len] );
+  advance( len );
 }
 
 void log_wtr::add_f64( double val )
@@ -196,30 +590,40 @@ void log_wtr::add_f64( double val )
 }
 
 log_line::log_line( str topic, int lvl )
-: is_first_( true )
+: is_first_( true ),
+  ring_( nullptr ),
+  rec_( nullptr ),
+  len_( 0UL )
 {
-  char tbuf[32];
-  nsecs_to_utc6( get_now(), tbuf );
-  wtr_.add( '[' );
-  wtr_.add( str( tbuf, 27 ) );
-  wtr_.add( ' ' );
-  wtr_.add_i64( log_pid );
-  wtr_.add( ' ' );
-  switch(lvl) {
-    case PC_LOG_DBG_LVL: wtr_.add( "DBG" );break;
-    case PC_LOG_INF_LVL: wtr_.add( "INF" );break;
-    case PC_LOG_WRN_LVL: wtr_.add( "WRN" );break;
-    case PC_LOG_ERR_LVL: wtr_.add( "ERR" );break;
+  int64_t ts = get_now();
+  if ( is_bin_.load( std::memory_order_relaxed ) ) {
+    ring_ = impl_.get_ring();
   }
-  wtr_.add( ' ' );
-  const size_t topic_len = 40;
-  size_t len = std::min( topic.len_, topic_len );
-  wtr_.add( str( topic.str_, len ) );
-  if ( len < topic_len ) {
-    wtr_.add( str( spaces, topic_len-len ) );
+  if ( !ring_ ) {
+    add_header( wtr_, ts, topic, lvl );
+  } else if ( ( rec_ = ring_->reserve() ) ) {
+    log_rec *rec = (log_rec*)rec_;
+    size_t tlen = std::min( topic.len_, 255UL );
+    __builtin_memcpy( &rec_[offsetof(log_rec,ts_)], &ts, sizeof( ts ) );
+    rec->lvl_  = static_cast< uint8_t >( lvl );
+    rec->tlen_ = static_cast< uint8_t >( tlen );
+    __builtin_memcpy( &rec_[sizeof(log_rec)], topic.str_, tlen );
+    len_ = sizeof( log_rec ) + tlen;
+  }
+}
+
+char *log_line::add_arg( uint8_t type, str key, size_t len )
+{
+  size_t klen = std::min( key.len_, 255UL );
+  if ( !rec_ || len_ + 2 + klen + len > PC_LOG_REC_SIZE ) {
+    return nullptr;
   }
-  wtr_.add( ']' );
-  wtr_.add( ' ' );
+  char *ptr = &rec_[len_];
+  ptr[0] = static_cast< char >( type );
+  ptr[1] = static_cast< char >( klen );
+  __builtin_memcpy( &ptr[2], key.str_, klen );
+  len_ += 2 + klen + len;
+  return &ptr[2+klen];
 }
 
 void log_line::add_key( str key )
@@ -235,6 +639,17 @@ void log_line::add_key( str key )
 
 log_line& log_line::add( str key, str val )
 {
+  if ( ring_ ) {
+    size_t klen = std::min( key.len_, 255UL ), used = len_ + 4 + klen;
+    if ( rec_ && used < PC_LOG_REC_SIZE ) {
+      uint16_t vlen = static_cast< uint16_t >(
+          std::min( val.len_, PC_LOG_REC_SIZE - used ) );
+      char *ptr = add_arg( e_log_str, key, sizeof( vlen ) + vlen );
+      __builtin_memcpy( ptr, &vlen, sizeof( vlen ) );
+      __builtin_memcpy( &ptr[sizeof(vlen)], val.str_, vlen );
+    }
+    return *this;
+  }
   add_key( key );
   wtr_.add( val );
   return *this;
@@ -242,6 +657,14 @@ log_line& log_line::add( str key, str val )
 
 log_line& log_line::add( str key, int32_t val )
 {
+  if ( ring_ ) {
+    char *ptr = add_arg( e_log_i64, key, sizeof( int64_t ) );
+    if ( ptr ) {
+      int64_t v = val;
+      __builtin_memcpy( ptr, &v, sizeof( v ) );
+    }
+    return *this;
+  }
   add_key( key );
   wtr_.add_i64( val );
   return *this;
@@ -249,6 +672,14 @@ log_line& log_line::add( str key, int32_t val )
 
 log_line& log_line::add( str key, int64_t val )
 {
+  if ( ring_ ) {
+    char *ptr = add_arg( e_log_i64, key, sizeof( int64_t ) );
+    if ( ptr ) {
+      int64_t v = val;
+      __builtin_memcpy( ptr, &v, sizeof( v ) );
+    }
+    return *this;
+  }
   add_key( key );
   wtr_.add_i64( val );
   return *this;
@@ -256,6 +687,14 @@ log_line& log_line::add( str key, int64_t val )
 
 log_line& log_line::add( str key, uint64_t val )
 {
+  if ( ring_ ) {
+    char *ptr = add_arg( e_log_u64, key, sizeof( uint64_t ) );
+    if ( ptr ) {
+      uint64_t v = val;
+      __builtin_memcpy( ptr, &v, sizeof( v ) );
+    }
+    return *this;
+  }
   add_key( key );
   wtr_.add_u64( val );
   return *this;
@@ -263,6 +702,14 @@ log_line& log_line::add( str key, uint64_t val )
 
 log_line& log_line::add( str key, uint32_t val )
 {
+  if ( ring_ ) {
+    char *ptr = add_arg( e_log_u64, key, sizeof( uint64_t ) );
+    if ( ptr ) {
+      uint64_t v = val;
+      __builtin_memcpy( ptr, &v, sizeof( v ) );
+    }
+    return *this;
+  }
   add_key( key );
   wtr_.add_u64( val );
   return *this;
@@ -270,6 +717,14 @@ log_line& log_line::add( str key, uint32_t val )
 
 log_line& log_line::add( str key, double val )
 {
+  if ( ring_ ) {
+    char *ptr = add_arg( e_log_f64, key, sizeof( double ) );
+    if ( ptr ) {
+      double v = val;
+      __builtin_memcpy( ptr, &v, sizeof( v ) );
+    }
+    return *this;
+  }
   add_key( key );
   wtr_.add_f64( val );
   return *this;
@@ -277,6 +732,13 @@ log_line& log_line::add( str key, double val )
 
 log_line& log_line::add( str key, const pub_key& pk )
 {
+  if ( ring_ ) {
+    char *ptr = add_arg( e_log_pub, key, sizeof( pub_key ) );
+    if ( ptr ) {
+      __builtin_memcpy( ptr, &pk, sizeof( pub_key ) );
+    }
+    return *this;
+  }
   add_key( key );
   std::string res;
   pk.enc_base58( res );
@@ -284,8 +746,142 @@ log_line& log_line::add( str key, const pub_key& pk )
   return *this;
 }
 
+log_line& log_line::add( str key, const signature& sig )
+{
+  if ( ring_ ) {
+    char *ptr = add_arg( e_log_sig, key, sizeof( signature ) );
+    if ( ptr ) {
+      __builtin_memcpy( ptr, &sig, sizeof( signature ) );
+    }
+    return *this;
+  }
+  add_key( key );
+  char buf[128];
+  int n = sig.enc_base58( buf, sizeof( buf ) );
+  wtr_.add( str( buf, static_cast< size_t >( n ) ) );
+  return *this;
+}
+
 void log_line::end()
 {
+  if ( ring_ ) {
+    if ( rec_ ) {
+      uint32_t len = static_cast< uint32_t >( len_ );
+      __builtin_memcpy( rec_, &len, sizeof( len ) );
+      ring_->commit( len_ );
+      rec_ = nullptr;
+      impl_.wake();
+    }
+    return;
+  }
   impl_.add( wtr_ );
   wtr_.reset();
 }
+
+log_limit::log_limit( str topic, int lvl )
+: topic_( topic.as_string() ),
+  lvl_( lvl ),
+  rate_( 10U ),
+  burst_( 10U ),
+  kint_( 10000L * PC_NSECS_PER_MS ),
+  sint_( 10000L * PC_NSECS_PER_MS ),
+  tat_( 0L ),
+  sts_( 0L ),
+  nsup_( 0UL ),
+  ntot_( 0UL ),
+  nsum_( 0UL )
+{
+}
+
+void log_limit::set_rate( unsigned rate )
+{
+  rate_ = rate;
+}
+
+unsigned log_limit::get_rate() const
+{
+  return rate_;
+}
+
+void log_limit::set_burst( unsigned burst )
+{
+  burst_ = burst;
+}
+
+unsigned log_limit::get_burst() const
+{
+  return burst_;
+}
+
+void log_limit::set_key_interval( int64_t ms )
+{
+  kint_ = ms * PC_NSECS_PER_MS;
+}
+
+int64_t log_limit::get_key_interval() const
+{
+  return kint_ / PC_NSECS_PER_MS;
+}
+
+void log_limit::set_summary_interval( int64_t ms )
+{
+  sint_ = ms * PC_NSECS_PER_MS;
+}
+
+int64_t log_limit::get_summary_interval() const
+{
+  return sint_ / PC_NSECS_PER_MS;
+}
+
+uint64_t log_limit::get_num_suppressed() const
+{
+  return nsup_;
+}
+
+uint64_t log_limit::get_num_total() const
+{
+  return ntot_;
+}
+
+bool log_limit::check( uint64_t key )
+{
+  if ( !log::has_level( lvl_ ) ) {
+    return false;
+  }
+  int64_t now = get_now();
+  key_map_t::iter_t it = kmap_.find( key );
+  if ( !it ) {
+    it = kmap_.add( key );
+    kmap_.ref( it ).ts_ = now - kint_;
+  }
+  trait_key::val_t& kval = kmap_.ref( it );
+
+  // topic bucket as a generic cell rate: a line is allowed if it does
+  // not arrive more than burst intervals ahead of the bucket
+  int64_t tint = rate_ ? PC_NSECS_PER_SEC / rate_ : PC_NSECS_PER_SEC;
+  int64_t tat = std::max( tat_, now );
+  bool is_ok = now - kval.ts_ >= kint_ &&
+               tat - now <= tint * ( (int64_t)std::max( burst_, 1U ) - 1L );
+  if ( !is_ok ) {
+    ++kval.num_;
+    ++ntot_;
+    ++nsum_;
+  }
+  if ( nsum_ && now - sts_ >= sint_ ) {
+    PC_LOG_TXT( "suppressed log lines", lvl_ )
+      .add( "topic", topic_ )
+      .add( "num", nsum_ )
+      .add( "total", ntot_ )
+      .end();
+    nsum_ = 0UL;
+    sts_  = now;
+  }
+  if ( !is_ok ) {
+    return false;
+  }
+  tat_      = tat + tint;
+  nsup_     = kval.num_;
+  kval.ts_  = now;
+  kval.num_ = 0UL;
+  return true;
+}
@@ -1,19 +1,33 @@
 #pragma once
 
 #include <pc/net_socket.hpp>
+#include <pc/hash_map.hpp>
 
 #define PC_LOG_DBG_LVL (1U<<3)
 #define PC_LOG_INF_LVL (1U<<2)
 #define PC_LOG_WRN_LVL (1U<<1)
 #define PC_LOG_ERR_LVL (1U<<0)
 
+// least severe level compiled in (cmake -DPC_LOG_LEVEL). statements
+// below it are removed along with their arguments and the levels kept
+// are still selected at runtime with log::set_level
+#ifndef PC_LOG_MIN_LVL
+#define PC_LOG_MIN_LVL PC_LOG_DBG_LVL
+#endif
+
 #define PC_LOG_TXT(X,LVL) \
-if (pc::log::has_level(LVL)) pc::log::add(X,LVL)
+if (static_cast<unsigned>(LVL) <= PC_LOG_MIN_LVL && pc::log::has_level(LVL)) \
+  pc::log::add(X,LVL)
 #define PC_LOG_DBG(X) PC_LOG_TXT(X,PC_LOG_DBG_LVL)
 #define PC_LOG_INF(X) PC_LOG_TXT(X,PC_LOG_INF_LVL)
 #define PC_LOG_WRN(X) PC_LOG_TXT(X,PC_LOG_WRN_LVL)
 #define PC_LOG_ERR(X) PC_LOG_TXT(X,PC_LOG_ERR_LVL)
 
+#define PC_LOG_LIM(LIM,KEY) \
+if ((LIM).check(KEY)) \
+  pc::log::add((LIM).get_topic(),(LIM).get_level()) \
+    .add("suppressed",(LIM).get_num_suppressed())
+
 namespace pc
 {
 
@@ -25,12 +39,16 @@ namespace pc
     void add_f64( double );
   };
 
-  // log line
+  class log_ring;
+
+  // log line. in binary mode the arguments are copied unformatted into
+  // a ring of the calling thread and formatted by the log thread
   class log_line
   {
   public:
     log_line& add( str key, str val );
     log_line& add( str key, const pub_key& val );
+    log_line& add( str key, const signature& val );
     log_line& add( str key, int32_t );
     log_line& add( str key, int64_t );
     log_line& add( str key, uint64_t );
@@ -41,8 +59,12 @@ namespace pc
   private:
     log_line( str, int lvl );
     void add_key( str );
-    bool    is_first_;
-    log_wtr wtr_;
+    char *add_arg( uint8_t type, str key, size_t len );
+    bool      is_first_;
+    log_ring *ring_;   // binary mode ring or null
+    char     *rec_;    // binary record or null if dropped
+    size_t    len_;    // binary record length
+    log_wtr   wtr_;
   };
 
   // log reporting
@@ -52,15 +74,111 @@ namespace pc
 
     static bool set_log_file( const std::string& );
     static void set_level( int level );
+
+    // format log lines on the log thread (default false)
+    static void set_binary( bool );
+    static bool get_is_binary();
+
+    // binary mode rings allocated. the ring of a thread is reused by
+    // another once it exits
+    static unsigned get_num_ring();
+
+    // pin the log thread to cpu. false with errno set on failure
+    static bool set_cpu( int cpu );
+
     static bool has_level( int level );
     static log_line add( str topic, int level );
   private:
     static int level_;
   };
 
+  // rate limit of log lines of one topic. each key can log one line
+  // per key interval and all keys together burst lines at once then
+  // rate lines per second. lines over the limit are counted: a key's
+  // count is reported as suppressed= on its next line and the topic's
+  // count in a summary line at most once per summary interval. use
+  // through PC_LOG_LIM and keep one per thread
+  class log_limit
+  {
+  public:
+
+    log_limit( str topic, int level );
+
+    str get_topic() const;
+    int get_level() const;
+
+    // lines per second over all keys (default 10)
+    void set_rate( unsigned );
+    unsigned get_rate() const;
+
+    // lines at once over all keys (default 10)
+    void set_burst( unsigned );
+    unsigned get_burst() const;
+
+    // milliseconds between lines of one key (default 10000)
+    void set_key_interval( int64_t );
+    int64_t get_key_interval() const;
+
+    // milliseconds between summary lines (default 10000)
+    void set_summary_interval( int64_t );
+    int64_t get_summary_interval() const;
+
+    // check if line of key can be logged
+    bool check( uint64_t key );
+
+    // lines of key suppressed before the line just checked
+    uint64_t get_num_suppressed() const;
+
+    // lines suppressed over all keys
+    uint64_t get_num_total() const;
+
+  private:
+
+    struct trait_key {
+      typedef uint32_t idx_t;
+      typedef uint64_t key_t;
+      typedef uint64_t keyref_t;
+      struct val_t {
+        int64_t  ts_;   // time of last line
+        uint64_t num_;  // suppressed since last line
+      };
+      struct hash_t {
+        idx_t operator() ( keyref_t k ) {
+          return static_cast< idx_t >( k ^ ( k >> 32 ) );
+        }
+      };
+    };
+
+    typedef open_hash_map<trait_key> key_map_t;
+
+    std::string topic_;
+    int         lvl_;
+    unsigned    rate_;
+    unsigned    burst_;
+    int64_t     kint_;   // key interval in nsecs
+    int64_t     sint_;   // summary interval in nsecs
+    int64_t     tat_;    // theoretical arrival time of topic bucket
+    int64_t     sts_;    // time of last summary
+    uint64_t    nsup_;
+    uint64_t    ntot_;
+    uint64_t    nsum_;   // suppressed since last summary
+    key_map_t   kmap_;
+  };
+
+  inline str log_limit::get_topic() const
+  {
+    return topic_;
+  }
+
+  inline int log_limit::get_level() const
+  {
+    return lvl_;
+  }
+
   inline bool log::has_level( int level )
   {
-    return level&level_;
+    return static_cast< unsigned >( level ) <= PC_LOG_MIN_LVL &&
+      ( level&level_ );
   }
 
 }
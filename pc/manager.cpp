@@ -2,22 +2,139 @@
 #include "log.hpp"
 
 #include <algorithm>
+#include <sched.h>
+#include <sys/mman.h>
 
 using namespace pc;
 
 #define PC_TPU_PROXY_PORT     8898
 #define PC_RPC_HTTP_PORT      8899
-#define PC_RECONNECT_TIMEOUT  (120L*1000000000L)
 #define PC_BLOCKHASH_TIMEOUT  3
+#define PC_PRIO_FEE_TIMEOUT   10
 #define PC_PUB_INTERVAL       PC_NSECS_IN_SEC
 #define PC_RPC_HOST           "localhost"
 #define PC_MAX_BATCH          8
+#define PC_BATCH_CONTEND_PUB  16
+#define PC_BATCH_CONTEND_SIZE 1
+#define PC_LATENCY_INTERVAL   (10L*PC_NSECS_IN_SEC)
 // Flush partial batches if not completed within 400 ms.
 #define PC_FLUSH_INTERVAL       (400L*PC_NSECS_IN_MSEC)
+// or if the current slot is about to end
+#define PC_FLUSH_LEAD         (100L*PC_NSECS_IN_MSEC)
+#define PC_SLOT_DURATION      (400L*PC_NSECS_IN_MSEC)
+#define PC_LEADER_SLOTS       4
+#define PC_SNAPSHOT_INTERVAL  (300L*PC_NSECS_IN_SEC)
+#define PC_USER_SEND_LIMIT    (1UL<<20)
+#define PC_USER_SEND_MAX      (64UL<<20)
+#define PC_USER_SLOW_TIMEOUT  (30L*PC_NSECS_IN_SEC)
+// Handed over users resume once mapped or after this long regardless
+#define PC_HANDOFF_TIMEOUT    (5L*PC_NSECS_IN_SEC)
+// and the previous process drains its queues for this long at most
+#define PC_HANDOFF_LINGER     (20L*PC_NSECS_IN_MSEC)
+#define PC_HANDOFF_DRAIN      (200L*PC_NSECS_IN_MSEC)
+// Batched account requests in flight during bootstrap and the backoff
+// before the accounts of a failed request are requested again
+#define PC_MAX_FETCH          4
+#define PC_FETCH_RETRY_MIN    (50L*PC_NSECS_IN_MSEC)
+#define PC_FETCH_RETRY_MAX    (5L*PC_NSECS_IN_SEC)
+// Account polls in flight without ws subscriptions and how often any
+// that are due are sent
+#define PC_MAX_POLL           4
+#define PC_POLL_TICK          (50L*PC_NSECS_IN_MSEC)
+// Slots between signature status queries when aggregate-only updates
+// leave our component unknown
+#define PC_AGG_SIG_STATUS_INTERVAL 2
 // Compute units requested per price update instruction
 // The biggest instruction appears to be about ~10300 CUs, so we overestimate by 100%.
 #define PC_UPD_PRICE_COMPUTE_UNITS 20000
 
+// batch_strategy
+static const char *batch_strategy_str[] = {
+  "unknown",
+  "fifo",
+  "fill",
+  "stale",
+  "contend"
+};
+
+// landing is tracked with the strategy as group
+static_assert( (unsigned)batch_strategy::e_last_batch_strategy <=
+               land_track::max_group, "" );
+
+namespace pc
+{
+  str batch_strategy_to_str( batch_strategy val )
+  {
+    unsigned iv = (unsigned)val;
+    if ( iv >= (unsigned)batch_strategy::e_last_batch_strategy ) {
+      iv = 0;
+    }
+    return batch_strategy_str[iv];
+  }
+
+  batch_strategy str_to_batch_strategy( str s )
+  {
+    for( unsigned i=0;
+         i != (unsigned)batch_strategy::e_last_batch_strategy; ++i ) {
+      if ( s == batch_strategy_str[i] ) {
+        return (batch_strategy)i;
+      }
+    }
+    return batch_strategy::e_batch_unknown;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////
+// price_queue
+
+price_queue::price_queue()
+: ring_( 64, entry{ nullptr, 0L } ),
+  hd_( 0UL ),
+  tl_( 0UL )
+{
+}
+
+bool price_queue::add( price *ptr, int64_t ts )
+{
+  if ( ptr->get_is_dirty() ) {
+    return false;
+  }
+  if ( tl_ - hd_ == ring_.size() ) {
+    // grow in place keeping queued order
+    ring_t ring( 2 * ring_.size(), entry{ nullptr, 0L } );
+    for( uint64_t i = hd_; i != tl_; ++i ) {
+      ring[ i - hd_ ] = ring_[ i & ( ring_.size() - 1 ) ];
+    }
+    tl_ -= hd_;
+    hd_ = 0UL;
+    ring_.swap( ring );
+  }
+  ring_[ tl_++ & ( ring_.size() - 1 ) ] = entry{ ptr, ts };
+  ptr->set_is_dirty( true );
+  return true;
+}
+
+unsigned price_queue::size() const
+{
+  return static_cast< unsigned >( tl_ - hd_ );
+}
+
+int64_t price_queue::get_first_ts() const
+{
+  return hd_ != tl_ ? ring_[ hd_ & ( ring_.size() - 1 ) ].ts_ : 0L;
+}
+
+unsigned price_queue::pop( price **buf, unsigned n )
+{
+  unsigned i = 0;
+  for( ; i != n && hd_ != tl_; ++i ) {
+    price *ptr = ring_[ hd_++ & ( ring_.size() - 1 ) ].ptr_;
+    ptr->set_is_dirty( false );
+    buf[i] = ptr;
+  }
+  return i;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // manager_sub
 
@@ -53,11 +170,25 @@ void manager_sub::on_slot_publish( manager * )
 {
 }
 
+void manager_sub::on_prices( manager *, const price_view *, unsigned,
+                             uint64_t )
+{
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // manager
 
 manager::manager()
-: wconn_{ nullptr },
+: num_hconn_( 1 ),
+  hnum_( 2 ),
+  gts_( 0L ),
+  asrc_( nullptr ),
+  ats_( 0L ),
+  is_aup_( false ),
+  wconn_{ nullptr },
+  tpool_( nullptr ),
+  num_sthr_( 0 ),
+  pst_( 0 ),
   thost_( PC_RPC_HOST ),
   rhost_( PC_RPC_HOST ),
   sub_( nullptr ),
@@ -65,33 +196,87 @@ manager::manager()
   num_sub_( 0 ),
   kidx_( (unsigned)-1 ),
   cts_( 0L ),
-  ctimeout_( PC_NSECS_IN_SEC ),
+  ctimeout_( PC_RECONNECT_MIN ),
   slot_( 0UL ),
   slot_cnt_( 0UL ),
   slot_ts_{ 0UL },
+  slot_start_( 0L ),
+  slot_dur_( PC_SLOT_DURATION ),
   curr_ts_( 0L ),
   pub_ts_( 0L ),
   pub_int_( PC_PUB_INTERVAL ),
+  spin_ns_( 0L ),
+  spin_ts_( 0L ),
+  lat_ts_( 0L ),
+  cap_drop_( 0UL ),
+  land_slot_( 0UL ),
+  poll_cpu_( -1 ),
+  poll_pri_( 0 ),
+  sign_cpu_( -1 ),
+  sec_cpu_( -1 ),
+  do_mlock_( false ),
+  kwhl_( price_sched::fraction ),
   wait_conn_( false ),
   do_cap_( false ),
+  do_snap_( false ),
+  do_shm_( false ),
+  do_mcast_( false ),
+  do_trc_( false ),
   do_ws_( true ),
   do_tx_( true ),
+  do_land_( false ),
+  do_pred_( false ),
+  do_pview_( false ),
+  do_wsz_( false ),
+  do_agg_( false ),
   is_pub_( false ),
+  snap_ts_( 0L ),
   cmt_( commitment::e_confirmed ),
   max_batch_( PC_MAX_BATCH ),
+  bstrat_( e_batch_fifo ),
+  bhot_pub_( PC_BATCH_CONTEND_PUB ),
+  bhot_num_( PC_BATCH_CONTEND_SIZE ),
   requested_upd_price_cu_units_( PC_UPD_PRICE_COMPUTE_UNITS ),
-  requested_upd_price_cu_price_( 0UL ),
+  poll_ts_( 0L ),
   sreq_{ { commitment::e_processed } },
-  secondary_{ nullptr },
-  is_secondary_( false )
+  fetch_ts_( 0L ),
+  fetch_to_( PC_FETCH_RETRY_MIN ),
+  flush_lead_( PC_FLUSH_LEAD ),
+  flush_age_( PC_FLUSH_INTERVAL ),
+  bat_num_( 0UL ),
+  bat_rem_( 0L ),
+  bat_min_( 0L ),
+  bat_ts_( 0L ),
+  bat_tot_( 0UL ),
+  tx_tot_( 0UL ),
+  upd_tot_( 0UL ),
+  ack_tot_( 0UL ),
+  usnd_lim_( PC_USER_SEND_LIMIT ),
+  usnd_max_( PC_USER_SEND_MAX ),
+  uslow_to_( PC_USER_SLOW_TIMEOUT ),
+  usr_ts_( 0L ),
+  do_hoff_( false ),
+  is_hoff_( false ),
+  hoff_ts_( 0L ),
+  chg_slot_( 0UL ),
+  chg_ts_( 0L ),
+  is_secondary_( false ),
+  uq_( nullptr ),
+  is_run_( false ),
+  num_shard_( 1U ),
+  shard_( 0U ),
+  fmgr_( nullptr ),
+  nrt_( 0UL ),
+  is_refetch_( false )
 {
   tconn_.set_sub( this );
   breq_->set_sub( this );
+  freq_->set_sub( this );
+  qreq_->set_sub( this );
   sreq_->set_sub( this );
-  preq_->set_sub( this );
-  areq_->set_sub( this );
   tconn_.set_net_parser( &txp_ );
   txp_.mgr_ = this;
+  hacc_.mgr_ = this;
 }
 
 manager::~manager()
@@ -105,9 +290,28 @@ manager::~manager()
     delete ptr;
   }
   svec_.clear();
-  if ( has_secondary() ) {
-    delete secondary_;
+  for( rpc::program_subscribe *ptr: pvec_ ) {
+    delete ptr;
+  }
+  pvec_.clear();
+  for( rpc::get_multiple_accounts *ptr: pavec_ ) {
+    delete ptr;
+  }
+  pavec_.clear();
+  for( rpc::get_multiple_accounts *ptr: favec_ ) {
+    delete ptr;
+  }
+  favec_.clear();
+  for( manager *mgr: secv_ ) {
+    mgr->stop_secondary();
+    delete mgr;
   }
+  secv_.clear();
+  delete uq_;
+  for( upd_queue *qptr: qvec_ ) {
+    delete qptr;
+  }
+  qvec_.clear();
 }
 
 bool manager::tx_parser::parse( const char *, size_t len, size_t& res )
@@ -164,305 +368,1482 @@ bool manager::get_do_ws() const
   return do_ws_;
 }
 
-void manager::set_do_tx( bool do_tx )
+void manager::set_poll_min_interval( int64_t ms )
 {
-  do_tx_ = do_tx;
+  poll_.set_min_interval( ms * PC_NSECS_IN_MSEC );
 }
 
-bool manager::get_do_tx() const
+int64_t manager::get_poll_min_interval() const
 {
-  return do_tx_;
+  return poll_.get_min_interval() / PC_NSECS_IN_MSEC;
 }
 
-void manager::set_capture_file( const std::string& cap_file )
+void manager::set_poll_max_interval( int64_t ms )
 {
-  cap_.set_file( cap_file );
+  poll_.set_max_interval( ms * PC_NSECS_IN_MSEC );
 }
 
-std::string manager::get_capture_file() const
+int64_t manager::get_poll_max_interval() const
 {
-  return cap_.get_file();
+  return poll_.get_max_interval() / PC_NSECS_IN_MSEC;
 }
 
-void manager::set_publish_interval( int64_t pub_int )
+void manager::set_do_tx( bool do_tx )
 {
-  pub_int_ = pub_int * PC_NSECS_IN_MSEC;
+  do_tx_ = do_tx;
 }
 
-int64_t manager::get_publish_interval() const
+bool manager::get_do_tx() const
 {
-  return pub_int_ / PC_NSECS_IN_MSEC;
+  return do_tx_;
 }
 
-void manager::set_requested_upd_price_cu_units( unsigned cu_units ) {
-  requested_upd_price_cu_units_ = cu_units;
+void manager::set_do_land_report( bool do_land )
+{
+  do_land_ = do_land;
 }
 
-unsigned manager::get_requested_upd_price_cu_units() const {
-  return requested_upd_price_cu_units_;
+bool manager::get_do_land_report() const
+{
+  return do_land_;
 }
 
-void manager::set_requested_upd_price_cu_price( unsigned cu_price ) {
-  requested_upd_price_cu_price_ = cu_price;
+void manager::set_do_predict( bool do_pred )
+{
+  do_pred_ = do_pred;
 }
 
-unsigned manager::get_requested_upd_price_cu_price() const {
-  return requested_upd_price_cu_price_;
+bool manager::get_do_predict() const
+{
+  return do_pred_;
 }
 
-void manager::set_max_batch_size( unsigned batch_size )
+void manager::set_do_price_view( bool do_pview )
 {
-  max_batch_ = batch_size;
+  do_pview_ = do_pview;
 }
 
-unsigned manager::get_max_batch_size() const
+bool manager::get_do_price_view() const
 {
-  return max_batch_;
+  return do_pview_;
 }
 
-void manager::set_do_capture( bool do_cap )
+void manager::set_num_sign_threads( unsigned num )
 {
-  do_cap_ = do_cap;
+  num_sthr_ = num;
 }
 
-bool manager::get_do_capture() const
+unsigned manager::get_num_sign_threads() const
 {
-  return do_cap_;
+  return num_sthr_;
 }
 
-void manager::set_listen_port( int port )
+tx_pool *manager::get_tx_pool() const
 {
-  lsvr_.set_port( port );
+  return tpool_;
 }
 
-int manager::get_listen_port() const
+void manager::set_spin_budget( int64_t usecs )
 {
-  return lsvr_.get_port();
+  spin_ns_ = usecs * PC_NSECS_IN_USEC;
 }
 
-void manager::set_commitment( commitment cmt )
+int64_t manager::get_spin_budget() const
 {
-  cmt_ = cmt;
+  return spin_ns_ / PC_NSECS_IN_USEC;
 }
 
-commitment manager::get_commitment() const
+void manager::set_busy_poll( int usecs )
 {
-  return cmt_;
+  nl_.set_busy_poll( usecs );
 }
 
-void manager::set_content_dir( const std::string& cdir )
+int manager::get_busy_poll() const
 {
-  cdir_ = cdir;
+  return nl_.get_busy_poll();
 }
 
-std::string manager::get_content_dir() const
+void manager::set_poll_cpu( int cpu )
 {
-  return cdir_;
+  poll_cpu_ = cpu;
 }
 
-void manager::set_manager_sub( manager_sub *sub )
+int manager::get_poll_cpu() const
 {
-  sub_ = sub;
+  return poll_cpu_;
 }
 
-manager_sub *manager::get_manager_sub() const
+void manager::set_poll_prio( int prio )
 {
-  return sub_;
+  poll_pri_ = prio;
 }
 
-int64_t manager::get_curr_time() const
+int manager::get_poll_prio() const
 {
-  return curr_ts_;
+  return poll_pri_;
 }
 
-rpc_client *manager::get_rpc_client()
+void manager::set_capture_cpu( int cpu )
 {
-  return &clnt_;
+  cap_.set_cpu( cpu );
 }
 
-hash *manager::get_recent_block_hash()
+int manager::get_capture_cpu() const
 {
-  return breq_->get_block_hash();
+  return cap_.get_cpu();
 }
 
-uint64_t manager::get_slot() const
+void manager::set_sign_cpu( int cpu )
 {
-  return slot_;
+  sign_cpu_ = cpu;
 }
 
-void manager::teardown()
+int manager::get_sign_cpu() const
 {
-  PC_LOG_INF( "pythd_teardown" ).add( "secondary", get_is_secondary() ).end();
-
-  // shutdown listener
-  lsvr_.close();
-
-  // destroy any open users
-  while( !olist_.empty() ) {
-    user *usr = olist_.first();
-    olist_.del( usr );
-    dlist_.add( usr );
-  }
-  teardown_users();
-
-  // destroy rpc connections
-  hconn_.close();
-  if ( wconn_ ) {
-    wconn_->close();
-    delete wconn_;
-    wconn_ = nullptr;
-    clnt_.set_ws_conn( nullptr );
-  }
-
-  // Shutdown secondary messenger
-  if ( has_secondary() ) {
-    get_secondary()->teardown();
-  }
+  return sign_cpu_;
 }
 
-bool manager::init()
+void manager::set_secondary_cpu( int cpu )
 {
-  // read key directory
-  if ( !key_store::init() ) {
-    return false;
-  }
+  sec_cpu_ = cpu;
+}
 
-  // log import key names
-  key_pair *kp = get_publish_key_pair();
-  if ( kp ) {
-    PC_LOG_INF( "publish_key" ).add( "key_name", *kp ).add( "secondary", get_is_secondary() ).end();
-  }
-  pub_key *mpub = get_mapping_pub_key();
-  if ( mpub ) {
-    PC_LOG_INF( "mapping_key" ).add( "key_name", *mpub ).add( "secondary", get_is_secondary() ).end();
-  }
-  pub_key *gpub = get_program_pub_key();
-  if ( gpub ) {
-    PC_LOG_INF( "program_key" ).add( "key_name", *gpub ).add( "secondary", get_is_secondary() ).end();
-  }
+int manager::get_secondary_cpu() const
+{
+  return sec_cpu_;
+}
 
-  // initialize capture
-  if ( do_cap_ && !cap_.init() ) {
-    return set_err_msg( cap_.get_err_msg() );
-  }
+void manager::set_do_mlock( bool do_mlock )
+{
+  do_mlock_ = do_mlock;
+}
 
-  // initialize net_loop
-  if ( !nl_.init() ) {
-    return set_err_msg( nl_.get_err_msg() );
-  }
+bool manager::get_do_mlock() const
+{
+  return do_mlock_;
+}
 
-  // decompose rpc_host into host:port
-  int rport =0, wport = 0;
-  std::string rhost = get_host_port( rhost_, rport, wport );
-  if ( rport == 0 ) rport = PC_RPC_HTTP_PORT;
-  if ( wport == 0 ) wport = rport+1;
+void manager::set_do_latency( bool do_lat )
+{
+  nl_.set_latency( do_lat );
+}
 
-  // add rpc_client connection to net_loop and initialize
-  hconn_.set_port( rport );
-  hconn_.set_host( rhost );
-  hconn_.set_net_loop( &nl_ );
-  clnt_.set_http_conn( &hconn_ );
-  if ( get_do_ws() ) {
-    wconn_ = new ws_connect{};
-    wconn_->set_port( wport );
-    wconn_->set_host( rhost );
-    wconn_->set_net_loop( &nl_ );
-    clnt_.set_ws_conn( wconn_ );
-  }
-  if ( !hconn_.init() ) {
-    return set_err_msg( hconn_.get_err_msg() );
-  }
-  if ( wconn_ && !wconn_->init() ) {
-    return set_err_msg( wconn_->get_err_msg() );
-  }
-  // connect to pyth_tx server
-  if ( do_tx_ ) {
-    int tport1 = 0, tport2 = 0;
-    std::string thost = get_host_port( thost_, tport1, tport2 );
-    tconn_.set_port( tport1 ? tport1 : PC_TPU_PROXY_PORT );
-    tconn_.set_host( thost );
-    tconn_.set_net_loop( &nl_ );
-    if ( !tconn_.init() ) {
-      return set_err_msg( tconn_.get_err_msg() );
-    }
-  }
-  wait_conn_ = true;
+bool manager::get_do_latency() const
+{
+  return nl_.get_latency();
+}
 
-  // initialize listening port if port defined
-  if ( lsvr_.get_port() > 0 ) {
-    lsvr_.set_net_accept( this );
-    lsvr_.set_net_loop( &nl_ );
-    if ( !lsvr_.init() ) {
-      return set_err_msg( lsvr_.get_err_msg() );
-    }
-    PC_LOG_INF("listening").add("port",lsvr_.get_port())
-      .add( "secondary", get_is_secondary() )
-      .add( "content_dir", get_content_dir() )
-      .end();
-  }
-  PC_LOG_INF( "initialized" )
-    .add( "secondary", get_is_secondary() )
-    .add( "version", PC_VERSION )
-    .add( "rpc_host", get_rpc_host() )
-    .add( "tx_host", get_tx_host() )
-    .add( "capture_file", get_capture_file() )
-    .add( "commitment", commitment_to_str( get_commitment() ) )
-    .add( "publish_interval(ms)", get_publish_interval() )
-    .end();
+void manager::set_do_ws_deflate( bool do_wsz )
+{
+  do_wsz_ = do_wsz;
+}
 
-  // Initialize secondary network manager
-  if ( has_secondary() ) {
-      PC_LOG_INF("initializing secondary manager").end();
-      secondary_->init();
-      PC_LOG_INF("initialized secondary manager").end();
-  }
+bool manager::get_do_ws_deflate() const
+{
+  return do_wsz_;
+}
 
-  return true;
+void manager::set_do_uring( bool do_uring )
+{
+  nl_.set_use_uring( do_uring );
 }
 
-void manager::add_secondary( const std::string& rpc_host, const std::string& key_dir )
+bool manager::get_do_uring() const
 {
+  return nl_.get_use_uring();
+}
 
-  manager *mgr = new manager;
-  mgr->set_dir( key_dir );
-  mgr->set_rpc_host( rpc_host );
-  mgr->set_tx_host( thost_ );
-  mgr->set_do_tx( do_tx_ );
-  mgr->set_do_ws( do_ws_ );
-  mgr->set_commitment( cmt_ );
-  mgr->set_is_secondary( true );
+void manager::set_capture_file( const std::string& cap_file )
+{
+  cap_.set_file( cap_file );
+}
 
-  secondary_ = mgr;
+std::string manager::get_capture_file() const
+{
+  return cap_.get_file();
+}
 
+void manager::set_capture_level( int level )
+{
+  cap_.set_zstd_level( level );
 }
 
-bool manager::has_secondary() const {
-  return secondary_ != nullptr;
+int manager::get_capture_level() const
+{
+  return cap_.get_zstd_level();
 }
 
-void manager::set_is_secondary(bool is_secondary) {
-  is_secondary_ = is_secondary;
+void manager::set_capture_threads( unsigned num )
+{
+  cap_.set_zstd_threads( num );
 }
 
-bool manager::get_is_secondary() const {
-  return is_secondary_;
+unsigned manager::get_capture_threads() const
+{
+  return cap_.get_zstd_threads();
 }
 
-manager *manager::get_secondary() {
-  return secondary_;
+void manager::set_capture_delta( unsigned num )
+{
+  cap_.set_delta_interval( num );
 }
 
-bool manager::get_is_tx_send() const
+unsigned manager::get_capture_delta() const
 {
-  return tconn_.get_is_send();
+  return cap_.get_delta_interval();
 }
 
-bool manager::get_is_rpc_send() const
+void manager::set_capture_rotate( unsigned secs )
 {
-  return hconn_.get_is_send() || ( wconn_ && wconn_->get_is_send() );
+  cap_.set_rotate_interval( secs );
 }
 
-bool manager::bootstrap()
+unsigned manager::get_capture_rotate() const
+{
+  return cap_.get_rotate_interval();
+}
+
+void manager::set_capture_rotate_size( uint64_t len )
+{
+  cap_.set_rotate_size( len );
+}
+
+uint64_t manager::get_capture_rotate_size() const
+{
+  return cap_.get_rotate_size();
+}
+
+void manager::set_capture_sync( unsigned ms )
+{
+  cap_.set_sync_interval( ms );
+}
+
+unsigned manager::get_capture_sync() const
+{
+  return cap_.get_sync_interval();
+}
+
+void manager::set_capture_max_pending( unsigned num )
+{
+  cap_.set_max_pending( num );
+}
+
+unsigned manager::get_capture_max_pending() const
+{
+  return cap_.get_max_pending();
+}
+
+bool manager::add_capture_filter( str term )
+{
+  return cflt_.add_term( term );
+}
+
+cap_filter& manager::get_capture_filter()
+{
+  return cflt_;
+}
+
+void manager::set_snapshot_file( const std::string& snap_file )
+{
+  snap_.set_file( snap_file );
+  do_snap_ = !snap_file.empty();
+}
+
+std::string manager::get_snapshot_file() const
+{
+  return snap_.get_file();
+}
+
+void manager::set_handoff_file( const std::string& file )
+{
+  hoff_.set_file( file );
+  do_hoff_ = !file.empty();
+}
+
+std::string manager::get_handoff_file() const
+{
+  return hoff_.get_file();
+}
+
+bool manager::get_is_handoff() const
+{
+  if ( !is_hoff_ ) {
+    return false;
+  }
+  int64_t ts = get_now() - hoff_ts_;
+  return ts > PC_HANDOFF_DRAIN || ( ts > PC_HANDOFF_LINGER &&
+      !get_is_tx_send() && !get_is_rpc_send() );
+}
+
+void manager::set_shm_file( const std::string& shm_file )
+{
+  shm_.set_file( shm_file );
+  do_shm_ = !shm_file.empty();
+}
+
+std::string manager::get_shm_file() const
+{
+  return shm_.get_file();
+}
+
+void manager::set_mcast_addr( const std::string& addr )
+{
+  mcast_.set_addr( addr );
+  do_mcast_ = !addr.empty();
+}
+
+std::string manager::get_mcast_addr() const
+{
+  return mcast_.get_addr();
+}
+
+void manager::set_mcast_ttl( int ttl )
+{
+  mcast_.set_ttl( ttl );
+}
+
+int manager::get_mcast_ttl() const
+{
+  return mcast_.get_ttl();
+}
+
+const mcast_pub *manager::get_mcast() const
+{
+  return do_mcast_ ? &mcast_ : nullptr;
+}
+
+void manager::set_trace_file( const std::string& trc_file )
+{
+  trc_.set_file( trc_file );
+  do_trc_ = !trc_file.empty();
+}
+
+std::string manager::get_trace_file() const
+{
+  return trc_.get_file();
+}
+
+void manager::set_trace_sample( unsigned num )
+{
+  trc_.set_sample( num );
+}
+
+unsigned manager::get_trace_sample() const
+{
+  return trc_.get_sample();
+}
+
+void manager::add_program_filter( const rpc::program_filter& filt )
+{
+  fvec_.push_back( filt );
+}
+
+void manager::set_num_shard( unsigned num )
+{
+  num_shard_ = std::max( num, 1U );
+  shard_ = num_shard_ > 1U ? num_shard_ : 0U;
+}
+
+unsigned manager::get_num_shard() const
+{
+  return num_shard_;
+}
+
+unsigned manager::get_shard( const pub_key& prod ) const
+{
+  // keys are uniformly distributed. the account map hashes the first
+  // word so partition on the second
+  const uint64_t *i = (const uint64_t*)prod.data();
+  return static_cast< unsigned >( i[1] % num_shard_ );
+}
+
+void manager::set_do_agg_only( bool do_agg )
+{
+  do_agg_ = do_agg;
+}
+
+bool manager::get_do_agg_only() const
+{
+  return do_agg_;
+}
+
+void manager::set_account_source( account_source *asrc )
+{
+  asrc_ = asrc;
+}
+
+account_source *manager::get_account_source() const
+{
+  return asrc_;
+}
+
+void manager::add_zstd_dict_file( const std::string& dict_file )
+{
+  zfile_.push_back( dict_file );
+}
+
+void manager::set_publish_interval( int64_t pub_int )
+{
+  pub_int_ = pub_int * PC_NSECS_IN_MSEC;
+}
+
+int64_t manager::get_publish_interval() const
+{
+  return pub_int_ / PC_NSECS_IN_MSEC;
+}
+
+void manager::set_requested_upd_price_cu_units( unsigned cu_units ) {
+  requested_upd_price_cu_units_ = cu_units;
+}
+
+unsigned manager::get_requested_upd_price_cu_units() const {
+  return requested_upd_price_cu_units_;
+}
+
+void manager::set_requested_upd_price_cu_price( unsigned cu_price ) {
+  fee_.set_min_cu_price( cu_price );
+}
+
+unsigned manager::get_requested_upd_price_cu_price() const {
+  return fee_.get_cu_price();
+}
+
+void manager::set_max_upd_price_cu_price( unsigned cu_price ) {
+  fee_.set_max_cu_price( cu_price );
+}
+
+unsigned manager::get_max_upd_price_cu_price() const {
+  return fee_.get_max_cu_price();
+}
+
+const prio_fee *manager::get_prio_fee() const {
+  return &fee_;
+}
+
+void manager::set_sig_status_interval( unsigned slots ) {
+  ltrk_.set_interval( slots );
+}
+
+unsigned manager::get_sig_status_interval() const {
+  return ltrk_.get_interval();
+}
+
+const land_track *manager::get_land_track() const {
+  return &ltrk_;
+}
+
+void manager::set_max_batch_size( unsigned batch_size )
+{
+  max_batch_ = batch_size;
+}
+
+unsigned manager::get_max_batch_size() const
+{
+  return max_batch_;
+}
+
+void manager::set_batch_strategy( batch_strategy strat )
+{
+  bstrat_ = strat;
+}
+
+batch_strategy manager::get_batch_strategy() const
+{
+  return bstrat_;
+}
+
+void manager::set_batch_contend_publishers( unsigned num )
+{
+  bhot_pub_ = num;
+}
+
+unsigned manager::get_batch_contend_publishers() const
+{
+  return bhot_pub_;
+}
+
+void manager::set_batch_contend_size( unsigned num )
+{
+  bhot_num_ = std::max( num, 1U );
+}
+
+unsigned manager::get_batch_contend_size() const
+{
+  return bhot_num_;
+}
+
+void manager::set_flush_lead( int64_t lead )
+{
+  flush_lead_ = lead * PC_NSECS_IN_MSEC;
+}
+
+int64_t manager::get_flush_lead() const
+{
+  return flush_lead_ / PC_NSECS_IN_MSEC;
+}
+
+void manager::set_flush_max_age( int64_t age )
+{
+  flush_age_ = age * PC_NSECS_IN_MSEC;
+}
+
+int64_t manager::get_flush_max_age() const
+{
+  return flush_age_ / PC_NSECS_IN_MSEC;
+}
+
+void manager::set_user_send_limit( size_t bytes )
+{
+  usnd_lim_ = bytes;
+}
+
+size_t manager::get_user_send_limit() const
+{
+  return usnd_lim_;
+}
+
+void manager::set_user_send_max( size_t bytes )
+{
+  usnd_max_ = bytes;
+}
+
+size_t manager::get_user_send_max() const
+{
+  return usnd_max_;
+}
+
+void manager::set_user_slow_timeout( int64_t timeout )
+{
+  uslow_to_ = timeout * PC_NSECS_IN_MSEC;
+}
+
+int64_t manager::get_user_slow_timeout() const
+{
+  return uslow_to_ / PC_NSECS_IN_MSEC;
+}
+
+int64_t manager::get_slot_duration() const
+{
+  return slot_dur_;
+}
+
+int64_t manager::get_slot_remain() const
+{
+  return get_slot_remain( get_now() );
+}
+
+uint64_t manager::get_num_batch_sent() const
+{
+  return bat_num_;
+}
+
+int64_t manager::get_avg_batch_slot_remain() const
+{
+  return bat_num_ ? bat_rem_ / static_cast< int64_t >( bat_num_ ) : 0L;
+}
+
+int64_t manager::get_min_batch_slot_remain() const
+{
+  return bat_min_;
+}
+
+void manager::set_do_capture( bool do_cap )
+{
+  do_cap_ = do_cap;
+}
+
+bool manager::get_do_capture() const
+{
+  return do_cap_;
+}
+
+void manager::set_num_http_conn( unsigned num )
+{
+  num_hconn_ = std::max( 1U, num );
+}
+
+unsigned manager::get_num_http_conn() const
+{
+  return num_hconn_;
+}
+
+void manager::add_hedge_host( const std::string& rpc_host )
+{
+  ghost_.push_back( rpc_host );
+}
+
+void manager::set_hedge_num( unsigned num )
+{
+  hnum_ = std::max( 1U, num );
+}
+
+unsigned manager::get_hedge_num() const
+{
+  return hnum_;
+}
+
+void manager::set_listen_port( int port )
+{
+  lsvr_.set_port( port );
+}
+
+int manager::get_listen_port() const
+{
+  return lsvr_.get_port();
+}
+
+void manager::set_commitment( commitment cmt )
+{
+  cmt_ = cmt;
+}
+
+commitment manager::get_commitment() const
+{
+  return cmt_;
+}
+
+void manager::set_content_dir( const std::string& cdir )
+{
+  cdir_ = cdir;
+}
+
+std::string manager::get_content_dir() const
+{
+  return cdir_;
+}
+
+void manager::set_manager_sub( manager_sub *sub )
+{
+  sub_ = sub;
+}
+
+manager_sub *manager::get_manager_sub() const
+{
+  return sub_;
+}
+
+int64_t manager::get_curr_time() const
+{
+  return curr_ts_;
+}
+
+rpc_client *manager::get_rpc_client()
+{
+  return &clnt_;
+}
+
+hash *manager::get_recent_block_hash()
+{
+  return breq_->get_block_hash();
+}
+
+uint64_t manager::get_slot() const
+{
+  return slot_;
+}
+
+void manager::teardown()
+{
+  PC_LOG_INF( "pythd_teardown" ).add( "secondary", get_is_secondary() ).end();
+
+  // shutdown listener
+  lsvr_.close();
+
+  // destroy any open users
+  while( !olist_.empty() ) {
+    user *usr = olist_.first();
+    olist_.del( usr );
+    dlist_.add( usr );
+  }
+  teardown_users();
+
+  // keep latest accounts for next start. after a handoff the successor
+  // maintains the snapshot
+  if ( !is_hoff_ ) {
+    save_snapshot();
+  }
+  hoff_.close();
+
+  // spans still in flight are written incomplete
+  if ( do_trc_ && !trc_.close() ) {
+    PC_LOG_ERR( "failed to close trace file" )
+      .add( "secondary", get_is_secondary() )
+      .add( "error", trc_.get_err_msg() )
+      .end();
+  }
+
+  // destroy rpc connections
+  hconn_.close();
+  for( tcp_connect *cptr: hpool_ ) {
+    cptr->close();
+    delete cptr;
+  }
+  hpool_.clear();
+  for( hedge_conn& hc: gpool_ ) {
+    hc.cptr_->close();
+    delete hc.cptr_;
+  }
+  gpool_.clear();
+  if ( asrc_ ) {
+    asrc_->close();
+  }
+  if ( tpool_ ) {
+    tpool_->teardown();
+    delete tpool_;
+    tpool_ = nullptr;
+  }
+  if ( wconn_ ) {
+    wconn_->close();
+    delete wconn_;
+    wconn_ = nullptr;
+    clnt_.set_ws_conn( nullptr );
+  }
+
+  // Shutdown secondary messengers
+  for( manager *mgr: secv_ ) {
+    mgr->stop_secondary();
+    mgr->teardown();
+  }
+}
+
+bool manager::init()
+{
+  // prediction aggregates the components aggregate-only updates omit
+  if ( do_pred_ && do_agg_ ) {
+    return set_err_msg( "prediction is not supported with aggregate-only "
+                        "price updates" );
+  }
+
+  // read key directory
+  if ( !key_store::init() ) {
+    return false;
+  }
+
+  // log import key names
+  key_pair *kp = get_publish_key_pair();
+  if ( kp ) {
+    PC_LOG_INF( "publish_key" ).add( "key_name", *kp ).add( "secondary", get_is_secondary() ).end();
+  }
+  pub_key *mpub = get_mapping_pub_key();
+  if ( mpub ) {
+    PC_LOG_INF( "mapping_key" ).add( "key_name", *mpub ).add( "secondary", get_is_secondary() ).end();
+  }
+  pub_key *gpub = get_program_pub_key();
+  if ( gpub ) {
+    PC_LOG_INF( "program_key" ).add( "key_name", *gpub ).add( "secondary", get_is_secondary() ).end();
+  }
+
+  // load account dictionaries
+  for( const std::string& file: zfile_ ) {
+    if ( !zdict_.add_file( file ) ) {
+      return set_err_msg( zdict_.get_err_msg() );
+    }
+  }
+  if ( zdict_.get_num() ) {
+    clnt_.set_zstd_dict( &zdict_ );
+    cap_.set_zstd_dict( &zdict_ );
+  }
+
+  // the landing of our updates is then known by signature only
+  if ( do_agg_ && do_tx_ && !ltrk_.get_interval() ) {
+    ltrk_.set_interval( PC_AGG_SIG_STATUS_INTERVAL );
+  }
+
+  // one program subscription per filter. aggregate-only slicing is
+  // limited to price accounts so the others need their own. shards are
+  // handed the notifications of their front end instead
+  filt_vec_t fvec = fvec_;
+  if ( get_is_shard() ) {
+    fvec.clear();
+  } else if ( fvec.empty() ) {
+    fvec.resize( do_agg_ ? 3 : 1 );
+    if ( do_agg_ ) {
+      fvec[0].set_account_type( PC_ACCTYPE_MAPPING );
+      fvec[1].set_account_type( PC_ACCTYPE_PRODUCT );
+      fvec[2].set_account_type( PC_ACCTYPE_PRICE );
+    }
+  }
+  for( rpc::program_filter& filt: fvec ) {
+    if ( do_agg_ && filt.get_account_type() == PC_ACCTYPE_PRICE ) {
+      filt.set_data_len( offsetof( pc_price_t, comp_ ) );
+    }
+    rpc::program_subscribe *pptr = new rpc::program_subscribe;
+    pptr->set_sub( this );
+    pptr->set_filter( filt );
+    pvec_.push_back( pptr );
+  }
+
+  // known accounts are polled without ws subscriptions
+  for( unsigned i = 0; !do_ws_ && i != PC_MAX_POLL; ++i ) {
+    rpc::get_multiple_accounts *mptr = new rpc::get_multiple_accounts;
+    mptr->set_sub( this );
+    pavec_.push_back( mptr );
+  }
+
+  // product and price accounts are requested in batches
+  for( unsigned i = 0; i != PC_MAX_FETCH; ++i ) {
+    rpc::get_multiple_accounts *mptr = new rpc::get_multiple_accounts;
+    mptr->set_sub( this );
+    favec_.push_back( mptr );
+  }
+
+  // initialize capture
+  if ( do_cap_ && !cap_.init() ) {
+    return set_err_msg( cap_.get_err_msg() );
+  }
+
+  // initialize shared-memory price feed
+  if ( do_shm_ && !shm_.init() ) {
+    return set_err_msg( shm_.get_err_msg() );
+  }
+
+  // initialize multicast price feed
+  if ( do_mcast_ && !mcast_.init() ) {
+    return set_err_msg( mcast_.get_err_msg() );
+  }
+
+  // initialize publisher update tracing
+  if ( do_trc_ && !trc_.init() ) {
+    return set_err_msg( trc_.get_err_msg() );
+  }
+
+  // take over from a running pythd. it saves its account snapshot for
+  // us before handing over its sockets
+  if ( do_hoff_ ) {
+    if ( !do_snap_ ) {
+      set_snapshot_file( get_handoff_file() + ".snap" );
+    }
+    if ( !hoff_.recv() ) {
+      return set_err_msg( hoff_.get_err_msg() );
+    }
+    if ( hoff_.get_is_recv() ) {
+      hoff_ts_ = get_now();
+      PC_LOG_INF( "handoff_recv" )
+        .add( "file", get_handoff_file() )
+        .add( "listen", hoff_.get_listen_fd() >= 0 )
+        .add( "num_users", hoff_.get_conns().size() )
+        .end();
+    }
+  }
+
+  // load account snapshot. without one we bootstrap from the rpc node
+  if ( do_snap_ ) {
+    if ( snap_.init() ) {
+      PC_LOG_INF( "load_snapshot" )
+        .add( "secondary", get_is_secondary() )
+        .add( "file", get_snapshot_file() )
+        .add( "num_accounts", snap_.get_num() )
+        .end();
+    } else {
+      PC_LOG_WRN( "failed to load snapshot" )
+        .add( "secondary", get_is_secondary() )
+        .add( "error", snap_.get_err_msg() )
+        .end();
+      snap_.reset_err();
+    }
+  }
+
+  // initialize net_loop
+  if ( !nl_.init() ) {
+    return set_err_msg( nl_.get_err_msg() );
+  }
+
+  // decompose rpc_host into host:port
+  int rport =0, wport = 0;
+  std::string rhost = get_host_port( rhost_, rport, wport );
+  if ( rport == 0 ) rport = PC_RPC_HTTP_PORT;
+  if ( wport == 0 ) wport = rport+1;
+
+  // add rpc_client connection to net_loop and initialize
+  hconn_.set_port( rport );
+  hconn_.set_host( rhost );
+  hconn_.set_net_loop( &nl_ );
+  clnt_.set_http_conn( &hconn_ );
+  if ( get_do_ws() ) {
+    wconn_ = new ws_connect{};
+    wconn_->set_port( wport );
+    wconn_->set_host( rhost );
+    wconn_->set_net_loop( &nl_ );
+    wconn_->set_deflate( do_wsz_ );
+    clnt_.set_ws_conn( wconn_ );
+  }
+  for( unsigned i=1; i < num_hconn_; ++i ) {
+    tcp_connect *cptr = new tcp_connect;
+    cptr->set_port( rport );
+    cptr->set_host( rhost );
+    cptr->set_net_loop( &nl_ );
+    if ( i == 1 ) {
+      clnt_.set_tx_http_conn( cptr );
+    } else {
+      clnt_.add_http_conn( cptr );
+    }
+    hpool_.push_back( cptr );
+  }
+  if ( !hconn_.init() ) {
+    return set_err_msg( hconn_.get_err_msg() );
+  }
+  for( tcp_connect *cptr: hpool_ ) {
+    if ( !cptr->init() ) {
+      return set_err_msg( cptr->get_err_msg() );
+    }
+  }
+  if ( wconn_ && !wconn_->init() ) {
+    return set_err_msg( wconn_->get_err_msg() );
+  }
+
+  // hedge connections are allowed to be down at start
+  for( const std::string& host: ghost_ ) {
+    int gport = 0, gport2 = 0;
+    std::string ghost = get_host_port( host, gport, gport2 );
+    hedge_conn hc;
+    hc.cptr_ = new tcp_connect;
+    hc.cptr_->set_port( gport ? gport : PC_RPC_HTTP_PORT );
+    hc.cptr_->set_host( ghost );
+    hc.cptr_->set_net_loop( &nl_ );
+    hc.cptr_->init();
+    hc.cts_ = get_now();
+    hc.is_up_ = false;
+    clnt_.add_hedge_conn( hc.cptr_ );
+    gpool_.push_back( hc );
+  }
+  clnt_.set_hedge_num( hnum_ );
+
+  // account source is allowed to be down at start
+  if ( asrc_ ) {
+    if ( !gpub ) {
+      return set_err_msg( "missing or invalid program public key [" +
+          get_program_pub_key_file() + "]" );
+    }
+    asrc_->set_sub( this );
+    asrc_->set_program( gpub );
+    asrc_->set_commitment( get_commitment() );
+    asrc_->init();
+    ats_ = get_now();
+  }
+
+  // connect to pyth_tx server
+  if ( do_tx_ ) {
+    int tport1 = 0, tport2 = 0;
+    std::string thost = get_host_port( thost_, tport1, tport2 );
+    tconn_.set_port( tport1 ? tport1 : PC_TPU_PROXY_PORT );
+    tconn_.set_host( thost );
+    tconn_.set_net_loop( &nl_ );
+    if ( !tconn_.init() ) {
+      return set_err_msg( tconn_.get_err_msg() );
+    }
+    if ( num_sthr_ ) {
+      tpool_ = new tx_pool;
+      tpool_->set_num_threads( num_sthr_ );
+      tpool_->set_cpu( sign_cpu_ );
+      tpool_->set_tx_conn( &tconn_ );
+      tpool_->set_net_loop( &nl_ );
+      if ( !tpool_->init() ) {
+        return set_err_msg( tpool_->get_err_msg() );
+      }
+    }
+  }
+  wait_conn_ = true;
+
+  // initialize listening port if port defined. a listening socket
+  // taken over keeps its port
+  int lfd = hoff_.get_listen_fd();
+  if ( lsvr_.get_port() > 0 ) {
+    lsvr_.set_net_accept( this );
+    lsvr_.set_net_loop( &nl_ );
+    if ( !( lfd >= 0 ? lsvr_.init( lfd ) : lsvr_.init() ) ) {
+      return set_err_msg( lsvr_.get_err_msg() );
+    }
+    PC_LOG_INF("listening").add("port",lsvr_.get_port())
+      .add( "secondary", get_is_secondary() )
+      .add( "content_dir", get_content_dir() )
+      .end();
+  } else if ( lfd >= 0 ) {
+    ::close( lfd );
+  }
+
+  // wait for our successor
+  if ( do_hoff_ ) {
+    hoff_.set_net_accept( &hacc_ );
+    hoff_.set_net_loop( &nl_ );
+    if ( !hoff_.init() ) {
+      return set_err_msg( hoff_.get_err_msg() );
+    }
+  }
+  // pin polling thread
+  if ( poll_cpu_ >= 0 ) {
+    cpu_set_t cset;
+    CPU_ZERO( &cset );
+    CPU_SET( static_cast< size_t >( poll_cpu_ ), &cset );
+    if ( 0 != sched_setaffinity( 0, sizeof( cset ), &cset ) ) {
+      return set_err_msg( "failed to pin cpu=" +
+          std::to_string( poll_cpu_ ), errno );
+    }
+  }
+  if ( poll_pri_ > 0 && !set_thread_prio( pthread_self(), poll_pri_ ) ) {
+    return set_err_msg( "failed to set real-time priority=" +
+        std::to_string( poll_pri_ ), errno );
+  }
+  if ( do_mlock_ && 0 != ::mlockall( MCL_CURRENT | MCL_FUTURE ) ) {
+    return set_err_msg( "failed to lock memory", errno );
+  }
+  PC_LOG_INF( "initialized" )
+    .add( "secondary", get_is_secondary() )
+    .add( "version", PC_VERSION )
+    .add( "rpc_host", get_rpc_host() )
+    .add( "tx_host", get_tx_host() )
+    .add( "land_report", get_do_land_report() )
+    .add( "predict", get_do_predict() )
+    .add( "sig_status_interval", get_sig_status_interval() )
+    .add( "capture_file", get_capture_file() )
+    .add( "capture_level", get_capture_level() )
+    .add( "capture_threads", get_capture_threads() )
+    .add( "capture_delta", get_capture_delta() )
+    .add( "capture_rotate", get_capture_rotate() )
+    .add( "capture_sync", get_capture_sync() )
+    .add( "capture_max_pending", get_capture_max_pending() )
+    .add( "capture_filters", cflt_.get_num_term() )
+    .add( "batch_strategy", batch_strategy_to_str( bstrat_ ) )
+    .add( "shm_file", get_shm_file() )
+    .add( "mcast_addr", get_mcast_addr() )
+    .add( "mcast_ttl", get_mcast_ttl() )
+    .add( "trace_file", get_trace_file() )
+    .add( "trace_sample", get_trace_sample() )
+    .add( "zstd_dicts", zdict_.get_num() )
+    .add( "commitment", commitment_to_str( get_commitment() ) )
+    .add( "publish_interval(ms)", get_publish_interval() )
+    .add( "flush_lead(ms)", get_flush_lead() )
+    .add( "flush_max_age(ms)", get_flush_max_age() )
+    .add( "user_send_limit", get_user_send_limit() )
+    .add( "user_send_max", get_user_send_max() )
+    .add( "user_slow_timeout(ms)", get_user_slow_timeout() )
+    .add( "num_http_conn", num_hconn_ )
+    .add( "num_hedge_conn", gpool_.size() )
+    .add( "hedge_num", hnum_ )
+    .add( "sign_threads", num_sthr_ )
+    .add( "account_source", asrc_ != nullptr )
+    .add( "program_filters", fvec_.size() )
+    .add( "num_shard", num_shard_ )
+    .add( "agg_only", do_agg_ )
+    .add( "io_uring", nl_.get_is_uring() )
+    .add( "ws_deflate", do_wsz_ )
+    .add( "spin_budget(us)", get_spin_budget() )
+    .add( "busy_poll(us)", get_busy_poll() )
+    .add( "poll_cpu", poll_cpu_ )
+    .add( "poll_prio", poll_pri_ )
+    .add( "capture_cpu", get_capture_cpu() )
+    .add( "sign_cpu", sign_cpu_ )
+    .add( "secondary_cpu", sec_cpu_ )
+    .add( "mlock", do_mlock_ )
+    .add( "huge_pages", huge_page::get_enabled() )
+    .add( "handoff_file", get_handoff_file() )
+    .end();
+
+  // shards of our network come first so that users find its prices
+  // there before those of secondary networks
+  if ( num_shard_ > 1U && !get_is_shard() ) {
+    for( unsigned i = 0; i != num_shard_; ++i ) {
+      manager *mgr = new_secondary( get_rpc_host(), get_dir() );
+      mgr->set_publish_interval( get_publish_interval() );
+      mgr->set_requested_upd_price_cu_units(
+          get_requested_upd_price_cu_units() );
+      mgr->set_max_batch_size( get_max_batch_size() );
+      mgr->num_shard_ = num_shard_;
+      mgr->shard_ = i;
+      mgr->fmgr_ = this;
+      secv_.insert( secv_.begin() + i, mgr );
+    }
+  }
+
+  // Initialize secondary network managers and start their threads
+  int sec_cpu = sec_cpu_;
+  for( manager *mgr: secv_ ) {
+      PC_LOG_INF("initializing secondary manager").end();
+      mgr->init();
+      mgr->start_secondary();
+      if ( sec_cpu >= 0 &&
+           !set_thread_cpu( mgr->thrd_.native_handle(), sec_cpu++ ) ) {
+        return set_err_msg( "failed to pin secondary thread to cpu=" +
+            std::to_string( sec_cpu - 1 ), errno );
+      }
+      PC_LOG_INF("initialized secondary manager").end();
+  }
+
+  return true;
+}
+
+void manager::add_secondary( const std::string& rpc_host, const std::string& key_dir )
+{
+  secv_.push_back( new_secondary( rpc_host, key_dir ) );
+}
+
+manager *manager::new_secondary(
+    const std::string& rpc_host, const std::string& key_dir )
+{
+  manager *mgr = new manager;
+  mgr->set_dir( key_dir );
+  mgr->set_rpc_host( rpc_host );
+  mgr->set_tx_host( thost_ );
+  mgr->set_do_tx( do_tx_ );
+  mgr->set_do_land_report( do_land_ );
+  mgr->set_do_predict( do_pred_ );
+  mgr->set_num_sign_threads( num_sthr_ );
+  mgr->set_do_ws( do_ws_ );
+  mgr->set_poll_min_interval( get_poll_min_interval() );
+  mgr->set_poll_max_interval( get_poll_max_interval() );
+  mgr->set_do_uring( get_do_uring() );
+  mgr->set_do_ws_deflate( do_wsz_ );
+  mgr->set_spin_budget( get_spin_budget() );
+  mgr->set_busy_poll( get_busy_poll() );
+  mgr->set_do_latency( get_do_latency() );
+  mgr->set_num_http_conn( num_hconn_ );
+  mgr->set_hedge_num( hnum_ );
+  mgr->set_do_agg_only( do_agg_ );
+  mgr->set_requested_upd_price_cu_price( fee_.get_min_cu_price() );
+  mgr->set_max_upd_price_cu_price( fee_.get_max_cu_price() );
+  mgr->set_sig_status_interval( ltrk_.get_interval() );
+  mgr->set_flush_lead( get_flush_lead() );
+  mgr->set_flush_max_age( get_flush_max_age() );
+  mgr->set_batch_strategy( bstrat_ );
+  mgr->set_batch_contend_publishers( bhot_pub_ );
+  mgr->set_batch_contend_size( bhot_num_ );
+  for( const rpc::program_filter& filt: fvec_ ) {
+    mgr->add_program_filter( filt );
+  }
+  mgr->set_commitment( cmt_ );
+  for( const std::string& file: zfile_ ) {
+    mgr->add_zstd_dict_file( file );
+  }
+  mgr->set_is_secondary( true );
+  mgr->uq_ = new upd_queue;
+  return mgr;
+}
+
+bool manager::has_secondary() const {
+  return !secv_.empty();
+}
+
+unsigned manager::get_num_secondary() const {
+  return static_cast< unsigned >( secv_.size() );
+}
+
+void manager::set_is_secondary(bool is_secondary) {
+  is_secondary_ = is_secondary;
+}
+
+bool manager::get_is_secondary() const {
+  return is_secondary_;
+}
+
+manager *manager::get_secondary( unsigned i ) {
+  return i < secv_.size() ? secv_[i] : nullptr;
+}
+
+bool manager::get_is_shard() const
+{
+  return shard_ < num_shard_ && num_shard_ > 1U;
+}
+
+void manager::add_notify( price *ptr )
+{
+  ntf_.push_back( ptr );
+}
+
+void manager::add_notify_predict( price *ptr )
+{
+  pntf_.push_back( ptr );
+}
+
+void manager::poll_notify()
+{
+  // users are sent the latest value so repeated prices are sent once
+  if ( !ntf_.empty() ) {
+    std::sort( ntf_.begin(), ntf_.end() );
+    ntf_.erase( std::unique( ntf_.begin(), ntf_.end() ), ntf_.end() );
+    for( price *ptr: ntf_ ) {
+      ptr->notify();
+    }
+    ntf_.clear();
+  }
+  if ( !pntf_.empty() ) {
+    std::sort( pntf_.begin(), pntf_.end() );
+    pntf_.erase( std::unique( pntf_.begin(), pntf_.end() ), pntf_.end() );
+    for( price *ptr: pntf_ ) {
+      ptr->notify_predict();
+    }
+    pntf_.clear();
+  }
+}
+
+void manager::add_route( const pub_key& acc, unsigned shard )
+{
+  std::lock_guard<std::mutex> lk( rmtx_ );
+  route_map_t::iter_t it = rmap_.find( acc );
+  if ( !it ) {
+    it = rmap_.add( acc );
+  }
+  rmap_.ref( it ) = shard;
+}
+
+unsigned manager::get_route( const pub_key& acc )
+{
+  std::lock_guard<std::mutex> lk( rmtx_ );
+  route_map_t::iter_t it = rmap_.find( acc );
+  return it ? rmap_.obj( it ) : num_shard_;
+}
+
+void manager::add_routed(
+    const pub_key& acc, uint64_t slot, uint64_t lamports, str data )
+{
+  // updates are kept with their buffers for reuse
+  std::lock_guard<std::mutex> lk( rmtx_ );
+  if ( nrt_ == rtv_.size() ) {
+    rtv_.resize( nrt_ + 1 );
+  }
+  routed_upd& ru = rtv_[nrt_++];
+  ru.acc_ = acc;
+  ru.slot_ = slot;
+  ru.lamports_ = lamports;
+  ru.data_.assign( data.str_, data.len_ );
+}
+
+void manager::poll_routed()
+{
+  // the front end resubscribed after a disconnect
+  if ( PC_UNLIKELY( is_refetch_ ) ) {
+    is_refetch_ = false;
+    if ( has_status( PC_PYTH_HAS_MAPPING ) ) {
+      fetch_all();
+      send_fetch();
+    }
+  }
+  size_t num;
+  {
+    std::lock_guard<std::mutex> lk( rmtx_ );
+    if ( !nrt_ ) {
+      return;
+    }
+    rtv_.swap( rtw_ );
+    num = nrt_;
+    nrt_ = 0UL;
+  }
+  rpc::routed_account_update upd;
+  upd.set_sub( this );
+  upd.set_rpc_client( &clnt_ );
+  for( size_t i = 0; i != num; ++i ) {
+    const routed_upd& ru = rtw_[i];
+    upd.set_update( ru.acc_, ru.slot_, ru.lamports_,
+                    ru.data_.data(), ru.data_.size() );
+    upd.dispatch();
+  }
+}
+
+upd_queue *manager::add_producer()
+{
+  qvec_.push_back( new upd_queue );
+  return qvec_.back();
+}
+
+void manager::add_secondary_update(
+    const pub_key& acc, int64_t price, uint64_t conf, symbol_status st )
+{
+  if ( PC_UNLIKELY( !uq_->push( acc, price, conf, st ) ) &&
+       uq_->get_num_drop() % 1000UL == 1UL ) {
+    PC_LOG_WRN( "secondary update queue full" )
+      .add( "secondary", get_is_secondary() )
+      .add( "rpc_host", get_rpc_host() )
+      .add( "num_drop", uq_->get_num_drop() )
+      .end();
+  }
+}
+
+void manager::lock()
+{
+  mtx_.lock();
+}
+
+void manager::unlock()
+{
+  mtx_.unlock();
+}
+
+bool manager::try_lock()
+{
+  return mtx_.try_lock();
+}
+
+void manager::start_secondary()
+{
+  is_run_ = true;
+  thrd_ = std::thread( run_secondary, this );
+}
+
+void manager::stop_secondary()
+{
+  if ( thrd_.joinable() ) {
+    is_run_ = false;
+    thrd_.join();
+  }
+}
+
+void manager::run_secondary( manager *mgr )
+{
+  // wait for socket events unlocked so that the primary manager only
+  // contends with the dispatch of events and periodic work
+  while( mgr->is_run_ ) {
+    mgr->nl_.wait( 1 );
+    std::lock_guard<std::mutex> lk( mgr->mtx_ );
+    mgr->nl_.poll( 0 );
+    mgr->poll_update();
+  }
+}
+
+void manager::poll_queue()
+{
+  upd_queue::upd upd;
+  while( uq_->pop( upd ) ) {
+    price *ptr = get_price( upd.acc_ );
+    if ( ptr ) {
+      ptr->update_no_send( upd.price_, upd.conf_, upd.st_, false );
+      add_dirty_price( ptr );
+    }
+  }
+}
+
+void manager::init_from_snapshot( request *rptr, const pub_key& acc )
+{
+  // apply the last known account content right away. the account info
+  // request already sent reconciles it with the chain when it returns
+  size_t len = 0;
+  const pc_acc_t *ptr = do_snap_ ? snap_.get_account( acc, len ) : nullptr;
+  if ( !ptr ) {
+    return;
+  }
+  rpc::raw_account_update upd;
+  upd.set_update( acc, slot_, 0UL, (const char*)ptr, len );
+  rptr->set_is_recv( true );
+  rptr->on_response( &upd );
+}
+
+void manager::fetch_account( const pub_key& acc )
+{
+  fetch_.push_back( acc );
+}
+
+void manager::fetch_all()
+{
+  for( get_mapping *mptr: mvec_ ) {
+    fetch_account( *mptr->get_mapping_key() );
+  }
+  for( product *ptr: svec_ ) {
+    fetch_account( *ptr->get_account() );
+    for( unsigned i=0; i != ptr->get_num_price(); ++i ) {
+      fetch_account( *ptr->get_price( i )->get_account() );
+    }
+  }
+}
+
+void manager::send_fetch()
+{
+  // get queued accounts in chunks with a few requests in flight so that
+  // every product or every price in a chain position is a round trip
+  if ( curr_ts_ < fetch_ts_ ) {
+    return;
+  }
+  size_t pos = 0;
+  for( rpc::get_multiple_accounts *mptr: favec_ ) {
+    if ( pos == fetch_.size() ) {
+      break;
+    }
+    if ( !mptr->get_is_recv() ) {
+      continue;
+    }
+    mptr->clear_accounts();
+    for( ; pos != fetch_.size() &&
+         mptr->get_num_accounts() != rpc::get_multiple_accounts::max_accounts;
+         ++pos ) {
+      mptr->add_account( fetch_[pos] );
+    }
+    mptr->set_commitment( get_commitment() );
+    clnt_.send( mptr );
+  }
+  fetch_.erase( fetch_.begin(), fetch_.begin() + (long)pos );
+}
+
+void manager::save_snapshot()
+{
+  snap_ts_ = curr_ts_;
+  if ( !do_snap_ || !snap_.get_num() ) {
+    return;
+  }
+  if ( snap_.save() ) {
+    PC_LOG_DBG( "save_snapshot" )
+      .add( "secondary", get_is_secondary() )
+      .add( "num_accounts", snap_.get_num() )
+      .end();
+  } else {
+    PC_LOG_ERR( "failed to save snapshot" )
+      .add( "secondary", get_is_secondary() )
+      .add( "error", snap_.get_err_msg() )
+      .end();
+    snap_.reset_err();
+  }
+}
+
+void manager::poll_producer()
+{
+  // publish to every network as with updates from users. at most a queue
+  // length at a time so that a busy producer cannot hold up the poll
+  upd_queue::upd upd;
+  for( upd_queue *qptr: qvec_ ) {
+    for( uint64_t i = 0; i != upd_queue::max_upd && qptr->pop( upd ); ++i ) {
+      price *ptr = get_price( upd.acc_ );
+      if ( ptr ) {
+        ptr->update_no_send( upd.price_, upd.conf_, upd.st_, false );
+        add_dirty_price( ptr );
+      }
+      for( manager *mgr: secv_ ) {
+        mgr->add_secondary_update( upd.acc_, upd.price_, upd.conf_, upd.st_ );
+      }
+    }
+  }
+}
+
+bool manager::get_is_tx_send() const
+{
+  return tconn_.get_is_send();
+}
+
+bool manager::get_is_rpc_send() const
+{
+  for( tcp_connect *cptr: hpool_ ) {
+    if ( cptr->get_is_send() ) {
+      return true;
+    }
+  }
+  return hconn_.get_is_send() || ( wconn_ && wconn_->get_is_send() );
+}
+
+bool manager::get_is_http_wait()
+{
+  for( tcp_connect *cptr: hpool_ ) {
+    if ( cptr->get_is_wait() ) {
+      return true;
+    }
+  }
+  return hconn_.get_is_wait();
+}
+
+bool manager::get_is_http_err() const
+{
+  for( tcp_connect *cptr: hpool_ ) {
+    if ( cptr->get_is_err() ) {
+      return true;
+    }
+  }
+  return hconn_.get_is_err();
+}
+
+bool manager::bootstrap()
 {
   int status = PC_PYTH_RPC_CONNECTED | PC_PYTH_HAS_BLOCK_HASH;
   if ( get_mapping_pub_key() ) {
@@ -487,6 +1868,9 @@ void manager::add_mapping( const pub_key& acc )
     amap_.ref( amap_.add( acc ) ) = mptr;
     mvec_.push_back( mptr );
     submit( mptr );
+    if ( !pavec_.empty() ) {
+      poll_.add_account( acc, false, curr_ts_ );
+    }
 
     // add mapping subscription count
     add_map_sub();
@@ -516,39 +1900,157 @@ void manager::reset_status( int status )
 void manager::send_pending_ups()
 {
   uint32_t n_to_send = 0;
+  if ( pending_upds_.size() == 0 ) {
+    return;
+  }
 
-  // the batch will be sent if its size is greater than max batch size
-  // or time since the previously sent batch is greater than PC_FLUSH_INTERVAL
+  // the batch will be sent if its size is greater than max batch size.
+  // partial batches are sent when the oldest update reaches the maximum
+  // age or when the current slot is about to end so that they can still
+  // land in it or at the start of the next one. that is earlier in the
+  // last slot of a leader's window as the next leader may be further away
   // the buffer is being updated by user class un user::parse_upd_price
   int64_t curr_ts = get_now();
-  if (curr_ts - last_upd_ts_> PC_FLUSH_INTERVAL) {
+  int64_t remain = get_slot_remain( curr_ts );
+  unsigned max_num = get_batch_limit();
+  if ( pending_upds_.size() >= max_num ) {
+    // strategies other than fifo compose batches from the whole queue
+    n_to_send = bstrat_ == e_batch_fifo ? max_num : pending_upds_.size();
+  } else if ( curr_ts - pending_upds_.get_first_ts() >= flush_age_ ) {
     n_to_send = pending_upds_.size();
-  } else if (pending_upds_.size() >= get_max_batch_size()) {
-    n_to_send = get_max_batch_size();
+  } else if ( remain > 0L ) {
+    uint64_t slot = slot_;
+    if ( curr_ts > slot_start_ ) {
+      slot += static_cast< uint64_t >( ( curr_ts - slot_start_ ) / slot_dur_ );
+    }
+    int64_t lead = flush_lead_;
+    if ( slot % PC_LEADER_SLOTS == PC_LEADER_SLOTS - 1 ) {
+      lead *= 2;
+    }
+    if ( remain <= lead ) {
+      n_to_send = pending_upds_.size();
+    }
   }
 
   if (n_to_send == 0) {
     return;
   }
 
-  // send batch of price updates to solana
-  price::send( pending_upds_.data(), n_to_send);
+  // remove the batch from the queue and send it to solana
+  send_upds_.resize( n_to_send );
+  pending_upds_.pop( send_upds_.data(), n_to_send );
+  send_batch( send_upds_.data(), n_to_send );
+
+  // record time to the end of the slot
+  if ( remain > 0L ) {
+    bat_min_ = bat_num_ ? std::min( bat_min_, remain ) : remain;
+    bat_rem_ += remain;
+    ++bat_num_;
+  }
+}
+
+void manager::send_batch( price **upds, unsigned n )
+{
+  // fifo batches are cut at the max batch size by price::send
+  if ( bstrat_ == e_batch_fifo ) {
+    price::send( upds, n );
+    unsigned max_num = std::max( get_max_batch_size(), 1U );
+    bat_tot_ += ( n + max_num - 1 ) / max_num;
+    return;
+  }
+
+  // stalest first by the publish slot of our last update that landed
+  if ( bstrat_ != e_batch_fill ) {
+    std::stable_sort( upds, upds + n, []( price *a, price *b ) {
+      return a->get_landed_slot() < b->get_landed_slot();
+    } );
+  }
+
+  // contended prices take write locks that other publishers wait on.
+  // they go first in small transactions of their own so that they do
+  // not hold up the rest
+  unsigned i = 0, num = 0;
+  if ( bstrat_ == e_batch_contend ) {
+    price **hot = std::stable_partition( upds, upds + n, [this]( price *p ) {
+      return p->get_num_publisher() >= bhot_pub_;
+    } );
+    unsigned nhot = static_cast< unsigned >( hot - upds );
+    for( ; i < nhot; i += num ) {
+      num = std::min( bhot_num_, nhot - i );
+      price::send( &upds[i], num, num );
+      ++bat_tot_;
+    }
+  }
+  unsigned max_num = get_batch_limit();
+  for( ; i < n; i += num ) {
+    num = std::min( max_num, n - i );
+    price::send( &upds[i], num, max_num );
+    ++bat_tot_;
+  }
+}
+
+unsigned manager::get_batch_limit() const
+{
+  // as many updates as fit a transaction unless limited to max batch
+  if ( bstrat_ == e_batch_fifo ) {
+    return get_max_batch_size();
+  }
+  return rpc::upd_price::get_max_num( get_requested_upd_price_cu_units(),
+                                      get_requested_upd_price_cu_price() );
+}
+
+void manager::flush_pending_ups()
+{
+  // whole queue composed by the batch strategy
+  unsigned n_to_send = pending_upds_.size();
+  if ( n_to_send ) {
+    send_upds_.resize( n_to_send );
+    pending_upds_.pop( send_upds_.data(), n_to_send );
+    send_batch( send_upds_.data(), n_to_send );
+  }
+}
 
-  // remove the sent elements from the vector
-  pending_upds_.erase(pending_upds_.begin(), pending_upds_.begin() + n_to_send);
+int64_t manager::get_slot_remain( int64_t ts ) const
+{
+  if ( !slot_start_ ) {
+    return 0L;
+  }
+  // project slot boundaries past the last observed slot
+  int64_t elapsed = ts > slot_start_ ? ts - slot_start_ : 0L;
+  return slot_dur_ - elapsed % slot_dur_;
+}
 
-  // record the current time
-  last_upd_ts_= curr_ts;
+void manager::log_batch_timing()
+{
+  if ( bat_ts_ && bat_num_ ) {
+    PC_LOG_DBG( "batch_slot_timing" )
+      .add( "secondary", get_is_secondary() )
+      .add( "num", bat_num_ )
+      .add( "slot_duration(ms)", 1e-6*slot_dur_ )
+      .add( "avg_slot_remain(ms)", 1e-6*get_avg_batch_slot_remain() )
+      .add( "min_slot_remain(ms)", 1e-6*bat_min_ )
+      .end();
+  }
+  bat_num_ = 0UL;
+  bat_rem_ = 0L;
+  bat_min_ = 0L;
+  bat_ts_ = curr_ts_;
 }
 
 void manager::poll( bool do_wait )
 {
   // poll for any socket events
   if ( do_wait ) {
-    nl_.poll( 1 );
+    poll_wait();
   } else {
     if ( has_status( PC_PYTH_RPC_CONNECTED ) ) {
       hconn_.poll();
+      for( tcp_connect *cptr: hpool_ ) {
+        cptr->poll();
+      }
+      for( hedge_conn& hc: gpool_ ) {
+        hc.cptr_->poll();
+      }
       if ( wconn_ ) {
         wconn_->poll();
       }
@@ -556,6 +2058,9 @@ void manager::poll( bool do_wait )
     if ( do_tx_ ) {
       tconn_.poll();
     }
+    if ( do_hoff_ ) {
+      hoff_.poll();
+    }
     if ( lsvr_.get_port()>0 ) {
       lsvr_.poll();
       for( user *uptr = olist_.first(); uptr; ) {
@@ -566,15 +2071,28 @@ void manager::poll( bool do_wait )
     }
   }
 
-  // submit pending requests
-  for( request *rptr =plist_.first(); rptr; ) {
-    request *nxt = rptr->get_next();
-    if ( rptr->get_is_ready() ) {
-      rptr->set_is_submit( false );
-      plist_.del( rptr );
-      rptr->submit();
+  poll_update();
+
+  // dispatch publisher schedules of secondary networks and price updates
+  // of shards on this thread as they notify our users. skipped while a
+  // secondary is busy
+  for( manager *mgr: secv_ ) {
+    if ( mgr->try_lock() ) {
+      mgr->poll_schedule();
+      mgr->poll_notify();
+      mgr->unlock();
     }
-    rptr = nxt;
+  }
+}
+
+void manager::poll_update()
+{
+  // submit pending requests
+  poll_pending();
+
+  // dispatch notifications handed over by our front end
+  if ( fmgr_ ) {
+    poll_routed();
   }
 
   // destroy any users scheduled for deletion
@@ -583,6 +2101,46 @@ void manager::poll( bool do_wait )
   // get current time
   curr_ts_ = get_now();
 
+  // resume users taken over at restart once their accounts are known
+  if ( PC_UNLIKELY( !hoff_.get_conns().empty() ) &&
+       ( has_status( PC_PYTH_HAS_MAPPING ) ||
+         curr_ts_ - hoff_ts_ > PC_HANDOFF_TIMEOUT ) ) {
+    restore_users();
+  }
+
+  // periodic wake-to-dispatch latency report
+  if ( nl_.get_latency() && curr_ts_ - lat_ts_ > PC_LATENCY_INTERVAL ) {
+    log_latency();
+  }
+
+  // periodic account snapshot once bootstrapped
+  if ( do_snap_ && has_status( PC_PYTH_HAS_MAPPING ) &&
+       curr_ts_ - snap_ts_ > PC_SNAPSHOT_INTERVAL ) {
+    save_snapshot();
+  }
+
+  // periodic report of batch send time relative to slot end
+  if ( curr_ts_ - bat_ts_ > PC_LATENCY_INTERVAL ) {
+    log_batch_timing();
+  }
+
+  // one notification per slot to bulk price subscriptions and the
+  // multicast feed
+  if ( !chg_.empty() ) {
+    poll_bulk();
+  }
+  if ( do_trc_ ) {
+    trc_.poll( curr_ts_ );
+  }
+  if ( do_mcast_ ) {
+    mcast_.poll( curr_ts_ );
+  }
+
+  // conflation and slow consumer policy of user send queues
+  if ( !olist_.empty() ) {
+    poll_users();
+  }
+
   // get current slot
   if ( curr_ts_ - slot_ts_ > 200 * PC_NSECS_IN_MSEC ) {
     if ( sreq_->get_is_recv() ) {
@@ -590,17 +2148,31 @@ void manager::poll( bool do_wait )
         clnt_.send( sreq_ );
       }
     }
-    if ( ! get_do_ws() ) {
-      if ( areq_->get_is_recv() ) {
-        if ( has_status( PC_PYTH_RPC_CONNECTED ) ) {
-          clnt_.send( areq_ );
-        }
-      }
-    }
   }
 
-  // request quotes from the publishers
-  poll_schedule();
+  // poll accounts in place of program subscriptions once mapped
+  if ( !pavec_.empty() && !asrc_ && curr_ts_ - poll_ts_ > PC_POLL_TICK &&
+       has_status( PC_PYTH_HAS_MAPPING ) ) {
+    poll_accounts();
+  }
+
+  // dispatch streamed account updates
+  if ( asrc_ ) {
+    poll_source();
+  }
+
+  // request quotes from the publishers. secondary networks are
+  // scheduled by the primary manager and receive its quotes instead
+  if ( uq_ ) {
+    poll_queue();
+  } else {
+    poll_schedule();
+  }
+
+  // price updates from publisher threads
+  if ( !qvec_.empty() ) {
+    poll_producer();
+  }
 
   // try to (re)connect to tx proxy
   if ( do_tx_ && ( !tconn_.get_is_connect() || tconn_.get_is_err() ) ) {
@@ -608,16 +2180,178 @@ void manager::poll( bool do_wait )
   }
 
   if ( has_status( PC_PYTH_RPC_CONNECTED ) &&
-       !hconn_.get_is_err() &&
+       !get_is_http_err() &&
        ( !wconn_ || !wconn_->get_is_err() ) ) {
+    poll_hedge();
+    send_fetch();
     send_pending_ups();
   } else {
     reconnect_rpc();
   }
+}
+
+void manager::poll_wait()
+{
+  if ( spin_ns_ <= 0 ) {
+    nl_.poll( 1 );
+    return;
+  }
+  // spin while within budget of the last event then block as usual
+  if ( nl_.poll( 0 ) ) {
+    spin_ts_ = get_now();
+  } else if ( get_now() - spin_ts_ > spin_ns_ && nl_.poll( 1 ) ) {
+    spin_ts_ = get_now();
+  }
+}
+
+void manager::log_latency()
+{
+  if ( lat_ts_ && nl_.get_num_latency() ) {
+    PC_LOG_INF( "wake_to_dispatch" )
+      .add( "secondary", get_is_secondary() )
+      .add( "mode", spin_ns_ > 0 ? "spin" : "wait" )
+      .add( "num", nl_.get_num_latency() )
+      .add( "avg(ns)", nl_.get_avg_latency() )
+      .add( "max(ns)", nl_.get_max_latency() )
+      .end();
+  }
+  static const char *lat_name[] = { "recv_to_send", "send_to_ack",
+                                    "send_to_agg" };
+  lat_hist hist;
+  for( unsigned i = 0; i != e_lat_num; ++i ) {
+    get_pub_latency( (pub_lat)i, hist );
+    if ( hist.get_num() ) {
+      PC_LOG_INF( "publish_latency" )
+        .add( "secondary", get_is_secondary() )
+        .add( "type", lat_name[i] )
+        .add( "num", hist.get_num() )
+        .add( "p50(ns)", hist.get_quantile( .5 ) )
+        .add( "p90(ns)", hist.get_quantile( .9 ) )
+        .add( "p99(ns)", hist.get_quantile( .99 ) )
+        .add( "p999(ns)", hist.get_quantile( .999 ) )
+        .add( "max(ns)", hist.get_max() )
+        .end();
+    }
+  }
+  for( unsigned i = 0; i != clnt_.get_num_method(); ++i ) {
+    const rpc_client::method_stats& ms = clnt_.get_method_stats( i );
+    if ( ms.rtt_.get_num() ) {
+      PC_LOG_INF( "rpc_latency" )
+        .add( "secondary", get_is_secondary() )
+        .add( "method", ms.method_ )
+        .add( "num", ms.rtt_.get_num() )
+        .add( "num_err", ms.num_err_ )
+        .add( "p50(ns)", ms.rtt_.get_quantile( .5 ) )
+        .add( "p99(ns)", ms.rtt_.get_quantile( .99 ) )
+        .add( "max(ns)", ms.rtt_.get_max() )
+        .add( "num_notify", ms.num_ntf_ )
+        .end();
+    }
+  }
+  nl_.reset_latency();
+  lat_ts_ = curr_ts_;
+}
+
+void manager::poll_source()
+{
+  if ( !asrc_->get_is_err() ) {
+    asrc_->poll();
+  }
+  if ( !asrc_->get_is_err() ) {
+    if ( !is_aup_ && asrc_->get_is_connect() ) {
+      is_aup_ = true;
+      PC_LOG_INF( "account_source_connected" )
+        .add( "secondary", get_is_secondary() )
+        .end();
+    }
+    return;
+  }
+  if ( is_aup_ ) {
+    is_aup_ = false;
+    PC_LOG_ERR( "account_source_reset" )
+      .add( "secondary", get_is_secondary() )
+      .add( "error", asrc_->get_err_msg() )
+      .end();
+  }
+  if ( curr_ts_ - ats_ > PC_NSECS_IN_SEC ) {
+    ats_ = curr_ts_;
+    asrc_->close();
+    asrc_->reset_err();
+    asrc_->init();
+  }
+}
+
+void manager::poll_hedge()
+{
+  for( hedge_conn& hc: gpool_ ) {
+    tcp_connect *cptr = hc.cptr_;
+    if ( cptr->get_is_wait() ) {
+      cptr->check();
+    } else if ( !cptr->get_is_err() ) {
+      if ( !hc.is_up_ ) {
+        hc.is_up_ = true;
+        PC_LOG_INF( "rpc_hedge_connected" )
+          .add( "secondary", get_is_secondary() )
+          .add( "host", cptr->get_host() )
+          .add( "port", cptr->get_port() )
+          .end();
+      }
+    } else {
+      // replies still owed by this provider are left to the other copies
+      clnt_.reset_hedge_conn( cptr );
+      if ( hc.is_up_ ) {
+        hc.is_up_ = false;
+        PC_LOG_ERR( "rpc_hedge_reset" )
+          .add( "secondary", get_is_secondary() )
+          .add( "error", cptr->get_err_msg() )
+          .add( "host", cptr->get_host() )
+          .add( "port", cptr->get_port() )
+          .end();
+      }
+      if ( curr_ts_ - hc.cts_ > PC_NSECS_IN_SEC ) {
+        hc.cts_ = curr_ts_;
+        cptr->init();
+      }
+    }
+  }
+
+  // periodic provider latency report
+  if ( gpool_.empty() || curr_ts_ - gts_ < PC_LATENCY_INTERVAL ) {
+    return;
+  }
+  gts_ = curr_ts_;
+  for( unsigned i=0; i != clnt_.get_num_hedge_conn(); ++i ) {
+    PC_LOG_DBG( "rpc_hedge" )
+      .add( "host", clnt_.get_hedge_conn( i )->get_host() )
+      .add( "latency(ns)", clnt_.get_hedge_latency( i ) )
+      .add( "wins", clnt_.get_hedge_wins( i ) )
+      .end();
+  }
+}
 
-  // Call the secondary manager's poll loop if necessary
-  if ( has_secondary() ) {
-    secondary_->poll();
+void manager::poll_pending()
+{
+  // readiness depends on our status so waiting requests are only
+  // rechecked when it has changed
+  if ( status_ != pst_ ) {
+    pst_ = status_;
+    for( request *rptr = plist_.first(); rptr; ) {
+      request *nxt = rptr->get_next();
+      if ( rptr->get_is_ready() ) {
+        plist_.del( rptr );
+        rlist_.add( rptr );
+      }
+      rptr = nxt;
+    }
+  }
+  for( request *rptr = rlist_.first(); rptr; rptr = rlist_.first() ) {
+    rlist_.del( rptr );
+    if ( rptr->get_is_ready() ) {
+      rptr->set_is_submit( false );
+      rptr->submit();
+    } else {
+      plist_.add( rptr );
+    }
   }
 }
 
@@ -631,16 +2365,19 @@ void manager::poll_schedule()
     pub_ts_ = curr_ts_;
   }
 
-  // Schedule the price_sched requests in a staggered fashion.
-  while ( is_pub_ && kidx_ < kvec_.size() ) {
-    price_sched *kptr = kvec_[kidx_];
+  // Schedule the price_sched requests in a staggered fashion. Each wheel
+  // slot holds the requests whose hash offsets fall at that fraction of
+  // the publish interval so only slots that are due are visited
+  while ( is_pub_ && kidx_ < kwhl_.size() ) {
     int64_t pub_ts = pub_ts_ + static_cast< int64_t >(
-      ( static_cast< uint64_t >( pub_int_ ) * kptr->get_hash() )
+      ( static_cast< uint64_t >( pub_int_ ) * kidx_ )
         / price_sched::fraction
     );
     if ( curr_ts_ > pub_ts ) {
-      kptr->schedule();
-      if ( ++kidx_ >= kvec_.size() ) {
+      for( price_sched *kptr: kwhl_[kidx_] ) {
+        kptr->schedule();
+      }
+      if ( ++kidx_ >= kwhl_.size() ) {
         is_pub_ = false;
       }
     } else {
@@ -655,33 +2392,54 @@ void manager::reconnect_rpc()
   if ( hconn_.get_is_wait() ) {
     hconn_.check();
   }
+  for( tcp_connect *cptr: hpool_ ) {
+    if ( cptr->get_is_wait() ) {
+      cptr->check();
+    }
+  }
   if ( wconn_ && wconn_->get_is_wait() ) {
     wconn_->check();
   }
-  if ( hconn_.get_is_wait() || ( wconn_ && wconn_->get_is_wait() ) ) {
+  if ( get_is_http_wait() || ( wconn_ && wconn_->get_is_wait() ) ) {
     return;
   }
 
   // check for successful (re)connect
-  if ( !hconn_.get_is_err() && ( !wconn_ || !wconn_->get_is_err() ) ) {
+  if ( !get_is_http_err() && ( !wconn_ || !wconn_->get_is_err() ) ) {
     PC_LOG_INF( "rpc_connected" ).add( "secondary", get_is_secondary() ).end();
     set_status( PC_PYTH_RPC_CONNECTED );
 
     // reset state
     wait_conn_ = false;
-    ctimeout_ = PC_NSECS_IN_SEC;
+    ctimeout_ = PC_RECONNECT_MIN;
     slot_ = 0L;
     slot_cnt_ = 0UL;
     slot_ts_ = 0L;
+    slot_start_ = 0L;
     num_sub_ = 0;
+    // replies from before the reset must not reach reused request ids
+    for( hedge_conn& hc: gpool_ ) {
+      hc.cptr_->init();
+      hc.cts_ = get_now();
+      hc.is_up_ = false;
+    }
     clnt_.reset();
-    for(;;) {
-      request *rptr = plist_.first();
-      if ( rptr ) {
+    fetch_.clear();
+    fetch_ts_ = 0L;
+    fetch_to_ = PC_FETCH_RETRY_MIN;
+    for( rpc::get_multiple_accounts *mptr: favec_ ) {
+      mptr->set_recv_time( mptr->get_sent_time() );
+    }
+    for( rpc::get_multiple_accounts *mptr: pavec_ ) {
+      if ( !mptr->get_is_recv() ) {
+        poll_.retry( mptr, curr_ts_ );
+      }
+      mptr->set_recv_time( mptr->get_sent_time() );
+    }
+    for( req_list_t *lptr: { &plist_, &rlist_ } ) {
+      for( request *rptr = lptr->first(); rptr; rptr = lptr->first() ) {
         rptr->set_is_submit( false );
-        plist_.del( rptr );
-      } else {
-        break;
+        lptr->del( rptr );
       }
     }
 
@@ -693,16 +2451,34 @@ void manager::reconnect_rpc()
     if ( !gpub ) {
       set_err_msg( "missing or invalid program public key [" +
           get_program_pub_key_file() + "]" );
-    } else {
+    } else if ( !asrc_ ) {
       if ( get_do_ws() ) {
-        preq_->set_commitment( get_commitment() );
-        preq_->set_program( get_program_pub_key() );
-        clnt_.send( preq_ );
+        for( rpc::program_subscribe *pptr: pvec_ ) {
+          pptr->set_commitment( get_commitment() );
+          pptr->set_program( get_program_pub_key() );
+          clnt_.send( pptr );
+        }
       }
-      else {
-        areq_->set_commitment( get_commitment() );
-        areq_->set_program( get_program_pub_key() );
+    }
+
+    // account state survives the reconnect once initialized so that
+    // publishing resumes with a fresh block hash. accounts are fetched
+    // again in one burst and reconciled as the replies arrive. so are
+    // those of our shards as they missed the notifications meanwhile
+    if ( has_status( PC_PYTH_HAS_MAPPING ) ) {
+      fetch_all();
+      for( unsigned i = 0; num_shard_ > 1U && i != num_shard_; ++i ) {
+        secv_[i]->is_refetch_ = true;
       }
+      PC_LOG_INF( "rpc_resubscribe" )
+        .add( "secondary", get_is_secondary() )
+        .add( "num_accounts", fetch_.size() )
+        .end();
+      send_fetch();
+      if ( sub_ ) {
+        sub_->on_connect( this );
+      }
+      return;
     }
 
     // gather latest info on mapping accounts
@@ -747,7 +2523,7 @@ void manager::reconnect_rpc()
   }
 
   // wait for reconnect timeout
-  status_ = 0;
+  status_ &= PC_PYTH_HAS_MAPPING;
   int64_t ts = get_now();
   if ( ctimeout_ > (ts-cts_) ) {
     return;
@@ -759,6 +2535,9 @@ void manager::reconnect_rpc()
   ctimeout_ = std::min( ctimeout_, PC_RECONNECT_TIMEOUT );
   wait_conn_ = true;
   hconn_.init();
+  for( tcp_connect *cptr: hpool_ ) {
+    cptr->init();
+  }
   if ( wconn_ ) {
     wconn_->init();
   }
@@ -766,6 +2545,17 @@ void manager::reconnect_rpc()
 
 void manager::log_disconnect()
 {
+  for( tcp_connect *cptr: hpool_ ) {
+    if ( cptr->get_is_err() ) {
+      PC_LOG_ERR( "rpc_http_reset")
+        .add( "secondary", get_is_secondary() )
+        .add( "error", cptr->get_err_msg() )
+        .add( "host", rhost_ )
+        .add( "port", cptr->get_port() )
+        .end();
+      return;
+    }
+  }
   if ( hconn_.get_is_err() ) {
     PC_LOG_ERR( "rpc_http_reset")
       .add( "secondary", get_is_secondary() )
@@ -797,7 +2587,105 @@ void manager::teardown_users()
   }
 }
 
+void manager::poll_users()
+{
+  bool do_log = curr_ts_ - usr_ts_ > PC_LATENCY_INTERVAL;
+  for( user *uptr = olist_.first(); uptr; ) {
+    user *nptr = uptr->get_next();
+    if ( do_log ) {
+      PC_LOG_DBG( "user_send_queue" )
+        .add( "fd", uptr->get_fd() )
+        .add( "send_size", uptr->get_send_size() )
+        .add( "max_send_size", uptr->get_max_send_size() )
+        .add( "num_conflate", uptr->get_num_conflate() )
+        .end();
+      uptr->reset_send_stats();
+    }
+    uptr->poll_send_queue( curr_ts_ );
+    uptr = nptr;
+  }
+  if ( do_log ) {
+    usr_ts_ = curr_ts_;
+  }
+}
+
+void manager::add_bulk_user( user *usr )
+{
+  busr_.push_back( usr );
+}
+
+void manager::del_bulk_user( user *usr )
+{
+  busr_.erase( std::remove( busr_.begin(), busr_.end(), usr ), busr_.end() );
+}
+
+unsigned manager::get_num_bulk_user() const
+{
+  return static_cast< unsigned >( busr_.size() );
+}
+
+void manager::add_changed_price( price *ptr )
+{
+  if ( busr_.empty() && !do_mcast_ && !( do_pview_ && sub_ ) ) {
+    return;
+  }
+  if ( chg_.empty() ) {
+    chg_slot_ = slot_;
+    chg_ts_   = curr_ts_;
+  }
+  chg_.push_back( ptr );
+}
+
+void manager::poll_accounts()
+{
+  poll_ts_ = curr_ts_;
+  for( rpc::get_multiple_accounts *mptr: pavec_ ) {
+    if ( !has_status( PC_PYTH_RPC_CONNECTED ) ) {
+      break;
+    }
+    if ( mptr->get_is_recv() && poll_.build( mptr, curr_ts_ ) ) {
+      mptr->set_commitment( get_commitment() );
+      clnt_.send( mptr );
+    }
+  }
+}
+
+void manager::poll_bulk()
+{
+  // wait for the slot of the first change to end. fall back on the
+  // slot duration if slots are not advancing
+  if ( slot_ == chg_slot_ && curr_ts_ - chg_ts_ < slot_dur_ ) {
+    return;
+  }
+  std::sort( chg_.begin(), chg_.end() );
+  chg_.erase( std::unique( chg_.begin(), chg_.end() ), chg_.end() );
+  if ( dnot_.get_num_user() ) {
+    dnot_.update( chg_, chg_slot_ );
+  }
+  for( user *usr: busr_ ) {
+    usr->on_prices( chg_, chg_slot_ );
+  }
+  if ( do_mcast_ ) {
+    mcast_.publish( chg_, chg_slot_ );
+  }
+  if ( do_pview_ && sub_ ) {
+    chgv_.clear();
+    for( price *ptr: chg_ ) {
+      chgv_.push_back( ptr->get_view() );
+    }
+    sub_->on_prices( this, chgv_.data(), (unsigned)chgv_.size(), chg_slot_ );
+  }
+  chg_.clear();
+}
+
 void manager::accept( int fd )
+{
+  if ( add_user( fd ) ) {
+    PC_LOG_DBG( "new_user" ).add("fd", fd ).end();
+  }
+}
+
+user *manager::add_user( int fd )
 {
   // create and add new user
   user *usr = new user;
@@ -806,13 +2694,107 @@ void manager::accept( int fd )
   usr->set_manager( this );
   usr->set_fd( fd );
   usr->set_block( false );
+  usr->set_allow_deflate( do_wsz_ );
   if ( usr->init() ) {
-    PC_LOG_DBG( "new_user" ).add("fd", fd ).end();
     olist_.add( usr );
-  } else {
-    usr->close();
-    delete usr;
+    return usr;
+  }
+  usr->close();
+  delete usr;
+  return nullptr;
+}
+
+void manager::handoff_accept::accept( int fd )
+{
+  mgr_->send_handoff( fd );
+}
+
+void manager::send_handoff( int fd )
+{
+  if ( is_hoff_ ) {
+    ::close( fd );
+    return;
+  }
+
+  // publish what users have sent so far and save the accounts for the
+  // successor to start from
+  int64_t ts = get_now();
+  flush_pending_ups();
+  snap_ts_ = curr_ts_;
+  if ( !snap_.save() ) {
+    PC_LOG_ERR( "failed to save snapshot" )
+      .add( "error", snap_.get_err_msg() )
+      .end();
+    snap_.reset_err();
+  }
+
+  // websocket users move with their state. the others are dropped when
+  // we exit and reconnect
+  std::vector<user*> uvec;
+  handoff::conn_vec_t cvec;
+  size_t num_drop = 0;
+  for( user *uptr = olist_.first(); uptr; uptr = uptr->get_next() ) {
+    ++num_drop;
+    uptr->poll_send();
+    handoff::conn cn;
+    cn.fd_ = uptr->get_fd();
+    if ( !uptr->net_connect::get_is_err() &&
+         uptr->save_state( cn.state_ ) ) {
+      uvec.push_back( uptr );
+      cvec.emplace_back( std::move( cn ) );
+    }
+  }
+  if ( !hoff_.send( fd, lsvr_.get_fd(), cvec ) ) {
+    PC_LOG_ERR( "failed to hand over" )
+      .add( "file", get_handoff_file() )
+      .add( "error", hoff_.get_err_msg() )
+      .end();
+    hoff_.reset_err();
+    return;
   }
+
+  // the successor owns the sockets now. our copies are closed before
+  // teardown so that nothing more reaches its users
+  lsvr_.close();
+  hoff_.close();
+  for( user *uptr: uvec ) {
+    uptr->close();
+    uptr->teardown();
+  }
+  is_hoff_ = true;
+  hoff_ts_ = get_now();
+  PC_LOG_INF( "handoff_sent" )
+    .add( "file", get_handoff_file() )
+    .add( "num_users", uvec.size() )
+    .add( "num_dropped", num_drop - uvec.size() )
+    .add( "elapsed(us)", ( hoff_ts_ - ts ) / PC_NSECS_IN_USEC )
+    .end();
+}
+
+void manager::restore_users()
+{
+  unsigned num_user = 0, num_drop = 0;
+  for( handoff::conn& cn: hoff_.get_conns() ) {
+    user *usr = add_user( cn.fd_ );
+    if ( !usr ) {
+      continue;
+    }
+    int rc = usr->restore_state( cn.state_ );
+    if ( rc < 0 ) {
+      PC_LOG_ERR( "invalid handoff user state" ).add( "fd", cn.fd_ ).end();
+      del_user( usr );
+      continue;
+    }
+    num_drop += static_cast< unsigned >( rc );
+    ++num_user;
+    usr->poll();
+  }
+  PC_LOG_INF( "handoff_restore" )
+    .add( "num_users", num_user )
+    .add( "num_sub_dropped", num_drop )
+    .add( "elapsed(us)", ( curr_ts_ - hoff_ts_ ) / PC_NSECS_IN_USEC )
+    .end();
+  hoff_.get_conns().clear();
 }
 
 void manager::del_user( user *usr )
@@ -824,12 +2806,7 @@ void manager::del_user( user *usr )
 
 void manager::schedule( price_sched *kptr )
 {
-  kvec_.push_back( kptr );
-  for( unsigned i = kvec_.size()-1; i; --i ) {
-    if ( kvec_[i]->get_hash() < kvec_[i-1]->get_hash() ) {
-      std::swap( kvec_[i], kvec_[i-1] );
-    }
-  }
+  kwhl_[kptr->get_hash()].push_back( kptr );
 }
 
 void manager::on_response( rpc::get_slot *res )
@@ -847,6 +2824,20 @@ void manager::on_response( rpc::get_slot *res )
   if ( slot <= slot_ ) {
     return;
   }
+
+  // track slot duration and the start of the current slot. the slot is
+  // observed up to a poll interval after it started so the estimate is
+  // carried forward by whole slots and only pulled back by observations
+  if ( slot_ && ts > slot_ts_ ) {
+    int64_t num = static_cast< int64_t >( slot - slot_ );
+    int64_t dur = ( ts - slot_ts_ ) / num;
+    slot_dur_ += ( dur - slot_dur_ ) / 8;
+    slot_dur_ = std::max( slot_dur_, PC_NSECS_IN_MSEC );
+    int64_t start = slot_start_ ? slot_start_ + num * slot_dur_ : ts;
+    slot_start_ = std::min( ts, std::max( start, ts - slot_dur_ ) );
+  } else {
+    slot_start_ = ts;
+  }
   slot_ = slot;
   slot_ts_ = ts;
 
@@ -855,17 +2846,34 @@ void manager::on_response( rpc::get_slot *res )
   PC_LOG_DBG( "received get_slot" )
     .add( "slot", slot_ )
     .add( "round_trip_time(ms)", 1e-6*ack_ts )
+    .add( "inflight", clnt_.get_num_inflight() )
     .add( "secondary", get_is_secondary() )
     .end();
 
   // submit block hash every N slots
+  if ( slot_cnt_ % PC_PRIO_FEE_TIMEOUT == 0 && fee_.get_is_adaptive() ) {
+    send_prio_fee();
+  }
+  if ( ltrk_.get_interval() && slot_cnt_ % ltrk_.get_interval() == 0 &&
+       !ltrk_.get_is_pending() && ltrk_.build( qreq_, slot_ ) ) {
+    clnt_.send( qreq_ );
+  }
   if ( slot_cnt_++ % PC_BLOCKHASH_TIMEOUT == 0 ) {
     clnt_.send( breq_ );
   }
 
-  // flush capture
+  // flush capture and start records of the new slot
   if ( do_cap_ ) {
     cap_.flush();
+    cap_.set_slot( slot_ );
+    uint64_t num_drop = cap_.get_num_dropped();
+    if ( PC_UNLIKELY( num_drop != cap_drop_ ) ) {
+      PC_LOG_WRN( "capture records dropped" )
+        .add( "num_dropped", num_drop - cap_drop_ )
+        .add( "total_dropped", num_drop )
+        .end();
+      cap_drop_ = num_drop;
+    }
   }
 
   if (
@@ -899,6 +2907,130 @@ void manager::on_response( rpc::get_recent_block_hash *m )
 
 }
 
+void manager::send_prio_fee()
+{
+  // fees paid to write lock the price accounts that we publish to
+  freq_->clear_accounts();
+  for( product *prod: svec_ ) {
+    for( unsigned i = 0; i != prod->get_num_price(); ++i ) {
+      price *ptr = prod->get_price( i );
+      if ( ptr->has_publisher() ) {
+        freq_->add_account( *ptr->get_account() );
+      }
+    }
+  }
+  if ( freq_->get_num_accounts() ) {
+    clnt_.send( freq_ );
+  }
+}
+
+void manager::on_response( rpc::get_recent_prioritization_fees *m )
+{
+  if ( m->get_is_err() ) {
+    PC_LOG_ERR( "failed to get recent prioritization fees" )
+      .add( "secondary", get_is_secondary() )
+      .add( "error", m->get_err_msg() )
+      .end();
+    return;
+  }
+  uint64_t num_sent = 0, num_recv = 0;
+  if ( ltrk_.get_interval() ) {
+    // landing known by signature
+    num_recv = ltrk_.get_num_land();
+    num_sent = num_recv + ltrk_.get_num_lost();
+  } else {
+    for( product *prod: svec_ ) {
+      for( unsigned i = 0; i != prod->get_num_price(); ++i ) {
+        price *ptr = prod->get_price( i );
+        num_sent += ptr->get_num_sent();
+        num_recv += ptr->get_num_recv();
+      }
+    }
+  }
+  unsigned cu_price = fee_.get_cu_price();
+  fee_.update( m->get_fees(), num_sent, num_recv );
+  if ( cu_price != fee_.get_cu_price() ) {
+    PC_LOG_DBG( "updated upd_price cu_price" )
+      .add( "secondary", get_is_secondary() )
+      .add( "cu_price", fee_.get_cu_price() )
+      .add( "market_price", fee_.get_market_price() )
+      .add( "boost", fee_.get_boost() )
+      .add( "landing_rate", fee_.get_landing_rate() )
+      .end();
+  }
+}
+
+void manager::on_response( rpc::get_signature_statuses *m )
+{
+  if ( m->get_is_err() ) {
+    PC_LOG_ERR( "failed to get signature statuses" )
+      .add( "secondary", get_is_secondary() )
+      .add( "error", m->get_err_msg() )
+      .end();
+  }
+  ltrk_.update( m, slot_ );
+  if ( ltrk_.get_batch_num() ) {
+    PC_LOG_DBG( "received signature statuses" )
+      .add( "secondary", get_is_secondary() )
+      .add( "num_sig", m->get_num_signatures() )
+      .add( "num_resolved", ltrk_.get_batch_num() )
+      .add( "landing_rate", ltrk_.get_batch_rate() )
+      .add( "landing_slots", ltrk_.get_batch_slots() )
+      .end();
+  }
+  add_landed( ltrk_.get_land_pub_slot(), ltrk_.get_land_slot() );
+}
+
+void manager::on_response( rpc::get_multiple_accounts *m )
+{
+  bool is_poll = pavec_.end() != std::find( pavec_.begin(), pavec_.end(), m );
+  if ( PC_UNLIKELY( m->get_is_err() ) ) {
+    if ( !is_poll ) {
+      // accounts of the request are queued again and every batched
+      // request backs off so that a struggling node is not flooded
+      PC_LOG_ERR( "account fetch failed" )
+        .add( "secondary", get_is_secondary() )
+        .add( "num_accounts", m->get_num_accounts() )
+        .add( "retry_ms", 1e-6*fetch_to_ )
+        .add( "error", m->get_err_msg() )
+        .end();
+      for( unsigned i = 0; i != m->get_num_accounts(); ++i ) {
+        fetch_.push_back( m->get_account_key( i ) );
+      }
+      m->clear_accounts();
+      m->reset_err();
+      fetch_ts_ = curr_ts_ + fetch_to_;
+      fetch_to_ = std::min( 2L * fetch_to_, PC_FETCH_RETRY_MAX );
+      return;
+    }
+    // a node that has not reached the slot of earlier replies is asked
+    // again with the next poll
+    PC_LOG_DBG( "account poll failed" )
+      .add( "secondary", get_is_secondary() )
+      .add( "min_slot", m->get_min_slot() )
+      .add( "error", m->get_err_msg() )
+      .end();
+    poll_.retry( m, curr_ts_ );
+    m->reset_err();
+    return;
+  }
+  // polled data from a slot already seen or unchanged is dropped
+  if ( !pavec_.empty() && !poll_.update( m, curr_ts_ ) && is_poll ) {
+    return;
+  }
+  if ( !is_poll ) {
+    fetch_to_ = PC_FETCH_RETRY_MIN;
+  }
+
+  // dispatch account as the first update of its request
+  acc_map_t::iter_t it = amap_.find( *m->get_account() );
+  if ( it ) {
+    request *rptr = amap_.obj( it );
+    rptr->set_is_recv( true );
+    rptr->on_response( static_cast< rpc::account_update* >( m ) );
+  }
+}
+
 void manager::on_response( rpc::account_update *m )
 {
   if ( m->get_is_err() ) {
@@ -929,6 +3061,27 @@ void manager::on_response( rpc::account_update *m )
   if ( it ) {
     amap_.obj( it )->on_response( m );
   }
+
+  // hand notifications of a sharded network over to the shards
+  if ( num_shard_ > 1U && !get_is_shard() && !m->get_is_http() ) {
+    route_update( m, it != nullptr );
+  }
+}
+
+void manager::route_update( rpc::account_update *m, bool is_all )
+{
+  // accounts we know ourselves such as the mapping go to every shard
+  unsigned shard = is_all ? num_shard_ : get_route( *m->get_account() );
+  if ( shard == num_shard_ && !is_all ) {
+    return;
+  }
+  str txt = m->get_data_text();
+  for( unsigned i = 0; i != num_shard_; ++i ) {
+    if ( shard == num_shard_ || shard == i ) {
+      secv_[i]->add_routed(
+          *m->get_account(), m->get_slot(), m->get_lamports(), txt );
+    }
+  }
 }
 
 void manager::submit( request *req )
@@ -939,7 +3092,11 @@ void manager::submit( request *req )
   req->set_manager( this );
   req->set_rpc_client( &clnt_ );
   req->set_is_submit( true );
-  plist_.add( req );
+  if ( req->get_is_ready() ) {
+    rlist_.add( req );
+  } else {
+    plist_.add( req );
+  }
 }
 
 void manager::submit( net_wtr& msg )
@@ -947,6 +3104,27 @@ void manager::submit( net_wtr& msg )
   tconn_.add_send( msg );
 }
 
+void manager::add_landed( uint64_t pub_slot, uint64_t land_slot )
+{
+  // updates of a batch land together so one report per slot is enough
+  if ( !do_land_ || !do_tx_ || land_slot <= land_slot_ ||
+       !tconn_.get_is_connect() ) {
+    return;
+  }
+  land_slot_ = land_slot;
+  struct PC_PACKED {
+    tx_hdr  hdr_;
+    tx_land land_;
+  } rpt;
+  rpt.hdr_.proto_id_    = PC_TPU_LAND_ID;
+  rpt.hdr_.size_        = sizeof( rpt );
+  rpt.land_.pub_slot_   = pub_slot;
+  rpt.land_.land_slot_  = land_slot;
+  net_wtr msg;
+  msg.add( str( (const char*)&rpt, sizeof( rpt ) ) );
+  tconn_.add_send( msg );
+}
+
 void manager::submit( tx_request *req )
 {
   net_wtr msg;
@@ -1000,13 +3178,23 @@ void manager::on_disconnect()
 
 void manager::add_product( const pub_key&acc )
 {
+  // products of a sharded network are added to their shard only
+  if ( num_shard_ > 1U && get_shard( acc ) != shard_ ) {
+    return;
+  }
   acc_map_t::iter_t it = amap_.find( acc );
   if ( !it ) {
+    if ( fmgr_ ) {
+      fmgr_->add_route( acc, shard_ );
+    }
     // get info for new product account
     product *ptr = new product( acc );
     amap_.ref( amap_.add( acc ) ) = ptr;
     svec_.push_back( ptr );
     submit( ptr );
+    if ( !pavec_.empty() ) {
+      poll_.add_account( acc, false, curr_ts_ );
+    }
     // add mapping subscription count
     add_map_sub();
   }
@@ -1023,10 +3211,16 @@ void manager::add_price( const pub_key&acc, product *prod )
   // find current symbol account (if any)
   acc_map_t::iter_t it = amap_.find( acc );
   if ( !it ) {
+    if ( fmgr_ ) {
+      fmgr_->add_route( acc, shard_ );
+    }
     // get info for new price account
-    price *ptr = new price( acc, prod );
+    price *ptr = new price( acc, prod, &arena_ );
     amap_.ref( amap_.add( acc ) ) = ptr;
     submit( ptr );
+    if ( !pavec_.empty() ) {
+      poll_.add_account( acc, true, curr_ts_ );
+    }
     // add price to product
     prod->add_price( ptr );
     // add mapping subscription count
@@ -1040,6 +3234,21 @@ price *manager::get_price( const pub_key& acc )
   return it ? dynamic_cast<price*>( amap_.obj( it ) ) : nullptr;
 }
 
+const price_arena *manager::get_price_arena() const
+{
+  return &arena_;
+}
+
+price_notify *manager::get_price_notify()
+{
+  return &pnot_;
+}
+
+dash_notify *manager::get_dash_notify()
+{
+  return &dnot_;
+}
+
 void manager::add_dirty_price(price* sptr)
 {
   // Skip this update if we have already attempted to update this price in the current slot.
@@ -1047,9 +3256,7 @@ void manager::add_dirty_price(price* sptr)
     return;
   }
 
-  if( std::find(pending_upds_.begin(), pending_upds_.end(), sptr) == pending_upds_.end() ) {
-    pending_upds_.emplace_back( sptr );
-  }
+  pending_upds_.add( sptr, curr_ts_ );
 }
 
 unsigned manager::get_num_product() const
@@ -1061,3 +3268,209 @@ product *manager::get_product( unsigned i ) const
 {
   return i < svec_.size() ? svec_[i] : nullptr;
 }
+
+void manager::write_metrics( metrics_wtr& mw )
+{
+  // everything here is a counter or a size kept up to date elsewhere
+  // so that a scrape does not hold up the loop
+  mw.add_family( "pyth_slot", "gauge", "latest slot observed" );
+  mw.add_sample( "pyth_slot", slot_ );
+  mw.add_family( "pyth_status", "gauge", "manager status bits" );
+  mw.add_sample( "pyth_status", (int64_t)status_ );
+
+  mw.add_family( "pyth_rpc_rtt_seconds", "summary",
+                 "rpc reply round trip time by method" );
+  std::string lbl;
+  for( unsigned i = 0; i != clnt_.get_num_method(); ++i ) {
+    const rpc_client::method_stats& ms = clnt_.get_method_stats( i );
+    if ( ms.rtt_.get_num() ) {
+      lbl = "method=\"" + ms.method_.as_string() + "\"";
+      mw.add_summary( "pyth_rpc_rtt_seconds", lbl, ms.rtt_ );
+    }
+  }
+  mw.add_family( "pyth_rpc_errors_total", "counter",
+                 "rpc error replies by method and error code" );
+  for( unsigned i = 0; i != clnt_.get_num_method(); ++i ) {
+    const rpc_client::method_stats& ms = clnt_.get_method_stats( i );
+    for( const std::pair<int,uint64_t>& ec: ms.err_ ) {
+      lbl = "method=\"" + ms.method_.as_string() + "\",code=\"" +
+            std::to_string( ec.first ) + "\"";
+      mw.add_sample( "pyth_rpc_errors_total", lbl, ec.second );
+    }
+  }
+  mw.add_family( "pyth_rpc_notifications_total", "counter",
+                 "subscription notifications by subscribe method" );
+  for( unsigned i = 0; i != clnt_.get_num_method(); ++i ) {
+    const rpc_client::method_stats& ms = clnt_.get_method_stats( i );
+    if ( ms.num_ntf_ ) {
+      lbl = "method=\"" + ms.method_.as_string() + "\"";
+      mw.add_sample( "pyth_rpc_notifications_total", lbl, ms.num_ntf_ );
+    }
+  }
+  mw.add_family( "pyth_rpc_notify_gap_seconds", "summary",
+                 "time between subscription notifications" );
+  for( unsigned i = 0; i != clnt_.get_num_method(); ++i ) {
+    const rpc_client::method_stats& ms = clnt_.get_method_stats( i );
+    if ( ms.gap_.get_num() ) {
+      lbl = "method=\"" + ms.method_.as_string() + "\"";
+      mw.add_summary( "pyth_rpc_notify_gap_seconds", lbl, ms.gap_ );
+    }
+  }
+  mw.add_family( "pyth_rpc_inflight", "gauge",
+                 "rpc requests awaiting a reply" );
+  mw.add_sample( "pyth_rpc_inflight", (uint64_t)clnt_.get_num_inflight() );
+
+  // publishing
+  uint64_t qdepth = uq_ ? uq_->size() : 0UL;
+  for( upd_queue *qptr: qvec_ ) {
+    qdepth += qptr->size();
+  }
+  mw.add_family( "pyth_pending_prices", "gauge",
+                 "prices with updates waiting for the next batch" );
+  mw.add_sample( "pyth_pending_prices", (uint64_t)pending_upds_.size() );
+  mw.add_family( "pyth_update_queue_depth", "gauge",
+                 "prices queued by producer threads and primary network" );
+  mw.add_sample( "pyth_update_queue_depth", qdepth );
+  mw.add_family( "pyth_batches_total", "counter", "batches sent" );
+  mw.add_sample( "pyth_batches_total", bat_tot_ );
+  mw.add_family( "pyth_txs_total", "counter",
+                 "upd_price transactions sent" );
+  mw.add_sample( "pyth_txs_total", tx_tot_ );
+  mw.add_family( "pyth_price_updates_total", "counter",
+                 "price updates sent in upd_price transactions" );
+  mw.add_sample( "pyth_price_updates_total", upd_tot_ );
+  mw.add_family( "pyth_tx_acks_total", "counter",
+                 "upd_price transactions acknowledged by sendTransaction" );
+  mw.add_sample( "pyth_tx_acks_total", ack_tot_ );
+  mw.add_family( "pyth_landing_rate", "gauge",
+                 "percent of price updates observed on chain" );
+  mw.add_sample( "pyth_landing_rate", str(), fee_.get_landing_rate() );
+  mw.add_family( "pyth_cu_price", "gauge",
+                 "compute unit price of upd_price transactions" );
+  mw.add_sample( "pyth_cu_price", (uint64_t)fee_.get_cu_price() );
+  if ( !pavec_.empty() ) {
+    mw.add_family( "pyth_account_polls_total", "counter",
+                   "accounts received by polling without ws subscriptions" );
+    mw.add_sample( "pyth_account_polls_total", poll_.get_num_poll() );
+    mw.add_family( "pyth_account_poll_changes_total", "counter",
+                   "polled accounts found changed" );
+    mw.add_sample( "pyth_account_poll_changes_total", poll_.get_num_change() );
+  }
+  if ( ltrk_.get_interval() ) {
+    mw.add_family( "pyth_updates_landed_total", "counter",
+                   "price updates found on chain by signature" );
+    mw.add_sample( "pyth_updates_landed_total", ltrk_.get_num_land() );
+    mw.add_family( "pyth_updates_lost_total", "counter",
+                   "price updates of failed or expired transactions" );
+    mw.add_sample( "pyth_updates_lost_total", ltrk_.get_num_lost() );
+    mw.add_family( "pyth_landing_slots", "gauge",
+                   "mean slots from publish to landing of the last batch" );
+    mw.add_sample( "pyth_landing_slots", str(), ltrk_.get_batch_slots() );
+    static const char *const bnames[] = {
+      "pyth_batch_updates_landed_total", "pyth_batch_updates_lost_total",
+      "pyth_batch_landing_slots_total" };
+    static const char *const bhelp[] = {
+      "price updates found on chain by batch strategy",
+      "price updates of failed or expired transactions by batch strategy",
+      "slots from publish to landing of landed updates by batch strategy" };
+    for( unsigned j = 0; j != 3; ++j ) {
+      mw.add_family( bnames[j], "counter", bhelp[j] );
+      for( unsigned i = 1; i != (unsigned)e_last_batch_strategy; ++i ) {
+        if ( ltrk_.get_group_land( i ) + ltrk_.get_group_lost( i ) ) {
+          str nm = batch_strategy_to_str( (batch_strategy)i );
+          lbl = "strategy=\"" + std::string( nm.str_, nm.len_ ) + "\"";
+          mw.add_sample( bnames[j], lbl, j == 0 ? ltrk_.get_group_land( i ) :
+              ( j == 1 ? ltrk_.get_group_lost( i ) :
+                ltrk_.get_group_slots( i ) ) );
+        }
+      }
+    }
+    static const char *const lnames[] = {
+      "pyth_symbol_landing_rate", "pyth_symbol_landing_slots" };
+    static const char *const lhelp[] = {
+      "percent of tracked price updates that landed",
+      "mean slots from publish to landing" };
+    for( unsigned j = 0; j != 2; ++j ) {
+      mw.add_family( lnames[j], "gauge", lhelp[j] );
+      for( product *prod: svec_ ) {
+        for( unsigned i = 0; i != prod->get_num_price(); ++i ) {
+          price *ptr = prod->get_price( i );
+          if ( ptr->get_num_land() + ptr->get_num_lost() ) {
+            lbl.clear();
+            metrics_wtr::add_label( lbl, "symbol", ptr->get_symbol() );
+            mw.add_sample( lnames[j], lbl, j ?
+                ptr->get_land_slots() : ptr->get_land_rate() );
+          }
+        }
+      }
+    }
+  }
+
+  // users
+  uint64_t nusr = 0UL, nsub = 0UL, wsz = 0UL, max_wsz = 0UL;
+  for( user *uptr = olist_.first(); uptr; uptr = uptr->get_next() ) {
+    size_t sz = uptr->get_send_size();
+    ++nusr;
+    nsub += uptr->get_num_sub();
+    wsz  += sz;
+    max_wsz = std::max( max_wsz, (uint64_t)sz );
+  }
+  mw.add_family( "pyth_users", "gauge", "connected users" );
+  mw.add_sample( "pyth_users", nusr );
+  mw.add_family( "pyth_user_subscriptions", "gauge",
+                 "price subscriptions of connected users" );
+  mw.add_sample( "pyth_user_subscriptions", nsub );
+  mw.add_family( "pyth_user_send_queue_bytes", "gauge",
+                 "bytes queued for sending to users" );
+  mw.add_sample( "pyth_user_send_queue_bytes", wsz );
+  mw.add_family( "pyth_user_send_queue_max_bytes", "gauge",
+                 "largest send queue of a user" );
+  mw.add_sample( "pyth_user_send_queue_max_bytes", max_wsz );
+
+  // capture
+  if ( do_cap_ ) {
+    mw.add_family( "pyth_capture_pending", "gauge",
+                   "capture buffers queued for the capture thread" );
+    mw.add_sample( "pyth_capture_pending",
+                   (uint64_t)cap_.get_num_pending() );
+    mw.add_family( "pyth_capture_dropped_total", "counter",
+                   "capture records dropped" );
+    mw.add_sample( "pyth_capture_dropped_total", cap_.get_num_dropped() );
+    mw.add_family( "pyth_capture_skipped_total", "counter",
+                   "price updates not captured by filter, sampling or pause" );
+    mw.add_sample( "pyth_capture_skipped_total", cflt_.get_num_skip() );
+  }
+
+  // network buffers of this thread
+  mw.add_family( "pyth_net_buf_free", "gauge",
+                 "network buffers cached for reuse by size class" );
+  for( unsigned i = 0; i != net_buf::num_cls; ++i ) {
+    lbl = "class=\"" + std::to_string( net_buf::get_cls_cap( i ) ) + "\"";
+    mw.add_sample( "pyth_net_buf_free", lbl,
+                   (uint64_t)net_buf::get_num_free( i ) );
+  }
+  mw.add_family( "pyth_net_buf_alloc_total", "counter",
+                 "network buffer allocations by size class and source" );
+  for( unsigned i = 0; i != net_buf::num_cls; ++i ) {
+    std::string cls = std::to_string( net_buf::get_cls_cap( i ) );
+    mw.add_sample( "pyth_net_buf_alloc_total",
+                   "class=\"" + cls + "\",source=\"pool\"",
+                   net_buf::get_num_hit( i ) );
+    mw.add_sample( "pyth_net_buf_alloc_total",
+                   "class=\"" + cls + "\",source=\"heap\"",
+                   net_buf::get_num_miss( i ) );
+  }
+}
+
+void manager::get_pub_latency( pub_lat lat, lat_hist& res ) const
+{
+  res.clear();
+  for( product *prod: svec_ ) {
+    for( unsigned i = 0; i != prod->get_num_price(); ++i ) {
+      const lat_hist *hist = prod->get_price( i )->get_latency( lat );
+      if ( hist ) {
+        res.merge( *hist );
+      }
+    }
+  }
+}
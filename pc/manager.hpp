@@ -8,6 +8,22 @@
 #include <pc/dbl_list.hpp>
 #include <pc/hash_map.hpp>
 #include <pc/capture.hpp>
+#include <pc/cap_filter.hpp>
+#include <pc/account_source.hpp>
+#include <pc/tx_pool.hpp>
+#include <pc/prio_fee.hpp>
+#include <pc/land_track.hpp>
+#include <pc/acc_poll.hpp>
+#include <pc/snapshot.hpp>
+#include <pc/handoff.hpp>
+#include <pc/shm_feed.hpp>
+#include <pc/mcast_pub.hpp>
+#include <pc/upd_trace.hpp>
+#include <pc/upd_queue.hpp>
+#include <pc/metrics.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 // status bits
 #define PC_PYTH_RPC_CONNECTED    (1<<0)
@@ -18,6 +34,54 @@ namespace pc
 {
   class manager;
 
+  // composition of the batches of price updates sent per transaction
+  enum batch_strategy
+  {
+    e_batch_unknown = 0,
+    e_batch_fifo,       // arrival order up to the max batch size
+    e_batch_fill,       // arrival order up to the transaction size limit
+    e_batch_stale,      // stalest on chain first up to the size limit
+    e_batch_contend,    // contended prices first in small batches of
+                        // their own and the rest as e_batch_stale
+    e_last_batch_strategy
+  };
+
+  str batch_strategy_to_str( batch_strategy );
+  batch_strategy str_to_batch_strategy( str );
+
+  // fifo of prices with pending updates. a price is queued at most once
+  // until it is removed (tracked by price::get_is_dirty)
+  class price_queue
+  {
+  public:
+    price_queue();
+
+    // add price unless already queued
+    bool add( price *, int64_t ts = 0L );
+
+    // number of queued prices
+    unsigned size() const;
+
+    // time the oldest queued price was added
+    int64_t get_first_ts() const;
+
+    // remove up to n oldest prices into buf. returns number removed
+    unsigned pop( price **buf, unsigned n );
+
+  private:
+    struct entry
+    {
+      price   *ptr_;
+      int64_t  ts_;
+    };
+
+    typedef std::vector<entry> ring_t;
+
+    ring_t   ring_;  // power of two capacity
+    uint64_t hd_;    // next to remove
+    uint64_t tl_;    // next to add
+  };
+
   // manager event notification events
   class manager_sub
   {
@@ -44,6 +108,13 @@ namespace pc
 
     // on new slot for publish
     virtual void on_slot_publish( manager * );
+
+    // once per slot with views of the prices whose aggregate changed in
+    // it (see manager::set_do_price_view). views are valid only for the
+    // duration of the callback. not called for the prices of secondary
+    // managers so that it does not fire at all with shards enabled
+    virtual void on_prices( manager *, const price_view *, unsigned num,
+                            uint64_t slot );
   };
 
   // pyth-client connection management and event loop
@@ -53,6 +124,9 @@ namespace pc
                   public rpc_sub,
                   public rpc_sub_i<rpc::get_slot>,
                   public rpc_sub_i<rpc::get_recent_block_hash>,
+                  public rpc_sub_i<rpc::get_recent_prioritization_fees>,
+                  public rpc_sub_i<rpc::get_signature_statuses>,
+                  public rpc_sub_i<rpc::get_multiple_accounts>,
                   public rpc_sub_i<rpc::account_update>
   {
   public:
@@ -68,14 +142,106 @@ namespace pc
     void set_tx_host( const std::string& );
     std::string get_tx_host() const;
 
-    // turn on/off ws subscriptions
+    // turn on/off ws subscriptions. without them known accounts are
+    // polled with getMultipleAccounts at adaptive intervals
     void set_do_ws( bool );
     bool get_do_ws() const;
 
+    // bounds of the account polling interval in milliseconds without
+    // ws subscriptions (default 400 and 12800)
+    void set_poll_min_interval( int64_t );
+    int64_t get_poll_min_interval() const;
+    void set_poll_max_interval( int64_t );
+    int64_t get_poll_max_interval() const;
+
     // turn on/off tx proxy mode
     void set_do_tx( bool );
     bool get_do_tx() const;
 
+    // report the slots that price updates land in to the tx proxy so
+    // that it can route to the leaders that include them (off by
+    // default - requires a pyth_tx that understands the reports)
+    void set_do_land_report( bool );
+    bool get_do_land_report() const;
+
+    // run the aggregation locally on component updates and notify price
+    // subscribers of the predicted next aggregate (off by default). not
+    // supported with set_do_agg_only
+    void set_do_predict( bool );
+    bool get_do_predict() const;
+
+    // notify manager_sub::on_prices of the prices changed in each slot
+    // (off by default). only prices of this manager are reported which
+    // excludes all of those of a sharded manager (see set_num_shard)
+    void set_do_price_view( bool );
+    bool get_do_price_view() const;
+
+    // sign tx proxy transactions on this many worker threads instead of
+    // the poll loop thread (0 = off, the default)
+    void set_num_sign_threads( unsigned );
+    unsigned get_num_sign_threads() const;
+
+    // transaction signing pool or null if signing on the poll loop
+    tx_pool *get_tx_pool() const;
+
+    // use io_uring for socket polling if supported (off by default)
+    void set_do_uring( bool );
+    bool get_do_uring() const;
+
+    // keep polling without blocking for this many microseconds after the
+    // last socket event before blocking again (0=always block, the default)
+    void set_spin_budget( int64_t usecs );
+    int64_t get_spin_budget() const;
+
+    // SO_BUSY_POLL microseconds on all sockets (0=off, the default)
+    void set_busy_poll( int usecs );
+    int get_busy_poll() const;
+
+    // pin polling thread to cpu during init (-1=no pinning, the default)
+    void set_poll_cpu( int );
+    int get_poll_cpu() const;
+
+    // run polling thread under SCHED_FIFO at this priority (0=default
+    // scheduling, the default)
+    void set_poll_prio( int );
+    int get_poll_prio() const;
+
+    // pin the capture thread, the signing threads and the threads of
+    // secondary networks. signing threads and secondaries take
+    // consecutive cpus from the one given (-1=no pinning, the default)
+    void set_capture_cpu( int );
+    int get_capture_cpu() const;
+    void set_sign_cpu( int );
+    int get_sign_cpu() const;
+    void set_secondary_cpu( int );
+    int get_secondary_cpu() const;
+
+    // lock current and future memory into ram during init (off by default)
+    void set_do_mlock( bool );
+    bool get_do_mlock() const;
+
+    // log wake-to-dispatch and publish latency statistics periodically
+    // (off by default)
+    void set_do_latency( bool );
+    bool get_do_latency() const;
+
+    // negotiate permessage-deflate on rpc and user websockets (off by default)
+    void set_do_ws_deflate( bool );
+    bool get_do_ws_deflate() const;
+
+    // number of rpc http connections (default 1)
+    // with two or more, one is reserved for transaction submission
+    void set_num_http_conn( unsigned );
+    unsigned get_num_http_conn() const;
+
+    // additional rpc provider on the same network. http requests are
+    // hedged across the primary host and the fastest of these
+    void add_hedge_host( const std::string& rpc_host );
+
+    // number of providers each http request is sent to (default 2)
+    void set_hedge_num( unsigned );
+    unsigned get_hedge_num() const;
+
     // server listening port
     void set_listen_port( int port );
     int get_listen_port() const;
@@ -96,6 +262,111 @@ namespace pc
     void set_capture_file( const std::string& cap_file );
     std::string get_capture_file() const;
 
+    // zstd level and worker threads of a .zst capture file without
+    // dictionaries
+    void set_capture_level( int );
+    int get_capture_level() const;
+    void set_capture_threads( unsigned );
+    unsigned get_capture_threads() const;
+
+    // capture changes to accounts with the full account every num
+    // records per account (default 0 - full accounts only)
+    void set_capture_delta( unsigned num );
+    unsigned get_capture_delta() const;
+
+    // start a new capture file every secs seconds or once it reaches
+    // len bytes (default 0 - never)
+    void set_capture_rotate( unsigned secs );
+    unsigned get_capture_rotate() const;
+    void set_capture_rotate_size( uint64_t len );
+    uint64_t get_capture_rotate_size() const;
+
+    // fdatasync capture at most every ms milliseconds (default 0 - never)
+    void set_capture_sync( unsigned ms );
+    unsigned get_capture_sync() const;
+
+    // capture buffers queued before they are dropped (default 0 -
+    // unbounded)
+    void set_capture_max_pending( unsigned num );
+    unsigned get_capture_max_pending() const;
+
+    // prices and their share of updates captured (see cap_filter).
+    // mapping and product accounts are always captured
+    bool add_capture_filter( str term );
+    cap_filter& get_capture_filter();
+
+    // snapshot of mapping, product and price accounts. loaded on init so
+    // that accounts are known as soon as they are requested and saved
+    // periodically and on teardown
+    void set_snapshot_file( const std::string& snap_file );
+    std::string get_snapshot_file() const;
+
+    // unix socket for zero-downtime restarts (see handoff). on init we
+    // take over the listening socket and users of a pythd running with
+    // the same file, then listen on it for our own successor. implies an
+    // account snapshot, by default <handoff_file>.snap
+    void set_handoff_file( const std::string& );
+    std::string get_handoff_file() const;
+
+    // sockets have been handed over to a successor and our outbound
+    // queues drained - time to exit
+    bool get_is_handoff() const;
+
+    // shared-memory price feed (see shm_reader). every price account
+    // update is copied into the slot of its price_arena index
+    void set_shm_file( const std::string& shm_file );
+    std::string get_shm_file() const;
+
+    // multicast group as <ip>:<port> to which the aggregates of prices
+    // changed in a slot are sent when the slot ends (see mcast_pub)
+    void set_mcast_addr( const std::string& );
+    std::string get_mcast_addr() const;
+
+    // multicast time-to-live (default 1 - same subnet)
+    void set_mcast_ttl( int );
+    int get_mcast_ttl() const;
+
+    // chrome trace event file of sampled publisher updates (see
+    // upd_trace) and the sampling of one in num updates (default 100)
+    void set_trace_file( const std::string& trc_file );
+    std::string get_trace_file() const;
+    void set_trace_sample( unsigned num );
+    unsigned get_trace_sample() const;
+
+    // server-side program account filter (all accounts by default)
+    // one program subscription is made per filter
+    void add_program_filter( const rpc::program_filter& );
+
+    // partition products across this many shard managers (default 1 -
+    // no shards). each shard is polled on its own thread with its own
+    // rpc connections and publishes the prices of its products. this
+    // manager then only keeps the mapping, routes user requests to the
+    // shards and is the only one subscribed to the program. it hands
+    // each notification over to the shard owning the account so that
+    // every notification is parsed once and decoded by its shard
+    void set_num_shard( unsigned );
+    unsigned get_num_shard() const;
+
+    // index of the shard owning a product
+    unsigned get_shard( const pub_key& prod ) const;
+
+    // price account updates carry only the header and aggregate price
+    // (components are as of the last full fetch). landing and latency of
+    // our updates and the stale batch order then follow their signature
+    // statuses, queried every 2 slots unless set_sig_status_interval is.
+    // off by default
+    void set_do_agg_only( bool );
+    bool get_do_agg_only() const;
+
+    // stream program account updates from this source instead of rpc
+    // program subscriptions. not owned by the manager
+    void set_account_source( account_source * );
+    account_source *get_account_source() const;
+
+    // zstd dictionary file trained on an account layout (see pyth_dict)
+    // used to decode account data and to compress the capture
+    void add_zstd_dict_file( const std::string& dict_file );
+
     // override default publish interval (in milliseconds)
     void set_publish_interval( int64_t mill_secs );
     int64_t get_publish_interval() const;
@@ -104,14 +375,83 @@ namespace pc
     void set_requested_upd_price_cu_units( unsigned cu_units );
     unsigned get_requested_upd_price_cu_units() const;
 
-    // override the price per CU for upd_price transaction
+    // override the price per CU for upd_price transaction. this is the
+    // lower bound when the price is adaptive
     void set_requested_upd_price_cu_price( unsigned cu_price );
     unsigned get_requested_upd_price_cu_price() const;
 
-    // override the default maximum number of price updates to send in a batch
+    // upper bound on the price per CU for upd_price transactions. when
+    // above the requested price, the price follows recent prioritization
+    // fees and our landing rate (see prio_fee). off (zero) by default
+    void set_max_upd_price_cu_price( unsigned cu_price );
+    unsigned get_max_upd_price_cu_price() const;
+    const prio_fee *get_prio_fee() const;
+
+    // query the status of upd_price transactions every this many slots
+    // to track which land (see land_track). the adaptive price per CU
+    // then follows the tracked landing rate. off (zero) by default
+    void set_sig_status_interval( unsigned slots );
+    unsigned get_sig_status_interval() const;
+    const land_track *get_land_track() const;
+
+    // landing tracker of sent transactions or null if not enabled
+    land_track *get_land_tracker();
+
+    // override the default maximum number of price updates to send in a batch.
+    // only e_batch_fifo is limited by it, the other strategies fill
+    // transactions up to their size limit
     void set_max_batch_size( unsigned batch_size );
     unsigned get_max_batch_size() const;
 
+    // composition of price update batches (default e_batch_fifo).
+    // landing is tracked per strategy (see set_sig_status_interval) so
+    // that strategies can be compared
+    void set_batch_strategy( batch_strategy );
+    batch_strategy get_batch_strategy() const;
+
+    // prices with at least this many publishers are contended and sent
+    // by e_batch_contend in batches of at most num (default 16 and 1)
+    void set_batch_contend_publishers( unsigned num );
+    unsigned get_batch_contend_publishers() const;
+    void set_batch_contend_size( unsigned num );
+    unsigned get_batch_contend_size() const;
+
+    // send partial batches once the current slot is estimated to end
+    // within this many milliseconds (default 100). twice as early in the
+    // last slot of a leader's window
+    void set_flush_lead( int64_t mill_secs );
+    int64_t get_flush_lead() const;
+
+    // send partial batches once the oldest queued update is this many
+    // milliseconds old (default 400)
+    void set_flush_max_age( int64_t mill_secs );
+    int64_t get_flush_max_age() const;
+
+    // user connections with more than this many bytes queued for sending
+    // (default 1MB) have price notifications conflated to the latest
+    // update of each subscription until the queue drains
+    void set_user_send_limit( size_t bytes );
+    size_t get_user_send_limit() const;
+
+    // disconnect users with more than this many bytes queued (default
+    // 64MB) or above the send limit for longer than the slow consumer
+    // timeout in milliseconds (default 30000)
+    void set_user_send_max( size_t bytes );
+    size_t get_user_send_max() const;
+    void set_user_slow_timeout( int64_t mill_secs );
+    int64_t get_user_slow_timeout() const;
+
+    // observed slot duration and estimated time to the end of the current
+    // slot in nanoseconds. zero until slots have been observed
+    int64_t get_slot_duration() const;
+    int64_t get_slot_remain() const;
+
+    // estimated time to the end of the slot at which batches were sent
+    // since the last batch_slot_timing report
+    uint64_t get_num_batch_sent() const;
+    int64_t get_avg_batch_slot_remain() const;
+    int64_t get_min_batch_slot_remain() const;
+
     // event subscription callback
     void set_manager_sub( manager_sub * );
     manager_sub *get_manager_sub() const;
@@ -137,12 +477,44 @@ namespace pc
     // add new price account in product
     void add_price( const pub_key&, product * );
 
+    // publish latency merged over all prices
+    void get_pub_latency( pub_lat, lat_hist& ) const;
+
+    // upd_price transactions (of num_upd price updates) sent and acked
+    void add_tx_sent( unsigned num_upd );
+    void inc_tx_ack();
+
+    // operational metrics in prometheus text format (served as /metrics)
+    void write_metrics( metrics_wtr& );
+
     // iterate through products
     unsigned get_num_product() const;
     product *get_product( unsigned i ) const;
     product *get_product( const pub_key& );
     price   *get_price( const pub_key& );
 
+    // decoded price accounts and aggregates of all symbols
+    const price_arena *get_price_arena() const;
+
+    // shared notify_price body for user subscriptions
+    price_notify *get_price_notify();
+
+    // shared notify_dashboard body for dashboard feed subscriptions
+    dash_notify *get_dash_notify();
+
+    // multicast publisher or null if not enabled
+    const mcast_pub *get_mcast() const;
+
+    // publisher update tracing or null if not enabled
+    upd_trace *get_trace();
+
+    // users with bulk price subscriptions are notified of all prices
+    // changed in a slot once the slot ends
+    void add_bulk_user( user * );
+    void del_bulk_user( user * );
+    unsigned get_num_bulk_user() const;
+    void add_changed_price( price * );
+
     // adds dirty price to pending updates buffer
     void add_dirty_price(price* sptr);
 
@@ -151,6 +523,9 @@ namespace pc
     void submit( net_wtr& );
     void submit( tx_request * );
 
+    // price update sent for pub_slot was first seen on chain in land_slot
+    void add_landed( uint64_t pub_slot, uint64_t land_slot );
+
     // submit pyth client api request and poll until finished
     bool submit_poll( request * );
 
@@ -172,7 +547,8 @@ namespace pc
     // accept new pyth client apps
     void accept( int fd ) override;
 
-    // add secondary network manager
+    // add secondary network manager. each secondary network is polled
+    // on its own thread once initialized and may be added more than once
     void add_secondary( const std::string& rpc_host, const std::string& key_dir );
 
     // shut-down server
@@ -185,6 +561,10 @@ namespace pc
     void del_map_sub();
     void schedule( price_sched* );
     void write( pc_pub_key_t *, pc_acc_t *ptr );
+    void write( price *, pc_pub_key_t *, pc_acc_t *ptr );
+    void write_feed( price * );
+    void init_from_snapshot( request *, const pub_key& );
+    void fetch_account( const pub_key& );
 
     // tx_sub callbacks
     void on_connect() override;
@@ -195,6 +575,9 @@ namespace pc
     // rpc callbacks
     void on_response( rpc::get_slot * ) override;
     void on_response( rpc::get_recent_block_hash * ) override;
+    void on_response( rpc::get_recent_prioritization_fees * ) override;
+    void on_response( rpc::get_signature_statuses * ) override;
+    void on_response( rpc::get_multiple_accounts * ) override;
     void on_response( rpc::account_update * ) override;
     void set_status( int );
     get_mapping *get_last_mapping() const;
@@ -203,7 +586,43 @@ namespace pc
     bool has_secondary() const;
     void set_is_secondary(bool is_secondary);
     bool get_is_secondary() const;
-    manager *get_secondary();
+    unsigned get_num_secondary() const;
+    manager *get_secondary( unsigned i = 0 );
+
+    // shards come first among the secondary managers
+    bool get_is_shard() const;
+
+    // prices updated on the thread of a shard that it notifies users of
+    // from the primary manager's thread. drained with the shard locked
+    void add_notify( price * );
+    void add_notify_predict( price * );
+    void poll_notify();
+
+    // shard owning an account of a sharded network as added by the shard
+    // or num_shard if none. the mapping goes to every shard
+    void add_route( const pub_key& acc, unsigned shard );
+    unsigned get_route( const pub_key& acc );
+
+    // account notification handed over to a shard. decoded on its thread
+    void add_routed( const pub_key& acc, uint64_t slot, uint64_t lamports,
+                     str data );
+
+    // add queue for publishing price updates from another thread. the
+    // producer thread pushes updates keyed by price account and poll()
+    // drains the queue each iteration. updates to a price that has not
+    // been sent yet are conflated to the latest. call before the producer
+    // starts, from the polling thread. owned by the manager
+    upd_queue *add_producer();
+
+    // queue publisher price update for a secondary manager's thread
+    void add_secondary_update( const pub_key& acc, int64_t price,
+                               uint64_t conf, symbol_status st );
+
+    // guards the state of a secondary manager against its thread while
+    // accessing it from the primary manager
+    void lock();
+    void unlock();
+    bool try_lock();
 
   private:
 
@@ -221,40 +640,133 @@ namespace pc
       };
     };
 
+    struct trait_route {
+      static const size_t hsize_ = 8363UL;
+      typedef uint32_t        idx_t;
+      typedef pub_key         key_t;
+      typedef const pub_key&  keyref_t;
+      typedef unsigned        val_t;
+      typedef trait_account::hash_t hash_t;
+    };
+
+    // account notification routed to a shard
+    struct routed_upd {
+      pub_key     acc_;
+      uint64_t    slot_;
+      uint64_t    lamports_;
+      std::string data_;     // as received
+    };
+
     struct tx_parser : public net_parser
     {
       bool parse( const char *buf, size_t sz, size_t& len ) override;
       manager *mgr_;
     };
 
+    struct handoff_accept : public net_accept
+    {
+      void accept( int fd ) override;
+      manager *mgr_;
+    };
+
     typedef dbl_list<user>            user_list_t;
     typedef dbl_list<request>         req_list_t;
     typedef std::vector<get_mapping*> map_vec_t;
     typedef std::vector<product*>     spx_vec_t;
     typedef std::vector<price_sched*> kpx_vec_t;
-    typedef hash_map<trait_account>   acc_map_t;
+    typedef std::vector<kpx_vec_t>    kpx_wheel_t;
+    typedef open_hash_map<trait_account> acc_map_t;
+    typedef open_hash_map<trait_route>   route_map_t;
+    typedef std::vector<routed_upd>      routed_vec_t;
+    typedef std::vector<tcp_connect*> conn_vec_t;
+    typedef std::vector<std::string>  str_vec_t;
+    typedef std::vector<rpc::program_filter>        filt_vec_t;
+    typedef std::vector<manager*>                   mgr_vec_t;
+    typedef std::vector<upd_queue*>                 upq_vec_t;
+    typedef std::vector<user*>                      user_vec_t;
+    typedef std::vector<price*>                     price_vec_t;
+    typedef std::vector<price_view>                 view_vec_t;
+    typedef std::atomic<bool>                       atomic_t;
+    typedef std::vector<rpc::program_subscribe*>    psub_vec_t;
+    typedef std::vector<rpc::get_multiple_accounts*> macc_vec_t;
+    typedef std::vector<pub_key>                    key_vec_t;
+
+    // hedge providers fail and reconnect independently of the primary
+    struct hedge_conn {
+      tcp_connect *cptr_;
+      int64_t      cts_;   // last connect attempt
+      bool         is_up_; // connected
+    };
+
+    typedef std::vector<hedge_conn>   hedge_vec_t;
 
+    bool get_is_http_wait();
+    bool get_is_http_err() const;
     void reconnect_rpc();
     void log_disconnect();
     void teardown_users();
+    user *add_user( int fd );
+    void send_handoff( int fd );
+    void restore_users();
+    void flush_pending_ups();
+    void poll_users();
+    void poll_bulk();
+    void poll_accounts();
     void poll_schedule();
     void reset_status( int );
+    void poll_wait();
+    void log_latency();
+    void poll_hedge();
+    void poll_source();
+    void send_prio_fee();
+    void poll_update();
+    void poll_pending();
+    void poll_queue();
+    void poll_routed();
+    void route_update( rpc::account_update *, bool is_all );
+    void fetch_all();
+    void poll_producer();
+    void save_snapshot();
+    void send_fetch();
+    manager *new_secondary( const std::string& rpc_host,
+                            const std::string& key_dir );
+    void start_secondary();
+    void stop_secondary();
+    static void run_secondary( manager * );
 
     // send a batch of pending price updates. This function eagerly sends any complete batches.
     // It also sends partial batches that have not been completed within a short interval of time.
-    // At most one complete batch will be sent. Additional price updates remain queued until the next
-    // time this function is invoked.
+    // With e_batch_fifo at most one complete batch will be sent and additional price updates
+    // remain queued until the next time this function is invoked. The other strategies compose
+    // batches from, and send, the whole queue.
     void send_pending_ups();
+    void send_batch( price **, unsigned n );
+    unsigned get_batch_limit() const;
+    int64_t get_slot_remain( int64_t ts ) const;
+    void log_batch_timing();
 
-    net_loop     nl_;       // epoll loop
+    net_loop     nl_;       // epoll or io_uring loop
     tcp_connect  hconn_;    // rpc http connection
+    conn_vec_t   hpool_;    // additional rpc http connections
+    unsigned     num_hconn_;// number of rpc http connections
+    str_vec_t    ghost_;    // hedge rpc hosts
+    hedge_vec_t  gpool_;    // hedge rpc http connections
+    unsigned     hnum_;     // providers per hedged request
+    int64_t      gts_;      // last hedge stats log time
+    account_source *asrc_;  // streaming account update source
+    int64_t      ats_;      // last account source connect attempt
+    bool         is_aup_;   // account source connected
     ws_connect  *wconn_;    // rpc websocket sonnection
     tcp_listen   lsvr_;     // listening socket
     rpc_client   clnt_;     // rpc api
     tx_connect   tconn_;    // tx proxy connection
+    tx_pool     *tpool_;    // transaction signing threads
+    unsigned     num_sthr_; // number of signing threads
     user_list_t  olist_;    // open users list
     user_list_t  dlist_;    // to-be-deleted users list
-    req_list_t   plist_;    // pending requests
+    req_list_t   plist_;    // pending requests waiting on status
+    req_list_t   rlist_;    // pending requests ready to submit
+    int          pst_;      // status pending requests were checked at
     map_vec_t    mvec_;     // mapping account updates
     acc_map_t    amap_;     // account to symbol pricing info
     spx_vec_t    svec_;     // symbol price subscriber/publishers
@@ -264,42 +776,135 @@ namespace pc
     manager_sub *sub_;      // subscription callback
     int          status_;   // status bitmap
     int          num_sub_;  // number of in-flight mapping subscriptions
-    uint32_t     kidx_;     // schedule index
+    uint32_t     kidx_;     // schedule wheel index
     int64_t      cts_;      // (re)connect timestamp
     int64_t      ctimeout_; // connection timeout
     uint64_t     slot_;     // current slot
     uint64_t     slot_cnt_; // slot count
     int64_t      slot_ts_;  // current slot time
+    int64_t      slot_start_;// estimated start time of current slot
+    int64_t      slot_dur_; // observed slot duration
     int64_t      curr_ts_;  // current time
     int64_t      pub_ts_;   // start publish time
     int64_t      pub_int_;  // publish interval
-    kpx_vec_t    kvec_;     // symbol price scheduling
+    int64_t      spin_ns_;  // spin budget
+    int64_t      spin_ts_;  // last socket event time
+    int64_t      lat_ts_;   // last latency log time
+    uint64_t     cap_drop_; // capture records dropped when last logged
+    uint64_t     land_slot_;// last landing slot reported
+    int          poll_cpu_; // cpu to pin polling thread
+    int          poll_pri_; // real-time priority of polling thread
+    int          sign_cpu_; // first cpu of signing threads
+    int          sec_cpu_;  // first cpu of secondary network threads
+    bool         do_mlock_; // lock memory into ram
+    kpx_wheel_t  kwhl_;     // symbol price scheduling by hash offset
     bool         wait_conn_;// waiting on connection
     bool         do_cap_;   // do capture flag
+    bool         do_snap_;  // do account snapshot
+    bool         do_shm_;   // do shared-memory price feed
+    bool         do_mcast_; // do multicast price feed
+    bool         do_trc_;   // do publisher update tracing
     bool         do_ws_;    // do ws subscriptions
     bool         do_tx_;    // do tx proxy connectivity
+    bool         do_land_;  // do landing reports to tx proxy
+    bool         do_pred_;  // do aggregate prediction
+    bool         do_pview_; // do bulk price view callback
+    bool         do_wsz_;   // do websocket permessage-deflate
+    bool         do_agg_;   // aggregate-only price updates
     bool         is_pub_;   // is publishing mode
     capture      cap_;      // aggregate price capture
+    cap_filter   cflt_;     // prices captured
+    snapshot     snap_;     // account snapshot
+    price_arena  arena_;    // price account storage
+    shm_feed     shm_;      // shared-memory price feed
+    mcast_pub    mcast_;    // multicast price feed
+    upd_trace    trc_;      // publisher update tracing
+    price_notify pnot_;     // shared price notifications
+    dash_notify  dnot_;     // shared dashboard feed deltas
+    int64_t      snap_ts_;  // last snapshot save time
+    zstd_dict    zdict_;    // account zstd dictionaries
+    str_vec_t    zfile_;    // account zstd dictionary files
     tx_parser    txp_;      // handle unexpected errors
     commitment   cmt_;      // account get/subscribe commitment
     unsigned     max_batch_;// maximum number of price updates that can be sent in a single batch
+    batch_strategy bstrat_; // batch composition
+    unsigned     bhot_pub_; // publishers of a contended price
+    unsigned     bhot_num_; // updates per batch of contended prices
     unsigned     requested_upd_price_cu_units_; // amount of requested CU units per upd_price transaction
-    unsigned     requested_upd_price_cu_price_; // price per CU for upd_price transaction
+    prio_fee     fee_;      // price per CU for upd_price transaction
+    land_track   ltrk_;     // landing of sent upd_price transactions
+    acc_poll     poll_;     // account polling schedule without ws
+    int64_t      poll_ts_;  // last account poll
 
     // requests
     rpc::get_slot              sreq_[1]; // slot subscription
     rpc::get_recent_block_hash breq_[1]; // block hash request
-    rpc::program_subscribe     preq_[1]; // program account subscription
-    rpc::get_program_accounts  areq_[1]; // alternative to program_subscribe
+    rpc::get_recent_prioritization_fees freq_[1]; // priority fee request
+    rpc::get_signature_statuses qreq_[1]; // landing status request
+    psub_vec_t   pvec_;     // program account subscriptions
+    macc_vec_t   pavec_;    // account polls instead of subscriptions
+    macc_vec_t   favec_;    // batched account requests
+    key_vec_t    fetch_;    // accounts waiting on a batched request
+    int64_t      fetch_ts_; // batched requests wait until then to retry
+    int64_t      fetch_to_; // backoff of the next failed batched request
+    filt_vec_t   fvec_;     // program account filters
 
     // price updates that have not been sent yet
-    std::vector<price*> pending_upds_;
-
-    // Timestamp of the last batch
-    int64_t last_upd_ts_= 0;
-
-    manager    *secondary_;   // manager for secondary network
-    bool       is_secondary_; // flag tracking whether we are a secondary manager
+    price_queue         pending_upds_;
+    std::vector<price*> send_upds_;
+
+    // partial batch flush policy and send timing relative to slot end
+    int64_t  flush_lead_;  // flush ahead of slot end
+    int64_t  flush_age_;   // flush oldest update at this age
+    uint64_t bat_num_;     // batches sent since last report
+    int64_t  bat_rem_;     // sum of time to slot end at send
+    int64_t  bat_min_;     // min time to slot end at send
+    int64_t  bat_ts_;      // last batch timing log time
+    uint64_t bat_tot_;     // batches sent
+    uint64_t tx_tot_;      // upd_price transactions sent
+    uint64_t upd_tot_;     // price updates sent
+    uint64_t ack_tot_;     // upd_price transactions acked
+
+    // user send queue limits
+    size_t   usnd_lim_;    // conflate notifications above this
+    size_t   usnd_max_;    // disconnect above this
+    int64_t  uslow_to_;    // disconnect above limit for this long
+    int64_t  usr_ts_;      // last user send queue log time
+
+    // zero-downtime restart
+    handoff        hoff_;    // successor listener and sockets taken over
+    handoff_accept hacc_;    // successor acceptor
+    bool           do_hoff_; // do handoff
+    bool           is_hoff_; // sockets handed over to successor
+    int64_t        hoff_ts_; // time of handoff
+
+    // prices changed since last bulk subscription notification
+    user_vec_t   busr_;    // users with bulk subscriptions
+    price_vec_t  chg_;     // changed prices (may repeat)
+    view_vec_t   chgv_;    // views of changed prices
+    uint64_t     chg_slot_;// slot of first change
+    int64_t      chg_ts_;  // time of first change
+
+    mgr_vec_t   secv_;         // managers for secondary networks
+    bool        is_secondary_; // flag tracking whether we are a secondary manager
+    upd_queue  *uq_;           // publisher updates for secondary network
+    upq_vec_t   qvec_;         // publisher updates from producer threads
+    std::mutex  mtx_;          // secondary network state
+    std::thread thrd_;         // secondary network thread
+    atomic_t    is_run_;
+
+    // product partition
+    unsigned    num_shard_;    // number of shards of the network
+    unsigned    shard_;        // index of our shard or num_shard_
+    price_vec_t ntf_;          // aggregates to notify users of
+    price_vec_t pntf_;         // predictions to notify users of
+    manager    *fmgr_;         // front end of our shard
+    route_map_t rmap_;         // shard by account of the front end
+    std::mutex  rmtx_;         // routes or routed updates
+    routed_vec_t rtv_;         // updates routed to us and their number
+    routed_vec_t rtw_;         // updates being dispatched
+    size_t      nrt_;
+    atomic_t    is_refetch_;   // front end resubscribed
   };
 
   inline bool manager::get_is_tx_connect() const
@@ -310,8 +915,54 @@ namespace pc
   inline void manager::write( pc_pub_key_t *key, pc_acc_t *ptr )
   {
     if ( do_cap_ ) {
+      // product attributes may change which prices are captured
+      if ( ptr->type_ == PC_ACCTYPE_PRODUCT ) {
+        cflt_.reset();
+      }
+      cap_.write( key, ptr );
+    }
+    if ( do_snap_ ) {
+      snap_.add( key, ptr );
+    }
+  }
+
+  inline void manager::write( price *pptr, pc_pub_key_t *key, pc_acc_t *ptr )
+  {
+    if ( do_cap_ && cflt_.get_is_capture( pptr ) ) {
       cap_.write( key, ptr );
     }
+    if ( do_snap_ ) {
+      snap_.add( key, ptr );
+    }
+  }
+
+  inline upd_trace *manager::get_trace()
+  {
+    return do_trc_ ? &trc_ : nullptr;
+  }
+
+  inline land_track *manager::get_land_tracker()
+  {
+    return ltrk_.get_interval() ? &ltrk_ : nullptr;
+  }
+
+  inline void manager::add_tx_sent( unsigned num_upd )
+  {
+    ++tx_tot_;
+    upd_tot_ += num_upd;
+  }
+
+  inline void manager::inc_tx_ack()
+  {
+    ++ack_tot_;
+  }
+
+  inline void manager::write_feed( price *ptr )
+  {
+    if ( do_shm_ ) {
+      unsigned idx = ptr->get_arena_index();
+      shm_.update( idx, *ptr->get_account(), arena_.get_account( idx ) );
+    }
   }
 
 }
@@ -0,0 +1,153 @@
+#include "mcast_pub.hpp"
+#include "misc.hpp"
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <errno.h>
+
+#define PC_MCAST_HEARTBEAT PC_NSECS_IN_SEC
+
+using namespace pc;
+
+mcast_pub::mcast_pub()
+: ttl_( 1 ),
+  hist_( 4096U ),
+  seq_( 0UL ),
+  pseq_( 0UL ),
+  ts_( 0L )
+{
+  __builtin_memset( hb_, 0, sizeof( hb_ ) );
+}
+
+void mcast_pub::set_addr( const std::string& addr )
+{
+  addr_ = addr;
+}
+
+std::string mcast_pub::get_addr() const
+{
+  return addr_;
+}
+
+void mcast_pub::set_ttl( int ttl )
+{
+  ttl_ = ttl;
+}
+
+int mcast_pub::get_ttl() const
+{
+  return ttl_;
+}
+
+void mcast_pub::set_hist( unsigned hist )
+{
+  hist_ = hist ? hist : 1U;
+}
+
+unsigned mcast_pub::get_hist() const
+{
+  return hist_;
+}
+
+bool mcast_pub::init()
+{
+  gaddr_ = ip_addr( str( addr_ ) );
+  const sockaddr_in *sptr = (const sockaddr_in*)gaddr_.buf_;
+  if ( sptr->sin_port == 0 ) {
+    return set_err_msg( "invalid multicast address=" + addr_ );
+  }
+  if ( !sock_.init() ) {
+    return set_err_msg( sock_.get_err_msg() );
+  }
+  if ( 0 > ::setsockopt( sock_.get_fd(), IPPROTO_IP, IP_MULTICAST_TTL,
+                         &ttl_, sizeof( ttl_ ) ) ) {
+    return set_err_msg( "failed to set multicast ttl", errno );
+  }
+  buf_.assign( hist_ * mcast_max_pkt, '\0' );
+  hb_->magic_ = mcast_magic;
+  hb_->ver_   = mcast_version;
+  return true;
+}
+
+uint64_t mcast_pub::get_seq() const
+{
+  return seq_;
+}
+
+const mcast_hdr *mcast_pub::get_packet( uint64_t seq ) const
+{
+  if ( seq == 0UL || seq > seq_ || seq_ - seq >= hist_ ) {
+    return nullptr;
+  }
+  return (const mcast_hdr*)&buf_[( seq % hist_ ) * mcast_max_pkt];
+}
+
+void mcast_pub::get_rec( price *ptr, mcast_rec& rec )
+{
+  __builtin_memcpy( &rec.acc_, ptr->get_account()->data(),
+                    sizeof( pc_pub_key_t ) );
+  rec.price_      = ptr->get_price();
+  rec.conf_       = ptr->get_conf();
+  rec.twap_       = ptr->get_twap();
+  rec.twac_       = ptr->get_twac();
+  rec.valid_slot_ = ptr->get_valid_slot();
+  rec.pub_slot_   = ptr->get_pub_slot();
+  rec.status_     = static_cast< uint32_t >( ptr->get_status() );
+  rec.num_qt_     = ptr->get_num_qt();
+}
+
+mcast_hdr *mcast_pub::add_packet( uint64_t slot )
+{
+  mcast_hdr *hdr = (mcast_hdr*)&buf_[( ++seq_ % hist_ ) * mcast_max_pkt];
+  hdr->magic_ = mcast_magic;
+  hdr->ver_   = mcast_version;
+  hdr->num_   = 0;
+  hdr->flags_ = 0;
+  hdr->seq_   = seq_;
+  hdr->slot_  = slot;
+  return hdr;
+}
+
+void mcast_pub::send( mcast_hdr *hdr )
+{
+  sock_.add_send( &gaddr_, (const char*)hdr,
+                  sizeof( mcast_hdr ) + hdr->num_ * sizeof( mcast_rec ) );
+}
+
+void mcast_pub::publish( const std::vector<price*>& pvec, uint64_t slot )
+{
+  if ( pvec.empty() ) {
+    return;
+  }
+  mcast_hdr *hdr = nullptr;
+  for( price *ptr: pvec ) {
+    if ( !hdr || hdr->num_ == mcast_max_rec ) {
+      if ( hdr ) {
+        send( hdr );
+      }
+      hdr = add_packet( slot );
+    }
+    get_rec( ptr, ((mcast_rec*)&hdr[1])[hdr->num_++] );
+  }
+  hdr->flags_ = mcast_flag_last;
+  send( hdr );
+  sock_.flush();
+  hb_->seq_  = seq_;
+  hb_->slot_ = slot;
+}
+
+void mcast_pub::poll( int64_t ts )
+{
+  // heartbeats only follow a second without packets
+  if ( seq_ != pseq_ ) {
+    pseq_ = seq_;
+    ts_ = ts;
+    return;
+  }
+  if ( ts - ts_ < PC_MCAST_HEARTBEAT ) {
+    return;
+  }
+  ts_ = ts;
+  if ( sock_.get_fd() >= 0 ) {
+    sock_.send( &gaddr_, (const char*)hb_, sizeof( mcast_hdr ) );
+  }
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <pc/error.hpp>
+#include <pc/net_socket.hpp>
+#include <pc/request.hpp>
+#include <vector>
+
+namespace pc
+{
+
+  // multicast distribution of aggregate prices. each datagram is an
+  // mcast_hdr followed by num_ mcast_rec records in host byte order.
+  // every data packet carries the next sequence number; consumers that
+  // see a gap recover the missing packets with the mcast_retransmit
+  // websocket request or start over from mcast_snapshot. an empty
+  // heartbeat packet repeating the last sequence number is sent when
+  // there are no updates so that a lost trailing packet is detected
+  struct PC_PACKED mcast_hdr
+  {
+    uint32_t     magic_;  // mcast_magic
+    uint16_t     ver_;    // mcast_version
+    uint8_t      num_;    // number of records
+    uint8_t      flags_;  // mcast_flag_last on last packet of slot
+    uint64_t     seq_;    // packet sequence number
+    uint64_t     slot_;   // slot of aggregate updates
+  };
+
+  struct PC_PACKED mcast_rec
+  {
+    pc_pub_key_t acc_;    // price account
+    int64_t      price_;
+    uint64_t     conf_;
+    int64_t      twap_;
+    uint64_t     twac_;
+    uint64_t     valid_slot_;
+    uint64_t     pub_slot_;
+    uint32_t     status_; // symbol_status
+    uint32_t     num_qt_;
+  };
+
+  static const uint32_t mcast_magic     = 0x70637963; // "cycp"
+  static const uint16_t mcast_version   = 1;
+  static const uint8_t  mcast_flag_last = 0x1;
+  static const size_t   mcast_max_pkt   = 1472;
+  static const unsigned mcast_max_rec   =
+    ( mcast_max_pkt - sizeof( mcast_hdr ) ) / sizeof( mcast_rec );
+
+  static_assert( sizeof( mcast_hdr ) == 24, "unexpected mcast_hdr size" );
+  static_assert( sizeof( mcast_rec ) == 88, "unexpected mcast_rec size" );
+
+  // multicast publisher of changed aggregates. the latest packets are
+  // kept for retransmission to consumers that lost them
+  class mcast_pub : public error
+  {
+  public:
+
+    mcast_pub();
+
+    // multicast group as <ip>:<port>
+    void set_addr( const std::string& );
+    std::string get_addr() const;
+
+    // multicast time-to-live (default 1)
+    void set_ttl( int );
+    int get_ttl() const;
+
+    // number of packets kept for retransmission (default 4096)
+    void set_hist( unsigned );
+    unsigned get_hist() const;
+
+    // open multicast socket
+    bool init();
+
+    // send the aggregates of prices updated in slot
+    void publish( const std::vector<price*>&, uint64_t slot );
+
+    // send heartbeat if nothing was sent in the last second
+    void poll( int64_t ts );
+
+    // sequence number of last packet sent (0 before the first)
+    uint64_t get_seq() const;
+
+    // packet with sequence number or null if no longer kept
+    const mcast_hdr *get_packet( uint64_t seq ) const;
+
+    // records of packet
+    static const mcast_rec *get_recs( const mcast_hdr * );
+
+    // copy aggregate of price into record
+    static void get_rec( price *, mcast_rec& );
+
+  private:
+
+    mcast_hdr *add_packet( uint64_t slot );
+    void send( mcast_hdr * );
+
+    std::string       addr_;
+    int               ttl_;
+    unsigned          hist_;
+    uint64_t          seq_;
+    uint64_t          pseq_;  // sequence number at last poll
+    int64_t           ts_;    // time of last packet
+    ip_addr           gaddr_;
+    udp_socket        sock_;
+    std::vector<char> buf_;   // last hist_ packets by sequence number
+    mcast_hdr         hb_[1]; // heartbeat packet
+  };
+
+  inline const mcast_rec *mcast_pub::get_recs( const mcast_hdr *hdr )
+  {
+    return (const mcast_rec*)&hdr[1];
+  }
+
+}
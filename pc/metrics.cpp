@@ -0,0 +1,131 @@
+#include "metrics.hpp"
+#include "misc.hpp"
+#include <stdio.h>
+
+using namespace pc;
+
+void metrics_wtr::add_family( str name, str type, str help )
+{
+  add( "# HELP " );
+  add( name );
+  add( ' ' );
+  add_help( help );
+  add( "\n# TYPE " );
+  add( name );
+  add( ' ' );
+  add( type );
+  add( '\n' );
+}
+
+void metrics_wtr::add_help( str help )
+{
+  for( size_t i = 0; i != help.len_; ++i ) {
+    char c = help.str_[i];
+    if ( c == '\\' ) {
+      add( "\\\\" );
+    } else if ( c == '\n' ) {
+      add( "\\n" );
+    } else {
+      add( c );
+    }
+  }
+}
+
+void metrics_wtr::add_label( std::string& labels, str name, str val )
+{
+  if ( !labels.empty() ) {
+    labels += ',';
+  }
+  labels.append( name.str_, name.len_ );
+  labels += "=\"";
+  for( size_t i = 0; i != val.len_; ++i ) {
+    char c = val.str_[i];
+    if ( c == '\\' || c == '"' ) {
+      labels += '\\';
+      labels += c;
+    } else if ( c == '\n' ) {
+      labels += "\\n";
+    } else {
+      labels += c;
+    }
+  }
+  labels += '"';
+}
+
+void metrics_wtr::add_name( str name, str labels )
+{
+  add( name );
+  if ( labels.len_ ) {
+    add( '{' );
+    add( labels );
+    add( '}' );
+  }
+  add( ' ' );
+}
+
+void metrics_wtr::add_double( double val )
+{
+  char *buf = reserve( 32 );
+  int len = snprintf( buf, 32, "%.9g", val );
+  advance( static_cast< size_t >( len ) );
+}
+
+void metrics_wtr::add_sample( str name, str labels, double val )
+{
+  add_name( name, labels );
+  add_double( val );
+  add( '\n' );
+}
+
+void metrics_wtr::add_sample( str name, str labels, int64_t val )
+{
+  add_name( name, labels );
+  if ( val < 0L ) {
+    add( '-' );
+  }
+  uint64_t uval = val < 0L ? 0UL - static_cast< uint64_t >( val )
+                           : static_cast< uint64_t >( val );
+  size_t len = uint_len( uval );
+  char *buf = reserve( len );
+  uint_to_str( uval, &buf[len] );
+  advance( len );
+  add( '\n' );
+}
+
+void metrics_wtr::add_sample( str name, str labels, uint64_t val )
+{
+  add_name( name, labels );
+  size_t len = uint_len( val );
+  char *buf = reserve( len );
+  uint_to_str( val, &buf[len] );
+  advance( len );
+  add( '\n' );
+}
+
+void metrics_wtr::add_sample( str name, int64_t val )
+{
+  add_sample( name, str(), val );
+}
+
+void metrics_wtr::add_sample( str name, uint64_t val )
+{
+  add_sample( name, str(), val );
+}
+
+void metrics_wtr::add_summary( str name, str labels, const lat_hist& h )
+{
+  static const char *qtxt[] = { "0.5", "0.9", "0.99", "0.999" };
+  static const double qval[] = { .5, .9, .99, .999 };
+  std::string lbl;
+  for( unsigned i = 0; i != 4; ++i ) {
+    lbl.assign( labels.str_, labels.len_ );
+    lbl += labels.len_ ? ",quantile=\"" : "quantile=\"";
+    lbl += qtxt[i];
+    lbl += '"';
+    add_sample( name, lbl, 1e-9 * (double)h.get_quantile( qval[i] ) );
+  }
+  std::string sum = name.as_string() + "_sum";
+  std::string cnt = name.as_string() + "_count";
+  add_sample( sum, labels, 1e-9 * (double)h.get_sum() );
+  add_sample( cnt, labels, h.get_num() );
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <pc/net_socket.hpp>
+#include <pc/pub_stats.hpp>
+#include <string>
+
+namespace pc
+{
+
+  // prometheus text exposition format writer. each metric family is
+  // declared with add_family followed by its samples. labels are
+  // given preformatted as name="value" pairs separated by commas.
+  // values not known to be plain text are appended with add_label
+  class metrics_wtr : public net_wtr
+  {
+  public:
+
+    // family of type counter, gauge or summary. backslashes and line
+    // feeds in help are escaped
+    void add_family( str name, str type, str help );
+
+    // append name="val" to labels escaping backslashes, double quotes
+    // and line feeds in val
+    static void add_label( std::string& labels, str name, str val );
+
+    // sample of family
+    void add_sample( str name, str labels, double val );
+    void add_sample( str name, str labels, int64_t val );
+    void add_sample( str name, str labels, uint64_t val );
+    void add_sample( str name, int64_t val );
+    void add_sample( str name, uint64_t val );
+
+    // summary of latency histogram in seconds with p50, p90, p99 and
+    // p999 quantiles
+    void add_summary( str name, str labels, const lat_hist& );
+
+  private:
+    void add_help( str );
+    void add_name( str name, str labels );
+    void add_double( double );
+  };
+
+}
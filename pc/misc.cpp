@@ -2,8 +2,18 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <errno.h>
+#include <sched.h>
 #include <time.h>
 
+#if defined( __x86_64__ )
+#include <immintrin.h>
+#elif defined( __aarch64__ ) && defined( __ARM_NEON )
+#include <arm_neon.h>
+#endif
+
+#define PC_B58_R 656356768UL  // 58^5
+
 namespace pc
 {
 
@@ -104,19 +114,226 @@ int dec_base58( const uint8_t *str, int len, uint8_t *result)
   return resultlen;
 }
 
-char *uint_to_str( uint64_t val, char *cptr )
+// fixed-length codecs convert between 32-bit binary limbs and limbs of
+// five base58 digits using tables of the weight of each limb in the
+// other base instead of a digit at a time
+template<unsigned NB, unsigned NI>
+struct b58_table
+{
+  uint32_t enc_[NB][NI];  // 2^(32*(NB-1-i)) in base 58^5
+  uint32_t dec_[NI][NB];  // 58^(5*(NI-1-k)) in base 2^32
+};
+
+template<unsigned NB, unsigned NI>
+constexpr b58_table<NB,NI> b58_make()
+{
+  b58_table<NB,NI> t{};
+  for( unsigned i = 0; i != NB; ++i ) {
+    uint64_t v[NI] = {};
+    v[NI-1] = 1UL;
+    for( unsigned s = 0; s != 2*(NB-1-i); ++s ) {
+      uint64_t carry = 0UL;
+      for( unsigned j = NI; j-- != 0; ) {
+        uint64_t x = ( v[j] << 16 ) + carry;
+        v[j]  = x % PC_B58_R;
+        carry = x / PC_B58_R;
+      }
+    }
+    for( unsigned j = 0; j != NI; ++j ) {
+      t.enc_[i][j] = static_cast< uint32_t >( v[j] );
+    }
+  }
+  for( unsigned k = 0; k != NI; ++k ) {
+    uint64_t v[NB] = {};
+    v[NB-1] = 1UL;
+    for( unsigned s = 0; s != NI-1-k; ++s ) {
+      uint64_t carry = 0UL;
+      for( unsigned i = NB; i-- != 0; ) {
+        uint64_t x = v[i] * PC_B58_R + carry;
+        v[i]  = x & 0xffffffffUL;
+        carry = x >> 32;
+      }
+    }
+    for( unsigned i = 0; i != NB; ++i ) {
+      t.dec_[k][i] = static_cast< uint32_t >( v[i] );
+    }
+  }
+  return t;
+}
+
+// 32 bytes are at most 44 base58 digits and 64 bytes at most 88
+static constexpr b58_table<8,9>   b58_tab32 = b58_make<8,9>();
+static constexpr b58_table<16,18> b58_tab64 = b58_make<16,18>();
+
+template<unsigned NB, unsigned NI>
+static int enc_base58_fixed(
+    const b58_table<NB,NI>& t, const uint8_t *src, char *result )
+{
+  static const unsigned nbytes = 4*NB;
+  static const unsigned nraw   = 5*NI;
+  unsigned zeros = 0;
+  while( zeros != nbytes && !src[zeros] ) {
+    ++zeros;
+  }
+
+  // sums of up to four products of a limb and a table entry fit in 64
+  // bits so carry into the next limb every four rows
+  uint64_t in[NI] = {};
+  for( unsigned i = 0; i != NB; ++i ) {
+    const uint8_t *p = &src[4*i];
+    uint64_t b = ( (uint64_t)p[0] << 24 ) | ( (uint64_t)p[1] << 16 ) |
+                 ( (uint64_t)p[2] << 8 ) | (uint64_t)p[3];
+    for( unsigned j = 0; j != NI; ++j ) {
+      in[j] += b * t.enc_[i][j];
+    }
+    if ( ( i & 3U ) == 3U ) {
+      for( unsigned j = NI - 1; j != 0; --j ) {
+        in[j-1] += in[j] / PC_B58_R;
+        in[j]   %= PC_B58_R;
+      }
+    }
+  }
+
+  // leading zero digits beyond those of the leading zero bytes are dropped
+  uint8_t raw[nraw];
+  for( unsigned j = 0; j != NI; ++j ) {
+    uint64_t v = in[j];
+    for( unsigned d = 5; d-- != 0; ) {
+      raw[5*j+d] = static_cast< uint8_t >( v % 58UL );
+      v /= 58UL;
+    }
+  }
+  unsigned skip = 0;
+  while( skip != nraw && !raw[skip] ) {
+    ++skip;
+  }
+  skip -= zeros;
+  unsigned len = nraw - skip;
+  for( unsigned i = 0; i != len; ++i ) {
+    result[i] = ALPHABET[raw[skip+i]];
+  }
+  result[len] = 0;
+  return static_cast< int >( len );
+}
+
+template<unsigned NB, unsigned NI>
+static int dec_base58_fixed(
+    const b58_table<NB,NI>& t, const uint8_t *str, int len, uint8_t *result )
 {
-  if ( val ) {
-    while( val ) {
-      *--cptr = '0' + (val%10L);
-      val /= 10L;
+  static const unsigned nbytes = 4*NB;
+  static const unsigned nraw   = 5*NI;
+  static const int max_len = NB == 8 ? 44 : 88;
+  if ( PC_UNLIKELY( len < 0 || len > max_len ) ) {
+    return -1;
+  }
+
+  // right-align digits in groups of five
+  uint8_t raw[nraw] = {};
+  unsigned pad = nraw - static_cast< unsigned >( len );
+  for( unsigned i = 0; i != static_cast< unsigned >( len ); ++i ) {
+    char d = ALPHABET_MAP[str[i]];
+    if ( PC_UNLIKELY( d < 0 ) ) {
+      return -1;
     }
+    raw[pad+i] = static_cast< uint8_t >( d );
+  }
+  uint64_t bin[NB] = {};
+  for( unsigned k = 0; k != NI; ++k ) {
+    const uint8_t *p = &raw[5*k];
+    uint64_t v = (((( (uint64_t)p[0] * 58UL + p[1] ) * 58UL + p[2] ) * 58UL +
+                   p[3] ) * 58UL ) + p[4];
+    for( unsigned i = 0; i != NB; ++i ) {
+      bin[i] += v * t.dec_[k][i];
+    }
+    if ( ( k & 3U ) == 3U || k == NI - 1 ) {
+      for( unsigned i = NB - 1; i != 0; --i ) {
+        bin[i-1] += bin[i] >> 32;
+        bin[i]   &= 0xffffffffUL;
+      }
+    }
+  }
+  if ( PC_UNLIKELY( bin[0] > 0xffffffffUL ) ) {
+    return -1;
+  }
+
+  // each leading '1' is a leading zero byte and no other byte can be
+  for( unsigned i = 0; i != NB; ++i ) {
+    uint8_t *p = &result[4*i];
+    p[0] = static_cast< uint8_t >( bin[i] >> 24 );
+    p[1] = static_cast< uint8_t >( bin[i] >> 16 );
+    p[2] = static_cast< uint8_t >( bin[i] >> 8 );
+    p[3] = static_cast< uint8_t >( bin[i] );
+  }
+  unsigned ones = 0, zeros = 0;
+  while( ones != static_cast< unsigned >( len ) && str[ones] == '1' ) {
+    ++ones;
+  }
+  while( zeros != nbytes && !result[zeros] ) {
+    ++zeros;
+  }
+  return ones == zeros ? static_cast< int >( nbytes ) : -1;
+}
+
+int enc_base58_32( const uint8_t *src, char *result )
+{
+  return enc_base58_fixed( b58_tab32, src, result );
+}
+
+int enc_base58_64( const uint8_t *src, char *result )
+{
+  return enc_base58_fixed( b58_tab64, src, result );
+}
+
+int dec_base58_32( const uint8_t *str, int len, uint8_t *result )
+{
+  return dec_base58_fixed( b58_tab32, str, len, result );
+}
+
+int dec_base58_64( const uint8_t *str, int len, uint8_t *result )
+{
+  return dec_base58_fixed( b58_tab64, str, len, result );
+}
+
+// two decimal digits at a time
+static const char digit_pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+char *uint_to_str( uint64_t val, char *cptr )
+{
+  while( val >= 100UL ) {
+    const char *dp = &digit_pairs[ 2UL * ( val % 100UL ) ];
+    val /= 100UL;
+    *--cptr = dp[1];
+    *--cptr = dp[0];
+  }
+  if ( val >= 10UL ) {
+    const char *dp = &digit_pairs[ 2UL * val ];
+    *--cptr = dp[1];
+    *--cptr = dp[0];
   } else {
-    *--cptr = '0';
+    *--cptr = static_cast< char >( '0' + val );
   }
   return cptr;
 }
 
+unsigned uint_len( uint64_t val )
+{
+  unsigned len = 1;
+  for( ; val >= 10000UL; val /= 10000UL ) {
+    len += 4;
+  }
+  return len + ( val >= 10UL ) + ( val >= 100UL ) + ( val >= 1000UL );
+}
+
 uint64_t str_to_uint( const char *val, const unsigned len )
 {
   uint64_t res = 0L;
@@ -137,22 +354,13 @@ uint64_t str_to_uint( const char *val, const unsigned len )
 
 char *int_to_str( int64_t val, char *cptr )
 {
-  if ( val ) {
-    bool is_neg = val<0;
-    if ( is_neg ) {
-      val = -val;
-    }
-    while( val ) {
-      *--cptr = '0' + (val%10L);
-      val /= 10L;
-    }
-    if ( is_neg ) {
-      *--cptr = '-';
-    }
-  } else {
-    *--cptr = '0';
+  if ( val < 0 ) {
+    // negate as unsigned to cover INT64_MIN
+    cptr = uint_to_str( 0UL - static_cast< uint64_t >( val ), cptr );
+    *--cptr = '-';
+    return cptr;
   }
-  return cptr;
+  return uint_to_str( static_cast< uint64_t >( val ), cptr );
 }
 
 int64_t str_to_int( const char *val, const unsigned len )
@@ -249,7 +457,7 @@ size_t enc_base64( const uint8_t *inp, int len, char *out )
   return encLen;
 }
 
-size_t dec_base64( const char *inp, int len, uint8_t *out )
+static size_t dec_base64_tail( const char *inp, int len, uint8_t *out )
 {
   int i = 0, j = 0;
   size_t decLen = 0;
@@ -288,6 +496,132 @@ size_t dec_base64( const char *inp, int len, uint8_t *out )
   return decLen;
 }
 
+// vectorized decode of whole blocks stops at the first block holding
+// padding or an invalid character and leaves the rest to the scalar impl.
+// blocks are a multiple of 4 characters so results are identical
+
+#if defined( __x86_64__ )
+
+// per Mula and Lemire, "Faster Base64 Encoding and Decoding using AVX2
+// Instructions": translate 32 characters via nibble lookups and pack
+// the 6-bit values into 24 bytes
+__attribute__(( target( "avx2" ) ))
+static size_t dec_base64_avx2( const char *&inp, size_t& len, uint8_t *out )
+{
+  const __m256i lut_lo = _mm256_setr_epi8(
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+    0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+    0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a );
+  const __m256i lut_hi = _mm256_setr_epi8(
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 );
+  const __m256i lut_roll = _mm256_setr_epi8(
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0 );
+  const __m256i pack = _mm256_setr_epi8(
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+    2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 );
+  const __m256i perm = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 );
+  const __m256i m2f = _mm256_set1_epi8( 0x2f );
+  size_t num = 0;
+  for( ; len >= 32; inp += 32, len -= 32, num += 24 ) {
+    __m256i v = _mm256_loadu_si256( (const __m256i*)inp );
+    __m256i hi_n = _mm256_and_si256( _mm256_srli_epi32( v, 4 ), m2f );
+    __m256i lo_n = _mm256_and_si256( v, m2f );
+    __m256i lo = _mm256_shuffle_epi8( lut_lo, lo_n );
+    __m256i hi = _mm256_shuffle_epi8( lut_hi, hi_n );
+    if ( !_mm256_testz_si256( lo, hi ) ) {
+      break;
+    }
+    __m256i eq2f = _mm256_cmpeq_epi8( v, m2f );
+    __m256i roll = _mm256_shuffle_epi8(
+        lut_roll, _mm256_add_epi8( eq2f, hi_n ) );
+    v = _mm256_add_epi8( v, roll );
+    v = _mm256_maddubs_epi16( v, _mm256_set1_epi32( 0x01400140 ) );
+    v = _mm256_madd_epi16( v, _mm256_set1_epi32( 0x00011000 ) );
+    v = _mm256_permutevar8x32_epi32( _mm256_shuffle_epi8( v, pack ), perm );
+    _mm_storeu_si128( (__m128i*)&out[num], _mm256_castsi256_si128( v ) );
+    _mm_storel_epi64(
+        (__m128i*)&out[num+16], _mm256_extracti128_si256( v, 1 ) );
+  }
+  return num;
+}
+
+static bool get_has_avx2()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports( "avx2" );
+}
+
+static const bool has_avx2 = get_has_avx2();
+
+#elif defined( __aarch64__ ) && defined( __ARM_NEON )
+
+// map A-Z, a-z, 0-9, + and / to 0..63 flagging anything else in bad
+static inline uint8x16_t dec_base64_lane( uint8x16_t c, uint8x16_t& bad )
+{
+  uint8x16_t up = vsubq_u8( c, vdupq_n_u8( 'A' ) );
+  uint8x16_t lo = vsubq_u8( c, vdupq_n_u8( 'a' ) );
+  uint8x16_t dg = vsubq_u8( c, vdupq_n_u8( '0' ) );
+  uint8x16_t is_up = vcltq_u8( up, vdupq_n_u8( 26 ) );
+  uint8x16_t is_lo = vcltq_u8( lo, vdupq_n_u8( 26 ) );
+  uint8x16_t is_dg = vcltq_u8( dg, vdupq_n_u8( 10 ) );
+  uint8x16_t is_pl = vceqq_u8( c, vdupq_n_u8( '+' ) );
+  uint8x16_t is_sl = vceqq_u8( c, vdupq_n_u8( '/' ) );
+  uint8x16_t res = vandq_u8( is_up, up );
+  res = vorrq_u8( res, vandq_u8( is_lo, vaddq_u8( lo, vdupq_n_u8( 26 ) ) ) );
+  res = vorrq_u8( res, vandq_u8( is_dg, vaddq_u8( dg, vdupq_n_u8( 52 ) ) ) );
+  res = vorrq_u8( res, vandq_u8( is_pl, vdupq_n_u8( 62 ) ) );
+  res = vorrq_u8( res, vandq_u8( is_sl, vdupq_n_u8( 63 ) ) );
+  uint8x16_t ok = vorrq_u8( vorrq_u8( is_up, is_lo ),
+                            vorrq_u8( is_dg, vorrq_u8( is_pl, is_sl ) ) );
+  bad = vorrq_u8( bad, vmvnq_u8( ok ) );
+  return res;
+}
+
+// de-interleave 64 characters into 4 lanes of 6-bit values and
+// re-interleave as 48 bytes
+static size_t dec_base64_neon( const char *&inp, size_t& len, uint8_t *out )
+{
+  size_t num = 0;
+  for( ; len >= 64; inp += 64, len -= 64, num += 48 ) {
+    uint8x16x4_t v = vld4q_u8( (const uint8_t*)inp );
+    uint8x16_t bad = vdupq_n_u8( 0 );
+    uint8x16_t a = dec_base64_lane( v.val[0], bad );
+    uint8x16_t b = dec_base64_lane( v.val[1], bad );
+    uint8x16_t c = dec_base64_lane( v.val[2], bad );
+    uint8x16_t d = dec_base64_lane( v.val[3], bad );
+    if ( vmaxvq_u8( bad ) ) {
+      break;
+    }
+    uint8x16x3_t o;
+    o.val[0] = vorrq_u8( vshlq_n_u8( a, 2 ), vshrq_n_u8( b, 4 ) );
+    o.val[1] = vorrq_u8( vshlq_n_u8( b, 4 ), vshrq_n_u8( c, 2 ) );
+    o.val[2] = vorrq_u8( vshlq_n_u8( c, 6 ), d );
+    vst3q_u8( &out[num], o );
+  }
+  return num;
+}
+
+#endif
+
+size_t dec_base64( const char *inp, int len, uint8_t *out )
+{
+  size_t num = 0;
+  size_t rem = len > 0 ? static_cast< size_t >( len ) : 0UL;
+#if defined( __x86_64__ )
+  if ( has_avx2 ) {
+    num = dec_base64_avx2( inp, rem, out );
+  }
+#elif defined( __aarch64__ ) && defined( __ARM_NEON )
+  num = dec_base64_neon( inp, rem, out );
+#endif
+  return num + dec_base64_tail( inp, static_cast< int >( rem ), &out[num] );
+}
+
 int64_t get_now()
 {
   struct timespec ts[1];
@@ -298,6 +632,29 @@ int64_t get_now()
   return res;
 }
 
+bool set_thread_cpu( pthread_t thrd, int cpu )
+{
+  if ( cpu < 0 || cpu >= CPU_SETSIZE ) {
+    errno = EINVAL;
+    return false;
+  }
+  cpu_set_t cset;
+  CPU_ZERO( &cset );
+  CPU_SET( static_cast< size_t >( cpu ), &cset );
+  int rc = pthread_setaffinity_np( thrd, sizeof( cset ), &cset );
+  errno = rc;
+  return rc == 0;
+}
+
+bool set_thread_prio( pthread_t thrd, int prio )
+{
+  sched_param prm;
+  prm.sched_priority = prio;
+  int rc = pthread_setschedparam( thrd, SCHED_FIFO, &prm );
+  errno = rc;
+  return rc == 0;
+}
+
 void uint_to_str6( char *cptr, int64_t val )
 {
   cptr[5] = '0' + (val%10L); val/=10L;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <pthread.h>
 #include <stdint.h>
 #include <string>
 
@@ -8,6 +9,7 @@
 #define PC_UNLIKELY(ARG) __builtin_expect((ARG),0)
 #define PC_NSECS_IN_SEC  1000000000L
 #define PC_NSECS_IN_MSEC 1000000L
+#define PC_NSECS_IN_USEC 1000L
 
 namespace pc
 {
@@ -16,18 +18,29 @@ namespace pc
   int enc_base58( const uint8_t *src, int len, char *result, int rlen);
   int dec_base58( const uint8_t *str, int len, uint8_t *result );
 
+  // base58 of fixed-length 32 byte keys and 64 byte signatures. the
+  // result holds 45 or 89 chars including the terminating nul. decoding
+  // returns -1 unless the text is the encoding of exactly that many bytes
+  int enc_base58_32( const uint8_t *src, char *result );
+  int enc_base58_64( const uint8_t *src, char *result );
+  int dec_base58_32( const uint8_t *str, int len, uint8_t *result );
+  int dec_base58_64( const uint8_t *str, int len, uint8_t *result );
+
   // base64 encoding courtesy of
   // Adam Rudd per licence: github.com/adamvr/arduino-base64
   size_t enc_base64_len( size_t len );
   size_t enc_base64( const uint8_t *src, int len, char *result );
   size_t dec_base64( const char *str, int len, uint8_t *result );
 
-  // integer to string encoding
+  // integer to string encoding (written backwards ending at end_ptr)
   char *uint_to_str( uint64_t val, char *end_ptr );
   uint64_t str_to_uint( const char *str, unsigned len );
   char *int_to_str( int64_t val, char *end_ptr );
   int64_t str_to_int( const char *str, unsigned len );
 
+  // number of decimal digits in val
+  unsigned uint_len( uint64_t val );
+
   // string representation of decimal to integer with implied decimal places
   int64_t str_to_dec( const char *str, int len, int expo );
   int64_t str_to_dec( const char *str, int expo );
@@ -36,6 +49,13 @@ namespace pc
   int64_t get_now();
   char *nsecs_to_utc6( int64_t ts, char *cptr );
 
+  // pin thread to cpu. false with errno set on failure
+  bool set_thread_cpu( pthread_t, int cpu );
+
+  // run thread under SCHED_FIFO at priority prio (1-99). false with
+  // errno set on failure (e.g. without CAP_SYS_NICE)
+  bool set_thread_prio( pthread_t, int prio );
+
   // get host/port from <host>[:port1[:port2]] convention
   std::string get_host_port( const std::string& host, int&port1, int&port2);
 
@@ -1,32 +1,144 @@
 #include "net_socket.hpp"
+#include "huge_page.hpp"
 
 #include <assert.h>
 #include <openssl/sha.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <netdb.h>
+#include <strings.h>
 #include <poll.h>
-
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <zlib.h>
+
+#if defined( __x86_64__ )
+#include <immintrin.h>
+#elif defined( __ARM_NEON )
+#include <arm_neon.h>
+#endif
+
+#if defined( __NR_io_uring_setup ) && __has_include( <linux/io_uring.h> )
+#include <linux/io_uring.h>
+#define PC_HAS_URING
+#endif
+
+#include <atomic>
 #include <cctype>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 #define PC_EPOLL_FLAGS (EPOLLIN|EPOLLET|EPOLLRDHUP|EPOLLHUP|EPOLLERR)
+#define PC_RESOLVE_TTL      (60L*PC_NSECS_IN_SEC)
+#define PC_RESOLVE_RETRY    PC_NSECS_IN_SEC
+#define PC_CONNECT_STAGGER  (250L*PC_NSECS_IN_MSEC)
+#define PC_CONNECT_MAX_TRY  4UL
 
 namespace pc
 {
   // net_buf allocation and caching scheme
+  // each thread keeps its own capped free list per size class so
+  // allocation rarely takes a lock. a thread whose cache is full (e.g.
+  // the log thread releasing buffers allocated elsewhere) hands half of
+  // it to a pool shared by all threads, which threads with an empty
+  // cache take batches from before allocating. the caches and the pool
+  // are trivially destructible so static writers can release buffers
+  // during program exit. with huge pages enabled the smallest buffers
+  // are carved from huge page slabs and are never returned to the heap
   struct net_buf_alloc
   {
   public:
-    net_buf_alloc();
-    ~net_buf_alloc();
-    net_buf *alloc();
+    net_buf *alloc( unsigned cls );
     void dealloc( net_buf * );
+    void add_slab();
+    bool refill( unsigned cls );
+    void spill( unsigned cls );
+
+    static const size_t hdr_len = sizeof( net_buf ) - net_buf::len;
+    static const uint16_t cls_cap[net_buf::num_cls];
+    static const unsigned max_cache[net_buf::num_cls];
+    static const unsigned max_pool[net_buf::num_cls];
+
+    net_buf *ptr_[net_buf::num_cls]; // free list by size class
+    unsigned num_[net_buf::num_cls]; // free list lengths
+    uint64_t hit_[net_buf::num_cls]; // allocations from free list
+    uint64_t mis_[net_buf::num_cls]; // allocations from heap
+  };
+
+  // batches of max_cache/2 buffers linked by next_ with the next batch
+  // stored at the start of the first buffer
+  struct net_buf_pool
+  {
+    std::mutex            mtx_;
+    net_buf              *ptr_[net_buf::num_cls]; // batches by size class
+    std::atomic<unsigned> num_[net_buf::num_cls]; // number of batches
+    bool                  has_slab_; // pooled class 0 may be slab buffers
+  };
+
+  // io_uring submission and completion rings used by net_loop
+  // sockets are armed with one-shot poll requests which are queued and
+  // then submitted in the same io_uring_enter call used to wait for
+  // completions, so each loop iteration costs a single system call
+  class net_uring
+  {
+  public:
+    net_uring();
+    ~net_uring();
+    bool init( unsigned entries );
+    void add( net_socket *, uint32_t events );
+    void del( net_socket * );
+    int  poll( int timeout, net_loop * );
+    bool wait( int timeout );
+
   private:
-    net_buf *ptr_;
+
+    struct slot {
+      net_socket *sp_;     // associated socket
+      uint32_t    gen_;    // generation for detecting stale completions
+      bool        out_;    // want write notification
+      bool        arm_[2]; // read/write poll request is armed
+    };
+
+    typedef std::vector<slot>     slot_vec_t;
+    typedef std::vector<uint32_t> idx_vec_t;
+
+    static const uint64_t ign_id = ~0UL;
+
+#ifdef PC_HAS_URING
+    io_uring_sqe *get_sqe();
+    void arm( uint32_t idx, bool out );
+    void cancel( uint32_t idx, bool out );
+    int  enter( unsigned min_complete );
+
+    int            fd_;
+    unsigned       pend_;   // sqes queued but not yet submitted
+    void          *sqp_;    // submission ring mapping
+    void          *cqp_;    // completion ring mapping
+    size_t         sqsz_;
+    size_t         cqsz_;
+    io_uring_sqe  *sqes_;
+    size_t         sqesz_;
+    unsigned      *sqhd_;
+    unsigned      *sqtl_;
+    unsigned       sqmsk_;
+    unsigned       sqnum_;
+    unsigned      *sqarr_;
+    unsigned      *cqhd_;
+    unsigned      *cqtl_;
+    unsigned       cqmsk_;
+    io_uring_cqe  *cqes_;
+    __kernel_timespec ts_[1];
+#endif
+    slot_vec_t     svec_;
+    idx_vec_t      fvec_;
   };
 
 }
@@ -36,51 +148,185 @@ using namespace pc;
 ///////////////////////////////////////////////////////////////////////////
 // net_buf_alloc
 
-net_buf_alloc::net_buf_alloc()
-: ptr_( nullptr )
-{
-  static_assert( sizeof( net_buf ) == 1280, "unexpected net_buf size");
-}
+const uint16_t net_buf_alloc::cls_cap[net_buf::num_cls] = {
+  net_buf::len,
+  (uint16_t)( 16384 - hdr_len ),
+  (uint16_t)( 65536 - hdr_len )
+};
 
-net_buf_alloc::~net_buf_alloc()
-{
-  while( ptr_ ) {
-    net_buf *nxt = ptr_->next_;
-    delete ptr_;
-    ptr_ = nxt;
-  }
-}
+// cap number of cached buffers per thread
+const unsigned net_buf_alloc::max_cache[net_buf::num_cls] = {
+  1024, 256, 32
+};
 
-net_buf *net_buf_alloc::alloc()
+// cap number of pooled batches beyond which buffers go back to the heap
+const unsigned net_buf_alloc::max_pool[net_buf::num_cls] = {
+  16, 8, 8
+};
+
+static net_buf_pool pool_;
+
+net_buf *net_buf_alloc::alloc( unsigned cls )
 {
+  static_assert( sizeof( net_buf ) == 1288, "unexpected net_buf size");
   net_buf *res;
-  if ( ptr_ ) {
-    res  = ptr_;
-    ptr_ = res->next_;
+  if ( PC_UNLIKELY( !ptr_[cls] && !refill( cls ) && !cls &&
+                    huge_page::get_enabled() ) ) {
+    add_slab();
+  }
+  if ( PC_LIKELY( ptr_[cls] != nullptr ) ) {
+    res  = ptr_[cls];
+    ptr_[cls] = res->next_;
+    --num_[cls];
+    ++hit_[cls];
   } else {
-    res = new net_buf;
+    size_t sz = std::max( sizeof( net_buf ), hdr_len + cls_cap[cls] );
+    res = (net_buf*)::operator new( sz );
+    res->cls_ = cls;
+    ++mis_[cls];
   }
   res->next_ = nullptr;
   res->size_ = 0;
+  res->ref_  = 1;
   return res;
 }
 
+void net_buf_alloc::add_slab()
+{
+  // slab buffers are cached or pooled but never deleted
+  char *buf = static_cast< char* >( huge_page::alloc( huge_page::fit_len ) );
+  for( size_t i = 0; i + sizeof( net_buf ) <= huge_page::fit_len;
+       i += sizeof( net_buf ) ) {
+    net_buf *ptr = (net_buf*)&buf[i];
+    ptr->cls_  = 0;
+    ptr->next_ = ptr_[0];
+    ptr_[0] = ptr;
+    ++num_[0];
+  }
+  ++mis_[0];
+  std::lock_guard<std::mutex> lck( pool_.mtx_ );
+  pool_.has_slab_ = true;
+}
+
+bool net_buf_alloc::refill( unsigned cls )
+{
+  // checked without the lock so that threads do not take it on every
+  // allocation while the pool is empty
+  if ( pool_.num_[cls].load( std::memory_order_relaxed ) == 0 ) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lck( pool_.mtx_ );
+  net_buf *hd = pool_.ptr_[cls];
+  if ( !hd ) {
+    return false;
+  }
+  pool_.ptr_[cls] = *(net_buf**)hd->buf_;
+  pool_.num_[cls].fetch_sub( 1U, std::memory_order_relaxed );
+  ptr_[cls] = hd;
+  num_[cls] = max_cache[cls] / 2;
+  return true;
+}
+
+void net_buf_alloc::spill( unsigned cls )
+{
+  // detach one batch from the free list and pool it unless the pool is
+  // full of buffers that can go back to the heap
+  unsigned num = max_cache[cls] / 2;
+  net_buf *hd = ptr_[cls], *tl = hd;
+  for( unsigned i = 1; i != num; ++i ) {
+    tl = tl->next_;
+  }
+  ptr_[cls] = tl->next_;
+  tl->next_ = nullptr;
+  num_[cls] -= num;
+  {
+    std::lock_guard<std::mutex> lck( pool_.mtx_ );
+    if ( pool_.num_[cls].load( std::memory_order_relaxed ) < max_pool[cls] ||
+         ( !cls && pool_.has_slab_ ) ) {
+      *(net_buf**)hd->buf_ = pool_.ptr_[cls];
+      pool_.ptr_[cls] = hd;
+      pool_.num_[cls].fetch_add( 1U, std::memory_order_relaxed );
+      return;
+    }
+  }
+  while( hd ) {
+    net_buf *nxt = hd->next_;
+    ::operator delete( hd );
+    hd = nxt;
+  }
+}
+
 void net_buf_alloc::dealloc( net_buf *ptr )
 {
-  ptr->next_ = ptr_;
-  ptr_ = ptr;
+  unsigned cls = ptr->cls_;
+  ptr->next_ = ptr_[cls];
+  ptr_[cls] = ptr;
+  if ( PC_UNLIKELY( ++num_[cls] > max_cache[cls] ) ) {
+    spill( cls );
+  }
 }
 
-static net_buf_alloc mem_;
+static thread_local net_buf_alloc mem_ = {};
 
 net_buf *net_buf::alloc()
 {
-  return mem_.alloc();
+  return mem_.alloc( 0 );
+}
+
+net_buf *net_buf::alloc( size_t min_len )
+{
+  unsigned cls = 0;
+  while( cls != num_cls-1 && min_len > net_buf_alloc::cls_cap[cls] ) {
+    ++cls;
+  }
+  return mem_.alloc( cls );
+}
+
+net_buf *net_buf::alloc_ref( net_buf *ptr )
+{
+  net_buf *res = mem_.alloc( 0 );
+  res->cls_  = ref_cls;
+  res->size_ = ptr->size_;
+  *(net_buf**)res->buf_ = ptr;
+  ++ptr->ref_;
+  return res;
 }
 
 void net_buf::dealloc()
 {
-  mem_.dealloc( this );
+  if ( PC_UNLIKELY( cls_ == ref_cls ) ) {
+    net_buf *ptr = *(net_buf**)buf_;
+    cls_ = 0;
+    mem_.dealloc( this );
+    ptr->dealloc();
+  } else if ( --ref_ == 0 ) {
+    mem_.dealloc( this );
+  }
+}
+
+uint16_t net_buf::get_cls_cap( unsigned cls )
+{
+  return net_buf_alloc::cls_cap[cls];
+}
+
+uint64_t net_buf::get_num_hit( unsigned cls )
+{
+  return mem_.hit_[cls];
+}
+
+uint64_t net_buf::get_num_miss( unsigned cls )
+{
+  return mem_.mis_[cls];
+}
+
+unsigned net_buf::get_num_free( unsigned cls )
+{
+  return mem_.num_[cls];
+}
+
+unsigned net_buf::get_max_free( unsigned cls )
+{
+  return net_buf_alloc::max_cache[cls];
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -88,7 +334,7 @@ void net_buf::dealloc()
 
 
 net_wtr::net_wtr()
-: hd_( mem_.alloc() ),
+: hd_( net_buf::alloc() ),
   tl_( hd_ ),
   sz_( 0 )
 {
@@ -102,7 +348,7 @@ net_wtr::~net_wtr()
 void net_wtr::reset()
 {
   dealloc();
-  hd_ = tl_ = mem_.alloc();
+  hd_ = tl_ = net_buf::alloc();
   sz_ = 0;
 }
 
@@ -116,6 +362,21 @@ void net_wtr::dealloc()
 
 }
 
+void net_wtr::add_copy( const net_wtr& buf )
+{
+  // append leaving buf intact
+  for( net_buf *ptr = buf.hd_; ptr; ptr = ptr->next_ ) {
+    add( str( ptr->buf_, ptr->size_ ) );
+  }
+}
+
+void net_wtr::copy_to( std::string& res ) const
+{
+  for( net_buf *ptr = hd_; ptr; ptr = ptr->next_ ) {
+    res.append( ptr->buf_, ptr->size_ );
+  }
+}
+
 void net_wtr::detach( net_buf *&hd, net_buf *&tl )
 {
   hd  = hd_;
@@ -124,9 +385,9 @@ void net_wtr::detach( net_buf *&hd, net_buf *&tl )
   sz_ = 0UL;
 }
 
-void net_wtr::alloc()
+void net_wtr::alloc( size_t min_len )
 {
-  net_buf *ptr = mem_.alloc();
+  net_buf *ptr = net_buf::alloc( min_len );
   tl_->next_ = ptr;
   sz_ += tl_->size_;
   tl_ = ptr;
@@ -135,7 +396,7 @@ void net_wtr::alloc()
 void net_wtr::add( str str )
 {
   size_t nlen = tl_->size_ + str.len_;
-  if ( nlen <= net_buf::len ) {
+  if ( nlen <= tl_->get_cap() ) {
     __builtin_memcpy( &tl_->buf_[tl_->size_], str.str_, str.len_ );
     tl_->size_ = nlen;
   } else {
@@ -145,7 +406,7 @@ void net_wtr::add( str str )
 
 void net_wtr::add( char val )
 {
-  if ( PC_UNLIKELY( tl_->size_ == net_buf::len ) ) {
+  if ( PC_UNLIKELY( tl_->size_ == tl_->get_cap() ) ) {
     alloc();
   }
   tl_->buf_[tl_->size_++] = val;
@@ -156,7 +417,7 @@ void net_wtr::add( net_wtr& buf )
   net_buf *hd, *tl;
   sz_ += tl_->size_ + buf.size();
   buf.detach( hd, tl );
-  if ( tl_->size_ + hd->size_ <= net_buf::len ) {
+  if ( tl_->size_ + hd->size_ <= tl_->get_cap() ) {
     __builtin_memcpy( &tl_->buf_[tl_->size_], hd->buf_, hd->size_ );
     tl_->next_ = hd->next_;
     tl_->size_ += hd->size_;
@@ -174,10 +435,11 @@ void net_wtr::add( net_wtr& buf )
 void net_wtr::add_alloc( str str )
 {
   while( str.len_ >0 ) {
-    if ( tl_->size_ == net_buf::len ) {
-      alloc();
+    if ( tl_->size_ == tl_->get_cap() ) {
+      // size next buffer to fit the remainder of large messages
+      alloc( str.len_ );
     }
-    size_t left = static_cast< size_t >( net_buf::len - tl_->size_ );
+    size_t left = static_cast< size_t >( tl_->get_cap() - tl_->size_ );
     size_t mlen = std::min( left, str.len_ );
     __builtin_memcpy( &tl_->buf_[tl_->size_], str.str_, mlen );
     tl_->size_ += mlen;
@@ -188,12 +450,12 @@ void net_wtr::add_alloc( str str )
 
 char *net_wtr::reserve( size_t len )
 {
-  if ( len > net_buf::len ) {
+  if ( len > net_buf::get_cls_cap( net_buf::num_cls-1 ) ) {
     return nullptr;
   }
   size_t nlen = tl_->size_ + len;
-  if ( nlen > net_buf::len ) {
-    alloc();
+  if ( nlen > tl_->get_cap() ) {
+    alloc( len );
   }
   return &tl_->buf_[tl_->size_];
 }
@@ -216,11 +478,302 @@ void net_wtr::print() const
   std::cout << std::endl;
 }
 
+///////////////////////////////////////////////////////////////////////////
+// net_uring
+
+#ifdef PC_HAS_URING
+
+net_uring::net_uring()
+: fd_( -1 ),
+  pend_( 0 ),
+  sqp_( MAP_FAILED ),
+  cqp_( MAP_FAILED ),
+  sqsz_( 0 ),
+  cqsz_( 0 ),
+  sqes_( (io_uring_sqe*)MAP_FAILED ),
+  sqesz_( 0 )
+{
+}
+
+net_uring::~net_uring()
+{
+  if ( sqes_ != MAP_FAILED ) {
+    ::munmap( sqes_, sqesz_ );
+  }
+  if ( cqp_ != MAP_FAILED && cqp_ != sqp_ ) {
+    ::munmap( cqp_, cqsz_ );
+  }
+  if ( sqp_ != MAP_FAILED ) {
+    ::munmap( sqp_, sqsz_ );
+  }
+  if ( fd_ >= 0 ) {
+    ::close( fd_ );
+  }
+}
+
+bool net_uring::init( unsigned entries )
+{
+  io_uring_params p[1];
+  __builtin_memset( p, 0, sizeof( p ) );
+  fd_ = (int)::syscall( __NR_io_uring_setup, entries, p );
+  if ( fd_ < 0 ) {
+    return false;
+  }
+  // map submission/completion rings and submission entries
+  sqsz_ = p->sq_off.array + p->sq_entries * sizeof( unsigned );
+  cqsz_ = p->cq_off.cqes + p->cq_entries * sizeof( io_uring_cqe );
+  if ( p->features & IORING_FEAT_SINGLE_MMAP ) {
+    sqsz_ = cqsz_ = std::max( sqsz_, cqsz_ );
+  }
+  sqp_ = ::mmap( nullptr, sqsz_, PROT_READ|PROT_WRITE,
+      MAP_SHARED|MAP_POPULATE, fd_, IORING_OFF_SQ_RING );
+  if ( sqp_ == MAP_FAILED ) {
+    return false;
+  }
+  if ( p->features & IORING_FEAT_SINGLE_MMAP ) {
+    cqp_ = sqp_;
+  } else {
+    cqp_ = ::mmap( nullptr, cqsz_, PROT_READ|PROT_WRITE,
+        MAP_SHARED|MAP_POPULATE, fd_, IORING_OFF_CQ_RING );
+    if ( cqp_ == MAP_FAILED ) {
+      return false;
+    }
+  }
+  sqesz_ = p->sq_entries * sizeof( io_uring_sqe );
+  sqes_ = (io_uring_sqe*)::mmap( nullptr, sqesz_, PROT_READ|PROT_WRITE,
+      MAP_SHARED|MAP_POPULATE, fd_, IORING_OFF_SQES );
+  if ( sqes_ == MAP_FAILED ) {
+    return false;
+  }
+  char *sq = (char*)sqp_, *cq = (char*)cqp_;
+  sqhd_  = (unsigned*)&sq[p->sq_off.head];
+  sqtl_  = (unsigned*)&sq[p->sq_off.tail];
+  sqmsk_ = *(unsigned*)&sq[p->sq_off.ring_mask];
+  sqnum_ = p->sq_entries;
+  sqarr_ = (unsigned*)&sq[p->sq_off.array];
+  cqhd_  = (unsigned*)&cq[p->cq_off.head];
+  cqtl_  = (unsigned*)&cq[p->cq_off.tail];
+  cqmsk_ = *(unsigned*)&cq[p->cq_off.ring_mask];
+  cqes_  = (io_uring_cqe*)&cq[p->cq_off.cqes];
+  return true;
+}
+
+int net_uring::enter( unsigned min_complete )
+{
+  unsigned flags = min_complete ? IORING_ENTER_GETEVENTS : 0U;
+  int rc = (int)::syscall( __NR_io_uring_enter,
+      fd_, pend_, min_complete, flags, nullptr, 0 );
+  if ( rc > 0 ) {
+    pend_ -= std::min( pend_, (unsigned)rc );
+  }
+  return rc;
+}
+
+io_uring_sqe *net_uring::get_sqe()
+{
+  unsigned tail = *sqtl_;
+  if ( tail - __atomic_load_n( sqhd_, __ATOMIC_ACQUIRE ) >= sqnum_ ) {
+    // ring is full - flush to kernel
+    enter( 0 );
+    if ( tail - __atomic_load_n( sqhd_, __ATOMIC_ACQUIRE ) >= sqnum_ ) {
+      return nullptr;
+    }
+  }
+  unsigned idx = tail & sqmsk_;
+  io_uring_sqe *sqe = &sqes_[idx];
+  __builtin_memset( sqe, 0, sizeof( io_uring_sqe ) );
+  sqarr_[idx] = idx;
+  __atomic_store_n( sqtl_, tail + 1, __ATOMIC_RELEASE );
+  ++pend_;
+  return sqe;
+}
+
+void net_uring::arm( uint32_t idx, bool out )
+{
+  slot& s = svec_[idx];
+  io_uring_sqe *sqe = get_sqe();
+  if ( !sqe ) {
+    return;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = s.sp_->get_fd();
+  sqe->poll32_events = out ?
+    (POLLOUT|POLLERR|POLLHUP) : (POLLIN|POLLRDHUP|POLLERR|POLLHUP);
+  sqe->user_data = ((uint64_t)s.gen_<<32) | (idx<<1) | (out?1:0);
+  s.arm_[out] = true;
+}
+
+void net_uring::cancel( uint32_t idx, bool out )
+{
+  slot& s = svec_[idx];
+  io_uring_sqe *sqe = get_sqe();
+  if ( !sqe ) {
+    return;
+  }
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = ((uint64_t)s.gen_<<32) | (idx<<1) | (out?1:0);
+  sqe->user_data = ign_id;
+  s.arm_[out] = false;
+}
+
+void net_uring::add( net_socket *eptr, uint32_t events )
+{
+  uint32_t idx;
+  if ( eptr->get_in_loop() ) {
+    idx = eptr->get_loop_idx();
+  } else {
+    if ( !fvec_.empty() ) {
+      idx = fvec_.back();
+      fvec_.pop_back();
+    } else {
+      idx = svec_.size();
+      svec_.resize( idx + 1 );
+      svec_[idx].gen_ = 0;
+    }
+    slot& s = svec_[idx];
+    s.sp_ = eptr;
+    s.arm_[0] = s.arm_[1] = false;
+    eptr->set_loop_idx( idx );
+    eptr->set_in_loop( true );
+    arm( idx, false );
+  }
+  slot& s = svec_[idx];
+  s.out_ = (events & EPOLLOUT) != 0;
+  if ( s.out_ && !s.arm_[1] ) {
+    arm( idx, true );
+  }
+}
+
+void net_uring::del( net_socket *eptr )
+{
+  if ( eptr->get_in_loop() ) {
+    uint32_t idx = eptr->get_loop_idx();
+    slot& s = svec_[idx];
+    if ( s.arm_[0] ) cancel( idx, false );
+    if ( s.arm_[1] ) cancel( idx, true );
+    ++s.gen_;
+    s.sp_ = nullptr;
+    fvec_.push_back( idx );
+    eptr->set_in_loop( false );
+  }
+}
+
+int net_uring::poll( int timeout, net_loop *lp )
+{
+  unsigned head = *cqhd_;
+  if ( head == __atomic_load_n( cqtl_, __ATOMIC_ACQUIRE ) ) {
+    // nothing pending - submit and wait for completions
+    if ( timeout > 0 ) {
+      io_uring_sqe *sqe = get_sqe();
+      if ( sqe ) {
+        ts_->tv_sec  = timeout / 1000;
+        ts_->tv_nsec = ( timeout % 1000 ) * PC_NSECS_IN_MSEC;
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->fd = -1;
+        sqe->addr = (uint64_t)ts_;
+        sqe->len = 1;
+        sqe->off = 1;
+        sqe->user_data = ign_id;
+      }
+    }
+    if ( 0 > enter( timeout ? 1 : 0 ) && errno != EINTR &&
+         errno != ETIME && errno != EBUSY ) {
+      return -1;
+    }
+  } else if ( pend_ ) {
+    enter( 0 );
+  }
+  int nev = 0;
+  unsigned tail = __atomic_load_n( cqtl_, __ATOMIC_ACQUIRE );
+  for( ; head != tail; ++head ) {
+    io_uring_cqe *cqe = &cqes_[head & cqmsk_];
+    uint64_t id = cqe->user_data;
+    __atomic_store_n( cqhd_, head + 1, __ATOMIC_RELEASE );
+    if ( id == ign_id ) {
+      continue;
+    }
+    uint32_t idx = (uint32_t)id >> 1, gen = id >> 32;
+    bool out = ( id & 1 ) != 0;
+    if ( idx >= svec_.size() || svec_[idx].gen_ != gen ) {
+      continue;
+    }
+    svec_[idx].arm_[out] = false;
+    net_socket *sp = svec_[idx].sp_;
+    ++nev;
+    sp->poll();
+    if ( sp->get_is_err() ) {
+      lp->del( sp );
+      sp->teardown();
+    } else if ( svec_[idx].gen_ == gen ) {
+      // re-arm one-shot poll request
+      if ( !out && !svec_[idx].arm_[0] ) {
+        arm( idx, false );
+      } else if ( out && svec_[idx].out_ && !svec_[idx].arm_[1] ) {
+        arm( idx, true );
+      }
+    }
+  }
+  return nev;
+}
+
+bool net_uring::wait( int timeout )
+{
+  // submit re-armed polls so that their completions can wake us
+  if ( pend_ ) {
+    enter( 0 );
+  }
+  pollfd pfd = { fd_, POLLIN, 0 };
+  return ::poll( &pfd, 1, timeout ) > 0;
+}
+
+#else
+
+net_uring::net_uring()
+{
+}
+
+net_uring::~net_uring()
+{
+}
+
+bool net_uring::init( unsigned )
+{
+  return false;
+}
+
+void net_uring::add( net_socket *, uint32_t )
+{
+}
+
+void net_uring::del( net_socket * )
+{
+}
+
+int net_uring::poll( int, net_loop * )
+{
+  return -1;
+}
+
+bool net_uring::wait( int )
+{
+  return false;
+}
+
+#endif
+
 ///////////////////////////////////////////////////////////////////////////
 // net_loop
 
 net_loop::net_loop()
-: fd_(-1)
+: fd_(-1),
+  use_ur_( false ),
+  do_lat_( false ),
+  busy_us_( 0 ),
+  lat_num_( 0UL ),
+  lat_tot_( 0L ),
+  lat_max_( 0L ),
+  ur_( nullptr )
 {
   __builtin_memset( ev_, 0, sizeof( ev_ ) );
   __builtin_memset( evarr_, 0, sizeof( evarr_ ) );
@@ -232,10 +785,98 @@ net_loop::~net_loop()
     ::close( fd_ );
     fd_ = -1;
   }
+  delete ur_;
+  ur_ = nullptr;
+}
+
+void net_loop::set_use_uring( bool use_ur )
+{
+  use_ur_ = use_ur;
+}
+
+bool net_loop::get_use_uring() const
+{
+  return use_ur_;
+}
+
+bool net_loop::get_is_uring() const
+{
+  return ur_ != nullptr;
+}
+
+void net_loop::set_busy_poll( int usecs )
+{
+  busy_us_ = usecs;
+}
+
+int net_loop::get_busy_poll() const
+{
+  return busy_us_;
+}
+
+void net_loop::set_latency( bool do_lat )
+{
+  do_lat_ = do_lat;
+}
+
+bool net_loop::get_latency() const
+{
+  return do_lat_;
+}
+
+void net_loop::add_latency( int64_t lat )
+{
+  ++lat_num_;
+  lat_tot_ += lat;
+  lat_max_ = std::max( lat_max_, lat );
+}
+
+uint64_t net_loop::get_num_latency() const
+{
+  return lat_num_;
+}
+
+int64_t net_loop::get_avg_latency() const
+{
+  return lat_num_ ? lat_tot_ / static_cast< int64_t >( lat_num_ ) : 0L;
+}
+
+int64_t net_loop::get_max_latency() const
+{
+  return lat_max_;
+}
+
+void net_loop::reset_latency()
+{
+  lat_num_ = 0UL;
+  lat_tot_ = lat_max_ = 0L;
+}
+
+void net_loop::add_opts( net_socket *eptr )
+{
+  // best effort - raising busy poll above net.core.busy_read
+  // requires CAP_NET_ADMIN
+  int fd = eptr->get_fd();
+  if ( busy_us_ > 0 ) {
+    setsockopt( fd, SOL_SOCKET, SO_BUSY_POLL, &busy_us_, sizeof( busy_us_ ) );
+  }
+  if ( do_lat_ ) {
+    int val = 1;
+    setsockopt( fd, SOL_SOCKET, SO_TIMESTAMPNS, &val, sizeof( val ) );
+  }
 }
 
 bool net_loop::init()
 {
+  if ( use_ur_ && !ur_ ) {
+    // fall back to epoll if io_uring not available on this kernel
+    ur_ = new net_uring;
+    if ( ur_->init( 2*max_events_ ) ) {
+      return true;
+    }
+    delete ur_;
+    ur_ = nullptr;
+  }
   fd_ = ::epoll_create( 1 );
   if ( fd_ < 0 ) {
     return set_err_msg( "failed to create epoll", errno );
@@ -245,6 +886,13 @@ bool net_loop::init()
 
 void net_loop::add( net_socket *eptr, uint32_t events )
 {
+  if ( !eptr->get_in_loop() && ( busy_us_ > 0 || do_lat_ ) ) {
+    add_opts( eptr );
+  }
+  if ( ur_ ) {
+    ur_->add( eptr, events );
+    return;
+  }
   ev_->events = events;
   ev_->data.ptr = eptr;
   int evop = EPOLL_CTL_ADD;
@@ -258,7 +906,9 @@ void net_loop::add( net_socket *eptr, uint32_t events )
 
 void net_loop::del( net_socket *eptr )
 {
-  if ( eptr->get_in_loop() ) {
+  if ( ur_ ) {
+    ur_->del( eptr );
+  } else if ( eptr->get_in_loop() ) {
     ev_->events   = 0;
     ev_->data.ptr = eptr;
     epoll_ctl( fd_, EPOLL_CTL_DEL, eptr->get_fd(), ev_ );
@@ -268,6 +918,9 @@ void net_loop::del( net_socket *eptr )
 
 bool net_loop::poll( int timeout )
 {
+  if ( ur_ ) {
+    return ur_->poll( timeout, this ) > 0;
+  }
   int nfds = epoll_wait( fd_, evarr_, max_events_, timeout );
   if ( nfds > 0 ) {
     for(int i=0; i != nfds; ++i ) {
@@ -285,6 +938,15 @@ bool net_loop::poll( int timeout )
   }
 }
 
+bool net_loop::wait( int timeout )
+{
+  if ( ur_ ) {
+    return ur_->wait( timeout );
+  }
+  pollfd pfd = { fd_, POLLIN, 0 };
+  return ::poll( &pfd, 1, timeout ) > 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // net_socket
 
@@ -299,6 +961,7 @@ net_socket::~net_socket()
 net_socket::net_socket()
 : fd_(-1),
   inl_( false ),
+  lix_( 0 ),
   lp_( nullptr )
 {
 }
@@ -333,6 +996,16 @@ bool net_socket::get_in_loop() const
   return inl_;
 }
 
+void net_socket::set_loop_idx( uint32_t lix )
+{
+  lix_ = lix;
+}
+
+uint32_t net_socket::get_loop_idx() const
+{
+  return lix_;
+}
+
 void net_socket::close()
 {
   if ( fd_ > 0 ) {
@@ -384,6 +1057,7 @@ bool net_socket::init()
 net_connect::net_connect()
 : whd_( nullptr ),
   wtl_( nullptr ),
+  wqsz_( 0 ),
   rsz_( 0 ),
   wsz_( 0 ),
   np_( nullptr )
@@ -405,9 +1079,15 @@ bool net_connect::get_is_send() const
   return whd_ != nullptr;
 }
 
+size_t net_connect::get_send_size() const
+{
+  return wqsz_;
+}
+
 void net_connect::add_send( net_wtr& msg )
 {
   net_buf *hd, *tl;
+  wqsz_ += msg.size();
   msg.detach( hd, tl );
   if ( wtl_ ) {
     wtl_->next_ = hd;
@@ -420,6 +1100,45 @@ void net_connect::add_send( net_wtr& msg )
   wtl_ = tl;
 }
 
+void net_connect::add_send_ref( net_buf *hd )
+{
+  for( ; hd; hd = hd->next_ ) {
+    net_buf *ptr = net_buf::alloc_ref( hd );
+    wqsz_ += ptr->size_;
+    if ( wtl_ ) {
+      wtl_->next_ = ptr;
+    } else {
+      whd_ = ptr;
+      if ( get_net_loop() ) {
+        get_net_loop()->add( this, PC_EPOLL_FLAGS | EPOLLOUT );
+      }
+    }
+    wtl_ = ptr;
+  }
+}
+
+void net_connect::get_queued( std::string& rbuf, std::string& wbuf ) const
+{
+  rbuf.assign( rdr_.data(), rsz_ );
+  wbuf.clear();
+  for( net_buf *ptr = whd_; ptr; ptr = ptr->next_ ) {
+    size_t off = ptr == whd_ ? wsz_ : 0UL;
+    wbuf.append( &ptr->get_data()[off], ptr->size_ - off );
+  }
+}
+
+void net_connect::set_queued( const std::string& rbuf,
+                              const std::string& wbuf )
+{
+  rdr_.assign( rbuf.begin(), rbuf.end() );
+  rsz_ = rbuf.size();
+  if ( !wbuf.empty() ) {
+    net_wtr msg;
+    msg.add( str( wbuf.data(), wbuf.size() ) );
+    add_send( msg );
+  }
+}
+
 void net_connect::poll()
 {
   if ( get_is_send() ) {
@@ -434,30 +1153,49 @@ void net_connect::poll_send()
     return;
   }
   for(;;) {
-    // write current buffer to ssl socket
-    char *ptr = &whd_->buf_[wsz_];
-    uint16_t len = whd_->size_ - wsz_;
-    int rc = ::send( get_fd(), ptr, len, MSG_NOSIGNAL );
+    // gather pending buffers into single vectored write
+    iovec iov[max_iov];
+    unsigned niov = 0;
+    iov[0].iov_base = (void*)&whd_->get_data()[wsz_];
+    iov[0].iov_len  = whd_->size_ - wsz_;
+    for( net_buf *ptr = whd_->next_; ptr && ++niov != max_iov;
+         ptr = ptr->next_ ) {
+      iov[niov].iov_base = (void*)ptr->get_data();
+      iov[niov].iov_len  = ptr->size_;
+    }
+    if ( niov != max_iov ) ++niov;
+    msghdr msg[1];
+    __builtin_memset( msg, 0, sizeof( msghdr ) );
+    msg->msg_iov    = iov;
+    msg->msg_iovlen = niov;
+    ssize_t rc = ::sendmsg( get_fd(), msg, MSG_NOSIGNAL );
     if ( rc > 0 ) {
-      wsz_ += rc;
-
-      // advance to next buffer in list
-      if ( wsz_ == whd_->size_ ) {
+      // release fully written buffers and track partial write position
+      size_t len = static_cast< size_t >( rc );
+      wqsz_ -= len;
+      while( len ) {
+        size_t left = whd_->size_ - wsz_;
+        if ( len < left ) {
+          wsz_ += len;
+          break;
+        }
+        len -= left;
         net_buf *nxt = whd_->next_;
         whd_->dealloc();
         wsz_ = 0;
-        if ( ! ( whd_ = nxt ) ) {
-          wtl_ = nullptr;
-          if ( get_net_loop() ) {
-            get_net_loop()->add( this, PC_EPOLL_FLAGS );
-          }
-          break;
+        whd_ = nxt;
+      }
+      if ( !whd_ ) {
+        wtl_ = nullptr;
+        if ( get_net_loop() ) {
+          get_net_loop()->add( this, PC_EPOLL_FLAGS );
         }
+        break;
       }
     } else {
       // check if this is not a try again sort of error
       if ( rc == 0 || errno != EAGAIN ) {
-        poll_error( true );
+        poll_error( false );
       }
       break;
     }
@@ -473,9 +1211,19 @@ void net_connect::poll_recv()
       rdr_.resize( rdr_.size() + buf_len );
     }
     // read up to buf_len at a time
-    ssize_t rc = ::recv( get_fd(), &rdr_[rsz_], buf_len, MSG_NOSIGNAL );
+    ssize_t rc;
+    int64_t rts = 0L;
+    net_loop *lp = get_net_loop();
+    if ( lp && lp->get_latency() ) {
+      rc = recv_ts( &rdr_[rsz_], rts );
+    } else {
+      rc = ::recv( get_fd(), &rdr_[rsz_], buf_len, MSG_NOSIGNAL );
+    }
     if ( rc > 0 ) {
       rsz_ += static_cast< size_t >( rc );
+      if ( rts ) {
+        lp->add_latency( get_now() - rts );
+      }
     } else {
       if ( rc == 0 || errno != EAGAIN ) {
         poll_error( true );
@@ -499,6 +1247,31 @@ void net_connect::poll_recv()
   }
 }
 
+ssize_t net_connect::recv_ts( char *buf, int64_t& rts )
+{
+  // read with kernel receive timestamp of last packet
+  iovec iov[1];
+  iov->iov_base = buf;
+  iov->iov_len  = buf_len;
+  char cbuf[CMSG_SPACE( sizeof( timespec ) )];
+  msghdr hdr;
+  __builtin_memset( &hdr, 0, sizeof( hdr ) );
+  hdr.msg_iov = iov;
+  hdr.msg_iovlen = 1;
+  hdr.msg_control = cbuf;
+  hdr.msg_controllen = sizeof( cbuf );
+  ssize_t rc = ::recvmsg( get_fd(), &hdr, MSG_NOSIGNAL );
+  for( cmsghdr *cm = CMSG_FIRSTHDR( &hdr ); rc > 0 && cm;
+       cm = CMSG_NXTHDR( &hdr, cm ) ) {
+    if ( cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPNS ) {
+      timespec ts;
+      __builtin_memcpy( &ts, CMSG_DATA( cm ), sizeof( ts ) );
+      rts = ts.tv_sec * PC_NSECS_IN_SEC + ts.tv_nsec;
+    }
+  }
+  return rc;
+}
+
 void net_connect::poll_error( bool is_read )
 {
   std::string emsg = "fail to ";
@@ -515,6 +1288,7 @@ void net_connect::teardown()
     whd_ = nxt;
   }
   wtl_ = nullptr;
+  wqsz_ = 0;
   rdr_.clear();
   rsz_ = wsz_ = 0;
 }
@@ -583,8 +1357,12 @@ void net_listen::poll()
 tcp_connect::tcp_connect()
 : port_(-1),
   wait_( false ),
+  res_( false ),
   sts_( 0L ),
-  timeout_( 10000000000L )
+  ats_( 0L ),
+  timeout_( 10000000000L ),
+  terr_( 0 ),
+  anxt_( 0 )
 {
 }
 
@@ -608,28 +1386,152 @@ int tcp_connect::get_port() const
   return port_;
 }
 
-static bool get_hname_addr( const std::string& name, sockaddr *saddr )
+namespace pc
 {
-  memset( saddr, 0, sizeof( sockaddr ) );
-  bool has_addr = false;
+  // background host name resolution with a cache of results so that
+  // reconnects use known addresses while stale entries are refreshed
+  class net_resolver
+  {
+  public:
+    typedef tcp_connect::addr_vec_t addr_vec_t;
+    net_resolver();
+    static net_resolver& get();
+    bool resolve( const std::string& host, addr_vec_t& );
+  private:
+    struct entry {
+      addr_vec_t addr_;
+      int64_t    ts_;   // time of last result or zero
+      bool       req_;  // queued or in progress
+    };
+    typedef std::unordered_map<std::string,entry> entry_map_t;
+    typedef std::deque<std::string> host_queue_t;
+    static void run_resolver( net_resolver * );
+    static void lookup( const std::string& host, addr_vec_t& );
+    void run();
+    std::mutex              mtx_;
+    std::condition_variable cv_;
+    bool                    is_run_;  // resolver thread started
+    entry_map_t             emap_;
+    host_queue_t            hque_;
+  };
+}
+
+net_resolver::net_resolver()
+: is_run_( false )
+{
+}
+
+net_resolver& net_resolver::get()
+{
+  // never destroyed so the detached thread cannot outlive its state
+  static net_resolver *res = new net_resolver;
+  return *res;
+}
+
+void net_resolver::run_resolver( net_resolver *res )
+{
+  res->run();
+}
+
+void net_resolver::lookup( const std::string& host, addr_vec_t& addr )
+{
+  addr.clear();
   addrinfo hints[1];
-  memset( hints, 0, sizeof( addrinfo ) );
-  hints->ai_family   = AF_INET;
+  __builtin_memset( hints, 0, sizeof( addrinfo ) );
+  hints->ai_family   = AF_UNSPEC;
+  hints->ai_socktype = SOCK_STREAM;
   addrinfo *ainfo[1] = { nullptr };
-  if ( 0 > ::getaddrinfo( name.c_str(), nullptr, nullptr, ainfo ) ) {
-    return false;
+  if ( 0 != ::getaddrinfo( host.c_str(), nullptr, hints, ainfo ) ) {
+    return;
   }
+  // interleave address families so racing attempts alternate between them
+  addr_vec_t v4, v6;
   for( addrinfo *aptr = ainfo[0]; aptr; aptr = aptr->ai_next ) {
-    if ( aptr->ai_family == hints->ai_family ) {
-      __builtin_memcpy( saddr, aptr->ai_addr, sizeof( sockaddr ) );
-      has_addr = true;
-      break;
+    if ( aptr->ai_family != AF_INET && aptr->ai_family != AF_INET6 ) {
+      continue;
+    }
+    sockaddr_storage saddr;
+    __builtin_memset( &saddr, 0, sizeof( saddr ) );
+    __builtin_memcpy( &saddr, aptr->ai_addr, aptr->ai_addrlen );
+    addr_vec_t& v = aptr->ai_family == AF_INET ? v4 : v6;
+    bool is_dup = false;
+    for( const sockaddr_storage& it: v ) {
+      is_dup |= 0 == __builtin_memcmp( &it, &saddr, sizeof( saddr ) );
+    }
+    if ( !is_dup ) {
+      v.push_back( saddr );
+    }
+  }
+  ::freeaddrinfo( ainfo[0] );
+  for( size_t i = 0; i != std::max( v4.size(), v6.size() ); ++i ) {
+    if ( i < v4.size() ) addr.push_back( v4[i] );
+    if ( i < v6.size() ) addr.push_back( v6[i] );
+  }
+}
+
+void net_resolver::run()
+{
+  std::unique_lock<std::mutex> lck( mtx_ );
+  for(;;) {
+    cv_.wait( lck, [this]{ return !hque_.empty(); } );
+    std::string host = hque_.front();
+    hque_.pop_front();
+    lck.unlock();
+    addr_vec_t addr;
+    lookup( host, addr );
+    lck.lock();
+    // a failed refresh keeps serving the last known addresses
+    entry& ent = emap_[host];
+    if ( !addr.empty() || ent.ts_ == 0L ) {
+      ent.addr_.swap( addr );
+    }
+    ent.ts_  = get_now();
+    ent.req_ = false;
+  }
+}
+
+bool net_resolver::resolve( const std::string& host, addr_vec_t& addr )
+{
+  // numeric addresses need no lookup
+  sockaddr_storage saddr;
+  __builtin_memset( &saddr, 0, sizeof( saddr ) );
+  sockaddr_in  *iaddr  = (sockaddr_in*)&saddr;
+  sockaddr_in6 *iaddr6 = (sockaddr_in6*)&saddr;
+  addr.clear();
+  if ( 1 == ::inet_pton( AF_INET, host.c_str(), &iaddr->sin_addr ) ) {
+    iaddr->sin_family = AF_INET;
+    addr.push_back( saddr );
+    return true;
+  }
+  if ( 1 == ::inet_pton( AF_INET6, host.c_str(), &iaddr6->sin6_addr ) ) {
+    iaddr6->sin6_family = AF_INET6;
+    addr.push_back( saddr );
+    return true;
+  }
+  std::lock_guard<std::mutex> lck( mtx_ );
+  entry& ent = emap_[host];
+  int64_t ttl = ent.addr_.empty() ? PC_RESOLVE_RETRY : PC_RESOLVE_TTL;
+  if ( !ent.req_ && ( ent.ts_ == 0L || get_now() - ent.ts_ > ttl ) ) {
+    ent.req_ = true;
+    hque_.push_back( host );
+    if ( !is_run_ ) {
+      is_run_ = true;
+      std::thread( run_resolver, this ).detach();
     }
+    cv_.notify_one();
   }
-  if ( ainfo[0] ) {
-    ::freeaddrinfo( ainfo[0] );
+  // known addresses are used while being refreshed
+  if ( !ent.addr_.empty() ) {
+    addr = ent.addr_;
+    return true;
   }
-  return has_addr;
+  // failed lookup not yet due for retry
+  return ent.ts_ != 0L && !ent.req_;
+}
+
+bool tcp_connect::resolve( const std::string& host, addr_vec_t& addr )
+{
+  return net_resolver::get().resolve( host, addr );
 }
 
 bool tcp_connect::get_is_wait()
@@ -642,65 +1544,158 @@ bool tcp_connect::init()
   wait_ = false;
   teardown();
   reset_err();
-  int fd = ::socket( AF_INET, SOCK_STREAM, IPPROTO_TCP );
-  if ( fd < 0 ) {
-    return set_err_msg( "failed to construct tcp socket", errno );
+  sts_ = get_now();
+  terr_ = 0;
+  anxt_ = 0;
+  if ( !resolve( host_, addr_ ) ) {
+    // completed in check()
+    res_ = wait_ = true;
+    return true;
   }
-  sockaddr saddr[1];
-  if ( !get_hname_addr( host_, saddr ) ) {
+  if ( addr_.empty() ) {
     return set_err_msg( "failed to resolve host" );
   }
-  set_fd( fd );
-  set_block( false );
-  sockaddr_in *iaddr = (sockaddr_in*)saddr;
-  iaddr->sin_port = htons( (uint16_t)port_ );
-  if ( 0 != ::connect( fd, saddr, sizeof( sockaddr ) ) ) {
-    if ( errno != EINPROGRESS ) {
-      return set_err_msg( "failed to connect", errno );
+  wait_ = true;
+  connect_next();
+  if ( get_is_err() ) {
+    wait_ = false;
+    return false;
+  }
+  return true;
+}
+
+void tcp_connect::connect_next()
+{
+  // start attempts until one is in progress or connected
+  while( anxt_ != addr_.size() ) {
+    sockaddr_storage saddr = addr_[anxt_++];
+    socklen_t slen = sizeof( sockaddr_in );
+    if ( saddr.ss_family == AF_INET ) {
+      ((sockaddr_in*)&saddr)->sin_port = htons( (uint16_t)port_ );
+    } else {
+      ((sockaddr_in6*)&saddr)->sin6_port = htons( (uint16_t)port_ );
+      slen = sizeof( sockaddr_in6 );
     }
-    sts_ = get_now();
-    wait_ = true;
+    int fd = ::socket( saddr.ss_family, SOCK_STREAM|SOCK_NONBLOCK,
+                       IPPROTO_TCP );
+    if ( fd < 0 ) {
+      set_err_msg( "failed to construct tcp socket", errno );
+      return;
+    }
+    ats_ = get_now();
+    if ( 0 == ::connect( fd, (sockaddr*)&saddr, slen ) ) {
+      close_try();
+      set_fd( fd );
+      wait_ = false;
+      net_socket::init();
+      return;
+    }
+    if ( errno == EINPROGRESS ) {
+      tvec_.push_back( std::make_pair( fd, anxt_ - 1 ) );
+      return;
+    }
+    terr_ = errno;
+    ::close( fd );
+  }
+  if ( tvec_.empty() ) {
+    wait_ = false;
+    set_err_msg( "failed to connect", terr_ );
   }
-  return true;
+}
+
+void tcp_connect::close_try()
+{
+  for( auto& it: tvec_ ) {
+    ::close( it.first );
+  }
+  tvec_.clear();
 }
 
 void tcp_connect::teardown()
 {
   net_connect::teardown();
+  close_try();
   wait_ = false;
+  res_ = false;
+}
+
+void tcp_connect::poll()
+{
+  if ( !wait_ ) {
+    net_connect::poll();
+  }
 }
 
 void tcp_connect::check()
 {
   if ( !wait_ ) return;
-  fd_set rfds[1], wfds[1], efds[1];
-  struct timeval tout[1];
-  tout->tv_sec  = 0;
-  tout->tv_usec = 0;
-  FD_ZERO( rfds );
-  FD_ZERO( wfds );
-  FD_ZERO( efds );
-  FD_SET( get_fd(), efds );
-  FD_SET( get_fd(), wfds );
-  int rsel = ::select( 1 + get_fd(), rfds, wfds, efds, tout );
-  if ( rsel > 0 ) {
-    // possibly connected or failed
+  int64_t ts = get_now();
+  if ( res_ ) {
+    if ( resolve( host_, addr_ ) ) {
+      res_ = false;
+      if ( addr_.empty() ) {
+        wait_ = false;
+        set_err_msg( "failed to resolve host" );
+        return;
+      }
+      connect_next();
+      if ( !wait_ ) return;
+    } else if ( ts - sts_ > timeout_ ) {
+      wait_ = false;
+      set_err_msg( "timeout trying to resolve host" );
+      return;
+    } else {
+      return;
+    }
+  }
+  pollfd pfd[PC_CONNECT_MAX_TRY];
+  nfds_t nfd = 0;
+  for( ; nfd != tvec_.size() && nfd != PC_CONNECT_MAX_TRY; ++nfd ) {
+    pfd[nfd].fd      = tvec_[nfd].first;
+    pfd[nfd].events  = POLLOUT;
+    pfd[nfd].revents = 0;
+  }
+  int rc = ::poll( pfd, nfd, 0 );
+  if ( rc < 0 ) {
+    // failed to poll sockets
     wait_ = false;
+    close_try();
+    set_err_msg( "failed to construct tcp socket", errno );
+    return;
+  }
+  for( nfds_t i = nfd; rc > 0 && i-- != 0; ) {
+    if ( !pfd[i].revents ) {
+      continue;
+    }
+    // possibly connected or failed
+    int fd = pfd[i].fd;
     int stat = 0;
     socklen_t slen = sizeof( stat );
-    int rc = getsockopt( get_fd(), SOL_SOCKET, SO_ERROR, &stat, &slen );
-    if ( rc!=0 || stat!=0 ) {
-      set_err_msg( "failed to connect tcp socket", stat?stat:errno );
-    } else {
+    int rs = getsockopt( fd, SOL_SOCKET, SO_ERROR, &stat, &slen );
+    if ( rs == 0 && stat == 0 ) {
+      // first to connect wins
+      tvec_.erase( tvec_.begin() + (long)i );
+      close_try();
+      set_fd( fd );
+      wait_ = false;
       net_socket::init();
+      return;
     }
-  } else if ( rsel< 0 ) {
-    // failed to select socket
-    wait_ = false;
-    set_err_msg( "failed to construct tcp socket", errno );
-  } else if ( get_now() - sts_ > timeout_ ) {
+    terr_ = stat ? stat : errno;
+    ::close( fd );
+    tvec_.erase( tvec_.begin() + (long)i );
+  }
+  // try next address on failure or if the current attempt is slow
+  if ( tvec_.empty() ||
+       ( ts - ats_ > PC_CONNECT_STAGGER &&
+         tvec_.size() < PC_CONNECT_MAX_TRY ) ) {
+    connect_next();
+    if ( !wait_ ) return;
+  }
+  if ( ts - sts_ > timeout_ ) {
     // timeout waiting for connection to happen
     wait_ = false;
+    close_try();
     set_err_msg( "timeout trying to connect" );
   }
 }
@@ -755,6 +1750,20 @@ bool tcp_listen::init()
   return net_listen::init();
 }
 
+bool tcp_listen::init( int fd )
+{
+  close();
+  reset_err();
+  sockaddr_in saddr[1];
+  socklen_t slen[1] = { sizeof( saddr ) };
+  if ( 0 != ::getsockname( fd, (sockaddr*)saddr, slen ) ) {
+    return set_err_msg( "failed to get listening socket address", errno );
+  }
+  port_ = ntohs( saddr->sin_port );
+  set_fd( fd );
+  return net_listen::init();
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // udp_socket
 
@@ -793,6 +1802,12 @@ ip_addr::ip_addr( str ap )
   }
 }
 
+udp_socket::udp_socket()
+: num_sent_( 0UL ),
+  num_call_( 0UL )
+{
+}
+
 bool udp_socket::init()
 {
   teardown();
@@ -811,6 +1826,56 @@ void udp_socket::send( ip_addr *ap, const char *buf, size_t len )
   sockaddr *saddr = (sockaddr*)ap->buf_;
   ::sendto( get_fd(), buf, len, MSG_NOSIGNAL,
       saddr, sizeof( sockaddr_in ) );
+  ++num_sent_;
+  ++num_call_;
+}
+
+void udp_socket::add_send( ip_addr *ap, const char *buf, size_t len )
+{
+  pvec_.push_back( { ap, buf, len } );
+}
+
+void udp_socket::flush()
+{
+  mmsghdr mvec[max_mmsg];
+  iovec   ivec[max_mmsg];
+  for( size_t i=0; i < pvec_.size(); ) {
+    unsigned num = 0;
+    for( ; num != max_mmsg && i+num < pvec_.size(); ++num ) {
+      pkt& p = pvec_[i+num];
+      ivec[num].iov_base = (void*)p.buf_;
+      ivec[num].iov_len  = p.len_;
+      msghdr& hdr = mvec[num].msg_hdr;
+      __builtin_memset( &mvec[num], 0, sizeof( mmsghdr ) );
+      hdr.msg_name    = p.addr_->buf_;
+      hdr.msg_namelen = sizeof( sockaddr_in );
+      hdr.msg_iov     = &ivec[num];
+      hdr.msg_iovlen  = 1;
+    }
+    int rc = ::sendmmsg( get_fd(), mvec, num, MSG_NOSIGNAL );
+    ++num_call_;
+    if ( rc > 0 ) {
+      num_sent_ += static_cast< uint64_t >( rc );
+      i += static_cast< size_t >( rc );
+    } else if ( errno == EAGAIN ) {
+      // drop remaining datagrams as with sendto
+      break;
+    } else {
+      // skip the datagram that failed
+      ++i;
+    }
+  }
+  pvec_.clear();
+}
+
+uint64_t udp_socket::get_num_sent() const
+{
+  return num_sent_;
+}
+
+uint64_t udp_socket::get_num_calls() const
+{
+  return num_call_;
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -839,11 +1904,9 @@ void http_request::add_hdr( const char *hdr, uint64_t ival )
   add( hdr );
   add( ':' );
   add( ' ' );
-  char *buf = reserve( 32 ), *end = &buf[31];
-  char *val = uint_to_str( ival, end );
-  assert( end >= val );
-  size_t val_len = static_cast< size_t >( end - val );
-  __builtin_memmove( buf, val, val_len );
+  size_t val_len = uint_len( ival );
+  char *buf = reserve( val_len );
+  uint_to_str( ival, &buf[val_len] );
   advance( val_len );
   add( '\r' );
   add( '\n' );
@@ -880,11 +1943,21 @@ static inline bool next(char ch,  const char *ptr, const char *end )
   return ptr != end && *ptr == ch;
 }
 
+http_client::http_client()
+: left_( 0UL )
+{
+}
+
 bool http_client::parse( const char *ptr, size_t len, size_t& res )
 {
   const char CR = (char)13;
   const char LF = (char)10;
 
+  // continue streamed body
+  if ( left_ ) {
+    return parse_body( ptr, len, res );
+  }
+
   // read status line in response
   const char *beg = ptr;
   const char *end = &ptr[len];
@@ -928,6 +2001,14 @@ bool http_client::parse( const char *ptr, size_t len, size_t& res )
   }
   // parse body
   ptr += 2;
+  if ( clen && parse_stream( clen ) ) {
+    left_ = clen;
+    assert( end >= ptr );
+    size_t blen = 0;
+    parse_body( ptr, static_cast< size_t >( end - ptr ), blen );
+    res = static_cast< size_t >( ptr - beg ) + blen;
+    return true;
+  }
   const char *cnt = &ptr[clen];
   if ( cnt > end ) return false;
 
@@ -951,6 +2032,37 @@ void http_client::parse_content( const char *, size_t )
 {
 }
 
+bool http_client::parse_stream( size_t )
+{
+  return false;
+}
+
+size_t http_client::parse_part( const char *, size_t len, bool )
+{
+  return len;
+}
+
+void http_client::reset_stream()
+{
+  left_ = 0;
+}
+
+bool http_client::parse_body( const char *ptr, size_t len, size_t& res )
+{
+  size_t avail = std::min( len, left_ );
+  if ( !avail ) {
+    return false;
+  }
+  bool is_last = avail == left_;
+  size_t num = parse_part( ptr, avail, is_last );
+  if ( is_last || num > avail ) {
+    num = avail;
+  }
+  left_ -= num;
+  res = num;
+  return num != 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // http_server
 
@@ -1101,12 +2213,27 @@ void http_server::upgrade_ws()
   msg.add_hdr( "Upgrade", "websocket" );
   msg.add_hdr( "Sec-WebSocket-Accept"
     , str( bkey, static_cast< size_t >( blen ) ) );
+
+  // accept permessage-deflate unless client constrains our compressor
+  bool is_deflate = false;
+  str ext;
+  if ( wp_->get_allow_deflate() &&
+       get_header_val( "SEC-WEBSOCKET-EXTENSIONS", ext ) ) {
+    std::string ext_str( ext.str_, ext.len_ );
+    is_deflate =
+      ext_str.find( "permessage-deflate" ) != std::string::npos &&
+      ext_str.find( "server_" ) == std::string::npos;
+  }
+  if ( is_deflate ) {
+    msg.add_hdr( "Sec-WebSocket-Extensions", "permessage-deflate" );
+  }
   msg.commit();
   np_->add_send( msg );
 
   // switch parser
   np_->set_net_parser( wp_ );
   wp_->set_net_connect( np_ );
+  wp_->set_is_deflate( is_deflate );
 }
 
 void http_server::parse_content( const char *, size_t )
@@ -1124,7 +2251,7 @@ tx_connect::tx_connect()
 : has_conn_( false ),
   wait_conn_( true ),
   cts_( 0L ),
-  ctimeout_( PC_NSECS_IN_SEC ),
+  ctimeout_( PC_RECONNECT_MIN ),
   sub_( nullptr )
 {
 }
@@ -1147,7 +2274,7 @@ void tx_connect::reconnect()
   // check for successful (re)connect
   if ( !get_is_err() ) {
     has_conn_ = true;
-    ctimeout_ = PC_NSECS_IN_SEC;
+    ctimeout_ = PC_RECONNECT_MIN;
     if ( sub_ ) sub_->on_connect();
     return;
   }
@@ -1168,7 +2295,7 @@ void tx_connect::reconnect()
   // attempt to reconnect
   cts_ = ts;
   ctimeout_ += ctimeout_;
-  ctimeout_ = std::min( ctimeout_, 120L*PC_NSECS_IN_SEC );
+  ctimeout_ = std::min( ctimeout_, PC_RECONNECT_TIMEOUT );
   wait_conn_ = true;
   init();
 }
@@ -1177,10 +2304,23 @@ void tx_connect::reconnect()
 // ws_connect
 
 ws_connect::ws_connect()
+: zoff_( false ),
+  up_( false )
 {
   init_.cp_ = this;
   init_.np_ = nullptr;
   init_.hs_ = false;
+  init_.zs_ = false;
+}
+
+void ws_connect::set_deflate( bool zoff )
+{
+  zoff_ = zoff;
+}
+
+bool ws_connect::get_deflate() const
+{
+  return zoff_;
 }
 
 bool ws_connect::init()
@@ -1192,20 +2332,34 @@ bool ws_connect::init()
     init_.np_ = get_net_parser();
   }
   init_.hs_ = false;
+  init_.zs_ = false;
   set_net_parser( &init_ );
+  if ( ws_parser *wp = dynamic_cast<ws_parser*>( init_.np_ ) ) {
+    wp->set_is_deflate( false );
+  }
+  up_ = false;
+  if ( !tcp_connect::get_is_wait() ) {
+    send_upgrade();
+  }
+  return true;
+}
 
-  // request upgrade to web-socket
+void ws_connect::send_upgrade()
+{
+  // request upgrade to web-socket once connected
+  up_ = true;
   http_request msg;
   msg.init( "GET", "/" );
   msg.add_hdr( "Connection", "Upgrade" );
   msg.add_hdr( "Upgrade", "websocket" );
   msg.add_hdr( "Sec-WebSocket-Key", "dGhlIHNhbXBsZSBub25jZQ==" );
   msg.add_hdr( "Sec-WebSocket-Version", "13" );
+  if ( zoff_ ) {
+    msg.add_hdr( "Sec-WebSocket-Extensions", "permessage-deflate" );
+  }
   msg.add_hdr( "Host", get_host() );
   msg.commit();
   add_send( msg );
-
-  return true;
 }
 
 void ws_connect::ws_connect_init::parse_status(
@@ -1218,12 +2372,35 @@ void ws_connect::ws_connect_init::parse_status(
     err.append( txt, len );
     cp_->set_err_msg( err );
   }
+  zs_ = status == 101 && cp_->zoff_;
+  ws_parser *wp = dynamic_cast<ws_parser*>( np_ );
+  if ( wp ) {
+    wp->set_is_deflate( false );
+  }
+}
+
+void ws_connect::ws_connect_init::parse_header(
+    const char *hdr, size_t hdr_len, const char *val, size_t val_len )
+{
+  // server accepted permessage-deflate offer
+  static const char ext_hdr[] = "sec-websocket-extensions";
+  static const char ext_val[] = "permessage-deflate";
+  ws_parser *wp = dynamic_cast<ws_parser*>( np_ );
+  if ( zs_ && wp && hdr_len == sizeof( ext_hdr ) - 1 &&
+       0 == strncasecmp( hdr, ext_hdr, hdr_len ) &&
+       val_len >= sizeof( ext_val ) - 1 &&
+       0 == __builtin_strncmp( val, ext_val, sizeof( ext_val ) - 1 ) ) {
+    wp->set_is_deflate( true );
+  }
 }
 
 void ws_connect::check()
 {
   tcp_connect::check();
   if ( !tcp_connect::get_is_wait() && !get_is_err() ) {
+    if ( !up_ ) {
+      send_upgrade();
+    }
     poll();
   }
 }
@@ -1233,6 +2410,120 @@ bool ws_connect::get_is_wait()
   return tcp_connect::get_is_wait() || (!get_is_err() && !init_.hs_);
 }
 
+///////////////////////////////////////////////////////////////////////////
+// ws_deflate
+
+// trailer removed from each compressed message (RFC 7692 7.2.1)
+static const char ws_deflate_tail[] = { 0x00, 0x00, (char)0xff, (char)0xff };
+
+ws_deflate::ws_deflate()
+: zin_( nullptr ),
+  zout_( nullptr )
+{
+}
+
+ws_deflate::~ws_deflate()
+{
+  reset();
+}
+
+void ws_deflate::reset()
+{
+  if ( zin_ ) {
+    inflateEnd( (z_stream*)zin_ );
+    delete (z_stream*)zin_;
+    zin_ = nullptr;
+  }
+  if ( zout_ ) {
+    deflateEnd( (z_stream*)zout_ );
+    delete (z_stream*)zout_;
+    zout_ = nullptr;
+  }
+}
+
+bool ws_deflate::compress( net_wtr& src, net_wtr& tgt )
+{
+  if ( src.size() < min_len ) {
+    return false;
+  }
+  z_stream *zs = (z_stream*)zout_;
+  if ( !zs ) {
+    zs = new z_stream;
+    __builtin_memset( zs, 0, sizeof( z_stream ) );
+    if ( Z_OK != deflateInit2( zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                               -MAX_WBITS, 8, Z_DEFAULT_STRATEGY ) ) {
+      delete zs;
+      return false;
+    }
+    zout_ = zs;
+  }
+
+  // compress each buffer in chain then flush to byte boundary
+  net_buf *hd, *tl;
+  src.detach( hd, tl );
+  obuf_.resize( std::max( obuf_.size(), size_t(1024) ) );
+  size_t len = 0;
+  while( hd ) {
+    net_buf *nxt = hd->next_;
+    zs->next_in  = (Bytef*)hd->buf_;
+    zs->avail_in = hd->size_;
+    int flush = nxt ? Z_NO_FLUSH : Z_SYNC_FLUSH;
+    do {
+      if ( len == obuf_.size() ) {
+        obuf_.resize( 2 * obuf_.size() );
+      }
+      zs->next_out  = (Bytef*)&obuf_[len];
+      zs->avail_out = (uInt)( obuf_.size() - len );
+      deflate( zs, flush );
+      len = obuf_.size() - zs->avail_out;
+    } while( zs->avail_out == 0 );
+    hd->dealloc();
+    hd = nxt;
+  }
+  assert( len >= sizeof( ws_deflate_tail ) );
+  tgt.add( str( obuf_.data(), len - sizeof( ws_deflate_tail ) ) );
+  return true;
+}
+
+bool ws_deflate::decompress( const char *buf, size_t len,
+                             const char *&res, size_t& res_len )
+{
+  z_stream *zs = (z_stream*)zin_;
+  if ( !zs ) {
+    zs = new z_stream;
+    __builtin_memset( zs, 0, sizeof( z_stream ) );
+    if ( Z_OK != inflateInit2( zs, -MAX_WBITS ) ) {
+      delete zs;
+      return false;
+    }
+    zin_ = zs;
+  }
+
+  // inflate message followed by the stripped trailer
+  ibuf_.resize( std::max( ibuf_.size(), size_t(1024) ) );
+  res_len = 0;
+  const char *ptr[2] = { buf, ws_deflate_tail };
+  size_t plen[2] = { len, sizeof( ws_deflate_tail ) };
+  for( unsigned i=0; i != 2; ++i ) {
+    zs->next_in  = (Bytef*)ptr[i];
+    zs->avail_in = (uInt)plen[i];
+    do {
+      if ( res_len == ibuf_.size() ) {
+        ibuf_.resize( 2 * ibuf_.size() );
+      }
+      zs->next_out  = (Bytef*)&ibuf_[res_len];
+      zs->avail_out = (uInt)( ibuf_.size() - res_len );
+      int rc = inflate( zs, Z_SYNC_FLUSH );
+      if ( rc != Z_OK && rc != Z_BUF_ERROR ) {
+        return false;
+      }
+      res_len = ibuf_.size() - zs->avail_out;
+    } while( zs->avail_out == 0 );
+  }
+  res = ibuf_.data();
+  return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // ws_wtr
 
@@ -1257,14 +2548,108 @@ struct PC_PACKED ws_hdr3 : public ws_hdr1
   uint64_t pay_len3_;
 };
 
+// xor websocket mask key over buffer starting at offset off in the
+// masked payload
+static void ws_mask_tail( char *buf, size_t len, const uint8_t *m )
+{
+  uint32_t m32;
+  __builtin_memcpy( &m32, m, sizeof( m32 ) );
+  size_t i = 0;
+#if defined( __SSE2__ )
+  __m128i mv = _mm_set1_epi32( (int)m32 );
+  for( ; i+16 <= len; i += 16 ) {
+    __m128i *p = (__m128i*)&buf[i];
+    _mm_storeu_si128( p, _mm_xor_si128( _mm_loadu_si128( p ), mv ) );
+  }
+#elif defined( __ARM_NEON )
+  uint8x16_t mv = vreinterpretq_u8_u32( vdupq_n_u32( m32 ) );
+  for( ; i+16 <= len; i += 16 ) {
+    uint8_t *p = (uint8_t*)&buf[i];
+    vst1q_u8( p, veorq_u8( vld1q_u8( p ), mv ) );
+  }
+#endif
+  uint64_t m64 = m32 | ( (uint64_t)m32 << 32 );
+  for( ; i+8 <= len; i += 8 ) {
+    uint64_t v;
+    __builtin_memcpy( &v, &buf[i], sizeof( v ) );
+    v ^= m64;
+    __builtin_memcpy( &buf[i], &v, sizeof( v ) );
+  }
+  for( ; i != len; ++i ) {
+    buf[i] = (char)( buf[i] ^ (char)m[i%4] );
+  }
+}
+
+#if defined( __x86_64__ )
+__attribute__(( target( "avx2" ) ))
+static void ws_mask_avx2( char *buf, size_t len, const uint8_t *m )
+{
+  uint32_t m32;
+  __builtin_memcpy( &m32, m, sizeof( m32 ) );
+  __m256i mv = _mm256_set1_epi32( (int)m32 );
+  size_t i = 0;
+  for( ; i+32 <= len; i += 32 ) {
+    __m256i *p = (__m256i*)&buf[i];
+    _mm256_storeu_si256( p, _mm256_xor_si256( _mm256_loadu_si256( p ), mv ) );
+  }
+  ws_mask_tail( &buf[i], len - i, m );
+}
+
+static bool get_has_avx2()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports( "avx2" );
+}
+
+static const bool has_avx2 = get_has_avx2();
+#endif
+
+static void ws_mask( char *buf, size_t len, const char *mask, size_t off )
+{
+  // rotate mask key to line up with start of buffer
+  uint8_t m[4];
+  for( unsigned i=0; i != 4; ++i ) {
+    m[i] = (uint8_t)mask[(off+i)%4];
+  }
+#if defined( __x86_64__ )
+  if ( has_avx2 && len >= 64 ) {
+    ws_mask_avx2( buf, len, m );
+    return;
+  }
+#endif
+  ws_mask_tail( buf, len, m );
+}
+
 void ws_wtr::commit( uint8_t op_code, net_wtr& buf, bool mask )
 {
-  size_t pay_len = buf.size();
-  char *hdr = reserve( sizeof( ws_hdr3 ) + sizeof( uint32_t ) );
+  add_frame( op_code, buf, mask, false );
+}
+
+void ws_wtr::commit( uint8_t op_code, net_wtr& buf, bool mask,
+                     ws_deflate *zs )
+{
+  net_wtr zbuf;
+  if ( zs && zs->compress( buf, zbuf ) ) {
+    add_frame( op_code, zbuf, mask, true );
+  } else {
+    add_frame( op_code, buf, mask, false );
+  }
+}
+
+void ws_wtr::commit_header( uint8_t op_code, size_t pay_len )
+{
   size_t hdsz = 0;
+  add_hdr( op_code, pay_len, false, false, hdsz );
+  advance( hdsz );
+}
+
+char *ws_wtr::add_hdr( uint8_t op_code, size_t pay_len, bool mask,
+                       bool is_comp, size_t& hdsz )
+{
+  char *hdr = reserve( sizeof( ws_hdr3 ) + sizeof( uint32_t ) );
   ws_hdr1 *hptr1 = (ws_hdr1*)hdr;
   hptr1->fin_  = 1;
-  hptr1->rsv1_ = 0;
+  hptr1->rsv1_ = is_comp;
   hptr1->rsv2_ = 0;
   hptr1->rsv3_ = 0;
   hptr1->mask_ = mask;
@@ -1283,6 +2668,14 @@ void ws_wtr::commit( uint8_t op_code, net_wtr& buf, bool mask )
     hptr3->pay_len3_ = __builtin_bswap64( (uint64_t)pay_len );
     hdsz = sizeof( ws_hdr3 );
   }
+  return hdr;
+}
+
+void ws_wtr::add_frame( uint8_t op_code, net_wtr& buf, bool mask,
+                        bool is_comp )
+{
+  size_t hdsz = 0;
+  char *hdr = add_hdr( op_code, buf.size(), mask, is_comp, hdsz );
   // generate mask
   if ( mask ) {
     uint32_t mask_key = random();
@@ -1291,12 +2684,11 @@ void ws_wtr::commit( uint8_t op_code, net_wtr& buf, bool mask )
     hdsz += sizeof( uint32_t );
     advance( hdsz );
     add( buf );
-    unsigned i=0;
+    size_t off = 0;
     for( net_buf *ptr = hd_; ptr; ptr = ptr->next_ ) {
-      for( char *ibuf = &ptr->buf_[hdsz], *ebuf = &ptr->buf_[ptr->size_];
-           ibuf != ebuf; ++ibuf, ++i ) {
-        *ibuf ^= mptr[i%4];
-      }
+      size_t len = ptr->size_ - hdsz;
+      ws_mask( &ptr->buf_[hdsz], len, mptr, off );
+      off += len;
       hdsz = 0;
     }
   } else {
@@ -1309,8 +2701,51 @@ void ws_wtr::commit( uint8_t op_code, net_wtr& buf, bool mask )
 // ws_parser
 
 ws_parser::ws_parser()
-: wptr_( nullptr )
+: wptr_( nullptr ),
+  zok_( false ),
+  zon_( false ),
+  zmsg_( false ),
+  bmsg_( false )
+{
+}
+
+void ws_parser::set_allow_deflate( bool zok )
+{
+  zok_ = zok;
+}
+
+bool ws_parser::get_allow_deflate() const
+{
+  return zok_;
+}
+
+void ws_parser::set_is_deflate( bool zon )
+{
+  // compression context is per connection
+  zs_.reset();
+  zon_ = zon;
+  zmsg_ = false;
+}
+
+bool ws_parser::get_is_deflate() const
 {
+  return zon_;
+}
+
+ws_deflate *ws_parser::get_ws_deflate()
+{
+  return zon_ ? &zs_ : nullptr;
+}
+
+void ws_parser::parse_comp( const char *buf, size_t sz )
+{
+  const char *res;
+  size_t res_len;
+  if ( zs_.decompress( buf, sz, res, res_len ) ) {
+    parse_msg( res, res_len );
+  } else {
+    set_err_msg( "failed to inflate websocket message" );
+  }
 }
 
 void ws_parser::set_net_connect( net_connect *wptr )
@@ -1348,29 +2783,41 @@ bool ws_parser::parse( const char *ptr, size_t len, size_t& res )
     if ( len < tot_sz ) return false;
   }
   if ( msk_len ) {
+    // unmask in place in the receive buffer
     const char *mask = payload;
     payload += msk_len;
-    for(unsigned i=0; i != pay_len;++i ) {
-      payload[i] = payload[i] ^ mask[i%4];
-    }
+    ws_mask( payload, pay_len, mask, 0 );
   }
   assert( payload >= ptr );
   res = pay_len + static_cast< size_t >( payload - ptr );
+  if ( hptr1->rsv1_ && !zon_ ) {
+    set_err_msg( "unexpected compressed websocket frame" );
+    return true;
+  }
   switch( hptr1->op_code_ ) {
     case ws_wtr::text_id:
     case ws_wtr::binary_id:{
-      if ( hptr1->fin_ ) {
-        parse_msg( payload, pay_len );
-      } else {
+      bmsg_ = hptr1->op_code_ == ws_wtr::binary_id;
+      if ( !hptr1->fin_ ) {
+        zmsg_ = hptr1->rsv1_;
         msg_.insert( msg_.end(), payload, &payload[pay_len] );
+      } else if ( hptr1->rsv1_ ) {
+        parse_comp( payload, pay_len );
+      } else {
+        parse_msg( payload, pay_len );
       }
       break;
     }
     case ws_wtr::cont_id:{
       msg_.insert( msg_.end(), payload, &payload[pay_len] );
       if ( hptr1->fin_ ) {
-        parse_msg( msg_.data(), msg_.size() );
+        if ( zmsg_ ) {
+          parse_comp( msg_.data(), msg_.size() );
+        } else {
+          parse_msg( msg_.data(), msg_.size() );
+        }
         msg_.clear();
+        zmsg_ = false;
       }
       break;
     }
@@ -1405,6 +2852,27 @@ void ws_parser::parse_msg( const char *, size_t )
 {
 }
 
+bool ws_parser::get_is_binary() const
+{
+  return bmsg_;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// json_key
+
+json_key::json_key( str key )
+{
+  txt_.reserve( key.len_ + 4 );
+  txt_ += ",\"";
+  txt_.append( key.str_, key.len_ );
+  txt_ += "\":";
+}
+
+str json_key::get_text( bool is_first ) const
+{
+  return is_first ? str( &txt_[1], txt_.size() - 1 ) : str( txt_ );
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // json_wtr
 
@@ -1454,6 +2922,40 @@ void json_wtr::add_key_only( str key )
   add( ':' );
 }
 
+void json_wtr::add_key_only( const json_key& key )
+{
+  add( key.get_text( first_ ) );
+  first_ = false;
+}
+
+void json_wtr::add_key( const json_key& key, str val )
+{
+  add_key_only( key );
+  add_text( val );
+}
+
+void json_wtr::add_key( const json_key& key, int64_t ival )
+{
+  add_key_only( key );
+  add_int( ival );
+}
+
+void json_wtr::add_key( const json_key& key, uint64_t ival )
+{
+  add_key_only( key );
+  add_uint( ival );
+}
+
+void json_wtr::add_key( const json_key& key, type_t t )
+{
+  add_key_only( key );
+  if ( t == e_obj ) {
+    add_obj();
+  } else {
+    add_arr();
+  }
+}
+
 void json_wtr::add_key( str key, str val )
 {
   add_key_only( key );
@@ -1496,6 +2998,12 @@ void json_wtr::add_key_verbatim( str key, str val )
   add( val );
 }
 
+void json_wtr::add_verbatim( str val )
+{
+  add_first();
+  add( val );
+}
+
 void json_wtr::add_key_enc_base58( str key, str val )
 {
   add_key_only( key );
@@ -1579,22 +3087,21 @@ void json_wtr::add_val_enc_base64( str val )
 
 void json_wtr::add_uint( uint64_t ival )
 {
-  char *buf = reserve( 32 ), *end = &buf[31];
-  char *val = uint_to_str( ival, end );
-  assert( end >= val );
-  size_t val_len = static_cast< size_t >( end - val );
-  __builtin_memmove( buf, val, val_len );
+  // write digits in place
+  size_t val_len = uint_len( ival );
+  char *buf = reserve( val_len );
+  uint_to_str( ival, &buf[val_len] );
   advance( val_len );
 }
 
 void json_wtr::add_int( int64_t ival )
 {
-  char *buf = reserve( 32 ), *end = &buf[31];
-  char *val = int_to_str( ival, end );
-  assert( end >= val );
-  size_t val_len = static_cast< size_t >( end - val );
-  __builtin_memmove( buf, val, val_len );
-  advance( val_len );
+  if ( ival < 0 ) {
+    add( '-' );
+    add_uint( 0UL - static_cast< uint64_t >( ival ) );
+  } else {
+    add_uint( static_cast< uint64_t >( ival ) );
+  }
 }
 
 void json_wtr::add_enc_base58( str val )
@@ -1602,8 +3109,10 @@ void json_wtr::add_enc_base58( str val )
   add( '"' );
   size_t rsv_len = val.len_ + val.len_;
   char *tgt = reserve( rsv_len );
-  const int elen =
-    enc_base58( (const uint8_t*)val.str_, val.len_, tgt, rsv_len );
+  const uint8_t *src = (const uint8_t*)val.str_;
+  const int elen = val.len_ == hash::len ? enc_base58_32( src, tgt ) :
+    val.len_ == signature::len ? enc_base58_64( src, tgt ) :
+    enc_base58( src, val.len_, tgt, rsv_len );
   assert( elen >= 0 );
   advance( static_cast< size_t >( elen ) );
   add( '"' );
@@ -4,20 +4,53 @@
 #include <pc/key_pair.hpp>
 #include <pc/misc.hpp>
 #include <sys/epoll.h>
+#include <sys/socket.h>
 #include <vector>
 
+// backoff between reconnect attempts doubling from min up to timeout
+#define PC_RECONNECT_MIN     (50L*PC_NSECS_IN_MSEC)
+#define PC_RECONNECT_TIMEOUT (5L*PC_NSECS_IN_SEC)
+
 namespace pc
 {
 
   // network message buffer
+  // buffers come in size classes with the smallest holding len bytes
+  // larger classes extend buf_ past len for big contiguous messages
+  // a buffer may also reference the content of another buffer so that
+  // one message can sit in the send queues of several connections
   struct net_buf
   {
     static const uint16_t len = 1270;
+    static const unsigned num_cls = 3;
+    static const uint16_t ref_cls = num_cls;
     net_buf *next_;
     uint16_t size_;
+    uint16_t cls_;
+    uint16_t ref_;  // references to this buffer including its owner
     char     buf_[len];
+    uint16_t get_cap() const;
+    const char *get_data() const;
     void dealloc();
     static net_buf *alloc();
+
+    // allocate smallest size class holding min_len (or largest class)
+    static net_buf *alloc( size_t min_len );
+
+    // allocate buffer referencing the content of ptr until deallocated
+    static net_buf *alloc_ref( net_buf *ptr );
+
+    // capacity of size class
+    static uint16_t get_cls_cap( unsigned cls );
+
+    // per-thread allocation counters by size class
+    static uint64_t get_num_hit( unsigned cls );
+    static uint64_t get_num_miss( unsigned cls );
+
+    // per-thread buffers cached on the free list of size class and the
+    // most cached before half of them are handed to the shared pool
+    static unsigned get_num_free( unsigned cls );
+    static unsigned get_max_free( unsigned cls );
   };
 
   // network message writer
@@ -29,14 +62,18 @@ namespace pc
     void add( char );
     void add( str );
     void add( net_wtr& );
+    void add_copy( const net_wtr& );
     void detach( net_buf *&hd, net_buf *&tl );
     size_t size() const;
     void print() const;
     void reset();
 
+    // append content to string
+    void copy_to( std::string& ) const;
+
   protected:
     void add_alloc( str );
-    void alloc();
+    void alloc( size_t min_len = 0 );
     void dealloc();
     void advance( size_t len );
     char *reserve( size_t len );
@@ -56,14 +93,37 @@ namespace pc
   };
 
   class net_socket;
+  class net_uring;
 
-  // epoll-based loop
+  // epoll or io_uring-based loop
   class net_loop : public error
   {
   public:
     net_loop();
     ~net_loop();
 
+    // use io_uring instead of epoll (set before init)
+    void set_use_uring( bool );
+    bool get_use_uring() const;
+
+    // is io_uring in use (false if kernel lacks support)
+    bool get_is_uring() const;
+
+    // SO_BUSY_POLL usecs applied to sockets as they are added (0=off)
+    void set_busy_poll( int usecs );
+    int get_busy_poll() const;
+
+    // measure kernel receive to parser dispatch latency (off by default)
+    void set_latency( bool );
+    bool get_latency() const;
+
+    // wake-to-dispatch latency statistics in nanoseconds
+    void add_latency( int64_t );
+    uint64_t get_num_latency() const;
+    int64_t get_avg_latency() const;
+    int64_t get_max_latency() const;
+    void reset_latency();
+
     // initialize
     bool init();
 
@@ -74,11 +134,23 @@ namespace pc
     // poll all connected sockets
     bool poll( int timeout );
 
+    // wait up to timeout for socket events without dispatching them
+    bool wait( int timeout );
+
   private:
 
     static const int max_events_ = 128;
 
+    void add_opts( net_socket * );
+
     int         fd_;                 // epoll file descriptor
+    bool        use_ur_;             // try io_uring on init
+    bool        do_lat_;             // measure dispatch latency
+    int         busy_us_;            // SO_BUSY_POLL usecs
+    uint64_t    lat_num_;            // number of latency samples
+    int64_t     lat_tot_;            // total latency
+    int64_t     lat_max_;            // max latency
+    net_uring  *ur_;                 // io_uring rings if in use
     epoll_event ev_[1];              // event used in epoll_ctl
     epoll_event evarr_[max_events_]; // receive events
   };
@@ -109,6 +181,10 @@ namespace pc
     void set_in_loop( bool );
     bool get_in_loop() const;
 
+    // slot index used by io_uring net_loop
+    void set_loop_idx( uint32_t );
+    uint32_t get_loop_idx() const;
+
     // initialize
     virtual bool init();
 
@@ -121,6 +197,7 @@ namespace pc
   private:
     int        fd_;  // socket
     bool       inl_; // in-loop flag
+    uint32_t   lix_; // net_loop slot index
     net_loop  *lp_;  // optional event_loop
   };
 
@@ -142,9 +219,21 @@ namespace pc
     // add message to send queue
     void add_send( net_wtr& );
 
+    // add references to a chain of buffers shared with other connections
+    // to the send queue. the chain is left intact
+    void add_send_ref( net_buf *hd );
+
     // any messages in the send queue
     bool get_is_send() const;
 
+    // bytes in the send queue not yet written
+    size_t get_send_size() const;
+
+    // unparsed inbound and unwritten outbound bytes, e.g. to hand the
+    // connection over to another process
+    void get_queued( std::string& rbuf, std::string& wbuf ) const;
+    void set_queued( const std::string& rbuf, const std::string& wbuf );
+
     // drop all outbound messages
     void teardown() override;
 
@@ -152,11 +241,14 @@ namespace pc
 
     typedef std::vector<char> buf_t;
     static const size_t buf_len = 2048;
+    static const unsigned max_iov = 64; // max buffers per sendmsg
     void poll_error( bool );
+    ssize_t recv_ts( char *buf, int64_t& rts );
 
     buf_t       rdr_; // inbound message read buffer
     net_buf    *whd_; // head of writer queue
     net_buf    *wtl_; // tail of writer queue
+    size_t      wqsz_;// bytes in writer queue
     size_t      rsz_; // current read position
     uint16_t    wsz_; // current write position
     net_parser *np_;  // message parser
@@ -228,12 +320,36 @@ namespace pc
     // are we waiting to connect
     virtual bool get_is_wait();
 
+    // no socket events until connected
+    void poll() override;
+
+    // host names are resolved on a background thread and cached so
+    // (re)connecting never blocks on dns. connect attempts are raced
+    // across the resolved addresses with a staggered start and the
+    // first to complete becomes the connection
+    typedef std::vector<sockaddr_storage> addr_vec_t;
+
+    // resolve host without blocking. returns false while pending and
+    // true with the addresses (empty on failure) once known
+    static bool resolve( const std::string& host, addr_vec_t& );
+
   private:
+    typedef std::vector<std::pair<int,size_t>> try_vec_t;
+
+    void connect_next();
+    void close_try();
+
     int         port_; // connection port
     bool        wait_; // is waiting to connect
+    bool        res_;  // is waiting for host resolution
     std::string host_; // connection host
     int64_t     sts_;  // start connect time
+    int64_t     ats_;  // start of last connect attempt
     int64_t     timeout_;
+    int         terr_; // error of last failed attempt
+    size_t      anxt_; // next address to try
+    addr_vec_t  addr_; // resolved addresses
+    try_vec_t   tvec_; // connect attempts in flight and address index
   };
 
   // listening tcp server
@@ -248,6 +364,9 @@ namespace pc
 
     bool init() override;
 
+    // listen on a bound socket, e.g. one handed over by another process
+    bool init( int fd );
+
   private:
     int port_; // listening port
   };
@@ -266,8 +385,32 @@ namespace pc
   class udp_socket : public net_socket
   {
   public:
+    udp_socket();
     bool init() override;
     void send( ip_addr *, const char *buf, size_t len );
+
+    // queue datagram for batched send - buf must remain valid until flush
+    void add_send( ip_addr *, const char *buf, size_t len );
+
+    // send all queued datagrams using as few sendmmsg calls as possible
+    void flush();
+
+    // number of datagrams and send system calls since construction
+    uint64_t get_num_sent() const;
+    uint64_t get_num_calls() const;
+
+  private:
+    struct pkt {
+      ip_addr    *addr_;
+      const char *buf_;
+      size_t      len_;
+    };
+    typedef std::vector<pkt> pkt_vec_t;
+    static const unsigned max_mmsg = 64; // datagrams per sendmmsg
+
+    pkt_vec_t pvec_;     // queued datagrams
+    uint64_t  num_sent_; // datagrams sent
+    uint64_t  num_call_; // send system calls
   };
 
   // http request message
@@ -285,11 +428,29 @@ namespace pc
   class http_client : public net_parser
   {
   public:
+    http_client();
     bool parse( const char *buf, size_t sz, size_t& len ) override;
     virtual void parse_status( int, const char *, size_t);
     virtual void parse_header( const char *hdr, size_t hdr_len,
                                const char *val, size_t val_len);
     virtual void parse_content( const char *content, size_t content_len );
+
+    // called once headers are complete - return true to receive the
+    // body incrementally via parse_part instead of parse_content
+    virtual bool parse_stream( size_t content_len );
+
+    // next piece of a streamed body - returns number of bytes consumed.
+    // unconsumed bytes are presented again once more data arrives.
+    // everything is treated as consumed on the last piece
+    virtual size_t parse_part( const char *buf, size_t len, bool is_last );
+
+    // abandon any partially received streamed body
+    void reset_stream();
+
+  private:
+    bool parse_body( const char *buf, size_t sz, size_t& len );
+
+    size_t left_;   // streamed body bytes remaining
   };
 
   class http_response : public http_request
@@ -338,6 +499,34 @@ namespace pc
     net_connect *np_;
   };
 
+  // permessage-deflate (RFC 7692) compression state for a websocket
+  class ws_deflate
+  {
+  public:
+    ws_deflate();
+    ~ws_deflate();
+
+    // reset compression context (e.g. on new connection)
+    void reset();
+
+    // compress message (consumes src) - false if not worth compressing
+    bool compress( net_wtr& src, net_wtr& tgt );
+
+    // decompress message into internal buffer which stays valid until
+    // the next decompress
+    bool decompress( const char *buf, size_t len,
+                     const char *&res, size_t& res_len );
+
+  private:
+    static const size_t min_len = 128; // smallest message to compress
+
+    typedef std::vector<char> buf_t;
+    void  *zin_;  // inflate stream
+    void  *zout_; // deflate stream
+    buf_t  ibuf_; // inflate output buffer
+    buf_t  obuf_; // deflate output buffer
+  };
+
   // websocket message builder
   class ws_wtr : public net_wtr
   {
@@ -351,6 +540,17 @@ namespace pc
     static const uint8_t pong_id   = 0xa;
 
     void commit( uint8_t opcode, net_wtr&, bool mask );
+
+    // compress message if compression state provided
+    void commit( uint8_t opcode, net_wtr&, bool mask, ws_deflate * );
+
+    // unmasked frame header only for payload queued separately
+    void commit_header( uint8_t opcode, size_t pay_len );
+
+  private:
+    void add_frame( uint8_t opcode, net_wtr&, bool mask, bool is_comp );
+    char *add_hdr( uint8_t opcode, size_t pay_len, bool mask, bool is_comp,
+                   size_t& hdsz );
   };
 
   class tx_sub
@@ -382,6 +582,11 @@ namespace pc
   {
   public:
     ws_connect();
+
+    // offer permessage-deflate in handshake (off by default)
+    void set_deflate( bool );
+    bool get_deflate() const;
+
     bool init() override;
     void check() override;
     bool get_is_wait() override;
@@ -389,11 +594,17 @@ namespace pc
   private:
     struct ws_connect_init : public http_client {
       void parse_status( int, const char *, size_t) override;
+      void parse_header( const char *hdr, size_t hdr_len,
+                         const char *val, size_t val_len) override;
       ws_connect *cp_;
       net_parser *np_;
       bool        hs_;
+      bool        zs_; // permessage-deflate accepted
     };
+    void send_upgrade();
     ws_connect_init init_;
+    bool            zoff_; // offer permessage-deflate
+    bool            up_;   // upgrade request sent
   };
 
   // websocket client protocol impl
@@ -412,10 +623,44 @@ namespace pc
     // callback on websocket message
     virtual void parse_msg( const char *buf, size_t sz );
 
+    // message passed to parse_msg arrived as binary (not text) frame
+    bool get_is_binary() const;
+
+    // accept permessage-deflate when offered by client (off by default)
+    void set_allow_deflate( bool );
+    bool get_allow_deflate() const;
+
+    // permessage-deflate negotiated on connection
+    void set_is_deflate( bool );
+    bool get_is_deflate() const;
+
+    // compression state for outbound messages if negotiated
+    ws_deflate *get_ws_deflate();
+
   protected:
     typedef std::vector<char> buf_t;
+    void parse_comp( const char *buf, size_t sz );
+
     buf_t        msg_;
     net_connect *wptr_;
+    ws_deflate   zs_;   // permessage-deflate state
+    bool         zok_;  // allow permessage-deflate
+    bool         zon_;  // permessage-deflate negotiated
+    bool         zmsg_; // fragmented message is compressed
+    bool         bmsg_; // current message is binary
+  };
+
+  // object key rendered once as ,"key": for frequently written keys
+  class json_key
+  {
+  public:
+    explicit json_key( str key );
+
+    // rendered key, without leading separator if first in object
+    str get_text( bool is_first ) const;
+
+  private:
+    std::string txt_;
   };
 
   class json_wtr : public net_wtr
@@ -446,6 +691,12 @@ namespace pc
     void add_key_verbatim( str key, str );
     void add_key_enc_base58( str key, str val );
 
+    // add key/value pair using pre-rendered key
+    void add_key( const json_key& key, str val );
+    void add_key( const json_key& key, int64_t val );
+    void add_key( const json_key& key, uint64_t val );
+    void add_key( const json_key& key, type_t );
+
     // add array value
     void add_val( str val );
     void add_val( uint64_t );
@@ -457,11 +708,15 @@ namespace pc
     void add_val_enc_base58( str val );
     void add_val_enc_base64( str val );
 
+    // add pre-rendered array value or object key/value pairs
+    void add_verbatim( str );
+
   private:
 
     typedef std::vector<type_t> type_vec_t;
 
     void add_key_only( str key );
+    void add_key_only( const json_key& key );
     void add_obj();
     void add_arr();
     void add_first();
@@ -478,6 +733,16 @@ namespace pc
   /////////////////////////////////////////////////////////////////////////
   // inline impl.
 
+  inline uint16_t net_buf::get_cap() const
+  {
+    return get_cls_cap( cls_ );
+  }
+
+  inline const char *net_buf::get_data() const
+  {
+    return PC_LIKELY( cls_ != ref_cls ) ? buf_ : (*(net_buf**)buf_)->buf_;
+  }
+
   inline bool ip_addr::operator==( const ip_addr& obj ) const
   {
     return i_[0] == obj.i_[0] && i_[1] == obj.i_[1];
@@ -0,0 +1,46 @@
+#include "price_arena.hpp"
+#include "huge_page.hpp"
+#include <algorithm>
+
+using namespace pc;
+
+price_arena::price_arena()
+: rnxt_( nullptr ),
+  rrem_( 0UL )
+{
+}
+
+price_arena::~price_arena()
+{
+  for( char *reg: rvec_ ) {
+    huge_page::dealloc( reg );
+  }
+  rvec_.clear();
+  bvec_.clear();
+}
+
+unsigned price_arena::add()
+{
+  unsigned idx = size();
+  if ( idx % block_num == 0 ) {
+    const size_t blk_len = block_num * slot_len;
+    if ( rrem_ < blk_len ) {
+      size_t len = blk_len;
+      if ( huge_page::get_enabled() ) {
+        len = std::max( blk_len, huge_page::fit_len / blk_len * blk_len );
+      }
+      rnxt_ = static_cast< char* >( huge_page::alloc( len ) );
+      rrem_ = len;
+      rvec_.push_back( rnxt_ );
+    }
+    bvec_.push_back( rnxt_ );
+    rnxt_ += blk_len;
+    rrem_ -= blk_len;
+  }
+  __builtin_memset( get_account( idx ), 0, slot_len );
+  px_.push_back( 0L );
+  conf_.push_back( 0UL );
+  slot_.push_back( 0UL );
+  st_.push_back( 0U );
+  return idx;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <pc/rpc_client.hpp>
+#include <oracle/oracle.h>
+#include <algorithm>
+#include <vector>
+
+namespace pc
+{
+
+  // storage for decoded price accounts of one manager. accounts are
+  // packed back to back in blocks of cache-line aligned slots sized to
+  // the largest price account on chain (pythnet accounts are larger
+  // than pc_price_t), so slots keep their address as prices are added and
+  // hold all of the account that capture and snapshot copy. the
+  // aggregate of every account is also kept in a structure of arrays so
+  // scanning all symbols does not touch the accounts themselves. with
+  // huge pages enabled blocks are carved from huge page sized regions
+  class price_arena
+  {
+  public:
+
+    // accounts per block
+    static const unsigned block_num = 64;
+
+    // account slot size
+    static const size_t slot_len = ( std::max( sizeof( pc_price_t ),
+        static_cast< size_t >( ZSTD_UPPER_BOUND ) ) + 63UL ) & ~63UL;
+
+    price_arena();
+    ~price_arena();
+
+    // allocate zeroed account slot and return its index
+    unsigned add();
+
+    // number of allocated accounts
+    unsigned size() const;
+
+    // account by index
+    pc_price_t *get_account( unsigned idx );
+
+    // copy aggregate from account into hot arrays
+    void update_agg( unsigned idx );
+
+    // aggregate by account index
+    int64_t       get_price( unsigned idx ) const;
+    uint64_t      get_conf( unsigned idx ) const;
+    uint64_t      get_pub_slot( unsigned idx ) const;
+    symbol_status get_status( unsigned idx ) const;
+
+  private:
+
+    typedef std::vector<char*>    blk_vec_t;
+    typedef std::vector<int64_t>  px_vec_t;
+    typedef std::vector<uint64_t> u64_vec_t;
+    typedef std::vector<uint32_t> u32_vec_t;
+
+    price_arena( const price_arena& );
+    price_arena& operator=( const price_arena& );
+
+    blk_vec_t bvec_;
+    blk_vec_t rvec_;  // allocated regions of one or more blocks
+    char     *rnxt_;  // next free block in last region
+    size_t    rrem_;  // bytes left in last region
+    px_vec_t  px_;
+    u64_vec_t conf_;
+    u64_vec_t slot_;
+    u32_vec_t st_;
+  };
+
+  inline unsigned price_arena::size() const
+  {
+    return static_cast< unsigned >( px_.size() );
+  }
+
+  inline pc_price_t *price_arena::get_account( unsigned idx )
+  {
+    return (pc_price_t*)&bvec_[idx / block_num][( idx % block_num )*slot_len];
+  }
+
+  inline void price_arena::update_agg( unsigned idx )
+  {
+    const pc_price_t *pptr = get_account( idx );
+    px_[idx]   = pptr->agg_.price_;
+    conf_[idx] = pptr->agg_.conf_;
+    slot_[idx] = pptr->agg_.pub_slot_;
+    st_[idx]   = pptr->agg_.status_;
+  }
+
+  inline int64_t price_arena::get_price( unsigned idx ) const
+  {
+    return px_[idx];
+  }
+
+  inline uint64_t price_arena::get_conf( unsigned idx ) const
+  {
+    return conf_[idx];
+  }
+
+  inline uint64_t price_arena::get_pub_slot( unsigned idx ) const
+  {
+    return slot_[idx];
+  }
+
+  inline symbol_status price_arena::get_status( unsigned idx ) const
+  {
+    return (symbol_status)st_[idx];
+  }
+
+}
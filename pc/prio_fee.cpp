@@ -0,0 +1,119 @@
+#include "prio_fee.hpp"
+#include <algorithm>
+
+using namespace pc;
+
+const uint64_t prio_fee::min_boost;
+
+prio_fee::prio_fee()
+: min_( 0U ),
+  max_( 0U ),
+  pct_( 75U ),
+  target_( 90U ),
+  cu_price_( 0U ),
+  market_( 0UL ),
+  boost_( 0UL ),
+  num_sent_( 0UL ),
+  num_recv_( 0UL ),
+  rate_( 0. )
+{
+}
+
+void prio_fee::set_min_cu_price( unsigned cu_price )
+{
+  min_ = cu_price;
+}
+
+unsigned prio_fee::get_min_cu_price() const
+{
+  return min_;
+}
+
+void prio_fee::set_max_cu_price( unsigned cu_price )
+{
+  max_ = cu_price;
+}
+
+unsigned prio_fee::get_max_cu_price() const
+{
+  return max_;
+}
+
+bool prio_fee::get_is_adaptive() const
+{
+  return max_ > min_;
+}
+
+void prio_fee::set_percentile( unsigned pct )
+{
+  pct_ = std::min( pct, 100U );
+}
+
+unsigned prio_fee::get_percentile() const
+{
+  return pct_;
+}
+
+void prio_fee::set_target_rate( unsigned rate )
+{
+  target_ = std::min( rate, 100U );
+}
+
+unsigned prio_fee::get_target_rate() const
+{
+  return target_;
+}
+
+unsigned prio_fee::get_cu_price() const
+{
+  if ( !get_is_adaptive() ) {
+    return min_;
+  }
+  return std::min( std::max( cu_price_, min_ ), max_ );
+}
+
+uint64_t prio_fee::get_market_price() const
+{
+  return market_;
+}
+
+uint64_t prio_fee::get_boost() const
+{
+  return boost_;
+}
+
+double prio_fee::get_landing_rate() const
+{
+  return rate_;
+}
+
+void prio_fee::update(
+    std::vector<uint64_t>& fees, uint64_t num_sent, uint64_t num_recv )
+{
+  // market price over recent slots
+  if ( !fees.empty() ) {
+    auto it = fees.begin() + static_cast< std::ptrdiff_t >(
+        ( fees.size() - 1 ) * pct_ / 100U );
+    std::nth_element( fees.begin(), it, fees.end() );
+    market_ = *it;
+  }
+
+  // landing rate since last update. raise the boost while updates are
+  // being dropped and decay it once they land again
+  uint64_t dsent = num_sent - num_sent_;
+  uint64_t drecv = std::min( num_recv - num_recv_, dsent );
+  num_sent_ = num_sent;
+  num_recv_ = num_recv;
+  if ( dsent ) {
+    rate_ = ( 100. * drecv ) / dsent;
+    if ( rate_ < target_ ) {
+      boost_ = std::max( 2 * boost_, std::max( market_ / 4, min_boost ) );
+    } else {
+      boost_ /= 2;
+    }
+  }
+  boost_ = std::min( boost_, (uint64_t)max_ );
+
+  uint64_t cu_price = std::min( market_ + boost_, (uint64_t)max_ );
+  cu_price_ = std::max( static_cast< unsigned >( cu_price ), min_ );
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace pc
+{
+
+  // adaptive compute unit price (priority fee) of price update
+  // transactions. tracks a percentile of the fees recently paid to write
+  // to our price accounts and raises or lowers a boost on top of it
+  // depending on how many of our updates land on chain
+  class prio_fee
+  {
+  public:
+
+    // smallest boost applied once updates stop landing
+    static const uint64_t min_boost = 1000UL;
+
+    prio_fee();
+
+    // price per CU (micro-lamports) when not adaptive and lower bound
+    // otherwise
+    void set_min_cu_price( unsigned );
+    unsigned get_min_cu_price() const;
+
+    // upper bound on price per CU. adaptive if above the minimum
+    void set_max_cu_price( unsigned );
+    unsigned get_max_cu_price() const;
+    bool get_is_adaptive() const;
+
+    // percentile of recent fees taken as the market price (default 75)
+    void set_percentile( unsigned );
+    unsigned get_percentile() const;
+
+    // landing rate in percent below which the boost is raised
+    // (default 90)
+    void set_target_rate( unsigned );
+    unsigned get_target_rate() const;
+
+    // price per CU to use for the next batch
+    unsigned get_cu_price() const;
+
+    // results of last update
+    uint64_t get_market_price() const;
+    uint64_t get_boost() const;
+    double   get_landing_rate() const;
+
+    // update from recent prioritization fees (reordered in place) and
+    // the cumulative number of prices sent and observed on chain
+    void update( std::vector<uint64_t>& fees,
+                 uint64_t num_sent, uint64_t num_recv );
+
+  private:
+    unsigned min_;
+    unsigned max_;
+    unsigned pct_;
+    unsigned target_;
+    unsigned cu_price_;
+    uint64_t market_;
+    uint64_t boost_;
+    uint64_t num_sent_;
+    uint64_t num_recv_;
+    double   rate_;
+  };
+
+}
@@ -1,18 +1,140 @@
 #include "pub_stats.hpp"
 #include "misc.hpp"
+#include <algorithm>
 
 using namespace pc;
 
+lat_hist::lat_hist()
+{
+  clear();
+}
+
+void lat_hist::clear()
+{
+  num_ = 0UL;
+  sum_ = 0L;
+  max_ = 0L;
+  __builtin_memset( hist_, 0, sizeof( hist_ ) );
+}
+
+unsigned lat_hist::get_bucket( int64_t ns )
+{
+  uint64_t val = ns > 0L ? static_cast< uint64_t >( ns ) : 0UL;
+  if ( val < 2 * num_sub ) {
+    return static_cast< unsigned >( val );
+  }
+  unsigned bits = static_cast< unsigned >( 64 - __builtin_clzl( val ) );
+  if ( bits > max_bits ) {
+    return num_buckets - 1;
+  }
+  unsigned exp = bits - sub_bits - 1;
+  return num_sub * ( exp + 1 ) +
+    static_cast< unsigned >( ( val >> exp ) - num_sub );
+}
+
+int64_t lat_hist::get_value( unsigned bucket )
+{
+  if ( bucket < 2 * num_sub ) {
+    return bucket;
+  }
+  unsigned exp = bucket / num_sub - 1;
+  uint64_t mant = num_sub + bucket % num_sub;
+  return static_cast< int64_t >( mant << exp );
+}
+
+void lat_hist::merge( const lat_hist& h )
+{
+  for( unsigned i = 0; i != num_buckets; ++i ) {
+    hist_[i] += h.hist_[i];
+  }
+  num_ += h.num_;
+  sum_ += h.sum_;
+  max_ = std::max( max_, h.max_ );
+}
+
+uint64_t lat_hist::get_num() const
+{
+  return num_;
+}
+
+int64_t lat_hist::get_sum() const
+{
+  return sum_;
+}
+
+int64_t lat_hist::get_max() const
+{
+  return max_;
+}
+
+int64_t lat_hist::get_quantile( double q ) const
+{
+  // report the middle of the bucket holding the quantile
+  uint64_t cnt = static_cast< uint64_t >( q * (double)num_ + 0.5 );
+  cnt = std::max( std::min( cnt, num_ ), 1UL );
+  uint64_t cum = 0UL;
+  for( unsigned i = 0; i != num_buckets && num_; ++i ) {
+    cum += hist_[i];
+    if ( cum >= cnt ) {
+      int64_t lo = get_value( i );
+      int64_t hi = i + 1 != num_buckets ? get_value( i + 1 ) : lo + 1;
+      return std::min( lo + ( hi - lo - 1 ) / 2, max_ );
+    }
+  }
+  return 0L;
+}
+
 pub_stats::pub_stats()
+: land_pub_( 0UL ),
+  lat_( nullptr )
 {
   clear_stats();
 }
 
+pub_stats::~pub_stats()
+{
+  delete [] lat_;
+}
+
 void pub_stats::clear_stats()
 {
   num_agg_ = num_sent_ = num_recv_ = num_sub_drop_ =
-    agg_slot_ = pub_slot_ = 0UL;
+    num_land_ = num_lost_ = land_slots_ =
+    agg_slot_ = pub_slot_ = sent_slot_ = 0UL;
+  recv_ts_ = sent_ts_ = 0L;
   __builtin_memset( shist_, 0, sizeof( shist_ ) );
+  delete [] lat_;
+  lat_ = nullptr;
+}
+
+const lat_hist *pub_stats::get_latency( pub_lat lat ) const
+{
+  return lat_ ? &lat_[lat] : nullptr;
+}
+
+void pub_stats::add_latency( pub_lat lat, int64_t ns )
+{
+  if ( PC_UNLIKELY( !lat_ ) ) {
+    lat_ = new lat_hist[e_lat_num];
+  }
+  lat_[lat].add( ns );
+}
+
+void pub_stats::add_pub_sent( int64_t ts, uint64_t pub_slot )
+{
+  if ( recv_ts_ ) {
+    add_latency( e_lat_send, ts - recv_ts_ );
+    recv_ts_ = 0L;
+  }
+  if ( !sent_ts_ ) {
+    sent_ts_   = ts;
+    sent_slot_ = pub_slot;
+  }
+}
+
+void pub_stats::add_pub_ack( int64_t dur )
+{
+  add_latency( e_lat_ack, dur );
 }
 
 uint64_t pub_stats::get_num_agg() const
@@ -40,12 +162,38 @@ double pub_stats::get_hit_rate() const
   return num_sent_ ? (100.*num_recv_)/num_sent_ : 0.;
 }
 
+uint64_t pub_stats::get_num_land() const
+{
+  return num_land_;
+}
+
+uint64_t pub_stats::get_num_lost() const
+{
+  return num_lost_;
+}
+
+double pub_stats::get_land_rate() const
+{
+  uint64_t num = num_land_ + num_lost_;
+  return num ? (100.*num_land_)/num : 0.;
+}
+
+double pub_stats::get_land_slots() const
+{
+  return num_land_ ? double( land_slots_ )/num_land_ : 0.;
+}
+
 void pub_stats::add_recv(
-    uint64_t curr_slot, uint64_t agg_slot,  uint64_t pub_slot )
+    uint64_t curr_slot, uint64_t agg_slot,  uint64_t pub_slot, int64_t ts )
 {
   if ( PC_UNLIKELY( num_sent_ == 0UL ) ) {
     return;
   }
+  if ( sent_ts_ && ts && pub_slot >= sent_slot_ ) {
+    // the oldest update not yet seen made it into the aggregate
+    add_latency( e_lat_agg, ts - sent_ts_ );
+    sent_ts_ = 0L;
+  }
   if ( pub_slot_ ) {
     uint64_t dslot = curr_slot>pub_slot?curr_slot - pub_slot:0UL;
     ++shist_[dslot<num_buckets?dslot:num_buckets-1];
@@ -1,16 +1,68 @@
 #pragma once
 
+#include <algorithm>
 #include <stdint.h>
 
 namespace pc
 {
 
+  // log-linear latency histogram in nanoseconds. values below 64ns are
+  // counted exactly and larger values in 32 buckets per power of two,
+  // i.e. to within about 3%, up to 2^36ns (about 68s)
+  class lat_hist
+  {
+  public:
+
+    static const unsigned sub_bits    = 5;
+    static const unsigned num_sub     = 1U << sub_bits;
+    static const unsigned max_bits    = 36;
+    static const unsigned num_buckets =
+      num_sub * ( max_bits - sub_bits + 1 );
+
+    lat_hist();
+
+    // add value
+    void add( int64_t ns );
+
+    // add counts of another histogram
+    void merge( const lat_hist& );
+
+    // number of values, their sum and largest value
+    uint64_t get_num() const;
+    int64_t get_sum() const;
+    int64_t get_max() const;
+
+    // value at quantile q in [0,1] (0 if empty)
+    int64_t get_quantile( double q ) const;
+
+    void clear();
+
+    // bucket of value and lowest value of bucket
+    static unsigned get_bucket( int64_t ns );
+    static int64_t get_value( unsigned bucket );
+
+  private:
+    uint64_t num_;
+    int64_t  sum_;
+    int64_t  max_;
+    uint32_t hist_[num_buckets];
+  };
+
+  // publish latencies
+  enum pub_lat : unsigned {
+    e_lat_send = 0,   // publisher update received to batch sent
+    e_lat_ack,        // batch sent to rpc sendTransaction reply
+    e_lat_agg,        // batch sent to component in aggregate
+    e_lat_num
+  };
+
   // publish statistics
   class pub_stats
   {
   public:
 
     pub_stats();
+    ~pub_stats();
 
     // number of prices submited
     uint64_t get_num_sent() const;
@@ -30,15 +82,41 @@ namespace pc
     // price updates relative to the number sent
     double get_hit_rate() const;
 
+    // transactions with our updates found on chain by signature and
+    // those that expired or failed (see land_track)
+    uint64_t get_num_land() const;
+    uint64_t get_num_lost() const;
+
+    // percent of tracked transactions that landed and their mean
+    // latency in slots from publish slot to landing slot
+    double get_land_rate() const;
+    double get_land_slots() const;
+
+    // publish slot of the latest tracked update that landed (0 if none)
+    uint64_t get_land_pub_slot() const;
+
     // get (rough) quartiles of publish end-to-end latency in slots
     // up to a maximum of 32 slots
     void get_slot_quartiles( uint32_t q[4] ) const;
 
+    // publish latency histogram or null if nothing recorded
+    const lat_hist *get_latency( pub_lat ) const;
+
     // clear-down statistics
     void clear_stats();
 
     // add slot and the time it was received
-    void add_recv( uint64_t slot, uint64_t agg_slot, uint64_t pub_slot );
+    void add_recv( uint64_t slot, uint64_t agg_slot, uint64_t pub_slot,
+                   int64_t ts = 0L );
+
+    // publisher update received. the oldest update of a batch counts
+    void add_pub_recv( int64_t ts );
+
+    // update of pub_slot sent at ts
+    void add_pub_sent( int64_t ts, uint64_t pub_slot );
+
+    // reply to sendTransaction of a batch sent dur nanoseconds ago
+    void add_pub_ack( int64_t dur );
 
     // increment subscription drop event
     void inc_sub_drop();
@@ -46,19 +124,46 @@ namespace pc
     // increment number of prices sent
     void inc_sent();
 
+    // transaction landed dslot slots after publish slot or was lost
+    void add_land( uint64_t pub_slot, uint64_t dslot );
+    void inc_lost();
+
   private:
 
     static constexpr const uint64_t num_buckets = 32;
 
+    void add_latency( pub_lat, int64_t );
+
     uint64_t num_sent_;
     uint64_t num_recv_;
     uint64_t num_agg_;
     uint64_t num_sub_drop_;
+    uint64_t num_land_;
+    uint64_t num_lost_;
+    uint64_t land_slots_; // sum of landing latency in slots
+    uint64_t land_pub_;
     uint64_t agg_slot_;
     uint64_t pub_slot_;
     uint32_t shist_[num_buckets];
+    int64_t  recv_ts_;  // oldest unsent publisher update
+    int64_t  sent_ts_;  // oldest sent update not yet in aggregate
+    uint64_t sent_slot_;
+    lat_hist *lat_;     // e_lat_num histograms allocated on first use
   };
 
+  inline void lat_hist::add( int64_t ns )
+  {
+    ++hist_[get_bucket( ns )];
+    ++num_;
+    sum_ += ns;
+    max_ = ns > max_ ? ns : max_;
+  }
+
+  inline void pub_stats::add_pub_recv( int64_t ts )
+  {
+    recv_ts_ = recv_ts_ ? recv_ts_ : ts;
+  }
+
   inline void pub_stats::inc_sub_drop()
   {
     ++num_sub_drop_;
@@ -69,4 +174,21 @@ namespace pc
     ++num_sent_;
   }
 
+  inline void pub_stats::add_land( uint64_t pub_slot, uint64_t dslot )
+  {
+    ++num_land_;
+    land_slots_ += dslot;
+    land_pub_ = std::max( land_pub_, pub_slot );
+  }
+
+  inline uint64_t pub_stats::get_land_pub_slot() const
+  {
+    return land_pub_;
+  }
+
+  inline void pub_stats::inc_lost()
+  {
+    ++num_lost_;
+  }
+
 }
@@ -1,4 +1,10 @@
 #include "replay.hpp"
+#include "capture.hpp"
+#include <zstd.h>
+#include <algorithm>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace pc;
 
@@ -9,13 +15,42 @@ replay::replay()
   buf_( nullptr ),
   pos_( 0 ),
   len_( 0 ),
-  zfd_( nullptr )
+  zfd_( nullptr ),
+  fd_( -1 ),
+  is_strm_( false ),
+  is_delta_( false ),
+  rbuf_( nullptr ),
+  rpos_( 0 ),
+  rlen_( 0 ),
+  dict_( nullptr ),
+  cxt_( nullptr ),
+  is_blk_( false ),
+  has_idx_( false ),
+  slot_( 0UL ),
+  boff_( 0UL ),
+  bend_( 0UL ),
+  bnxt_( 0U ),
+  bpos_( 0UL ),
+  cleft_( 0UL ),
+  bptr_( nullptr ),
+  blen_( 0UL ),
+  has_acc_( false ),
+  fpos_( 0U ),
+  fnum_( 0U ),
+  min_ts_( 0L ),
+  min_slot_( 0UL ),
+  nthr_( 0U ),
+  seq_( 0UL ),
+  curr_( nullptr ),
+  is_pool_( false ),
+  is_run_( false )
 {
   buf_ = new char[buf_sz];
 }
 
 replay::~replay()
 {
+  stop_pool();
   if ( zfd_ ) {
     ::gzclose( zfd_ );
     zfd_ = nullptr;
@@ -24,6 +59,18 @@ replay::~replay()
     delete [] buf_;
     buf_ = nullptr;
   }
+  if ( fd_ >= 0 ) {
+    ::close( fd_ );
+    fd_ = -1;
+  }
+  if ( rbuf_ ) {
+    delete [] rbuf_;
+    rbuf_ = nullptr;
+  }
+  if ( cxt_ ) {
+    ZSTD_freeDCtx( (ZSTD_DCtx*)cxt_ );
+    cxt_ = nullptr;
+  }
 }
 
 void replay::set_file( const std::string& cap_file )
@@ -36,13 +83,87 @@ std::string replay::get_file() const
   return file_;
 }
 
+void replay::set_zstd_dict( const zstd_dict *dict )
+{
+  dict_ = dict;
+}
+
+const zstd_dict *replay::get_zstd_dict() const
+{
+  return dict_;
+}
+
+void replay::set_threads( unsigned num )
+{
+  nthr_ = num;
+}
+
+unsigned replay::get_threads() const
+{
+  return nthr_;
+}
+
 bool replay::init()
 {
+  // capture appends .gz to files named without a suffix
   std::string file = file_;
-  size_t flen = file.length();
-  if ( flen >=3 && file.substr(flen-3) != ".gz" ) {
+  struct stat fst[1];
+  if ( 0 != ::stat( file.c_str(), fst ) &&
+       0 == ::stat( ( file + ".gz" ).c_str(), fst ) ) {
     file += ".gz";
   }
+  if ( fd_ >= 0 ) {
+    ::close( fd_ );
+  }
+  if ( zfd_ ) {
+    ::gzclose( zfd_ );
+    zfd_ = nullptr;
+  }
+  fd_ = ::open( file.c_str(), O_RDONLY );
+  if ( fd_ < 0 ) {
+    return set_err_msg( "failed to open file=" + file, errno );
+  }
+
+  is_delta_ = false;
+  dmap_.clear();
+  dvec_.clear();
+  slot_ = 0UL;
+  min_ts_ = 0L;
+  min_slot_ = 0UL;
+
+  // zstd streams start with a frame and frame captures with the
+  // length of the first frame
+  uint32_t magic[2] = { 0, 0 };
+  ssize_t mlen = ::pread( fd_, magic, sizeof( magic ), 0 );
+  uint64_t bmagic = 0UL;
+  __builtin_memcpy( &bmagic, magic, sizeof( bmagic ) );
+  is_blk_ = mlen == sizeof( magic ) && bmagic == capture::blk_magic;
+  is_strm_ = mlen >= 4 && magic[0] == ZSTD_MAGICNUMBER;
+  if ( is_blk_ || is_strm_ || ( mlen == sizeof( magic ) &&
+                                magic[1] == ZSTD_MAGICNUMBER ) ) {
+    if ( !rbuf_ ) {
+      rbuf_ = new char[buf_sz];
+    }
+    if ( !cxt_ ) {
+      cxt_ = ZSTD_createDCtx();
+    }
+    ZSTD_DCtx_reset( (ZSTD_DCtx*)cxt_, ZSTD_reset_session_only );
+    rpos_ = rlen_ = 0;
+    pos_ = len_ = 0;
+    if ( is_blk_ ) {
+      stop_pool();
+      if ( !init_blk() ) {
+        return false;
+      }
+      if ( nthr_ ) {
+        mmap_.set_file( file );
+        return map_blk();
+      }
+    }
+    return true;
+  }
+  ::close( fd_ );
+  fd_ = -1;
   zfd_ = ::gzopen( file.c_str(), "r" );
   if ( !zfd_ ) {
     return set_err_msg( "failed to open file=" + file );
@@ -57,6 +178,438 @@ bool replay::init()
 }
 
 bool replay::get_next()
+{
+  for(;;) {
+    bool is_ok = is_blk_ ? get_next_blk() :
+      ( fd_ >= 0 && !is_strm_ ? get_next_zstd() : get_next_gz() );
+    if ( !is_ok ) {
+      return false;
+    }
+    if ( PC_UNLIKELY( is_delta_ ||
+                      up_->acc_.magic_ == capture::delta_magic ) ) {
+      int rc = get_delta();
+      if ( rc < 0 ) {
+        return false;
+      } else if ( rc == 0 ) {
+        continue;
+      }
+    }
+    // records before a seek are still read for the deltas that follow
+    if ( PC_LIKELY( up_->ts_ >= min_ts_ && slot_ >= min_slot_ &&
+                    ( !has_acc_ || fkey_ == *(pub_key*)&up_->key_ ) ) ) {
+      return true;
+    }
+  }
+}
+
+void replay::set_account( const pc_pub_key_t *key )
+{
+  has_acc_ = key != nullptr;
+  fpos_ = fnum_ = 0U;
+  if ( key ) {
+    fkey_ = *(const pub_key*)key;
+    acc_map_t::iter_t it = amap_.find( fkey_ );
+    if ( it ) {
+      const capture::blk_acc& acc = bacc_[amap_.obj( it )];
+      fpos_ = acc.pos_;
+      fnum_ = acc.num_;
+    }
+  }
+  if ( is_blk_ ) {
+    min_ts_ = 0L;
+    min_slot_ = 0UL;
+    boff_ = sizeof( capture::blk_magic );
+    seek_blk( 0U );
+  } else if ( fd_ >= 0 || zfd_ ) {
+    init();
+  }
+}
+
+bool replay::seek_time( int64_t ts )
+{
+  if ( !has_idx_ ) {
+    return set_err_msg( "capture file has no index file=" + file_ );
+  }
+  blk_vec_t::iterator it = std::partition_point(
+      bidx_.begin(), bidx_.end(),
+      [ts]( const capture::blk_idx& idx ) { return idx.ts1_ < ts; } );
+  min_ts_ = ts;
+  min_slot_ = 0UL;
+  seek_blk( static_cast< uint32_t >( it - bidx_.begin() ) );
+  return true;
+}
+
+bool replay::seek_slot( uint64_t slot )
+{
+  if ( !has_idx_ ) {
+    return set_err_msg( "capture file has no index file=" + file_ );
+  }
+  blk_vec_t::iterator it = std::partition_point(
+      bidx_.begin(), bidx_.end(),
+      [slot]( const capture::blk_idx& idx ) { return idx.slot1_ < slot; } );
+  min_ts_ = 0L;
+  min_slot_ = slot;
+  seek_blk( static_cast< uint32_t >( it - bidx_.begin() ) );
+  return true;
+}
+
+void replay::seek_blk( uint32_t blk )
+{
+  // next block read is the first at or after blk
+  bnxt_ = blk;
+  if ( has_acc_ && has_idx_ ) {
+    const uint32_t *lst = &blst_[fpos_];
+    bnxt_ = static_cast< uint32_t >(
+        std::lower_bound( lst, lst + fnum_, blk ) - lst );
+  }
+  bptr_ = nullptr;
+  blen_ = bpos_ = cleft_ = 0UL;
+  stop_pool();
+}
+
+bool replay::init_blk()
+{
+  // read index from the end of the file
+  struct stat fst[1];
+  if ( 0 != ::fstat( fd_, fst ) ) {
+    return set_err_msg( "failed to stat file=" + file_, errno );
+  }
+  uint64_t flen = static_cast< uint64_t >( fst->st_size );
+  has_idx_ = false;
+  bidx_.clear();
+  bacc_.clear();
+  blst_.clear();
+  amap_.clear();
+  boff_ = sizeof( capture::blk_magic );
+  bend_ = flen;
+  capture::blk_tail tail;
+  if ( flen < boff_ + sizeof( tail ) ||
+       sizeof( tail ) != ::pread( fd_, &tail, sizeof( tail ),
+                                  static_cast< off_t >( flen - sizeof( tail ) ) ) ||
+       tail.magic_ != capture::blk_magic ||
+       tail.idx_off_ < boff_ || tail.idx_off_ > flen - sizeof( tail ) ) {
+    seek_blk( 0U );
+    return true;
+  }
+  uint64_t ilen = flen - sizeof( tail ) - tail.idx_off_;
+  uint64_t alen = tail.nblk_ * sizeof( capture::blk_idx ) +
+                  tail.nacc_ * sizeof( capture::blk_acc );
+  std::vector<char> buf( ilen );
+  if ( alen > ilen || ( ilen - alen ) % sizeof( uint32_t ) ||
+       (ssize_t)ilen != ::pread( fd_, buf.data(), ilen,
+                                 static_cast< off_t >( tail.idx_off_ ) ) ) {
+    return set_err_msg( "corrupt capture index file=" + file_ );
+  }
+  const capture::blk_idx *iptr = (const capture::blk_idx*)buf.data();
+  const capture::blk_acc *aptr = (const capture::blk_acc*)&iptr[tail.nblk_];
+  const uint32_t *lptr = (const uint32_t*)&aptr[tail.nacc_];
+  bidx_.assign( iptr, iptr + tail.nblk_ );
+  bacc_.assign( aptr, aptr + tail.nacc_ );
+  blst_.assign( lptr, lptr + ( ilen - alen ) / sizeof( uint32_t ) );
+  for( uint32_t i = 0; i != tail.nacc_; ++i ) {
+    const capture::blk_acc& acc = bacc_[i];
+    if ( acc.pos_ > blst_.size() || acc.num_ > blst_.size() - acc.pos_ ) {
+      return set_err_msg( "corrupt capture index file=" + file_ );
+    }
+    pub_key key;
+    key.init_from_buf( (const uint8_t*)&aptr[i].acc_ );
+    amap_.ref( amap_.add( key ) ) = i;
+  }
+  for( uint32_t blk: blst_ ) {
+    if ( blk >= tail.nblk_ ) {
+      return set_err_msg( "corrupt capture index file=" + file_ );
+    }
+  }
+  has_idx_ = true;
+  bend_ = tail.idx_off_;
+  set_account( has_acc_ ? (const pc_pub_key_t*)fkey_.data() : nullptr );
+  return true;
+}
+
+bool replay::read_blk()
+{
+  if ( nthr_ ) {
+    return read_pool();
+  }
+  // next block in file, in the index or of the account
+  uint64_t off = boff_;
+  if ( has_idx_ ) {
+    uint32_t blk = bnxt_;
+    if ( has_acc_ ) {
+      if ( bnxt_ >= fnum_ ) {
+        return false;
+      }
+      blk = blst_[fpos_ + bnxt_];
+    } else if ( bnxt_ >= bidx_.size() ) {
+      return false;
+    }
+    ++bnxt_;
+    off = bidx_[blk].off_;
+  }
+  // a capture that was not closed can end in a partial block
+  capture::blk_hdr bhdr;
+  if ( off > bend_ || bend_ - off < sizeof( bhdr ) ||
+       sizeof( bhdr ) != ::pread( fd_, &bhdr, sizeof( bhdr ),
+                                  static_cast< off_t >( off ) ) ||
+       bhdr.zlen_ > bend_ - off - sizeof( bhdr ) ) {
+    return false;
+  }
+  zblk_.resize( bhdr.zlen_ );
+  blk_.resize( bhdr.len_ );
+  if ( (ssize_t)bhdr.zlen_ != ::pread( fd_, zblk_.data(), bhdr.zlen_,
+                    static_cast< off_t >( off + sizeof( bhdr ) ) ) ) {
+    return set_err_msg( "failed to read file=" + file_, errno );
+  }
+  if ( bhdr.zlen_ ) {
+    size_t len = ZSTD_decompressDCtx( (ZSTD_DCtx*)cxt_, blk_.data(),
+                                      blk_.size(), zblk_.data(), zblk_.size() );
+    if ( ZSTD_isError( len ) || len != blk_.size() ) {
+      return set_err_msg( "corrupt capture file=" + file_ );
+    }
+  }
+  boff_ = off + sizeof( bhdr ) + bhdr.zlen_;
+  bptr_ = blk_.data();
+  blen_ = blk_.size();
+  bpos_ = cleft_ = 0UL;
+  is_delta_ = false;
+  dmap_.clear();
+  dvec_.clear();
+  return true;
+}
+
+bool replay::get_next_blk()
+{
+  static const size_t hdr_sz = sizeof( int64_t ) + sizeof( pc_pub_key_t );
+  for(;;) {
+    size_t left = blen_ - bpos_;
+    if ( cleft_ == 0 && left >= sizeof( capture::blk_chunk ) ) {
+      capture::blk_chunk chk;
+      __builtin_memcpy( &chk, &bptr_[bpos_], sizeof( chk ) );
+      bpos_ += sizeof( chk );
+      left -= sizeof( chk );
+      slot_ = chk.slot_;
+      cleft_ = std::min( chk.size_, left );
+    }
+    if ( cleft_ >= sizeof( hdr ) ) {
+      up_ = (hdr*)&bptr_[bpos_];
+      size_t rlen = hdr_sz + up_->acc_.size_;
+      if ( rlen <= cleft_ ) {
+        bpos_ += rlen;
+        cleft_ -= rlen;
+        return true;
+      }
+    }
+    if ( cleft_ ) {
+      return set_err_msg( "corrupt capture file=" + file_ );
+    }
+    if ( bpos_ + sizeof( capture::blk_chunk ) > blen_ && !read_blk() ) {
+      return false;
+    }
+  }
+}
+
+bool replay::map_blk()
+{
+  // block offsets come from the index or the block headers
+  if ( !mmap_.init() ) {
+    return set_err_msg( "failed to map file=" + mmap_.get_file() );
+  }
+  bofs_.clear();
+  if ( has_idx_ ) {
+    for( const capture::blk_idx& idx: bidx_ ) {
+      bofs_.push_back( idx.off_ );
+    }
+    return true;
+  }
+  const char *buf = mmap_.data();
+  uint64_t end = std::min( bend_, static_cast< uint64_t >( mmap_.size() ) );
+  for( uint64_t off = sizeof( capture::blk_magic ); ; ) {
+    capture::blk_hdr bhdr;
+    if ( end - off < sizeof( bhdr ) ) {
+      break;
+    }
+    __builtin_memcpy( &bhdr, &buf[off], sizeof( bhdr ) );
+    if ( bhdr.zlen_ > end - off - sizeof( bhdr ) ) {
+      break;
+    }
+    bofs_.push_back( off );
+    off += sizeof( bhdr ) + bhdr.zlen_;
+  }
+  return true;
+}
+
+static void run_replay( replay *rep, unsigned idx )
+{
+  rep->run( idx );
+}
+
+void replay::start_pool()
+{
+  // worker i decompresses every nthr_-th block of the schedule
+  bsch_.clear();
+  if ( has_acc_ && has_idx_ ) {
+    for( uint32_t i = bnxt_; i < fnum_; ++i ) {
+      bsch_.push_back( blst_[fpos_ + i] );
+    }
+  } else {
+    for( uint32_t i = bnxt_; i < bofs_.size(); ++i ) {
+      bsch_.push_back( i );
+    }
+  }
+  seq_ = 0UL;
+  curr_ = nullptr;
+  is_run_ = true;
+  for( unsigned i = 0; i != nthr_; ++i ) {
+    worker *wp = new worker;
+    wp->cxt_ = ZSTD_createDCtx();
+    sem_init( &wp->free_, 0, max_ahead );
+    sem_init( &wp->done_, 0, 0 );
+    wvec_.push_back( wp );
+  }
+  for( unsigned i = 0; i != nthr_; ++i ) {
+    wvec_[i]->thrd_ = std::thread( run_replay, this, i );
+  }
+  is_pool_ = true;
+}
+
+void replay::stop_pool()
+{
+  if ( !is_pool_ ) {
+    return;
+  }
+  is_run_ = false;
+  for( worker *wp: wvec_ ) {
+    sem_post( &wp->free_ );
+  }
+  for( worker *wp: wvec_ ) {
+    wp->thrd_.join();
+    sem_destroy( &wp->free_ );
+    sem_destroy( &wp->done_ );
+    ZSTD_freeDCtx( (ZSTD_DCtx*)wp->cxt_ );
+    delete wp;
+  }
+  wvec_.clear();
+  curr_ = nullptr;
+  is_pool_ = false;
+}
+
+void replay::run( unsigned idx )
+{
+  worker *wp = wvec_[idx];
+  const char *buf = mmap_.data();
+  for( uint64_t seq = idx; seq < bsch_.size(); seq += nthr_ ) {
+    sem_wait( &wp->free_ );
+    if ( !is_run_ ) {
+      break;
+    }
+    job& jb = wp->jobs_[( seq / nthr_ ) % max_ahead];
+    capture::blk_hdr bhdr;
+    uint64_t off = bofs_[bsch_[seq]];
+    __builtin_memcpy( &bhdr, &buf[off], sizeof( bhdr ) );
+    jb.is_ok_ = off + sizeof( bhdr ) + bhdr.zlen_ <= mmap_.size();
+    jb.buf_.resize( jb.is_ok_ ? bhdr.len_ : 0UL );
+    if ( jb.is_ok_ && bhdr.zlen_ ) {
+      size_t len = ZSTD_decompressDCtx( (ZSTD_DCtx*)wp->cxt_,
+          jb.buf_.data(), jb.buf_.size(),
+          &buf[off + sizeof( bhdr )], bhdr.zlen_ );
+      jb.is_ok_ = !ZSTD_isError( len ) && len == jb.buf_.size();
+    }
+    sem_post( &wp->done_ );
+  }
+}
+
+bool replay::read_pool()
+{
+  // hand the previous block back to its worker
+  if ( !is_pool_ ) {
+    start_pool();
+  }
+  if ( curr_ ) {
+    sem_post( &wvec_[( seq_ - 1 ) % nthr_]->free_ );
+    curr_ = nullptr;
+  }
+  if ( seq_ == bsch_.size() ) {
+    return false;
+  }
+  worker *wp = wvec_[seq_ % nthr_];
+  sem_wait( &wp->done_ );
+  curr_ = &wp->jobs_[( seq_ / nthr_ ) % max_ahead];
+  ++seq_;
+  if ( !curr_->is_ok_ ) {
+    return set_err_msg( "corrupt capture file=" + file_ );
+  }
+  bptr_ = curr_->buf_.data();
+  blen_ = curr_->buf_.size();
+  bpos_ = cleft_ = 0UL;
+  is_delta_ = false;
+  dmap_.clear();
+  dvec_.clear();
+  return true;
+}
+
+int replay::get_delta()
+{
+  // keep the latest full record of every account and apply delta
+  // records to it. returns 0 to skip the record or -1 on error
+  static const size_t hdr_sz = sizeof( int64_t ) + sizeof( pc_pub_key_t );
+  capture::cap_delta dhdr;
+  __builtin_memcpy( &dhdr, &up_->acc_, sizeof( dhdr ) );
+  bool is_delta = dhdr.hdr_.magic_ == capture::delta_magic;
+  if ( is_delta && dhdr.len_ == 0 ) {
+    is_delta_ = true;
+    return 0;
+  }
+  const pub_key& key = *(const pub_key*)&up_->key_;
+  acc_map_t::iter_t it = dmap_.find( key );
+  if ( !is_delta ) {
+    if ( !it ) {
+      it = dmap_.add( key );
+      dmap_.ref( it ) = static_cast< uint32_t >( dvec_.size() );
+      dvec_.resize( dvec_.size() + 1 );
+    }
+    word_vec_t& rec = dvec_[dmap_.obj( it )];
+    size_t len = hdr_sz + up_->acc_.size_;
+    rec.assign( ( len + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ), 0UL );
+    __builtin_memcpy( rec.data(), up_, len );
+    return 1;
+  }
+  if ( !it ) {
+    set_err_msg( "capture delta without account file=" + file_ );
+    return -1;
+  }
+  word_vec_t& rec = dvec_[dmap_.obj( it )];
+  char *tgt = (char*)rec.data();
+  size_t len = hdr_sz + dhdr.len_;
+  if ( rec.size() * sizeof( uint64_t ) < len ) {
+    set_err_msg( "corrupt capture file=" + file_ );
+    return -1;
+  }
+  __builtin_memcpy( tgt, up_, sizeof( int64_t ) );
+  tgt += hdr_sz;
+  const char *src = (const char*)&up_->acc_ + sizeof( dhdr );
+  const char *end = (const char*)&up_->acc_ + dhdr.hdr_.size_;
+  for( uint32_t i = 0; i != dhdr.num_; ++i ) {
+    capture::cap_run run;
+    if ( end - src < (ssize_t)sizeof( run ) ) {
+      break;
+    }
+    __builtin_memcpy( &run, src, sizeof( run ) );
+    src += sizeof( run );
+    size_t off = run.off_ * sizeof( uint64_t );
+    size_t num = run.num_ * sizeof( uint64_t );
+    if ( (size_t)( end - src ) < num ||
+         off + num > rec.size() * sizeof( uint64_t ) - hdr_sz ) {
+      set_err_msg( "corrupt capture file=" + file_ );
+      return -1;
+    }
+    __builtin_memcpy( &tgt[off], src, num );
+    src += num;
+  }
+  up_ = (hdr*)rec.data();
+  return 1;
+}
+
+bool replay::get_next_gz()
 {
   for(;;) {
     size_t left = len_ - pos_;
@@ -74,7 +627,9 @@ bool replay::get_next()
       }
       pos_ = 0;
       len_ = left;
-      int numread = ::gzread( zfd_, &buf_[len_], buf_sz - len_ );
+      ssize_t numread = is_strm_ ?
+        read_stream( &buf_[len_], buf_sz - len_ ) :
+        ::gzread( zfd_, &buf_[len_], buf_sz - len_ );
       if ( numread > 0 ) {
         len_ += static_cast< size_t >( numread );
       } else {
@@ -83,3 +638,69 @@ bool replay::get_next()
     }
   }
 }
+
+ssize_t replay::read_stream( char *buf, size_t len )
+{
+  ZSTD_DCtx *cxt = (ZSTD_DCtx*)cxt_;
+  ZSTD_outBuffer out = { buf, len, 0 };
+  while( out.pos == 0 ) {
+    if ( rpos_ == rlen_ ) {
+      ssize_t numread = ::read( fd_, rbuf_, buf_sz );
+      if ( numread <= 0 ) {
+        return 0;
+      }
+      rpos_ = 0;
+      rlen_ = static_cast< size_t >( numread );
+    }
+    ZSTD_inBuffer in = { rbuf_, rlen_, rpos_ };
+    size_t rc = ZSTD_decompressStream( cxt, &out, &in );
+    rpos_ = in.pos;
+    if ( ZSTD_isError( rc ) ) {
+      set_err_msg( "corrupt capture file=" + file_ );
+      return -1;
+    }
+  }
+  return static_cast< ssize_t >( out.pos );
+}
+
+bool replay::get_next_zstd()
+{
+  for(;;) {
+    size_t left = rlen_ - rpos_;
+    uint32_t flen = 0;
+    if ( left >= sizeof( flen ) ) {
+      __builtin_memcpy( &flen, &rbuf_[rpos_], sizeof( flen ) );
+    }
+    if ( left >= sizeof( flen ) && left - sizeof( flen ) >= flen ) {
+      const char *frame = &rbuf_[rpos_ + sizeof( flen )];
+      rpos_ += sizeof( flen ) + flen;
+      ZSTD_DCtx *cxt = (ZSTD_DCtx*)cxt_;
+      uint32_t id = ZSTD_getDictID_fromFrame( frame, flen );
+      const ZSTD_DDict *ddict = (const ZSTD_DDict*)(
+          dict_ ? dict_->get_ddict( id ) : nullptr );
+      if ( id && !ddict ) {
+        return set_err_msg(
+            "missing capture dictionary id=" + std::to_string( id ) );
+      }
+      size_t len = ddict ?
+        ZSTD_decompress_usingDDict( cxt, buf_, buf_sz, frame, flen, ddict ) :
+        ZSTD_decompressDCtx( cxt, buf_, buf_sz, frame, flen );
+      if ( ZSTD_isError( len ) || len < sizeof( hdr ) ) {
+        return set_err_msg( "corrupt capture file=" + file_ );
+      }
+      up_ = (hdr*)buf_;
+      return true;
+    }
+    if ( rpos_ ) {
+      __builtin_memmove( &rbuf_[0], &rbuf_[rpos_], left );
+    }
+    rpos_ = 0;
+    rlen_ = left;
+    ssize_t numread = ::read( fd_, &rbuf_[rlen_], buf_sz - rlen_ );
+    if ( numread > 0 ) {
+      rlen_ += static_cast< size_t >( numread );
+    } else {
+      return false;
+    }
+  }
+}
@@ -1,14 +1,25 @@
 #pragma once
 
 #include <pc/mem_map.hpp>
+#include <pc/capture.hpp>
 #include <pc/error.hpp>
+#include <pc/hash_map.hpp>
+#include <pc/key_pair.hpp>
+#include <pc/zstd_dict.hpp>
 #include <oracle/oracle.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <semaphore.h>
 #include <zlib.h>
 
 namespace pc
 {
 
-  // replay pyth aggregate prices from capture file
+  // replay pyth aggregate prices from capture file. the format is
+  // detected from the file content: gzip, zstd stream or zstd frames
+  // compressed by capture using dictionaries or indexed blocks (.pcb).
+  // delta records are returned as the full accounts they encode
   class replay : public error
   {
   public:
@@ -20,6 +31,15 @@ namespace pc
     void set_file( const std::string& cap_file );
     std::string get_file() const;
 
+    // zstd dictionaries used by .zst capture file
+    void set_zstd_dict( const zstd_dict * );
+    const zstd_dict *get_zstd_dict() const;
+
+    // memory-map block captures and decompress blocks on this many
+    // threads ahead of get_next (default 0 - read on the calling thread)
+    void set_threads( unsigned );
+    unsigned get_threads() const;
+
     // (re) initialize
     bool init();
 
@@ -32,11 +52,47 @@ namespace pc
     // on-chain account capture
     pc_acc_t *get_update() const;
 
-    // get next price capture
+    // slot of price capture in block captures (0 otherwise)
+    uint64_t get_slot() const;
+
+    // get next price capture. captures of block files read on threads
+    // point into the decompressed block and remain valid until the next
+    // call
     bool get_next();
 
+    // continue from the first capture at or after time or slot. requires
+    // the index of a block capture
+    bool seek_time( int64_t ts );
+    bool seek_slot( uint64_t slot );
+
+    // only return captures of account (null for all) and restart from
+    // the first capture. block captures with an index only read the
+    // blocks containing the account
+    void set_account( const pc_pub_key_t * );
+
+  private:
+
+    bool get_next_gz();
+    bool get_next_blk();
+    bool init_blk();
+    bool read_blk();
+    void seek_blk( uint32_t );
+    bool map_blk();
+    bool read_pool();
+    void start_pool();
+    void stop_pool();
+
+  public:
+    void run( unsigned );
+
   private:
 
+    // blocks decompressed ahead per thread
+    static const unsigned max_ahead = 4;
+    bool get_next_zstd();
+    ssize_t read_stream( char *, size_t );
+    int  get_delta();
+
     struct hdr
     {
       int64_t      ts_;
@@ -44,11 +100,91 @@ namespace pc
       pc_acc_t     acc_;
     };
 
+    struct trait_account {
+      typedef uint32_t        idx_t;
+      typedef pub_key         key_t;
+      typedef const pub_key&  keyref_t;
+      typedef uint32_t        val_t;
+      struct hash_t {
+        idx_t operator() ( keyref_t a ) {
+          uint64_t *i = (uint64_t*)a.data();
+          return *i;
+        }
+      };
+    };
+
+    typedef open_hash_map<trait_account> acc_map_t;
+    typedef std::vector<uint64_t>        word_vec_t;
+    typedef std::vector<word_vec_t>      rec_vec_t;
+    typedef std::vector<capture::blk_idx> blk_vec_t;
+    typedef std::vector<capture::blk_acc> blk_acc_t;
+    typedef std::vector<uint32_t>        blk_list_t;
+
+    struct job
+    {
+      std::vector<char> buf_;
+      bool              is_ok_;
+    };
+
+    struct worker
+    {
+      job              jobs_[max_ahead];
+      sem_t            free_; // jobs free to decompress into
+      sem_t            done_; // jobs decompressed
+      void            *cxt_;
+      std::thread      thrd_;
+    };
+
+    typedef std::vector<worker*>  worker_vec_t;
+    typedef std::vector<uint64_t> off_vec_t;
+    typedef std::atomic<bool>     atomic_t;
+
     hdr        *up_;
     char       *buf_;
     size_t      pos_;
     size_t      len_;
     gzFile      zfd_;
+    int         fd_;     // .zst capture file
+    bool        is_strm_;// zstd stream rather than frames
+    bool        is_delta_;// capture has delta records
+    acc_map_t   dmap_;   // latest full record index by account
+    rec_vec_t   dvec_;
+    char       *rbuf_;   // compressed read buffer
+    size_t      rpos_;
+    size_t      rlen_;
+    const zstd_dict *dict_;
+    void       *cxt_;
+    bool        is_blk_; // block capture
+    bool        has_idx_;// block capture with index
+    uint64_t    slot_;   // slot of current chunk
+    uint64_t    boff_;   // file offset of next block without index
+    uint64_t    bend_;   // file offset of end of blocks
+    uint32_t    bnxt_;   // next block or position in account blocks
+    size_t      bpos_;   // position in block
+    size_t      cleft_;  // bytes left in chunk
+    const char *bptr_;   // current block
+    size_t      blen_;
+    std::vector<char> blk_;
+    std::vector<char> zblk_;
+    blk_vec_t   bidx_;   // block index
+    blk_acc_t   bacc_;   // account blocks
+    blk_list_t  blst_;
+    acc_map_t   amap_;   // bacc_ index by account
+    bool        has_acc_;// account filter
+    pub_key     fkey_;
+    uint32_t    fpos_;   // account blocks in blst_
+    uint32_t    fnum_;
+    int64_t     min_ts_;
+    uint64_t    min_slot_;
+    unsigned    nthr_;
+    mem_map     mmap_;
+    off_vec_t   bofs_;   // file offset of every block
+    blk_list_t  bsch_;   // blocks read by the pool in order
+    uint64_t    seq_;    // next position in bsch_
+    job        *curr_;   // job holding current block
+    bool        is_pool_;
+    atomic_t    is_run_;
+    worker_vec_t wvec_;
     std::string file_;
   };
 
@@ -67,4 +203,9 @@ namespace pc
     return &up_->acc_;
   }
 
+  inline uint64_t replay::get_slot() const
+  {
+    return slot_;
+  }
+
 }
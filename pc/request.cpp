@@ -1,4 +1,5 @@
 #include "request.hpp"
+#include "aggregate.hpp"
 #include "manager.hpp"
 #include "log.hpp"
 
@@ -61,6 +62,43 @@ bool request_sub_set::del( uint64_t sidx )
   return true;
 }
 
+bool request_sub_set::add( request *rptr, uint64_t sidx )
+{
+  // ids skipped over are free for later subscriptions
+  if ( sidx >= svec_.size() ) {
+    for( uint64_t i = svec_.size(); i != sidx; ++i ) {
+      rvec_.push_back( i );
+    }
+    svec_.resize( sidx + 1, nullptr );
+    sidx_ = svec_.size();
+  } else if ( svec_[sidx] ) {
+    return false;
+  } else {
+    rvec_.erase( std::remove( rvec_.begin(), rvec_.end(), sidx ),
+                 rvec_.end() );
+  }
+  request_node *sptr = new request_node(sptr_,rptr,sidx);
+  rptr->add_sub( sptr );
+  svec_[sidx] = sptr;
+  return true;
+}
+
+uint64_t request_sub_set::get_end() const
+{
+  return svec_.size();
+}
+
+request *request_sub_set::get( uint64_t sidx ) const
+{
+  request_node *sptr = sidx < svec_.size() ? svec_[sidx] : nullptr;
+  return sptr ? sptr->req_ : nullptr;
+}
+
+size_t request_sub_set::size() const
+{
+  return svec_.size() - rvec_.size();
+}
+
 void request_sub_set::teardown()
 {
   for( request_node *sptr: svec_ ) {
@@ -124,6 +162,11 @@ void request::del_sub( request_node *sptr )
   slist_.del( sptr );
 }
 
+bool request::get_has_sub() const
+{
+  return !slist_.empty();
+}
+
 request::prev_next_t *request::get_request()
 {
   return nd_;
@@ -197,6 +240,7 @@ void get_mapping::submit()
   areq_->set_sub( this );
   // get account data
   get_rpc_client()->send( areq_ );
+  get_manager()->init_from_snapshot( this, mkey_ );
 }
 
 void get_mapping::on_response( rpc::get_account_info *res )
@@ -267,8 +311,7 @@ product::product( const pub_key& acc )
 : acc_( acc ),
   st_( e_subscribe )
 {
-  areq_->set_account( &acc_ );
-  areq_->set_sub( this );
+  acc_.enc_base58( atxt_ );
 }
 
 product::~product()
@@ -289,25 +332,24 @@ const pub_key *product::get_account() const
   return &acc_;
 }
 
+str product::get_account_text() const
+{
+  return atxt_;
+}
+
 str product::get_symbol()
 {
-  str sym;
-  get_attr( attr_id( "symbol" ), sym);
-  return sym;
+  return sym_;
 }
 
 str product::get_base_asset()
 {
-  str base;
-  get_attr( attr_id( "base" ), base);
-  return base;
+  return base_;
 }
 
 str product::get_quote_currency()
 {
-  str quote;
-  get_attr( attr_id( "quote_currency" ), quote);
-  return quote;
+  return quote_;
 }
 
 void product::reset()
@@ -320,20 +362,15 @@ void product::reset()
 void product::add_price( price *px )
 {
   pvec_.push_back( px );
+  jlist_.clear();
 }
 
 void product::submit()
 {
-  rpc_client  *cptr = get_rpc_client();
-  areq_->set_commitment( get_manager()->get_commitment() );
+  // account data arrives with the next batch of accounts requested
   st_ = e_subscribe;
-  cptr->send( areq_ );
-}
-
-void product::on_response( rpc::get_account_info *res )
-{
-  set_is_recv( true );
-  update( res );
+  get_manager()->fetch_account( acc_ );
+  get_manager()->init_from_snapshot( this, acc_ );
 }
 
 void product::on_response( rpc::account_update *res )
@@ -369,6 +406,15 @@ void product::update( T *res )
     return;
   }
 
+  // attributes or price chain may have changed. interned values stay
+  // valid across updates
+  jref_.clear();
+  jlist_.clear();
+  sym_ = base_ = quote_ = str();
+  get_attr( attr_id( "symbol" ), sym_ );
+  get_attr( attr_id( "base" ), base_ );
+  get_attr( attr_id( "quote_currency" ), quote_ );
+
   // subscribe to firstprice account in chain
   if ( !pc_pub_key_is_zero( &prod->px_acc_ ) ) {
     cptr->add_price( *(pub_key*)&prod->px_acc_, this );
@@ -430,10 +476,7 @@ price *product::get_price( price_type pt ) const
 void product::dump_json( json_wtr& wtr ) const
 {
   // assumes the json_wtr has already started an object structure
-  wtr.add_key( "account", *get_account() );
-  wtr.add_key( "attr_dict", json_wtr::e_obj );
-  write_json( wtr );
-  wtr.pop();
+  wtr.add_verbatim( get_ref_json() );
   wtr.add_key( "price_accounts", json_wtr::e_arr );
   for( unsigned i=0; i != get_num_price(); ++i ) {
     wtr.add_val( json_wtr::e_obj );
@@ -444,36 +487,91 @@ void product::dump_json( json_wtr& wtr ) const
   wtr.pop();
 }
 
+str product::get_ref_json() const
+{
+  if ( jref_.empty() ) {
+    json_wtr wtr;
+    wtr.add_key( "account", get_account_text() );
+    wtr.add_key( "attr_dict", json_wtr::e_obj );
+    write_json( wtr );
+    wtr.pop();
+    wtr.copy_to( jref_ );
+  }
+  return str( jref_ );
+}
+
+str product::get_list_json() const
+{
+  // the exponent and type belong to the price accounts and so may
+  // change without a product update
+  bool is_ok = !jlist_.empty() && jsig_.size() == 2 * pvec_.size();
+  for( unsigned i=0; is_ok && i != pvec_.size(); ++i ) {
+    is_ok = jsig_[2*i] == pvec_[i]->get_price_exponent() &&
+            jsig_[2*i+1] == (int64_t)pvec_[i]->get_price_type();
+  }
+  if ( PC_LIKELY( is_ok ) ) {
+    return str( jlist_ );
+  }
+  json_wtr wtr;
+  wtr.add_val( json_wtr::e_obj );
+  wtr.add_verbatim( get_ref_json() );
+  wtr.add_key( "price", json_wtr::e_arr );
+  jsig_.clear();
+  for( price *px: pvec_ ) {
+    int64_t expo = px->get_price_exponent();
+    price_type ptype = px->get_price_type();
+    wtr.add_val( json_wtr::e_obj );
+    wtr.add_key( "account", px->get_account_text() );
+    wtr.add_key( "price_exponent", expo );
+    wtr.add_key( "price_type", price_type_to_str( ptype) );
+    wtr.pop();
+    jsig_.push_back( expo );
+    jsig_.push_back( (int64_t)ptype );
+  }
+  wtr.pop();
+  wtr.pop();
+  jlist_.clear();
+  wtr.copy_to( jlist_ );
+  return str( jlist_ );
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // price
 
-price::price( const pub_key& acc, product *prod )
+price::price( const pub_key& acc, product *prod, price_arena *arena )
 : init_( false ),
   isched_( false ),
   st_( e_subscribe ),
   pub_idx_( (unsigned)-1 ),
+  pnum_( (unsigned)-1 ),
+  plast_( 0UL ),
+  ppub_( nullptr ),
   apub_( acc ),
   lamports_( 0UL ),
   pub_slot_( 0UL ),
+  useq_( 0UL ),
   prod_( prod ),
   sched_( this ),
   pinit_( this ),
-  pptr_(nullptr),
-  last_attempted_update_slot_( 0UL )
+  ppred_( this ),
+  arena_( arena ),
+  aidx_( arena->add() ),
+  pptr_( arena->get_account( aidx_ ) ),
+  tbeg_( 0UL ),
+  tend_( 0UL ),
+  tnum_( 0U ),
+  last_attempted_update_slot_( 0UL ),
+  trc_( 0UL ),
+  lslot_( 0UL ),
+  is_dirty_( false )
 {
-  areq_->set_account( &apub_ );
   preq_->set_account( &apub_ );
-  areq_->set_sub( this );
   preq_->set_sub( this );
-  size_t tlen = ZSTD_compressBound( ZSTD_UPPER_BOUND );
-  pptr_ = (pc_price_t*)new char[tlen];
-  __builtin_memset( pptr_, 0, tlen );
+  apub_.enc_base58( atxt_ );
 }
 
 price::~price()
 {
-  delete [] (char*)pptr_;
-  pptr_ = nullptr;
 }
 
 bool price::init_publish()
@@ -481,14 +579,14 @@ bool price::init_publish()
   manager *cptr = get_manager();
   key_pair *pkey = cptr->get_publish_key_pair();
   if ( !pkey ) {
-    on_error_sub( "missing or invalid publish key [" +
-        cptr->get_publish_key_pair_file() + "]", this );
+    on_error( "missing or invalid publish key [" +
+        cptr->get_publish_key_pair_file() + "]" );
     return false;
   }
   pub_key *gpub = cptr->get_program_pub_key();
   if ( !gpub ) {
-    on_error_sub( "missing or invalid program public key [" +
-        cptr->get_program_pub_key_file() + "]", this );
+    on_error( "missing or invalid program public key [" +
+        cptr->get_program_pub_key_file() + "]" );
     return false;
   }
   preq_->set_publish( pkey );
@@ -533,6 +631,11 @@ const pub_key *price::get_account() const
   return &apub_;
 }
 
+str price::get_account_text() const
+{
+  return atxt_;
+}
+
 uint32_t price::get_version() const
 {
   return pptr_->ver_;
@@ -564,11 +667,28 @@ uint64_t price::get_last_attempted_update_slot() const
   return last_attempted_update_slot_;
 }
 
+uint64_t price::get_landed_slot() const
+{
+  // components of aggregate-only updates are stale so landing is then
+  // only known by signature
+  return std::max( lslot_, get_land_pub_slot() );
+}
+
 void price::set_last_attempted_update_slot( uint64_t slot )
 {
   last_attempted_update_slot_ = slot;
 }
 
+bool price::get_is_dirty() const
+{
+  return is_dirty_;
+}
+
+void price::set_is_dirty( bool is_dirty )
+{
+  is_dirty_ = is_dirty;
+}
+
 uint64_t price::get_prev_slot() const
 {
   return pptr_->prev_slot_;
@@ -624,6 +744,21 @@ uint64_t price::get_pub_slot() const
   return pptr_->agg_.pub_slot_;
 }
 
+uint64_t price::get_update_seq() const
+{
+  return useq_;
+}
+
+price_view price::get_view()
+{
+  price_view vw;
+  vw.ver_ = price_view::version;
+  vw.seq_ = useq_;
+  vw.px_  = this;
+  vw.acc_ = pptr_;
+  return vw;
+}
+
 bool price::get_is_ready_publish() const
 {
   if ( st_ != e_publish )
@@ -660,6 +795,16 @@ bool price::has_publisher( const pub_key& key )
   return false;
 }
 
+price_arena *price::get_arena() const
+{
+  return arena_;
+}
+
+unsigned price::get_arena_index() const
+{
+  return aidx_;
+}
+
 price_sched *price::get_sched()
 {
   if ( !isched_ ) {
@@ -694,6 +839,12 @@ bool price::update(
   }
   preq_->set_price( price, conf, st, is_agg );
   manager *mgr = get_manager();
+  upd_trace *trc = mgr->get_trace();
+  if ( PC_UNLIKELY( trc != nullptr ) && !trc->get_is_live( trc_ ) ) {
+    const int64_t ts = get_now();
+    trc_ = trc->add_recv( get_symbol(), ts, ts );
+    trc->add_send( trc_, ts );
+  }
   const uint64_t slot = mgr->get_slot();
   preq_->set_slot( slot );
   preq_->set_block_hash( mgr->get_recent_block_hash() );
@@ -701,47 +852,68 @@ bool price::update(
     mgr->submit( preq_ );
   else {
     get_rpc_client()->send( preq_ );
-    tvec_.emplace_back( std::string( 100, '\0' ), preq_->get_sent_time() );
-    preq_->get_signature()->enc_base58( tvec_.back().first );
+    add_txid( *preq_->get_signature(), preq_->get_sent_time() );
     PC_LOG_DBG( "sent price update transaction" )
       .add( "secondary", mgr->get_is_secondary() )
       .add( "price_account", *get_account() )
       .add( "product_account", *prod_->get_account() )
       .add( "symbol", get_symbol() )
       .add( "price_type", price_type_to_str( get_price_type() ) )
-      .add( "sig", tvec_.back().first )
+      .add( "sig", *preq_->get_signature() )
       .add( "pub_slot", slot )
       .end();
-    if ( PC_UNLIKELY( tvec_.size() >= 100 ) ) {
-      PC_LOG_WRN( "too many unacked price update transactions" )
-        .add( "secondary", mgr->get_is_secondary() )
-        .add( "price_account", *get_account() )
-        .add( "product_account", *prod_->get_account() )
-        .add( "symbol", get_symbol() )
-        .add( "price_type", price_type_to_str( get_price_type() ) )
-        .add( "num_txid", tvec_.size() )
-        .end();
-      tvec_.erase( tvec_.begin(), tvec_.begin() + 50 );
-    }
   }
+  const int64_t ts = get_now();
+  add_pub_sent( ts, slot );
+  if ( PC_UNLIKELY( trc != nullptr ) ) {
+    trc->add_sent( trc_, mgr->get_do_tx() ? nullptr : preq_->get_signature(),
+                   slot, ts );
+  }
+  land_track *ltrk = mgr->get_land_tracker();
+  if ( ltrk ) {
+    ltrk->add_sent( *preq_->get_signature(), this, slot );
+  }
+  mgr->add_tx_sent( 1 );
   inc_sent();
+  if ( mgr->get_do_predict() ) {
+    predict();
+  }
   return true;
 }
 
 void price::update_no_send(
   const int64_t price, const uint64_t conf
-  , const symbol_status st, const bool is_agg
+  , const symbol_status st, const bool is_agg, const int64_t rts
 )
 {
-  preq_->set_slot( get_manager()->get_slot() );
+  manager *mgr = get_manager();
+  preq_->set_slot( mgr->get_slot() );
   preq_->set_price( price, conf, st, is_agg );
+  const int64_t ts = get_now();
+  add_pub_recv( ts );
+  upd_trace *trc = mgr->get_trace();
+  if ( PC_UNLIKELY( trc != nullptr ) && !trc->get_is_live( trc_ ) ) {
+    trc_ = trc->add_recv( get_symbol(), rts, ts );
+  }
+  if ( mgr->get_do_predict() ) {
+    predict();
+  }
 }
 
-bool price::send( price *prices[], const unsigned n )
+bool price::send( price *prices[], const unsigned n, unsigned max_num )
 {
-  static std::vector< rpc::upd_price * > upds_;
+  static thread_local std::vector< rpc::upd_price * > upds_;
+  static thread_local std::vector< price * > sent_;
+  static thread_local log_limit init_lim(
+      "failed to initialize publisher", PC_LOG_ERR_LVL );
+  static thread_local log_limit perm_lim(
+      "missing publish permission", PC_LOG_ERR_LVL );
+  static thread_local log_limit ready_lim(
+      "not ready to publish - check rpc / pyth_tx connection",
+      PC_LOG_ERR_LVL );
 
   upds_.clear();
+  sent_.clear();
 
   manager *mgr1 = nullptr;
 
@@ -751,7 +923,7 @@ bool price::send( price *prices[], const unsigned n )
     manager *const mgr = p->get_manager();
     p->set_last_attempted_update_slot( mgr->get_slot() );
     if ( PC_UNLIKELY( ! p->init_ && ! p->init_publish() ) ) {
-      PC_LOG_ERR( "failed to initialize publisher" )
+      PC_LOG_LIM( init_lim, (uint64_t)p )
         .add( "secondary", mgr->get_is_secondary() )
         .add( "price_account", *p->get_account() )
         .add( "product_account", *p->prod_->get_account() )
@@ -760,7 +932,7 @@ bool price::send( price *prices[], const unsigned n )
       continue;
     }
     if ( PC_UNLIKELY( ! p->has_publisher() ) ) {
-      PC_LOG_ERR( "missing publish permission" )
+      PC_LOG_LIM( perm_lim, (uint64_t)p )
         .add( "secondary", mgr->get_is_secondary() )
         .add( "price_account", *p->get_account() )
         .add( "product_account", *p->prod_->get_account() )
@@ -769,7 +941,7 @@ bool price::send( price *prices[], const unsigned n )
       continue;
     }
     if ( PC_UNLIKELY( ! p->get_is_ready_publish() ) ) {
-      PC_LOG_ERR( "not ready to publish - check rpc / pyth_tx connection" )
+      PC_LOG_LIM( ready_lim, (uint64_t)p )
         .add( "secondary", mgr->get_is_secondary() )
         .add( "price_account", *p->get_account() )
         .add( "product_account", *p->prod_->get_account() )
@@ -790,19 +962,38 @@ bool price::send( price *prices[], const unsigned n )
         .add( "price_type", price_type_to_str( p->get_price_type() ) ).end();
       continue;
     }
+    if ( PC_UNLIKELY( p->trc_ != 0UL ) ) {
+      mgr->get_trace()->add_send( p->trc_, get_now() );
+    }
     p->preq_->set_block_hash( mgr->get_recent_block_hash() );
     upds_.emplace_back( p->preq_ );
+    sent_.emplace_back( p );
 
     // If the batch is full, or we have reached the end, send the upd_price requests in upds_.
     // These correspond to the valid prices[j..i], inclusive.
     if (
-      upds_.size() >= mgr->get_max_batch_size()
+      upds_.size() >= ( max_num ? max_num : mgr->get_max_batch_size() )
       || ( upds_.size() && ( i + 1 ) == n )
     ) {
+      // transaction signature of the batch if signed here
+      const signature *bsig = nullptr;
       if ( mgr->get_do_tx() ) {
-        net_wtr msg;
-        if ( rpc::upd_price::build( msg, &upds_[ 0 ], upds_.size(), mgr->get_requested_upd_price_cu_units(), mgr->get_requested_upd_price_cu_units() ) ) {
-          mgr->submit( msg );
+        bool is_ok;
+        tx_pool *pool = mgr->get_tx_pool();
+        if ( pool ) {
+          // built here and signed on a worker thread
+          is_ok = pool->submit( &upds_[ 0 ], upds_.size(), mgr->get_requested_upd_price_cu_units(), mgr->get_requested_upd_price_cu_price() );
+        }
+        else {
+          net_wtr msg;
+          is_ok = rpc::upd_price::build( msg, &upds_[ 0 ], upds_.size(), mgr->get_requested_upd_price_cu_units(), mgr->get_requested_upd_price_cu_price() );
+          if ( is_ok ) {
+            mgr->submit( msg );
+            bsig = upds_[ 0 ]->get_signature();
+          }
+        }
+        if ( is_ok ) {
+          mgr->add_tx_sent( upds_.size() );
         }
         else {
           PC_LOG_ERR( "failed to build msg" )
@@ -815,10 +1006,9 @@ bool price::send( price *prices[], const unsigned n )
       }
       else {
         p->get_rpc_client()->send( &upds_[ 0 ], upds_.size(), mgr->get_requested_upd_price_cu_units(), mgr->get_requested_upd_price_cu_price() );
-        p->tvec_.emplace_back(
-          std::string( 100, '\0' ), p->preq_->get_sent_time()
-        );
-        p->preq_->get_signature()->enc_base58( p->tvec_.back().first );
+        mgr->add_tx_sent( upds_.size() );
+        bsig = upds_[ 0 ]->get_signature();
+        p->add_txid( *bsig, p->preq_->get_sent_time() );
         for ( unsigned k = j; k <= i; ++k ) {
           price *const p1 = prices[ k ];
           PC_LOG_DBG( "sent price update" )
@@ -827,20 +1017,9 @@ bool price::send( price *prices[], const unsigned n )
             .add( "product_account", *p1->prod_->get_account() )
             .add( "symbol", p1->get_symbol() )
             .add( "price_type", price_type_to_str( p1->get_price_type() ) )
-            .add( "sig", p->tvec_.back().first )
+            .add( "sig", *bsig )
             .add( "pub_slot", p->preq_->get_slot() )
             .end();
-          if ( PC_UNLIKELY( p1->tvec_.size() >= 100 ) ) {
-            PC_LOG_WRN( "too many unacked price update transactions" )
-              .add( "secondary", mgr->get_is_secondary() )
-              .add( "price_account", *p1->get_account() )
-              .add( "product_account", *p1->prod_->get_account() )
-              .add( "symbol", p1->get_symbol() )
-              .add( "price_type", price_type_to_str( p1->get_price_type() ) )
-              .add( "num_txid", p1->tvec_.size() )
-              .end();
-            p1->tvec_.erase( p1->tvec_.begin(), p1->tvec_.begin() + 50 );
-          }
         }
       }
 
@@ -848,9 +1027,25 @@ bool price::send( price *prices[], const unsigned n )
         price *const p1 = prices[ k ];
         p1->inc_sent();
       }
+      // updates of the batch share the transaction signature
+      const int64_t ts = get_now();
+      const signature *sig = mgr->get_do_tx() ? nullptr : bsig;
+      land_track *ltrk = bsig ? mgr->get_land_tracker() : nullptr;
+      for ( price *const p1 : sent_ ) {
+        p1->add_pub_sent( ts, p1->preq_->get_slot() );
+        if ( PC_UNLIKELY( p1->trc_ != 0UL ) ) {
+          mgr->get_trace()->add_sent(
+              p1->trc_, sig, p1->preq_->get_slot(), ts );
+        }
+        if ( ltrk ) {
+          ltrk->add_sent( *bsig, p1, p1->preq_->get_slot(),
+                          (unsigned)mgr->get_batch_strategy() );
+        }
+      }
 
       j = i + 1;
       upds_.clear();
+      sent_.clear();
     }
   }
 
@@ -861,44 +1056,82 @@ void price::submit()
 {
   if ( st_ == e_subscribe ) {
     // subscribe first
-    areq_->set_commitment( get_manager()->get_commitment() );
-    rpc_client  *cptr = get_rpc_client();
-    cptr->send( areq_ );
+    get_manager()->fetch_account( apub_ );
     st_ = e_sent_subscribe;
+    get_manager()->init_from_snapshot( this, apub_ );
   }
 }
 
 bool price::has_unacked_updates() const
 {
-  return ! tvec_.empty();
+  return tnum_ != 0;
+}
+
+void price::add_txid( const signature& sig, int64_t ts )
+{
+  if ( PC_UNLIKELY( tend_ - tbeg_ == max_txid ) ) {
+    PC_LOG_WRN( "too many unacked price update transactions" )
+      .add( "secondary", get_manager()->get_is_secondary() )
+      .add( "price_account", *get_account() )
+      .add( "product_account", *prod_->get_account() )
+      .add( "symbol", get_symbol() )
+      .add( "price_type", price_type_to_str( get_price_type() ) )
+      .add( "num_txid", tnum_ )
+      .end();
+    // drop oldest half
+    for( unsigned i = 0; i != max_txid/2; ++i, ++tbeg_ ) {
+      if ( tvec_[tbeg_%max_txid].ts_ ) {
+        --tnum_;
+      }
+    }
+  }
+  txid& t = tvec_[tend_++%max_txid];
+  t.sig_ = sig;
+  t.ts_  = ts;
+  ++tnum_;
 }
 
 void price::on_response( rpc::upd_price *res )
 {
-  std::string txid = res->get_ack_signature().as_string();
-  const auto it = std::find_if( tvec_.begin(), tvec_.end(),
-      [&] ( const std::pair<std::string,int64_t>& m ) { return m.first == txid; } );
-  if ( it == tvec_.end() )
+  // decode ack once and match raw signature bytes
+  str ack = res->get_ack_signature();
+  uint8_t sbuf[signature::len];
+  if ( 0 > dec_base58_64( (const uint8_t*)ack.str_, (int)ack.len_, sbuf ) ) {
     return;
-  const int64_t ack_dur = res->get_recv_time() - it->second;
-  tvec_.erase( it );
+  }
+  upd_trace *trc = get_manager()->get_trace();
+  if ( PC_UNLIKELY( trc != nullptr ) ) {
+    trc->add_ack( sbuf, res->get_recv_time() );
+  }
+  uint64_t i = tbeg_;
+  for( ; i != tend_; ++i ) {
+    const txid& t = tvec_[i%max_txid];
+    if ( t.ts_ && 0 == __builtin_memcmp( t.sig_.data(), sbuf, signature::len ) ) {
+      break;
+    }
+  }
+  if ( i == tend_ )
+    return;
+  txid& t = tvec_[i%max_txid];
+  const int64_t ack_dur = res->get_recv_time() - t.ts_;
+  add_pub_ack( ack_dur );
+  get_manager()->inc_tx_ack();
+  t.ts_ = 0;
+  --tnum_;
+  while( tbeg_ != tend_ && !tvec_[tbeg_%max_txid].ts_ ) {
+    ++tbeg_;
+  }
   PC_LOG_DBG( "received price update transaction ack" )
     .add( "secondary", get_manager()->get_is_secondary() )
     .add( "price_account", *get_account() )
     .add( "product_account", *prod_->get_account() )
     .add( "symbol", get_symbol() )
     .add( "price_type", price_type_to_str( get_price_type() ) )
-    .add( "sig", txid )
+    .add( "sig", ack )
     .add( "round_trip_time(ms)", 1e-6 * ack_dur )
     .end();
 }
 
-void price::on_response( rpc::get_account_info *res )
-{
-  set_is_recv( true );
-  update( res );
-}
-
 void price::on_response( rpc::account_update *res )
 {
   if ( get_is_recv() ) {
@@ -958,16 +1191,21 @@ void price::update( T *res )
 {
   // check for errors
   if ( res->get_is_err() ) {
-    on_error_sub( res->get_err_msg(), this );
+    on_error( res->get_err_msg() );
     st_ = e_error;
     return;
   }
 
-  // get account data
-  size_t tlen = ZSTD_compressBound( ZSTD_UPPER_BOUND );
-  res->get_data_val( pptr_, tlen );
-  if ( PC_UNLIKELY( pptr_->magic_ != PC_MAGIC ) ) {
-    on_error_sub( "bad price account header", this );
+  // get account data. capture and snapshot copy size_ bytes of the
+  // account so it may not claim more than the arena slot holds. updates
+  // sliced to the aggregate (see manager::set_do_agg_only) leave the
+  // components as of the last full fetch
+  size_t dlen = res->get_data_val( pptr_, price_arena::slot_len );
+  const bool has_comp = dlen > offsetof( pc_price_t, comp_ );
+  if ( PC_UNLIKELY( pptr_->magic_ != PC_MAGIC ||
+                    pptr_->num_ > PC_NUM_COMP ||
+                    pptr_->size_ > price_arena::slot_len ) ) {
+    on_error( "bad price account header" );
     st_ = e_error;
     return;
   }
@@ -988,6 +1226,18 @@ void price::update( T *res )
   lamports_ = res->get_lamports();
   manager *mgr = get_manager();
 
+  // copy account to local readers
+  mgr->write_feed( this );
+
+  // report the slot that our latest update landed in to the tx proxy
+  if ( pub_idx_ != (unsigned)-1 && has_comp ) {
+    uint64_t lslot = pptr_->comp_[pub_idx_].latest_.pub_slot_;
+    if ( lslot > lslot_ ) {
+      lslot_ = lslot;
+      mgr->add_landed( lslot, res->get_slot() );
+    }
+  }
+
   // update aggregate price and status if changed
   if ( pub_slot_ != pptr_->agg_.pub_slot_ || pub_slot_ == 0UL ) {
     // subscription service dropped an update
@@ -995,26 +1245,116 @@ void price::update( T *res )
       inc_sub_drop();
     }
     pub_slot_ = pptr_->agg_.pub_slot_;
+    arena_->update_agg( aidx_ );
 
     // capture aggregate price and components to disk
-    mgr->write( (pc_pub_key_t*)apub_.data(), (pc_acc_t*)pptr_ );
+    mgr->write( this, (pc_pub_key_t*)apub_.data(), (pc_acc_t*)pptr_ );
 
     // add slot/time latency statistics
-    if ( pub_idx_ != (unsigned)-1 ) {
+    if ( pub_idx_ != (unsigned)-1 && has_comp ) {
       uint64_t pub_slot = pptr_->comp_[pub_idx_].agg_.pub_slot_;
-      add_recv( mgr->get_slot(), pub_slot_, pub_slot );
+      const int64_t ts = get_now();
+      add_recv( mgr->get_slot(), pub_slot_, pub_slot, ts );
+      if ( PC_UNLIKELY( trc_ != 0UL ) ) {
+        upd_trace *trc = mgr->get_trace();
+        trc->add_agg( trc_, pub_slot, ts );
+        trc_ = trc->get_is_live( trc_ ) ? trc_ : 0UL;
+      }
     }
 
     // ping subscribers with new aggregate price
-    on_response_sub( this );
+    ++useq_;
+    notify_sub();
+    mgr->add_changed_price( this );
+  }
+
+  // predict the next aggregate from the new components
+  if ( mgr->get_do_predict() && has_comp ) {
+    predict();
+  }
+}
+
+void price::predict()
+{
+  if ( PC_UNLIKELY( pptr_->magic_ != PC_MAGIC ) ) {
+    return;
+  }
+
+  // aggregate a copy of the account with our component replaced by the
+  // update in flight if it has not landed yet
+  static thread_local pc_price_t px[1];
+  __builtin_memcpy( (void*)px, pptr_, sizeof( pc_price_t ) );
+  if ( pub_idx_ != (unsigned)-1 && !preq_->get_is_aggregate() ) {
+    pc_price_info_t& lt = px->comp_[pub_idx_].latest_;
+    uint64_t pslot = preq_->get_slot();
+    if ( pslot > lt.pub_slot_ ) {
+      lt.price_    = preq_->get_price();
+      lt.conf_     = preq_->get_conf();
+      lt.status_   = (uint32_t)preq_->get_symbol_status();
+      lt.pub_slot_ = pslot;
+    }
+  }
+
+  // the chain aggregates the components when the first update of a
+  // later slot lands
+  uint64_t slot = std::max( get_manager()->get_slot(), px->agg_.pub_slot_ );
+  aggregate_price( px, ++slot, 0L );
+  if ( ppred_.set( px, slot ) ) {
+    manager *mgr = get_manager();
+    if ( PC_UNLIKELY( mgr->get_is_shard() ) ) {
+      mgr->add_notify_predict( this );
+    } else {
+      notify_predict();
+    }
+  }
+}
+
+void price::notify_sub()
+{
+  manager *mgr = get_manager();
+  if ( PC_UNLIKELY( mgr->get_is_shard() ) ) {
+    mgr->add_notify( this );
+  } else {
+    notify();
   }
 }
 
+void price::on_error( const std::string& emsg )
+{
+  set_err_msg( emsg );
+  notify_sub();
+}
+
+void price::notify()
+{
+  on_response_sub( this );
+}
+
+void price::notify_predict()
+{
+  on_response_sub( &ppred_ );
+}
+
 void price::update_pub()
 {
+  // publishers are appended to and removed from the component list so
+  // the index is unchanged while the component count and the last
+  // component are. verifying this touches one or two cache lines
+  // instead of every component
+  pub_key *pkey = get_manager()->get_publish_pub_key();
+  uint32_t num = pptr_->num_;
+  uint64_t last = num ? pptr_->comp_[num-1].pub_.k8_[0] : 0UL;
+  if ( PC_LIKELY( num == pnum_ && last == plast_ && pkey == ppub_ &&
+       ( pub_idx_ == (unsigned)-1 || pc_pub_key_equal(
+         &pptr_->comp_[pub_idx_].pub_, (pc_pub_key_t*)pkey ) ) ) ) {
+    return;
+  }
+  pnum_  = num;
+  plast_ = last;
+  ppub_  = pkey;
+
   // update publishing index
   pub_idx_ = (unsigned)-1;
-  pub_key *pkey = get_manager()->get_publish_pub_key();
   if ( pkey ) {
     for( unsigned i=0; i != pptr_->num_; ++i ) {
       if ( pc_pub_key_equal( &pptr_->comp_[i].pub_, (pc_pub_key_t*)pkey ) ) {
@@ -1063,7 +1403,7 @@ symbol_status price::get_publisher_status( unsigned i ) const
 void price::dump_json( json_wtr& wtr ) const
 {
   // assumes the json_wtr has already started an object structure
-  wtr.add_key( "account", *get_account() );
+  wtr.add_key( "account", get_account_text() );
   wtr.add_key( "price_type", price_type_to_str( get_price_type() ));
   wtr.add_key( "price_exponent", get_price_exponent() );
   wtr.add_key( "status", symbol_status_to_str( get_status() ) );
@@ -1146,3 +1486,63 @@ price *price_init::get_price() const
 void price_init::submit()
 {
 }
+
+///////////////////////////////////////////////////////////////////////////
+// price_predict
+
+price_predict::price_predict( price *ptr )
+: ptr_( ptr ),
+  price_( 0L ),
+  conf_( 0UL ),
+  st_( symbol_status::e_unknown ),
+  num_qt_( 0U ),
+  pub_slot_( 0UL )
+{
+}
+
+price *price_predict::get_price() const
+{
+  return ptr_;
+}
+
+int64_t price_predict::get_price_value() const
+{
+  return price_;
+}
+
+uint64_t price_predict::get_conf() const
+{
+  return conf_;
+}
+
+symbol_status price_predict::get_status() const
+{
+  return st_;
+}
+
+uint32_t price_predict::get_num_qt() const
+{
+  return num_qt_;
+}
+
+uint64_t price_predict::get_pub_slot() const
+{
+  return pub_slot_;
+}
+
+bool price_predict::set( const pc_price_t *px, uint64_t pub_slot )
+{
+  symbol_status st = (symbol_status)px->agg_.status_;
+  bool is_chg = price_ != px->agg_.price_ || conf_ != px->agg_.conf_ ||
+                st_ != st || num_qt_ != px->num_qt_;
+  price_    = px->agg_.price_;
+  conf_     = px->agg_.conf_;
+  st_       = st;
+  num_qt_   = px->num_qt_;
+  pub_slot_ = pub_slot;
+  return is_chg;
+}
+
+void price_predict::submit()
+{
+}
@@ -4,6 +4,7 @@
 #include <pc/dbl_list.hpp>
 #include <pc/attr_id.hpp>
 #include <pc/pub_stats.hpp>
+#include <pc/price_arena.hpp>
 #include <oracle/oracle.h>
 
 namespace pc
@@ -47,6 +48,19 @@ namespace pc
     uint64_t add( request * );
     bool del( uint64_t );
     void teardown();
+
+    // add subscription under a given id, e.g. one restored from another
+    // process. false if the id is in use
+    bool add( request *, uint64_t sid );
+
+    // subscribed request by subscription id or null
+    request *get( uint64_t ) const;
+
+    // one past the largest subscription id (for iterating with get)
+    uint64_t get_end() const;
+
+    // number of subscriptions
+    size_t size() const;
   private:
     typedef std::vector<request_node*> sub_vec_t;
     typedef std::vector<uint64_t>      sub_idx_t;
@@ -82,8 +96,9 @@ namespace pc
     // response callbacks
     void add_sub( request_node * );
     void del_sub( request_node * );
+    bool get_has_sub() const;
 
-    // is status good to go
+    // is status good to go. rechecked only when the manager status changes
     virtual bool get_is_ready();
 
     // has request finished
@@ -147,15 +162,17 @@ namespace pc
 
   // product symbol and other reference-data attributes
   class product : public request,
-                  public attr_dict,
-                  public rpc_sub_i<rpc::get_account_info>
+                  public attr_dict
   {
   public:
     // product account number
     pub_key *get_account();
     const pub_key *get_account() const;
 
-    // symbol from attr_dict
+    // account number as base58 text (encoded once)
+    str get_account_text() const;
+
+    // symbol from attr_dict (looked up once per product update)
     str get_symbol();
     // Get the base currency (from attr_dict)
     str get_base_asset();
@@ -171,13 +188,18 @@ namespace pc
     // output full set of data to json writer
     void dump_json( json_wtr& wtr ) const;
 
+    // pre-rendered account and attr_dict key/value pairs and
+    // get_product_list entry. rendered again once the attributes or
+    // price accounts change
+    str get_ref_json() const;
+    str get_list_json() const;
+
   public:
 
     product( const pub_key& );
     virtual ~product();
     void reset();
     void submit() override;
-    void on_response( rpc::get_account_info * ) override;
     void on_response( rpc::account_update * ) override;
     bool get_is_done() const override;
     void add_price( price * );
@@ -188,10 +210,18 @@ namespace pc
 
     template<class T> void update( T *res );
 
+    typedef std::vector<int64_t> sig_vec_t;
+
     pub_key                acc_;
+    std::string            atxt_;
     prices_t               pvec_;
     state_t                st_;
-    rpc::get_account_info  areq_[1];
+    str                    sym_;    // interned symbol
+    str                    base_;   // interned base asset
+    str                    quote_;  // interned quote currency
+    mutable std::string    jref_;   // rendered reference data
+    mutable std::string    jlist_;  // rendered product list entry
+    mutable sig_vec_t      jsig_;   // price exponent, type of jlist_
   };
 
   // price submission schedule
@@ -230,15 +260,82 @@ namespace pc
     price *ptr_;
   };
 
+  // aggregate price the chain is predicted to publish next given the
+  // latest price account and our in-flight update (see
+  // manager::set_do_predict)
+  class price_predict : public request
+  {
+  public:
+    price_predict( price * );
+
+    // get associated symbol price
+    price *get_price() const;
+
+    // predicted aggregate
+    int64_t       get_price_value() const;
+    uint64_t      get_conf() const;
+    symbol_status get_status() const;
+    uint32_t      get_num_qt() const;
+
+    // slot the prediction is for
+    uint64_t      get_pub_slot() const;
+
+    // set new prediction. returns false if unchanged
+    bool set( const pc_price_t *, uint64_t pub_slot );
+
+    void submit() override;
+  private:
+    price        *ptr_;
+    int64_t       price_;
+    uint64_t      conf_;
+    symbol_status st_;
+    uint32_t      num_qt_;
+    uint64_t      pub_slot_;
+  };
+
+  // read-only view of a decoded price account for bulk consumers. the
+  // accessors read the account in place and are inlined so that a pass
+  // over the prices of a slot needs no call per field. ver_ is the view
+  // layout a consumer was built against (see price_view::version)
+  struct price_view
+  {
+    static const uint32_t version = 1;
+
+    uint32_t          ver_;  // layout version
+    uint64_t          seq_;  // aggregate update sequence number
+    const price      *px_;   // price object with account key and symbol
+    const pc_price_t *acc_;  // decoded price account
+
+    int32_t       get_price_exponent() const;
+    int64_t       get_price() const;
+    uint64_t      get_conf() const;
+    symbol_status get_status() const;
+    uint64_t      get_pub_slot() const;
+    uint64_t      get_valid_slot() const;
+    int64_t       get_twap() const;
+    uint64_t      get_twac() const;
+    int64_t       get_prev_price() const;
+    uint64_t      get_prev_conf() const;
+    uint64_t      get_prev_slot() const;
+    uint32_t      get_num_qt() const;
+
+    // publisher components
+    unsigned      get_num_publisher() const;
+    int64_t       get_publisher_price( unsigned ) const;
+    uint64_t      get_publisher_conf( unsigned ) const;
+    uint64_t      get_publisher_slot( unsigned ) const;
+    symbol_status get_publisher_status( unsigned ) const;
+    const pub_key *get_publisher( unsigned ) const;
+  };
+
   // price subscriber and publisher
   class price : public request,
                 public pub_stats,
-                public rpc_sub_i<rpc::get_account_info>,
                 public rpc_sub_i<rpc::upd_price>
   {
   public:
 
-    price( const pub_key&, product *prod );
+    price( const pub_key&, product *prod, price_arena * );
     virtual ~price();
 
     // corresponding product definition
@@ -269,16 +366,28 @@ namespace pc
     uint64_t get_last_attempted_update_slot() const;
     void set_last_attempted_update_slot( uint64_t );
 
+    // publish slot of our latest update that landed (0 if none) as seen
+    // in our component or tracked by signature
+    uint64_t get_landed_slot() const;
+
+    // queued for the next batch of price updates (see price_queue)
+    bool get_is_dirty() const;
+    void set_is_dirty( bool );
+
     // submit new price update and update aggregate
     // will fail with false if in error (check get_is_err() )
     // or because symbol is not ready to publish (get_is_ready_publish())
     // or because publisher does not have permission (has_publisher())
     bool update( int64_t price, uint64_t conf, symbol_status );
 
+    // rts is the time the update was received if not now
     void update_no_send(
-      int64_t price, uint64_t conf, symbol_status, bool aggr
+      int64_t price, uint64_t conf, symbol_status, bool aggr,
+      int64_t rts = 0L
     );
-    static bool send( price * [], unsigned );
+    // send updates of prices in batches of at most max_num (default the
+    // manager's max batch size)
+    static bool send( price * [], unsigned, unsigned max_num = 0U );
 
     // update aggregate price only
     bool update();
@@ -289,9 +398,14 @@ namespace pc
     // get and activate price schedule subscription
     price_sched *get_sched();
 
+    // account storage and index of this price within it
+    price_arena *get_arena() const;
+    unsigned     get_arena_index() const;
+
     // various accessors
     pub_key       *get_account();
     const pub_key *get_account() const;
+    str            get_account_text() const;
     price_type     get_price_type() const;
     int64_t        get_price_exponent() const;
     uint8_t        get_min_pub() const;
@@ -322,15 +436,25 @@ namespace pc
     // slot of last aggregate price
     uint64_t      get_pub_slot() const;
 
+    // number of aggregate updates notified to subscribers
+    uint64_t      get_update_seq() const;
+
+    // read-only view of the account valid until the next update
+    price_view    get_view();
+
     // output full set of data to json writer
     void dump_json( json_wtr& wtr ) const;
 
+    // notify subscribers of the latest aggregate price or prediction.
+    // prices of a shard leave this to the primary manager's thread
+    void notify();
+    void notify_predict();
+
   public:
     void reset();
     void unsubscribe();
     void submit() override;
     void on_response( rpc::upd_price * ) override;
-    void on_response( rpc::get_account_info * ) override;
     void on_response( rpc::account_update * ) override;
     bool get_is_done() const override;
 
@@ -339,7 +463,14 @@ namespace pc
     typedef enum {
       e_subscribe, e_sent_subscribe, e_publish, e_error } state_t;
 
-    typedef std::vector<std::pair<std::string,int64_t>> txid_vec_t;
+    // unacked transaction signatures, oldest first
+    static const unsigned max_txid = 128;
+
+    struct txid
+    {
+      signature sig_;
+      int64_t   ts_;        // send time or zero once acked
+    };
 
     template<class T> void update( T *res );
 
@@ -347,23 +478,40 @@ namespace pc
     void init_subscribe();
     void log_update( const char *title );
     void update_pub();
+    void predict();
+    void notify_sub();
+    void on_error( const std::string& );
     bool update( int64_t price, uint64_t conf, symbol_status, bool aggr );
+    void add_txid( const signature&, int64_t ts );
 
     bool                   init_;
     bool                   isched_;
     state_t                st_;
     uint32_t               pub_idx_;
+    uint32_t               pnum_;   // component count at last index update
+    uint64_t               plast_;  // last component key at index update
+    pub_key               *ppub_;   // publish key at last index update
     pub_key                apub_;
+    std::string            atxt_;
     uint64_t               lamports_;
     uint64_t               pub_slot_;
+    uint64_t               useq_;
     product               *prod_;
     price_sched            sched_;
     price_init             pinit_;
-    rpc::get_account_info  areq_[1];
+    price_predict          ppred_;
     rpc::upd_price         preq_[1];
+    price_arena           *arena_;
+    unsigned               aidx_;
     pc_price_t            *pptr_;
-    txid_vec_t             tvec_;
+    txid                   tvec_[max_txid];
+    uint64_t               tbeg_;
+    uint64_t               tend_;
+    unsigned               tnum_;
     uint64_t               last_attempted_update_slot_;
+    uint64_t               trc_;    // span of traced update in flight
+    uint64_t               lslot_;  // publish slot of last landed update
+    bool                   is_dirty_;
   };
 
   template<class T>
@@ -386,4 +534,94 @@ namespace pc
     on_response_sub( req );
   }
 
+  inline int32_t price_view::get_price_exponent() const
+  {
+    return acc_->expo_;
+  }
+
+  inline int64_t price_view::get_price() const
+  {
+    return acc_->agg_.price_;
+  }
+
+  inline uint64_t price_view::get_conf() const
+  {
+    return acc_->agg_.conf_;
+  }
+
+  inline symbol_status price_view::get_status() const
+  {
+    return (symbol_status)acc_->agg_.status_;
+  }
+
+  inline uint64_t price_view::get_pub_slot() const
+  {
+    return acc_->agg_.pub_slot_;
+  }
+
+  inline uint64_t price_view::get_valid_slot() const
+  {
+    return acc_->valid_slot_;
+  }
+
+  inline int64_t price_view::get_twap() const
+  {
+    return acc_->twap_.val_;
+  }
+
+  inline uint64_t price_view::get_twac() const
+  {
+    return static_cast< uint64_t >( acc_->twac_.val_ );
+  }
+
+  inline int64_t price_view::get_prev_price() const
+  {
+    return acc_->prev_price_;
+  }
+
+  inline uint64_t price_view::get_prev_conf() const
+  {
+    return acc_->prev_conf_;
+  }
+
+  inline uint64_t price_view::get_prev_slot() const
+  {
+    return acc_->prev_slot_;
+  }
+
+  inline uint32_t price_view::get_num_qt() const
+  {
+    return acc_->num_qt_;
+  }
+
+  inline unsigned price_view::get_num_publisher() const
+  {
+    return acc_->num_;
+  }
+
+  inline int64_t price_view::get_publisher_price( unsigned i ) const
+  {
+    return acc_->comp_[i].agg_.price_;
+  }
+
+  inline uint64_t price_view::get_publisher_conf( unsigned i ) const
+  {
+    return acc_->comp_[i].agg_.conf_;
+  }
+
+  inline uint64_t price_view::get_publisher_slot( unsigned i ) const
+  {
+    return acc_->comp_[i].agg_.pub_slot_;
+  }
+
+  inline symbol_status price_view::get_publisher_status( unsigned i ) const
+  {
+    return (symbol_status)acc_->comp_[i].agg_.status_;
+  }
+
+  inline const pub_key *price_view::get_publisher( unsigned i ) const
+  {
+    return (const pub_key*)&acc_->comp_[i].pub_;
+  }
+
 }
@@ -3,6 +3,10 @@
 #include <unistd.h>
 #include "log.hpp"
 #include <zstd.h>
+#include <algorithm>
+
+// largest serialized transaction accepted by the cluster
+#define PC_TX_MAX_SIZE 1232
 
 using namespace pc;
 
@@ -94,15 +98,31 @@ rpc_client::rpc_client()
 : hptr_( nullptr ),
   wptr_( nullptr ),
   id_( 0UL ),
+  num_( 0 ),
+  hnum_( 1 ),
+  dict_( nullptr ),
   cxt_( nullptr )
 {
   hp_.cp_ = this;
+  tp_.cp_ = this;
   wp_.cp_ = this;
   cxt_ = ZSTD_createDCtx();
 }
 
 rpc_client::~rpc_client()
 {
+  for( rpc_http *hp: hvec_ ) {
+    delete hp;
+  }
+  hvec_.clear();
+  for( rpc_http *hp: gvec_ ) {
+    delete hp;
+  }
+  gvec_.clear();
+  for( method_stats *mr: stat_ ) {
+    delete mr;
+  }
+  stat_.clear();
   if ( cxt_ ) {
     ZSTD_freeDCtx( (ZSTD_DCtx*)cxt_ );
     cxt_ = nullptr;
@@ -112,6 +132,7 @@ rpc_client::~rpc_client()
 void rpc_client::set_http_conn( tcp_connect *hptr )
 {
   hptr_ = hptr;
+  hp_.hptr_ = hptr;
   hptr_->set_net_parser( &hp_ );
 }
 
@@ -120,6 +141,80 @@ tcp_connect *rpc_client::get_http_conn() const
   return hptr_;
 }
 
+void rpc_client::add_http_conn( tcp_connect *hptr )
+{
+  rpc_http *hp = new rpc_http;
+  hp->cp_ = this;
+  hp->hptr_ = hptr;
+  hptr->set_net_parser( hp );
+  hvec_.push_back( hp );
+}
+
+void rpc_client::set_tx_http_conn( tcp_connect *hptr )
+{
+  tp_.hptr_ = hptr;
+  if ( hptr ) {
+    hptr->set_net_parser( &tp_ );
+  }
+}
+
+tcp_connect *rpc_client::get_tx_http_conn() const
+{
+  return tp_.hptr_;
+}
+
+void rpc_client::add_hedge_conn( tcp_connect *hptr )
+{
+  rpc_http *hp = new rpc_http;
+  hp->cp_ = this;
+  hp->hptr_ = hptr;
+  hp->is_hedge_ = true;
+  hptr->set_net_parser( hp );
+  gvec_.push_back( hp );
+}
+
+void rpc_client::reset_hedge_conn( tcp_connect *hptr )
+{
+  for( rpc_http *hp: gvec_ ) {
+    if ( hp->hptr_ == hptr ) {
+      while( !hp->pend_.empty() ) {
+        end_copy( hp->pop_pend() );
+      }
+      hp->reset();
+    }
+  }
+}
+
+void rpc_client::set_hedge_num( unsigned num )
+{
+  hnum_ = std::max( 1U, num );
+}
+
+unsigned rpc_client::get_hedge_num() const
+{
+  return hnum_;
+}
+
+unsigned rpc_client::get_num_hedge_conn() const
+{
+  return static_cast< unsigned >( gvec_.size() );
+}
+
+tcp_connect *rpc_client::get_hedge_conn( unsigned i ) const
+{
+  return gvec_[i]->hptr_;
+}
+
+int64_t rpc_client::get_hedge_latency( unsigned i ) const
+{
+  return gvec_[i]->lat_;
+}
+
+uint64_t rpc_client::get_hedge_wins( unsigned i ) const
+{
+  return gvec_[i]->win_;
+}
+
 void rpc_client::set_ws_conn( net_connect *wptr )
 {
   wptr_ = wptr;
@@ -136,26 +231,183 @@ net_connect *rpc_client::get_ws_conn() const
 
 void rpc_client::reset()
 {
-  rv_.clear();
+  hp_.reset();
+  tp_.reset();
+  for( rpc_http *hp: hvec_ ) {
+    hp->reset();
+  }
+  for( rpc_http *hp: gvec_ ) {
+    hp->reset();
+  }
+  for( pend_slot& ps: rv_ ) {
+    ps.clear();
+  }
   smap_.clear();
   reuse_.clear();
   id_ = 0;
+  num_ = 0;
 }
 
-void rpc_client::send( rpc_request *rptr )
+unsigned rpc_client::get_num_inflight() const
 {
-  // get request id
+  return num_;
+}
+
+unsigned rpc_client::get_num_method() const
+{
+  return static_cast< unsigned >( stat_.size() );
+}
+
+const rpc_client::method_stats& rpc_client::get_method_stats(
+    unsigned i ) const
+{
+  return *stat_[i];
+}
+
+rpc_client::method_stats *rpc_client::get_stats( rpc_request *rptr )
+{
+  // a handful of methods so a linear search is enough
+  str method = rptr->get_method();
+  for( method_stats *it: stat_ ) {
+    if ( it->method_ == method ) {
+      return it;
+    }
+  }
+  method_stats *ms = new method_stats;
+  ms->method_  = method;
+  ms->num_err_ = 0UL;
+  ms->num_ntf_ = 0UL;
+  ms->ntf_ts_  = 0L;
+  stat_.push_back( ms );
+  return ms;
+}
+
+void rpc_client::add_reply( rpc_request *rptr, int64_t now )
+{
+  get_stats( rptr )->rtt_.add( now - rptr->get_sent_time() );
+}
+
+void rpc_client::add_error( rpc_request *rptr, int code )
+{
+  method_stats *ms = get_stats( rptr );
+  ++ms->num_err_;
+  for( std::pair<int,uint64_t>& ec: ms->err_ ) {
+    if ( ec.first == code ) {
+      ++ec.second;
+      return;
+    }
+  }
+  ms->err_.emplace_back( code, 1UL );
+}
+
+void rpc_client::add_ntf( rpc_request *rptr, int64_t now )
+{
+  method_stats *ms = get_stats( rptr );
+  if ( ms->ntf_ts_ ) {
+    ms->gap_.add( now - ms->ntf_ts_ );
+  }
+  ms->ntf_ts_ = now;
+  ++ms->num_ntf_;
+}
+
+void rpc_client::set_zstd_dict( const zstd_dict *dict )
+{
+  dict_ = dict;
+}
+
+const zstd_dict *rpc_client::get_zstd_dict() const
+{
+  return dict_;
+}
+
+uint64_t rpc_client::add_id()
+{
+  // ids are recycled so the pending table stays dense
   uint64_t id;
   if ( !reuse_.empty() ) {
     id = reuse_.back();
     reuse_.pop_back();
   } else {
     id = ++id_;
+    if ( id >= rv_.size() ) {
+      rv_.resize( id + 1 );
+    }
+  }
+  return id;
+}
+
+void rpc_client::add_pend( uint64_t id, rpc_request *rptr )
+{
+  rv_[id].add( rptr );
+  ++num_;
+}
+
+rpc_client::pend_slot *rpc_client::get_pend( uint64_t id )
+{
+  if ( id < rv_.size() && rv_[id].num_ ) {
+    return &rv_[id];
+  }
+  return nullptr;
+}
+
+void rpc_client::del_pend( uint64_t id )
+{
+  pend_slot *ps = get_pend( id );
+  if ( ps ) {
+    num_ -= ps->num_;
+    ps->num_ = 0;
+    ps->ext_.clear();
+    // hold on to id until every hedged copy has replied
+    if ( !ps->copy_ ) {
+      reuse_.push_back( id );
+    }
+  }
+}
+
+void rpc_client::end_copy( uint64_t id )
+{
+  if ( id < rv_.size() && rv_[id].copy_ &&
+       !--rv_[id].copy_ && !rv_[id].num_ ) {
+    reuse_.push_back( id );
   }
+}
+
+rpc_client::pend_slot::pend_slot()
+: num_( 0 ),
+  copy_( 0 )
+{
+}
+
+void rpc_client::pend_slot::add( rpc_request *rptr )
+{
+  if ( num_ < inline_num ) {
+    inl_[num_] = rptr;
+  } else {
+    ext_.push_back( rptr );
+  }
+  ++num_;
+}
+
+rpc_request *rpc_client::pend_slot::get( unsigned i ) const
+{
+  return i < inline_num ? inl_[i] : ext_[i - inline_num];
+}
+
+void rpc_client::pend_slot::clear()
+{
+  num_ = 0;
+  copy_ = 0;
+  ext_.clear();
+}
+
+void rpc_client::send( rpc_request *rptr )
+{
+  // get request id
+  uint64_t id = add_id();
   rptr->set_id( id );
   rptr->set_rpc_client( this );
   rptr->set_sent_time( get_now() );
-  rv_.emplace( id, rptr );
+  add_pend( id, rptr );
 
   // construct json message
   json_wtr jw;
@@ -166,13 +418,8 @@ void rpc_client::send( rpc_request *rptr )
   jw.pop();
 //  jw.print();
   if ( rptr->get_is_http() ) {
-    // submit http POST request
-    http_request msg;
-    msg.init( "POST", "/" );
-    msg.add_hdr( "Host", hptr_->get_host() );
-    msg.add_hdr( "Content-Type", "application/json" );
-    msg.commit( jw );
-    hptr_->add_send( msg );
+    // streamed replies are parsed in place so cannot be raced
+    send_http( jw, id, false, !rptr->get_is_stream() );
   } else if ( wptr_ ) {
     // submit websocket message
     ws_wtr msg;
@@ -191,20 +438,14 @@ void rpc_client::send( rpc::upd_price *upds[], const unsigned n, unsigned cu_uni
   }
 
   // get request id
-  uint64_t id;
-  if ( !reuse_.empty() ) {
-    id = reuse_.back();
-    reuse_.pop_back();
-  } else {
-    id = ++id_;
-  }
+  uint64_t id = add_id();
   const auto now = get_now();
   for ( unsigned i = 0; i < n; ++i ) {
     rpc_request *const rptr = upds[ i ];
     rptr->set_id( id );
     rptr->set_rpc_client( this );
     rptr->set_sent_time( now );
-    rv_.emplace( id, rptr );
+    add_pend( id, rptr );
   }
 
   // construct json message
@@ -216,13 +457,7 @@ void rpc_client::send( rpc::upd_price *upds[], const unsigned n, unsigned cu_uni
   jw.pop();
 //  jw.print();
   if ( upds[ 0 ]->get_is_http() ) {
-    // submit http POST request
-    http_request msg;
-    msg.init( "POST", "/" );
-    msg.add_hdr( "Host", hptr_->get_host() );
-    msg.add_hdr( "Content-Type", "application/json" );
-    msg.commit( jw );
-    hptr_->add_send( msg );
+    send_http( jw, id, true, true );
   } else if ( wptr_ ) {
     // submit websocket message
     ws_wtr msg;
@@ -234,9 +469,288 @@ void rpc_client::send( rpc::upd_price *upds[], const unsigned n, unsigned cu_uni
   }
 }
 
+rpc_client::rpc_http *rpc_client::get_http( bool is_tx )
+{
+  if ( is_tx && tp_.get_is_ready() ) {
+    return &tp_;
+  }
+  rpc_http *res = &hp_;
+  for( rpc_http *hp: hvec_ ) {
+    if ( hp->get_is_ready() && ( hp->get_num() < res->get_num() ||
+          !res->get_is_ready() ) ) {
+      res = hp;
+    }
+  }
+  return res;
+}
+
+void rpc_client::send_http(
+    json_wtr& jw, uint64_t id, bool is_tx, bool do_hedge )
+{
+  // race copies on the hedge connections with the lowest score so that
+  // slow or stalled providers drop out of the selection
+  int64_t now = get_now();
+  size_t num = 0;
+  gsel_.clear();
+  if ( do_hedge && hnum_ > 1 ) {
+    for( rpc_http *hp: gvec_ ) {
+      if ( hp->get_is_ready() ) {
+        gsel_.push_back( hp );
+      }
+    }
+    num = std::min( gsel_.size(), (size_t)hnum_ - 1 );
+    std::partial_sort( gsel_.begin(), gsel_.begin() + (long)num,
+      gsel_.end(), [now]( const rpc_http *a, const rpc_http *b ) {
+        return a->get_score( now ) < b->get_score( now );
+      } );
+  }
+  for( size_t i=0; i != num; ++i ) {
+    json_wtr cp;
+    cp.add_copy( jw );
+    send_http( gsel_[i], cp, id, now );
+  }
+  send_http( get_http( is_tx ), jw, id, now );
+  if ( num ) {
+    rv_[id].copy_ = static_cast< unsigned >( num + 1 );
+  }
+}
+
+void rpc_client::send_http(
+    rpc_http *hp, net_wtr& body, uint64_t id, int64_t ts )
+{
+  // submit http POST request - pipelined behind any pending requests
+  http_request msg;
+  msg.init( "POST", "/" );
+  msg.add_hdr( "Host", hp->hptr_->get_host() );
+  msg.add_hdr( "Content-Type", "application/json" );
+  msg.commit( body );
+  hp->hptr_->add_send( msg );
+  hp->add_pend( id, ts );
+}
+
+rpc_client::rpc_http::rpc_http()
+: cp_( nullptr ),
+  hptr_( nullptr ),
+  lat_( 0L ),
+  win_( 0UL ),
+  is_hedge_( false ),
+  sptr_( nullptr ),
+  st_( e_head ),
+  eoff_( 0UL ),
+  edep_( 0 ),
+  istr_( false ),
+  iesc_( false )
+{
+}
+
+void rpc_client::rpc_http::reset()
+{
+  if ( sptr_ ) {
+    sptr_->set_is_partial( false );
+    sptr_ = nullptr;
+  }
+  pend_.clear();
+  reset_stream();
+}
+
+unsigned rpc_client::rpc_http::get_num() const
+{
+  return static_cast< unsigned >( pend_.size() );
+}
+
+int64_t rpc_client::rpc_http::get_score( int64_t now ) const
+{
+  // smoothed latency unless the oldest reply is already later than that
+  int64_t score = lat_;
+  if ( !pend_.empty() ) {
+    score = std::max( score, now - pend_.front().ts_ );
+  }
+  return score;
+}
+
+void rpc_client::rpc_http::add_pend( uint64_t id, int64_t ts )
+{
+  pend_.push_back( { id, ts } );
+}
+
+uint64_t rpc_client::rpc_http::pop_pend()
+{
+  if ( pend_.empty() ) {
+    return 0;
+  }
+  // replies arrive in request order
+  const pend_req& pr = pend_.front();
+  uint64_t id = pr.id_;
+  int64_t lat = get_now() - pr.ts_;
+  lat_ = lat_ ? lat_ + ( lat - lat_ ) / 8 : lat;
+  pend_.pop_front();
+  return id;
+}
+
+bool rpc_client::rpc_http::get_is_ready() const
+{
+  return hptr_ && !hptr_->get_is_err() &&
+    !hptr_->get_is_wait();
+}
+
 void rpc_client::rpc_http::parse_content( const char *txt, size_t len )
 {
-  cp_->parse_response( txt, len );
+  uint64_t id = pop_pend();
+  if ( cp_->parse_response( txt, len, is_hedge_ ) ) {
+    ++win_;
+  }
+  cp_->end_copy( id );
+}
+
+bool rpc_client::rpc_http::parse_stream( size_t len )
+{
+  // replies arrive in request order so the oldest pending id is ours
+  if ( len < stream_len || pend_.empty() ) {
+    return false;
+  }
+  pend_slot *ps = cp_->get_pend( pend_.front().id_ );
+  if ( !ps || ps->num_ != 1 || !ps->get( 0 )->get_is_stream() ) {
+    return false;
+  }
+  sptr_ = ps->get( 0 );
+  sptr_->set_is_partial( true );
+  pre_.clear();
+  stk_.clear();
+  st_   = e_head;
+  eoff_ = 0;
+  edep_ = 0;
+  istr_ = iesc_ = false;
+  return true;
+}
+
+size_t rpc_client::rpc_http::parse_part(
+    const char *buf, size_t len, bool is_last )
+{
+  size_t idx = 0;
+  if ( st_ == e_head ) {
+    idx += parse_head( buf, len );
+  }
+  if ( st_ == e_elem ) {
+    idx += parse_elem( &buf[idx], len - idx );
+  }
+  if ( st_ == e_tail ) {
+    // nothing of interest after leading array
+    idx = len;
+  }
+  if ( is_last ) {
+    end_stream();
+  }
+  return idx;
+}
+
+size_t rpc_client::rpc_http::parse_head( const char *buf, size_t len )
+{
+  // accumulate reply up to the start of its first array
+  for( size_t i = 0; i != len; ++i ) {
+    const char ch = buf[i];
+    if ( istr_ ) {
+      if ( iesc_ ) {
+        iesc_ = false;
+      } else if ( ch == '\\' ) {
+        iesc_ = true;
+      } else if ( ch == '"' ) {
+        istr_ = false;
+      }
+      continue;
+    }
+    if ( ch == '"' ) {
+      istr_ = true;
+    } else if ( ch == '{' ) {
+      stk_ += '}';
+    } else if ( ch == '}' && !stk_.empty() ) {
+      stk_.pop_back();
+    } else if ( ch == '[' ) {
+      // close with an empty array and parse as a regular reply
+      pre_.append( buf, i );
+      pre_ += "[]";
+      pre_.append( stk_.rbegin(), stk_.rend() );
+      jtree& jp = cp_->jp_;
+      jp.parse( pre_.c_str(), pre_.size() );
+      st_ = jp.find_val( 1, "result" ) ? e_elem : e_tail;
+      sptr_->response( jp );
+      return i + 1;
+    }
+  }
+  pre_.append( buf, len );
+  if ( pre_.size() > stream_len ) {
+    PC_LOG_WRN( "failed to find array in streamed reply" ).end();
+    st_ = e_tail;
+  }
+  return len;
+}
+
+size_t rpc_client::rpc_http::parse_elem( const char *buf, size_t len )
+{
+  // split array elements and parse each one in turn. an incomplete
+  // trailing element is left unconsumed but remembers how far it has
+  // been scanned
+  size_t beg = 0, idx = eoff_;
+  while( idx != len ) {
+    const char ch = buf[idx];
+    if ( istr_ ) {
+      if ( iesc_ ) {
+        iesc_ = false;
+      } else if ( ch == '\\' ) {
+        iesc_ = true;
+      } else if ( ch == '"' ) {
+        istr_ = false;
+      }
+      ++idx;
+      continue;
+    }
+    if ( idx == beg ) {
+      if ( ch == ',' || isspace( ch ) ) {
+        beg = ++idx;
+        continue;
+      }
+      if ( ch == ']' ) {
+        st_ = e_tail;
+        eoff_ = 0;
+        return idx + 1;
+      }
+    }
+    size_t end = 0;
+    if ( ch == '"' ) {
+      istr_ = true;
+    } else if ( ch == '{' || ch == '[' ) {
+      ++edep_;
+    } else if ( edep_ ) {
+      if ( ( ch == '}' || ch == ']' ) && !--edep_ ) {
+        end = idx + 1;
+      }
+    } else if ( ch == ',' || ch == ']' ) {
+      end = idx;
+    }
+    if ( end ) {
+      jtree& jp = cp_->jp_;
+      jp.parse( &buf[beg], end - beg );
+      if ( jp.is_valid() ) {
+        sptr_->response_part( jp );
+      }
+      beg = idx = end;
+    } else {
+      ++idx;
+    }
+  }
+  eoff_ = idx - beg;
+  return beg;
+}
+
+void rpc_client::rpc_http::end_stream()
+{
+  pop_pend();
+  if ( sptr_ ) {
+    const uint64_t id = sptr_->get_id();
+    cp_->add_reply( sptr_, get_now() );
+    sptr_->set_is_partial( false );
+    sptr_ = nullptr;
+    cp_->del_pend( id );
+  }
 }
 
 void rpc_client::rpc_ws::parse_msg( const char *txt, size_t len )
@@ -244,7 +758,8 @@ void rpc_client::rpc_ws::parse_msg( const char *txt, size_t len )
   cp_->parse_response( txt, len );
 }
 
-void rpc_client::parse_response( const char *txt, size_t len )
+bool rpc_client::parse_response(
+    const char *txt, size_t len, bool is_hedge )
 {
   // parse and redirect response to corresponding request
   jp_.parse( txt, len );
@@ -252,13 +767,28 @@ void rpc_client::parse_response( const char *txt, size_t len )
   if ( idtok ) {
     // response to http request
     const uint64_t id = jp_.get_uint( idtok );
-    const auto range = rv_.equal_range( id );
-    for ( auto it = range.first; it != range.second; ++it ) {
-      rpc_request *const rptr = it->second;
-      rptr->response( jp_ );
+    pend_slot *ps = get_pend( id );
+    if ( !ps ) {
+      // already answered by another hedged copy
+      return false;
     }
-    reuse_.push_back( id );
-    rv_.erase( range.first, range.second );
+    if ( is_hedge && ps->copy_ > 1 && jp_.find_val( 1, "error" ) ) {
+      // leave errors from hedge providers to the remaining copies
+      return false;
+    }
+    if ( ps->num_ ) {
+      add_reply( ps->get( 0 ), get_now() );
+      uint32_t etok = jp_.find_val( 1, "error" );
+      if ( PC_UNLIKELY( etok != 0 ) ) {
+        add_error( ps->get( 0 ), static_cast< int >(
+              jp_.get_int( jp_.find_val( etok, "code" ) ) ) );
+      }
+    }
+    // callbacks may send new requests and grow the table so index by id
+    for( unsigned i = 0; get_pend( id ) && i < rv_[id].num_; ++i ) {
+      rv_[id].get( i )->response( jp_ );
+    }
+    del_pend( id );
   } else {
     // websocket notification
     uint32_t ptok = jp_.find_val( 1, "params" );
@@ -266,11 +796,18 @@ void rpc_client::parse_response( const char *txt, size_t len )
     if ( stok ) {
       uint64_t id = jp_.get_uint( stok );
       sub_map_t::iter_t i = smap_.find( id );
+      if ( i ) {
+        add_ntf( smap_.obj(i), get_now() );
+      }
       if ( i  && smap_.obj(i)->notify( jp_ ) ) {
-        smap_.del( i );
+        // callbacks may add or remove subscriptions which moves entries
+        if ( ( i = smap_.find( id ) ) ) {
+          smap_.del( i );
+        }
       }
     }
   }
+  return true;
 }
 
 void rpc_client::add_notify( rpc_request *rptr )
@@ -286,27 +823,51 @@ void rpc_client::remove_notify( rpc_request *rptr )
   }
 }
 
+size_t rpc_client::decode_data(
+    const char *dptr, size_t dlen, char *tgt, size_t tlen )
+{
+  // decode base64 in chunks and stream each straight into zstd so the
+  // compressed account is never materialized in full
+  static const size_t chunk_len = 4096;
+  uint8_t buf[chunk_len*3/4];
+  ZSTD_DCtx *cxt = (ZSTD_DCtx*)cxt_;
+  ZSTD_DCtx_reset( cxt, ZSTD_reset_session_only );
+  ZSTD_outBuffer out = { tgt, tlen, 0 };
+  const char *dbeg = dptr;
+  while( dlen && out.pos < out.size ) {
+    size_t clen = std::min( dlen, chunk_len );
+    ZSTD_inBuffer in = { buf, dec_base64( dptr, (int)clen, buf ), 0 };
+    if ( dptr == dbeg && dict_ ) {
+      // frame header is in the first chunk
+      ZSTD_DCtx_refDDict( cxt, (const ZSTD_DDict*)dict_->get_ddict(
+            ZSTD_getDictID_fromFrame( buf, in.size ) ) );
+    }
+    dptr += clen;
+    dlen -= clen;
+    while( in.pos < in.size && out.pos < out.size ) {
+      if ( ZSTD_isError( ZSTD_decompressStream( cxt, &out, &in ) ) ) {
+        return 0;
+      }
+    }
+  }
+  return out.pos;
+}
+
 size_t rpc_client::get_data_ref(
     const char *dptr, size_t dlen, size_t tlen, char *&ptr )
 {
   tlen = ZSTD_compressBound( tlen );
-  abuf_.resize( dlen );
-  zbuf_.resize( tlen );
-  ZSTD_DCtx *cxt = (ZSTD_DCtx*)cxt_;
-  dlen = dec_base64( dptr, dlen, (uint8_t*)&abuf_[0] );
-  tlen = ZSTD_decompressDCtx( cxt, &zbuf_[0], tlen, &abuf_[0], dlen );
+  if ( zbuf_.size() < tlen ) {
+    zbuf_.resize( tlen );
+  }
   ptr = &zbuf_[0];
-  return tlen;
+  return decode_data( dptr, dlen, ptr, tlen );
 }
 
 size_t rpc_client::get_data_val(
     const char *dptr, size_t dlen, size_t tlen, char *tgt )
 {
-  abuf_.resize( dlen );
-  ZSTD_DCtx *cxt = (ZSTD_DCtx*)cxt_;
-  dlen = dec_base64( dptr, dlen, (uint8_t*)&abuf_[0] );
-  tlen = ZSTD_decompressDCtx( cxt, tgt, tlen, &abuf_[0], dlen );
-  return tlen;
+  return decode_data( dptr, dlen, tgt, tlen );
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -318,7 +879,8 @@ rpc_request::rpc_request()
   id_( 0UL ),
   ec_( 0 ),
   sent_ts_( 0L ),
-  recv_ts_( 0L )
+  recv_ts_( 0L ),
+  is_part_( false )
 {
 }
 
@@ -388,7 +950,22 @@ int64_t rpc_request::get_recv_time() const
 
 bool rpc_request::get_is_recv() const
 {
-  return recv_ts_ >= sent_ts_;
+  return recv_ts_ >= sent_ts_ && !is_part_;
+}
+
+void rpc_request::set_is_partial( bool is_part )
+{
+  is_part_ = is_part;
+}
+
+bool rpc_request::get_is_partial() const
+{
+  return is_part_;
+}
+
+str rpc_request::get_method() const
+{
+  return "unknown";
 }
 
 bool rpc_request::get_is_http() const
@@ -401,6 +978,15 @@ bool rpc_request::notify( const jtree& )
   return true;
 }
 
+bool rpc_request::get_is_stream() const
+{
+  return false;
+}
+
+void rpc_request::response_part( const jtree& )
+{
+}
+
 bool rpc_subscription::get_is_http() const
 {
   return false;
@@ -472,9 +1058,14 @@ rpc::get_recent_block_hash::get_recent_block_hash()
   bhash_.zero();
 }
 
+str rpc::get_recent_block_hash::get_method() const
+{
+  return "getRecentBlockhash";
+}
+
 void rpc::get_recent_block_hash::request( json_wtr& msg )
 {
-  msg.add_key( "method", "getRecentBlockhash" );
+  msg.add_key( "method", get_method() );
 }
 
 void rpc::get_recent_block_hash::response( const jtree& jt )
@@ -507,9 +1098,14 @@ uint64_t rpc::get_slot::get_current_slot() const
   return cslot_;
 }
 
+str rpc::get_slot::get_method() const
+{
+  return "getSlot";
+}
+
 void rpc::get_slot::request( json_wtr& msg )
 {
-  msg.add_key( "method", "getSlot" );
+  msg.add_key( "method", get_method() );
   msg.add_key( "params", json_wtr::e_arr );
   msg.add_val( json_wtr::e_obj );
   msg.add_key( "commitment", commitment_to_str( cmt_ ) );
@@ -526,31 +1122,151 @@ void rpc::get_slot::response( const jtree& jt )
 }
 
 ///////////////////////////////////////////////////////////////////////////
-// account_update
+// get_recent_prioritization_fees
 
-rpc::account_update::account_update()
-: acc_{},
-  cmt_{ commitment::e_confirmed },
-  slot_{ 0UL },
-  lamports_{ 0UL },
-  dlen_{ 0UL },
-  dptr_{ nullptr }
+void rpc::get_recent_prioritization_fees::clear_accounts()
 {
+  avec_.clear();
 }
 
-pub_key const* rpc::account_update::get_account() const
+void rpc::get_recent_prioritization_fees::add_account( const pub_key& acc )
 {
-  return &acc_;
+  if ( avec_.size() < max_accounts ) {
+    avec_.push_back( acc );
+  }
 }
 
-void rpc::account_update::set_account( pub_key *pkey )
+unsigned rpc::get_recent_prioritization_fees::get_num_accounts() const
 {
-  acc_ = *pkey;
+  return static_cast< unsigned >( avec_.size() );
 }
 
-void rpc::account_update::set_commitment( commitment val )
+std::vector<uint64_t>& rpc::get_recent_prioritization_fees::get_fees()
 {
-  cmt_ = val;
+  return fees_;
+}
+
+str rpc::get_recent_prioritization_fees::get_method() const
+{
+  return "getRecentPrioritizationFees";
+}
+
+void rpc::get_recent_prioritization_fees::request( json_wtr& msg )
+{
+  msg.add_key( "method", get_method() );
+  msg.add_key( "params", json_wtr::e_arr );
+  msg.add_val( json_wtr::e_arr );
+  for( const pub_key& acc: avec_ ) {
+    msg.add_val( acc );
+  }
+  msg.pop();
+  msg.pop();
+}
+
+void rpc::get_recent_prioritization_fees::response( const jtree& jt )
+{
+  if ( on_error( jt, this ) ) return;
+  fees_.clear();
+  uint32_t rtok = jt.find_val( 1, "result" );
+  for( uint32_t tok = jt.get_first( rtok ); tok; tok = jt.get_next( tok ) ) {
+    fees_.push_back( jt.get_uint( jt.find_val( tok, "prioritizationFee" ) ) );
+  }
+  on_response( this );
+}
+
+///////////////////////////////////////////////////////////////////////////
+// get_signature_statuses
+
+void rpc::get_signature_statuses::clear_signatures()
+{
+  svec_.clear();
+}
+
+void rpc::get_signature_statuses::add_signature( const signature& sig )
+{
+  if ( svec_.size() < max_signatures ) {
+    svec_.push_back( sig );
+  }
+}
+
+unsigned rpc::get_signature_statuses::get_num_signatures() const
+{
+  return static_cast< unsigned >( svec_.size() );
+}
+
+uint64_t rpc::get_signature_statuses::get_slot( unsigned i ) const
+{
+  return i < res_.size() ? res_[i].slot_ : 0UL;
+}
+
+bool rpc::get_signature_statuses::get_is_tx_err( unsigned i ) const
+{
+  return i < res_.size() && res_[i].is_err_;
+}
+
+str rpc::get_signature_statuses::get_method() const
+{
+  return "getSignatureStatuses";
+}
+
+void rpc::get_signature_statuses::request( json_wtr& msg )
+{
+  msg.add_key( "method", get_method() );
+  msg.add_key( "params", json_wtr::e_arr );
+  msg.add_val( json_wtr::e_arr );
+  for( const signature& sig: svec_ ) {
+    msg.add_val( sig );
+  }
+  msg.pop();
+  msg.pop();
+}
+
+void rpc::get_signature_statuses::response( const jtree& jt )
+{
+  if ( on_error( jt, this ) ) return;
+  res_.clear();
+  uint32_t rtok = jt.find_val( 1, "result" );
+  uint32_t vtok = jt.find_val( rtok, "value" );
+  for( uint32_t tok = jt.get_first( vtok ); tok; tok = jt.get_next( tok ) ) {
+    status st = { 0UL, false };
+    if ( jt.get_type( tok ) == jtree::e_obj ) {
+      st.slot_ = jt.get_uint( jt.find_val( tok, "slot" ) );
+      uint32_t etok = jt.find_val( tok, "err" );
+      st.is_err_ = etok && ( jt.get_type( etok ) != jtree::e_val ||
+                             jt.get_str( etok ) != str( "null" ) );
+    }
+    res_.push_back( st );
+  }
+  on_response( this );
+}
+
+///////////////////////////////////////////////////////////////////////////
+// account_update
+
+rpc::account_update::account_update()
+: acc_{},
+  cmt_{ commitment::e_confirmed },
+  slot_{ 0UL },
+  lamports_{ 0UL },
+  dlen_{ 0UL },
+  dptr_{ nullptr },
+  is_raw_{ false }
+{
+}
+
+pub_key const* rpc::account_update::get_account() const
+{
+  return &acc_;
+}
+
+void rpc::account_update::set_account( pub_key *pkey )
+{
+  acc_ = *pkey;
+}
+
+void rpc::account_update::set_commitment( commitment val )
+{
+  cmt_ = val;
 }
 
 uint64_t rpc::account_update::get_slot() const
@@ -563,6 +1279,50 @@ uint64_t rpc::account_update::get_lamports() const
   return lamports_;
 }
 
+str rpc::account_update::get_data_text() const
+{
+  return str( dptr_, dlen_ );
+}
+
+///////////////////////////////////////////////////////////////////////////
+// raw_account_update
+
+rpc::raw_account_update::raw_account_update()
+: account_update{}
+{
+  is_raw_ = true;
+}
+
+void rpc::raw_account_update::set_update(
+    const pub_key& acc, uint64_t slot, uint64_t lamports,
+    const char *data, size_t len )
+{
+  acc_      = acc;
+  slot_     = slot;
+  lamports_ = lamports;
+  dptr_     = data;
+  dlen_     = len;
+}
+
+void rpc::raw_account_update::dispatch()
+{
+  on_response( static_cast< account_update* >( this ) );
+}
+
+void rpc::raw_account_update::request( json_wtr& )
+{
+}
+
+void rpc::raw_account_update::response( const jtree& )
+{
+}
+
+rpc::routed_account_update::routed_account_update()
+: raw_account_update{}
+{
+  is_raw_ = false;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // get_account_info
 
@@ -591,9 +1351,14 @@ rpc::get_account_info::get_account_info()
 {
 }
 
+str rpc::get_account_info::get_method() const
+{
+  return "getAccountInfo";
+}
+
 void rpc::get_account_info::request( json_wtr& msg )
 {
-  msg.add_key( "method", "getAccountInfo" );
+  msg.add_key( "method", get_method() );
   msg.add_key( "params", json_wtr::e_arr );
   msg.add_val( acc_ );
   msg.add_val( json_wtr::e_obj );
@@ -624,6 +1389,99 @@ bool rpc::get_account_info::get_is_http() const
   return true;
 }
 
+///////////////////////////////////////////////////////////////////////////
+// get_multiple_accounts
+
+rpc::get_multiple_accounts::get_multiple_accounts()
+: account_update{},
+  min_slot_( 0UL )
+{
+}
+
+void rpc::get_multiple_accounts::clear_accounts()
+{
+  avec_.clear();
+}
+
+void rpc::get_multiple_accounts::add_account( const pub_key& acc )
+{
+  if ( avec_.size() < max_accounts ) {
+    avec_.push_back( acc );
+  }
+}
+
+unsigned rpc::get_multiple_accounts::get_num_accounts() const
+{
+  return static_cast< unsigned >( avec_.size() );
+}
+
+const pub_key& rpc::get_multiple_accounts::get_account_key( unsigned i ) const
+{
+  return avec_[i];
+}
+
+void rpc::get_multiple_accounts::set_min_slot( uint64_t slot )
+{
+  min_slot_ = slot;
+}
+
+uint64_t rpc::get_multiple_accounts::get_min_slot() const
+{
+  return min_slot_;
+}
+
+str rpc::get_multiple_accounts::get_method() const
+{
+  return "getMultipleAccounts";
+}
+
+void rpc::get_multiple_accounts::request( json_wtr& msg )
+{
+  msg.add_key( "method", get_method() );
+  msg.add_key( "params", json_wtr::e_arr );
+  msg.add_val( json_wtr::e_arr );
+  for( const pub_key& acc: avec_ ) {
+    msg.add_val( acc );
+  }
+  msg.pop();
+  msg.add_val( json_wtr::e_obj );
+  msg.add_key( "encoding", "base64+zstd" );
+  msg.add_key( "commitment", commitment_to_str( cmt_ ) );
+  if ( min_slot_ ) {
+    msg.add_key( "minContextSlot", min_slot_ );
+  }
+  msg.pop();
+  msg.pop();
+}
+
+void rpc::get_multiple_accounts::response( const jtree& jt )
+{
+  if ( on_error( jt, this ) ) return;
+  uint32_t rtok = jt.find_val( 1, "result" );
+  uint32_t ctok = jt.find_val( rtok, "context" );
+  slot_ = jt.get_uint( jt.find_val( ctok, "slot" ) );
+  uint32_t vtok = jt.find_val( rtok, "value" );
+  uint32_t tok = jt.get_first( vtok );
+  for( const pub_key& acc: avec_ ) {
+    acc_ = acc;
+    lamports_ = 0UL;
+    dptr_ = nullptr;
+    dlen_ = 0UL;
+    if ( tok && jt.get_type( tok ) == jtree::e_obj ) {
+      lamports_ = jt.get_uint( jt.find_val( tok, "lamports" ) );
+      uint32_t dtok = jt.find_val( tok, "data" );
+      jt.get_text( jt.get_first( dtok ), dptr_, dlen_ );
+    }
+    on_response( this );
+    tok = tok ? jt.get_next( tok ) : 0;
+  }
+}
+
+bool rpc::get_multiple_accounts::get_is_http() const
+{
+  return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // account_subscribe
 
@@ -632,9 +1490,14 @@ rpc::account_subscribe::account_subscribe()
 {
 }
 
+str rpc::account_subscribe::get_method() const
+{
+  return "accountSubscribe";
+}
+
 void rpc::account_subscribe::request( json_wtr& msg )
 {
-  msg.add_key( "method", "accountSubscribe" );
+  msg.add_key( "method", get_method() );
   msg.add_key( "params", json_wtr::e_arr );
   msg.add_val( acc_ );
   msg.add_val( json_wtr::e_obj );
@@ -673,6 +1536,144 @@ bool rpc::account_subscribe::notify( const jtree& jt )
   return false;  // keep notification
 }
 
+///////////////////////////////////////////////////////////////////////////
+// program_filter
+
+rpc::program_filter::program_filter()
+: type_( 0 ),
+  dlen_( 0 ),
+  dsize_( 0 ),
+  has_prod_( false )
+{
+}
+
+void rpc::program_filter::set_account_type( uint32_t acc_type )
+{
+  type_ = acc_type;
+}
+
+uint32_t rpc::program_filter::get_account_type() const
+{
+  return type_;
+}
+
+void rpc::program_filter::set_product( const pub_key& prod )
+{
+  prod_ = prod;
+  has_prod_ = true;
+  type_ = PC_ACCTYPE_PRICE;
+}
+
+const pub_key *rpc::program_filter::get_product() const
+{
+  return has_prod_ ? &prod_ : nullptr;
+}
+
+void rpc::program_filter::set_data_len( uint32_t len )
+{
+  dlen_ = len;
+}
+
+uint32_t rpc::program_filter::get_data_len() const
+{
+  return dlen_;
+}
+
+void rpc::program_filter::set_data_size( uint32_t size )
+{
+  dsize_ = size;
+}
+
+uint32_t rpc::program_filter::get_data_size() const
+{
+  return dsize_;
+}
+
+bool rpc::program_filter::init_from_text( str txt )
+{
+  // terms are combined
+  const char *sep = (const char*)__builtin_memchr( txt.str_, ',', txt.len_ );
+  if ( sep ) {
+    size_t len = static_cast< size_t >( sep - txt.str_ );
+    return init_from_text( str( txt.str_, len ) ) &&
+           init_from_text( str( sep + 1, txt.len_ - len - 1 ) );
+  }
+  static const str prod_pfx = "product=";
+  static const str size_pfx = "size=";
+  if ( txt == str( "mapping" ) ) {
+    set_account_type( PC_ACCTYPE_MAPPING );
+  } else if ( txt == str( "product" ) ) {
+    set_account_type( PC_ACCTYPE_PRODUCT );
+  } else if ( txt == str( "price" ) ) {
+    set_account_type( PC_ACCTYPE_PRICE );
+  } else if ( txt.len_ > prod_pfx.len_ &&
+              0 == __builtin_memcmp( txt.str_, prod_pfx.str_, prod_pfx.len_ ) ) {
+    // base58 text of a 32 byte key is at most 44 characters
+    const char *kptr = txt.str_ + prod_pfx.len_;
+    size_t klen = txt.len_ - prod_pfx.len_;
+    uint8_t kbuf[pub_key::len];
+    if ( klen > 44 || 0 > dec_base58_32(
+          (const uint8_t*)kptr, (int)klen, kbuf ) ) {
+      return false;
+    }
+    pub_key prod;
+    prod.init_from_buf( kbuf );
+    set_product( prod );
+  } else if ( txt.len_ > size_pfx.len_ && txt.len_ < size_pfx.len_ + 10 &&
+              0 == __builtin_memcmp( txt.str_, size_pfx.str_, size_pfx.len_ ) ) {
+    const char *nptr = txt.str_ + size_pfx.len_;
+    unsigned nlen = static_cast< unsigned >( txt.len_ - size_pfx.len_ );
+    for( unsigned i = 0; i != nlen; ++i ) {
+      if ( nptr[i] < '0' || nptr[i] > '9' ) {
+        return false;
+      }
+    }
+    set_data_size( static_cast< uint32_t >( str_to_uint( nptr, nlen ) ) );
+    return dsize_ != 0;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void rpc::program_filter::request( json_wtr& msg ) const
+{
+  if ( type_ || dsize_ ) {
+    msg.add_key( "filters", json_wtr::e_arr );
+  }
+  if ( type_ ) {
+    msg.add_val( json_wtr::e_obj );
+    msg.add_key( "memcmp", json_wtr::e_obj );
+    msg.add_key( "offset", offsetof( pc_acc_t, type_ ) );
+    msg.add_key_enc_base58(
+      "bytes", str( ( char* )&type_, sizeof( type_ ) ) );
+    msg.pop();
+    msg.pop();
+    if ( has_prod_ ) {
+      msg.add_val( json_wtr::e_obj );
+      msg.add_key( "memcmp", json_wtr::e_obj );
+      msg.add_key( "offset", offsetof( pc_price_t, prod_ ) );
+      msg.add_key( "bytes", prod_ );
+      msg.pop();
+      msg.pop();
+    }
+  }
+  if ( dsize_ ) {
+    msg.add_val( json_wtr::e_obj );
+    msg.add_key( "dataSize", (uint64_t)dsize_ );
+    msg.pop();
+  }
+  if ( type_ || dsize_ ) {
+    msg.pop();
+  }
+  if ( dlen_ ) {
+    msg.add_key( "dataSlice", json_wtr::e_obj );
+    msg.add_key( "offset", 0UL );
+    msg.add_key( "length", (uint64_t)dlen_ );
+    msg.pop();
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // program_subscribe
 
@@ -687,14 +1688,25 @@ void rpc::program_subscribe::set_program( pub_key *pkey )
   pgm_ = pkey;
 }
 
+void rpc::program_subscribe::set_filter( const program_filter& filt )
+{
+  filt_ = filt;
+}
+
+str rpc::program_subscribe::get_method() const
+{
+  return "programSubscribe";
+}
+
 void rpc::program_subscribe::request( json_wtr& msg )
 {
-  msg.add_key( "method", "programSubscribe" );
+  msg.add_key( "method", get_method() );
   msg.add_key( "params", json_wtr::e_arr );
   msg.add_val( *pgm_ );
   msg.add_val( json_wtr::e_obj );
   msg.add_key( "encoding", "base64+zstd" );
   msg.add_key( "commitment", commitment_to_str( cmt_ ) );
+  filt_.request( msg );
   msg.pop();
   msg.pop();
 }
@@ -737,7 +1749,6 @@ bool rpc::program_subscribe::notify( const jtree& jt )
 rpc::get_program_accounts::get_program_accounts()
 : account_update{}
 , pgm_{ nullptr }
-, acct_type_{ 0 }
 {
 }
 
@@ -748,28 +1759,28 @@ void rpc::get_program_accounts::set_program( pub_key *pkey )
 
 void rpc::get_program_accounts::set_account_type( uint32_t const acct_type )
 {
-  acct_type_ = acct_type;
+  filt_.set_account_type( acct_type );
+}
+
+void rpc::get_program_accounts::set_filter( const program_filter& filt )
+{
+  filt_ = filt;
+}
+
+str rpc::get_program_accounts::get_method() const
+{
+  return "getProgramAccounts";
 }
 
 void rpc::get_program_accounts::request( json_wtr& msg )
 {
-  msg.add_key( "method", "getProgramAccounts" );
+  msg.add_key( "method", get_method() );
   msg.add_key( "params", json_wtr::e_arr );
   msg.add_val( *pgm_ );
   msg.add_val( json_wtr::e_obj );
   msg.add_key( "encoding", "base64+zstd" );
   msg.add_key( "commitment", commitment_to_str( cmt_ ) );
-  if ( acct_type_ ) {
-    msg.add_key( "filters", json_wtr::e_arr );
-    msg.add_val( json_wtr::e_obj );
-    msg.add_key( "memcmp", json_wtr::e_obj );
-    msg.add_key( "offset", offsetof( pc_acc_t, type_ ) );
-    msg.add_key_enc_base58(
-      "bytes", str( ( char* )&acct_type_, sizeof( acct_type_ ) ) );
-    msg.pop();
-    msg.pop();
-    msg.pop();
-  }
+  filt_.request( msg );
   msg.add_key( "withContext", json_wtr::jtrue{} );
   msg.pop();
   msg.pop();
@@ -785,22 +1796,40 @@ void rpc::get_program_accounts::response( const jtree& jt )
   slot_ = jt.get_uint( jt.find_val( ctok, "slot" ) );
   uint32_t const vtok = jt.find_val( rtok, "value" );
   for ( uint32_t tok = jt.get_first( vtok ); tok; tok = jt.get_next( tok ) ) {
-    str akey = jt.get_str( jt.find_val( tok, "pubkey" ) );
-    acc_.init_from_text( akey );
-    uint32_t const atok = jt.find_val( tok, "account" );
-    lamports_ = jt.get_uint( jt.find_val( atok, "lamports" ) );
-    uint32_t dtok = jt.find_val( atok, "data" );
-    jt.get_text( jt.get_first( dtok ), dptr_, dlen_ );
-
-    on_response( this_t );
+    parse_account( jt, tok );
   }
 }
 
+void rpc::get_program_accounts::response_part( const jtree& jt )
+{
+  // single element of streamed value array
+  parse_account( jt, 1 );
+}
+
+void rpc::get_program_accounts::parse_account( const jtree& jt, uint32_t tok )
+{
+  auto* const this_t = static_cast< account_update* >( this );
+
+  str akey = jt.get_str( jt.find_val( tok, "pubkey" ) );
+  acc_.init_from_text( akey );
+  uint32_t const atok = jt.find_val( tok, "account" );
+  lamports_ = jt.get_uint( jt.find_val( atok, "lamports" ) );
+  uint32_t dtok = jt.find_val( atok, "data" );
+  jt.get_text( jt.get_first( dtok ), dptr_, dlen_ );
+
+  on_response( this_t );
+}
+
 bool rpc::get_program_accounts::get_is_http() const
 {
   return true;
 }
 
+bool rpc::get_program_accounts::get_is_stream() const
+{
+  return true;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // upd_price
 
@@ -809,7 +1838,11 @@ rpc::upd_price::upd_price()
   ckey_( nullptr ),
   gkey_( nullptr ),
   akey_( nullptr ),
-  cmd_( e_cmd_upd_price_no_fail_on_error )
+  price_( 0L ),
+  conf_( 0UL ),
+  pub_slot_( 0UL ),
+  cmd_( e_cmd_upd_price_no_fail_on_error ),
+  st_( symbol_status::e_unknown )
 {
 }
 
@@ -863,11 +1896,36 @@ uint64_t rpc::upd_price::get_slot() {
   return pub_slot_;
 }
 
+int64_t rpc::upd_price::get_price() const
+{
+  return price_;
+}
+
+uint64_t rpc::upd_price::get_conf() const
+{
+  return conf_;
+}
+
+symbol_status rpc::upd_price::get_symbol_status() const
+{
+  return st_;
+}
+
+bool rpc::upd_price::get_is_aggregate() const
+{
+  return cmd_ == e_cmd_agg_price;
+}
+
 signature *rpc::upd_price::get_signature()
 {
   return &sig_;
 }
 
+key_cache *rpc::upd_price::get_pubcache() const
+{
+  return ckey_;
+}
+
 str rpc::upd_price::get_ack_signature() const
 {
   return ack_sig_;
@@ -892,6 +1950,45 @@ public:
 // specifying the number of requested cu units, and a price per cu unit, to enable
 // priority fees. If these parameters are emitted these are left as unspecified in
 // the transaction.
+static size_t compact_len_size( size_t len )
+{
+  return len < 0x80 ? 1 : ( len < 0x4000 ? 2 : 3 );
+}
+
+size_t rpc::upd_price::get_tx_size(
+  unsigned n,
+  unsigned cu_units,
+  unsigned cu_price
+)
+{
+  // as laid out by build_msg
+  size_t num_ix = n;
+  num_ix += cu_units > 0 ? 1 : 0;
+  num_ix += cu_price > 0 ? 1 : 0;
+  size_t len = compact_len_size( 1 ) + signature::len; // signature
+  len += 3;                                            // message header
+  len += compact_len_size( n + 4 ) + ( n + 4 ) * pub_key::len;
+  len += hash::len;                                    // block hash
+  len += compact_len_size( num_ix );
+  if ( cu_units > 0 ) {
+    len += 3 + sizeof( uint8_t ) + sizeof( uint32_t );
+  }
+  if ( cu_price > 0 ) {
+    len += 3 + sizeof( uint8_t ) + sizeof( uint64_t );
+  }
+  len += n * ( 6 + sizeof( cmd_upd_price_t ) );
+  return len;
+}
+
+unsigned rpc::upd_price::get_max_num( unsigned cu_units, unsigned cu_price )
+{
+  unsigned n = 1;
+  while( get_tx_size( n + 1, cu_units, cu_price ) <= PC_TX_MAX_SIZE ) {
+    ++n;
+  }
+  return n;
+}
+
 bool rpc::upd_price::build_tx(
   bincode& tx,
   upd_price* upds[],
@@ -899,26 +1996,130 @@ bool rpc::upd_price::build_tx(
   unsigned cu_units,
   unsigned cu_price
 )
+{
+  size_t pub_idx, tx_idx;
+  if ( ! build_msg( tx, upds, n, cu_units, cu_price, pub_idx, tx_idx ) ) {
+    return false;
+  }
+
+  // all accounts need to sign transaction
+  auto& first = *upds[ 0 ];
+  tx.sign( pub_idx, tx_idx, *first.ckey_ );
+  first.sig_.init_from_buf( (const uint8_t*)(tx.get_buf() + pub_idx) );
+
+  return true;
+}
+
+// serialized upd_price message of one batch composition (publisher,
+// price accounts, program and compute budget). a batch of the same
+// composition only rewrites the block hash and the price fields
+struct upd_tmpl
+{
+  uint64_t            key_;      // hash of batch composition
+  unsigned            num_;
+  unsigned            cu_units_;
+  unsigned            cu_price_;
+  size_t              pub_idx_;  // positions relative to message start
+  size_t              tx_idx_;
+  size_t              acc_idx_;  // publish account key
+  size_t              bh_idx_;   // recent block hash
+  std::vector<size_t> cmd_idx_;  // command of each upd_price instruction
+  std::string         buf_;
+};
+
+static const unsigned max_upd_tmpl = 64;
+static thread_local std::vector<upd_tmpl> upd_tmpl_;
+static thread_local unsigned upd_tmpl_idx_ = 0;
+
+static inline uint64_t upd_tmpl_hash( uint64_t key, const void *ptr )
+{
+  return ( key ^ (uint64_t)ptr ) * 0x9e3779b97f4a7c15UL;
+}
+
+static inline bool upd_tmpl_match( const char *buf, const uint8_t *pk )
+{
+  uint64_t a[4], b[4];
+  __builtin_memcpy( a, buf, sizeof( a ) );
+  __builtin_memcpy( b, pk, sizeof( b ) );
+  return ( ( a[0] ^ b[0] ) | ( a[1] ^ b[1] ) |
+           ( a[2] ^ b[2] ) | ( a[3] ^ b[3] ) ) == 0;
+}
+
+bool rpc::upd_price::build_msg(
+  bincode& tx,
+  upd_price* upds[],
+  const unsigned n,
+  unsigned cu_units,
+  unsigned cu_price,
+  size_t& pub_idx,
+  size_t& tx_idx
+)
 {
   if ( ! n ) {
     return false;
   }
 
+  auto& first = *upds[ 0 ];
+
+  // look for a template of the same composition. keys are matched by
+  // value as well as by address
+  uint64_t key = upd_tmpl_hash( ( (uint64_t)cu_units << 32 ) | cu_price, first.gkey_ );
+  key = upd_tmpl_hash( key, first.pkey_ );
+  for ( unsigned i = 0; i < n; ++i ) {
+    key = upd_tmpl_hash( key, upds[ i ]->akey_ );
+  }
+  size_t pos = tx.get_pos();
+  for ( const upd_tmpl& tp : upd_tmpl_ ) {
+    if ( tp.key_ != key || tp.num_ != n || tp.cu_units_ != cu_units || tp.cu_price_ != cu_price ) {
+      continue;
+    }
+    const char *acc = &tp.buf_[ tp.acc_idx_ ];
+    bool is_match = upd_tmpl_match( acc, &first.pkey_->data()[ pub_key::len ] ) &&
+      upd_tmpl_match( &acc[ ( n + 2 ) * pub_key::len ], first.gkey_->data() );
+    for ( unsigned i = 0; is_match && i < n; ++i ) {
+      is_match = upd_tmpl_match( &acc[ ( i + 1 ) * pub_key::len ], upds[ i ]->akey_->data() );
+    }
+    if ( ! is_match ) {
+      continue;
+    }
+    char *msg = tx.get_wtr();
+    __builtin_memcpy( msg, tp.buf_.data(), tp.buf_.size() );
+    __builtin_memcpy( &msg[ tp.bh_idx_ ], first.bhash_->data(), hash::len );
+    for ( unsigned i = 0; i < n; ++i ) {
+      auto const& upd = *upds[ i ];
+      bincode prm( &msg[ tp.cmd_idx_[ i ] ] );
+      prm.add( (int32_t)( upd.cmd_ ) );
+      prm.add( (int32_t)( upd.st_ ) );
+      prm.add( (int32_t)0 );
+      prm.add( upd.price_ );
+      prm.add( upd.conf_ );
+      prm.add( upd.pub_slot_ );
+    }
+    pub_idx = pos + tp.pub_idx_;
+    tx_idx = pos + tp.tx_idx_;
+    tx.set_pos( pos + tp.buf_.size() );
+    return true;
+  }
+  upd_tmpl tp;
+  tp.key_ = key;
+  tp.num_ = n;
+  tp.cu_units_ = cu_units;
+  tp.cu_price_ = cu_price;
+
   // signatures section
   tx.add_len< 1 >(); // one signature (publish)
-  size_t pub_idx = tx.reserve_sign();
+  pub_idx = tx.reserve_sign();
 
   // message header
-  size_t tx_idx = tx.get_pos();
+  tx_idx = tx.get_pos();
   tx.add( (uint8_t)1 ); // pub is only signing account
   tx.add( (uint8_t)0 ); // read-only signed accounts
   tx.add( (uint8_t)2 ); // sysvar and program-id are read-only
                         // unsigned accounts
 
-  auto& first = *upds[ 0 ];
-
   // accounts
   tx.add_len( n + 4 ); // n + 4 accounts: publish, symbol{n}, sysvar, pyth program, compute budget program
+  tp.acc_idx_ = tx.get_pos() - pos;
   tx.add( *first.pkey_ ); // publish account
   for ( unsigned i = 0; i < n; ++i ) {
     tx.add( *upds[ i ]->akey_ ); // symbol account
@@ -928,6 +2129,7 @@ bool rpc::upd_price::build_tx(
   tx.add( *(pub_key*)compute_budget_program_id ); // compute budget program id
 
   // recent block hash
+  tp.bh_idx_ = tx.get_pos() - pos;
   tx.add( *first.bhash_ ); // recent block hash
 
   // instructions section
@@ -972,6 +2174,7 @@ bool rpc::upd_price::build_tx(
     // instruction parameter section
     tx.add_len<sizeof(cmd_upd_price)>();
     tx.add( (uint32_t)PC_VERSION );
+    tp.cmd_idx_.push_back( tx.get_pos() - pos );
     tx.add( (int32_t)( upd.cmd_ ) );
     tx.add( (int32_t)( upd.st_ ) );
     tx.add( (int32_t)0 );
@@ -980,9 +2183,15 @@ bool rpc::upd_price::build_tx(
     tx.add( upd.pub_slot_ );
   }
 
-  // all accounts need to sign transaction
-  tx.sign( pub_idx, tx_idx, *first.ckey_ );
-  first.sig_.init_from_buf( (const uint8_t*)(tx.get_buf() + pub_idx) );
+  // keep template, replacing the oldest once the cache is full
+  tp.pub_idx_ = pub_idx - pos;
+  tp.tx_idx_ = tx_idx - pos;
+  tp.buf_.assign( tx.get_buf() + pos, tx.get_pos() - pos );
+  if ( upd_tmpl_.size() < max_upd_tmpl ) {
+    upd_tmpl_.emplace_back( std::move( tp ) );
+  } else {
+    upd_tmpl_[ upd_tmpl_idx_++ % max_upd_tmpl ] = std::move( tp );
+  }
 
   return true;
 }
@@ -994,6 +2203,11 @@ void rpc::upd_price::build( net_wtr& wtr )
 }
 
 
+str rpc::upd_price::get_method() const
+{
+  return "sendTransaction";
+}
+
 void rpc::upd_price::request( json_wtr& msg )
 {
   upd_price* upds[] = { this };
@@ -6,8 +6,11 @@
 #include <pc/attr_id.hpp>
 #include <oracle/oracle.h>
 #include <pc/hash_map.hpp>
+#include <pc/zstd_dict.hpp>
+#include <pc/pub_stats.hpp>
 
-#include <unordered_map>
+#include <algorithm>
+#include <deque>
 
 #define PC_RPC_ERROR_BLOCK_CLEANED_UP          -32001
 #define PC_RPC_ERROR_SEND_TX_PREFLIGHT_FAIL    -32002
@@ -20,6 +23,7 @@
 #define PC_RPC_ERROR_LONG_TERM_SLOT_SKIPPED    -32009
 
 #define PC_TPU_PROTO_ID 0xb1ab
+#define PC_TPU_LAND_ID  0xb1ac
 
 namespace pc
 {
@@ -81,6 +85,34 @@ namespace pc
     void set_http_conn( tcp_connect * );
     tcp_connect *get_http_conn() const;
 
+    // additional pooled rpc http connections
+    // requests are routed to the connection with fewest pending replies
+    void add_http_conn( tcp_connect * );
+
+    // dedicated http connection for sendTransaction requests so they
+    // never queue behind slow bulk account fetches
+    void set_tx_http_conn( tcp_connect * );
+    tcp_connect *get_tx_http_conn() const;
+
+    // http connection to another rpc provider on the same network.
+    // http requests are hedged across the primary connection and the
+    // fastest of these - the first valid reply wins and later copies
+    // are dropped
+    void add_hedge_conn( tcp_connect * );
+
+    // abandon replies pending on a failed hedge connection
+    void reset_hedge_conn( tcp_connect * );
+
+    // number of endpoints each http request is sent to (default 1)
+    void set_hedge_num( unsigned );
+    unsigned get_hedge_num() const;
+
+    // hedge connection stats
+    unsigned get_num_hedge_conn() const;
+    tcp_connect *get_hedge_conn( unsigned i ) const;
+    int64_t get_hedge_latency( unsigned i ) const;  // smoothed reply ns
+    uint64_t get_hedge_wins( unsigned i ) const;    // replies used
+
     // rpc web socket connection
     void set_ws_conn( net_connect * );
     net_connect *get_ws_conn() const;
@@ -89,10 +121,39 @@ namespace pc
     void send( rpc_request * );
     void send( rpc::upd_price *[], unsigned n, unsigned cu_units, unsigned cu_price );
 
+    // number of requests awaiting a reply
+    unsigned get_num_inflight() const;
+
+    // error reply counts by error code
+    typedef std::vector<std::pair<int,uint64_t>> err_vec_t;
+
+    // reply and notification statistics of a json rpc method. replies
+    // cover http and websocket requests (including subscription acks)
+    // and notifications are counted under the subscribe method
+    struct method_stats {
+      str       method_;
+      lat_hist  rtt_;     // reply round trip time
+      lat_hist  gap_;     // time between notifications
+      uint64_t  num_err_; // error replies
+      uint64_t  num_ntf_; // subscription notifications
+      int64_t   ntf_ts_;  // time of last notification
+      err_vec_t err_;
+    };
+
+    // statistics by method in order of first use
+    unsigned get_num_method() const;
+    const method_stats& get_method_stats( unsigned i ) const;
+
+    // zstd dictionaries used to decode account data (optional)
+    void set_zstd_dict( const zstd_dict * );
+    const zstd_dict *get_zstd_dict() const;
+
   public:
 
-    // parse json payload and invoke callback
-    void parse_response( const char *msg, size_t msg_len );
+    // parse json payload and invoke callback - returns false if the
+    // reply was dropped as a duplicate or as an error from a hedge
+    bool parse_response( const char *msg, size_t msg_len,
+                         bool is_hedge=false );
 
     // add/remove request from notification map
     void add_notify( rpc_request * );
@@ -110,9 +171,49 @@ namespace pc
 
   private:
 
+    // stream base64 decode into zstd decompression of target
+    size_t decode_data( const char *dptr, size_t dlen, char *tgt, size_t );
+
+    // reply expected on http connection
+    struct pend_req {
+      uint64_t id_;
+      int64_t  ts_;  // time sent
+    };
+
+    typedef std::deque<pend_req>      pend_t;
+
+    // large replies to requests supporting it are parsed incrementally
+    // one element of the reply's leading array at a time
     struct rpc_http : public http_client {
+      static const size_t stream_len = 64UL * 1024UL;
+      enum state { e_head, e_elem, e_tail };
+      rpc_http();
       void parse_content( const char *, size_t ) override;
-      rpc_client *cp_;
+      bool parse_stream( size_t ) override;
+      size_t parse_part( const char *, size_t, bool ) override;
+      size_t parse_head( const char *, size_t );
+      size_t parse_elem( const char *, size_t );
+      void end_stream();
+      void reset();
+      bool get_is_ready() const;
+      unsigned get_num() const;
+      int64_t get_score( int64_t now ) const;
+      void add_pend( uint64_t id, int64_t ts );
+      uint64_t pop_pend();
+      rpc_client  *cp_;
+      tcp_connect *hptr_;
+      pend_t       pend_; // pending replies
+      int64_t      lat_;  // smoothed reply latency
+      uint64_t     win_;  // replies dispatched
+      bool         is_hedge_;
+      rpc_request *sptr_; // request receiving streamed reply
+      std::string  pre_;  // streamed reply up to leading array
+      std::string  stk_;  // open containers
+      state        st_;   // stream parse state
+      size_t       eoff_; // bytes of current element scanned
+      unsigned     edep_; // current element depth
+      bool         istr_; // scanning string
+      bool         iesc_; // next char escaped
     };
 
     struct rpc_ws : public ws_parser {
@@ -131,22 +232,60 @@ namespace pc
       };
     };
 
-    typedef std::unordered_multimap< uint64_t, rpc_request* > request_t;
+    // requests waiting on the same id (i.e. one batched transaction)
+    // stored inline up to the default batch size
+    struct pend_slot {
+      static const unsigned inline_num = 8;
+      pend_slot();
+      void add( rpc_request * );
+      rpc_request *get( unsigned i ) const;
+      void clear();
+      typedef std::vector<rpc_request*> ext_t;
+      rpc_request *inl_[inline_num];
+      ext_t        ext_;
+      unsigned     num_;
+      unsigned     copy_; // hedged copies awaiting reply
+    };
+
+    typedef std::vector<pend_slot>    request_t;
     typedef std::vector<uint64_t>     id_vec_t;
     typedef std::vector<char>         acc_buf_t;
-    typedef hash_map<trait>           sub_map_t;
+    typedef open_hash_map<trait>      sub_map_t;
+    typedef std::vector<rpc_http*>    http_vec_t;
+
+    uint64_t add_id();
+    void add_pend( uint64_t id, rpc_request * );
+    typedef std::vector<method_stats*> stat_vec_t;
+
+    pend_slot *get_pend( uint64_t id );
+    void del_pend( uint64_t id );
+    method_stats *get_stats( rpc_request * );
+    void add_reply( rpc_request *, int64_t now );
+    void add_error( rpc_request *, int code );
+    void add_ntf( rpc_request *, int64_t now );
+    void end_copy( uint64_t id );
+    rpc_http *get_http( bool is_tx );
+    void send_http( json_wtr&, uint64_t id, bool is_tx, bool do_hedge );
+    void send_http( rpc_http *, net_wtr&, uint64_t id, int64_t ts );
 
     tcp_connect *hptr_;
     net_connect *wptr_;
     rpc_http     hp_;    // http parser wrapper
+    rpc_http     tp_;    // transaction http parser wrapper
+    http_vec_t   hvec_;  // additional pooled http connections
+    http_vec_t   gvec_;  // hedge http connections
+    http_vec_t   gsel_;  // hedge connection selection
     rpc_ws       wp_;    // websocket parser wrapper
     jtree        jp_;    // json parser
-    request_t    rv_;    // waiting requests by id
+    request_t    rv_;    // waiting requests indexed by id
     id_vec_t     reuse_; // reuse id list
     sub_map_t    smap_;  // subscription map
-    acc_buf_t    abuf_;  // account decode buffer
     acc_buf_t    zbuf_;  // account decompress buffer
+    stat_vec_t   stat_;  // reply statistics by method
     uint64_t     id_;    // next request id
+    unsigned     num_;   // requests awaiting reply
+    unsigned     hnum_;  // endpoints per hedged request
+    const zstd_dict *dict_; // account dictionaries
     void        *cxt_;
   };
 
@@ -193,9 +332,13 @@ namespace pc
     void set_recv_time( int64_t );
     int64_t get_recv_time() const;
 
-    // have we received a reply
+    // have we received a (complete) reply
     bool get_is_recv() const;
 
+    // still receiving an incrementally parsed reply
+    void set_is_partial( bool );
+    bool get_is_partial() const;
+
     // rpc response callback
     void set_sub( rpc_sub * );
     rpc_sub *get_sub() const;
@@ -203,6 +346,9 @@ namespace pc
     // is this message http or websocket bound
     virtual bool get_is_http() const;
 
+    // json rpc method name
+    virtual str get_method() const;
+
     // request builder
     virtual void request( json_wtr& ) = 0;
 
@@ -212,6 +358,12 @@ namespace pc
     // notification subscription update
     virtual bool notify( const jtree& );
 
+    // parse large http replies incrementally - response is invoked with
+    // the reply's leading array left empty followed by response_part
+    // for each of its elements
+    virtual bool get_is_stream() const;
+    virtual void response_part( const jtree& );
+
   protected:
 
     template<class T> void on_response( T * );
@@ -224,6 +376,7 @@ namespace pc
     int         ec_;
     int64_t     sent_ts_;
     int64_t     recv_ts_;
+    bool        is_part_;
   };
 
   struct tx_hdr
@@ -232,6 +385,14 @@ namespace pc
     uint16_t size_;
   };
 
+  // landing report sent to pyth_tx after a tx_hdr with PC_TPU_LAND_ID.
+  // an update sent for pub_slot was first seen on chain in land_slot
+  struct PC_PACKED tx_land
+  {
+    uint64_t pub_slot_;
+    uint64_t land_slot_;
+  };
+
   // transaction builder
   class tx_request : public error
   {
@@ -267,6 +428,7 @@ namespace pc
 
       get_recent_block_hash();
       void request( json_wtr& ) override;
+      str get_method() const override;
       void response( const jtree& ) override;
 
     private:
@@ -282,12 +444,66 @@ namespace pc
       get_slot( commitment = e_finalized );
       uint64_t get_current_slot() const;
       void request( json_wtr& ) override;
+      str get_method() const override;
       void response( const jtree& ) override;
     private:
       commitment const cmt_; // param
       uint64_t cslot_; // result
     };
 
+    // prioritization fees of recent slots that write lock any of the
+    // given accounts
+    class get_recent_prioritization_fees : public rpc_request
+    {
+    public:
+      static const unsigned max_accounts = 128;
+
+      // parameters
+      void clear_accounts();
+      void add_account( const pub_key& );
+      unsigned get_num_accounts() const;
+
+      // results in micro-lamports per compute unit, one per slot
+      std::vector<uint64_t>& get_fees();
+
+      void request( json_wtr& ) override;
+      str get_method() const override;
+      void response( const jtree& ) override;
+
+    private:
+      std::vector<pub_key>  avec_;
+      std::vector<uint64_t> fees_;
+    };
+
+    // processing status of recent transactions by signature
+    class get_signature_statuses : public rpc_request
+    {
+    public:
+      static const unsigned max_signatures = 256;
+
+      // parameters
+      void clear_signatures();
+      void add_signature( const signature& );
+      unsigned get_num_signatures() const;
+
+      // results by signature index. slot is zero if the transaction
+      // was not found
+      uint64_t get_slot( unsigned ) const;
+      bool get_is_tx_err( unsigned ) const;
+
+      void request( json_wtr& ) override;
+      str get_method() const override;
+      void response( const jtree& ) override;
+
+    private:
+      struct status {
+        uint64_t slot_;
+        bool     is_err_;
+      };
+      std::vector<signature> svec_;
+      std::vector<status>    res_;
+    };
+
     // base class for account updates
     class account_update : public rpc_subscription
     {
@@ -302,6 +518,7 @@ namespace pc
       // results
       uint64_t get_slot() const;
       uint64_t get_lamports() const;
+      str      get_data_text() const; // data as received (encoded unless raw)
       template<class T>
       size_t get_data_ref( T *&, size_t srclen=sizeof(T) ) const;
       template<class T>
@@ -314,11 +531,16 @@ namespace pc
       uint64_t    lamports_;
       size_t      dlen_;
       const char *dptr_;
+      bool        is_raw_;  // dptr_ is account data, not base64+zstd
     };
 
     template<class T>
     size_t account_update::get_data_ref( T *&res, size_t tlen ) const
     {
+      if ( is_raw_ ) {
+        res = (T*)dptr_;
+        return dlen_;
+      }
       char *ptr;
       size_t len = get_rpc_client()->get_data_ref( dptr_, dlen_, tlen, ptr );
       res = (T*)ptr;
@@ -328,11 +550,42 @@ namespace pc
     template<class T>
     size_t account_update::get_data_val( T *res, size_t tlen ) const
     {
+      if ( is_raw_ ) {
+        size_t len = std::min( dlen_, tlen );
+        __builtin_memcpy( (char*)res, dptr_, len );
+        return len;
+      }
       char *ptr = (char*)res;
       size_t len = get_rpc_client()->get_data_val( dptr_, dlen_, tlen, ptr );
       return len;
     }
 
+    // account data received from a binary streaming source instead of
+    // an rpc node. data is referenced, not copied, and must stay valid
+    // and 8-byte aligned until the update callback returns
+    class raw_account_update : public account_update
+    {
+    public:
+      raw_account_update();
+
+      void set_update( const pub_key& acc, uint64_t slot,
+                       uint64_t lamports, const char *data, size_t len );
+
+      // invoke subscriber callback
+      void dispatch();
+
+      void request( json_wtr& ) override;
+      void response( const jtree& ) override;
+    };
+
+    // account update received by another rpc client and handed over with
+    // its data as received. decoded with the rpc client of the update
+    class routed_account_update : public raw_account_update
+    {
+    public:
+      routed_account_update();
+    };
+
     // get account balance, program data and account meta-data
     class get_account_info : public account_update
     {
@@ -344,6 +597,7 @@ namespace pc
 
       get_account_info();
       void request( json_wtr& ) override;
+      str get_method() const override;
       void response( const jtree& ) override;
 
       bool get_is_http() const override;
@@ -355,30 +609,105 @@ namespace pc
       bool        is_exec_;
     };
 
+    // get account data of several accounts in one request. the callback
+    // is invoked once per account in the order added with the account,
+    // lamports and data of that account. accounts that do not exist have
+    // no data
+    class get_multiple_accounts : public account_update
+    {
+    public:
+      static const unsigned max_accounts = 100;
+
+      // parameters
+      void clear_accounts();
+      void add_account( const pub_key& );
+      unsigned get_num_accounts() const;
+      const pub_key& get_account_key( unsigned ) const;
+
+      // fail unless the node has reached this slot (zero for any)
+      void set_min_slot( uint64_t );
+      uint64_t get_min_slot() const;
+
+      get_multiple_accounts();
+      void request( json_wtr& ) override;
+      str get_method() const override;
+      void response( const jtree& ) override;
+
+      bool get_is_http() const override;
+
+    private:
+      std::vector<pub_key> avec_;
+      uint64_t             min_slot_;
+    };
+
     // account data subscription
     class account_subscribe : public account_update
     {
     public:
       account_subscribe();
       void request( json_wtr& ) override;
+      str get_method() const override;
       void response( const jtree& ) override;
       bool notify( const jtree& ) override;
     };
 
     // program subscription
+    // server-side selection of program accounts by account type and/or
+    // product of price accounts, optionally returning only the leading
+    // bytes of each account (dataSlice). selects all of every account by
+    // default
+    class program_filter
+    {
+    public:
+      program_filter();
+
+      // account type (PC_ACCTYPE_*) or zero for any
+      void set_account_type( uint32_t );
+      uint32_t get_account_type() const;
+
+      // price accounts of product only
+      void set_product( const pub_key& );
+      const pub_key *get_product() const;
+
+      // leading bytes of account data only or zero for all
+      void set_data_len( uint32_t );
+      uint32_t get_data_len() const;
+
+      // accounts of this data size only or zero for any
+      void set_data_size( uint32_t );
+      uint32_t get_data_size() const;
+
+      // from text: comma-separated mapping, product, price,
+      // product=<product key> or size=<data size>
+      bool init_from_text( str );
+
+      // add filters and dataSlice to request configuration
+      void request( json_wtr& ) const;
+
+    private:
+      pub_key  prod_;
+      uint32_t type_;
+      uint32_t dlen_;
+      uint32_t dsize_;
+      bool     has_prod_;
+    };
+
     class program_subscribe : public account_update
     {
     public:
       // parameters
       void set_program( pub_key * );
+      void set_filter( const program_filter& );
 
       program_subscribe();
       void request( json_wtr& ) override;
+      str get_method() const override;
       void response( const jtree& ) override;
       bool notify( const jtree& ) override;
 
     private:
       pub_key    *pgm_;
+      program_filter filt_;
     };
 
     class get_program_accounts : public account_update
@@ -387,16 +716,22 @@ namespace pc
       // parameters
       void set_program( pub_key * );
       void set_account_type( uint32_t );
+      void set_filter( const program_filter& );
 
       get_program_accounts();
       void request( json_wtr& ) override;
+      str get_method() const override;
       void response( const jtree& ) override;
+      void response_part( const jtree& ) override;
 
       bool get_is_http() const override;
+      bool get_is_stream() const override;
 
     private:
+      void parse_account( const jtree&, uint32_t tok );
+
       pub_key    *pgm_;
-      uint32_t    acct_type_;
+      program_filter filt_;
     };
 
     // set new component price
@@ -416,13 +751,21 @@ namespace pc
 
       uint64_t get_slot();
 
+      // price of the last set_price
+      int64_t       get_price() const;
+      uint64_t      get_conf() const;
+      symbol_status get_symbol_status() const;
+      bool          get_is_aggregate() const;
+
       // results
       signature *get_signature();
       str        get_ack_signature() const;
+      key_cache *get_pubcache() const;
 
       upd_price();
       void build( net_wtr& ) override;
       void request( json_wtr& ) override;
+      str get_method() const override;
       void response( const jtree& ) override;
 
       static bool build( net_wtr&, upd_price*[], unsigned n );
@@ -431,6 +774,16 @@ namespace pc
       static bool build( net_wtr&, upd_price*[], unsigned n, unsigned cu_units, unsigned cu_price  );
       static bool request( json_wtr&, upd_price*[], const unsigned n, unsigned cu_units, unsigned cu_price );
 
+      // serialize transaction without signing it. sig_idx and msg_idx
+      // are the positions of the signature and of the signed message
+      static bool build_msg( bincode&, upd_price*[], unsigned n, unsigned cu_units, unsigned cu_price,
+                             size_t& sig_idx, size_t& msg_idx );
+
+      // serialized size of a transaction of n updates and the most
+      // updates that fit within the transaction size limit
+      static size_t get_tx_size( unsigned n, unsigned cu_units, unsigned cu_price );
+      static unsigned get_max_num( unsigned cu_units, unsigned cu_price );
+
     private:
       static bool build_tx( bincode&, upd_price*[], unsigned n, unsigned cu_units, unsigned cu_price );
 
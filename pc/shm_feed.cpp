@@ -0,0 +1,100 @@
+#include "shm_feed.hpp"
+#include <algorithm>
+#include <errno.h>
+
+using namespace pc;
+
+shm_feed::shm_feed()
+: max_num_( 8192U ),
+  slot_len_( ( sizeof( shm_slot ) + 63UL ) & ~63UL ),
+  len_( 0UL ),
+  buf_( nullptr )
+{
+}
+
+shm_feed::~shm_feed()
+{
+  if ( buf_ ) {
+    ::munmap( buf_, len_ );
+    buf_ = nullptr;
+  }
+}
+
+void shm_feed::set_file( const std::string& file )
+{
+  file_ = file;
+}
+
+std::string shm_feed::get_file() const
+{
+  return file_;
+}
+
+void shm_feed::set_max_num( unsigned max_num )
+{
+  max_num_ = max_num;
+}
+
+unsigned shm_feed::get_max_num() const
+{
+  return max_num_;
+}
+
+bool shm_feed::init()
+{
+  // start from an empty feed so that readers of a previous run do not
+  // see stale slots under indices assigned differently this time
+  ::unlink( file_.c_str() );
+  int fd = ::open( file_.c_str(), O_CREAT | O_RDWR, 0644 );
+  if ( fd < 0 ) {
+    return set_err_msg( "failed to create shm feed file=" + file_, errno );
+  }
+  len_ = sizeof( shm_hdr ) + max_num_ * slot_len_;
+  if ( 0 != ::ftruncate( fd, static_cast< off_t >( len_ ) ) ) {
+    ::close( fd );
+    return set_err_msg( "failed to size shm feed file=" + file_, errno );
+  }
+  void *ptr = ::mmap( nullptr, len_, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      fd, 0 );
+  ::close( fd );
+  if ( ptr == MAP_FAILED ) {
+    return set_err_msg( "failed to map shm feed file=" + file_, errno );
+  }
+  buf_ = (char*)ptr;
+  shm_hdr *hdr = (shm_hdr*)buf_;
+  hdr->ver_      = shm_version;
+  hdr->slot_len_ = static_cast< uint32_t >( slot_len_ );
+  hdr->max_num_  = max_num_;
+  hdr->num_.store( 0U, std::memory_order_relaxed );
+  std::atomic_thread_fence( std::memory_order_release );
+  hdr->magic_    = shm_magic;
+  return true;
+}
+
+shm_slot *shm_feed::get_slot( unsigned idx )
+{
+  return (shm_slot*)&buf_[sizeof( shm_hdr ) + idx * slot_len_];
+}
+
+void shm_feed::update( unsigned idx, const pub_key& acc,
+                       const pc_price_t *pptr )
+{
+  if ( PC_UNLIKELY( idx >= max_num_ || !buf_ ) ) {
+    return;
+  }
+  size_t len = offsetof( pc_price_t, comp_ ) +
+    std::min( pptr->num_, (uint32_t)PC_NUM_COMP ) * sizeof( pc_price_comp_t );
+  shm_slot *sptr = get_slot( idx );
+  uint64_t seq = sptr->seq_.load( std::memory_order_relaxed );
+  sptr->seq_.store( seq + 1UL, std::memory_order_relaxed );
+  std::atomic_thread_fence( std::memory_order_release );
+  __builtin_memcpy( &sptr->acc_, acc.data(), sizeof( pc_pub_key_t ) );
+  __builtin_memcpy( &sptr->px_, pptr, len );
+  sptr->seq_.store( seq + 2UL, std::memory_order_release );
+
+  // publish slot to readers once first written
+  shm_hdr *hdr = (shm_hdr*)buf_;
+  if ( idx >= hdr->num_.load( std::memory_order_relaxed ) ) {
+    hdr->num_.store( idx + 1U, std::memory_order_release );
+  }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <pc/error.hpp>
+#include <pc/key_pair.hpp>
+#include <pc/shm_reader.hpp>
+
+namespace pc
+{
+
+  // writer of the shared-memory price feed read with shm_reader. slots
+  // are indexed by the caller (the manager uses the price arena index)
+  class shm_feed : public error
+  {
+  public:
+
+    shm_feed();
+    ~shm_feed();
+
+    // feed file, typically under /dev/shm
+    void set_file( const std::string& );
+    std::string get_file() const;
+
+    // maximum number of price accounts (default 8192)
+    void set_max_num( unsigned );
+    unsigned get_max_num() const;
+
+    // create and map feed file
+    bool init();
+
+    // copy latest price account into slot. ignored past max_num
+    void update( unsigned idx, const pub_key&, const pc_price_t * );
+
+  private:
+
+    shm_feed( const shm_feed& );
+    shm_feed& operator=( const shm_feed& );
+
+    shm_slot *get_slot( unsigned idx );
+
+    std::string file_;
+    unsigned    max_num_;
+    size_t      slot_len_;
+    size_t      len_;
+    char       *buf_;
+  };
+
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <oracle/oracle.h>
+#include <atomic>
+#include <cstddef>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// shared-memory price feed written by pythd (see pc::shm_feed). the file
+// is a shm_hdr followed by max_num_ slots of slot_len_ bytes, one per
+// price account. each slot is guarded by a sequence lock: the writer
+// makes seq_ odd while copying the latest price account into it.
+// this header depends only on oracle.h so that any local process can
+// map the file and read prices without syscalls or the pc library
+
+namespace pc
+{
+
+  static const uint64_t shm_magic   = 0x6465656663797000UL; // "\0pycfeed"
+  static const uint32_t shm_version = 1U;
+
+  struct shm_hdr
+  {
+    uint64_t              magic_;     // shm_magic
+    uint32_t              ver_;       // shm_version
+    uint32_t              slot_len_;  // bytes per slot
+    uint32_t              max_num_;   // number of slots in file
+    std::atomic<uint32_t> num_;       // number of slots written
+    char                  pad_[40];
+  };
+
+  struct shm_slot
+  {
+    std::atomic<uint64_t> seq_;       // even and non-zero once written
+    pc_pub_key_t          acc_;       // price account
+    pc_price_t            px_;        // populated region of account
+  };
+
+  static_assert( sizeof( shm_hdr ) == 64, "unexpected shm_hdr size" );
+
+  // read-only mapping of a shared-memory price feed
+  class shm_reader
+  {
+  public:
+
+    shm_reader();
+    ~shm_reader();
+
+    // map feed file. false if missing or not a feed
+    bool init( const char *file );
+
+    // number of slots written so far
+    unsigned get_num() const;
+
+    // consistent copy of slot. false if slot not yet written
+    bool get( unsigned idx, pc_pub_key_t& acc, pc_price_t& px ) const;
+
+    // update sequence of slot (changes on every write)
+    uint64_t get_seq( unsigned idx ) const;
+
+    // slot index of price account or -1 if not found
+    int find( const pc_pub_key_t& acc ) const;
+
+  private:
+
+    shm_reader( const shm_reader& );
+    shm_reader& operator=( const shm_reader& );
+
+    const shm_slot *get_slot( unsigned idx ) const;
+
+    const char *buf_;
+    size_t      len_;
+  };
+
+  inline shm_reader::shm_reader()
+  : buf_( nullptr ),
+    len_( 0UL )
+  {
+  }
+
+  inline shm_reader::~shm_reader()
+  {
+    if ( buf_ ) {
+      ::munmap( (void*)buf_, len_ );
+    }
+  }
+
+  inline bool shm_reader::init( const char *file )
+  {
+    int fd = ::open( file, O_RDONLY );
+    if ( fd < 0 ) {
+      return false;
+    }
+    struct stat fst[1];
+    if ( 0 != ::fstat( fd, fst ) || (size_t)fst->st_size < sizeof( shm_hdr ) ) {
+      ::close( fd );
+      return false;
+    }
+    len_ = (size_t)fst->st_size;
+    void *ptr = ::mmap( nullptr, len_, PROT_READ, MAP_SHARED, fd, 0 );
+    ::close( fd );
+    if ( ptr == MAP_FAILED ) {
+      return false;
+    }
+    buf_ = (const char*)ptr;
+    const shm_hdr *hdr = (const shm_hdr*)buf_;
+    if ( hdr->magic_ != shm_magic || hdr->ver_ != shm_version ||
+         hdr->slot_len_ < sizeof( shm_slot ) ||
+         len_ < sizeof( shm_hdr ) + (size_t)hdr->max_num_*hdr->slot_len_ ) {
+      ::munmap( ptr, len_ );
+      buf_ = nullptr;
+      return false;
+    }
+    return true;
+  }
+
+  inline unsigned shm_reader::get_num() const
+  {
+    const shm_hdr *hdr = (const shm_hdr*)buf_;
+    return hdr->num_.load( std::memory_order_acquire );
+  }
+
+  inline const shm_slot *shm_reader::get_slot( unsigned idx ) const
+  {
+    const shm_hdr *hdr = (const shm_hdr*)buf_;
+    return (const shm_slot*)&buf_[sizeof( shm_hdr ) +
+                                  (size_t)idx * hdr->slot_len_];
+  }
+
+  inline uint64_t shm_reader::get_seq( unsigned idx ) const
+  {
+    return get_slot( idx )->seq_.load( std::memory_order_acquire );
+  }
+
+  inline bool shm_reader::get( unsigned idx, pc_pub_key_t& acc,
+                               pc_price_t& px ) const
+  {
+    static const size_t hdr_len = offsetof( pc_price_t, comp_ );
+    const shm_slot *sptr = get_slot( idx );
+    for(;;) {
+      uint64_t seq = sptr->seq_.load( std::memory_order_acquire );
+      if ( seq == 0UL ) {
+        return false;
+      }
+      if ( seq & 1UL ) {
+        continue;
+      }
+      // copy fixed part then populated components
+      __builtin_memcpy( &acc, &sptr->acc_, sizeof( pc_pub_key_t ) );
+      __builtin_memcpy( &px, &sptr->px_, hdr_len );
+      uint32_t num = px.num_ < PC_NUM_COMP ? px.num_ : PC_NUM_COMP;
+      __builtin_memcpy( px.comp_, sptr->px_.comp_,
+                        num * sizeof( pc_price_comp_t ) );
+      std::atomic_thread_fence( std::memory_order_acquire );
+      if ( sptr->seq_.load( std::memory_order_relaxed ) == seq ) {
+        return true;
+      }
+    }
+  }
+
+  inline int shm_reader::find( const pc_pub_key_t& acc ) const
+  {
+    for( unsigned i = 0, num = get_num(); i != num; ++i ) {
+      const shm_slot *sptr = get_slot( i );
+      if ( pc_pub_key_equal( (pc_pub_key_t*)&sptr->acc_,
+                             (pc_pub_key_t*)&acc ) ) {
+        return (int)i;
+      }
+    }
+    return -1;
+  }
+
+}
@@ -0,0 +1,168 @@
+#include "snapshot.hpp"
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+using namespace pc;
+
+static size_t align8( size_t len )
+{
+  return ( len + 7UL ) & ~7UL;
+}
+
+snapshot::snapshot()
+{
+}
+
+void snapshot::set_file( const std::string& file )
+{
+  mmap_.set_file( file );
+}
+
+std::string snapshot::get_file() const
+{
+  return mmap_.get_file();
+}
+
+bool snapshot::init()
+{
+  // no snapshot yet
+  struct stat fst[1];
+  if ( 0 != ::stat( get_file().c_str(), fst ) ) {
+    return true;
+  }
+  if ( !mmap_.init() ) {
+    return set_err_msg( "failed to map snapshot file=" + get_file() );
+  }
+  const char *buf = mmap_.data();
+  size_t len = mmap_.size();
+  const snap_hdr *hdr = (const snap_hdr*)buf;
+  if ( len < sizeof( snap_hdr ) || hdr->magic_ != magic ) {
+    return set_err_msg( "invalid snapshot file=" + get_file() );
+  }
+  if ( hdr->ver_ != version ) {
+    return set_err_msg( "invalid snapshot version=" +
+        std::to_string( hdr->ver_ ) );
+  }
+
+  // index accounts by key
+  size_t pos = sizeof( snap_hdr );
+  for( uint32_t i = 0; i != hdr->num_; ++i ) {
+    const snap_rec *rec = (const snap_rec*)&buf[pos];
+    if ( len < pos + sizeof( snap_rec ) ||
+         len - pos - sizeof( snap_rec ) < rec->size_ ||
+         rec->size_ < sizeof( pc_acc_t ) ) {
+      return set_err_msg( "corrupt snapshot file=" + get_file() );
+    }
+    account& acc = get( *(const pub_key*)&rec->acc_ );
+    acc.ptr_ = &buf[pos + sizeof( snap_rec )];
+    acc.len_ = rec->size_;
+    pos += sizeof( snap_rec ) + align8( rec->size_ );
+  }
+  return true;
+}
+
+unsigned snapshot::get_num() const
+{
+  return avec_.size();
+}
+
+snapshot::account& snapshot::get( const pub_key& key )
+{
+  acc_map_t::iter_t it = amap_.find( key );
+  if ( it ) {
+    return avec_[amap_.obj( it )];
+  }
+  amap_.ref( amap_.add( key ) ) = avec_.size();
+  avec_.resize( avec_.size() + 1 );
+  account& acc = avec_.back();
+  acc.acc_ = key;
+  acc.ptr_ = nullptr;
+  acc.len_ = 0;
+  return acc;
+}
+
+const pc_acc_t *snapshot::get_account( const pub_key& key, size_t& len )
+{
+  acc_map_t::iter_t it = amap_.find( key );
+  if ( !it ) {
+    return nullptr;
+  }
+  account& acc = avec_[amap_.obj( it )];
+  len = acc.len_;
+  return (const pc_acc_t*)( acc.buf_.empty() ? acc.ptr_ : acc.buf_.data() );
+}
+
+const pc_acc_t *snapshot::get_account( unsigned i, pub_key& key,
+                                       size_t& len )
+{
+  if ( i >= avec_.size() ) {
+    return nullptr;
+  }
+  account& acc = avec_[i];
+  key = acc.acc_;
+  len = acc.len_;
+  return (const pc_acc_t*)( acc.buf_.empty() ? acc.ptr_ : acc.buf_.data() );
+}
+
+void snapshot::add( const pc_pub_key_t *key, const pc_acc_t *ptr )
+{
+  // the mapping table is read whole rather than its populated region
+  size_t len = ptr->size_;
+  if ( ptr->type_ == PC_ACCTYPE_MAPPING ) {
+    len = std::max( len, sizeof( pc_map_table_t ) );
+  }
+  account& acc = get( *(const pub_key*)key );
+  if ( (const char*)ptr == acc.buf_.data() ) {
+    return;
+  }
+  acc.buf_.assign( (const char*)ptr, (const char*)ptr + len );
+  acc.len_ = len;
+}
+
+bool snapshot::save()
+{
+  // write next to the snapshot and rename so that the mapped file and
+  // readers never see a partial snapshot
+  std::string file = get_file() + ".tmp";
+  int fd = ::open( file.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644 );
+  if ( fd < 0 ) {
+    return set_err_msg(
+        "failed to create snapshot file=" + file, errno );
+  }
+  std::vector<char> buf( sizeof( snap_hdr ) );
+  snap_hdr *hdr = (snap_hdr*)buf.data();
+  hdr->magic_ = magic;
+  hdr->ver_ = version;
+  hdr->num_ = avec_.size();
+  for( const account& acc: avec_ ) {
+    const char *ptr = acc.buf_.empty() ? acc.ptr_ : acc.buf_.data();
+    size_t pos = buf.size();
+    buf.resize( pos + sizeof( snap_rec ) + align8( acc.len_ ), '\0' );
+    snap_rec *rec = (snap_rec*)&buf[pos];
+    pc_pub_key_assign( &rec->acc_, (pc_pub_key_t*)acc.acc_.data() );
+    rec->size_ = acc.len_;
+    __builtin_memcpy( &buf[pos + sizeof( snap_rec )], ptr, acc.len_ );
+  }
+  const char *ptr = buf.data();
+  size_t len = buf.size();
+  while( len ) {
+    ssize_t num = ::write( fd, ptr, len );
+    if ( num <= 0 ) {
+      ::close( fd );
+      return set_err_msg(
+          "failed to write snapshot file=" + file, errno );
+    }
+    ptr += num;
+    len -= static_cast< size_t >( num );
+  }
+  ::close( fd );
+  if ( 0 != ::rename( file.c_str(), get_file().c_str() ) ) {
+    return set_err_msg(
+        "failed to rename snapshot file=" + file, errno );
+  }
+  return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <pc/error.hpp>
+#include <pc/hash_map.hpp>
+#include <pc/key_pair.hpp>
+#include <pc/mem_map.hpp>
+#include <oracle/oracle.h>
+#include <vector>
+
+namespace pc
+{
+
+  // on-disk snapshot of mapping, product and price accounts used to
+  // bootstrap without waiting on the rpc node for every account in turn.
+  // the file is memory-mapped on load and rewritten from the latest
+  // account content on save
+  class snapshot : public error
+  {
+  public:
+
+    snapshot();
+
+    void set_file( const std::string& );
+    std::string get_file() const;
+
+    // map snapshot file if it exists
+    bool init();
+
+    // number of accounts in snapshot
+    unsigned get_num() const;
+
+    // latest account content or null if not in snapshot. data is 8-byte
+    // aligned and remains valid until the account is next added
+    const pc_acc_t *get_account( const pub_key&, size_t& len );
+
+    // latest content and key of account i of get_num()
+    const pc_acc_t *get_account( unsigned i, pub_key&, size_t& len );
+
+    // record latest account content
+    void add( const pc_pub_key_t *, const pc_acc_t * );
+
+    // write all accounts to file
+    bool save();
+
+  private:
+
+    static const uint64_t magic = 0x70616e73637970UL; // "pycsnap"
+    static const uint32_t version = 1U;
+
+    struct snap_hdr {
+      uint64_t magic_;
+      uint32_t ver_;
+      uint32_t num_;
+    };
+
+    struct snap_rec {
+      pc_pub_key_t acc_;
+      uint64_t     size_;
+    };
+
+    struct account {
+      pub_key           acc_;
+      const char       *ptr_;  // mapped content
+      size_t            len_;
+      std::vector<char> buf_;  // content added since mapped
+    };
+
+    struct trait_account {
+      static const size_t hsize_ = 8363UL;
+      typedef uint32_t        idx_t;
+      typedef pub_key         key_t;
+      typedef const pub_key&  keyref_t;
+      typedef uint32_t        val_t;
+      struct hash_t {
+        idx_t operator() ( keyref_t a ) {
+          uint64_t *i = (uint64_t*)a.data();
+          return *i;
+        }
+      };
+    };
+
+    typedef open_hash_map<trait_account> acc_map_t;
+    typedef std::vector<account>    acc_vec_t;
+
+    account& get( const pub_key& );
+
+    mem_map     mmap_;
+    acc_map_t   amap_;
+    acc_vec_t   avec_;
+  };
+
+}
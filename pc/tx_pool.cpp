@@ -0,0 +1,206 @@
+#include "tx_pool.hpp"
+#include "bincode.hpp"
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace pc;
+
+static void run_tx_pool( tx_pool *pool, unsigned idx )
+{
+  pool->run( idx );
+}
+
+tx_pool::tx_pool()
+: conn_( nullptr ),
+  num_( 1 ),
+  cpu_( -1 ),
+  in_( 0UL ),
+  out_( 0UL ),
+  num_inline_( 0UL ),
+  is_run_( false )
+{
+}
+
+tx_pool::~tx_pool()
+{
+  teardown();
+}
+
+void tx_pool::set_num_threads( unsigned num )
+{
+  num_ = num;
+}
+
+unsigned tx_pool::get_num_threads() const
+{
+  return num_;
+}
+
+void tx_pool::set_cpu( int cpu )
+{
+  cpu_ = cpu;
+}
+
+int tx_pool::get_cpu() const
+{
+  return cpu_;
+}
+
+void tx_pool::set_tx_conn( net_connect *conn )
+{
+  conn_ = conn;
+}
+
+net_connect *tx_pool::get_tx_conn() const
+{
+  return conn_;
+}
+
+uint64_t tx_pool::get_num_inline() const
+{
+  return num_inline_;
+}
+
+bool tx_pool::init()
+{
+  if ( !num_ ) {
+    return set_err_msg( "tx_pool requires at least one thread" );
+  }
+  int fd = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+  if ( fd < 0 ) {
+    return set_err_msg( "failed to create eventfd", errno );
+  }
+  set_fd( fd );
+  is_run_ = true;
+  for( unsigned i=0; i != num_; ++i ) {
+    worker *wp = new worker;
+    wp->in_   = 0UL;
+    wp->done_ = 0UL;
+    wp->out_  = 0UL;
+    wp->src_  = nullptr;
+    sem_init( &wp->sem_, 0, 0 );
+    wvec_.push_back( wp );
+  }
+  for( unsigned i=0; i != num_; ++i ) {
+    wvec_[i]->thrd_ = std::thread( run_tx_pool, this, i );
+    int cpu = cpu_ + static_cast< int >( i );
+    if ( cpu_ >= 0 && !set_thread_cpu( wvec_[i]->thrd_.native_handle(), cpu ) ) {
+      set_err_msg( "failed to pin signing thread to cpu=" +
+          std::to_string( cpu ), errno );
+    }
+  }
+  if ( get_is_err() ) {
+    return false;
+  }
+  return net_socket::init();
+}
+
+bool tx_pool::submit( rpc::upd_price *upds[], unsigned n,
+                      unsigned cu_units, unsigned cu_price )
+{
+  if ( PC_UNLIKELY( !n ) ) {
+    return false;
+  }
+  worker *wp = wvec_[in_ % wvec_.size()];
+  uint64_t seq = wp->in_.load( std::memory_order_relaxed );
+  if ( PC_UNLIKELY( seq - wp->out_ == max_queue ) ) {
+    // sign here rather than wait for the worker
+    net_wtr msg;
+    if ( !rpc::upd_price::build( msg, upds, n, cu_units, cu_price ) ) {
+      return false;
+    }
+    conn_->add_send( msg );
+    ++num_inline_;
+    return true;
+  }
+
+  // serialize tx proxy header and unsigned transaction
+  job& jb = wp->jobs_[seq % max_queue];
+  bincode tx( jb.buf_ );
+  tx.add( (uint16_t)PC_TPU_PROTO_ID );
+  tx.add( (uint16_t)0 );
+  if ( !rpc::upd_price::build_msg(
+        tx, upds, n, cu_units, cu_price, jb.sig_, jb.msg_ ) ) {
+    return false;
+  }
+  jb.len_  = tx.size();
+  jb.ckey_ = upds[0]->get_pubcache();
+  ((tx_hdr*)jb.buf_)->size_ = (uint16_t)jb.len_;
+  wp->in_.store( seq + 1, std::memory_order_release );
+  sem_post( &wp->sem_ );
+  ++in_;
+  return true;
+}
+
+void tx_pool::run( unsigned idx )
+{
+  worker *wp = wvec_[idx];
+  uint64_t seq = 0UL, one = 1UL;
+  for(;;) {
+    sem_wait( &wp->sem_ );
+    if ( !is_run_ ) {
+      break;
+    }
+    uint64_t in = wp->in_.load( std::memory_order_acquire );
+    if ( seq == in ) {
+      continue;
+    }
+    for( ; seq != in; ++seq ) {
+      job& jb = wp->jobs_[seq % max_queue];
+      if ( jb.ckey_ != wp->src_ ) {
+        wp->ckey_.set( *jb.ckey_ );
+        wp->src_ = jb.ckey_;
+      }
+      signature *sig = (signature*)&jb.buf_[jb.sig_];
+      sig->sign( (const uint8_t*)&jb.buf_[jb.msg_],
+                 (uint32_t)( jb.len_ - jb.msg_ ), wp->ckey_ );
+      wp->done_.store( seq + 1, std::memory_order_release );
+    }
+    // wake loop thread
+    ssize_t rc = ::write( get_fd(), &one, sizeof( one ) );
+    (void)rc;
+  }
+}
+
+void tx_pool::poll()
+{
+  uint64_t val;
+  while( sizeof( val ) == ::read( get_fd(), &val, sizeof( val ) ) );
+
+  // send in submission order across workers
+  while( out_ != in_ ) {
+    worker *wp = wvec_[out_ % wvec_.size()];
+    if ( wp->out_ == wp->done_.load( std::memory_order_acquire ) ) {
+      break;
+    }
+    job& jb = wp->jobs_[wp->out_ % max_queue];
+    send( jb.buf_, jb.len_ );
+    ++wp->out_;
+    ++out_;
+  }
+}
+
+void tx_pool::send( const char *buf, size_t len )
+{
+  net_wtr msg;
+  msg.add( str( buf, len ) );
+  conn_->add_send( msg );
+}
+
+void tx_pool::teardown()
+{
+  if ( is_run_ ) {
+    is_run_ = false;
+    for( worker *wp: wvec_ ) {
+      sem_post( &wp->sem_ );
+    }
+    for( worker *wp: wvec_ ) {
+      wp->thrd_.join();
+      sem_destroy( &wp->sem_ );
+      delete wp;
+    }
+    wvec_.clear();
+    in_ = out_ = 0UL;
+  }
+  close();
+}
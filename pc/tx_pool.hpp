@@ -0,0 +1,99 @@
+#pragma once
+
+#include <pc/net_socket.hpp>
+#include <pc/rpc_client.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <semaphore.h>
+
+namespace pc
+{
+
+  // signs upd_price transactions on worker threads. batches are
+  // serialized on the loop thread, signed by a worker and handed back
+  // through a per-worker ring. an eventfd in the net_loop wakes the loop
+  // to send them to the tx proxy in submission order
+  class tx_pool : public net_socket
+  {
+  public:
+
+    // batches queued per worker before signing falls back to the caller
+    static const unsigned max_queue = 64;
+
+    tx_pool();
+    ~tx_pool();
+
+    // number of worker threads
+    void set_num_threads( unsigned );
+    unsigned get_num_threads() const;
+
+    // pin worker threads to consecutive cpus starting at cpu (default -1
+    // - no pinning)
+    void set_cpu( int );
+    int get_cpu() const;
+
+    // tx proxy connection signed transactions are sent to
+    void set_tx_conn( net_connect * );
+    net_connect *get_tx_conn() const;
+
+    // start worker threads and add completion event to net_loop
+    bool init() override;
+
+    // queue batch of price updates for signing
+    bool submit( rpc::upd_price *[], unsigned n,
+                 unsigned cu_units, unsigned cu_price );
+
+    // send signed transactions
+    void poll() override;
+
+    // stop worker threads
+    void teardown() override;
+
+    // batches signed by the caller because the worker queue was full
+    uint64_t get_num_inline() const;
+
+  public:
+    void run( unsigned );
+
+  private:
+
+    struct job
+    {
+      const key_cache *ckey_;
+      size_t           sig_;  // signature position
+      size_t           msg_;  // signed message position
+      size_t           len_;  // tx proxy message length
+      char             buf_[net_buf::len];
+    };
+
+    typedef std::atomic<uint64_t> seq_t;
+
+    struct worker
+    {
+      job              jobs_[max_queue];
+      seq_t            in_;   // jobs queued by loop
+      seq_t            done_; // jobs signed by worker
+      uint64_t         out_;  // jobs sent by loop
+      sem_t            sem_;
+      std::thread      thrd_;
+      key_cache        ckey_; // worker copy of signing key
+      const key_cache *src_;  // source of ckey_
+    };
+
+    typedef std::vector<worker*> worker_vec_t;
+    typedef std::atomic<bool>    atomic_t;
+
+    void send( const char *buf, size_t len );
+
+    worker_vec_t  wvec_;
+    net_connect  *conn_;
+    unsigned      num_;
+    int           cpu_;
+    uint64_t      in_;    // next job sequence number
+    uint64_t      out_;   // next job sequence number to send
+    uint64_t      num_inline_;
+    atomic_t      is_run_;
+  };
+
+}
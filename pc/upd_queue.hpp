@@ -0,0 +1,177 @@
+#pragma once
+
+#include <pc/key_pair.hpp>
+#include <pc/rpc_client.hpp>
+#include <pc/hash_map.hpp>
+#include <atomic>
+
+namespace pc
+{
+
+  // lock-free single producer, single consumer queue of publisher price
+  // updates. used to hand updates received on the primary manager's
+  // thread to the thread of a secondary network and updates from
+  // publisher threads to the manager (see manager::add_producer).
+  // updates are conflated per price: pushing to a price with an update
+  // still queued replaces its value so that a slow consumer pops the
+  // latest value of every price instead of the producer losing updates
+  class upd_queue
+  {
+  public:
+
+    // prices a queue can hold
+    static const uint64_t max_upd = 4096;
+
+    struct upd
+    {
+      pub_key       acc_;
+      int64_t       price_;
+      uint64_t      conf_;
+      symbol_status st_;
+    };
+
+    upd_queue();
+
+    // add or replace the queued update of a price (producer). false if
+    // max_upd other prices were pushed before
+    bool push( const pub_key& acc, int64_t price, uint64_t conf,
+               symbol_status st );
+
+    // remove the latest update of the price queued longest (consumer).
+    // false if the queue is empty
+    bool pop( upd& );
+
+    // number of updates dropped because the queue was full
+    uint64_t get_num_drop() const;
+
+    // number of prices queued (approximate unless called by consumer)
+    uint64_t size() const;
+
+  private:
+
+    typedef std::atomic<uint64_t> seq_t;
+
+    struct trait_price {
+      static const size_t hsize_ = 8363UL;
+      typedef uint32_t        idx_t;
+      typedef pub_key         key_t;
+      typedef const pub_key&  keyref_t;
+      typedef uint32_t        val_t;
+      struct hash_t {
+        idx_t operator() ( keyref_t a ) {
+          uint64_t *i = (uint64_t*)a.data();
+          return *i;
+        }
+      };
+    };
+
+    // latest update of a price. written under a sequence lock
+    struct entry {
+      pub_key               acc_;     // set before first queued
+      seq_t                 seq_;     // odd while written
+      std::atomic<int64_t>  price_;
+      std::atomic<uint64_t> conf_;
+      std::atomic<int>      st_;
+      std::atomic<bool>     is_pend_; // queued and not yet popped
+    };
+
+    typedef open_hash_map<trait_price> idx_map_t;
+
+    // producer state, producer and consumer positions on separate cache
+    // lines. each price is queued at most once so the ring cannot fill
+    idx_map_t emap_;  // entry by price
+    uint32_t  nent_;
+    uint64_t  ndrop_;
+    seq_t     in_;    // next slot written by producer
+    char      pad_[64 - sizeof( seq_t )];
+    seq_t     out_;   // next slot read by consumer
+    char      pad2_[64 - sizeof( seq_t )];
+    uint32_t  ring_[max_upd];
+    entry     evec_[max_upd];
+  };
+
+  inline upd_queue::upd_queue()
+  : nent_( 0U ),
+    ndrop_( 0UL ),
+    in_( 0UL ),
+    out_( 0UL )
+  {
+    for( entry& e: evec_ ) {
+      e.seq_.store( 0UL, std::memory_order_relaxed );
+      e.is_pend_.store( false, std::memory_order_relaxed );
+    }
+  }
+
+  inline bool upd_queue::push( const pub_key& acc, int64_t price,
+                               uint64_t conf, symbol_status st )
+  {
+    idx_map_t::iter_t it = emap_.find( acc );
+    uint32_t idx;
+    if ( PC_LIKELY( it != nullptr ) ) {
+      idx = emap_.obj( it );
+    } else if ( nent_ == max_upd ) {
+      ++ndrop_;
+      return false;
+    } else {
+      idx = nent_++;
+      emap_.ref( emap_.add( acc ) ) = idx;
+      evec_[idx].acc_ = acc;
+    }
+    entry& e = evec_[idx];
+    uint64_t seq = e.seq_.load( std::memory_order_relaxed );
+    e.seq_.store( seq + 1, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    e.price_.store( price, std::memory_order_relaxed );
+    e.conf_.store( conf, std::memory_order_relaxed );
+    e.st_.store( (int)st, std::memory_order_relaxed );
+    e.seq_.store( seq + 2, std::memory_order_release );
+
+    // queue the price unless the consumer is yet to pop it
+    if ( !e.is_pend_.exchange( true, std::memory_order_acq_rel ) ) {
+      uint64_t in = in_.load( std::memory_order_relaxed );
+      ring_[in % max_upd] = idx;
+      in_.store( in + 1, std::memory_order_release );
+    }
+    return true;
+  }
+
+  inline bool upd_queue::pop( upd& u )
+  {
+    uint64_t out = out_.load( std::memory_order_relaxed );
+    if ( out == in_.load( std::memory_order_acquire ) ) {
+      return false;
+    }
+    entry& e = evec_[ring_[out % max_upd]];
+    out_.store( out + 1, std::memory_order_release );
+
+    // pushes from here on queue the price again
+    e.is_pend_.exchange( false, std::memory_order_acq_rel );
+    for( ;; ) {
+      uint64_t seq = e.seq_.load( std::memory_order_acquire );
+      if ( PC_UNLIKELY( seq & 1UL ) ) {
+        continue;
+      }
+      u.price_ = e.price_.load( std::memory_order_relaxed );
+      u.conf_  = e.conf_.load( std::memory_order_relaxed );
+      u.st_    = (symbol_status)e.st_.load( std::memory_order_relaxed );
+      std::atomic_thread_fence( std::memory_order_acquire );
+      if ( PC_LIKELY( e.seq_.load( std::memory_order_relaxed ) == seq ) ) {
+        break;
+      }
+    }
+    u.acc_ = e.acc_;
+    return true;
+  }
+
+  inline uint64_t upd_queue::get_num_drop() const
+  {
+    return ndrop_;
+  }
+
+  inline uint64_t upd_queue::size() const
+  {
+    return in_.load( std::memory_order_acquire ) -
+           out_.load( std::memory_order_relaxed );
+  }
+
+}
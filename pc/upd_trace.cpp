@@ -0,0 +1,285 @@
+#include "upd_trace.hpp"
+#include "log.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <errno.h>
+
+#define PC_TRACE_MAX_SPAN 1024
+#define PC_TRACE_TIMEOUT  (30L*PC_NSECS_IN_SEC)
+#define PC_TRACE_FLUSH    PC_NSECS_IN_SEC
+#define PC_TRACE_BUF      65536
+
+using namespace pc;
+
+upd_trace::upd_trace()
+: fd_( -1 ),
+  sample_( 100U ),
+  cnt_( 0U ),
+  nack_( 0U ),
+  nid_( 0UL ),
+  nspan_( 0UL ),
+  nevt_( 0UL ),
+  fts_( 0L ),
+  spans_( PC_TRACE_MAX_SPAN )
+{
+  for( span& s: spans_ ) {
+    s.id_ = 0UL;
+    s.has_sig_ = false;
+  }
+}
+
+upd_trace::~upd_trace()
+{
+  close();
+}
+
+void upd_trace::set_file( const std::string& file )
+{
+  file_ = file;
+}
+
+std::string upd_trace::get_file() const
+{
+  return file_;
+}
+
+void upd_trace::set_sample( unsigned num )
+{
+  sample_ = num ? num : 1U;
+}
+
+unsigned upd_trace::get_sample() const
+{
+  return sample_;
+}
+
+uint64_t upd_trace::get_num_spans() const
+{
+  return nspan_;
+}
+
+bool upd_trace::init()
+{
+  fd_ = ::open( file_.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644 );
+  if ( fd_ < 0 ) {
+    return set_err_msg( "failed to create trace file=" + file_, errno );
+  }
+  buf_ = "[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+         "\"args\":{\"name\":\"pythd\"}}";
+  nevt_ = 1UL;
+  return true;
+}
+
+uint64_t upd_trace::add_recv( str sym, int64_t rts, int64_t ts )
+{
+  if ( fd_ < 0 || ++cnt_ < sample_ ) {
+    return 0UL;
+  }
+  cnt_ = 0U;
+  uint64_t id = ++nid_;
+  span& s = spans_[id%spans_.size()];
+  if ( s.id_ ) {
+    // all lanes in use
+    return 0UL;
+  }
+  s.id_ = id;
+  s.slot_ = 0UL;
+  for( unsigned i = 0; i != e_trc_num; ++i ) {
+    s.ts_[i] = 0L;
+  }
+  s.ts_[e_trc_recv]  = rts ? rts : ts;
+  s.ts_[e_trc_parse] = ts;
+  s.has_sig_ = false;
+  s.sym_.assign( sym.str_, sym.len_ );
+  return id;
+}
+
+upd_trace::span *upd_trace::get_span( uint64_t id )
+{
+  return get_is_live( id ) ? &spans_[id%spans_.size()] : nullptr;
+}
+
+void upd_trace::add_send( uint64_t id, int64_t ts )
+{
+  span *sp = get_span( id );
+  if ( sp && !sp->ts_[e_trc_send] ) {
+    sp->ts_[e_trc_send] = ts;
+  }
+}
+
+void upd_trace::add_sent( uint64_t id, const signature *sig,
+                          uint64_t pub_slot, int64_t ts )
+{
+  span *sp = get_span( id );
+  if ( !sp || sp->ts_[e_trc_sent] ) {
+    return;
+  }
+  sp->ts_[e_trc_sent] = ts;
+  sp->slot_ = pub_slot;
+  if ( sig ) {
+    sp->sig_ = *sig;
+    sp->has_sig_ = true;
+    ++nack_;
+  }
+}
+
+void upd_trace::add_ack( const uint8_t *sig, int64_t ts )
+{
+  // updates of a batch share the transaction
+  for( span& s: spans_ ) {
+    if ( !nack_ ) {
+      break;
+    }
+    if ( s.id_ && s.has_sig_ &&
+         0 == __builtin_memcmp( s.sig_.data(), sig, signature::len ) ) {
+      s.ts_[e_trc_ack] = ts;
+      s.has_sig_ = false;
+      --nack_;
+    }
+  }
+}
+
+void upd_trace::add_agg( uint64_t id, uint64_t pub_slot, int64_t ts )
+{
+  span *sp = get_span( id );
+  if ( sp && sp->ts_[e_trc_sent] && pub_slot >= sp->slot_ ) {
+    sp->ts_[e_trc_agg] = ts;
+    write_span( *sp );
+  }
+}
+
+void upd_trace::poll( int64_t ts )
+{
+  if ( fd_ < 0 || ts - fts_ < PC_TRACE_FLUSH ) {
+    return;
+  }
+  fts_ = ts;
+  for( span& s: spans_ ) {
+    if ( s.id_ && ts - s.ts_[e_trc_recv] > PC_TRACE_TIMEOUT ) {
+      write_span( s );
+    }
+  }
+  flush();
+}
+
+bool upd_trace::close()
+{
+  if ( fd_ < 0 ) {
+    return !get_is_err();
+  }
+  for( span& s: spans_ ) {
+    if ( s.id_ ) {
+      write_span( s );
+    }
+  }
+  buf_ += "\n]\n";
+  flush();
+  if ( fd_ >= 0 && 0 != ::close( fd_ ) ) {
+    set_err_msg( "failed to close trace file=" + file_, errno );
+  }
+  fd_ = -1;
+  return !get_is_err();
+}
+
+void upd_trace::write_span( span& s )
+{
+  // the update spans its stages. the transaction reply is an instant
+  // as it may come before or after the aggregate
+  static const char *const names[] = {
+    "parse", "pending", "build", "confirm" };
+  static const trace_stage ends[] = {
+    e_trc_parse, e_trc_send, e_trc_sent, e_trc_agg };
+  const int64_t *ts = s.ts_;
+  unsigned tid = static_cast< unsigned >( s.id_ % spans_.size() );
+  int64_t end = ts[e_trc_recv];
+  for( unsigned i = e_trc_parse; i != e_trc_num; ++i ) {
+    end = ts[i] > end ? ts[i] : end;
+  }
+  add_event( "update", tid, ts[e_trc_recv], end - ts[e_trc_recv] );
+  buf_ += ",\"args\":{\"symbol\":\"";
+  for( char c: s.sym_ ) {
+    if ( c == '"' || c == '\\' ) {
+      buf_ += '\\';
+    }
+    if ( (unsigned char)c >= 0x20 ) {
+      buf_ += c;
+    }
+  }
+  buf_ += "\",\"pub_slot\":";
+  buf_ += std::to_string( s.slot_ );
+  buf_ += ",\"complete\":";
+  buf_ += ts[e_trc_agg] ? "true" : "false";
+  buf_ += "}}";
+  trace_stage beg = e_trc_recv;
+  for( unsigned i = 0; i != 4; ++i ) {
+    if ( ts[beg] && ts[ends[i]] ) {
+      add_event( names[i], tid, ts[beg], ts[ends[i]] - ts[beg] );
+      buf_ += '}';
+    }
+    beg = ends[i];
+  }
+  if ( ts[e_trc_ack] ) {
+    add_event( "ack", tid, ts[e_trc_ack], -1L );
+    buf_ += ",\"s\":\"t\"}";
+  }
+  if ( s.has_sig_ ) {
+    --nack_;
+  }
+  s.id_ = 0UL;
+  s.has_sig_ = false;
+  ++nspan_;
+  if ( buf_.size() >= PC_TRACE_BUF ) {
+    flush();
+  }
+}
+
+void upd_trace::add_event( const char *name, unsigned tid,
+                           int64_t ts, int64_t dur )
+{
+  // complete event or instant if no duration. closed by caller
+  buf_ += nevt_++ ? ",\n{\"name\":\"" : "{\"name\":\"";
+  buf_ += name;
+  buf_ += dur < 0 ? "\",\"ph\":\"i\"" : "\",\"ph\":\"X\"";
+  buf_ += ",\"pid\":1,\"tid\":";
+  buf_ += std::to_string( tid );
+  buf_ += ",\"ts\":";
+  add_time( ts );
+  if ( dur >= 0 ) {
+    buf_ += ",\"dur\":";
+    add_time( dur );
+  }
+}
+
+void upd_trace::add_time( int64_t ns )
+{
+  // microseconds to nanosecond precision
+  char tbuf[32];
+  int len = ::snprintf( tbuf, sizeof( tbuf ), "%ld.%03ld",
+                        ns / 1000L, ns % 1000L );
+  buf_.append( tbuf, static_cast< size_t >( len ) );
+}
+
+void upd_trace::flush()
+{
+  const char *buf = buf_.data();
+  size_t len = buf_.size();
+  while( fd_ >= 0 && len > 0 ) {
+    ssize_t num = ::write( fd_, buf, len );
+    if ( num > 0 ) {
+      buf += num;
+      len -= static_cast< size_t >( num );
+    } else {
+      set_err_msg( "failed to write trace file=" + file_, errno );
+      PC_LOG_ERR( "failed to write trace file" )
+        .add( "file", file_ )
+        .add( "error", get_err_msg() )
+        .end();
+      ::close( fd_ );
+      fd_ = -1;
+    }
+  }
+  buf_.clear();
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <pc/error.hpp>
+#include <pc/key_pair.hpp>
+#include <pc/misc.hpp>
+#include <vector>
+
+namespace pc
+{
+
+  // stages of a traced publisher update
+  enum trace_stage {
+    e_trc_recv = 0,   // message received from user
+    e_trc_parse,      // update applied to price
+    e_trc_send,       // picked up by price::send
+    e_trc_sent,       // handed to rpc_client or tx proxy
+    e_trc_ack,        // sendTransaction reply
+    e_trc_agg,        // aggregate with the publish slot observed
+    e_trc_num
+  };
+
+  // sampled tracing of publisher updates through pythd. one in every
+  // sample updates is followed from the user message to the aggregate
+  // that includes it and written as a chrome trace event file (as read
+  // by chrome://tracing or perfetto) with one lane per in-flight span
+  class upd_trace : public error
+  {
+  public:
+
+    upd_trace();
+    ~upd_trace();
+
+    // chrome trace event file
+    void set_file( const std::string& );
+    std::string get_file() const;
+
+    // trace one in num updates (default 100)
+    void set_sample( unsigned num );
+    unsigned get_sample() const;
+
+    // create file
+    bool init();
+
+    // update of symbol received at rts and applied at ts. returns the
+    // id of the new span or 0 if not sampled
+    uint64_t add_recv( str symbol, int64_t rts, int64_t ts );
+
+    // is span still in flight
+    bool get_is_live( uint64_t id ) const;
+
+    // update picked up for sending
+    void add_send( uint64_t id, int64_t ts );
+
+    // update of pub_slot sent in the transaction with signature sig
+    // (null if signed elsewhere)
+    void add_sent( uint64_t id, const signature *sig, uint64_t pub_slot,
+                   int64_t ts );
+
+    // reply to the transaction with the raw signature
+    void add_ack( const uint8_t *sig, int64_t ts );
+
+    // aggregate including the update of pub_slot observed. completes
+    // the span
+    void add_agg( uint64_t id, uint64_t pub_slot, int64_t ts );
+
+    // write spans that timed out and flush buffered events
+    void poll( int64_t ts );
+
+    // write remaining spans and close file
+    bool close();
+
+    // number of spans written
+    uint64_t get_num_spans() const;
+
+  private:
+
+    struct span {
+      uint64_t    id_;    // 0 if free
+      uint64_t    slot_;  // publish slot
+      int64_t     ts_[e_trc_num];
+      signature   sig_;
+      bool        has_sig_;
+      std::string sym_;
+    };
+
+    typedef std::vector<span> span_vec_t;
+
+    span *get_span( uint64_t id );
+    void write_span( span& );
+    void add_event( const char *name, unsigned tid, int64_t ts,
+                    int64_t dur );
+    void add_time( int64_t ns );
+    void flush();
+
+    int         fd_;
+    unsigned    sample_;
+    unsigned    cnt_;     // updates since last sampled
+    unsigned    nack_;    // spans waiting on a transaction reply
+    uint64_t    nid_;     // last span id
+    uint64_t    nspan_;   // spans written
+    uint64_t    nevt_;    // events written
+    int64_t     fts_;     // last flush time
+    span_vec_t  spans_;   // spans by id modulo size
+    std::string buf_;     // unwritten events
+    std::string file_;
+  };
+
+  inline bool upd_trace::get_is_live( uint64_t id ) const
+  {
+    return id && spans_[id%spans_.size()].id_ == id;
+  }
+
+}
@@ -2,7 +2,10 @@
 #include "manager.hpp"
 #include "log.hpp"
 #include "mem_map.hpp"
+#include "handoff.hpp"
 #include <algorithm>
+#include <sys/socket.h>
+#include <netinet/in.h>
 
 #define PC_JSON_RPC_VER         "2.0"
 #define PC_JSON_PARSE_ERROR     -32700
@@ -16,6 +19,286 @@
 
 using namespace pc;
 
+// pre-rendered keys for price notifications
+static const json_key key_jsonrpc( "jsonrpc" );
+static const json_key key_method( "method" );
+static const json_key key_params( "params" );
+static const json_key key_result( "result" );
+static const json_key key_price( "price" );
+static const json_key key_conf( "conf" );
+static const json_key key_twap( "twap" );
+static const json_key key_twac( "twac" );
+static const json_key key_status( "status" );
+static const json_key key_num_qt( "num_qt" );
+static const json_key key_valid_slot( "valid_slot" );
+static const json_key key_pub_slot( "pub_slot" );
+static const json_key key_subscription( "subscription" );
+
+static const json_key key_account( "account" );
+static const json_key key_slot( "slot" );
+
+// aggregate price fields of price notifications
+static void add_price_fields( json_wtr& jw, price *rptr )
+{
+  jw.add_key( key_price, rptr->get_price() );
+  jw.add_key( key_conf, rptr->get_conf() );
+  jw.add_key( key_twap, rptr->get_twap() );
+  jw.add_key( key_twac, rptr->get_twac() );
+  jw.add_key( key_status, symbol_status_to_str( rptr->get_status() ) );
+  jw.add_key( key_num_qt, (uint64_t)rptr->get_num_qt() );
+  jw.add_key( key_valid_slot, rptr->get_valid_slot() );
+  jw.add_key( key_pub_slot, rptr->get_pub_slot() );
+}
+
+// aggregate price fields of a multicast record
+static void add_rec_fields( json_wtr& jw, const mcast_rec& rec )
+{
+  jw.add_key_enc_base58( "account",
+      str( (const char*)&rec.acc_, sizeof( pc_pub_key_t ) ) );
+  jw.add_key( key_price, rec.price_ );
+  jw.add_key( key_conf, rec.conf_ );
+  jw.add_key( key_twap, rec.twap_ );
+  jw.add_key( key_twac, rec.twac_ );
+  jw.add_key( key_status,
+      symbol_status_to_str( static_cast< symbol_status >( rec.status_ ) ) );
+  jw.add_key( key_num_qt, (uint64_t)rec.num_qt_ );
+  jw.add_key( key_valid_slot, rec.valid_slot_ );
+  jw.add_key( key_pub_slot, rec.pub_slot_ );
+}
+
+///////////////////////////////////////////////////////////////////////////
+// price_notify
+
+price_notify::price_notify()
+: ptr_( nullptr ),
+  seq_( 0UL ),
+  hd_( nullptr ),
+  len_( 0UL )
+{
+}
+
+price_notify::~price_notify()
+{
+  dealloc();
+}
+
+void price_notify::dealloc()
+{
+  // buffers still queued on user connections are released when sent
+  while( hd_ ) {
+    net_buf *nxt = hd_->next_;
+    hd_->dealloc();
+    hd_ = nxt;
+  }
+}
+
+net_buf *price_notify::get( price *rptr, size_t& len )
+{
+  if ( rptr != ptr_ || rptr->get_update_seq() != seq_ || !hd_ ) {
+    json_wtr jw;
+    jw.add_val( json_wtr::e_obj );
+    jw.add_key( key_jsonrpc, str( PC_JSON_RPC_VER ) );
+    jw.add_key( key_method, "notify_price" );
+    jw.add_key( key_params, json_wtr::e_obj );
+    jw.add_key( key_result, json_wtr::e_obj );
+    add_price_fields( jw, rptr );
+    jw.pop();
+    jw.add( key_subscription.get_text( false ) );
+    dealloc();
+    net_buf *tl;
+    len_ = jw.size();
+    jw.detach( hd_, tl );
+    ptr_ = rptr;
+    seq_ = rptr->get_update_seq();
+  }
+  len = len_;
+  return hd_;
+}
+
+///////////////////////////////////////////////////////////////////////////
+// dash_notify
+
+static const json_key key_id( "id" );
+
+dash_notify::dash_notify()
+: num_usr_( 0U ),
+  slot_( 0UL ),
+  hd_( nullptr ),
+  len_( 0UL )
+{
+}
+
+dash_notify::~dash_notify()
+{
+  dealloc();
+}
+
+void dash_notify::dealloc()
+{
+  while( hd_ ) {
+    net_buf *nxt = hd_->next_;
+    hd_->dealloc();
+    hd_ = nxt;
+  }
+  len_ = 0UL;
+}
+
+void dash_notify::add_user( manager *mgr )
+{
+  if ( num_usr_++ ) {
+    return;
+  }
+  // deltas of changes not yet notified are taken against the fields as
+  // they are now as are the snapshots of the new subscriber
+  dealloc();
+  slot_ = mgr->get_slot();
+  for( unsigned i = 0; i != mgr->get_num_product(); ++i ) {
+    product *prod = mgr->get_product( i );
+    for( unsigned j = 0; j != prod->get_num_price(); ++j ) {
+      price *ptr = prod->get_price( j );
+      rec& r = get_rec( ptr );
+      r.ptr_        = ptr;
+      r.price_      = ptr->get_price();
+      r.conf_       = ptr->get_conf();
+      r.twap_       = ptr->get_twap();
+      r.twac_       = ptr->get_twac();
+      r.status_     = ptr->get_status();
+      r.num_qt_     = ptr->get_num_qt();
+      r.valid_slot_ = ptr->get_valid_slot();
+      r.pub_slot_   = ptr->get_pub_slot();
+    }
+  }
+}
+
+void dash_notify::del_user()
+{
+  if ( num_usr_ ) {
+    --num_usr_;
+  }
+}
+
+unsigned dash_notify::get_num_user() const
+{
+  return num_usr_;
+}
+
+uint64_t dash_notify::get_slot() const
+{
+  return slot_;
+}
+
+dash_notify::rec& dash_notify::get_rec( price *ptr )
+{
+  unsigned idx = ptr->get_arena_index();
+  if ( idx >= rvec_.size() ) {
+    rec r;
+    __builtin_memset( &r, 0, sizeof( r ) );
+    rvec_.resize( idx + 1, r );
+  }
+  return rvec_[idx];
+}
+
+bool dash_notify::update( const price_vec_t& pvec, uint64_t slot )
+{
+  dealloc();
+  slot_ = slot;
+  json_wtr jw;
+  jw.add_val( json_wtr::e_obj );
+  jw.add_key( key_jsonrpc, str( PC_JSON_RPC_VER ) );
+  jw.add_key( key_method, "notify_dashboard" );
+  jw.add_key( key_params, json_wtr::e_obj );
+  jw.add_key( key_slot, slot );
+  jw.add_key( key_result, json_wtr::e_arr );
+  bool is_chg = false;
+  for( price *ptr: pvec ) {
+    rec& r = get_rec( ptr );
+    bool is_new = r.ptr_ == nullptr;
+    int64_t px = ptr->get_price(), twap = ptr->get_twap();
+    uint64_t conf = ptr->get_conf(), twac = ptr->get_twac();
+    symbol_status st = ptr->get_status();
+    uint32_t num_qt = ptr->get_num_qt();
+    uint64_t valid_slot = ptr->get_valid_slot();
+    uint64_t pub_slot = ptr->get_pub_slot();
+    if ( !is_new && px == r.price_ && conf == r.conf_ && twap == r.twap_ &&
+         twac == r.twac_ && st == r.status_ && num_qt == r.num_qt_ &&
+         valid_slot == r.valid_slot_ && pub_slot == r.pub_slot_ ) {
+      continue;
+    }
+    jw.add_val( json_wtr::e_obj );
+    jw.add_key( key_id, (uint64_t)ptr->get_arena_index() );
+    if ( is_new ) {
+      jw.add_key( key_account, ptr->get_account_text() );
+    }
+    if ( is_new || px != r.price_ ) {
+      jw.add_key( key_price, r.price_ = px );
+    }
+    if ( is_new || conf != r.conf_ ) {
+      jw.add_key( key_conf, r.conf_ = conf );
+    }
+    if ( is_new || twap != r.twap_ ) {
+      jw.add_key( key_twap, r.twap_ = twap );
+    }
+    if ( is_new || twac != r.twac_ ) {
+      jw.add_key( key_twac, r.twac_ = twac );
+    }
+    if ( is_new || st != r.status_ ) {
+      jw.add_key( key_status, symbol_status_to_str( r.status_ = st ) );
+    }
+    if ( is_new || num_qt != r.num_qt_ ) {
+      jw.add_key( key_num_qt, (uint64_t)( r.num_qt_ = num_qt ) );
+    }
+    if ( is_new || valid_slot != r.valid_slot_ ) {
+      jw.add_key( key_valid_slot, r.valid_slot_ = valid_slot );
+    }
+    if ( is_new || pub_slot != r.pub_slot_ ) {
+      jw.add_key( key_pub_slot, r.pub_slot_ = pub_slot );
+    }
+    jw.pop();
+    r.ptr_ = ptr;
+    is_chg = true;
+  }
+  if ( !is_chg ) {
+    return false;
+  }
+  jw.pop();
+  jw.add( key_subscription.get_text( false ) );
+  net_buf *tl;
+  len_ = jw.size();
+  jw.detach( hd_, tl );
+  return true;
+}
+
+net_buf *dash_notify::get( size_t& len )
+{
+  len = len_;
+  return hd_;
+}
+
+void dash_notify::write_snapshot( json_wtr& jw ) const
+{
+  jw.add_key( key_slot, slot_ );
+  jw.add_key( key_result, json_wtr::e_arr );
+  for( unsigned idx = 0; idx != rvec_.size(); ++idx ) {
+    const rec& r = rvec_[idx];
+    if ( !r.ptr_ ) {
+      continue;
+    }
+    jw.add_val( json_wtr::e_obj );
+    jw.add_key( key_id, (uint64_t)idx );
+    jw.add_key( key_account, r.ptr_->get_account_text() );
+    jw.add_key( key_price, r.price_ );
+    jw.add_key( key_conf, r.conf_ );
+    jw.add_key( key_twap, r.twap_ );
+    jw.add_key( key_twac, r.twac_ );
+    jw.add_key( key_status, symbol_status_to_str( r.status_ ) );
+    jw.add_key( key_num_qt, (uint64_t)r.num_qt_ );
+    jw.add_key( key_valid_slot, r.valid_slot_ );
+    jw.add_key( key_pub_slot, r.pub_slot_ );
+    jw.pop();
+  }
+  jw.pop();
+}
+
 ///////////////////////////////////////////////////////////////////////////
 // user
 
@@ -27,7 +310,19 @@ void user::user_http::parse_content( const char *txt, size_t len )
 user::user()
 : rptr_( nullptr ),
   sptr_( nullptr ),
-  psub_( this )
+  psub_( this ),
+  hbp_(),
+  bsid_( 0UL ),
+  bslot_( 0UL ),
+  dsid_( 0UL ),
+  slow_ts_( 0L ),
+  msg_ts_( 0L ),
+  max_wsz_( 0UL ),
+  num_conf_( 0UL ),
+  bin_( false ),
+  back_( false ),
+  dash_( false ),
+  dsync_( false )
 {
   // setup the plumbing
   hsvr_.ptr_ = this;
@@ -53,8 +348,26 @@ void user::teardown()
   // remove self from server list
   sptr_->del_user( this );
 
-  // remove all symbol subscriptions
+  // remove all symbol subscriptions. those to prices of secondary
+  // managers are removed under their lock as they were added
+  for( uint64_t sid = 0; sid != psub_.get_end(); ++sid ) {
+    request *rptr = psub_.get( sid );
+    manager *mgr = rptr ? rptr->get_manager() : nullptr;
+    std::unique_lock<manager> lk;
+    if ( mgr && mgr != sptr_ ) {
+      lk = std::unique_lock<manager>( *mgr );
+    }
+    psub_.del( sid );
+  }
   psub_.teardown();
+  if ( !bsvec_.empty() || dash_ ) {
+    sptr_->del_bulk_user( this );
+    bsvec_.clear();
+  }
+  if ( dash_ ) {
+    sptr_->get_dash_notify()->del_user();
+    dash_ = false;
+  }
 }
 
 static str get_content_type( const std::string & filen )
@@ -80,6 +393,17 @@ void user::parse_content( const char *, size_t )
 
   http_response msg;
 
+  // operational metrics rendered from in-memory counters
+  if ( path == str( "/metrics" ) ) {
+    metrics_wtr mw;
+    sptr_->write_metrics( mw );
+    msg.init( "200", "OK" );
+    msg.add_hdr( "Content-Type", "text/plain; version=0.0.4" );
+    msg.commit( mw );
+    add_send( msg );
+    return;
+  }
+
   // whitelist
   std::string const relpath{ path.str_, path.len_ };
   if (
@@ -119,6 +443,12 @@ void user::parse_content( const char *, size_t )
 
 void user::parse_msg( const char *txt, size_t len )
 {
+  // only needed for traced updates
+  msg_ts_ = PC_UNLIKELY( sptr_->get_trace() != nullptr ) ? get_now() : 0L;
+  if ( bin_ && get_is_binary() ) {
+    parse_binary( txt, len );
+    return;
+  }
   jw_.reset();
   jp_.parse( txt, len );
   if ( jp_.is_valid() ) {
@@ -128,15 +458,21 @@ void user::parse_msg( const char *txt, size_t len )
     } else if ( t == jtree::e_arr ) {
       uint32_t tok = jp_.get_first( 1 );
       if ( tok ) {
+        bool has_reply = false;
         jw_.add_val( json_wtr::e_arr );
         for( ; tok; tok = jp_.get_next( tok ) ) {
           if ( jp_.get_type( tok ) == jtree::e_obj ) {
-            parse_request( tok );
+            has_reply = parse_request( tok ) || has_reply;
           } else {
             add_invalid_request();
+            has_reply = true;
           }
         }
         jw_.pop();
+        // batch of notifications only gets no reply
+        if ( !has_reply ) {
+          jw_.reset();
+        }
       } else {
         add_invalid_request();
       }
@@ -147,91 +483,536 @@ void user::parse_msg( const char *txt, size_t len )
     add_parse_error();
   }
   // wrap in websockets header and submit
-  ws_wtr msg;
-  msg.commit( ws_wtr::text_id, jw_, false );
-  add_send( msg );
+  if ( jw_.size() ) {
+    ws_wtr msg;
+    msg.commit( ws_wtr::text_id, jw_, false, get_ws_deflate() );
+    add_send( msg );
+  }
 
   // process any deferred subscriptions
   if ( PC_UNLIKELY( !dvec_.empty() ) ) {
     for( deferred_sub& dsub: dvec_ ) {
-      on_response( dsub.sptr_, dsub.sid_ );
+      notify_price( dsub.sptr_, dsub.sid_ );
     }
     dvec_.clear();
   }
+  send_bulk();
 }
 
-void user::parse_request( uint32_t tok )
+bool user::parse_request( uint32_t tok )
 {
   uint32_t itok = jp_.find_val( tok, "id" );
   uint32_t mtok = jp_.find_val( tok, "method" );
+
+  // price updates sent as notifications (without id) are not replied to
+  if ( itok == 0 && mtok && jtree::e_val == jp_.get_type( mtok ) ) {
+    str mst = jp_.get_str( mtok );
+    uint32_t ptok = jp_.find_val( tok, "params" );
+    if ( mst == "update_price" ) {
+      parse_upd_params( ptok );
+      return false;
+    }
+    if ( mst == "update_prices" && ptok &&
+         jp_.get_type( ptok ) == jtree::e_arr ) {
+      for( uint32_t utok = jp_.get_first( ptok ); utok;
+           utok = jp_.get_next( utok ) ) {
+        parse_upd_params( utok );
+      }
+      return false;
+    }
+  }
   if ( itok ==0 || mtok == 0 ||
        jtree::e_val != jp_.get_type( itok ) ||
        jtree::e_val != jp_.get_type( mtok ) ) {
     add_invalid_request( itok );
-    return;
+    return true;
   }
   str mst = jp_.get_str( mtok );
   if ( mst == "update_price" ) {
     parse_upd_price( tok, itok );
+  } else if ( mst == "update_prices" ) {
+    parse_upd_prices( tok, itok );
   } else if ( mst == "subscribe_price" ) {
     parse_sub_price( tok, itok );
   } else if ( mst == "subscribe_price_sched" ) {
     parse_sub_price_sched( tok, itok );
+  } else if ( mst == "subscribe_prices" ) {
+    parse_sub_prices( tok, itok, false );
+  } else if ( mst == "subscribe_all_prices" ) {
+    parse_sub_prices( tok, itok, true );
+  } else if ( mst == "subscribe_dashboard" ) {
+    parse_sub_dashboard( itok );
   } else if ( mst == "get_product_list" ) {
     parse_get_product_list( itok );
   } else if ( mst == "get_product" ) {
     parse_get_product( tok, itok );
   } else if ( mst == "get_all_products" ) {
     parse_get_all_products( itok );
+  } else if ( mst == "enable_binary" ) {
+    parse_enable_binary( tok, itok );
+  } else if ( mst == "get_price_handle" ) {
+    parse_get_price_handle( tok, itok );
+  } else if ( mst == "mcast_snapshot" ) {
+    parse_mcast_snapshot( itok );
+  } else if ( mst == "mcast_retransmit" ) {
+    parse_mcast_retransmit( tok, itok );
+  } else if ( mst == "set_capture" ) {
+    parse_set_capture( tok, itok );
   } else {
     add_error( itok, PC_JSON_UNKNOWN_METHOD, "method not found" );
   }
+  return true;
 }
 
 void user::parse_upd_price( uint32_t tok, uint32_t itok )
 {
-  do {
-    // unpack and verify parameters
-    uint32_t ntok,ptok = jp_.find_val( tok, "params" );
-    if ( ptok == 0 || jp_.get_type(ptok) != jtree::e_obj ) break;
-    if ( 0 == (ntok = jp_.find_val( ptok, "account" ) ) ) break;
-    pub_key pkey;
-    pkey.init_from_text( jp_.get_str( ntok ) );
-    price *sptr = sptr_->get_price( pkey );
-    price *sptr_secondary = nullptr;
-    if ( sptr_->has_secondary() ) {
-      sptr_secondary = sptr_->get_secondary()->get_price( pkey );
+  // unpack and verify parameters
+  uint32_t ptok = jp_.find_val( tok, "params" );
+  int err = parse_upd_params( ptok );
+  if ( PC_UNLIKELY( err == PC_JSON_UNKNOWN_SYMBOL ) ) {
+    add_unknown_symbol( itok );
+  } else if ( PC_UNLIKELY( err ) ) {
+    add_invalid_params( itok );
+  } else {
+    // Send the result back
+    add_header();
+    jw_.add_key( "result", 0UL );
+    add_tail( itok );
+  }
+}
+
+void user::parse_upd_prices( uint32_t tok, uint32_t itok )
+{
+  // params is an array of update_price params. reply with one result
+  // per entry: 0 on success or the error code update_price would return
+  uint32_t ptok = jp_.find_val( tok, "params" );
+  if ( ptok == 0 || jp_.get_type( ptok ) != jtree::e_arr ) {
+    return add_invalid_params( itok );
+  }
+  add_header();
+  jw_.add_key( "result", json_wtr::e_arr );
+  for( uint32_t utok = jp_.get_first( ptok ); utok;
+       utok = jp_.get_next( utok ) ) {
+    jw_.add_val( (int64_t)parse_upd_params( utok ) );
+  }
+  jw_.pop();
+  add_tail( itok );
+}
+
+int user::parse_upd_params( uint32_t ptok )
+{
+  if ( ptok == 0 || jp_.get_type(ptok) != jtree::e_obj ) {
+    return PC_JSON_INVALID_PARAMS;
+  }
+  static const str keys[] = {
+    "account", "price", "conf", "status", "handle" };
+  uint32_t vals[5];
+  jp_.find_vals( ptok, keys, vals );
+
+  // accounts are given as text or as a handle from get_price_handle
+  bin_price *bp = nullptr;
+  if ( vals[4] ) {
+    uint64_t hdl = jp_.get_uint( vals[4] );
+    if ( PC_UNLIKELY( hdl >= hvec_.size() ) ) {
+      return PC_JSON_UNKNOWN_SYMBOL;
     }
+    bp = &hvec_[hdl];
+  } else if ( vals[0] ) {
+    bp = get_handle( jp_.get_str( vals[0] ) );
+  } else {
+    return PC_JSON_INVALID_PARAMS;
+  }
 
-    // Bail if we cannot find the price in either manager.
-    if ( PC_UNLIKELY( !sptr && !sptr_secondary ) ) { add_unknown_symbol(itok); return; }
-    
-    if ( 0 == (ntok = jp_.find_val( ptok, "price" ) ) ) break;
-    int64_t price = jp_.get_int( ntok );
-    if ( 0 == (ntok = jp_.find_val( ptok, "conf" ) ) ) break;
-    uint64_t conf = jp_.get_uint( ntok );
-    if ( 0 == (ntok = jp_.find_val( ptok, "status" ) ) ) break;
-    symbol_status stype = str_to_symbol_status( jp_.get_str( ntok ) );
+  // Bail if we cannot find the price in any manager.
+  if ( PC_UNLIKELY( !find_price( *bp ) ) ) {
+    return PC_JSON_UNKNOWN_SYMBOL;
+  }
 
-    // Add the price to both the managers pending updates, so that it will
-    // be published to both networks if possible.
-    if ( sptr ) {
-      sptr->update_no_send( price, conf, stype, false );
-      sptr_->add_dirty_price( sptr );
+  if ( 0 == vals[1] || 0 == vals[2] || 0 == vals[3] ) {
+    return PC_JSON_INVALID_PARAMS;
+  }
+  int64_t price = jp_.get_int( vals[1] );
+  uint64_t conf = jp_.get_uint( vals[2] );
+  symbol_status stype = str_to_symbol_status( jp_.get_str( vals[3] ) );
+
+  update_price( *bp, price, conf, stype );
+  return 0;
+}
+
+user::bin_price *user::get_handle( str acc, uint32_t *hdl )
+{
+  // publishers update the same accounts over and over so the decoded
+  // key and prices are interned by account text
+  acc_text txt;
+  if ( PC_LIKELY( acc.len_ < sizeof( txt ) &&
+                  hvec_.size() < bin_max_idx ) ) {
+    __builtin_memset( &txt, 0, sizeof( txt ) );
+    __builtin_memcpy( &txt, acc.str_, acc.len_ );
+    text_map_t::iter_t it = hmap_.find( txt );
+    if ( PC_UNLIKELY( !it ) ) {
+      it = hmap_.add( txt );
+      hmap_.ref( it ) = static_cast< uint32_t >( hvec_.size() );
+      hvec_.push_back( bin_price{ pub_key(), nullptr, nullptr } );
+      hvec_.back().acc_.init_from_text( acc );
     }
-    if ( sptr_secondary ) {
-      sptr_secondary->update_no_send( price, conf, stype, false );
-      sptr_->get_secondary()->add_dirty_price( sptr_secondary );
+    if ( hdl ) {
+      *hdl = hmap_.obj( it );
     }
+    return &hvec_[hmap_.obj( it )];
+  }
+  if ( hdl ) {
+    return nullptr;
+  }
+  hbp_ = bin_price{ pub_key(), nullptr, nullptr };
+  hbp_.acc_.init_from_text( acc );
+  return &hbp_;
+}
 
-    // Send the result back
-    add_header();
-    jw_.add_key( "result", 0UL );
-    add_tail( itok );
+void user::parse_get_price_handle( uint32_t tok, uint32_t itok )
+{
+  // params: { "account" : <price account> }
+  // the handle replaces the account of later update_price requests
+  uint32_t ptok = jp_.find_val( tok, "params" );
+  uint32_t atok = ptok ? jp_.find_val( ptok, "account" ) : 0;
+  if ( !atok || jp_.get_type( ptok ) != jtree::e_obj ) {
+    return add_invalid_params( itok );
+  }
+  uint32_t hdl = 0;
+  bin_price *bp = get_handle( jp_.get_str( atok ), &hdl );
+  if ( !bp || !find_price( *bp ) ) {
+    return add_unknown_symbol( itok );
+  }
+  add_header();
+  jw_.add_key( "result", json_wtr::e_obj );
+  jw_.add_key( "handle", (uint64_t)hdl );
+  jw_.pop();
+  add_tail( itok );
+}
+
+void user::update_price( const bin_price& bp,
+    int64_t price, uint64_t conf, symbol_status stype )
+{
+  // Add the price to all the managers pending updates, so that it will
+  // be published to every network if possible. secondary networks run
+  // on their own threads and pick up the update from their queue. of
+  // the shards only the one owning the price does
+  if ( bp.sptr_ ) {
+    bp.sptr_->update_no_send( price, conf, stype, false, msg_ts_ );
+    sptr_->add_dirty_price( bp.sptr_ );
+  }
+  manager *own = bp.sptr2_ ? bp.sptr2_->get_manager() : nullptr;
+  for( unsigned i = 0; i != sptr_->get_num_secondary(); ++i ) {
+    manager *mgr = sptr_->get_secondary( i );
+    if ( !mgr->get_is_shard() || mgr == own ) {
+      mgr->add_secondary_update( bp.acc_, price, conf, stype );
+    }
+  }
+}
+
+price *user::find_secondary_price( const pub_key& acc )
+{
+  for( unsigned i = 0; i != sptr_->get_num_secondary(); ++i ) {
+    manager *mgr = sptr_->get_secondary( i );
+    std::lock_guard<manager> lk( *mgr );
+    price *ptr = mgr->get_price( acc );
+    if ( ptr ) {
+      return ptr;
+    }
+  }
+  return nullptr;
+}
+
+manager *user::get_product_mgr( unsigned k, std::unique_lock<manager>& lk )
+{
+  // products of a sharded network are those of each of its shards in
+  // turn, locked against their thread
+  if ( sptr_->get_num_shard() > 1 ) {
+    if ( k == sptr_->get_num_shard() ) {
+      lk = std::unique_lock<manager>();
+      return nullptr;
+    }
+    lk = std::unique_lock<manager>( *sptr_->get_secondary( k ) );
+    return sptr_->get_secondary( k );
+  }
+  if ( k ) {
+    return nullptr;
+  }
+
+  // If the primary manager has no products, pull them from the first
+  // secondary manager that has, locked against its thread.
+  manager *mgr = sptr_;
+  for( unsigned i = 0; mgr->get_num_product() == 0 &&
+                       i != sptr_->get_num_secondary(); ++i ) {
+    mgr = sptr_->get_secondary( i );
+    lk = std::unique_lock<manager>( *mgr );
+  }
+  return mgr;
+}
+
+void user::notify_price( price *ptr, uint64_t sid )
+{
+  // a shard's price is read locked against its thread
+  manager *mgr = ptr->get_manager();
+  if ( mgr != sptr_ ) {
+    std::lock_guard<manager> lk( *mgr );
+    on_response( ptr, sid );
+  } else {
+    on_response( ptr, sid );
+  }
+}
+
+void user::parse_enable_binary( uint32_t tok, uint32_t itok )
+{
+  // optional params: { "ack" : true|false }
+  uint32_t ptok = jp_.find_val( tok, "params" );
+  if ( ptok && jp_.get_type( ptok ) != jtree::e_obj ) {
+    return add_invalid_params( itok );
+  }
+  uint32_t atok = ptok ? jp_.find_val( ptok, "ack" ) : 0;
+  bin_  = true;
+  back_ = atok && jp_.get_bool( atok );
+  add_header();
+  jw_.add_key( "result", json_wtr::e_obj );
+  jw_.add_key( "version", (uint64_t)bin_version );
+  jw_.pop();
+  add_tail( itok );
+}
+
+void user::parse_mcast_snapshot( uint32_t itok )
+{
+  // latest aggregate of every price and the sequence number of the last
+  // multicast packet it reflects
+  const mcast_pub *mptr = sptr_->get_mcast();
+  if ( !mptr ) {
+    return add_error( itok, PC_JSON_INVALID_REQUEST, "multicast disabled" );
+  }
+  add_header();
+  jw_.add_key( "result", json_wtr::e_obj );
+  jw_.add_key( "seq", mptr->get_seq() );
+  jw_.add_key( key_slot, sptr_->get_slot() );
+  jw_.add_key( "prices", json_wtr::e_arr );
+  mcast_rec rec;
+  for( unsigned i=0; i != sptr_->get_num_product(); ++i ) {
+    product *prod = sptr_->get_product( i );
+    for( unsigned j=0; j != prod->get_num_price(); ++j ) {
+      mcast_pub::get_rec( prod->get_price( j ), rec );
+      jw_.add_val( json_wtr::e_obj );
+      add_rec_fields( jw_, rec );
+      jw_.pop();
+    }
+  }
+  jw_.pop();
+  jw_.pop();
+  add_tail( itok );
+}
+
+void user::parse_mcast_retransmit( uint32_t tok, uint32_t itok )
+{
+  // params: { "seq" : <first packet>, "num" : <number of packets> }
+  // packets no longer kept are left out of the result
+  const mcast_pub *mptr = sptr_->get_mcast();
+  if ( !mptr ) {
+    return add_error( itok, PC_JSON_INVALID_REQUEST, "multicast disabled" );
+  }
+  uint32_t ptok = jp_.find_val( tok, "params" );
+  uint32_t stok = ptok ? jp_.find_val( ptok, "seq" ) : 0;
+  uint32_t ntok = ptok ? jp_.find_val( ptok, "num" ) : 0;
+  if ( !stok || !ntok || jp_.get_type( ptok ) != jtree::e_obj ) {
+    return add_invalid_params( itok );
+  }
+  uint64_t seq = jp_.get_uint( stok );
+  uint64_t num = std::min( jp_.get_uint( ntok ), (uint64_t)mptr->get_hist() );
+  add_header();
+  jw_.add_key( "result", json_wtr::e_arr );
+  for( uint64_t i = 0; i != num; ++i ) {
+    const mcast_hdr *hdr = mptr->get_packet( seq + i );
+    if ( !hdr ) {
+      continue;
+    }
+    jw_.add_val( json_wtr::e_obj );
+    jw_.add_key( "seq", hdr->seq_ );
+    jw_.add_key( key_slot, hdr->slot_ );
+    jw_.add_key( "prices", json_wtr::e_arr );
+    const mcast_rec *rptr = mcast_pub::get_recs( hdr );
+    for( unsigned j = 0; j != hdr->num_; ++j ) {
+      mcast_rec rec;
+      __builtin_memcpy( &rec, &rptr[j], sizeof( rec ) );
+      jw_.add_val( json_wtr::e_obj );
+      add_rec_fields( jw_, rec );
+      jw_.pop();
+    }
+    jw_.pop();
+    jw_.pop();
+  }
+  jw_.pop();
+  add_tail( itok );
+}
+
+static bool is_local_peer( int fd )
+{
+  // admin requests are only taken from this host
+  sockaddr_storage addr;
+  socklen_t len = sizeof( addr );
+  if ( 0 != ::getpeername( fd, (sockaddr*)&addr, &len ) ) {
+    return false;
+  }
+  if ( addr.ss_family == AF_UNIX ) {
+    return true;
+  }
+  if ( addr.ss_family == AF_INET ) {
+    const sockaddr_in *ip4 = (const sockaddr_in*)&addr;
+    return ( ntohl( ip4->sin_addr.s_addr ) >> 24 ) == 127U;
+  }
+  if ( addr.ss_family == AF_INET6 ) {
+    const in6_addr *ip6 = &((const sockaddr_in6*)&addr)->sin6_addr;
+    return IN6_IS_ADDR_LOOPBACK( ip6 ) ||
+      ( IN6_IS_ADDR_V4MAPPED( ip6 ) && ip6->s6_addr[12] == 127 );
+  }
+  return false;
+}
+
+void user::parse_set_capture( uint32_t tok, uint32_t itok )
+{
+  // params (each optional): { "paused" : <bool>, "full" : <bool>,
+  // "filters" : [ <cap_filter term>, ... ] } replacing the filters.
+  // replies with the resulting capture state
+  if ( !is_local_peer( get_fd() ) ) {
+    return add_error( itok, PC_JSON_MISSING_PERMS, "not a local connection" );
+  }
+  if ( !sptr_->get_do_capture() ) {
+    return add_error( itok, PC_JSON_INVALID_REQUEST, "capture disabled" );
+  }
+  cap_filter& flt = sptr_->get_capture_filter();
+  uint32_t ptok = jp_.find_val( tok, "params" );
+  if ( ptok ) {
+    static const str keys[] = { "paused", "full", "filters" };
+    uint32_t vals[3];
+    if ( jp_.get_type( ptok ) != jtree::e_obj ) {
+      return add_invalid_params( itok );
+    }
+    jp_.find_vals( ptok, keys, vals );
+    uint32_t ftok = vals[2];
+    if ( ftok ) {
+      // check all terms before replacing any
+      cap_filter chk;
+      if ( jp_.get_type( ftok ) != jtree::e_arr ) {
+        return add_invalid_params( itok );
+      }
+      for( uint32_t ttok = jp_.get_first( ftok ); ttok;
+           ttok = jp_.get_next( ttok ) ) {
+        if ( jp_.get_type( ttok ) != jtree::e_val ||
+             !chk.add_term( jp_.get_str( ttok ) ) ) {
+          return add_invalid_params( itok );
+        }
+      }
+      flt.clear();
+      for( unsigned i = 0; i != chk.get_num_term(); ++i ) {
+        flt.add_term( chk.get_term( i ) );
+      }
+    }
+    if ( vals[0] ) {
+      flt.set_is_paused( jp_.get_bool( vals[0] ) );
+    }
+    if ( vals[1] ) {
+      flt.set_is_full( jp_.get_bool( vals[1] ) );
+    }
+    PC_LOG_INF( "set_capture" )
+      .add( "paused", flt.get_is_paused() )
+      .add( "full", flt.get_is_full() )
+      .add( "filters", flt.get_num_term() )
+      .end();
+  }
+  add_header();
+  jw_.add_key( "result", json_wtr::e_obj );
+  if ( flt.get_is_paused() ) {
+    jw_.add_key( "paused", json_wtr::jtrue() );
+  } else {
+    jw_.add_key( "paused", json_wtr::jfalse() );
+  }
+  if ( flt.get_is_full() ) {
+    jw_.add_key( "full", json_wtr::jtrue() );
+  } else {
+    jw_.add_key( "full", json_wtr::jfalse() );
+  }
+  jw_.add_key( "filters", json_wtr::e_arr );
+  for( unsigned i = 0; i != flt.get_num_term(); ++i ) {
+    jw_.add_val( str( flt.get_term( i ) ) );
+  }
+  jw_.pop();
+  jw_.add_key( "skipped", flt.get_num_skip() );
+  jw_.pop();
+  add_tail( itok );
+}
 
+bool user::find_price( bin_price& bp )
+{
+  // resolve lazily as accounts may be mapped after binding
+  if ( !bp.sptr_ ) {
+    bp.sptr_ = sptr_->get_price( bp.acc_ );
+  }
+  if ( !bp.sptr_ && !bp.sptr2_ ) {
+    bp.sptr2_ = find_secondary_price( bp.acc_ );
+  }
+  return bp.sptr_ || bp.sptr2_;
+}
+
+void user::parse_binary( const char *buf, size_t len )
+{
+  bin_hdr hdr;
+  size_t rlen = sizeof( bin_upd );
+  bool is_ok = len >= sizeof( hdr );
+  if ( is_ok ) {
+    __builtin_memcpy( &hdr, buf, sizeof( hdr ) );
+    if ( hdr.flags_ & bin_flag_key ) {
+      rlen = sizeof( bin_key_upd );
+    }
+    is_ok = hdr.ver_ == bin_version &&
+      len == sizeof( hdr ) + rlen * hdr.num_;
+  }
+  if ( PC_UNLIKELY( !is_ok ) ) {
+    jw_.reset();
+    add_parse_error();
+    ws_wtr msg;
+    msg.commit( ws_wtr::text_id, jw_, false, get_ws_deflate() );
+    add_send( msg );
     return;
-  } while( 0 );
-  add_invalid_params( itok );
+  }
+
+  // apply updates in order
+  bin_ack ack;
+  ack.seq_ = hdr.seq_;
+  ack.num_ = ack.err_ = 0;
+  const char *rec = &buf[sizeof( hdr )];
+  for( uint32_t i = 0; i != hdr.num_; ++i, rec += rlen ) {
+    bin_upd upd;
+    __builtin_memcpy( &upd, rec, sizeof( upd ) );
+    if ( upd.idx_ >= bin_max_idx ||
+         upd.status_ >= (uint32_t)symbol_status::e_last_symbol_status ) {
+      ++ack.err_;
+      continue;
+    }
+    if ( upd.idx_ >= bvec_.size() ) {
+      bvec_.resize( upd.idx_ + 1, bin_price{ pub_key(), nullptr, nullptr } );
+    }
+    bin_price& bp = bvec_[upd.idx_];
+    if ( rlen == sizeof( bin_key_upd ) ) {
+      bp.acc_.init_from_buf( (const uint8_t*)&rec[sizeof( bin_upd )] );
+      bp.sptr_ = bp.sptr2_ = nullptr;
+    }
+    if ( PC_UNLIKELY( !find_price( bp ) ) ) {
+      ++ack.err_;
+      continue;
+    }
+    update_price( bp, upd.price_, upd.conf_, (symbol_status)upd.status_ );
+    ++ack.num_;
+  }
+  if ( back_ ) {
+    net_wtr abuf;
+    abuf.add( str( (const char*)&ack, sizeof( ack ) ) );
+    ws_wtr msg;
+    msg.commit( ws_wtr::binary_id, abuf, false, get_ws_deflate() );
+    add_send( msg );
+  }
 }
 
 void user::parse_sub_price( uint32_t tok, uint32_t itok )
@@ -243,7 +1024,17 @@ void user::parse_sub_price( uint32_t tok, uint32_t itok )
     if ( 0 == (ntok = jp_.find_val( ptok, "account" ) ) ) break;
     pub_key pkey;
     pkey.init_from_text( jp_.get_str( ntok ) );
+
+    // prices of a sharded network are notified on our thread by the
+    // shard that owns them
     price *sptr = sptr_->get_price( pkey );
+    std::unique_lock<manager> lk;
+    unsigned num_shard = sptr_->get_num_shard() > 1 ?
+      sptr_->get_num_shard() : 0U;
+    for( unsigned i = 0; !sptr && i != num_shard; ++i ) {
+      lk = std::unique_lock<manager>( *sptr_->get_secondary( i ) );
+      sptr = sptr_->get_secondary( i )->get_price( pkey );
+    }
     if ( PC_UNLIKELY( !sptr ) ) { add_unknown_symbol(itok); return; }
 
     // add subscription
@@ -264,6 +1055,107 @@ void user::parse_sub_price( uint32_t tok, uint32_t itok )
   add_invalid_params( itok );
 }
 
+void user::parse_sub_prices( uint32_t tok, uint32_t itok, bool all )
+{
+  do {
+    // unpack and verify parameters. subscribe_prices takes a list of
+    // accounts and/or product attribute values to match
+    if ( sptr_->get_num_shard() > 1 ) {
+      return add_error( itok, PC_JSON_INVALID_REQUEST,
+                        "not supported by sharded pythd" );
+    }
+    bulk_sub bsub;
+    bsub.all_ = all;
+    uint32_t ptok = jp_.find_val( tok, "params" );
+    if ( ptok && jp_.get_type( ptok ) != jtree::e_obj ) break;
+    if ( !all ) {
+      if ( !ptok || !jp_.get_first( ptok ) ) break;
+      bool is_ok = true;
+      for( uint32_t kv = jp_.get_first( ptok ); kv && is_ok;
+           kv = jp_.get_next( kv ) ) {
+        str key = jp_.get_str( jp_.get_key( kv ) );
+        uint32_t vtok = jp_.get_val( kv );
+        if ( key == "accounts" ) {
+          if ( jp_.get_type( vtok ) != jtree::e_arr ) {
+            is_ok = false;
+            break;
+          }
+          for( uint32_t atok = jp_.get_first( vtok ); atok;
+               atok = jp_.get_next( atok ) ) {
+            pub_key pkey;
+            pkey.init_from_text( jp_.get_str( atok ) );
+            price *sptr = sptr_->get_price( pkey );
+            if ( PC_UNLIKELY( !sptr ) ) {
+              add_unknown_symbol( itok );
+              return;
+            }
+            bsub.pvec_.push_back( sptr );
+          }
+        } else {
+          bulk_attr attr{ key.as_string(), attr_id( key ),
+                          jp_.get_str( vtok ).as_string() };
+          is_ok = jp_.get_type( vtok ) == jtree::e_val;
+          bsub.avec_.push_back( attr );
+        }
+      }
+      if ( !is_ok ) break;
+      std::sort( bsub.pvec_.begin(), bsub.pvec_.end() );
+    }
+
+    // add subscription. one record covers all matching prices
+    bsub.sid_ = bsid_++;
+    if ( bsvec_.empty() && !dash_ ) {
+      sptr_->add_bulk_user( this );
+    }
+
+    // create result
+    add_header();
+    jw_.add_key( "result", json_wtr::e_obj );
+    jw_.add_key( "subscription", bsub.sid_ );
+    jw_.pop();
+    add_tail( itok );
+
+    // current value of all matching prices follows the reply
+    for( unsigned i = 0; i != sptr_->get_num_product(); ++i ) {
+      product *prod = sptr_->get_product( i );
+      for( unsigned j = 0; j != prod->get_num_price(); ++j ) {
+        price *ptr = prod->get_price( j );
+        if ( bsub.match( ptr ) ) {
+          bsub.pend_.push_back( ptr );
+        }
+      }
+    }
+    bslot_ = std::max( bslot_, sptr_->get_slot() );
+    bsvec_.emplace_back( std::move( bsub ) );
+    return;
+  } while( 0 );
+  add_invalid_params( itok );
+}
+
+void user::parse_sub_dashboard( uint32_t itok )
+{
+  // a single feed of the changed fields of all prices once per slot. a
+  // snapshot of all prices follows the reply
+  if ( sptr_->get_num_shard() > 1 ) {
+    return add_error( itok, PC_JSON_INVALID_REQUEST,
+                      "not supported by sharded pythd" );
+  }
+  if ( !dash_ ) {
+    if ( bsvec_.empty() ) {
+      sptr_->add_bulk_user( this );
+    }
+    sptr_->get_dash_notify()->add_user( sptr_ );
+    dsid_ = bsid_++;
+    dash_ = true;
+  }
+  dsync_ = true;
+  add_header();
+  jw_.add_key( "result", json_wtr::e_obj );
+  jw_.add_key( "subscription", dsid_ );
+  jw_.pop();
+  add_tail( itok );
+}
+
 void user::parse_sub_price_sched( uint32_t tok, uint32_t itok )
 {
   do {
@@ -274,11 +1166,14 @@ void user::parse_sub_price_sched( uint32_t tok, uint32_t itok )
     pub_key pkey;
     pkey.init_from_text( jp_.get_str( ntok ) );
 
-    // Check to see if the price exists in either the primary or the secondary manager
+    // Check to see if the price exists in either the primary or a secondary
+    // manager. secondary schedules are dispatched on our thread
     price *sptr = sptr_->get_price( pkey );
-    if ( !sptr && sptr_->has_secondary() ) {
-      sptr = sptr_->get_secondary()->get_price( pkey );
-    };
+    std::unique_lock<manager> lk;
+    for( unsigned i = 0; !sptr && i != sptr_->get_num_secondary(); ++i ) {
+      lk = std::unique_lock<manager>( *sptr_->get_secondary( i ) );
+      sptr = sptr_->get_secondary( i )->get_price( pkey );
+    }
     if ( PC_UNLIKELY( !sptr ) ) { add_unknown_symbol(itok); return; }
 
     // add subscription
@@ -307,31 +1202,12 @@ void user::parse_get_product_list( uint32_t itok )
   // exist in the primary manager's mapping (i.e. pythd hasn't restarted), the prices
   // returned from this endpoint will therefore be stale and will only be updated
   // when the primary network reconnects.
-  pc::manager *mgr = sptr_;
-  if ( sptr_->get_num_product() == 0 && sptr_->has_secondary() ) {
-    mgr = sptr_->get_secondary();
-  }
-
-  for( unsigned i=0; i != mgr->get_num_product(); ++i ) {
-    product *prod = mgr->get_product( i );
-    jw_.add_val( json_wtr::e_obj );
-    jw_.add_key( "account", *prod->get_account() );
-    jw_.add_key( "attr_dict", json_wtr::e_obj );
-    prod->write_json( jw_ );
-    jw_.pop();
-    jw_.add_key( "price", json_wtr::e_arr );
-    for( unsigned j=0; j != prod->get_num_price(); ++j ) {
-      jw_.add_val( json_wtr::e_obj );
-      price *px = prod->get_price( j );
-      int64_t expo = px->get_price_exponent();
-      price_type ptype = px->get_price_type();
-      jw_.add_key( "account", *px->get_account() );
-      jw_.add_key( "price_exponent", expo );
-      jw_.add_key( "price_type", price_type_to_str( ptype) );
-      jw_.pop();
+  std::unique_lock<manager> lk;
+  for( unsigned k = 0; pc::manager *mgr = get_product_mgr( k, lk ); ++k ) {
+    // entries are rendered once per product and attribute change
+    for( unsigned i=0; i != mgr->get_num_product(); ++i ) {
+      jw_.add_verbatim( mgr->get_product( i )->get_list_json() );
     }
-    jw_.pop();
-    jw_.pop();
   }
   jw_.pop();
   add_tail( itok );
@@ -351,9 +1227,12 @@ void user::parse_get_product( uint32_t tok, uint32_t itok )
   product *prod = sptr_->get_product( pkey );
 
   // If the product is not present in the primary manager's mapping,
-  // attempt to use the one in the secondary manager's mapping instead.
-  if ( PC_UNLIKELY( !prod && sptr_->has_secondary() ) ) {
-    prod = sptr_->get_secondary()->get_product( pkey );
+  // attempt to use the one in a secondary manager's mapping instead.
+  std::unique_lock<manager> lk;
+  for( unsigned i = 0; !prod &&
+                       i != sptr_->get_num_secondary(); ++i ) {
+    lk = std::unique_lock<manager>( *sptr_->get_secondary( i ) );
+    prod = sptr_->get_secondary( i )->get_product( pkey );
   }
 
   if ( PC_UNLIKELY( !prod ) )
@@ -372,18 +1251,16 @@ void user::parse_get_all_products( uint32_t itok )
   add_header();
   jw_.add_key( "result", json_wtr::e_arr );
 
-  // If the primary manager has no products, pull them from the secondary
+  // If the primary manager has no products, pull them from a secondary
   // manager instead.
-  pc::manager *mgr = sptr_;
-  if ( sptr_->get_num_product() == 0 && sptr_->has_secondary() ) {
-    mgr = sptr_->get_secondary();
-  }
-
-  for( unsigned i=0; i != mgr->get_num_product(); ++i ) {
-    product *prod = mgr->get_product( i );
-    jw_.add_val( json_wtr::e_obj );
-    prod->dump_json( jw_ );
-    jw_.pop();
+  std::unique_lock<manager> lk;
+  for( unsigned k = 0; pc::manager *mgr = get_product_mgr( k, lk ); ++k ) {
+    for( unsigned i=0; i != mgr->get_num_product(); ++i ) {
+      product *prod = mgr->get_product( i );
+      jw_.add_val( json_wtr::e_obj );
+      prod->dump_json( jw_ );
+      jw_.pop();
+    }
   }
   jw_.pop();
   add_tail( itok );
@@ -392,7 +1269,7 @@ void user::parse_get_all_products( uint32_t itok )
 void user::add_header()
 {
   jw_.add_val( json_wtr::e_obj );
-  jw_.add_key( "jsonrpc", str( PC_JSON_RPC_VER ) );
+  jw_.add_key( key_jsonrpc, str( PC_JSON_RPC_VER ) );
 }
 
 void user::add_tail( uint32_t id )
@@ -445,28 +1322,75 @@ void user::add_error( uint32_t id, int err, str emsg )
 
 void user::on_response( price *rptr, uint64_t idx )
 {
+  // hold back notification from a backed-up consumer and send only the
+  // latest value of the price once the queue drains
+  if ( PC_UNLIKELY( get_send_size() >= sptr_->get_user_send_limit() ) ) {
+    add_conflate( idx );
+    return;
+  }
+
+  // share the body rendered for other subscribers unless each message
+  // is compressed with connection state
+  if ( PC_LIKELY( !get_ws_deflate() ) ) {
+    size_t len = 0;
+    net_buf *body = sptr_->get_price_notify()->get( rptr, len );
+    json_wtr tail;
+    tail.add_val( idx );
+    tail.add( str( "}}" ) );
+    ws_wtr msg;
+    msg.commit_header( ws_wtr::text_id, len + tail.size() );
+    add_send( msg );
+    add_send_ref( body );
+    add_send( tail );
+    return;
+  }
+
   // construct notify response
   jw_.reset();
   add_header();
-  jw_.add_key( "method", "notify_price" );
-  jw_.add_key( "params", json_wtr::e_obj );
-  jw_.add_key( "result", json_wtr::e_obj );
-  jw_.add_key( "price", rptr->get_price() );
-  jw_.add_key( "conf", rptr->get_conf() );
-  jw_.add_key( "twap", rptr->get_twap() );
-  jw_.add_key( "twac", rptr->get_twac() );
-  jw_.add_key( "status", symbol_status_to_str( rptr->get_status() ) );
-  jw_.add_key( "num_qt", (uint64_t)rptr->get_num_qt() );
-  jw_.add_key( "valid_slot", rptr->get_valid_slot() );
-  jw_.add_key( "pub_slot", rptr->get_pub_slot() );
+  jw_.add_key( key_method, "notify_price" );
+  jw_.add_key( key_params, json_wtr::e_obj );
+  jw_.add_key( key_result, json_wtr::e_obj );
+  add_price_fields( jw_, rptr );
   jw_.pop();
-  jw_.add_key( "subscription", idx );
+  jw_.add_key( key_subscription, idx );
+  jw_.pop();
+  jw_.pop();
+
+  // wrap in websockets header and submit
+  ws_wtr msg;
+  msg.commit( ws_wtr::text_id, jw_, false, get_ws_deflate() );
+  add_send( msg );
+}
+
+void user::on_response( price_predict *rptr, uint64_t idx )
+{
+  // predictions are superseded by the next one or by the aggregate so
+  // drop them rather than queue behind a backed-up consumer
+  if ( PC_UNLIKELY( get_send_size() >= sptr_->get_user_send_limit() ) ) {
+    return;
+  }
+
+  // construct notify response
+  jw_.reset();
+  add_header();
+  jw_.add_key( key_method, "notify_predicted_price" );
+  jw_.add_key( key_params, json_wtr::e_obj );
+  jw_.add_key( key_result, json_wtr::e_obj );
+  jw_.add_key( key_price, rptr->get_price_value() );
+  jw_.add_key( key_conf, rptr->get_conf() );
+  jw_.add_key( key_status, symbol_status_to_str( rptr->get_status() ) );
+  jw_.add_key( key_num_qt, (uint64_t)rptr->get_num_qt() );
+  jw_.add_key( key_pub_slot, rptr->get_pub_slot() );
+  jw_.add_key( "predicted", json_wtr::jtrue() );
+  jw_.pop();
+  jw_.add_key( key_subscription, idx );
   jw_.pop();
   jw_.pop();
 
   // wrap in websockets header and submit
   ws_wtr msg;
-  msg.commit( ws_wtr::text_id, jw_, false );
+  msg.commit( ws_wtr::text_id, jw_, false, get_ws_deflate() );
   add_send( msg );
 }
 
@@ -483,6 +1407,402 @@ void user::on_response( price_sched *, uint64_t idx )
 
   // wrap in websockets header and submit
   ws_wtr msg;
-  msg.commit( ws_wtr::text_id, jw_, false );
+  msg.commit( ws_wtr::text_id, jw_, false, get_ws_deflate() );
+  add_send( msg );
+}
+
+void user::add_conflate( uint64_t sid )
+{
+  ++num_conf_;
+  if ( cflag_.size() <= sid ) {
+    cflag_.resize( sid + 1, false );
+  }
+  if ( !cflag_[sid] ) {
+    cflag_[sid] = true;
+    cvec_.push_back( sid );
+  }
+}
+
+size_t user::get_num_sub() const
+{
+  return psub_.size() + bsvec_.size() + dash_;
+}
+
+size_t user::get_max_send_size() const
+{
+  return std::max( max_wsz_, get_send_size() );
+}
+
+uint64_t user::get_num_conflate() const
+{
+  return num_conf_;
+}
+
+void user::reset_send_stats()
+{
+  max_wsz_  = get_send_size();
+  num_conf_ = 0UL;
+}
+
+void user::poll_send_queue( int64_t ts )
+{
+  size_t wsz = get_send_size();
+  max_wsz_ = std::max( max_wsz_, wsz );
+  if ( wsz < sptr_->get_user_send_limit() ) {
+    slow_ts_ = 0L;
+    send_bulk();
+    if ( !cvec_.empty() ) {
+      // latest value of each conflated subscription. may conflate again
+      sub_vec_t cvec;
+      cvec.swap( cvec_ );
+      for( uint64_t sid: cvec ) {
+        cflag_[sid] = false;
+      }
+      for( uint64_t sid: cvec ) {
+        price *ptr = dynamic_cast<price*>( psub_.get( sid ) );
+        if ( ptr ) {
+          notify_price( ptr, sid );
+        }
+      }
+    }
+    return;
+  }
+  if ( !slow_ts_ ) {
+    slow_ts_ = ts;
+  }
+  int64_t slow = ts - slow_ts_;
+  if ( wsz > sptr_->get_user_send_max() ||
+       slow > sptr_->get_user_slow_timeout() * PC_NSECS_IN_MSEC ) {
+    PC_LOG_WRN( "slow_consumer_disconnect" )
+      .add( "fd", get_fd() )
+      .add( "send_size", wsz )
+      .add( "slow(ms)", slow / PC_NSECS_IN_MSEC )
+      .add( "num_conflate", num_conf_ )
+      .end();
+    teardown();
+  }
+}
+
+bool user::bulk_sub::match( price *ptr ) const
+{
+  if ( all_ ) {
+    return true;
+  }
+  if ( !pvec_.empty() &&
+       std::binary_search( pvec_.begin(), pvec_.end(), ptr ) ) {
+    return true;
+  }
+  if ( avec_.empty() ) {
+    return false;
+  }
+  for( const bulk_attr& attr: avec_ ) {
+    if ( !attr.id_.is_valid() ) {
+      attr.id_ = attr_id( str( attr.key_ ) );
+    }
+    str val;
+    if ( !ptr->get_attr( attr.id_, val ) || val != str( attr.val_ ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void user::on_prices( const price_vec_t& pvec, uint64_t slot )
+{
+  bool is_conf = get_send_size() >= sptr_->get_user_send_limit();
+  for( bulk_sub& bsub: bsvec_ ) {
+    for( price *ptr: pvec ) {
+      if ( bsub.match( ptr ) ) {
+        bsub.pend_.push_back( ptr );
+        num_conf_ += is_conf;
+      }
+    }
+  }
+  bslot_ = slot;
+  if ( dash_ && !dsync_ ) {
+    // a delta held back would leave the dashboard inconsistent so a
+    // backed-up consumer gets a snapshot once its queue drains
+    if ( get_send_size() >= sptr_->get_user_send_limit() ) {
+      dsync_ = true;
+      ++num_conf_;
+    } else {
+      send_dash();
+    }
+  }
+  send_bulk();
+}
+
+void user::send_dash()
+{
+  size_t len = 0;
+  net_buf *body = sptr_->get_dash_notify()->get( len );
+  if ( !body ) {
+    return;
+  }
+  json_wtr tail;
+  tail.add_val( dsid_ );
+  tail.add( str( "}}" ) );
+  if ( PC_LIKELY( !get_ws_deflate() ) ) {
+    ws_wtr msg;
+    msg.commit_header( ws_wtr::text_id, len + tail.size() );
+    add_send( msg );
+    add_send_ref( body );
+    add_send( tail );
+    return;
+  }
+
+  // compressed with connection state so copy the shared body
+  jw_.reset();
+  for( net_buf *ptr = body; ptr; ptr = ptr->next_ ) {
+    jw_.add( str( ptr->get_data(), ptr->size_ ) );
+  }
+  jw_.add_val( dsid_ );
+  jw_.add( str( "}}" ) );
+  ws_wtr msg;
+  msg.commit( ws_wtr::text_id, jw_, false, get_ws_deflate() );
   add_send( msg );
 }
+
+void user::send_bulk()
+{
+  // prices of backed-up consumers accumulate until the queue drains
+  if ( PC_UNLIKELY( get_send_size() >= sptr_->get_user_send_limit() ) ) {
+    return;
+  }
+  if ( dsync_ ) {
+    jw_.reset();
+    add_header();
+    jw_.add_key( key_method, "notify_dashboard" );
+    jw_.add_key( key_params, json_wtr::e_obj );
+    jw_.add_key( "snapshot", json_wtr::jtrue() );
+    sptr_->get_dash_notify()->write_snapshot( jw_ );
+    jw_.add_key( key_subscription, dsid_ );
+    jw_.pop();
+    jw_.pop();
+    dsync_ = false;
+    ws_wtr msg;
+    msg.commit( ws_wtr::text_id, jw_, false, get_ws_deflate() );
+    add_send( msg );
+  }
+  for( bulk_sub& bsub: bsvec_ ) {
+    if ( bsub.pend_.empty() ) {
+      continue;
+    }
+    std::sort( bsub.pend_.begin(), bsub.pend_.end() );
+    bsub.pend_.erase( std::unique( bsub.pend_.begin(), bsub.pend_.end() ),
+                      bsub.pend_.end() );
+    jw_.reset();
+    add_header();
+    jw_.add_key( key_method, "notify_prices" );
+    jw_.add_key( key_params, json_wtr::e_obj );
+    jw_.add_key( key_subscription, bsub.sid_ );
+    jw_.add_key( key_slot, bslot_ );
+    jw_.add_key( key_result, json_wtr::e_arr );
+    for( price *ptr: bsub.pend_ ) {
+      jw_.add_val( json_wtr::e_obj );
+      jw_.add_key( key_account, ptr->get_account_text() );
+      add_price_fields( jw_, ptr );
+      jw_.pop();
+    }
+    jw_.pop();
+    jw_.pop();
+    jw_.pop();
+    bsub.pend_.clear();
+
+    // wrap in websockets header and submit
+    ws_wtr msg;
+    msg.commit( ws_wtr::text_id, jw_, false, get_ws_deflate() );
+    add_send( msg );
+  }
+}
+
+bool user::save_state( std::string& buf ) const
+{
+  if ( get_net_parser() != static_cast< const ws_parser* >( this ) ||
+       get_is_deflate() ) {
+    return false;
+  }
+  handoff_wtr wtr;
+  std::string rbuf, wbuf;
+  get_queued( rbuf, wbuf );
+  wtr.add( (uint64_t)bin_ );
+  wtr.add( (uint64_t)back_ );
+  wtr.add( (uint64_t)bmsg_ );
+  wtr.add( str( rbuf.data(), rbuf.size() ) );
+  wtr.add( str( wbuf.data(), wbuf.size() ) );
+  wtr.add( str( msg_.data(), msg_.size() ) );
+
+  // price and price schedule subscriptions by id
+  wtr.add( (uint64_t)psub_.size() );
+  for( uint64_t sid = 0; sid != psub_.get_end(); ++sid ) {
+    request *rptr = psub_.get( sid );
+    if ( !rptr ) {
+      continue;
+    }
+    price_sched *kptr = dynamic_cast<price_sched*>( rptr );
+    price *ptr = kptr ? kptr->get_price() : dynamic_cast<price*>( rptr );
+    wtr.add( sid );
+    wtr.add( (uint64_t)( kptr != nullptr ) );
+    wtr.add( *ptr->get_account() );
+  }
+
+  // binary protocol indices and json handles keep their numbering
+  wtr.add( (uint64_t)bvec_.size() );
+  for( const bin_price& bp: bvec_ ) {
+    wtr.add( bp.acc_ );
+  }
+  wtr.add( (uint64_t)hvec_.size() );
+  for( const bin_price& bp: hvec_ ) {
+    wtr.add( bp.acc_ );
+  }
+
+  // bulk subscriptions
+  wtr.add( bsid_ );
+  wtr.add( bslot_ );
+  wtr.add( (uint64_t)bsvec_.size() );
+  for( const bulk_sub& bsub: bsvec_ ) {
+    wtr.add( bsub.sid_ );
+    wtr.add( (uint64_t)bsub.all_ );
+    wtr.add( (uint64_t)bsub.pvec_.size() );
+    for( price *ptr: bsub.pvec_ ) {
+      wtr.add( *ptr->get_account() );
+    }
+    wtr.add( (uint64_t)bsub.avec_.size() );
+    for( const bulk_attr& attr: bsub.avec_ ) {
+      wtr.add( attr.key_ );
+      wtr.add( attr.val_ );
+    }
+  }
+
+  // dashboard feed resumes with a snapshot
+  wtr.add( (uint64_t)dash_ );
+  wtr.add( dsid_ );
+
+  // notifications conflated but not yet sent
+  wtr.add( (uint64_t)cvec_.size() );
+  for( uint64_t sid: cvec_ ) {
+    wtr.add( sid );
+  }
+  buf = wtr.get();
+  return true;
+}
+
+int user::restore_state( const std::string& buf )
+{
+  handoff_rdr rdr( buf );
+  uint64_t is_bin = 0, is_back = 0, is_bmsg = 0, num = 0;
+  std::string rbuf, wbuf, mbuf;
+  if ( !rdr.get( is_bin ) || !rdr.get( is_back ) || !rdr.get( is_bmsg ) ||
+       !rdr.get( rbuf ) || !rdr.get( wbuf ) || !rdr.get( mbuf ) ) {
+    return -1;
+  }
+  msg_.assign( mbuf.begin(), mbuf.end() );
+  bin_  = is_bin != 0UL;
+  back_ = is_back != 0UL;
+  bmsg_ = is_bmsg != 0UL;
+  set_net_parser( this );
+  set_net_connect( this );
+  set_queued( rbuf, wbuf );
+
+  // subscriptions are looked up as when they were made
+  int num_drop = 0;
+  rdr.get( num );
+  for( uint64_t i = 0; i != num; ++i ) {
+    uint64_t sid = 0, is_sched = 0;
+    pub_key pkey;
+    if ( !rdr.get( sid ) || !rdr.get( is_sched ) || !rdr.get( pkey ) ) {
+      return -1;
+    }
+    price *sptr = sptr_->get_price( pkey );
+    std::unique_lock<manager> lk;
+    unsigned num_mgr = is_sched ? sptr_->get_num_secondary() :
+      ( sptr_->get_num_shard() > 1 ? sptr_->get_num_shard() : 0U );
+    for( unsigned j = 0; !sptr && j != num_mgr; ++j ) {
+      lk = std::unique_lock<manager>( *sptr_->get_secondary( j ) );
+      sptr = sptr_->get_secondary( j )->get_price( pkey );
+    }
+    if ( !sptr ) {
+      ++num_drop;
+    } else if ( is_sched ) {
+      psub_.add( sptr->get_sched(), sid );
+    } else {
+      psub_.add( sptr, sid );
+    }
+  }
+  rdr.get( num );
+  for( uint64_t i = 0; i != num && i != bin_max_idx; ++i ) {
+    bvec_.push_back( bin_price{ pub_key(), nullptr, nullptr } );
+    rdr.get( bvec_.back().acc_ );
+  }
+  rdr.get( num );
+  for( uint64_t i = 0; i != num && i != bin_max_idx; ++i ) {
+    pub_key pkey;
+    std::string txt;
+    rdr.get( pkey );
+    pkey.enc_base58( txt );
+    get_handle( str( txt.data(), txt.size() ) );
+  }
+
+  // bulk subscriptions
+  rdr.get( bsid_ );
+  rdr.get( bslot_ );
+  rdr.get( num );
+  for( uint64_t i = 0; i != num; ++i ) {
+    bulk_sub bsub;
+    uint64_t is_all = 0, num_px = 0, num_attr = 0;
+    if ( !rdr.get( bsub.sid_ ) || !rdr.get( is_all ) || !rdr.get( num_px ) ) {
+      return -1;
+    }
+    bsub.all_ = is_all != 0UL;
+    bool is_ok = true;
+    for( uint64_t j = 0; j != num_px; ++j ) {
+      pub_key pkey;
+      if ( !rdr.get( pkey ) ) {
+        return -1;
+      }
+      price *sptr = sptr_->get_price( pkey );
+      if ( sptr ) {
+        bsub.pvec_.push_back( sptr );
+      } else {
+        is_ok = false;
+      }
+    }
+    rdr.get( num_attr );
+    for( uint64_t j = 0; j != num_attr; ++j ) {
+      std::string key, val;
+      if ( !rdr.get( key ) || !rdr.get( val ) ) {
+        return -1;
+      }
+      bsub.avec_.push_back(
+          bulk_attr{ key, attr_id( str( key.data(), key.size() ) ), val } );
+    }
+    if ( !is_ok ) {
+      ++num_drop;
+      continue;
+    }
+    std::sort( bsub.pvec_.begin(), bsub.pvec_.end() );
+    if ( bsvec_.empty() ) {
+      sptr_->add_bulk_user( this );
+    }
+    bsvec_.emplace_back( std::move( bsub ) );
+  }
+  uint64_t is_dash = 0;
+  rdr.get( is_dash );
+  rdr.get( dsid_ );
+  if ( is_dash ) {
+    if ( bsvec_.empty() ) {
+      sptr_->add_bulk_user( this );
+    }
+    sptr_->get_dash_notify()->add_user( sptr_ );
+    dash_  = true;
+    dsync_ = true;
+  }
+  rdr.get( num );
+  for( uint64_t i = 0; i != num; ++i ) {
+    uint64_t sid = 0;
+    if ( rdr.get( sid ) && psub_.get( sid ) ) {
+      add_conflate( sid );
+    }
+  }
+  return rdr.get_is_end() ? num_drop : -1;
+}
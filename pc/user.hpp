@@ -5,18 +5,146 @@
 #include <pc/request.hpp>
 #include <pc/key_store.hpp>
 #include <pc/dbl_list.hpp>
+#include <mutex>
 
 namespace pc
 {
 
   class manager;
 
+  // binary publisher protocol enabled on a user connection with the
+  // enable_binary request. each binary websocket message is a bin_hdr
+  // followed by num_ update records, all little-endian and packed.
+  // records refer to price accounts by a connection-local index; a
+  // keyed record binds its index to the given account before updating
+  struct PC_PACKED bin_hdr
+  {
+    uint16_t     ver_;    // protocol version
+    uint16_t     flags_;  // bin_flag_key if records are bin_key_upd
+    uint32_t     num_;    // number of records
+    uint64_t     seq_;    // client sequence number returned in ack
+  };
+
+  struct PC_PACKED bin_upd
+  {
+    uint32_t     idx_;    // connection-local price account index
+    uint32_t     status_; // symbol_status
+    int64_t      price_;
+    uint64_t     conf_;
+  };
+
+  struct PC_PACKED bin_key_upd
+  {
+    bin_upd      upd_;
+    pc_pub_key_t key_;    // price account bound to upd_.idx_
+  };
+
+  // optional reply to each binary message
+  struct PC_PACKED bin_ack
+  {
+    uint64_t     seq_;    // sequence number of acknowledged message
+    uint32_t     num_;    // records queued for publishing
+    uint32_t     err_;    // records rejected (unknown account or status)
+  };
+
+  static const uint16_t bin_version  = 1;
+  static const uint16_t bin_flag_key = 0x1;
+  static const uint32_t bin_max_idx  = 65536;
+
+  // notify_price message body rendered once per aggregate update and
+  // shared by the send queues of all users subscribed to the price.
+  // the body ends at the subscription id, which each user appends
+  class price_notify
+  {
+  public:
+    price_notify();
+    ~price_notify();
+
+    // body for the latest update of price. valid until the next call
+    net_buf *get( price *, size_t& len );
+
+  private:
+    price_notify( const price_notify& );
+    price_notify& operator=( const price_notify& );
+
+    void dealloc();
+
+    price    *ptr_;   // price of rendered body
+    uint64_t  seq_;   // update sequence of rendered body
+    net_buf  *hd_;    // rendered body
+    size_t    len_;
+  };
+
+  // notify_dashboard message body rendered once per slot and shared by
+  // the send queues of all users subscribed to the dashboard feed.
+  // prices are referred to by their arena index and each message carries
+  // only the fields that changed since the previous one, along with the
+  // account of prices not notified before. the body ends at the
+  // subscription id, which each user appends
+  class dash_notify
+  {
+  public:
+    dash_notify();
+    ~dash_notify();
+
+    typedef std::vector<price*> price_vec_t;
+
+    // dashboard subscribers. the first one takes the current fields of
+    // all prices of the manager as the baseline for the deltas
+    void add_user( manager * );
+    void del_user();
+    unsigned get_num_user() const;
+
+    // render the changed fields of prices changed in slot. false and no
+    // body if none of their fields changed
+    bool update( const price_vec_t&, uint64_t slot );
+
+    // body rendered by the last update or nullptr. valid until the next
+    net_buf *get( size_t& len );
+
+    // all fields of all prices as last notified for a new subscriber or
+    // one that dropped a delta while backed-up
+    void write_snapshot( json_wtr& ) const;
+
+    // slot of last update
+    uint64_t get_slot() const;
+
+  private:
+    dash_notify( const dash_notify& );
+    dash_notify& operator=( const dash_notify& );
+
+    // fields of a price as last notified
+    struct rec {
+      price         *ptr_;   // or nullptr if not yet notified
+      int64_t        price_;
+      uint64_t       conf_;
+      int64_t        twap_;
+      uint64_t       twac_;
+      symbol_status  status_;
+      uint32_t       num_qt_;
+      uint64_t       valid_slot_;
+      uint64_t       pub_slot_;
+    };
+
+    typedef std::vector<rec> rec_vec_t;
+
+    rec& get_rec( price * );
+    void dealloc();
+
+    rec_vec_t rvec_;    // by price arena index
+    unsigned  num_usr_;
+    uint64_t  slot_;
+    net_buf  *hd_;      // rendered body
+    size_t    len_;
+  };
+
   // pyth daemon web-socket user connection
   class user : public prev_next<user>,
                public net_connect,
                public ws_parser,
                public request_sub,
                public request_sub_i<price>,
+               public request_sub_i<price_predict>,
                public request_sub_i<price_sched>
   {
   public:
@@ -40,9 +168,41 @@ namespace pc
     // symbol update callback
     void on_response( price *, uint64_t ) override;
 
+    // predicted aggregate callback
+    void on_response( price_predict *, uint64_t ) override;
+
     // symbol price schedule callback
     void on_response( price_sched *, uint64_t ) override;
 
+    typedef std::vector<price*> price_vec_t;
+
+    // prices changed in slot for bulk subscriptions (subscribe_prices
+    // and subscribe_all_prices). each bulk subscription gets at most one
+    // notify_prices message per call with its matching prices
+    void on_prices( const price_vec_t&, uint64_t slot );
+
+    // number of price, bulk price and dashboard feed subscriptions
+    size_t get_num_sub() const;
+
+    // send queue statistics since last reset
+    size_t get_max_send_size() const;
+    uint64_t get_num_conflate() const;
+    void reset_send_stats();
+
+    // send conflated notifications once the send queue has drained
+    // below the manager's user send limit and disconnect slow consumers
+    void poll_send_queue( int64_t ts );
+
+    // connection state for handing the connection over to another
+    // process. false if it cannot be moved (not a websocket or using
+    // permessage-deflate whose compression context cannot be carried)
+    bool save_state( std::string& ) const;
+
+    // resume a handed over websocket connection once accounts are
+    // mapped. returns the number of subscriptions dropped as their
+    // accounts are no longer known or -1 if the state is invalid
+    int restore_state( const std::string& );
+
   private:
 
     // http-only request parsing
@@ -56,15 +216,84 @@ namespace pc
       uint64_t sid_;
     };
 
+    // price account bound to a binary protocol index or a json handle
+    struct bin_price {
+      pub_key  acc_;
+      price   *sptr_;
+      price   *sptr2_;  // on a secondary network (if not on primary)
+    };
+
+    // product attribute value required by a bulk subscription. the
+    // attribute is looked up once products using it have been seen
+    struct bulk_attr {
+      std::string     key_;
+      mutable attr_id id_;
+      std::string     val_;
+    };
+
+    typedef std::vector<bulk_attr> attr_vec_t;
+
+    // bulk price subscription matching all prices, listed accounts
+    // and/or product attributes
+    struct bulk_sub {
+      uint64_t    sid_;
+      bool        all_;
+      price_vec_t pvec_;  // sorted listed prices
+      attr_vec_t  avec_;  // product attribute filter
+      price_vec_t pend_;  // matching prices not yet sent
+      bool match( price * ) const;
+    };
+
+    // account text interned as a json handle. text is zero-padded and
+    // longer text is not interned
+    struct acc_text {
+      uint64_t i_[6];
+      bool operator==( const acc_text& ) const;
+    };
+
+    struct trait_text {
+      typedef uint32_t        idx_t;
+      typedef acc_text        key_t;
+      typedef const acc_text& keyref_t;
+      typedef uint32_t        val_t;
+      struct hash_t {
+        idx_t operator() ( keyref_t a ) {
+          return static_cast< idx_t >( a.i_[0] ^ a.i_[1] );
+        }
+      };
+    };
+
+    typedef open_hash_map<trait_text> text_map_t;
     typedef std::vector<deferred_sub> def_vec_t;
+    typedef std::vector<bin_price>    bin_vec_t;
+    typedef std::vector<uint64_t>     sub_vec_t;
+    typedef std::vector<bool>         flag_vec_t;
+    typedef std::vector<bulk_sub>     bulk_vec_t;
 
-    void parse_request( uint32_t );
+    bool parse_request( uint32_t );
     void parse_get_product_list( uint32_t );
     void parse_get_product( uint32_t, uint32_t );
     void parse_get_all_products( uint32_t );
     void parse_upd_price( uint32_t,  uint32_t );
+    void parse_upd_prices( uint32_t,  uint32_t );
+    int  parse_upd_params( uint32_t );
     void parse_sub_price( uint32_t,  uint32_t );
     void parse_sub_price_sched( uint32_t,  uint32_t );
+    void parse_sub_prices( uint32_t,  uint32_t, bool all );
+    void parse_sub_dashboard( uint32_t );
+    void parse_enable_binary( uint32_t,  uint32_t );
+    void parse_get_price_handle( uint32_t,  uint32_t );
+    void parse_mcast_snapshot( uint32_t );
+    void parse_mcast_retransmit( uint32_t,  uint32_t );
+    void parse_set_capture( uint32_t,  uint32_t );
+    void parse_binary( const char *, size_t );
+    bool find_price( bin_price& );
+    bin_price *get_handle( str acc, uint32_t *hdl = nullptr );
+    price *find_secondary_price( const pub_key& );
+    manager *get_product_mgr( unsigned, std::unique_lock<manager>& );
+    void notify_price( price *, uint64_t sid );
+    void update_price( const bin_price&, int64_t, uint64_t,
+                       symbol_status );
     void add_header();
     void add_tail( uint32_t id );
     void add_parse_error();
@@ -72,6 +301,9 @@ namespace pc
     void add_invalid_params( uint32_t id );
     void add_unknown_symbol( uint32_t id );
     void add_error( uint32_t id, int err, str );
+    void add_conflate( uint64_t sid );
+    void send_bulk();
+    void send_dash();
 
     rpc_client     *rptr_;        // rpc manager api
     manager        *sptr_;        // manager collection
@@ -80,6 +312,31 @@ namespace pc
     json_wtr        jw_;          // json writer
     def_vec_t       dvec_;        // deferred subscriptions
     request_sub_set psub_;        // price subscriptions
+    bin_vec_t       bvec_;        // binary protocol index bindings
+    bin_vec_t       hvec_;        // json handle bindings
+    text_map_t      hmap_;        // json handle by account text
+    bin_price       hbp_;         // binding of text not interned
+    bulk_vec_t      bsvec_;       // bulk price subscriptions
+    uint64_t        bsid_;        // next bulk subscription id
+    uint64_t        bslot_;       // slot of latest bulk notification
+    uint64_t        dsid_;        // dashboard feed subscription id
+    sub_vec_t       cvec_;        // conflated subscriptions
+    flag_vec_t      cflag_;       // conflated flag by subscription
+    int64_t         slow_ts_;     // time send queue went over limit
+    int64_t         msg_ts_;      // time current message was received
+    size_t          max_wsz_;     // max send queue size
+    uint64_t        num_conf_;    // conflated notifications
+    bool            bin_;         // binary protocol enabled
+    bool            back_;        // binary protocol acks requested
+    bool            dash_;        // dashboard feed subscribed
+    bool            dsync_;       // dashboard snapshot owed
   };
 
+  inline bool user::acc_text::operator==( const acc_text& obj ) const
+  {
+    return i_[0] == obj.i_[0] && i_[1] == obj.i_[1] &&
+           i_[2] == obj.i_[2] && i_[3] == obj.i_[3] &&
+           i_[4] == obj.i_[4] && i_[5] == obj.i_[5];
+  }
+
 }
@@ -0,0 +1,110 @@
+#include "zstd_dict.hpp"
+#include "mem_map.hpp"
+#include <zstd.h>
+#include <zdict.h>
+
+using namespace pc;
+
+// base of dictionary ids reserved for account layouts
+static const uint32_t dict_id_base = 0x70630000;
+
+zstd_dict::zstd_dict()
+{
+}
+
+zstd_dict::~zstd_dict()
+{
+  for( entry& e: dvec_ ) {
+    ZSTD_freeDDict( (ZSTD_DDict*)e.ddict_ );
+    ZSTD_freeCDict( (ZSTD_CDict*)e.cdict_ );
+  }
+  dvec_.clear();
+}
+
+uint32_t zstd_dict::get_dict_id( uint32_t acc_type )
+{
+  return dict_id_base + acc_type;
+}
+
+bool zstd_dict::train( uint32_t acc_type,
+                       const std::vector<char>& samples,
+                       const std::vector<size_t>& sample_lens,
+                       size_t max_len,
+                       std::string& dict )
+{
+  dict.resize( max_len );
+  size_t len = ZDICT_trainFromBuffer(
+      &dict[0], max_len, samples.data(), sample_lens.data(),
+      static_cast< unsigned >( sample_lens.size() ) );
+  if ( ZDICT_isError( len ) ) {
+    dict.clear();
+    return set_err_msg( std::string( "failed to train dictionary: " ) +
+                        ZDICT_getErrorName( len ) );
+  }
+  dict.resize( len );
+
+  // replace random training id with that of the account type
+  uint32_t id = get_dict_id( acc_type );
+  __builtin_memcpy( &dict[sizeof( uint32_t )], &id, sizeof( id ) );
+  return true;
+}
+
+bool zstd_dict::add_file( const std::string& file )
+{
+  mem_map mp;
+  mp.set_file( file );
+  if ( !mp.init() ) {
+    return set_err_msg( "failed to read dictionary file=" + file );
+  }
+  if ( !add_dict( mp.data(), mp.size() ) ) {
+    return set_err_msg( get_err_msg() + " file=" + file );
+  }
+  return true;
+}
+
+bool zstd_dict::add_dict( const char *buf, size_t len )
+{
+  uint32_t id = ZDICT_getDictID( buf, len );
+  if ( id < dict_id_base || id > get_dict_id( 0xff ) ) {
+    return set_err_msg( "not an account dictionary" );
+  }
+  if ( get_ddict( id ) ) {
+    return set_err_msg( "duplicate dictionary id=" + std::to_string( id ) );
+  }
+  entry e;
+  e.id_    = id;
+  e.ddict_ = ZSTD_createDDict( buf, len );
+  e.cdict_ = ZSTD_createCDict( buf, len, level );
+  if ( !e.ddict_ || !e.cdict_ ) {
+    ZSTD_freeDDict( (ZSTD_DDict*)e.ddict_ );
+    ZSTD_freeCDict( (ZSTD_CDict*)e.cdict_ );
+    return set_err_msg( "failed to load dictionary" );
+  }
+  dvec_.push_back( e );
+  return true;
+}
+
+size_t zstd_dict::get_num() const
+{
+  return dvec_.size();
+}
+
+const void *zstd_dict::get_ddict( uint32_t dict_id ) const
+{
+  for( const entry& e: dvec_ ) {
+    if ( e.id_ == dict_id ) {
+      return e.ddict_;
+    }
+  }
+  return nullptr;
+}
+
+const void *zstd_dict::get_cdict( uint32_t acc_type ) const
+{
+  for( const entry& e: dvec_ ) {
+    if ( e.id_ == get_dict_id( acc_type ) ) {
+      return e.cdict_;
+    }
+  }
+  return nullptr;
+}
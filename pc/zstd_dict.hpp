@@ -0,0 +1,63 @@
+#pragma once
+
+#include <pc/error.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace pc
+{
+
+  // trained zstd dictionaries for on-chain account layouts. each account
+  // type gets a fixed dictionary id so that frames can be matched back to
+  // their dictionary on decompression
+  class zstd_dict : public error
+  {
+  public:
+
+    // compression level used with dictionaries
+    static const int level = 3;
+
+    zstd_dict();
+    ~zstd_dict();
+
+    // dictionary id of trained account type (PC_ACCTYPE_*)
+    static uint32_t get_dict_id( uint32_t acc_type );
+
+    // train dictionary for account type from concatenated samples
+    bool train( uint32_t acc_type,
+                const std::vector<char>& samples,
+                const std::vector<size_t>& sample_lens,
+                size_t max_len,
+                std::string& dict );
+
+    // load dictionary file
+    bool add_file( const std::string& file );
+
+    // load dictionary content
+    bool add_dict( const char *buf, size_t len );
+
+    // number of dictionaries loaded
+    size_t get_num() const;
+
+    // decompression dictionary (ZSTD_DDict) by frame dictionary id or null
+    const void *get_ddict( uint32_t dict_id ) const;
+
+    // compression dictionary (ZSTD_CDict) for account type or null
+    const void *get_cdict( uint32_t acc_type ) const;
+
+  private:
+
+    struct entry
+    {
+      uint32_t  id_;
+      void     *ddict_;
+      void     *cdict_;
+    };
+
+    typedef std::vector<entry> entry_t;
+
+    entry_t dvec_;
+  };
+
+}
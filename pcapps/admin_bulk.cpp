@@ -0,0 +1,487 @@
+#include "admin_bulk.hpp"
+#include <pc/manager.hpp>
+#include <pc/misc.hpp>
+#include <iostream>
+
+// resubmit delay of failed requests and how long to wait for the manager
+// to pick up an account created by an earlier operation
+#define PC_BULK_RETRY_INTERVAL (2L*PC_NSECS_IN_SEC)
+#define PC_BULK_WAIT_TIMEOUT   (120L*PC_NSECS_IN_SEC)
+
+using namespace pc;
+
+admin_bulk::admin_bulk()
+: mgr_( nullptr ),
+  cmt_( commitment::e_confirmed ),
+  expo_( -5 ),
+  max_run_( 16 ),
+  max_retry_( 3 ),
+  num_run_( 0 ),
+  num_add_( 0 ),
+  num_fail_( 0 ),
+  prod_rent_( 0UL ),
+  price_rent_( 0UL ),
+  map_rent_( 0UL ),
+  mreq_( nullptr ),
+  mptr_( nullptr )
+{
+}
+
+admin_bulk::~admin_bulk()
+{
+  for( op& o: ovec_ ) {
+    delete o.req_;
+  }
+  delete mreq_;
+}
+
+void admin_bulk::set_manager( manager *mgr )
+{
+  mgr_ = mgr;
+}
+
+void admin_bulk::set_commitment( commitment cmt )
+{
+  cmt_ = cmt;
+}
+
+void admin_bulk::set_exponent( int32_t expo )
+{
+  expo_ = expo;
+}
+
+void admin_bulk::set_max_inflight( unsigned max_run )
+{
+  max_run_ = max_run;
+}
+
+unsigned admin_bulk::get_max_inflight() const
+{
+  return max_run_;
+}
+
+void admin_bulk::set_max_retry( unsigned max_retry )
+{
+  max_retry_ = max_retry;
+}
+
+unsigned admin_bulk::get_max_retry() const
+{
+  return max_retry_;
+}
+
+unsigned admin_bulk::get_num_op() const
+{
+  return (unsigned)ovec_.size();
+}
+
+unsigned admin_bulk::get_num_op( str name ) const
+{
+  unsigned num = 0;
+  for( const op& o: ovec_ ) {
+    num += get_op_name( o.op_ ) == name;
+  }
+  return num;
+}
+
+str admin_bulk::get_op_name( op_t typ )
+{
+  switch( typ ) {
+    case e_add_product:   return "add_product";
+    case e_upd_product:   return "upd_product";
+    case e_add_price:     return "add_price";
+    case e_add_publisher: return "add_publisher";
+    case e_del_publisher: return "del_publisher";
+  }
+  return "unknown";
+}
+
+bool admin_bulk::init_from_json( jtree& pt, uint32_t hd )
+{
+  if ( hd == 0 || pt.get_type( hd ) != jtree::e_arr ) {
+    return set_err_msg( "bulk file is not a json list" );
+  }
+  for( uint32_t tok = pt.get_first( hd ); tok; tok = pt.get_next( tok ) ) {
+    if ( !parse_op( pt, tok ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+unsigned admin_bulk::new_op( op_t typ, unsigned dep )
+{
+  ovec_.resize( ovec_.size() + 1 );
+  op& o = ovec_.back();
+  o.op_        = typ;
+  o.st_        = e_wait;
+  o.dep_       = dep;
+  o.ptype_     = price_type::e_unknown;
+  o.expo_      = expo_;
+  o.num_retry_ = 0;
+  o.ts_        = 0L;
+  o.req_       = nullptr;
+  return (unsigned)ovec_.size() - 1;
+}
+
+bool admin_bulk::parse_op( jtree& pt, uint32_t tok )
+{
+  uint32_t nt = pt.find_val( tok, "op" );
+  str name = nt ? pt.get_str( nt ) : str( "upd_product" );
+  if ( name == "add_product" ) {
+    unsigned idx = new_op( e_add_product, (unsigned)-1 );
+    uint32_t at = pt.find_val( tok, "attr_dict" );
+    if ( at && !parse_upd_product( pt, at, idx ) ) {
+      return false;
+    }
+    uint32_t lt = pt.find_val( tok, "prices" );
+    for( uint32_t it = lt ? pt.get_first( lt ) : 0; it;
+         it = pt.get_next( it ) ) {
+      if ( !parse_add_price( pt, it, idx ) ) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if ( name == "upd_product" ) {
+    return parse_upd_product( pt, pt.find_val( tok, "attr_dict" ),
+        (unsigned)-1, pt.find_val( tok, "account" ) );
+  }
+  if ( name == "add_price" ) {
+    return parse_add_price( pt, tok, (unsigned)-1 );
+  }
+  if ( name == "add_publisher" || name == "del_publisher" ) {
+    return parse_publisher( pt, pt.find_val( tok, "publisher" ),
+        name == "add_publisher" ? e_add_publisher : e_del_publisher,
+        (unsigned)-1, pt.find_val( tok, "price" ) );
+  }
+  return set_err_msg( "unknown bulk op=" + name.as_string() );
+}
+
+bool admin_bulk::parse_upd_product(
+    jtree& pt, uint32_t at, unsigned dep, uint32_t kt )
+{
+  op& o = ovec_[new_op( e_upd_product, dep )];
+  if ( !at || !o.adict_.init_from_json( pt, at ) ||
+       ( dep == (unsigned)-1 &&
+         ( !kt || !o.acc_.init_from_text( pt.get_str( kt ) ) ) ) ) {
+    return set_err_msg( "missing/invalid account/attr_dict for "
+                        "upd_product" );
+  }
+  return true;
+}
+
+bool admin_bulk::parse_add_price( jtree& pt, uint32_t tok, unsigned dep )
+{
+  unsigned idx = new_op( e_add_price, dep );
+  op& o = ovec_[idx];
+  uint32_t tt = pt.find_val( tok, "price_type" );
+  uint32_t et = pt.find_val( tok, "exponent" );
+  uint32_t kt = pt.find_val( tok, "product" );
+  o.ptype_ = tt ? str_to_price_type( pt.get_str( tt ) ) : price_type::e_price;
+  if ( et ) {
+    o.expo_ = (int32_t)pt.get_int( et );
+  }
+  if ( o.ptype_ == price_type::e_unknown ||
+       ( dep == (unsigned)-1 &&
+         ( !kt || !o.acc_.init_from_text( pt.get_str( kt ) ) ) ) ) {
+    return set_err_msg( "missing/invalid product/price_type for "
+                        "add_price" );
+  }
+  uint32_t lt = pt.find_val( tok, "publishers" );
+  for( uint32_t it = lt ? pt.get_first( lt ) : 0; it;
+       it = pt.get_next( it ) ) {
+    if ( !parse_publisher( pt, it, e_add_publisher, idx ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool admin_bulk::parse_publisher(
+    jtree& pt, uint32_t ut, op_t typ, unsigned dep, uint32_t kt )
+{
+  op& o = ovec_[new_op( typ, dep )];
+  if ( !ut || !o.pub_.init_from_text( pt.get_str( ut ) ) ||
+       ( dep == (unsigned)-1 &&
+         ( !kt || !o.acc_.init_from_text( pt.get_str( kt ) ) ) ) ) {
+    return set_err_msg( "missing/invalid price/publisher for " +
+                        get_op_name( typ ).as_string() );
+  }
+  return true;
+}
+
+bool admin_bulk::get_lamports( size_t sz, uint64_t& lamports )
+{
+  get_minimum_balance_rent_exemption req[1];
+  req->set_size( sz );
+  if ( !mgr_->submit_poll( req ) ) {
+    return set_err_msg( "failed to get rent exemption amount" );
+  }
+  lamports = req->get_lamports();
+  return true;
+}
+
+int admin_bulk::get_num_free() const
+{
+  // products added to the mapping in flight. completed ones may not yet
+  // be reflected in the mapping so this can over-allocate, in which case
+  // the program rejects the add and it is retried on the next mapping
+  get_mapping *mptr = mgr_->get_last_mapping();
+  if ( !mptr ) {
+    return 0;
+  }
+  return (int)PC_MAP_TABLE_SIZE - (int)mptr->get_num_symbols() -
+         (int)num_add_;
+}
+
+void admin_bulk::upd_mapping()
+{
+  // start a new mapping account once the last one is full
+  if ( mreq_ ) {
+    if ( mreq_->get_is_err() ) {
+      std::string emsg = "failed to add mapping account: " +
+                         mreq_->get_err_msg();
+      for( op& o: ovec_ ) {
+        if ( o.op_ == e_add_product && o.st_ != e_done && o.st_ != e_fail &&
+             o.st_ != e_run ) {
+          fail( o, emsg );
+        }
+      }
+    } else if ( !mreq_->get_is_done() ||
+                mgr_->get_last_mapping() == mptr_ ) {
+      return;
+    }
+    delete mreq_;
+    mreq_ = nullptr;
+    return;
+  }
+  if ( num_add_ || get_num_free() > 0 ) {
+    return;
+  }
+  get_mapping *mptr = mgr_->get_last_mapping();
+  if ( !mptr || !mptr->get_is_full() ) {
+    return;
+  }
+  for( const op& o: ovec_ ) {
+    if ( o.op_ == e_add_product && ( o.st_ == e_wait || o.st_ == e_retry ) ) {
+      mptr_ = mptr;
+      mreq_ = new add_mapping;
+      mreq_->set_lamports( map_rent_ );
+      mreq_->set_commitment( commitment::e_finalized );
+      mgr_->submit( mreq_ );
+      return;
+    }
+  }
+}
+
+bool admin_bulk::start( op& o )
+{
+  int64_t ts = get_now();
+  if ( o.st_ == e_retry && ts < o.ts_ ) {
+    return false;
+  }
+
+  // account created by an earlier operation
+  bool is_dep = o.dep_ != (unsigned)-1;
+  if ( is_dep ) {
+    const op& d = ovec_[o.dep_];
+    if ( d.st_ == e_fail ) {
+      fail( o, get_op_name( d.op_ ).as_string() + " failed" );
+      return false;
+    }
+    if ( d.st_ != e_done ) {
+      return false;
+    }
+    o.acc_ = d.acc_;
+  }
+
+  // wait for the manager to pick up new accounts
+  product *prod = nullptr;
+  price   *px   = nullptr;
+  if ( o.op_ == e_upd_product || o.op_ == e_add_price ) {
+    prod = mgr_->get_product( o.acc_ );
+  } else if ( o.op_ != e_add_product ) {
+    px = mgr_->get_price( o.acc_ );
+  }
+  if ( o.op_ != e_add_product && !prod && ( !px || !px->get_is_done() ) ) {
+    std::string knm;
+    o.acc_.enc_base58( knm );
+    if ( !is_dep ) {
+      fail( o, "failed to find account=" + knm );
+    } else if ( !o.ts_ ) {
+      o.ts_ = ts;
+    } else if ( ts - o.ts_ > PC_BULK_WAIT_TIMEOUT ) {
+      fail( o, "timed out waiting for account=" + knm );
+    }
+    return false;
+  }
+
+  switch( o.op_ ) {
+    case e_add_product: {
+      if ( get_num_free() <= 0 ) {
+        return false;
+      }
+      add_product *req = dynamic_cast<add_product*>( o.req_ );
+      if ( req ) {
+        req->reset();
+      } else {
+        o.req_ = req = new add_product;
+        req->set_lamports( prod_rent_ );
+        req->set_commitment( cmt_ );
+      }
+      ++num_add_;
+      break;
+    }
+    case e_upd_product: {
+      upd_product *req = dynamic_cast<upd_product*>( o.req_ );
+      if ( req ) {
+        req->reset();
+      } else {
+        o.req_ = req = new upd_product;
+        req->set_attr_dict( &o.adict_ );
+        req->set_commitment( cmt_ );
+      }
+      req->set_product( prod );
+      break;
+    }
+    case e_add_price: {
+      add_price *req = dynamic_cast<add_price*>( o.req_ );
+      if ( req ) {
+        req->reset();
+      } else {
+        o.req_ = req = new add_price;
+        req->set_exponent( o.expo_ );
+        req->set_price_type( o.ptype_ );
+        req->set_lamports( price_rent_ );
+        req->set_commitment( cmt_ );
+      }
+      req->set_product( prod );
+      break;
+    }
+    case e_add_publisher: {
+      add_publisher *req = dynamic_cast<add_publisher*>( o.req_ );
+      if ( req ) {
+        req->reset();
+      } else {
+        o.req_ = req = new add_publisher;
+        req->set_publisher( o.pub_ );
+        req->set_commitment( cmt_ );
+      }
+      req->set_price( px );
+      break;
+    }
+    case e_del_publisher: {
+      del_publisher *req = dynamic_cast<del_publisher*>( o.req_ );
+      if ( req ) {
+        req->reset();
+      } else {
+        o.req_ = req = new del_publisher;
+        req->set_publisher( o.pub_ );
+        req->set_commitment( cmt_ );
+      }
+      req->set_price( px );
+      break;
+    }
+  }
+  o.st_ = e_run;
+  ++num_run_;
+  mgr_->submit( o.req_ );
+  return true;
+}
+
+void admin_bulk::check( op& o, int64_t ts )
+{
+  request *req = o.req_;
+  bool is_err = req->get_is_err();
+  if ( !is_err && !req->get_is_done() ) {
+    return;
+  }
+  --num_run_;
+  if ( o.op_ == e_add_product ) {
+    --num_add_;
+  }
+  if ( is_err ) {
+    if ( o.num_retry_ == max_retry_ ) {
+      fail( o, req->get_err_msg() );
+      return;
+    }
+    ++o.num_retry_;
+    o.st_ = e_retry;
+    o.ts_ = ts + PC_BULK_RETRY_INTERVAL;
+    std::cerr << "pyth_admin: " << get_op_name( o.op_ ).as_string()
+              << " failed, retrying: " << req->get_err_msg() << std::endl;
+    return;
+  }
+  o.st_ = e_done;
+  o.ts_ = 0L;
+
+  // report new accounts
+  std::string knm;
+  if ( o.op_ == e_add_product ) {
+    o.acc_ = pub_key( *dynamic_cast<add_product*>( req )->get_account() );
+    o.acc_.enc_base58( knm );
+    std::cout << "add_product " << knm << std::endl;
+  } else if ( o.op_ == e_add_price ) {
+    std::string pnm;
+    o.acc_.enc_base58( pnm );
+    o.acc_ = pub_key( *dynamic_cast<add_price*>( req )->get_account() );
+    o.acc_.enc_base58( knm );
+    std::cout << "add_price " << knm << " " << pnm << " "
+              << price_type_to_str( o.ptype_ ).as_string() << std::endl;
+  }
+}
+
+void admin_bulk::fail( op& o, const std::string& emsg )
+{
+  o.st_ = e_fail;
+  ++num_fail_;
+  std::string knm;
+  o.acc_.enc_base58( knm );
+  std::cerr << "pyth_admin: " << get_op_name( o.op_ ).as_string()
+            << " account=" << knm << " failed: " << emsg << std::endl;
+}
+
+bool admin_bulk::run()
+{
+  // rent exemption amounts of the accounts we create
+  unsigned num_prod = get_num_op( "add_product" );
+  if ( num_prod && ( !get_lamports( PC_PROD_ACC_SIZE, prod_rent_ ) ||
+                     !get_lamports( sizeof( pc_map_table_t ), map_rent_ ) ) ) {
+    return false;
+  }
+  if ( get_num_op( "add_price" ) &&
+       !get_lamports( sizeof( pc_price_t ), price_rent_ ) ) {
+    return false;
+  }
+
+  // submit operations as they become ready and the in-flight window
+  // allows until all of them completed or failed
+  for(;;) {
+    int64_t ts = get_now();
+    upd_mapping();
+    unsigned num_left = 0;
+    for( op& o: ovec_ ) {
+      if ( o.st_ == e_run ) {
+        check( o, ts );
+      }
+      if ( ( o.st_ == e_wait || o.st_ == e_retry ) && num_run_ < max_run_ ) {
+        start( o );
+      }
+      num_left += o.st_ != e_done && o.st_ != e_fail;
+    }
+    if ( !num_left ) {
+      break;
+    }
+    if ( mgr_->get_is_err() ) {
+      return set_err_msg( mgr_->get_err_msg() );
+    }
+    mgr_->poll();
+  }
+  if ( num_fail_ ) {
+    return set_err_msg( std::to_string( num_fail_ ) + " of " +
+                        std::to_string( ovec_.size() ) +
+                        " operations failed" );
+  }
+  return true;
+}
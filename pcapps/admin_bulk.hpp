@@ -0,0 +1,112 @@
+#pragma once
+
+#include "admin_request.hpp"
+#include <pc/jtree.hpp>
+#include <vector>
+
+namespace pc
+{
+
+  // run the admin operations of a bulk file concurrently instead of one
+  // request at a time. operations whose account is created by an earlier
+  // operation (for example publishers of a new price) wait for it to
+  // complete and to be picked up by the manager. at most a fixed number
+  // of requests are in flight and failed requests are resubmitted
+  class admin_bulk : public error
+  {
+  public:
+
+    admin_bulk();
+    ~admin_bulk();
+
+    // manager connected to the chain (after bootstrap)
+    void set_manager( manager * );
+
+    // commitment level of the admin transactions
+    void set_commitment( commitment );
+
+    // exponent of new prices that do not specify one
+    void set_exponent( int32_t );
+
+    // maximum number of requests in flight (default 16)
+    void set_max_inflight( unsigned );
+    unsigned get_max_inflight() const;
+
+    // number of times a failed request is resubmitted (default 3)
+    void set_max_retry( unsigned );
+    unsigned get_max_retry() const;
+
+    // add operations from a json list. each entry has an "op" of
+    // add_product (with optional attr_dict and prices), upd_product,
+    // add_price (with optional publishers), add_publisher or
+    // del_publisher. entries without an op are upd_product entries as in
+    // a product.json file. the parse tree must outlive run()
+    bool init_from_json( jtree&, uint32_t tok = 1 );
+
+    // number of operations
+    unsigned get_num_op() const;
+
+    // number of operations of each kind
+    unsigned get_num_op( str op ) const;
+
+    // run operations to completion. false if any of them failed
+    bool run();
+
+  private:
+
+    typedef enum {
+      e_add_product, e_upd_product, e_add_price,
+      e_add_publisher, e_del_publisher } op_t;
+
+    typedef enum { e_wait, e_run, e_retry, e_done, e_fail } state_t;
+
+    struct op
+    {
+      op_t        op_;
+      state_t     st_;
+      unsigned    dep_;       // operation creating acc_ or -1
+      pub_key     acc_;       // product or price account
+      pub_key     pub_;       // publisher
+      price_type  ptype_;
+      int32_t     expo_;
+      attr_dict   adict_;
+      unsigned    num_retry_;
+      int64_t     ts_;        // time to resubmit
+      request    *req_;
+    };
+
+    typedef std::vector<op> op_vec_t;
+
+    static str get_op_name( op_t );
+
+    unsigned new_op( op_t, unsigned dep );
+    bool parse_op( jtree&, uint32_t tok );
+    bool parse_upd_product( jtree&, uint32_t attr_tok, unsigned dep,
+                          uint32_t acc_tok = 0 );
+    bool parse_add_price( jtree&, uint32_t tok, unsigned dep );
+    bool parse_publisher( jtree&, uint32_t pub_tok, op_t, unsigned dep,
+                        uint32_t acc_tok = 0 );
+    bool get_lamports( size_t sz, uint64_t& );
+    bool start( op& );
+    void check( op&, int64_t ts );
+    void fail( op&, const std::string& );
+    void upd_mapping();
+    int  get_num_free() const;
+
+    manager       *mgr_;
+    commitment     cmt_;
+    int32_t        expo_;
+    unsigned       max_run_;
+    unsigned       max_retry_;
+    unsigned       num_run_;      // requests in flight
+    unsigned       num_add_;      // add_product requests in flight
+    unsigned       num_fail_;
+    uint64_t       prod_rent_;    // rent exempt lamports by account type
+    uint64_t       price_rent_;
+    uint64_t       map_rent_;
+    add_mapping   *mreq_;         // mapping account in creation or null
+    get_mapping   *mptr_;         // last mapping at add_mapping
+    op_vec_t       ovec_;
+  };
+
+}
@@ -258,7 +258,8 @@ bool add_mapping::get_is_done() const
 
 add_product::add_product()
 : st_( e_create_sent ),
-  cmt_( commitment::e_confirmed )
+  cmt_( commitment::e_confirmed ),
+  has_acc_( false )
 {
 }
 
@@ -277,6 +278,12 @@ key_pair *add_product::get_account()
   return &akey_;
 }
 
+void add_product::reset()
+{
+  reset_err();
+  st_ = e_create_sent;
+}
+
 bool add_product::get_is_ready()
 {
   manager *cptr = get_manager();
@@ -324,7 +331,7 @@ void add_product::submit()
         cptr->get_program_pub_key_file() + "]", this );
     return;
   }
-  if ( !cptr->create_account_key_pair( akey_ ) ) {
+  if ( !has_acc_ && !cptr->create_account_key_pair( akey_ ) ) {
     on_error_sub( "failed to create new symbol key_pair", this );
     return;
   }
@@ -340,6 +347,12 @@ void add_product::submit()
   sig_->set_sub( this );
 
   // get recent block hash and submit request
+  if ( has_acc_ ) {
+    st_ = e_add_sent;
+    sreq_->set_block_hash( get_manager()->get_recent_block_hash() );
+    get_rpc_client()->send( sreq_ );
+    return;
+  }
   st_ = e_create_sent;
   areq_->set_block_hash( get_manager()->get_recent_block_hash() );
   get_rpc_client()->send( areq_ );
@@ -365,6 +378,7 @@ void add_product::on_response( rpc::signature_subscribe *res )
     on_error_sub( res->get_err_msg(), this );
     st_ = e_error;
   } else if ( st_ == e_create_sig ) {
+    has_acc_ = true;
     st_ = e_add_sent;
     sreq_->set_block_hash( get_manager()->get_recent_block_hash() );
     get_rpc_client()->send( sreq_ );
@@ -503,7 +517,9 @@ bool upd_product::get_is_done() const
 
 add_price::add_price()
 : st_( e_create_sent ),
-  cmt_( commitment::e_confirmed )
+  cmt_( commitment::e_confirmed ),
+  has_acc_( false ),
+  prod_( nullptr )
 {
 }
 
@@ -537,6 +553,12 @@ key_pair *add_price::get_account()
   return &akey_;
 }
 
+void add_price::reset()
+{
+  reset_err();
+  st_ = e_create_sent;
+}
+
 bool add_price::get_is_ready()
 {
   manager *cptr = get_manager();
@@ -575,7 +597,7 @@ void add_price::submit()
     on_error_sub( "missing key pair for product acct [" + knm + "]", this);
     return;
   }
-  if ( !cptr->create_account_key_pair( akey_ ) ) {
+  if ( !has_acc_ && !cptr->create_account_key_pair( akey_ ) ) {
     on_error_sub( "failed to create new symbol key_pair", this );
     return;
   }
@@ -592,6 +614,12 @@ void add_price::submit()
   sig_->set_sub( this );
 
   // get recent block hash and submit request
+  if ( has_acc_ ) {
+    st_ = e_add_sent;
+    sreq_->set_block_hash( get_manager()->get_recent_block_hash() );
+    get_rpc_client()->send( sreq_ );
+    return;
+  }
   st_ = e_create_sent;
   areq_->set_block_hash( get_manager()->get_recent_block_hash() );
   get_rpc_client()->send( areq_ );
@@ -617,6 +645,7 @@ void add_price::on_response( rpc::signature_subscribe *res )
     on_error_sub( res->get_err_msg(), this );
     st_ = e_error;
   } else if ( st_ == e_create_sig ) {
+    has_acc_ = true;
     st_ = e_add_sent;
     sreq_->set_block_hash( get_manager()->get_recent_block_hash() );
     get_rpc_client()->send( sreq_ );
@@ -868,6 +897,12 @@ void add_publisher::set_commitment( commitment cmt )
   cmt_ = cmt;
 }
 
+void add_publisher::reset()
+{
+  reset_err();
+  st_ = e_add_sent;
+}
+
 bool add_publisher::get_is_ready()
 {
   manager *cptr = get_manager();
@@ -974,6 +1009,12 @@ void del_publisher::set_commitment( commitment cmt )
   cmt_ = cmt;
 }
 
+void del_publisher::reset()
+{
+  reset_err();
+  st_ = e_add_sent;
+}
+
 bool del_publisher::get_is_ready()
 {
   manager *cptr = get_manager();
@@ -88,6 +88,10 @@ namespace pc
     bool get_is_done() const override;
     key_pair *get_account();
 
+    // clear error for resubmission. an account that was already
+    // created is reused rather than created again
+    void reset();
+
   public:
     void on_response( rpc::create_account * ) override;
     void on_response( rpc::signature_subscribe * ) override;
@@ -105,6 +109,7 @@ namespace pc
 
     state_t                  st_;
     commitment               cmt_;
+    bool                     has_acc_;
     key_pair                 akey_;
     key_pair                 mkey_;
     rpc::create_account      areq_[1];
@@ -162,6 +167,10 @@ namespace pc
     bool get_is_done() const override;
     key_pair *get_account();
 
+    // clear error for resubmission. an account that was already
+    // created is reused rather than created again
+    void reset();
+
   public:
     void on_response( rpc::create_account * ) override;
     void on_response( rpc::signature_subscribe * ) override;
@@ -179,6 +188,7 @@ namespace pc
 
     state_t                  st_;
     commitment               cmt_;
+    bool                     has_acc_;
     product                 *prod_;
     key_pair                 akey_;
     key_pair                 mkey_;
@@ -265,6 +275,9 @@ namespace pc
     void set_commitment( commitment );
     bool get_is_done() const override;
 
+    // clear error for resubmission
+    void reset();
+
   public:
     void on_response( rpc::add_publisher * ) override;
     void on_response( rpc::signature_subscribe * ) override;
@@ -298,6 +311,9 @@ namespace pc
     void set_commitment( commitment );
     bool get_is_done() const override;
 
+    // clear error for resubmission
+    void reset();
+
   public:
     void on_response( rpc::del_publisher * ) override;
     void on_response( rpc::signature_subscribe * ) override;
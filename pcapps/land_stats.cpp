@@ -0,0 +1,115 @@
+#include "land_stats.hpp"
+
+// slots kept waiting on reports and the age at which they are scored
+#define PC_LAND_SLOTS 256
+#define PC_LAND_DELAY 32
+
+using namespace pc;
+
+land_stats::land_stats()
+: decay_( 1./32. ),
+  min_num_( 8. ),
+  num_slot_( 0UL ),
+  num_land_( 0UL ),
+  svec_( PC_LAND_SLOTS )
+{
+  for( slot_info& si: svec_ ) {
+    si.slot_ = 0UL;
+    si.is_sent_ = si.is_land_ = false;
+  }
+}
+
+void land_stats::set_decay( double decay )
+{
+  decay_ = decay;
+}
+
+double land_stats::get_decay() const
+{
+  return decay_;
+}
+
+void land_stats::set_min_slots( double num )
+{
+  min_num_ = num;
+}
+
+double land_stats::get_min_slots() const
+{
+  return min_num_;
+}
+
+uint64_t land_stats::get_num_slots() const
+{
+  return num_slot_;
+}
+
+uint64_t land_stats::get_num_land() const
+{
+  return num_land_;
+}
+
+land_stats::slot_info& land_stats::get_slot( uint64_t slot )
+{
+  // a slot still waiting is scored before its entry is reused
+  slot_info& si = svec_[slot%svec_.size()];
+  if ( si.slot_ != slot ) {
+    score( si );
+    si.slot_ = slot;
+    si.is_sent_ = si.is_land_ = false;
+  }
+  return si;
+}
+
+void land_stats::add_sent( uint64_t slot, const pub_key& ldr )
+{
+  slot_info& si = get_slot( slot );
+  if ( si.is_sent_ ) {
+    return;
+  }
+  ldr_map_t::iter_t it = lmap_.find( ldr );
+  if ( !it ) {
+    it = lmap_.add( ldr );
+    lmap_.ref( it ) = static_cast< uint32_t >( lvec_.size() );
+    lvec_.push_back( leader{ 0., 0. } );
+  }
+  si.ldr_ = lmap_.obj( it );
+  si.is_sent_ = true;
+}
+
+void land_stats::add_land( uint64_t slot )
+{
+  get_slot( slot ).is_land_ = true;
+}
+
+void land_stats::add_slot( uint64_t curr_slot )
+{
+  for( slot_info& si: svec_ ) {
+    if ( si.slot_ + PC_LAND_DELAY < curr_slot ) {
+      score( si );
+    }
+  }
+}
+
+void land_stats::score( slot_info& si )
+{
+  if ( !si.is_sent_ ) {
+    return;
+  }
+  leader& ld = lvec_[si.ldr_];
+  ld.num_  = ld.num_ * ( 1. - decay_ ) + 1.;
+  ld.land_ = ld.land_ * ( 1. - decay_ ) + ( si.is_land_ ? 1. : 0. );
+  ++num_slot_;
+  num_land_ += si.is_land_;
+  si.is_sent_ = si.is_land_ = false;
+}
+
+double land_stats::get_rate( const pub_key& ldr )
+{
+  ldr_map_t::iter_t it = lmap_.find( ldr );
+  if ( !it ) {
+    return -1.;
+  }
+  const leader& ld = lvec_[lmap_.obj( it )];
+  return ld.num_ < min_num_ ? -1. : ld.land_ / ld.num_;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <pc/key_pair.hpp>
+#include <pc/hash_map.hpp>
+#include <vector>
+
+namespace pc
+{
+
+  // online landing statistics of slot leaders (cf. pctest/leader_stats).
+  // a slot is targeted when transactions were forwarded to its leader
+  // and landed when a connected pythd reports a price update that landed
+  // in it. slots are scored once no more reports are expected and the
+  // rates are exponentially decayed so that they follow the validator
+  class land_stats
+  {
+  public:
+
+    land_stats();
+
+    // weight of the latest slot in the decayed rates (default 1/32)
+    void set_decay( double );
+    double get_decay() const;
+
+    // decayed number of targeted slots before a rate is known
+    // (default 8)
+    void set_min_slots( double );
+    double get_min_slots() const;
+
+    // transactions were forwarded to leader of slot
+    void add_sent( uint64_t slot, const pub_key& leader );
+
+    // price update landed in slot
+    void add_land( uint64_t slot );
+
+    // score slots that are too old for further reports
+    void add_slot( uint64_t curr_slot );
+
+    // landing rate of leader in [0,1] or -1 if not known
+    double get_rate( const pub_key& );
+
+    // slots scored and landed in since start
+    uint64_t get_num_slots() const;
+    uint64_t get_num_land() const;
+
+  private:
+
+    struct leader {
+      double   num_;   // decayed targeted slots
+      double   land_;  // decayed landed slots
+    };
+
+    struct slot_info {
+      uint64_t slot_;
+      uint32_t ldr_;   // leader index
+      bool     is_sent_;
+      bool     is_land_;
+    };
+
+    struct trait_leader {
+      static const size_t hsize_ = 859UL;
+      typedef uint32_t        idx_t;
+      typedef pub_key         key_t;
+      typedef const pub_key&  keyref_t;
+      typedef uint32_t        val_t;
+      struct hash_t {
+        idx_t operator() ( keyref_t a ) {
+          uint64_t *i = (uint64_t*)a.data();
+          return *i;
+        }
+      };
+    };
+
+    typedef open_hash_map<trait_leader> ldr_map_t;
+    typedef std::vector<leader>         ldr_vec_t;
+    typedef std::vector<slot_info>      slot_vec_t;
+
+    slot_info& get_slot( uint64_t );
+    void score( slot_info& );
+
+    double     decay_;
+    double     min_num_;
+    uint64_t   num_slot_;
+    uint64_t   num_land_;
+    ldr_map_t  lmap_;    // leader index by identity
+    ldr_vec_t  lvec_;
+    slot_vec_t svec_;    // recent slots by slot modulo size
+  };
+
+}
@@ -1,3 +1,4 @@
+#include "admin_bulk.hpp"
 #include "admin_request.hpp"
 #include <pc/manager.hpp>
 #include <pc/log.hpp>
@@ -32,6 +33,7 @@ int usage()
   cerr << "  add_publisher    <pub_key> <price_key> [options]" << endl;
   cerr << "  del_publisher    <pub_key> <price_key> [options]" << endl;
   cerr << "  upd_product      <product.json> [options]" << endl;
+  cerr << "  bulk             <bulk.json> [options]" << endl;
   cerr << "  version" << endl;
   cerr << endl;
 
@@ -46,6 +48,11 @@ int usage()
   cerr << "     Options include processed, confirmed and finalized\n" << endl;
   cerr << "  -d" << endl;
   cerr << "     Turn on debug logging\n" << endl;
+  cerr << "  -w <max_inflight (default 16)>" << endl;
+  cerr << "     Number of bulk requests run concurrently\n" << endl;
+  cerr << "  -t <max_retry (default 3)>" << endl;
+  cerr << "     Number of times a failed bulk request is resubmitted\n"
+       << endl;
   cerr << "  -h" << endl;
   cerr << "     Output this help text\n" << endl;
   return 1;
@@ -62,12 +69,14 @@ struct pyth_arguments
   int          exponent_   = DEFAULT_EXPONENT;
   uint8_t      min_pub_    = 0;
   bool         do_prompt_  = true;
+  unsigned     max_run_    = 16;
+  unsigned     max_retry_  = 3;
 };
 
 pyth_arguments::pyth_arguments( int argc, char **argv )
 {
   int opt = 0;
-  while ( (opt = ::getopt( argc, argv, "r:k:c:de:m:nh" )) != -1 ) {
+  while ( (opt = ::getopt( argc, argv, "r:k:c:de:m:nw:t:h" )) != -1 ) {
     switch (opt) {
       case 'r': rpc_host_ = optarg; break;
       case 'k': key_dir_ = optarg; break;
@@ -93,6 +102,8 @@ pyth_arguments::pyth_arguments( int argc, char **argv )
         break;
       }
       case 'n': do_prompt_ = false; break;
+      case 'w': max_run_ = (unsigned)::atoi( optarg ); break;
+      case 't': max_retry_ = (unsigned)::atoi( optarg ); break;
       default:
         usage();
         invalid_ = true;
@@ -315,6 +326,87 @@ int on_upd_product( int argc, char **argv )
   return 0;
 }
 
+int on_bulk( int argc, char **argv )
+{
+  // get bulk file name
+  if ( argc < 2 ) {
+    return usage();
+  }
+  jtree   pt;
+  mem_map cfg;
+  cfg.set_file( argv[1] );
+  argc -= 1;
+  argv += 1;
+
+  pyth_arguments args( argc, argv );
+  if ( args.invalid_ )
+    return 1;
+  if ( !args.max_run_ ) {
+    std::cerr << "pyth_admin: max inflight must be positive" << std::endl;
+    return 1;
+  }
+
+  // parse bulk file
+  if ( !cfg.init() ) {
+    std::cerr << "pyth_admin: failed to read file=" << cfg.get_file() << std::endl;
+    return 1;
+  }
+  pt.parse( cfg.data(), cfg.size() );
+  if ( !pt.is_valid() ) {
+    std::cerr << "pyth_admin: failed to parse file=" <<cfg.get_file() << std::endl;
+    return 1;
+  }
+  admin_bulk blk;
+  blk.set_commitment( args.cmt_ );
+  blk.set_exponent( args.exponent_ );
+  blk.set_max_inflight( args.max_run_ );
+  blk.set_max_retry( args.max_retry_ );
+  if ( !blk.init_from_json( pt ) ) {
+    std::cerr << "pyth_admin: " << blk.get_err_msg() << " in file="
+              << cfg.get_file() << std::endl;
+    return 1;
+  }
+
+  // are you sure prompt
+  if ( args.do_prompt_ ) {
+    std::cout << "running bulk operations:" << std::endl;
+    for( const char *op: { "add_product", "upd_product", "add_price",
+                           "add_publisher", "del_publisher" } ) {
+      if ( unsigned num = blk.get_num_op( op ) ) {
+        print_val( op, 2 );
+        std::cout << num << std::endl;
+      }
+    }
+    print_val( "max_inflight", 2 );
+    std::cout << blk.get_max_inflight() << std::endl;
+    std::cout << "are you sure? [y/n] ";
+    char ch;
+    std::cin >> ch;
+    if ( ch != 'y' && ch != 'Y' ) {
+      return 1;
+    }
+  }
+
+  // initialize connection to block-chain
+  manager mgr;
+  mgr.set_rpc_host( args.rpc_host_ );
+  mgr.set_dir( args.key_dir_ );
+  mgr.set_do_tx( false );
+  mgr.set_commitment( args.cmt_ );
+  if ( !mgr.init() || !mgr.bootstrap() ) {
+    std::cerr << "pyth_admin: " << mgr.get_err_msg() << std::endl;
+    return 1;
+  }
+
+  // run operations
+  blk.set_manager( &mgr );
+  if ( !blk.run() ) {
+    std::cerr << "pyth_admin: " << blk.get_err_msg() << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
 int on_add_price( int argc, char **argv )
 {
   // get input parameters
@@ -640,6 +732,8 @@ int main(int argc, char **argv)
     rc = on_upd_publisher( argc, argv, false );
   } else if ( cmd == "upd_product" ) {
     rc = on_upd_product( argc, argv );
+  } else if ( cmd == "bulk" ) {
+    rc = on_bulk( argc, argv );
   } else if ( cmd == "version" ) {
     std::cout << "version: " << PC_VERSION << std::endl;
   } else {
@@ -1,9 +1,13 @@
 #include <pc/replay.hpp>
+#include <pc/col_file.hpp>
 #include <pc/rpc_client.hpp>
 #include <pc/misc.hpp>
 #include <unistd.h>
 #include <signal.h>
+#include <atomic>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 using namespace pc;
 
@@ -13,6 +17,7 @@ class csv_print
 public:
 
   csv_print();
+  virtual ~csv_print();
 
   // print csv header row
   void print_header();
@@ -23,7 +28,7 @@ public:
   // parse next update
   void parse( replay& );
 
-private:
+protected:
 
   struct trait_account {
     static const size_t hsize_ = 8363UL;
@@ -41,8 +46,8 @@ private:
 
   typedef hash_map<trait_account> symbol_map_t;
 
-  void parse_product( replay& );
-  void parse_price( replay& );
+  virtual void parse_product( replay& );
+  virtual void parse_price( replay& );
 
   symbol_map_t smap_;
   attr_id      sym_id_;
@@ -53,13 +58,26 @@ private:
   bool         has_sym_;
 };
 
+// attribute ids are shared by the threads of a parallel export
+static std::mutex attr_mtx;
+
+static attr_id get_symbol_attr()
+{
+  std::lock_guard<std::mutex> lck( attr_mtx );
+  return attr_id::add( "symbol" );
+}
+
 csv_print::csv_print()
-: sym_id_( attr_id::add( "symbol" ) ),
+: sym_id_( get_symbol_attr() ),
   do_sym_( false ),
   has_sym_( false )
 {
 }
 
+csv_print::~csv_print()
+{
+}
+
 void csv_print::set_symbol( const std::string& sym )
 {
   sym_ = sym;
@@ -96,6 +114,7 @@ void csv_print::parse_product( replay& rep )
 {
   // generate attribute dictionary from account and get symbol
   str sym, val;
+  std::lock_guard<std::mutex> lck( attr_mtx );
   if ( !attr_.init_from_account( (pc_prod_t*)rep.get_update() ) ||
        !attr_.get_attr( sym_id_, sym ) ) {
     return;
@@ -172,15 +191,246 @@ void csv_print::parse( replay& rep )
   }
 }
 
+// columnar export of prices and their publisher components
+class col_print : public csv_print
+{
+public:
+
+  col_print();
+
+  // create export file
+  bool init( const std::string& file );
+
+  // write remaining rows and dictionaries
+  bool close();
+
+  std::string get_err_msg() const;
+
+protected:
+
+  void parse_product( replay& ) override;
+  void parse_price( replay& ) override;
+
+private:
+
+  struct trait_id {
+    static const size_t hsize_ = 8363UL;
+    typedef uint32_t     idx_t;
+    typedef pub_key      key_t;
+    typedef const key_t& keyref_t;
+    typedef uint32_t     val_t;
+    struct hash_t {
+      idx_t operator() ( keyref_t a ) {
+        uint64_t *p = (uint64_t*)a.data();
+        return p[0] ^ p[1];
+      }
+    };
+  };
+
+  typedef hash_map<trait_id> id_map_t;
+
+  // price table columns
+  enum {
+    p_time, p_symbol, p_price_type, p_expo, p_status, p_price, p_conf,
+    p_twap, p_twac, p_num_qt, p_valid_slot, p_pub_slot, p_prev_slot,
+    p_prev_price, p_prev_conf
+  };
+
+  // component table columns
+  enum {
+    c_row, c_publisher, c_status, c_price, c_conf, c_pub_slot
+  };
+
+  uint32_t get_symbol_id( const pub_key& );
+  uint32_t get_publisher_id( const pub_key& );
+
+  col_writer wtr_;
+  unsigned   ptbl_;
+  unsigned   ctbl_;
+  id_map_t   sids_;  // symbol ids by product account
+  id_map_t   pids_;  // publisher ids by publisher key
+};
+
+col_print::col_print()
+{
+  // delta encoding suits the slowly moving time, slot and price columns
+  ptbl_ = wtr_.add_table( "price" );
+  wtr_.add_column( ptbl_, "time", e_col_delta );
+  wtr_.add_column( ptbl_, "symbol", e_col_dict );
+  wtr_.add_column( ptbl_, "price_type", e_col_dict );
+  wtr_.add_column( ptbl_, "price_exponent", e_col_delta );
+  wtr_.add_column( ptbl_, "status", e_col_dict );
+  wtr_.add_column( ptbl_, "price", e_col_delta );
+  wtr_.add_column( ptbl_, "conf", e_col_delta );
+  wtr_.add_column( ptbl_, "twap", e_col_delta );
+  wtr_.add_column( ptbl_, "twac", e_col_delta );
+  wtr_.add_column( ptbl_, "num_qt", e_col_delta );
+  wtr_.add_column( ptbl_, "valid_slot", e_col_delta );
+  wtr_.add_column( ptbl_, "pub_slot", e_col_delta );
+  wtr_.add_column( ptbl_, "prev_slot", e_col_delta );
+  wtr_.add_column( ptbl_, "prev_price", e_col_delta );
+  wtr_.add_column( ptbl_, "prev_conf", e_col_delta );
+  ctbl_ = wtr_.add_table( "comp" );
+  wtr_.add_column( ctbl_, "row", e_col_delta );
+  wtr_.add_column( ctbl_, "publisher", e_col_dict );
+  wtr_.add_column( ctbl_, "status", e_col_dict );
+  wtr_.add_column( ctbl_, "price", e_col_delta );
+  wtr_.add_column( ctbl_, "conf", e_col_delta );
+  wtr_.add_column( ctbl_, "pub_slot", e_col_delta );
+}
+
+bool col_print::init( const std::string& file )
+{
+  wtr_.set_file( file );
+  return wtr_.init();
+}
+
+bool col_print::close()
+{
+  return wtr_.close();
+}
+
+std::string col_print::get_err_msg() const
+{
+  return wtr_.get_err_msg();
+}
+
+uint32_t col_print::get_symbol_id( const pub_key& prod )
+{
+  id_map_t::iter_t i = sids_.find( prod );
+  if ( i ) {
+    return sids_.obj( i );
+  }
+  str sym;
+  symbol_map_t::iter_t j = smap_.find( prod );
+  if ( j ) {
+    sym = str( smap_.obj( j ) );
+  }
+  uint32_t id = wtr_.get_dict_id( ptbl_, p_symbol, sym );
+  sids_.ref( sids_.add( prod ) ) = id;
+  return id;
+}
+
+uint32_t col_print::get_publisher_id( const pub_key& pub )
+{
+  id_map_t::iter_t i = pids_.find( pub );
+  if ( i ) {
+    return pids_.obj( i );
+  }
+  std::string txt;
+  pub.enc_base58( txt );
+  uint32_t id = wtr_.get_dict_id( ctbl_, c_publisher, str( txt ) );
+  pids_.ref( pids_.add( pub ) ) = id;
+  return id;
+}
+
+void col_print::parse_product( replay& rep )
+{
+  // symbol of product may have changed
+  csv_print::parse_product( rep );
+  id_map_t::iter_t i = sids_.find( *(pub_key*)rep.get_account() );
+  if ( i ) {
+    sids_.del( i );
+  }
+}
+
+void col_print::parse_price( replay& rep )
+{
+  pc_price_t *ptr = (pc_price_t*)rep.get_update();
+  pub_key *aptr = (pub_key*)&ptr->prod_;
+  if ( do_sym_ && (!has_sym_ || *aptr != skey_ ) ) {
+    return;
+  }
+  int64_t row = static_cast< int64_t >( wtr_.get_num_rows( ptbl_ ) );
+  wtr_.set( ptbl_, p_time, rep.get_time() );
+  wtr_.set( ptbl_, p_symbol, get_symbol_id( *aptr ) );
+  wtr_.set( ptbl_, p_price_type, wtr_.get_dict_id( ptbl_, p_price_type,
+        price_type_to_str( (price_type)ptr->ptype_ ) ) );
+  wtr_.set( ptbl_, p_expo, ptr->expo_ );
+  wtr_.set( ptbl_, p_status, wtr_.get_dict_id( ptbl_, p_status,
+        symbol_status_to_str( (symbol_status)ptr->agg_.status_ ) ) );
+  wtr_.set( ptbl_, p_price, ptr->agg_.price_ );
+  wtr_.set( ptbl_, p_conf, (int64_t)ptr->agg_.conf_ );
+  wtr_.set( ptbl_, p_twap, ptr->twap_.val_ );
+  wtr_.set( ptbl_, p_twac, ptr->twac_.val_ );
+  wtr_.set( ptbl_, p_num_qt, ptr->num_qt_ );
+  wtr_.set( ptbl_, p_valid_slot, (int64_t)ptr->valid_slot_ );
+  wtr_.set( ptbl_, p_pub_slot, (int64_t)ptr->agg_.pub_slot_ );
+  wtr_.set( ptbl_, p_prev_slot, (int64_t)ptr->prev_slot_ );
+  wtr_.set( ptbl_, p_prev_price, ptr->prev_price_ );
+  wtr_.set( ptbl_, p_prev_conf, (int64_t)ptr->prev_conf_ );
+  wtr_.add_row( ptbl_ );
+  for( unsigned i=0; i != ptr->num_ && i != PC_NUM_COMP; ++i ) {
+    pc_price_comp_t *cptr = &ptr->comp_[i];
+    wtr_.set( ctbl_, c_row, row );
+    wtr_.set( ctbl_, c_publisher,
+              get_publisher_id( *(pub_key*)&cptr->pub_ ) );
+    wtr_.set( ctbl_, c_status, wtr_.get_dict_id( ctbl_, c_status,
+          symbol_status_to_str( (symbol_status)cptr->agg_.status_ ) ) );
+    wtr_.set( ctbl_, c_price, cptr->agg_.price_ );
+    wtr_.set( ctbl_, c_conf, (int64_t)cptr->agg_.conf_ );
+    wtr_.set( ctbl_, c_pub_slot, (int64_t)cptr->agg_.pub_slot_ );
+    wtr_.add_row( ctbl_ );
+  }
+}
+
 int usage()
 {
   std::cerr << "usage: pyth_csv <cap_file> [options]"
             << std::endl << std::endl;
   std::cerr << "options include:" << std::endl;
   std::cerr << "  -s <symbol>" << std::endl;
+  std::cerr << "  -D <zstd dictionary file> (for .zst capture, repeatable)"
+            << std::endl;
+  std::cerr << "  -t <decompression threads> (for .pcb capture)"
+            << std::endl;
+  std::cerr << "  -C (write columnar <cap_file>.pcol instead of csv)"
+            << std::endl;
+  std::cerr << "  -j <capture files converted in parallel> (with -C)"
+            << std::endl;
+  std::cerr << "further capture files may follow the options" << std::endl;
   return 1;
 }
 
+static std::mutex err_mtx;
+
+static bool print_err( const std::string& msg )
+{
+  std::lock_guard<std::mutex> lck( err_mtx );
+  std::cerr << "pyth_csv: " << msg << std::endl;
+  return false;
+}
+
+static bool init_replay( replay& rep, const std::string& cap_file,
+                         zstd_dict *dict, unsigned num_thr )
+{
+  rep.set_file( cap_file );
+  rep.set_zstd_dict( dict );
+  rep.set_threads( num_thr );
+  return rep.init() || print_err( rep.get_err_msg() );
+}
+
+static bool export_col( const std::string& cap_file, zstd_dict *dict,
+                        unsigned num_thr, const std::string& symstr )
+{
+  replay rep;
+  if ( !init_replay( rep, cap_file, dict, num_thr ) ) {
+    return false;
+  }
+  col_print col;
+  col.set_symbol( symstr );
+  if ( !col.init( cap_file + ".pcol" ) ) {
+    return print_err( col.get_err_msg() );
+  }
+  while( rep.get_next() ) {
+    col.parse( rep );
+  }
+  if ( rep.get_is_err() ) {
+    return print_err( rep.get_err_msg() );
+  }
+  return col.close() || print_err( col.get_err_msg() );
+}
+
 
 int main(int argc, char **argv)
 {
@@ -190,20 +440,52 @@ int main(int argc, char **argv)
   }
   int opt = 0;
   std::string cap_file = argv[1], symstr;
+  unsigned num_thr = 0, num_job = 1;
+  bool do_col = false;
+  zstd_dict dict;
   argc -= 1;
   argv += 1;
-  while( (opt = ::getopt(argc,argv, "s:h" )) != -1 ) {
+  while( (opt = ::getopt(argc,argv, "s:D:t:j:Ch" )) != -1 ) {
     switch(opt) {
       case 's': symstr = optarg; break;
+      case 't': num_thr = (unsigned)::atoi( optarg ); break;
+      case 'j': num_job = (unsigned)::atoi( optarg ); break;
+      case 'C': do_col = true; break;
+      case 'D': {
+        if ( !dict.add_file( optarg ) ) {
+          std::cerr << "pyth_csv: " << dict.get_err_msg() << std::endl;
+          return 1;
+        }
+        break;
+      }
       default: return usage();
     }
   }
-  // initialize replay api
-  replay rep;
-  rep.set_file( cap_file );
-  if ( !rep.init() ) {
-    std::cerr << "pyth_csv: " << rep.get_err_msg() << std::endl;
-    return 1;
+  std::vector<std::string> files( 1, cap_file );
+  for( int i = optind; i < argc; ++i ) {
+    files.push_back( argv[i] );
+  }
+
+  // convert capture files to columnar files on num_job threads
+  if ( do_col ) {
+    std::atomic<size_t> nxt( 0 );
+    std::atomic<bool> is_ok( true );
+    auto run = [&]() {
+      for( size_t i; ( i = nxt++ ) < files.size(); ) {
+        if ( !export_col( files[i], &dict, num_thr, symstr ) ) {
+          is_ok = false;
+        }
+      }
+    };
+    std::vector<std::thread> thrd;
+    for( unsigned i = 1; i < num_job && i < files.size(); ++i ) {
+      thrd.push_back( std::thread( run ) );
+    }
+    run();
+    for( std::thread& t: thrd ) {
+      t.join();
+    }
+    return is_ok ? 0 : 1;
   }
 
   // csv print object
@@ -211,12 +493,18 @@ int main(int argc, char **argv)
   csv.print_header();
   csv.set_symbol( symstr );
 
-  // loop through and parse all updates in capture
-  for(;;) {
-    if ( rep.get_next() ) {
+  // loop through and parse all updates in captures
+  for( const std::string& file: files ) {
+    replay rep;
+    if ( !init_replay( rep, file, &dict, num_thr ) ) {
+      return 1;
+    }
+    while( rep.get_next() ) {
       csv.parse( rep );
-    } else {
-      break;
+    }
+    if ( rep.get_is_err() ) {
+      print_err( rep.get_err_msg() );
+      return 1;
     }
   }
   return 0;
@@ -0,0 +1,113 @@
+#include <pc/replay.hpp>
+#include <pc/zstd_dict.hpp>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+
+using namespace pc;
+
+// train zstd dictionaries per account layout from capture files
+
+struct dict_sample
+{
+  uint32_t            type_;
+  const char         *name_;
+  std::vector<char>   buf_;
+  std::vector<size_t> len_;
+};
+
+int usage()
+{
+  std::cerr << "usage: pyth_dict <cap_file> [<cap_file> ...] [options]"
+            << std::endl << std::endl;
+  std::cerr << "options include:" << std::endl;
+  std::cerr << "  -o <output prefix (default pyth)>" << std::endl;
+  std::cerr << "     Writes <prefix>_mapping.dict, <prefix>_product.dict and "
+               "<prefix>_price.dict\n" << std::endl;
+  std::cerr << "  -s <max_dict_size (default 16384)>" << std::endl;
+  std::cerr << "  -n <max_samples per account type (default 100000)>"
+            << std::endl;
+  std::cerr << "  -D <zstd dictionary file> (for .zst capture, repeatable)"
+            << std::endl;
+  return 1;
+}
+
+int main(int argc, char **argv)
+{
+  int opt = 0;
+  std::string prefix = "pyth";
+  size_t max_len = 16384, max_num = 100000;
+  zstd_dict dict;
+  while( (opt = ::getopt(argc,argv, "o:s:n:D:h" )) != -1 ) {
+    switch(opt) {
+      case 'o': prefix = optarg; break;
+      case 's': max_len = strtoul(optarg, NULL, 0); break;
+      case 'n': max_num = strtoul(optarg, NULL, 0); break;
+      case 'D': {
+        if ( !dict.add_file( optarg ) ) {
+          std::cerr << "pyth_dict: " << dict.get_err_msg() << std::endl;
+          return 1;
+        }
+        break;
+      }
+      default: return usage();
+    }
+  }
+  if ( optind >= argc ) {
+    return usage();
+  }
+
+  // collect account samples by type
+  dict_sample svec[] = {
+    { PC_ACCTYPE_MAPPING, "mapping", {}, {} },
+    { PC_ACCTYPE_PRODUCT, "product", {}, {} },
+    { PC_ACCTYPE_PRICE,   "price",   {}, {} }
+  };
+  for( int i = optind; i < argc; ++i ) {
+    replay rep;
+    rep.set_file( argv[i] );
+    rep.set_zstd_dict( &dict );
+    if ( !rep.init() ) {
+      std::cerr << "pyth_dict: " << rep.get_err_msg() << std::endl;
+      return 1;
+    }
+    while( rep.get_next() ) {
+      pc_acc_t *aptr = rep.get_update();
+      for( dict_sample& s: svec ) {
+        if ( s.type_ == aptr->type_ && s.len_.size() < max_num ) {
+          const char *buf = (const char*)aptr;
+          s.buf_.insert( s.buf_.end(), buf, buf + aptr->size_ );
+          s.len_.push_back( aptr->size_ );
+        }
+      }
+    }
+    if ( rep.get_is_err() ) {
+      std::cerr << "pyth_dict: " << rep.get_err_msg() << std::endl;
+      return 1;
+    }
+  }
+
+  // train and write one dictionary per account type
+  for( dict_sample& s: svec ) {
+    if ( s.len_.empty() ) {
+      continue;
+    }
+    std::string res;
+    if ( !dict.train( s.type_, s.buf_, s.len_, max_len, res ) ) {
+      std::cerr << "pyth_dict: " << s.name_ << ": " << dict.get_err_msg()
+                << std::endl;
+      dict.reset_err();
+      continue;
+    }
+    std::string file = prefix + "_" + s.name_ + ".dict";
+    std::ofstream fout( file, std::ios::binary );
+    fout.write( res.data(), static_cast< std::streamsize >( res.size() ) );
+    if ( !fout ) {
+      std::cerr << "pyth_dict: failed to write file=" << file << std::endl;
+      return 1;
+    }
+    std::cout << file << ": samples=" << s.len_.size()
+              << " size=" << res.size() << std::endl;
+  }
+  return 0;
+}
@@ -35,6 +35,34 @@ int usage()
   std::cerr << "  -l <log_file>" << std::endl;
   std::cerr << "     Optional log file - uses stderr if not provided\n"
             << std::endl;
+  std::cerr << "  -q <num_leaders (default 0)>" << std::endl;
+  std::cerr << "     Keep QUIC connections open to this many upcoming leaders "
+               "and send\n     transactions over QUIC where connected\n"
+            << std::endl;
+  std::cerr << "  -W <num_workers (default 0)>" << std::endl;
+  std::cerr << "     Forward transactions over udp on this many worker "
+               "threads, each with\n     its own socket. QUIC connections "
+               "stay on the main thread\n" << std::endl;
+  std::cerr << "  -w <lookahead_slots (default 5)>" << std::endl;
+  std::cerr << "     Forward transactions to the leaders of the current and "
+               "this many\n     following slots\n" << std::endl;
+  std::cerr << "  -c <num_copies (default 1)>" << std::endl;
+  std::cerr << "     Copies of each transaction sent over udp to the current "
+               "and next\n     leader. Extra copies add load on those "
+               "leaders\n" << std::endl;
+  std::cerr << "  -u <dedup_window_slots (default 32)>" << std::endl;
+  std::cerr << "     Drop transactions whose signature was already forwarded "
+               "within this\n     many slots, as sent by redundant pythd "
+               "instances (0 to disable)\n" << std::endl;
+  std::cerr << "  -m <max_leaders (default 4)>" << std::endl;
+  std::cerr << "     Forward each transaction to at most this many upcoming "
+               "leaders\n" << std::endl;
+  std::cerr << "  -t <landing target (default 0.95)>" << std::endl;
+  std::cerr << "     While pythd reports where price updates land (pythd "
+               "-I), leaders that\n     drop transactions are skipped and "
+               "later leaders are added until the\n     chance that one of "
+               "them lands a transaction reaches this target\n"
+            << std::endl;
   std::cerr << "  -n" << std::endl;
   std::cerr << "     No wait mode - i.e. run using busy poll loop\n"
             << std::endl;
@@ -67,14 +95,24 @@ int main(int argc, char **argv)
   std::string log_file;
   std::string rpc_host = get_rpc_host();
   int opt = 0, pyth_port = get_port();
+  unsigned num_quic = 0, max_ldr = 4, ldr_win = 5, num_copy = 1;
+  unsigned dedup_win = 32, num_wrk = 0;
+  double land_tgt = 0.95;
   bool do_wait = true, do_debug = false;
-  while( (opt = ::getopt(argc,argv, "r:p:l:dnh" )) != -1 ) {
+  while( (opt = ::getopt(argc,argv, "r:p:l:q:m:t:w:c:u:W:dnh" )) != -1 ) {
     switch(opt) {
       case 'r': rpc_host = optarg; break;
       case 'p': pyth_port = ::atoi(optarg); break;
       case 'd': do_debug = true; break;
       case 'l': log_file = optarg; break;
       case 'n': do_wait = false; break;
+      case 'q': num_quic = strtoul(optarg, NULL, 0); break;
+      case 'm': max_ldr = strtoul(optarg, NULL, 0); break;
+      case 't': land_tgt = strtod(optarg, NULL); break;
+      case 'w': ldr_win = strtoul(optarg, NULL, 0); break;
+      case 'c': num_copy = strtoul(optarg, NULL, 0); break;
+      case 'u': dedup_win = strtoul(optarg, NULL, 0); break;
+      case 'W': num_wrk = strtoul(optarg, NULL, 0); break;
       default: return usage();
     }
   }
@@ -92,6 +130,13 @@ int main(int argc, char **argv)
   tx_svr mgr;
   mgr.set_rpc_host( rpc_host );
   mgr.set_listen_port( pyth_port );
+  mgr.set_num_quic( num_quic );
+  mgr.set_num_workers( num_wrk );
+  mgr.set_lookahead( ldr_win );
+  mgr.set_num_copies( num_copy );
+  mgr.set_max_leaders( max_ldr );
+  mgr.set_dedup_window( dedup_win );
+  mgr.set_land_target( land_tgt );
   if ( !mgr.init() ) {
     std::cerr << "pyth_tx: " << mgr.get_err_msg() << std::endl;
     return 1;
@@ -1,7 +1,9 @@
 #include <pc/manager.hpp>
 #include <pc/log.hpp>
+#include <pc/huge_page.hpp>
 #include <unistd.h>
 #include <signal.h>
+#include <string.h>
 #include <iostream>
 
 // pyth daemon service
@@ -37,6 +39,10 @@ int usage()
             << std::endl;
   std::cerr << "     Host name or IP address of solana rpc node in the form "
                "host_name[:rpc_port[:ws_port]]\n" << std::endl;
+  std::cerr << "  -s <secondary rpc_host>" << std::endl;
+  std::cerr << "     Also publish to the network of this rpc node. Each "
+               "secondary network is polled on its own thread (repeatable)\n"
+            << std::endl;
   std::cerr << "  -t <tx proxy host (default " << get_tx_host() << ")>"
             << std::endl;
   std::cerr << "     Host name or IP address of running pyth_tx server\n"
@@ -53,19 +59,148 @@ int usage()
   std::cerr << "  -w <web content directory>" << std::endl;
   std::cerr << "     Directory containing dashboard/ content\n" << std::endl;
   std::cerr << "  -c <capture file>" << std::endl;
-  std::cerr << "     Optional capture will get compressed\n" << std::endl;
+  std::cerr << "     Optional capture will get compressed with gzip or, if "
+               "the file ends in\n     .zst, as a zstd stream. Files "
+               "ending in .pcb are written as indexed\n     blocks that "
+               "can be read from a time, slot or account\n"
+            << std::endl;
+  std::cerr << "  -O <capture zstd level (default 3)>" << std::endl;
+  std::cerr << "  -T <capture zstd threads (default 0)>" << std::endl;
+  std::cerr << "     Compression level and worker threads of a .zst "
+               "capture\n" << std::endl;
+  std::cerr << "  -X <capture delta interval (default 0)>" << std::endl;
+  std::cerr << "     Capture the changes to accounts with the full account "
+               "every this many\n     records per account\n"
+            << std::endl;
+  std::cerr << "  -E <capture rotation interval in seconds (default 0)>"
+            << std::endl;
+  std::cerr << "     Start a new capture file named by the time of its "
+               "first record every\n     this many seconds\n"
+            << std::endl;
+  std::cerr << "  -P <capture fdatasync interval in ms (default 0)>"
+            << std::endl;
+  std::cerr << "  -N <capture buffers queued before dropping (default 0)>"
+            << std::endl;
+  std::cerr << "     Records dropped by a full capture queue are counted "
+               "and logged\n" << std::endl;
+  std::cerr << "  -5 <price_account|attribute=value>[@<rate>]" << std::endl;
+  std::cerr << "     Capture one in rate aggregate updates (default 1) of "
+               "the price account or\n     of prices of products with the "
+               "attribute value, e.g. symbol=BTC/USD@10.\n     The first "
+               "matching filter applies and other prices are not captured. "
+               "May\n     be repeated. Changed at runtime with set_capture\n"
+            << std::endl;
+  std::cerr << "  -D <zstd dictionary file>" << std::endl;
+  std::cerr << "     Account dictionary trained with pyth_dict used to decode "
+               "account data and\n     to compress the capture. May be "
+               "repeated\n" << std::endl;
+  std::cerr << "  -f <snapshot_file>" << std::endl;
+  std::cerr << "     Mapping, product and price accounts are loaded from this "
+               "file on startup\n     and saved back to it periodically so "
+               "that publishing starts without\n     fetching every account "
+               "in turn\n" << std::endl;
+  std::cerr << "  -3 <handoff_file>" << std::endl;
+  std::cerr << "     Unix socket for zero-downtime restarts. A pythd started "
+               "with the file of\n     a running pythd takes over its "
+               "listening socket and websocket users\n     with their "
+               "subscriptions and the running pythd exits. Implies -f\n"
+               "     <handoff_file>.snap unless given\n" << std::endl;
+  std::cerr << "  -M <shm_file>" << std::endl;
+  std::cerr << "     Shared-memory price feed. Every price account update is "
+               "copied to this\n     file so that local processes can read "
+               "prices without a connection\n     (see pc/shm_reader.hpp)\n"
+            << std::endl;
+  std::cerr << "  -g <mcast_ip:port>" << std::endl;
+  std::cerr << "     Multicast group to which aggregate prices changed in a "
+               "slot are sent\n     when the slot ends. Lost packets are "
+               "recovered with the\n     mcast_retransmit and mcast_snapshot "
+               "websocket requests\n" << std::endl;
+  std::cerr << "  -G <mcast_ttl (default 1)>" << std::endl;
+  std::cerr << "     Multicast time-to-live\n" << std::endl;
+  std::cerr << "  -y <trace_file>" << std::endl;
+  std::cerr << "     Follow sampled publisher updates from the websocket "
+               "message to the\n     aggregate that includes them and write "
+               "the stages as a chrome\n     trace event file "
+               "(chrome://tracing or ui.perfetto.dev)\n" << std::endl;
+  std::cerr << "  -Y <trace one in this many updates (default 100)>"
+            << std::endl;
   std::cerr << "  -l <log_file>" << std::endl;
   std::cerr << "     Optional log file - uses stderr if not provided\n"
             << std::endl;
+  std::cerr << "  -j" << std::endl;
+  std::cerr << "     Binary logging - log lines are formatted on the log "
+               "thread\n" << std::endl;
   std::cerr << "  -n" << std::endl;
   std::cerr << "     No wait mode - i.e. run using busy poll loop\n"
             << std::endl;
   std::cerr << "  -x" << std::endl;
   std::cerr << "     Disable connection to pyth_tx transaction proxy server"
                "\n" << std::endl;
+  std::cerr << "  -I" << std::endl;
+  std::cerr << "     Report the slots that price updates land in to pyth_tx "
+               "so that it\n     forwards transactions to the leaders that "
+               "include them. Requires\n     a pyth_tx that accepts the "
+               "reports\n" << std::endl;
+  std::cerr << "  -o" << std::endl;
+  std::cerr << "     Predict the next aggregate price locally on component "
+               "updates and\n     send it to price subscribers as "
+               "notify_predicted_price. Not supported with -A\n" << std::endl;
   std::cerr << "  -z" << std::endl;
   std::cerr << "     Disable WebSocket connection to Solana RPC node"
                "\n" << std::endl;
+  std::cerr << "  -4 <min_ms>[,<max_ms>] (default 400,12800)" << std::endl;
+  std::cerr << "     Polling interval of accounts with -z. Each account is "
+               "polled more often\n     while it changes and less often "
+               "while it does not\n" << std::endl;
+  std::cerr << "  -H <num_http_conn (default 1)>" << std::endl;
+  std::cerr << "     Number of http connections to the solana rpc node. With "
+               "two or more, one is\n     reserved for submitting "
+               "transactions\n" << std::endl;
+  std::cerr << "  -R <hedge_rpc_host>" << std::endl;
+  std::cerr << "     Additional rpc provider on the same network. Http "
+               "requests are raced\n     across providers and the first "
+               "valid reply is used. May be repeated\n" << std::endl;
+  std::cerr << "  -K <num_hedge (default 2)>" << std::endl;
+  std::cerr << "     Number of providers each http request is sent to, "
+               "slowest dropped first\n" << std::endl;
+  std::cerr << "  -W <num_sign_threads (default 0)>" << std::endl;
+  std::cerr << "     Sign pyth_tx transactions on worker threads instead of "
+               "the polling thread\n" << std::endl;
+  std::cerr << "  -F <program_filter>" << std::endl;
+  std::cerr << "     Subscribe only to matching program accounts: mapping, "
+               "product, price,\n     product=<product_key> or "
+               "size=<data_size>, several separated by commas\n     to "
+               "match all. May be repeated. Account types left out are not"
+               "\n     updated after startup\n" << std::endl;
+  std::cerr << "  -A" << std::endl;
+  std::cerr << "     Receive only the header and aggregate price of price "
+               "account updates.\n     Component prices are as of startup. "
+               "Landing of updates is tracked as\n     with -J (every 2 "
+               "slots unless set)\n" << std::endl;
+  std::cerr << "  -U" << std::endl;
+  std::cerr << "     Use io_uring instead of epoll for socket polling if "
+               "supported by the kernel\n" << std::endl;
+  std::cerr << "  -S <spin_budget_usecs (default 0)>" << std::endl;
+  std::cerr << "     Keep polling sockets without blocking for this long after "
+               "the last socket\n     event before blocking again\n"
+            << std::endl;
+  std::cerr << "  -B <busy_poll_usecs (default 0)>" << std::endl;
+  std::cerr << "     Set SO_BUSY_POLL on all sockets\n" << std::endl;
+  std::cerr << "  -C <cpu>" << std::endl;
+  std::cerr << "     Pin the polling thread to this cpu\n" << std::endl;
+  std::cerr << "  -2 <placement>" << std::endl;
+  std::cerr << "     Comma-separated thread placement and memory options: "
+               "poll=<cpu>,\n     log=<cpu>, capture=<cpu>, sign=<first_cpu>, "
+               "secondary=<first_cpu>,\n     prio=<real-time priority of "
+               "the polling thread>, mlock (lock memory\n     into ram) and "
+               "huge (allocate tables and buffers from 2MB huge pages)\n"
+            << std::endl;
+  std::cerr << "  -L" << std::endl;
+  std::cerr << "     Periodically log kernel receive to dispatch latency "
+               "and publish\n     latency percentiles\n" << std::endl;
+  std::cerr << "  -Z" << std::endl;
+  std::cerr << "     Negotiate permessage-deflate compression on websocket "
+               "connections\n" << std::endl;
   std::cerr << "  -m <commitment_level>" << std::endl;
   std::cerr << "     Subscription commitment level: processed, confirmed or "
                "finalized\n" << std::endl;
@@ -76,9 +211,116 @@ int usage()
   std::cerr << "     Number of compute units requested by each upd_price transaction (default 20000)" << std::endl;
   std::cerr << "  -v" << std::endl;
   std::cerr << "     Price per compute unit for each upd_price transaction, in micro lamports (the default is not to specify a specific price)" << std::endl;
+  std::cerr << "  -V" << std::endl;
+  std::cerr << "     Maximum price per compute unit, in micro lamports. When above -v, the price adapts to recent prioritization fees and the rate at which updates land (default 0, off)" << std::endl;
+  std::cerr << "  -1 <num_shards (default 1)>" << std::endl;
+  std::cerr << "     Partition products across this many shards, each "
+               "polled on its own thread\n     with its own rpc "
+               "connections. Subscribing to all prices, capture,\n     "
+               "shared-memory feed and multicast are not supported with "
+               "shards\n" << std::endl;
+  std::cerr << "  -J <sig_status_interval_slots (default 0)>" << std::endl;
+  std::cerr << "     Query the status of sent upd_price transactions every "
+               "this many slots\n     to track which land. The adaptive "
+               "price of -V then follows the\n     tracked landing rate "
+               "(default 0, off)\n" << std::endl;
+  std::cerr << "  -e <flush_lead_msecs (default 100)>" << std::endl;
+  std::cerr << "     Send partial batches of price updates once the current "
+               "slot is estimated to\n     end within this long\n"
+            << std::endl;
+  std::cerr << "  -a <flush_max_age_msecs (default 400)>" << std::endl;
+  std::cerr << "     Send partial batches of price updates once the oldest "
+               "update is this old\n" << std::endl;
+  std::cerr << "  -6 <strategy>[,<contend_publishers>[,<contend_size>]]"
+            << std::endl;
+  std::cerr << "     Composition of price update batches: fifo (default) in "
+               "arrival order up to\n     the max batch size, fill up to "
+               "the transaction size limit, stale with\n     the stalest "
+               "prices on chain first, or contend with prices of at least\n"
+               "     contend_publishers (default 16) first in batches of "
+               "contend_size (default\n     1) and the rest as stale. "
+               "Landing is tracked per strategy with -J.\n     The max "
+               "batch size (-b) only applies to fifo\n" << std::endl;
+  std::cerr << "  -q <user_send_limit_kbytes (default 1024)>" << std::endl;
+  std::cerr << "     Conflate price notifications to websocket users with "
+               "more than this queued\n     for sending\n" << std::endl;
+  std::cerr << "  -Q <user_slow_timeout_msecs (default 30000)>" << std::endl;
+  std::cerr << "     Disconnect websocket users above the send limit for "
+               "this long\n" << std::endl;
   return 1;
 }
 
+// thread placement and memory options of -2
+struct placement
+{
+  placement();
+  bool parse( const std::string& );
+  int  poll_cpu_;
+  int  poll_pri_;
+  int  log_cpu_;
+  int  cap_cpu_;
+  int  sign_cpu_;
+  int  sec_cpu_;
+  bool do_mlock_;
+  bool do_huge_;
+};
+
+placement::placement()
+: poll_cpu_( -1 ),
+  poll_pri_( 0 ),
+  log_cpu_( -1 ),
+  cap_cpu_( -1 ),
+  sign_cpu_( -1 ),
+  sec_cpu_( -1 ),
+  do_mlock_( false ),
+  do_huge_( false )
+{
+}
+
+bool placement::parse( const std::string& spec )
+{
+  for( size_t pos = 0; pos <= spec.size(); ) {
+    size_t end = std::min( spec.find( ',', pos ), spec.size() );
+    std::string tok = spec.substr( pos, end - pos );
+    pos = end + 1;
+    size_t eq = tok.find( '=' );
+    std::string key = tok.substr( 0, eq );
+    if ( eq == std::string::npos ) {
+      if ( key == "mlock" ) {
+        do_mlock_ = true;
+      } else if ( key == "huge" ) {
+        do_huge_ = true;
+      } else if ( !key.empty() ) {
+        return false;
+      }
+      continue;
+    }
+    char *vend = nullptr;
+    std::string val = tok.substr( eq + 1 );
+    long num = ::strtol( val.c_str(), &vend, 10 );
+    if ( val.empty() || *vend || num < 0 || num > 1023 ) {
+      return false;
+    }
+    int ival = static_cast< int >( num );
+    if ( key == "poll" ) {
+      poll_cpu_ = ival;
+    } else if ( key == "prio" ) {
+      poll_pri_ = ival;
+    } else if ( key == "log" ) {
+      log_cpu_ = ival;
+    } else if ( key == "capture" ) {
+      cap_cpu_ = ival;
+    } else if ( key == "sign" ) {
+      sign_cpu_ = ival;
+    } else if ( key == "secondary" ) {
+      sec_cpu_ = ival;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool do_run = true;
 
 void sig_handle( int )
@@ -100,37 +342,134 @@ int main(int argc, char **argv)
 {
   // command-line parsing
   commitment cmt = commitment::e_confirmed;
-  std::string cnt_dir, cap_file, log_file;
+  std::string cnt_dir, cap_file, snap_file, shm_file, mcast_addr, log_file;
+  std::string hoff_file;
+  std::string trc_file;
+  std::vector<std::string> dict_files, hedge_hosts, cap_filters;
+  std::vector<rpc::program_filter> filters;
   std::string rpc_host = get_rpc_host();
-  std::string secondary_rpc_host = "";
+  std::vector<std::string> secondary_rpc_hosts;
   std::string key_dir  = get_key_store();
   std::string tx_host  = get_tx_host();
   int pyth_port = get_port();
   int opt = 0;
   int pub_int = 1000;
   unsigned cu_units = 20000;
-  unsigned cu_price = 0;
+  unsigned cu_price = 0, max_cu_price = 0, sig_intv = 0;
   unsigned max_batch_size = 0;
+  batch_strategy bstrat = e_batch_fifo;
+  unsigned bhot_pub = 16, bhot_num = 1;
+  int64_t flush_lead = 100, flush_age = 400;
+  size_t usnd_lim = 1024;
+  int64_t uslow_to = 30000;
+  int64_t poll_min = 400, poll_max = 12800;
+  unsigned num_hconn = 1;
+  unsigned num_hedge = 2, num_sthr = 0, num_shard = 1;
+  int64_t spin_us = 0;
+  int busy_us = 0, mcast_ttl = 1, cap_level = 3;
+  placement place;
+  unsigned cap_threads = 0, cap_delta = 0, cap_rotate = 0, cap_sync = 0;
+  unsigned cap_pend = 0, trc_sample = 100;
   bool do_wait = true, do_tx = true, do_ws = true, do_debug = false;
-  while( (opt = ::getopt(argc,argv, "r:s:t:p:i:k:w:c:l:m:b:u:v:dnxhz" )) != -1 ) {
+  bool do_uring = false, do_wsz = false, do_lat = false, do_agg = false;
+  bool do_blog = false, do_land = false, do_pred = false;
+  while( (opt = ::getopt(argc,argv, "r:s:t:p:i:k:w:c:f:M:g:G:y:Y:O:T:X:E:N:P:l:m:b:e:a:q:Q:u:v:V:H:R:K:F:W:S:B:C:D:J:1:2:3:4:5:6:AdnxhzUZLjIo" )) != -1 ) {
     switch(opt) {
       case 'r': rpc_host = optarg; break;
-      case 's': secondary_rpc_host = optarg; break;
+      case 's': secondary_rpc_hosts.push_back( optarg ); break;
       case 't': tx_host = optarg; break;
       case 'p': pyth_port = ::atoi(optarg); break;
       case 'i': pub_int = ::atoi(optarg); break;
       case 'k': key_dir = optarg; break;
       case 'c': cap_file = optarg; break;
+      case 'O': cap_level = strtol(optarg, NULL, 0); break;
+      case 'T': cap_threads = strtoul(optarg, NULL, 0); break;
+      case 'X': cap_delta = strtoul(optarg, NULL, 0); break;
+      case 'E': cap_rotate = strtoul(optarg, NULL, 0); break;
+      case 'N': cap_pend = strtoul(optarg, NULL, 0); break;
+      case 'P': cap_sync = strtoul(optarg, NULL, 0); break;
+      case 'f': snap_file = optarg; break;
+      case '3': hoff_file = optarg; break;
+      case '5': cap_filters.push_back( optarg ); break;
+      case '6': {
+        char *end = ::strchr( optarg, ',' );
+        std::string name( optarg, end ? (size_t)( end - optarg )
+                                      : ::strlen( optarg ) );
+        bstrat = str_to_batch_strategy( name );
+        if ( end ) {
+          bhot_pub = (unsigned)strtoul( end + 1, &end, 0 );
+          bhot_num = *end == ',' ? (unsigned)strtoul( end + 1, &end, 0 )
+                                 : bhot_num;
+        }
+        if ( bstrat == e_batch_unknown || ( end && *end ) || !bhot_num ) {
+          std::cerr << "pythd: invalid batch strategy=" << optarg << std::endl;
+          return usage();
+        }
+        break;
+      }
+      case '4': {
+        char *end = nullptr;
+        poll_min = strtol( optarg, &end, 0 );
+        poll_max = *end == ',' ? strtol( end + 1, &end, 0 ) : poll_max;
+        if ( *end || poll_min <= 0 || poll_max < poll_min ) {
+          std::cerr << "pythd: invalid poll interval=" << optarg << std::endl;
+          return usage();
+        }
+        break;
+      }
+      case 'M': shm_file = optarg; break;
+      case 'g': mcast_addr = optarg; break;
+      case 'G': mcast_ttl = strtol(optarg, NULL, 0); break;
+      case 'y': trc_file = optarg; break;
+      case 'Y': trc_sample = strtoul(optarg, NULL, 0); break;
+      case 'D': dict_files.push_back( optarg ); break;
       case 'w': cnt_dir = optarg; break;
       case 'l': log_file = optarg; break;
+      case 'j': do_blog = true; break;
       case 'm': cmt = str_to_commitment(optarg); break;
       case 'b': max_batch_size = strtoul(optarg, NULL, 0); break;
+      case 'e': flush_lead = strtol(optarg, NULL, 0); break;
+      case 'a': flush_age = strtol(optarg, NULL, 0); break;
+      case 'q': usnd_lim = strtoul(optarg, NULL, 0); break;
+      case 'Q': uslow_to = strtol(optarg, NULL, 0); break;
       case 'n': do_wait = false; break;
       case 'x': do_tx = false; break;
+      case 'I': do_land = true; break;
+      case 'o': do_pred = true; break;
       case 'z': do_ws = false; break;
+      case 'H': num_hconn = strtoul(optarg, NULL, 0); break;
+      case 'R': hedge_hosts.push_back( optarg ); break;
+      case 'K': num_hedge = strtoul(optarg, NULL, 0); break;
+      case 'F': {
+        filters.resize( filters.size() + 1 );
+        if ( !filters.back().init_from_text( optarg ) ) {
+          std::cerr << "pythd: invalid program filter=" << optarg
+                    << std::endl;
+          return usage();
+        }
+        break;
+      }
+      case 'A': do_agg = true; break;
+      case 'W': num_sthr = strtoul(optarg, NULL, 0); break;
+      case 'U': do_uring = true; break;
+      case 'Z': do_wsz = true; break;
+      case 'S': spin_us = strtol(optarg, NULL, 0); break;
+      case 'B': busy_us = ::atoi(optarg); break;
+      case 'C': place.poll_cpu_ = ::atoi(optarg); break;
+      case 'L': do_lat = true; break;
       case 'd': do_debug = true; break;
       case 'u': cu_units = strtoul(optarg, NULL, 0); break;
       case 'v': cu_price = strtoul(optarg, NULL, 0); break;
+      case 'V': max_cu_price = strtoul(optarg, NULL, 0); break;
+      case 'J': sig_intv = strtoul(optarg, NULL, 0); break;
+      case '1': num_shard = strtoul(optarg, NULL, 0); break;
+      case '2': {
+        if ( !place.parse( optarg ) ) {
+          std::cerr << "pythd: invalid placement=" << optarg << std::endl;
+          return usage();
+        }
+        break;
+      }
       default: return usage();
     }
   }
@@ -138,6 +477,25 @@ int main(int argc, char **argv)
     std::cerr << "pythd: unknown commitment level" << std::endl;
     return usage();
   }
+  if ( num_shard > 1 && ( !cap_file.empty() || !shm_file.empty() ||
+                          !mcast_addr.empty() ) ) {
+    std::cerr << "pythd: capture, shared-memory feed and multicast are "
+                 "not supported with shards" << std::endl;
+    return usage();
+  }
+  if ( do_pred && do_agg ) {
+    std::cerr << "pythd: prediction needs the components that -A leaves "
+                 "out" << std::endl;
+    return usage();
+  }
+  if ( max_batch_size && bstrat != e_batch_fifo ) {
+    std::cerr << "pythd: max batch size only applies to the fifo batch "
+                 "strategy" << std::endl;
+    return usage();
+  }
+
+  // huge pages apply to allocations from here on
+  huge_page::set_enabled( place.do_huge_ );
 
   // set up logging and disable SIGPIPE
   signal( SIGPIPE, SIG_IGN );
@@ -146,7 +504,13 @@ int main(int argc, char **argv)
               << log_file << std::endl;
     return 1;
   }
+  log::set_binary( do_blog );
   log::set_level( do_debug ? PC_LOG_DBG_LVL : PC_LOG_INF_LVL );
+  if ( place.log_cpu_ >= 0 && !log::set_cpu( place.log_cpu_ ) ) {
+    std::cerr << "pythd: failed to pin log thread to cpu="
+              << place.log_cpu_ << std::endl;
+    return 1;
+  }
 
   // construct and initialize pyth-client manager
   manager mgr;
@@ -156,17 +520,76 @@ int main(int argc, char **argv)
   mgr.set_listen_port( pyth_port );
   mgr.set_content_dir( cnt_dir );
   mgr.set_capture_file( cap_file );
+  mgr.set_capture_level( cap_level );
+  mgr.set_capture_threads( cap_threads );
+  mgr.set_capture_delta( cap_delta );
+  mgr.set_capture_rotate( cap_rotate );
+  mgr.set_capture_sync( cap_sync );
+  mgr.set_capture_max_pending( cap_pend );
+  for( const std::string& term: cap_filters ) {
+    if ( !mgr.add_capture_filter( term ) ) {
+      std::cerr << "pythd: invalid capture filter=" << term << std::endl;
+      return usage();
+    }
+  }
+  mgr.set_snapshot_file( snap_file );
+  mgr.set_handoff_file( hoff_file );
+  mgr.set_shm_file( shm_file );
+  mgr.set_mcast_addr( mcast_addr );
+  mgr.set_mcast_ttl( mcast_ttl );
+  mgr.set_trace_file( trc_file );
+  mgr.set_trace_sample( trc_sample );
+  for( const std::string& file: dict_files ) {
+    mgr.add_zstd_dict_file( file );
+  }
   mgr.set_do_tx( do_tx );
+  mgr.set_do_land_report( do_land );
+  mgr.set_do_predict( do_pred );
+  mgr.set_num_sign_threads( num_sthr );
   mgr.set_do_ws( do_ws );
+  mgr.set_poll_min_interval( poll_min );
+  mgr.set_poll_max_interval( poll_max );
+  mgr.set_do_uring( do_uring );
+  mgr.set_do_ws_deflate( do_wsz );
+  mgr.set_spin_budget( spin_us );
+  mgr.set_busy_poll( busy_us );
+  mgr.set_poll_cpu( place.poll_cpu_ );
+  mgr.set_poll_prio( place.poll_pri_ );
+  mgr.set_capture_cpu( place.cap_cpu_ );
+  mgr.set_sign_cpu( place.sign_cpu_ );
+  mgr.set_secondary_cpu( place.sec_cpu_ );
+  mgr.set_do_mlock( place.do_mlock_ );
+  mgr.set_do_latency( do_lat );
+  mgr.set_num_http_conn( num_hconn );
+  for( const std::string& host: hedge_hosts ) {
+    mgr.add_hedge_host( host );
+  }
+  mgr.set_hedge_num( num_hedge );
+  for( const rpc::program_filter& filt: filters ) {
+    mgr.add_program_filter( filt );
+  }
+  mgr.set_do_agg_only( do_agg );
   mgr.set_do_capture( !cap_file.empty() );
   mgr.set_commitment( cmt );
   mgr.set_publish_interval( pub_int );
   mgr.set_requested_upd_price_cu_units( cu_units );
   mgr.set_requested_upd_price_cu_price( cu_price );
+  mgr.set_max_upd_price_cu_price( max_cu_price );
+  mgr.set_sig_status_interval( sig_intv );
+  mgr.set_flush_lead( flush_lead );
+  mgr.set_flush_max_age( flush_age );
+  mgr.set_user_send_limit( usnd_lim * 1024UL );
+  mgr.set_user_slow_timeout( uslow_to );
+  mgr.set_num_shard( num_shard );
+  if (max_batch_size > 0) {
+    mgr.set_max_batch_size(max_batch_size);
+  }
+  mgr.set_batch_strategy( bstrat );
+  mgr.set_batch_contend_publishers( bhot_pub );
+  mgr.set_batch_contend_size( bhot_num );
 
-  bool do_secondary = !secondary_rpc_host.empty();
-  if ( do_secondary ) {
-    mgr.add_secondary( secondary_rpc_host, key_dir );
+  for( const std::string& host: secondary_rpc_hosts ) {
+    mgr.add_secondary( host, key_dir );
   }
   if ( !mgr.init() ) {
     std::cerr << "pythd: " << mgr.get_err_msg() << std::endl;
@@ -178,9 +601,6 @@ int main(int argc, char **argv)
     return 1;
   }
 
-  if (max_batch_size > 0) {
-    mgr.set_max_batch_size(max_batch_size);
-  }
   std::cout << "pythd: max batch size " << mgr.get_max_batch_size() << std::endl;
 
   // set up signal handing
@@ -188,7 +608,7 @@ int main(int argc, char **argv)
   signal( SIGHUP, sig_handle );
   signal( SIGTERM, sig_handle );
   signal( SIGUSR1, sig_toggle );
-  while( do_run && !mgr.get_is_err() ) {
+  while( do_run && !mgr.get_is_err() && !mgr.get_is_handoff() ) {
     mgr.poll( do_wait );
   }
   int retcode = 0;
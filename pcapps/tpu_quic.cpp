@@ -0,0 +1,267 @@
+#include "tpu_quic.hpp"
+#include <openssl/opensslv.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L && !defined( OPENSSL_NO_QUIC )
+#include <openssl/quic.h>
+#define PC_HAS_QUIC
+#endif
+
+using namespace pc;
+
+///////////////////////////////////////////////////////////////////////////
+// tpu_quic
+
+tpu_quic::tpu_quic()
+: slot_( 0UL ),
+  ssl_( nullptr ),
+  is_conn_( false )
+{
+}
+
+tpu_quic::~tpu_quic()
+{
+  close();
+}
+
+void tpu_quic::set_tpu_addr( const ip_addr& addr )
+{
+  taddr_ = addr;
+}
+
+const ip_addr& tpu_quic::get_tpu_addr() const
+{
+  return taddr_;
+}
+
+void tpu_quic::set_quic_addr( const ip_addr& addr )
+{
+  qaddr_ = addr;
+}
+
+const ip_addr& tpu_quic::get_quic_addr() const
+{
+  return qaddr_;
+}
+
+void tpu_quic::set_slot( uint64_t slot )
+{
+  slot_ = slot;
+}
+
+uint64_t tpu_quic::get_slot() const
+{
+  return slot_;
+}
+
+bool tpu_quic::get_is_connect() const
+{
+  return is_conn_ && !get_is_err();
+}
+
+bool tpu_quic::get_is_wait() const
+{
+  return ssl_ && !is_conn_ && !get_is_err();
+}
+
+#ifdef PC_HAS_QUIC
+
+// alpn protocol id expected by solana tpu
+static const unsigned char tpu_alpn[] = {
+  10, 's', 'o', 'l', 'a', 'n', 'a', '-', 't', 'p', 'u'
+};
+
+static SSL_CTX *get_ctx()
+{
+  // shared client context with a self-signed (i.e. unstaked) identity
+  static SSL_CTX *ctx = nullptr;
+  if ( ctx ) {
+    return ctx;
+  }
+  EVP_PKEY *pkey = EVP_PKEY_Q_keygen( nullptr, nullptr, "ED25519" );
+  X509 *cert = X509_new();
+  SSL_CTX *cptr = SSL_CTX_new( OSSL_QUIC_client_method() );
+  if ( pkey && cert && cptr ) {
+    X509_set_version( cert, X509_VERSION_3 );
+    ASN1_INTEGER_set( X509_get_serialNumber( cert ), 1 );
+    X509_gmtime_adj( X509_getm_notBefore( cert ), 0 );
+    X509_gmtime_adj( X509_getm_notAfter( cert ), 10L*365L*86400L );
+    X509_set_pubkey( cert, pkey );
+    X509_NAME *name = X509_get_subject_name( cert );
+    X509_NAME_add_entry_by_txt( name, "CN", MBSTRING_ASC,
+        (const unsigned char*)"pyth_tx", -1, -1, 0 );
+    X509_set_issuer_name( cert, name );
+    if ( X509_sign( cert, pkey, nullptr ) > 0 &&
+         SSL_CTX_use_certificate( cptr, cert ) == 1 &&
+         SSL_CTX_use_PrivateKey( cptr, pkey ) == 1 ) {
+      // validators present self-signed certificates too
+      SSL_CTX_set_verify( cptr, SSL_VERIFY_NONE, nullptr );
+      ctx  = cptr;
+      cptr = nullptr;
+    }
+  }
+  SSL_CTX_free( cptr );
+  X509_free( cert );
+  EVP_PKEY_free( pkey );
+  return ctx;
+}
+
+bool tpu_quic::get_is_supported()
+{
+  return true;
+}
+
+bool tpu_quic::init()
+{
+  close();
+  reset_err();
+  SSL_CTX *ctx = get_ctx();
+  if ( !ctx ) {
+    return set_err_msg( "failed to create quic context" );
+  }
+  int fd = ::socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+  if ( fd < 0 ) {
+    return set_err_msg( "failed to construct udp socket", errno );
+  }
+  sockaddr_in *sptr = (sockaddr_in*)qaddr_.buf_;
+  if ( 0 != ::connect( fd, (sockaddr*)sptr, sizeof( sockaddr_in ) ) ||
+       !BIO_socket_nbio( fd, 1 ) ) {
+    ::close( fd );
+    return set_err_msg( "failed to connect udp socket", errno );
+  }
+  BIO *bio = BIO_new_dgram( fd, BIO_CLOSE );
+  if ( !bio ) {
+    ::close( fd );
+    return set_err_msg( "failed to create datagram bio" );
+  }
+  SSL *ssl = SSL_new( ctx );
+  if ( !ssl ) {
+    BIO_free( bio );
+    return set_err_msg( "failed to create quic connection" );
+  }
+  SSL_set_bio( ssl, bio, bio );
+  ssl_ = ssl;
+  BIO_ADDR *peer = BIO_ADDR_new();
+  bool is_ok = peer && BIO_ADDR_rawmake( peer, AF_INET, &sptr->sin_addr,
+      sizeof( sptr->sin_addr ), sptr->sin_port );
+  is_ok = is_ok && SSL_set1_initial_peer_addr( ssl, peer );
+  BIO_ADDR_free( peer );
+  if ( !is_ok ||
+       0 != SSL_set_alpn_protos( ssl, tpu_alpn, sizeof( tpu_alpn ) ) ||
+       !SSL_set_blocking_mode( ssl, 0 ) ||
+       !SSL_set_default_stream_mode( ssl, SSL_DEFAULT_STREAM_MODE_NONE ) ) {
+    close();
+    return set_err_msg( "failed to configure quic connection" );
+  }
+
+  // send initial handshake packet
+  poll();
+  return !get_is_err();
+}
+
+void tpu_quic::poll()
+{
+  SSL *ssl = (SSL*)ssl_;
+  if ( !ssl || get_is_err() ) {
+    return;
+  }
+  if ( !is_conn_ ) {
+    int rc = SSL_connect( ssl );
+    if ( rc == 1 ) {
+      is_conn_ = true;
+    } else {
+      check_err( rc );
+    }
+    return;
+  }
+  SSL_handle_events( ssl );
+
+  // peer closed or idle timeout
+  SSL_CONN_CLOSE_INFO info;
+  if ( SSL_get_conn_close_info( ssl, &info, sizeof( info ) ) ) {
+    set_err_msg( "quic connection closed" );
+  }
+}
+
+bool tpu_quic::send( const char *buf, size_t len )
+{
+  if ( !get_is_connect() ) {
+    return false;
+  }
+  // fails without blocking if peer has not granted stream credit
+  SSL *st = SSL_new_stream( (SSL*)ssl_, SSL_STREAM_FLAG_UNI );
+  if ( !st ) {
+    ERR_clear_error();
+    return false;
+  }
+  size_t wlen = 0;
+  bool is_ok = SSL_write_ex( st, buf, len, &wlen ) == 1 && wlen == len &&
+               SSL_stream_conclude( st, 0 ) == 1;
+  if ( !is_ok ) {
+    ERR_clear_error();
+  }
+  // concluded streams continue to be flushed by the connection
+  SSL_free( st );
+  return is_ok;
+}
+
+void tpu_quic::close()
+{
+  if ( ssl_ ) {
+    SSL *ssl = (SSL*)ssl_;
+    if ( is_conn_ ) {
+      SSL_shutdown( ssl );
+    }
+    SSL_free( ssl );
+    ssl_ = nullptr;
+  }
+  is_conn_ = false;
+}
+
+void tpu_quic::check_err( int rc )
+{
+  int err = SSL_get_error( (SSL*)ssl_, rc );
+  if ( err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE ) {
+    return;
+  }
+  char ebuf[256];
+  ERR_error_string_n( ERR_get_error(), ebuf, sizeof( ebuf ) );
+  set_err_msg( std::string( "quic handshake failed: " ) + ebuf );
+}
+
+#else
+
+bool tpu_quic::get_is_supported()
+{
+  return false;
+}
+
+bool tpu_quic::init()
+{
+  return set_err_msg( "openssl built without quic client support" );
+}
+
+void tpu_quic::poll()
+{
+}
+
+bool tpu_quic::send( const char *, size_t )
+{
+  return false;
+}
+
+void tpu_quic::close()
+{
+}
+
+void tpu_quic::check_err( int )
+{
+}
+
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <pc/error.hpp>
+#include <pc/net_socket.hpp>
+
+namespace pc
+{
+
+  // non-blocking quic connection to a leader's transaction processing
+  // unit. each transaction is sent on its own unidirectional stream as
+  // expected by solana validators. requires an openssl build with quic
+  // client support (3.2 or later) - otherwise init always fails
+  class tpu_quic : public error
+  {
+  public:
+    tpu_quic();
+    ~tpu_quic();
+
+    // built with quic support
+    static bool get_is_supported();
+
+    // leader tpu (udp) address used to match against leader schedule
+    void set_tpu_addr( const ip_addr& );
+    const ip_addr& get_tpu_addr() const;
+
+    // leader tpu quic address to connect to
+    void set_quic_addr( const ip_addr& );
+    const ip_addr& get_quic_addr() const;
+
+    // last slot in which leader was scheduled
+    void set_slot( uint64_t );
+    uint64_t get_slot() const;
+
+    // start handshake
+    bool init();
+
+    // advance handshake, retransmits, acks and timers
+    void poll();
+
+    // handshake complete and connection open
+    bool get_is_connect() const;
+
+    // still handshaking
+    bool get_is_wait() const;
+
+    // send transaction on new stream - false if connection cannot take it
+    bool send( const char *buf, size_t len );
+
+    // close connection
+    void close();
+
+  private:
+    void check_err( int rc );
+
+    ip_addr   taddr_;  // tpu udp address
+    ip_addr   qaddr_;  // tpu quic address
+    uint64_t  slot_;   // last leader slot
+    void     *ssl_;    // quic connection
+    bool      is_conn_;
+  };
+
+}
@@ -0,0 +1,67 @@
+#include "tx_dedup.hpp"
+
+// table size (power of two) and entries probed per signature
+#define PC_DEDUP_SIZE  8192
+#define PC_DEDUP_PROBE 8
+
+using namespace pc;
+
+tx_dedup::tx_dedup()
+: win_( 32U ),
+  num_check_( 0UL ),
+  num_dup_( 0UL ),
+  evec_( PC_DEDUP_SIZE )
+{
+  for( entry& e: evec_ ) {
+    e.key_[0] = e.key_[1] = e.slot_ = 0UL;
+  }
+}
+
+void tx_dedup::set_window( unsigned slots )
+{
+  win_ = slots;
+}
+
+unsigned tx_dedup::get_window() const
+{
+  return win_;
+}
+
+uint64_t tx_dedup::get_num_check() const
+{
+  return num_check_;
+}
+
+uint64_t tx_dedup::get_num_dup() const
+{
+  return num_dup_;
+}
+
+bool tx_dedup::get_is_dup( const uint8_t *sig, uint64_t slot )
+{
+  if ( !win_ ) {
+    return false;
+  }
+  ++num_check_;
+
+  // signatures are random so their leading bytes serve as hash and key.
+  // a new signature takes the stalest entry of its probe sequence
+  uint64_t key[2];
+  __builtin_memcpy( key, sig, sizeof( key ) );
+  entry *rep = nullptr;
+  for( uint64_t i = 0; i != PC_DEDUP_PROBE; ++i ) {
+    entry& e = evec_[( key[0] + i ) & ( PC_DEDUP_SIZE - 1 )];
+    bool is_live = e.slot_ && e.slot_ + win_ >= slot;
+    if ( is_live && e.key_[0] == key[0] && e.key_[1] == key[1] ) {
+      ++num_dup_;
+      return true;
+    }
+    if ( !rep || e.slot_ < rep->slot_ ) {
+      rep = &e;
+    }
+  }
+  rep->key_[0] = key[0];
+  rep->key_[1] = key[1];
+  rep->slot_   = slot ? slot : 1UL;
+  return false;
+}
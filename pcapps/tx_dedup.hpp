@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace pc
+{
+
+  // window of recently forwarded transactions by signature. several
+  // pythd instances (or redundant publishers) behind one proxy submit
+  // the same transactions, which only need forwarding once. fixed size
+  // table with short probes where entries expire by slot
+  class tx_dedup
+  {
+  public:
+
+    tx_dedup();
+
+    // slots a signature is remembered for (default 32, 0=off)
+    void set_window( unsigned slots );
+    unsigned get_window() const;
+
+    // is transaction with raw signature sig a repeat of one seen in the
+    // window. remembers it otherwise
+    bool get_is_dup( const uint8_t *sig, uint64_t slot );
+
+    // transactions checked and repeats found
+    uint64_t get_num_check() const;
+    uint64_t get_num_dup() const;
+
+  private:
+
+    struct entry {
+      uint64_t key_[2];   // leading signature bytes
+      uint64_t slot_;     // slot last seen or zero if free
+    };
+
+    typedef std::vector<entry> entry_vec_t;
+
+    unsigned    win_;
+    uint64_t    num_check_;
+    uint64_t    num_dup_;
+    entry_vec_t evec_;
+  };
+
+}
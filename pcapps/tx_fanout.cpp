@@ -0,0 +1,209 @@
+#include "tx_fanout.hpp"
+
+// transactions sent per sendmmsg flush of a worker
+#define PC_FANOUT_CHUNK 64
+
+using namespace pc;
+
+const unsigned tx_fanout::max_queue;
+const size_t   tx_fanout::max_len;
+
+static void run_tx_fanout( tx_fanout *fan, unsigned idx )
+{
+  fan->run( idx );
+}
+
+tx_fanout::tx_fanout()
+: set_( new leader_set ),
+  num_( 1U ),
+  next_( 0UL ),
+  is_run_( false )
+{
+}
+
+tx_fanout::~tx_fanout()
+{
+  teardown();
+  delete set_.load();
+}
+
+void tx_fanout::set_num_threads( unsigned num )
+{
+  num_ = num;
+}
+
+unsigned tx_fanout::get_num_threads() const
+{
+  return num_;
+}
+
+uint64_t tx_fanout::get_num_sent() const
+{
+  uint64_t num = 0UL;
+  for( worker *wp: wvec_ ) {
+    num += wp->nsent_.load( std::memory_order_relaxed );
+  }
+  return num;
+}
+
+uint64_t tx_fanout::get_num_calls() const
+{
+  uint64_t num = 0UL;
+  for( worker *wp: wvec_ ) {
+    num += wp->ncall_.load( std::memory_order_relaxed );
+  }
+  return num;
+}
+
+bool tx_fanout::init()
+{
+  if ( !num_ ) {
+    return set_err_msg( "tx_fanout requires at least one thread" );
+  }
+  for( unsigned i=0; i != num_; ++i ) {
+    worker *wp = new worker;
+    wp->in_    = 0UL;
+    wp->out_   = 0UL;
+    wp->use_   = nullptr;
+    wp->nsent_ = 0UL;
+    wp->ncall_ = 0UL;
+    wp->post_  = 0UL;
+    sem_init( &wp->sem_, 0, 0 );
+    wvec_.push_back( wp );
+    if ( !wp->sock_.init() ) {
+      return set_err_msg( wp->sock_.get_err_msg() );
+    }
+  }
+  is_run_ = true;
+  for( unsigned i=0; i != num_; ++i ) {
+    wvec_[i]->thrd_ = std::thread( run_tx_fanout, this, i );
+  }
+  return true;
+}
+
+void tx_fanout::set_leaders( const std::vector<ip_addr>& avec,
+                             const std::vector<unsigned>& nvec )
+{
+  leader_set *ls = new leader_set;
+  ls->avec_ = avec;
+  ls->nvec_ = nvec;
+  old_.push_back( set_.exchange( ls ) );
+  free_sets();
+}
+
+void tx_fanout::free_sets()
+{
+  for( size_t i=0; i != old_.size(); ) {
+    leader_set *ls = old_[i];
+    bool is_use = false;
+    for( worker *wp: wvec_ ) {
+      is_use = is_use || wp->use_.load() == ls;
+    }
+    if ( is_use ) {
+      ++i;
+      continue;
+    }
+    delete ls;
+    old_[i] = old_.back();
+    old_.pop_back();
+  }
+}
+
+bool tx_fanout::submit( const char *buf, size_t len )
+{
+  if ( PC_UNLIKELY( len > max_len || wvec_.empty() ) ) {
+    return false;
+  }
+  worker *wp = wvec_[next_++ % wvec_.size()];
+  uint64_t seq = wp->in_.load( std::memory_order_relaxed );
+  if ( PC_UNLIKELY( seq - wp->out_.load( std::memory_order_acquire ) ==
+                    max_queue ) ) {
+    // wake the worker in case the ring filled up within one flush and
+    // wait for it to make room rather than send ahead of the queue
+    if ( seq != wp->post_ ) {
+      wp->post_ = seq;
+      sem_post( &wp->sem_ );
+    }
+    while( seq - wp->out_.load( std::memory_order_acquire ) == max_queue ) {
+      std::this_thread::yield();
+    }
+  }
+  job& jb = wp->jobs_[seq % max_queue];
+  __builtin_memcpy( jb.buf_, buf, len );
+  jb.len_ = len;
+  wp->in_.store( seq + 1, std::memory_order_release );
+  return true;
+}
+
+void tx_fanout::flush()
+{
+  for( worker *wp: wvec_ ) {
+    uint64_t in = wp->in_.load( std::memory_order_relaxed );
+    if ( in != wp->post_ ) {
+      wp->post_ = in;
+      sem_post( &wp->sem_ );
+    }
+  }
+}
+
+void tx_fanout::run( unsigned idx )
+{
+  worker *wp = wvec_[idx];
+  uint64_t seq = 0UL;
+  for(;;) {
+    sem_wait( &wp->sem_ );
+    if ( !is_run_ ) {
+      break;
+    }
+    uint64_t in = wp->in_.load( std::memory_order_acquire );
+    if ( seq == in ) {
+      continue;
+    }
+
+    // mark the current leader set before using it so that it is not
+    // freed in between
+    leader_set *ls;
+    do {
+      ls = set_.load();
+      wp->use_.store( ls );
+    } while( ls != set_.load() );
+
+    while( seq != in ) {
+      uint64_t end = std::min( in, seq + PC_FANOUT_CHUNK );
+      for( uint64_t i = seq; i != end; ++i ) {
+        job& jb = wp->jobs_[i % max_queue];
+        for( size_t j = 0; j != ls->avec_.size(); ++j ) {
+          for( unsigned k = 0; k != ls->nvec_[j]; ++k ) {
+            wp->sock_.add_send( &ls->avec_[j], jb.buf_, jb.len_ );
+          }
+        }
+      }
+      wp->sock_.flush();
+      seq = end;
+      wp->out_.store( seq, std::memory_order_release );
+    }
+    wp->use_.store( nullptr );
+    wp->nsent_.store( wp->sock_.get_num_sent(), std::memory_order_relaxed );
+    wp->ncall_.store( wp->sock_.get_num_calls(), std::memory_order_relaxed );
+  }
+}
+
+void tx_fanout::teardown()
+{
+  if ( is_run_ ) {
+    is_run_ = false;
+    for( worker *wp: wvec_ ) {
+      sem_post( &wp->sem_ );
+    }
+    for( worker *wp: wvec_ ) {
+      wp->thrd_.join();
+    }
+  }
+  for( worker *wp: wvec_ ) {
+    sem_destroy( &wp->sem_ );
+    wp->sock_.close();
+    delete wp;
+  }
+  wvec_.clear();
+  free_sets();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <pc/net_socket.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <semaphore.h>
+
+namespace pc
+{
+
+  // forwards transactions to the leader tpu addresses over udp on worker
+  // threads, each with its own socket. transactions are handed to the
+  // workers round robin through per-worker rings. the loop thread
+  // publishes a new leader set on slot change which workers pick up
+  // without locking. a worker marks the set it uses (a hazard pointer)
+  // and retired sets are freed once no worker has them marked
+  class tx_fanout : public error
+  {
+  public:
+
+    // transactions queued per worker before submit waits for it and the
+    // largest transaction queued
+    static const unsigned max_queue = 1024;
+    static const size_t   max_len   = 1280;
+
+    tx_fanout();
+    ~tx_fanout();
+
+    // number of worker threads
+    void set_num_threads( unsigned );
+    unsigned get_num_threads() const;
+
+    // start worker threads
+    bool init();
+
+    // publish leader addresses and copies sent to each (loop thread)
+    void set_leaders( const std::vector<ip_addr>&,
+                      const std::vector<unsigned>& copies );
+
+    // queue transaction, waiting for the worker while its ring is full
+    // so that transactions leave in order. false if it is too large and
+    // has to be sent by the caller
+    bool submit( const char *buf, size_t len );
+
+    // wake workers with transactions queued since the last call
+    void flush();
+
+    // stop worker threads
+    void teardown();
+
+    // datagrams and send calls of all workers
+    uint64_t get_num_sent() const;
+    uint64_t get_num_calls() const;
+
+  public:
+    void run( unsigned );
+
+  private:
+
+    struct leader_set
+    {
+      std::vector<ip_addr>  avec_;
+      std::vector<unsigned> nvec_;
+    };
+
+    struct job
+    {
+      size_t len_;
+      char   buf_[max_len];
+    };
+
+    typedef std::atomic<uint64_t>    seq_t;
+    typedef std::atomic<leader_set*> set_ptr_t;
+
+    struct worker
+    {
+      job          jobs_[max_queue];
+      seq_t        in_;    // jobs queued by loop
+      seq_t        out_;   // jobs sent by worker
+      set_ptr_t    use_;   // leader set in use or null
+      seq_t        nsent_; // datagrams sent
+      seq_t        ncall_; // send system calls
+      uint64_t     post_;  // in_ at last wake up
+      sem_t        sem_;
+      std::thread  thrd_;
+      udp_socket   sock_;
+    };
+
+    typedef std::vector<worker*>     worker_vec_t;
+    typedef std::vector<leader_set*> set_vec_t;
+    typedef std::atomic<bool>        atomic_t;
+
+    void free_sets();
+
+    worker_vec_t  wvec_;
+    set_ptr_t     set_;   // current leader set
+    set_vec_t     old_;   // retired sets not yet freed
+    unsigned      num_;
+    uint64_t      next_;  // next worker to queue to
+    atomic_t      is_run_;
+  };
+
+}
@@ -1,5 +1,9 @@
 #include "tx_rpc_client.hpp"
 #include <pc/bincode.hpp>
+#include <netinet/in.h>
+
+// solana tpu quic port offset from tpu udp port
+#define PC_TPU_QUIC_OFFSET 6
 
 using namespace pc;
 
@@ -54,7 +58,19 @@ bool rpc::get_cluster_nodes::get_ip_addr( const pub_key& pkey, ip_addr& res )
 {
   node_map_t::iter_t it = nmap_.find( pkey );
   if ( it ) {
-    res = nmap_.obj( it );
+    res = nmap_.obj( it ).tpu_;
+    return true;
+  } else {
+    return false;
+  }
+}
+
+bool rpc::get_cluster_nodes::get_quic_addr(
+    const pub_key& pkey, ip_addr& res )
+{
+  node_map_t::iter_t it = nmap_.find( pkey );
+  if ( it ) {
+    res = nmap_.obj( it ).quic_;
     return true;
   } else {
     return false;
@@ -73,7 +89,20 @@ void rpc::get_cluster_nodes::response( const jtree& jt )
   pub_key pkey;
   for( uint32_t tok = jt.get_first( rtok ); tok; tok = jt.get_next( tok ) ) {
     pkey.init_from_text( jt.get_str( jt.find_val( tok, "pubkey" ) ) );
-    ip_addr addr( jt.get_str( jt.find_val( tok, "tpu" ) ) );
+    node_addr addr;
+    addr.tpu_ = ip_addr( jt.get_str( jt.find_val( tok, "tpu" ) ) );
+    uint32_t qtok = jt.find_val( tok, "tpuQuic" );
+    if ( qtok ) {
+      addr.quic_ = ip_addr( jt.get_str( qtok ) );
+    }
+    sockaddr_in *qptr = (sockaddr_in*)addr.quic_.buf_;
+    sockaddr_in *tptr = (sockaddr_in*)addr.tpu_.buf_;
+    if ( qptr->sin_port == 0 && tptr->sin_port != 0 ) {
+      // older nodes do not advertise tpuQuic
+      addr.quic_ = addr.tpu_;
+      qptr->sin_port = htons( (uint16_t)( ntohs( tptr->sin_port ) +
+                                          PC_TPU_QUIC_OFFSET ) );
+    }
     node_map_t::iter_t it = nmap_.find( pkey );
     if ( !it ) it = nmap_.add( pkey );
     nmap_.ref( it ) = addr;
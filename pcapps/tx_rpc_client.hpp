@@ -19,15 +19,21 @@ namespace pc {
     {
     public:
       bool get_ip_addr( const pub_key&, ip_addr& );
+      // tpu quic address (tpu port plus quic offset if not advertised)
+      bool get_quic_addr( const pub_key&, ip_addr& );
       void request( json_wtr& ) override;
       void response( const jtree&p) override;
     private:
+      struct node_addr {
+        ip_addr tpu_;
+        ip_addr quic_;
+      };
       struct trait_node {
         static const size_t hsize_ = 859UL;
         typedef uint32_t        idx_t;
         typedef pub_key         key_t;
         typedef const pub_key&  keyref_t;
-        typedef ip_addr         val_t;
+        typedef node_addr       val_t;
         struct hash_t {
           idx_t operator() ( keyref_t a ) {
             uint64_t *i = (uint64_t*)a.data();
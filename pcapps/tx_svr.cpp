@@ -5,8 +5,14 @@
 #define PC_RPC_HTTP_PORT      8899
 #define PC_LEADER_MAX         256
 #define PC_LEADER_MIN         32
-#define PC_RECONNECT_TIMEOUT  (120L*1000000000L)
 #define PC_HBEAT_INTERVAL     16
+#define PC_STATS_INTERVAL     (10L*PC_NSECS_IN_SEC)
+#define PC_LEADER_WINDOW      5
+#define PC_LEADER_COPIES      1
+#define PC_LEADER_AHEAD       16U
+#define PC_LAND_MIN_RATE      0.2
+#define PC_LAND_PRIOR         0.9
+#define PC_LAND_STALE         128
 
 using namespace pc;
 
@@ -29,6 +35,19 @@ bool tx_user::parse( const char *buf, size_t sz, size_t&len  )
   if ( PC_UNLIKELY( sz < sizeof( tx_hdr) || sz < hdr->size_ ) ) {
     return false;
   }
+  if ( PC_UNLIKELY( hdr->size_ < sizeof( tx_hdr ) ) ) {
+    teardown();
+    return false;
+  }
+  if ( hdr->proto_id_ == PC_TPU_LAND_ID ) {
+    if ( hdr->size_ >= sizeof( tx_hdr ) + sizeof( tx_land ) ) {
+      tx_land land;
+      __builtin_memcpy( &land, &hdr[1], sizeof( land ) );
+      mgr_->add_landed( land );
+    }
+    len = hdr->size_;
+    return true;
+  }
   if ( PC_UNLIKELY( hdr->proto_id_ != PC_TPU_PROTO_ID ) ) {
     teardown();
     return false;
@@ -56,7 +75,32 @@ tx_svr::tx_svr()
   slot_( 0UL ),
   slot_cnt_( 0UL ),
   cts_( 0L ),
-  ctimeout_( PC_NSECS_IN_SEC )
+  ctimeout_( PC_RECONNECT_MIN ),
+  num_quic_( 0U ),
+  fan_( nullptr ),
+  num_wrk_( 0U ),
+  num_inl_( 0UL ),
+  snum_inl_( 0UL ),
+  num_tx_( 0UL ),
+  num_qtx_( 0UL ),
+  snum_qtx_( 0UL ),
+  snum_tx_( 0UL ),
+  snum_pkt_( 0UL ),
+  snum_call_( 0UL ),
+  sts_( 0L ),
+  snum_dchk_( 0UL ),
+  snum_dup_( 0UL ),
+  max_ldr_( 4U ),
+  win_( PC_LEADER_WINDOW ),
+  ncopy_( PC_LEADER_COPIES ),
+  land_tgt_( 0.95 ),
+  lslot_( 0UL ),
+  num_land_( 0UL ),
+  num_skip_( 0UL ),
+  snum_land_( 0UL ),
+  snum_skip_( 0UL ),
+  is_land_( false ),
+  is_tgt_( false )
 {
   hreq_->set_sub( this );
   sreq_->set_sub( this );
@@ -92,6 +136,86 @@ int tx_svr::get_listen_port() const
   return tsvr_.get_port();
 }
 
+uint64_t tx_svr::get_slot() const
+{
+  return slot_;
+}
+
+unsigned tx_svr::get_num_leaders() const
+{
+  return static_cast< unsigned >( avec_.size() );
+}
+
+void tx_svr::set_num_quic( unsigned num )
+{
+  num_quic_ = num;
+}
+
+unsigned tx_svr::get_num_quic() const
+{
+  return num_quic_;
+}
+
+void tx_svr::set_num_workers( unsigned num )
+{
+  num_wrk_ = num;
+}
+
+unsigned tx_svr::get_num_workers() const
+{
+  return num_wrk_;
+}
+
+void tx_svr::set_lookahead( unsigned num )
+{
+  win_ = num;
+}
+
+unsigned tx_svr::get_lookahead() const
+{
+  return win_;
+}
+
+void tx_svr::set_num_copies( unsigned num )
+{
+  ncopy_ = num ? num : 1U;
+}
+
+unsigned tx_svr::get_num_copies() const
+{
+  return ncopy_;
+}
+
+void tx_svr::set_dedup_window( unsigned slots )
+{
+  dedup_.set_window( slots );
+}
+
+unsigned tx_svr::get_dedup_window() const
+{
+  return dedup_.get_window();
+}
+
+void tx_svr::set_max_leaders( unsigned num )
+{
+  max_ldr_ = num ? num : 1U;
+}
+
+unsigned tx_svr::get_max_leaders() const
+{
+  return max_ldr_;
+}
+
+void tx_svr::set_land_target( double tgt )
+{
+  land_tgt_ = tgt;
+}
+
+double tx_svr::get_land_target() const
+{
+  return land_tgt_;
+}
+
 bool tx_svr::init()
 {
   // initialize net_loop
@@ -128,9 +252,27 @@ bool tx_svr::init()
   if ( !tsvr_.init() ) {
     return set_err_msg( tsvr_.get_err_msg() );
   }
+  if ( num_wrk_ ) {
+    fan_ = new tx_fanout;
+    fan_->set_num_threads( num_wrk_ );
+    if ( !fan_->init() ) {
+      return set_err_msg( fan_->get_err_msg() );
+    }
+  }
+  if ( num_quic_ && !tpu_quic::get_is_supported() ) {
+    PC_LOG_WRN( "quic not supported - using udp only" ).end();
+    num_quic_ = 0;
+  }
   PC_LOG_INF("initialized")
     .add("listen_port",tsvr_.get_port())
     .add("rpc_host", rhost )
+    .add("num_quic", num_quic_ )
+    .add("num_workers", num_wrk_ )
+    .add("lookahead", win_ )
+    .add("num_copies", ncopy_ )
+    .add("max_leaders", max_ldr_ )
+    .add("dedup_window", dedup_.get_window() )
+    .add("land_target", land_tgt_ )
     .end();
   wait_conn_ = true;
   return true;
@@ -154,9 +296,26 @@ void tx_svr::poll( bool do_wait )
     }
   }
 
+  // drive quic handshakes and acks
+  for( tpu_quic *qptr: qvec_ ) {
+    qptr->poll();
+  }
+
+  // fan out transactions received in this iteration
+  if ( !toff_.empty() ) {
+    send_txs();
+  }
+
   // destroy any users scheduled for deletion
   teardown_users();
 
+  // periodic throughput stats
+  int64_t ts = get_now();
+  if ( ts - sts_ > PC_STATS_INTERVAL ) {
+    log_stats();
+    sts_ = ts;
+  }
+
   // reconnect to rpc as required
   if ( PC_UNLIKELY( !has_conn_ ||
         hconn_.get_is_err() || wconn_.get_is_err() ) ) {
@@ -201,68 +360,262 @@ void tx_svr::accept( int fd )
 
 void tx_svr::submit( const char *buf, size_t len )
 {
+  // transactions start with the number of signatures (a compact-u16,
+  // one byte when below 128) followed by the signatures
+  ++num_tx_;
+  const uint8_t *tx = (const uint8_t*)buf;
+  if ( len > 1 + signature::len && tx[0] != 0 && tx[0] < 0x80 &&
+       dedup_.get_is_dup( &tx[1], slot_ ) ) {
+    PC_LOG_DBG( "drop duplicate tx" )
+      .add( "slot", slot_ )
+      .end();
+    return;
+  }
   PC_LOG_DBG( "submit tx" )
     .add( "slot", slot_ )
     .add( "num_leaders", avec_.size() )
     .end();
-  for( ip_addr& addr: avec_ ) {
-    tconn_.send( &addr, buf, len );
+  tbuf_.insert( tbuf_.end(), buf, &buf[len] );
+  toff_.push_back( tbuf_.size() );
+}
+
+void tx_svr::add_landed( const tx_land& land )
+{
+  PC_LOG_DBG( "receive landing" )
+    .add( "pub_slot", land.pub_slot_ )
+    .add( "land_slot", land.land_slot_ )
+    .end();
+  lstat_.add_land( land.land_slot_ );
+  lslot_ = std::max( lslot_, land.land_slot_ );
+  ++num_land_;
+}
+
+void tx_svr::send_txs()
+{
+  // slots of the targeted leaders are scored against landing reports
+  if ( is_land_ && !is_tgt_ ) {
+    for( const slot_leader& sl: tgt_ ) {
+      lstat_.add_sent( sl.slot_, sl.key_ );
+    }
+    is_tgt_ = true;
+  }
+
+  // every leader gets every transaction - over quic where connected
+  // otherwise batched into udp sendmmsg calls. with workers, leaders
+  // without quic connections are sent to off the loop thread
+  size_t off = 0;
+  for( size_t end: toff_ ) {
+    bool is_fan = fan_ && fan_->submit( &tbuf_[off], end - off );
+    num_inl_ += fan_ && !is_fan;
+    for( tx_route& rt: avec_ ) {
+      if ( is_fan && !rt.qptr_ ) {
+        continue;
+      }
+      if ( rt.qptr_ && rt.qptr_->send( &tbuf_[off], end - off ) ) {
+        ++num_qtx_;
+        continue;
+      }
+      for( unsigned i = 0; i != rt.num_; ++i ) {
+        tconn_.add_send( &rt.addr_, &tbuf_[off], end - off );
+      }
+    }
+    off = end;
   }
+  tconn_.flush();
+  if ( fan_ ) {
+    fan_->flush();
+  }
+  tbuf_.clear();
+  toff_.clear();
 }
 
-void tx_svr::add_addr( const ip_addr& addr )
+void tx_svr::log_stats()
 {
-  for( ip_addr& iaddr: avec_ ) {
-    if ( iaddr == addr ) return;
+  if ( sts_ ) {
+    double secs = double( get_now() - sts_ ) / double( PC_NSECS_IN_SEC );
+    uint64_t num_pkt  = get_num_pkt();
+    uint64_t num_call = get_num_calls();
+    uint64_t num_dchk = dedup_.get_num_check();
+    uint64_t num_dup  = dedup_.get_num_dup();
+    uint32_t num_conn = 0;
+    for( tpu_quic *qptr: qvec_ ) {
+      num_conn += qptr->get_is_connect();
+    }
+    PC_LOG_INF( "tx_stats" )
+      .add( "num_leaders", avec_.size() )
+      .add( "num_quic_conn", num_conn )
+      .add( "tx_per_sec", double( num_tx_ - snum_tx_ ) / secs )
+      .add( "quic_tx_per_sec", double( num_qtx_ - snum_qtx_ ) / secs )
+      .add( "pkt_per_sec", double( num_pkt - snum_pkt_ ) / secs )
+      .add( "syscall_per_sec", double( num_call - snum_call_ ) / secs )
+      .add( "num_inline", num_inl_ - snum_inl_ )
+      .add( "land_per_sec", double( num_land_ - snum_land_ ) / secs )
+      .add( "num_skip", num_skip_ - snum_skip_ )
+      .add( "num_land_slots", lstat_.get_num_land() )
+      .add( "num_scored_slots", lstat_.get_num_slots() )
+      .add( "dup_per_sec", double( num_dup - snum_dup_ ) / secs )
+      .add( "dup_rate", num_dchk > snum_dchk_ ? double( num_dup - snum_dup_ )
+            / double( num_dchk - snum_dchk_ ) : 0. )
+      .end();
   }
-  avec_.push_back( addr );
+  snum_dchk_ = dedup_.get_num_check();
+  snum_dup_  = dedup_.get_num_dup();
+  snum_land_ = num_land_;
+  snum_skip_ = num_skip_;
+  snum_tx_   = num_tx_;
+  snum_qtx_  = num_qtx_;
+  snum_pkt_  = get_num_pkt();
+  snum_call_ = get_num_calls();
+  snum_inl_  = num_inl_;
 }
 
-void tx_svr::on_response( rpc::slot_subscribe *res )
+tpu_quic *tx_svr::find_quic( const ip_addr& addr )
 {
-  // check error
-  if ( PC_UNLIKELY( res->get_is_err() ) ) {
-    set_err_msg( "failed to slot_subscribe ["
-        + res->get_err_msg()  + "]" );
-    return;
+  for( tpu_quic *qptr: qvec_ ) {
+    if ( qptr->get_tpu_addr() == addr ) return qptr;
   }
+  return nullptr;
+}
 
-  // ignore slots that go back in time
-  uint64_t slot = res->get_slot();
-  if ( slot <= slot_ ) {
-    return;
+void tx_svr::update_quic()
+{
+  // mark the next num_quic_ distinct leaders as upcoming
+  ip_addr taddr, qaddr;
+  unsigned num = 0;
+  pub_key *pkey = nullptr;
+  uint64_t max_slot = lreq_->get_last_slot();
+  for( uint64_t slot = slot_-1; num < num_quic_ && slot < max_slot; ++slot ) {
+    pub_key *ikey = lreq_->get_leader( slot );
+    if ( ikey && ( !pkey || *ikey != *pkey ) &&
+         creq_->get_ip_addr( *ikey, taddr ) &&
+         creq_->get_quic_addr( *ikey, qaddr ) ) {
+      tpu_quic *qptr = find_quic( taddr );
+      if ( !qptr ) {
+        qptr = new tpu_quic;
+        qptr->set_tpu_addr( taddr );
+        qptr->set_quic_addr( qaddr );
+        qvec_.push_back( qptr );
+      }
+      if ( qptr->get_slot() != slot_ ) {
+        qptr->set_slot( slot_ );
+        ++num;
+      }
+    }
+    pkey = ikey;
   }
-  slot_ = slot;
 
-  // submit heartbeat every so often to keep connection alive
-  if ( slot_cnt_++ % PC_HBEAT_INTERVAL == 0 ) {
-    clnt_.send( hreq_ );
+  // connections stay warm across slots while their leader is upcoming
+  for( size_t i=0; i != qvec_.size(); ) {
+    tpu_quic *qptr = qvec_[i];
+    if ( qptr->get_slot() != slot_ ) {
+      delete qptr;
+      qvec_[i] = qvec_.back();
+      qvec_.pop_back();
+      continue;
+    }
+    if ( !qptr->get_is_connect() && !qptr->get_is_wait() ) {
+      if ( qptr->get_is_err() ) {
+        PC_LOG_DBG( "quic reset" )
+          .add( "error", qptr->get_err_msg() )
+          .end();
+      }
+      qptr->init();
+    }
+    ++i;
+  }
+}
+
+void tx_svr::add_addr( const ip_addr& addr, unsigned num )
+{
+  for( tx_route& rt: avec_ ) {
+    if ( rt.addr_ == addr ) {
+      rt.num_ = std::max( rt.num_, num );
+      return;
+    }
   }
+  avec_.push_back( tx_route{ addr, nullptr, num } );
+}
 
-  // request next slot leader schedule
-  if ( PC_UNLIKELY( lreq_->get_is_recv() &&
-                    slot_ > lreq_->get_last_slot() - PC_LEADER_MIN ) ) {
-    lreq_->set_slot( slot_ - PC_LEADER_MIN );
-    clnt_.send( lreq_ );
+void tx_svr::update_routes()
+{
+  // connections only change with the slot so that forwarding does not
+  // need to look them up
+  for( tx_route& rt: avec_ ) {
+    rt.qptr_ = num_quic_ ? find_quic( rt.addr_ ) : nullptr;
   }
+  if ( fan_ ) {
+    std::vector<ip_addr> addr;
+    std::vector<unsigned> num;
+    for( tx_route& rt: avec_ ) {
+      if ( !rt.qptr_ ) {
+        addr.push_back( rt.addr_ );
+        num.push_back( rt.num_ );
+      }
+    }
+    fan_->set_leaders( addr, num );
+  }
+}
 
-  // construct unique list of addresses of the leaders for
-  // the previous and next num_slots
+uint64_t tx_svr::get_num_pkt() const
+{
+  return tconn_.get_num_sent() + ( fan_ ? fan_->get_num_sent() : 0UL );
+}
+
+uint64_t tx_svr::get_num_calls() const
+{
+  return tconn_.get_num_calls() + ( fan_ ? fan_->get_num_calls() : 0UL );
+}
+
+void tx_svr::select_leaders( bool do_land )
+{
+  // construct unique list of addresses of the leaders for the previous
+  // and next few slots. while pythd reports where updates land, leaders
+  // that drop transactions are skipped and later leaders are added until
+  // the chance that one of those targeted lands a transaction is reached
   avec_.clear();
+  tgt_.clear();
+  is_tgt_ = false;
   pub_key *pkey = nullptr;
   ip_addr iaddr;
-  uint64_t max_slot = std::min( slot_+5, lreq_->get_last_slot() );
+  bool is_use = false;
+  double pmiss = 1.;
+  uint64_t max_slot = std::min( slot_ + ( do_land ?
+        std::max( win_, PC_LEADER_AHEAD ) : win_ ), lreq_->get_last_slot() );
+
+  // current and next leader get the most copies
+  pub_key *ckey = lreq_->get_leader( slot_ ), *nkey = nullptr;
+  for( uint64_t slot = slot_+1; ckey && !nkey && slot < max_slot; ++slot ) {
+    pub_key *ikey = lreq_->get_leader( slot );
+    nkey = ikey && *ikey != *ckey ? ikey : nullptr;
+  }
   for( uint64_t slot = slot_-1; slot < max_slot; ++slot ) {
     pub_key *ikey = lreq_->get_leader( slot );
     if ( ikey && ( !pkey || *ikey != *pkey) ) {
-      if ( creq_->get_ip_addr( *ikey, iaddr ) ) {
-        add_addr( iaddr );
+      if ( avec_.size() >= max_ldr_ || ( slot >= slot_ + win_ &&
+           pmiss <= 1. - land_tgt_ ) ) {
+        break;
+      }
+      double rate = do_land ? lstat_.get_rate( *ikey ) : -1.;
+      is_use = rate < 0. || rate >= PC_LAND_MIN_RATE;
+      if ( !is_use ) {
+        PC_LOG_DBG( "skip leader" )
+          .add( "leader", *ikey )
+          .add( "slot", slot )
+          .add( "land_rate", rate )
+          .end();
+        ++num_skip_;
+      } else if ( creq_->get_ip_addr( *ikey, iaddr ) ) {
+        bool is_near = ( ckey && *ikey == *ckey ) ||
+                       ( nkey && *ikey == *nkey );
+        add_addr( iaddr, is_near ? ncopy_ : 1U );
+        pmiss *= 1. - ( rate < 0. ? PC_LAND_PRIOR : rate );
       } else {
+        is_use = false;
         PC_LOG_WRN( "missing leader addr" )
           .add( "leader", *ikey )
           .add( "curr_slot", slot )
           .add( "start_slot", slot_-1 )
-          .add( "end_slot", slot_+4 )
+          .add( "end_slot", max_slot-1 )
           .add( "last_slot", lreq_->get_last_slot() )
           .end();
         if ( creq_->get_is_recv() ) {
@@ -274,11 +627,57 @@ void tx_svr::on_response( rpc::slot_subscribe *res )
         }
       }
     }
+    if ( ikey && is_use ) {
+      tgt_.push_back( slot_leader{ slot, *ikey } );
+    }
     pkey = ikey;
   }
+}
+
+void tx_svr::on_response( rpc::slot_subscribe *res )
+{
+  // check error
+  if ( PC_UNLIKELY( res->get_is_err() ) ) {
+    set_err_msg( "failed to slot_subscribe ["
+        + res->get_err_msg()  + "]" );
+    return;
+  }
+
+  // ignore slots that go back in time
+  uint64_t slot = res->get_slot();
+  if ( slot <= slot_ ) {
+    return;
+  }
+  slot_ = slot;
+
+  // submit heartbeat every so often to keep connection alive
+  if ( slot_cnt_++ % PC_HBEAT_INTERVAL == 0 ) {
+    clnt_.send( hreq_ );
+  }
+
+  // request next slot leader schedule
+  if ( PC_UNLIKELY( lreq_->get_is_recv() &&
+                    slot_ > lreq_->get_last_slot() - PC_LEADER_MIN ) ) {
+    lreq_->set_slot( slot_ - PC_LEADER_MIN );
+    clnt_.send( lreq_ );
+  }
+
+  // leaders to forward to. every leader is used again if all of those
+  // in reach are known to drop transactions
+  is_land_ = lslot_ + PC_LAND_STALE > slot_;
+  lstat_.add_slot( slot_ );
+  select_leaders( is_land_ );
+  if ( avec_.empty() && is_land_ ) {
+    select_leaders( false );
+  }
+  if ( num_quic_ ) {
+    update_quic();
+  }
+  update_routes();
   PC_LOG_DBG( "receive slot" )
     .add( "slot", slot_ )
     .add( "num_leaders", avec_.size() )
+    .add( "num_quic", qvec_.size() )
     .end();
 }
 
@@ -339,8 +738,9 @@ void tx_svr::reconnect_rpc()
     wait_conn_ = false;
     slot_ = 0L;
     avec_.clear();
+    update_routes();
     clnt_.reset();
-    ctimeout_ = PC_NSECS_IN_SEC;
+    ctimeout_ = PC_RECONNECT_MIN;
     lreq_->set_recv_time( lreq_->get_sent_time() );
 
     // subscribe to slots and cluster addresses
@@ -406,6 +806,20 @@ void tx_svr::teardown()
   }
   teardown_users();
 
+  // destroy quic connections
+  for( tpu_quic *qptr: qvec_ ) {
+    delete qptr;
+  }
+  qvec_.clear();
+  avec_.clear();
+
+  // stop forwarding workers
+  if ( fan_ ) {
+    fan_->teardown();
+    delete fan_;
+    fan_ = nullptr;
+  }
+
   // destroy rpc connections
   hconn_.close();
   wconn_.close();
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "tx_rpc_client.hpp"
+#include "tpu_quic.hpp"
+#include "land_stats.hpp"
+#include "tx_dedup.hpp"
+#include "tx_fanout.hpp"
 #include <pc/net_socket.hpp>
 #include <pc/rpc_client.hpp>
 #include <pc/dbl_list.hpp>
@@ -47,6 +51,48 @@ namespace pc
     void set_listen_port( int port );
     int get_listen_port() const;
 
+    // latest slot notified and number of leaders forwarded to in it
+    uint64_t get_slot() const;
+    unsigned get_num_leaders() const;
+
+    // number of upcoming leaders to keep quic connections open to
+    // (0=udp only, the default). udp is used if a connection is not ready
+    void set_num_quic( unsigned );
+    unsigned get_num_quic() const;
+
+    // number of worker threads that forward transactions over udp
+    // (0=forward on the loop thread, the default). quic connections
+    // stay on the loop thread
+    void set_num_workers( unsigned );
+    unsigned get_num_workers() const;
+
+    // slots past the current one whose leaders are forwarded to
+    // (default 5). with landing reports from pythd this is extended
+    // while the landing target is not met
+    void set_lookahead( unsigned );
+    unsigned get_lookahead() const;
+
+    // copies of each transaction sent over udp to the current and the
+    // next leader, which are the most likely to include it (default 1 -
+    // extra copies are opt-in)
+    void set_num_copies( unsigned );
+    unsigned get_num_copies() const;
+
+    // slots a transaction signature is remembered for so that repeats
+    // submitted by other pythd instances are dropped (default 32, 0=off)
+    void set_dedup_window( unsigned slots );
+    unsigned get_dedup_window() const;
+
+    // most leaders a transaction is forwarded to (default 4)
+    void set_max_leaders( unsigned );
+    unsigned get_max_leaders() const;
+
+    // chance that one of the leaders forwarded to lands a transaction.
+    // with landing reports from pythd, leaders past the next few slots
+    // are added until it is reached (default 0.95)
+    void set_land_target( double );
+    double get_land_target() const;
+
     // initialize
     bool init();
 
@@ -62,9 +108,12 @@ namespace pc
     // move user to teardown list
     void del_user( tx_user *usr );
 
-    // send tpu request
+    // queue tpu request for fan-out to leaders at end of poll
     void submit( const char *buf, size_t len );
 
+    // landing report from pythd
+    void add_landed( const tx_land& );
+
     // rpc calbacks
     void on_response( rpc::slot_subscribe * ) override;
     void on_response( rpc::get_cluster_nodes * ) override;
@@ -74,12 +123,37 @@ namespace pc
   private:
 
     typedef dbl_list<tx_user>    user_list_t;
-    typedef std::vector<ip_addr> addr_vec_t;
+    // forwarding destination resolved on slot change
+    struct tx_route {
+      ip_addr   addr_;   // tpu address
+      tpu_quic *qptr_;   // quic connection or null
+      unsigned  num_;    // copies sent over udp
+    };
+
+    typedef std::vector<tx_route> route_vec_t;
+    typedef std::vector<char>    buf_t;
+    typedef std::vector<size_t>  off_vec_t;
+    typedef std::vector<tpu_quic*> quic_vec_t;
+
+    struct slot_leader {
+      uint64_t slot_;
+      pub_key  key_;
+    };
+
+    typedef std::vector<slot_leader> tgt_vec_t;
 
     void reconnect_rpc();
     void log_disconnect();
+    void log_stats();
     void teardown_users();
-    void add_addr( const ip_addr& );
+    void add_addr( const ip_addr&, unsigned num );
+    void update_routes();
+    uint64_t get_num_pkt() const;
+    uint64_t get_num_calls() const;
+    void send_txs();
+    void update_quic();
+    void select_leaders( bool do_land );
+    tpu_quic *find_quic( const ip_addr& );
 
     static const size_t buf_len = 2048;
 
@@ -91,7 +165,7 @@ namespace pc
     ip_addr      src_[1];      // src ip address
     uint64_t     slot_;        // current slot
     uint64_t     slot_cnt_;    // number of slots received
-    addr_vec_t   avec_;        // address vector of leaders
+    route_vec_t  avec_;        // forwarding routes to leaders
     tcp_connect  hconn_;       // rpc http connection
     ws_connect   wconn_;       // rpc websocket sonnection
     udp_socket   tconn_;       // udp sending socket
@@ -101,6 +175,37 @@ namespace pc
     int64_t      cts_;         // (re)connect timestamp
     int64_t      ctimeout_;    // connection timeout
     std::string  rhost_;       // rpc host
+    buf_t        tbuf_;        // transactions received this poll
+    off_vec_t    toff_;        // end offset of each transaction in tbuf_
+    quic_vec_t   qvec_;        // quic connections to upcoming leaders
+    unsigned     num_quic_;    // number of upcoming leaders to connect to
+    tx_fanout   *fan_;         // udp forwarding worker threads
+    unsigned     num_wrk_;     // number of forwarding workers
+    uint64_t     num_inl_;     // transactions too large for workers
+    uint64_t     snum_inl_;    // num_inl_ at last stats log
+    uint64_t     num_tx_;      // transactions submitted
+    uint64_t     num_qtx_;     // transactions sent over quic
+    uint64_t     snum_qtx_;    // num_qtx_ at last stats log
+    uint64_t     snum_tx_;     // num_tx_ at last stats log
+    uint64_t     snum_pkt_;    // packets sent at last stats log
+    uint64_t     snum_call_;   // send calls at last stats log
+    int64_t      sts_;         // last stats log time
+    land_stats   lstat_;       // leader landing statistics
+    tx_dedup     dedup_;       // recently forwarded signatures
+    uint64_t     snum_dchk_;   // dedup checks at last stats log
+    uint64_t     snum_dup_;    // dedup repeats at last stats log
+    tgt_vec_t    tgt_;         // targeted slots of this slot
+    unsigned     max_ldr_;     // most leaders to forward to
+    unsigned     win_;         // leader lookahead in slots
+    unsigned     ncopy_;       // udp copies to current and next leader
+    double       land_tgt_;    // landing probability target
+    uint64_t     lslot_;       // latest reported landing slot
+    uint64_t     num_land_;    // landing reports received
+    uint64_t     num_skip_;    // leaders skipped for dropping txs
+    uint64_t     snum_land_;   // num_land_ at last stats log
+    uint64_t     snum_skip_;   // num_skip_ at last stats log
+    bool         is_land_;     // landing reports are current
+    bool         is_tgt_;      // targeted slots recorded
 
     // rpc subscription info
     rpc::slot_subscribe    sreq_[1];
@@ -0,0 +1,294 @@
+char heap_start[8192];
+#define PC_HEAP_START (heap_start)
+
+#include <oracle/oracle.h>
+#include <oracle/upd_aggregate.h>
+#include <pc/jtree.hpp>
+#include <pc/mem_map.hpp>
+#include <pc/misc.hpp>
+#include <pc/replay.hpp>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace pc;
+
+// native benchmark of the on-chain aggregation: upd_aggregate,
+// price_model_core and upd_twap over the price accounts of the rust
+// aggregation test data and of capture files. reports ns per call and,
+// where the kernel allows hardware counters, user instructions per call
+// as the compute unit estimate (bpf charges one compute unit per
+// instruction and native counts track them closely enough to flag
+// regressions)
+
+#define PC_BENCH_MAX_ACC 4096U
+
+// user instructions retired by this thread
+class insn_counter
+{
+public:
+  insn_counter();
+  ~insn_counter();
+  bool get_is_valid() const { return fd_ >= 0; }
+  uint64_t get() const;
+private:
+  int fd_;
+};
+
+insn_counter::insn_counter()
+{
+  perf_event_attr attr;
+  __builtin_memset( &attr, 0, sizeof( attr ) );
+  attr.type           = PERF_TYPE_HARDWARE;
+  attr.size           = sizeof( attr );
+  attr.config         = PERF_COUNT_HW_INSTRUCTIONS;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  fd_ = (int)::syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0 );
+}
+
+insn_counter::~insn_counter()
+{
+  if ( fd_ >= 0 ) {
+    ::close( fd_ );
+  }
+}
+
+uint64_t insn_counter::get() const
+{
+  uint64_t num = 0UL;
+  if ( fd_ >= 0 && ::read( fd_, &num, sizeof( num ) ) != sizeof( num ) ) {
+    num = 0UL;
+  }
+  return num;
+}
+
+// price accounts of one input with the slot to aggregate them at
+struct agg_set
+{
+  std::string             name_;
+  std::vector<pc_price_t> pvec_;
+  std::vector<uint64_t>   svec_;
+};
+
+static void add_price( agg_set& st, const pc_price_t *ptr )
+{
+  st.pvec_.push_back( *ptr );
+  uint64_t slot = 0UL;
+  for( uint32_t i = 0; i != ptr->num_ && i != PC_NUM_COMP; ++i ) {
+    slot = std::max( slot, ptr->comp_[i].latest_.pub_slot_ );
+  }
+  st.pvec_.back().num_ = std::min( ptr->num_, (uint32_t)PC_NUM_COMP );
+  st.svec_.push_back( slot + 1UL );
+}
+
+// aggregation test cases: exponent and quotes of price, conf and status
+static bool load_test_data( const std::string& dir, agg_set& st )
+{
+  DIR *dp = ::opendir( dir.c_str() );
+  if ( !dp ) {
+    std::cerr << "bench_aggregate: failed to open " << dir << std::endl;
+    return false;
+  }
+  std::vector<std::string> files;
+  while( dirent *ep = ::readdir( dp ) ) {
+    std::string file = ep->d_name;
+    if ( file.size() > 5 && file.substr( file.size() - 5 ) == ".json" ) {
+      files.push_back( dir + "/" + file );
+    }
+  }
+  ::closedir( dp );
+  std::sort( files.begin(), files.end() );
+  pc_price_t *ptr = new pc_price_t;
+  for( const std::string& file: files ) {
+    mem_map mp;
+    mp.set_file( file );
+    if ( !mp.init() ) {
+      std::cerr << "bench_aggregate: failed to read " << file << std::endl;
+      continue;
+    }
+    jtree jt;
+    jt.parse( mp.data(), mp.size() );
+    __builtin_memset( (void*)ptr, 0, sizeof( pc_price_t ) );
+    ptr->expo_ = (int32_t)jt.get_int( jt.find_val( 1, "exponent" ) );
+    uint32_t qt = jt.find_val( 1, "quotes" );
+    for( uint32_t it = jt.get_first( qt ); it && ptr->num_ != PC_NUM_COMP;
+         it = jt.get_next( it ) ) {
+      pc_price_info_t& lt = ptr->comp_[ptr->num_++].latest_;
+      lt.price_    = jt.get_int( jt.find_val( it, "price" ) );
+      lt.conf_     = jt.get_uint( jt.find_val( it, "conf" ) );
+      lt.status_   = (uint32_t)jt.get_uint( jt.find_val( it, "status" ) );
+      lt.pub_slot_ = 1000UL;
+    }
+    add_price( st, ptr );
+  }
+  delete ptr;
+  st.name_ = dir;
+  return !st.pvec_.empty();
+}
+
+// price account records of a capture
+static bool load_capture( const std::string& file, agg_set& st )
+{
+  replay rep;
+  rep.set_file( file );
+  if ( !rep.init() ) {
+    std::cerr << "bench_aggregate: " << rep.get_err_msg() << std::endl;
+    return false;
+  }
+  pc_price_t *ptr = new pc_price_t;
+  while( st.pvec_.size() != PC_BENCH_MAX_ACC && rep.get_next() ) {
+    const pc_acc_t *aptr = rep.get_update();
+    if ( aptr->type_ != PC_ACCTYPE_PRICE ) {
+      continue;
+    }
+    // captures hold the populated region of the account
+    __builtin_memset( (void*)ptr, 0, sizeof( pc_price_t ) );
+    __builtin_memcpy( (void*)ptr, aptr,
+        std::min( (size_t)aptr->size_, sizeof( pc_price_t ) ) );
+    if ( ptr->num_ ) {
+      add_price( st, ptr );
+    }
+  }
+  delete ptr;
+  st.name_ = file;
+  if ( st.pvec_.empty() ) {
+    std::cerr << "bench_aggregate: no price accounts in " << file
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+struct bench_res
+{
+  double ns_;
+  double insn_;
+};
+
+template<class F>
+static bench_res run( const insn_counter& ic, unsigned num_iter,
+                      size_t num, F fn )
+{
+  int64_t  ts = get_now();
+  uint64_t i0 = ic.get();
+  for( unsigned it = 0; it != num_iter; ++it ) {
+    for( size_t i = 0; i != num; ++i ) {
+      fn( i );
+    }
+  }
+  double dn = (double)num_iter * (double)num;
+  bench_res res;
+  res.insn_ = (double)( ic.get() - i0 ) / dn;
+  res.ns_   = (double)( get_now() - ts ) / dn;
+  return res;
+}
+
+static void print( const insn_counter& ic, const char *name,
+                   const bench_res& res )
+{
+  std::cout << "  " << name << ": " << res.ns_ << "ns";
+  if ( ic.get_is_valid() ) {
+    std::cout << " " << (uint64_t)res.insn_ << "insn";
+  }
+  std::cout << std::endl;
+}
+
+static void bench( const insn_counter& ic, unsigned num_iter, agg_set& st )
+{
+  // the model inputs upd_aggregate builds from the valid quotes
+  size_t num = st.pvec_.size();
+  std::vector<std::vector<int64_t>> qvec( num );
+  uint64_t num_qt = 0UL;
+  for( size_t i = 0; i != num; ++i ) {
+    const pc_price_t& px = st.pvec_[i];
+    for( uint32_t j = 0; j != px.num_; ++j ) {
+      const pc_price_info_t& lt = px.comp_[j].latest_;
+      int64_t conf = (int64_t)lt.conf_;
+      if ( lt.status_ == PC_STATUS_TRADING && conf > 0 &&
+           INT64_MIN + conf <= lt.price_ && lt.price_ <= INT64_MAX - conf &&
+           (int64_t)( st.svec_[i] - lt.pub_slot_ ) <=
+             ( px.max_latency_ ? px.max_latency_ : PC_MAX_SEND_LATENCY ) ) {
+        qvec[i].push_back( lt.price_ - conf );
+        qvec[i].push_back( lt.price_ );
+        qvec[i].push_back( lt.price_ + conf );
+      }
+    }
+    num_qt += px.num_;
+  }
+  std::cout << st.name_ << ": accounts: " << num
+            << " avg quotes: " << (double)num_qt / (double)num << std::endl;
+
+  int64_t sink = 0;
+  print( ic, "upd_aggregate", run( ic, num_iter, num, [&]( size_t i ) {
+    sink += upd_aggregate( &st.pvec_[i], st.svec_[i], 0L );
+  } ) );
+  std::vector<int64_t> quote( 3 * PC_NUM_COMP ), scratch( 3 * PC_NUM_COMP );
+  print( ic, "price_model_core", run( ic, num_iter, num, [&]( size_t i ) {
+    const std::vector<int64_t>& qt = qvec[i];
+    if ( !qt.empty() ) {
+      int64_t p25, p50, p75;
+      __builtin_memcpy( &quote[0], &qt[0], qt.size() * sizeof( int64_t ) );
+      price_model_core( qt.size(), &quote[0], &p25, &p50, &p75, &scratch[0] );
+      sink += p50;
+    }
+  } ) );
+  print( ic, "upd_twap", run( ic, num_iter, num, [&]( size_t i ) {
+    upd_twap( &st.pvec_[i], 1L );
+    sink += st.pvec_[i].twap_.val_;
+  } ) );
+  std::cout << "  sink: " << ( sink & 1 ) << std::endl;
+}
+
+int usage()
+{
+  std::cerr << "usage: bench_aggregate [options] [capture file ...]"
+            << std::endl;
+  std::cerr << "options include:" << std::endl;
+  std::cerr << "  -a <aggregation test data directory (default "
+            << "program/rust/test_data/aggregation)>" << std::endl;
+  std::cerr << "  -n <number of iterations (default 1000)>" << std::endl;
+  return 1;
+}
+
+int main( int argc, char **argv )
+{
+  std::string test_dir = "program/rust/test_data/aggregation";
+  unsigned num_iter = 1000;
+  int opt = 0;
+  while( (opt = ::getopt(argc,argv, "a:n:h" )) != -1 ) {
+    switch(opt) {
+      case 'a': test_dir = optarg; break;
+      case 'n': num_iter = (unsigned)::atoi( optarg ); break;
+      default: return usage();
+    }
+  }
+  if ( !num_iter ) {
+    return usage();
+  }
+  insn_counter ic;
+  if ( !ic.get_is_valid() ) {
+    std::cerr << "bench_aggregate: no instruction counter, "
+              << "reporting times only" << std::endl;
+  }
+  agg_set st;
+  if ( !load_test_data( test_dir, st ) ) {
+    return 1;
+  }
+  bench( ic, num_iter, st );
+  for( int i = optind; i < argc; ++i ) {
+    agg_set cs;
+    if ( !load_capture( argv[i], cs ) ) {
+      return 1;
+    }
+    bench( ic, num_iter, cs );
+  }
+  return 0;
+}
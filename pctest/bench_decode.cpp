@@ -0,0 +1,72 @@
+#include <pc/rpc_client.hpp>
+#include <pc/misc.hpp>
+#include <oracle/oracle.h>
+#include <zstd.h>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace pc;
+
+// account update decode micro-benchmark: base64 and zstd in isolation
+// followed by the streamed path used by rpc_client
+
+static const int num_iter = 100000;
+
+static void report( const char *name, int64_t ns )
+{
+  std::cout << name << ": " << (double)ns/(double)num_iter << "ns/op"
+            << std::endl;
+}
+
+int main( int, char** )
+{
+  // price account with sparsely populated component prices
+  std::mt19937 rnd( 1 );
+  std::vector<char> acc( sizeof( pc_price_t ), 0 );
+  for( size_t i=0; i < acc.size()/4; ++i ) {
+    acc[rnd()%acc.size()] = (char)rnd();
+  }
+  std::vector<char> zbuf( ZSTD_compressBound( acc.size() ) );
+  size_t zlen = ZSTD_compress(
+      &zbuf[0], zbuf.size(), &acc[0], acc.size(), 3 );
+  std::string txt( enc_base64_len( zlen ), '\0' );
+  txt.resize( enc_base64( (const uint8_t*)&zbuf[0], (int)zlen, &txt[0] ) );
+  std::cout << "account: " << acc.size() << " zstd: " << zlen
+            << " base64: " << txt.size() << std::endl;
+
+  volatile size_t sink = 0;
+  std::vector<char> dbuf( txt.size() );
+  std::vector<char> obuf( acc.size() );
+
+  // base64 only
+  int64_t ts = get_now();
+  for( int i=0; i != num_iter; ++i ) {
+    sink += dec_base64( txt.c_str(), (int)txt.size(), (uint8_t*)&dbuf[0] );
+  }
+  report( "base64", get_now() - ts );
+
+  // zstd only
+  ZSTD_DCtx *cxt = ZSTD_createDCtx();
+  ts = get_now();
+  for( int i=0; i != num_iter; ++i ) {
+    sink += ZSTD_decompressDCtx(
+        cxt, &obuf[0], obuf.size(), &zbuf[0], zlen );
+  }
+  report( "zstd", get_now() - ts );
+  ZSTD_freeDCtx( cxt );
+
+  // streamed base64 into zstd
+  rpc_client clnt;
+  ts = get_now();
+  for( int i=0; i != num_iter; ++i ) {
+    sink += clnt.get_data_val(
+        txt.c_str(), txt.size(), obuf.size(), &obuf[0] );
+  }
+  report( "base64+zstd", get_now() - ts );
+  if ( obuf != acc ) {
+    std::cerr << "bench_decode: decoded account mismatch" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+#include <pc/manager.hpp>
+#include <pc/misc.hpp>
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace pc;
+
+// pending price update queue: n prices updated several times per slot
+// and drained in batches as in manager::send_pending_ups. compares
+// price_queue with the previous linear search and front erase
+
+static const unsigned num_slot  = 200;
+static const unsigned num_dup   = 4;
+static const unsigned batch_len = 8;
+
+int main( int, char** )
+{
+  std::mt19937 rnd( 1 );
+  pub_key acc;
+  product prod( acc );
+  price_arena arena;
+  for( unsigned num = 64; num <= 4096; num *= 4 ) {
+    std::vector<price*> pvec;
+    for( unsigned i = 0; i != num; ++i ) {
+      pvec.push_back( new price( acc, &prod, &arena ) );
+    }
+    std::vector<price*> upds;
+    for( unsigned i = 0; i != num_dup; ++i ) {
+      upds.insert( upds.end(), pvec.begin(), pvec.end() );
+    }
+    std::shuffle( upds.begin(), upds.end(), rnd );
+    std::vector<price*> batch( batch_len );
+    const double num_upd = (double)num_slot * (double)upds.size();
+
+    // price_queue
+    price_queue pq;
+    uint64_t sink = 0;
+    int64_t ts = get_now();
+    for( unsigned s = 0; s != num_slot; ++s ) {
+      for( price *ptr: upds ) {
+        pq.add( ptr );
+      }
+      while( pq.size() ) {
+        sink += pq.pop( &batch[0], batch_len );
+      }
+    }
+    double pq_ns = (double)( get_now() - ts ) / num_upd;
+
+    // vector with linear search and erase from front
+    std::vector<price*> vec;
+    ts = get_now();
+    for( unsigned s = 0; s != num_slot; ++s ) {
+      for( price *ptr: upds ) {
+        if ( std::find( vec.begin(), vec.end(), ptr ) == vec.end() ) {
+          vec.push_back( ptr );
+        }
+      }
+      while( !vec.empty() ) {
+        size_t n = std::min( vec.size(), (size_t)batch_len );
+        sink += n;
+        vec.erase( vec.begin(), vec.begin() + (long)n );
+      }
+    }
+    double vec_ns = (double)( get_now() - ts ) / num_upd;
+
+    std::cout << "prices: " << num
+              << " price_queue: " << pq_ns << "ns/upd"
+              << " vector: " << vec_ns << "ns/upd"
+              << " sent: " << sink << std::endl;
+    for( price *ptr: pvec ) {
+      delete ptr;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include <pc/hash_map.hpp>
+#include <pc/key_pair.hpp>
+#include <pc/misc.hpp>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace pc;
+
+// account lookups by pub_key as in manager::trait_account. compares the
+// fixed-size chained hash_map with the growable open_hash_map as the
+// number of accounts approaches and exceeds the chained bucket count
+
+struct trait_account
+{
+  static const size_t hsize_ = 8363UL;
+  typedef uint32_t        idx_t;
+  typedef pub_key         key_t;
+  typedef const pub_key&  keyref_t;
+  typedef uint32_t        val_t;
+  struct hash_t {
+    idx_t operator() ( keyref_t a ) {
+      uint64_t *i = (uint64_t*)a.data();
+      return *i;
+    }
+  };
+};
+
+static const unsigned num_iter = 4;
+
+template<class M>
+static void run( const char *name, const std::vector<pub_key>& kvec,
+                 const std::vector<pub_key>& mvec )
+{
+  M *hmap = new M;
+  uint64_t sink = 0;
+
+  int64_t ts = get_now();
+  for( unsigned i = 0; i != kvec.size(); ++i ) {
+    hmap->ref( hmap->add( kvec[i] ) ) = i;
+  }
+  double add_ns = (double)( get_now() - ts ) / (double)kvec.size();
+
+  ts = get_now();
+  for( unsigned j = 0; j != num_iter; ++j ) {
+    for( const pub_key& k: kvec ) {
+      typename M::iter_t it = hmap->find( k );
+      sink += it ? hmap->obj( it ) : 0;
+    }
+  }
+  double hit_ns = (double)( get_now() - ts ) /
+    (double)( num_iter * kvec.size() );
+
+  ts = get_now();
+  for( unsigned j = 0; j != num_iter; ++j ) {
+    for( const pub_key& k: mvec ) {
+      sink += hmap->find( k ) ? 1UL : 0UL;
+    }
+  }
+  double miss_ns = (double)( get_now() - ts ) /
+    (double)( num_iter * mvec.size() );
+
+  std::cout << name << ": num=" << kvec.size()
+            << " add_ns=" << add_ns
+            << " find_ns=" << hit_ns
+            << " miss_ns=" << miss_ns
+            << " sink=" << sink % 2 << std::endl;
+  delete hmap;
+}
+
+static void gen_keys( std::mt19937_64& rnd, std::vector<pub_key>& kvec,
+                      unsigned num )
+{
+  kvec.resize( num );
+  for( pub_key& k: kvec ) {
+    uint64_t *ptr = (uint64_t*)k.data();
+    for( unsigned i = 0; i != sizeof( pub_key ) / sizeof( uint64_t ); ++i ) {
+      ptr[i] = rnd();
+    }
+  }
+}
+
+int main( int, char** )
+{
+  std::mt19937_64 rnd( 1 );
+  for( unsigned num = 1000; num <= 64000; num *= 4 ) {
+    std::vector<pub_key> kvec, mvec;
+    gen_keys( rnd, kvec, num );
+    gen_keys( rnd, mvec, num );
+    run<hash_map<trait_account>>( "hash_map", kvec, mvec );
+    run<open_hash_map<trait_account>>( "open_hash_map", kvec, mvec );
+  }
+  return 0;
+}
@@ -0,0 +1,399 @@
+#include <pc/bincode.hpp>
+#include <pc/hash_map.hpp>
+#include <pc/jtree.hpp>
+#include <pc/key_pair.hpp>
+#include <pc/mem_map.hpp>
+#include <pc/misc.hpp>
+#include <pc/net_socket.hpp>
+#include <pc/rpc_client.hpp>
+#include <oracle/oracle.h>
+#include <zstd.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace pc;
+
+// micro-benchmarks of the libpc primitives on the publishing and
+// subscription paths. each benchmark doubles its iteration count until
+// it runs for at least the minimum time and results are written to
+// stdout as json for tracking across releases. extra arguments are json
+// files (for example captured rpc payloads) to time jtree::parse on
+
+struct bench_res
+{
+  std::string name_;
+  uint64_t    iter_;
+  double      ns_;     // per op
+  size_t      bytes_;  // per op
+};
+
+typedef std::vector<bench_res> res_vec_t;
+
+static int64_t min_ns = 200L * PC_NSECS_IN_MSEC;
+static volatile uint64_t sink = 0UL;
+
+// time fn which does num_op operations of bytes each per call
+template<class F>
+static void run( res_vec_t& rvec, const std::string& name, size_t bytes,
+                 uint64_t num_op, F fn )
+{
+  uint64_t iter = 1UL;
+  int64_t  tot  = 0L;
+  for(;;) {
+    int64_t ts = get_now();
+    for( uint64_t i = 0; i != iter; ++i ) {
+      fn();
+    }
+    tot = get_now() - ts;
+    if ( tot >= min_ns || iter >= ( 1UL << 40 ) ) {
+      break;
+    }
+    iter *= 2UL;
+  }
+  bench_res res;
+  res.name_  = name;
+  res.iter_  = iter * num_op;
+  res.ns_    = (double)tot / (double)res.iter_;
+  res.bytes_ = bytes;
+  rvec.push_back( res );
+  std::cerr << name << ": " << res.ns_ << "ns/op" << std::endl;
+}
+
+struct trait_account
+{
+  static const size_t hsize_ = 8363UL;
+  typedef uint32_t        idx_t;
+  typedef pub_key         key_t;
+  typedef const pub_key&  keyref_t;
+  typedef uint32_t        val_t;
+  struct hash_t {
+    idx_t operator() ( keyref_t a ) {
+      uint64_t *i = (uint64_t*)a.data();
+      return *i;
+    }
+  };
+};
+
+typedef hash_map<trait_account> acc_map_t;
+
+static void gen_key( std::mt19937_64& rnd, pub_key& k )
+{
+  uint64_t *ptr = (uint64_t*)k.data();
+  for( unsigned i = 0; i != sizeof( pub_key ) / sizeof( uint64_t ); ++i ) {
+    ptr[i] = rnd();
+  }
+}
+
+// price account with sparsely populated component prices as zstd and
+// base64 encoded by the rpc node
+static std::string gen_account_data( std::mt19937_64& rnd, size_t& len )
+{
+  std::vector<char> acc( sizeof( pc_price_t ), 0 );
+  for( size_t i=0; i < acc.size()/4; ++i ) {
+    acc[rnd()%acc.size()] = (char)rnd();
+  }
+  std::vector<char> zbuf( ZSTD_compressBound( acc.size() ) );
+  size_t zlen = ZSTD_compress(
+      &zbuf[0], zbuf.size(), &acc[0], acc.size(), 3 );
+  std::string txt( enc_base64_len( zlen ), '\0' );
+  txt.resize( enc_base64( (const uint8_t*)&zbuf[0], (int)zlen, &txt[0] ) );
+  len = acc.size();
+  return txt;
+}
+
+static void bench_jtree( res_vec_t& rvec, const std::string& name,
+                         const char *buf, size_t len )
+{
+  jtree jt;
+  run( rvec, "jtree_parse_" + name, len, 1UL, [&]() {
+    jt.parse( buf, len );
+    sink += jt.is_valid();
+  } );
+}
+
+static void bench_json_wtr( res_vec_t& rvec, const pub_key& acc )
+{
+  // notify_price as sent to pythd subscribers
+  json_wtr jw;
+  auto fn = [&]() {
+    jw.reset();
+    jw.add_val( json_wtr::e_obj );
+    jw.add_key( "jsonrpc", "2.0" );
+    jw.add_key( "method", "notify_price" );
+    jw.add_key( "params", json_wtr::e_obj );
+    jw.add_key( "result", json_wtr::e_obj );
+    jw.add_key( "account", acc );
+    jw.add_key( "price", (int64_t)12345678901L );
+    jw.add_key( "conf", (uint64_t)1234567UL );
+    jw.add_key( "twap", (int64_t)12345600000L );
+    jw.add_key( "twac", (uint64_t)1200000UL );
+    jw.add_key( "status", "trading" );
+    jw.add_key( "num_qt", (uint64_t)24UL );
+    jw.add_key( "valid_slot", (uint64_t)123456788UL );
+    jw.add_key( "pub_slot", (uint64_t)123456789UL );
+    jw.pop();
+    jw.add_key( "subscription", (uint64_t)42UL );
+    jw.pop();
+    jw.pop();
+    sink += jw.size();
+  };
+  fn();
+  run( rvec, "json_wtr_notify_price", jw.size(), 1UL, fn );
+}
+
+static void bench_base( res_vec_t& rvec, std::mt19937_64& rnd )
+{
+  pub_key pk;
+  gen_key( rnd, pk );
+  char txt[64];
+  int tlen = pk.enc_base58( txt, (int)sizeof( txt ) );
+  run( rvec, "enc_base58_pub_key", pub_key::len, 1UL, [&]() {
+    sink += (uint64_t)pk.enc_base58( txt, (int)sizeof( txt ) );
+  } );
+  pub_key dk;
+  run( rvec, "dec_base58_pub_key", (size_t)tlen, 1UL, [&]() {
+    sink += (uint64_t)dk.dec_base58( (const uint8_t*)txt, tlen );
+  } );
+  uint8_t gbuf[128];
+  run( rvec, "enc_base58_generic_32", pub_key::len, 1UL, [&]() {
+    sink += (uint64_t)enc_base58( pk.data(), (int)pub_key::len, txt,
+                                  (int)sizeof( txt ) );
+  } );
+  run( rvec, "dec_base58_generic_32", (size_t)tlen, 1UL, [&]() {
+    sink += (uint64_t)dec_base58( (const uint8_t*)txt, tlen, gbuf );
+  } );
+  signature sig;
+  for( unsigned i = 0; i != signature::len; ++i ) {
+    gbuf[i] = (uint8_t)rnd();
+  }
+  sig.init_from_buf( gbuf );
+  char stxt[128];
+  int slen = sig.enc_base58( stxt, (int)sizeof( stxt ) );
+  run( rvec, "enc_base58_signature", signature::len, 1UL, [&]() {
+    sink += (uint64_t)sig.enc_base58( stxt, (int)sizeof( stxt ) );
+  } );
+  run( rvec, "dec_base58_signature", (size_t)slen, 1UL, [&]() {
+    sink += (uint64_t)dec_base58_64( (const uint8_t*)stxt, slen, gbuf );
+  } );
+  run( rvec, "enc_base58_generic_64", signature::len, 1UL, [&]() {
+    sink += (uint64_t)enc_base58( sig.data(), (int)signature::len, stxt,
+                                  (int)sizeof( stxt ) );
+  } );
+  run( rvec, "dec_base58_generic_64", (size_t)slen, 1UL, [&]() {
+    sink += (uint64_t)dec_base58( (const uint8_t*)stxt, slen, gbuf );
+  } );
+  std::vector<uint8_t> raw( 4096 );
+  for( uint8_t& c: raw ) {
+    c = (uint8_t)rnd();
+  }
+  std::string b64( enc_base64_len( raw.size() ), '\0' );
+  b64.resize( enc_base64( &raw[0], (int)raw.size(), &b64[0] ) );
+  std::vector<uint8_t> out( raw.size() );
+  run( rvec, "dec_base64_4k", b64.size(), 1UL, [&]() {
+    sink += dec_base64( b64.c_str(), (int)b64.size(), &out[0] );
+  } );
+}
+
+static void bench_data_val( res_vec_t& rvec, std::mt19937_64& rnd )
+{
+  size_t alen = 0;
+  std::string txt = gen_account_data( rnd, alen );
+  std::vector<char> obuf( alen );
+  rpc_client clnt;
+  run( rvec, "get_data_val_price_account", txt.size(), 1UL, [&]() {
+    sink += clnt.get_data_val(
+        txt.c_str(), txt.size(), obuf.size(), &obuf[0] );
+  } );
+}
+
+static void bench_sign( res_vec_t& rvec, const key_cache& kc )
+{
+  std::vector<uint8_t> msg( 256, 0x5a );
+  signature sig;
+  run( rvec, "sign_key_cache", msg.size(), 1UL, [&]() {
+    sig.sign( &msg[0], (uint32_t)msg.size(), kc );
+    sink += sig.data()[0];
+  } );
+}
+
+static void bench_upd_price( res_vec_t& rvec, std::mt19937_64& rnd,
+                             key_pair& kp, key_cache& kc )
+{
+  // batches of price updates as built by price::send and the tx proxy
+  static const unsigned max_upd = 8;
+  pub_key pgm;
+  hash bh;
+  gen_key( rnd, pgm );
+  gen_key( rnd, *(pub_key*)&bh );
+  std::vector<pub_key> acc( max_upd );
+  std::vector<rpc::upd_price> uvec( max_upd );
+  std::vector<rpc::upd_price*> upds( max_upd );
+  for( unsigned i = 0; i != max_upd; ++i ) {
+    gen_key( rnd, acc[i] );
+    rpc::upd_price& upd = uvec[i];
+    upd.set_publish( &kp );
+    upd.set_pubcache( &kc );
+    upd.set_account( &acc[i] );
+    upd.set_program( &pgm );
+    upd.set_block_hash( &bh );
+    upd.set_price( 12345678901L + i, 1234567UL, symbol_status::e_trading,
+                   false );
+    upd.set_slot( 123456789UL );
+    upds[i] = &upd;
+  }
+  net_buf *bptr = net_buf::alloc();
+  for( unsigned n = 1; n <= max_upd; n *= 2 ) {
+    size_t sig_idx = 0, msg_idx = 0;
+    bincode tx( bptr->buf_ );
+    rpc::upd_price::build_msg( tx, &upds[0], n, 20000, 1000,
+                               sig_idx, msg_idx );
+    size_t len = tx.size();
+    run( rvec, "upd_price_build_msg_" + std::to_string( n ), len, 1UL,
+         [&]() {
+      bincode bt( bptr->buf_ );
+      rpc::upd_price::build_msg( bt, &upds[0], n, 20000, 1000,
+                                 sig_idx, msg_idx );
+      sink += bt.size();
+    } );
+    net_wtr wtr;
+    run( rvec, "upd_price_build_tx_" + std::to_string( n ), len, 1UL,
+         [&]() {
+      sink += rpc::upd_price::build( wtr, &upds[0], n, 20000, 1000 );
+    } );
+  }
+  bptr->dealloc();
+}
+
+static void bench_hash_map( res_vec_t& rvec, std::mt19937_64& rnd )
+{
+  // accounts of a large mapping in the manager's account map
+  static const unsigned num_key = 4096;
+  std::vector<pub_key> kvec( num_key );
+  for( pub_key& k: kvec ) {
+    gen_key( rnd, k );
+  }
+  acc_map_t *hmap = new acc_map_t;
+  run( rvec, "hash_map_add", sizeof( pub_key ), num_key, [&]() {
+    hmap->clear();
+    for( unsigned i = 0; i != num_key; ++i ) {
+      hmap->ref( hmap->add( kvec[i] ) ) = i;
+    }
+  } );
+  run( rvec, "hash_map_find", sizeof( pub_key ), num_key, [&]() {
+    for( const pub_key& k: kvec ) {
+      acc_map_t::iter_t it = hmap->find( k );
+      sink += it ? hmap->obj( it ) : 0U;
+    }
+  } );
+  delete hmap;
+}
+
+static void bench_net_wtr( res_vec_t& rvec )
+{
+  // small appends as done by json_wtr and the websocket framing
+  static const unsigned num_add = 256;
+  std::string blk( 64, 'x' );
+  net_wtr wtr;
+  run( rvec, "net_wtr_append_64", blk.size(), num_add, [&]() {
+    wtr.reset();
+    for( unsigned i = 0; i != num_add; ++i ) {
+      wtr.add( str( blk ) );
+    }
+    sink += wtr.size();
+  } );
+}
+
+static void print( const res_vec_t& rvec )
+{
+  json_wtr jw;
+  jw.add_val( json_wtr::e_obj );
+  jw.add_key( "version", (uint64_t)PC_VERSION );
+  jw.add_key( "min_time_ns", (uint64_t)min_ns );
+  jw.add_key( "results", json_wtr::e_arr );
+  for( const bench_res& res: rvec ) {
+    jw.add_val( json_wtr::e_obj );
+    jw.add_key( "name", res.name_ );
+    jw.add_key( "iter", res.iter_ );
+    jw.add_key_verbatim( "ns_per_op", std::to_string( res.ns_ ) );
+    jw.add_key_verbatim( "ops_per_sec", std::to_string( 1e9 / res.ns_ ) );
+    jw.add_key( "bytes_per_op", (uint64_t)res.bytes_ );
+    jw.add_key_verbatim( "mb_per_sec", std::to_string(
+          1e3 * (double)res.bytes_ / res.ns_ ) );
+    jw.pop();
+  }
+  jw.pop();
+  jw.pop();
+  jw.print();
+}
+
+int usage()
+{
+  std::cerr << "usage: bench_pc [options] [json file ...]" << std::endl;
+  std::cerr << "options include:" << std::endl;
+  std::cerr << "  -t <minimum time per benchmark in ms (default 200)>"
+            << std::endl;
+  return 1;
+}
+
+int main( int argc, char **argv )
+{
+  int opt = 0;
+  while( (opt = ::getopt(argc,argv, "t:h" )) != -1 ) {
+    switch(opt) {
+      case 't': min_ns = ::atol( optarg ) * PC_NSECS_IN_MSEC; break;
+      default: return usage();
+    }
+  }
+  if ( min_ns <= 0L ) {
+    return usage();
+  }
+
+  std::mt19937_64 rnd( 1 );
+  key_pair kp;
+  kp.gen();
+  key_cache kc;
+  kc.set( kp );
+  pub_key acc;
+  gen_key( rnd, acc );
+  res_vec_t rvec;
+
+  // rpc payloads: account notification and block hash reply
+  size_t alen = 0;
+  std::string data = gen_account_data( rnd, alen );
+  std::string anot =
+    "{\"jsonrpc\":\"2.0\",\"method\":\"accountNotification\",\"params\":"
+    "{\"result\":{\"context\":{\"slot\":123456789},\"value\":{\"data\":[\"" +
+    data + "\",\"base64+zstd\"],\"executable\":false,\"lamports\":"
+    "23942400,\"owner\":\"FsJ3A3u2vn5cTVofAjvy6y5kwABJAqYWpe4975bi2epH\","
+    "\"rentEpoch\":361}},\"subscription\":42}}";
+  std::string bhash =
+    "{\"jsonrpc\":\"2.0\",\"result\":{\"context\":{\"slot\":123456789},"
+    "\"value\":{\"blockhash\":\"CSymwgTNX1j3E4qhKfJAUE41nBWEwXufoYryPbkde5RR\","
+    "\"feeCalculator\":{\"lamportsPerSignature\":5000}}},\"id\":7}";
+  bench_jtree( rvec, "account_notify", anot.c_str(), anot.size() );
+  bench_jtree( rvec, "block_hash", bhash.c_str(), bhash.size() );
+  for( int i = optind; i < argc; ++i ) {
+    mem_map mp;
+    mp.set_file( argv[i] );
+    if ( !mp.init() ) {
+      std::cerr << "bench_pc: failed to read " << argv[i] << std::endl;
+      return 1;
+    }
+    std::string name = argv[i];
+    name = name.substr( name.find_last_of( '/' ) + 1 );
+    bench_jtree( rvec, name, mp.data(), mp.size() );
+  }
+  bench_json_wtr( rvec, acc );
+  bench_base( rvec, rnd );
+  bench_data_val( rvec, rnd );
+  bench_sign( rvec, kc );
+  bench_upd_price( rvec, rnd, kp, kc );
+  bench_hash_map( rvec, rnd );
+  bench_net_wtr( rvec );
+  print( rvec );
+  return 0;
+}
@@ -0,0 +1,72 @@
+#include <pc/misc.hpp>
+#include <oracle/oracle.h>
+#include <oracle/model/price_model.h>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#define SORT_NAME  merge_sort
+#define SORT_KEY_T int64_t
+#include <oracle/sort/tmpl/sort_stable.c>
+
+using namespace pc;
+
+// aggregate price model as run by upd_aggregate: 3 quotes (price-conf,
+// price, price+conf) per publisher for publisher counts up to
+// PC_NUM_COMP. compares price_model_core with the network base cases
+// against the plain mergesort (and reading off the same quantiles)
+
+static const unsigned num_set  = 16384;
+static const unsigned num_iter = 64;
+
+int main( int, char** )
+{
+  std::mt19937_64 rnd( 1 );
+  const unsigned pvec[] = { 1, 2, 4, 8, 10, 16, 20, 24, 32, 48, PC_NUM_COMP };
+  for( unsigned num_pub: pvec ) {
+    const unsigned cnt = 3 * num_pub;
+
+    // publisher prices around 1e8 with confidences of ~0.1%
+    std::vector<int64_t> qvec( num_set * cnt );
+    for( unsigned i = 0; i != num_set; ++i ) {
+      for( unsigned j = 0; j != num_pub; ++j ) {
+        int64_t price = 100000000L + (int64_t)( rnd() % 1000000UL );
+        int64_t conf  = 1L + (int64_t)( rnd() % 100000UL );
+        int64_t *qt = &qvec[i*cnt+3*j];
+        qt[0] = price - conf;
+        qt[1] = price;
+        qt[2] = price + conf;
+      }
+    }
+    std::vector<int64_t> quote( cnt ), scratch( cnt );
+    int64_t p25, p50, p75, sink = 0;
+
+    int64_t ts = get_now();
+    for( unsigned it = 0; it != num_iter; ++it ) {
+      for( unsigned i = 0; i != num_set; ++i ) {
+        __builtin_memcpy( &quote[0], &qvec[i*cnt], cnt*sizeof(int64_t) );
+        price_model_core( cnt, &quote[0], &p25, &p50, &p75, &scratch[0] );
+        sink += p50;
+      }
+    }
+    double net_ns = (double)( get_now() - ts ) / ( num_iter * num_set );
+
+    ts = get_now();
+    for( unsigned it = 0; it != num_iter; ++it ) {
+      for( unsigned i = 0; i != num_set; ++i ) {
+        __builtin_memcpy( &quote[0], &qvec[i*cnt], cnt*sizeof(int64_t) );
+        int64_t *srt = merge_sort_stable( &quote[0], cnt, &scratch[0] );
+        sink += srt[cnt>>2] + srt[cnt>>1] + srt[cnt-1-(cnt>>2)];
+      }
+    }
+    double merge_ns = (double)( get_now() - ts ) / ( num_iter * num_set );
+
+    std::cout << "publishers: " << num_pub
+              << " quotes: " << cnt
+              << " price_model: " << net_ns << "ns"
+              << " mergesort: " << merge_ns << "ns"
+              << " speedup: " << merge_ns / net_ns
+              << " sink: " << ( sink & 1 ) << std::endl;
+  }
+  return 0;
+}
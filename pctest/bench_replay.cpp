@@ -0,0 +1,806 @@
+#include <pc/manager.hpp>
+#include <pc/account_source.hpp>
+#include <pc/replay.hpp>
+#include <pc/jtree.hpp>
+#include <pc/log.hpp>
+#include <pc/misc.hpp>
+#include "mock_rpc.hpp"
+#include <oracle/oracle.h>
+#include <zlib.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace pc;
+
+// end-to-end replay benchmark: a capture is read with replay and its
+// account updates are handed to a manager through an account_source at
+// the captured pace (1x, 10x) or as fast as possible. the manager
+// bootstraps from a mock rpc node serving the first captured content of
+// every account and notifies websocket users subscribed to every price
+// while synthetic publishers answer the price schedules with updates.
+// reports events/sec, notification latency percentiles and allocations
+// per update. without a capture file one is generated
+
+#define PC_BENCH_SLOT_TIME  ( 400L * PC_NSECS_IN_MSEC )
+#define PC_BENCH_WAIT       ( 10L * PC_NSECS_IN_SEC )
+#define PC_BENCH_DRAIN      ( 200L * PC_NSECS_IN_MSEC )
+#define PC_BENCH_RING       16U
+#define PC_BENCH_MAX_BATCH  256U
+
+// allocations made by the manager. counted only within manager::poll,
+// of which upd_alloc within the dispatch of account updates
+static std::atomic<uint64_t> num_alloc( 0UL );
+static uint64_t upd_alloc = 0UL;
+static bool do_count = false;
+
+void *operator new( size_t sz )
+{
+  if ( do_count ) {
+    num_alloc.fetch_add( 1UL, std::memory_order_relaxed );
+  }
+  void *ptr = ::malloc( sz ? sz : 1UL );
+  if ( !ptr ) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete( void *ptr ) noexcept
+{
+  ::free( ptr );
+}
+
+void operator delete( void *ptr, size_t ) noexcept
+{
+  ::free( ptr );
+}
+
+static std::string get_key( const pc_pub_key_t *acc )
+{
+  return std::string( (const char*)acc, sizeof( pc_pub_key_t ) );
+}
+
+// dispatch time of a price update by publish slot
+struct disp_rec
+{
+  uint64_t slot_;
+  int64_t  ts_;
+};
+
+// accounts of the capture shared by the mock rpc node, the account
+// source and the clients
+struct bench_data
+{
+  typedef std::unordered_map<std::string,std::vector<char>> acc_map_t;
+  typedef std::unordered_map<std::string,unsigned>          idx_map_t;
+
+  bool init( const std::string& cap_file );
+  void add_disp( unsigned idx, uint64_t slot, int64_t ts );
+  void add_recv( unsigned idx, uint64_t slot, int64_t ts );
+
+  std::string            cap_file_;
+  std::string            map_key_;  // first mapping account
+  acc_map_t              amap_;     // first content of every account
+  idx_map_t              pmap_;     // price account index
+  std::vector<pub_key>   pvec_;     // price accounts
+  std::vector<disp_rec>  disp_;     // PC_BENCH_RING per price
+  std::vector<int64_t>   lat_;      // notification latencies
+  uint64_t               num_rec_;  // records in capture
+  uint64_t               slot0_;    // first captured price slot
+  uint64_t               slot_;     // latest slot dispatched
+};
+
+bool bench_data::init( const std::string& cap_file )
+{
+  cap_file_ = cap_file;
+  replay rep;
+  rep.set_file( cap_file );
+  if ( !rep.init() ) {
+    std::cerr << "bench_replay: " << rep.get_err_msg() << std::endl;
+    return false;
+  }
+  num_rec_ = slot0_ = 0UL;
+  while( rep.get_next() ) {
+    ++num_rec_;
+    const pc_acc_t *aptr = rep.get_update();
+    std::string key = get_key( rep.get_account() );
+    if ( amap_.find( key ) != amap_.end() ) {
+      continue;
+    }
+    // captures hold the populated region of accounts which the rpc node
+    // returns zero-padded to the account size
+    std::vector<char>& acc = amap_[key];
+    acc.assign( (const char*)aptr, (const char*)aptr + aptr->size_ );
+    acc.resize( std::max( acc.size(), mock_rpc::get_account_size( aptr->type_ ) ) );
+    if ( aptr->type_ == PC_ACCTYPE_MAPPING && map_key_.empty() ) {
+      map_key_ = key;
+    } else if ( aptr->type_ == PC_ACCTYPE_PRICE ) {
+      if ( !slot0_ ) {
+        slot0_ = ((const pc_price_t*)aptr)->agg_.pub_slot_;
+      }
+      pmap_[key] = static_cast< unsigned >( pvec_.size() );
+      pub_key acc;
+      acc.init_from_buf( (const uint8_t*)key.data() );
+      pvec_.push_back( acc );
+    }
+  }
+  if ( map_key_.empty() || pvec_.empty() ) {
+    std::cerr << "bench_replay: no mapping or price accounts in capture"
+              << std::endl;
+    return false;
+  }
+  return true;
+}
+
+void bench_data::add_disp( unsigned idx, uint64_t slot, int64_t ts )
+{
+  disp_rec& rec = disp_[idx*PC_BENCH_RING + slot%PC_BENCH_RING];
+  rec.slot_ = slot;
+  rec.ts_   = ts;
+}
+
+void bench_data::add_recv( unsigned idx, uint64_t slot, int64_t ts )
+{
+  const disp_rec& rec = disp_[idx*PC_BENCH_RING + slot%PC_BENCH_RING];
+  if ( idx < pvec_.size() && rec.slot_ == slot ) {
+    lat_.push_back( ts - rec.ts_ );
+  }
+}
+
+// account updates of the capture released at speed times the captured
+// pace (0 - as fast as possible)
+class replay_source : public account_source
+{
+public:
+
+  replay_source( bench_data * );
+
+  bool init() override;
+  void poll() override;
+  void close() override;
+  bool get_is_connect() const override;
+
+  // start dispatching updates
+  void start( int64_t speed );
+
+  // all updates dispatched and time of last one
+  bool get_is_done() const;
+  int64_t get_last_time() const;
+  uint64_t get_num() const;
+
+private:
+
+  void dispatch();
+
+  bench_data       *bd_;
+  replay            rep_;
+  std::vector<char> buf_;    // zero-padded account
+  bool              has_;
+  bool              run_;
+  int64_t           speed_;
+  int64_t           ts0_;    // time of first capture
+  int64_t           start_;  // time of start
+  int64_t           last_;
+  uint64_t          num_;
+};
+
+replay_source::replay_source( bench_data *bd )
+: bd_( bd ),
+  has_( false ),
+  run_( false ),
+  speed_( 0L ),
+  ts0_( 0L ),
+  start_( 0L ),
+  last_( 0L ),
+  num_( 0UL )
+{
+}
+
+bool replay_source::init()
+{
+  rep_.set_file( bd_->cap_file_ );
+  if ( !rep_.init() ) {
+    return set_err_msg( rep_.get_err_msg() );
+  }
+  has_ = rep_.get_next();
+  ts0_ = has_ ? rep_.get_time() : 0L;
+  return true;
+}
+
+void replay_source::close()
+{
+}
+
+bool replay_source::get_is_connect() const
+{
+  return true;
+}
+
+void replay_source::start( int64_t speed )
+{
+  speed_ = speed;
+  start_ = last_ = get_now();
+  run_   = true;
+}
+
+bool replay_source::get_is_done() const
+{
+  return run_ && !has_;
+}
+
+int64_t replay_source::get_last_time() const
+{
+  return last_;
+}
+
+uint64_t replay_source::get_num() const
+{
+  return num_;
+}
+
+void replay_source::poll()
+{
+  if ( !run_ ) {
+    return;
+  }
+  int64_t now = get_now();
+  for( unsigned i = 0; has_ && i != PC_BENCH_MAX_BATCH; ++i ) {
+    if ( speed_ && rep_.get_time() - ts0_ > ( now - start_ ) * speed_ ) {
+      break;
+    }
+    dispatch();
+    has_ = rep_.get_next();
+  }
+}
+
+void replay_source::dispatch()
+{
+  // bookkeeping of the benchmark is not counted against the manager
+  const pc_acc_t *aptr = rep_.get_update();
+  pc_pub_key_t *kptr = rep_.get_account();
+  bool is_count = do_count;
+  do_count = false;
+  if ( aptr->type_ == PC_ACCTYPE_PRICE ) {
+    uint64_t slot = ((const pc_price_t*)aptr)->agg_.pub_slot_;
+    bd_->slot_ = std::max( bd_->slot_, slot );
+    auto it = bd_->pmap_.find( get_key( kptr ) );
+    if ( it != bd_->pmap_.end() ) {
+      bd_->add_disp( it->second, slot, get_now() );
+    }
+  }
+  const char *data = (const char*)aptr;
+  size_t len = std::max( (size_t)aptr->size_, mock_rpc::get_account_size( aptr->type_ ) );
+  if ( len != aptr->size_ ) {
+    buf_.assign( data, data + aptr->size_ );
+    buf_.resize( len );
+    data = buf_.data();
+  }
+  do_count = is_count;
+  pub_key acc;
+  acc.init_from_buf( (const uint8_t*)kptr );
+  uint64_t nalloc = num_alloc.load();
+  on_account( acc, bd_->slot_, 1UL, data, len );
+  upd_alloc += num_alloc.load() - nalloc;
+  last_ = get_now();
+  ++num_;
+}
+
+// websocket client of the manager. users subscribe to every price and
+// time the notifications, publishers answer every price schedule with
+// an update
+class bench_client : public ws_parser
+{
+public:
+
+  bench_client( bench_data *, bool is_pub );
+
+  bool init( net_loop *, int port );
+  bool get_is_wait();
+  bool get_is_err() const;
+  void close();
+
+  // subscribe to every price and number of subscriptions outstanding
+  void subscribe();
+  unsigned get_num_pending() const;
+
+  bool get_is_pub() const;
+  uint64_t get_num_notify() const;
+  uint64_t get_num_sent() const;
+
+  void parse_msg( const char *, size_t ) override;
+
+private:
+
+  void send( json_wtr& );
+
+  typedef std::unordered_map<uint64_t,unsigned> sub_map_t;
+
+  bench_data *bd_;
+  bool        is_pub_;
+  ws_connect  conn_;
+  jtree       jp_;
+  sub_map_t   smap_;   // price index by subscription
+  unsigned    npend_;
+  uint64_t    nnotify_;
+  uint64_t    nsent_;
+  int64_t     px_;
+};
+
+bench_client::bench_client( bench_data *bd, bool is_pub )
+: bd_( bd ),
+  is_pub_( is_pub ),
+  npend_( 0U ),
+  nnotify_( 0UL ),
+  nsent_( 0UL ),
+  px_( 100000L )
+{
+}
+
+bool bench_client::init( net_loop *lp, int port )
+{
+  conn_.set_host( "127.0.0.1" );
+  conn_.set_port( port );
+  conn_.set_net_parser( this );
+  conn_.set_net_loop( lp );
+  set_net_connect( &conn_ );
+  if ( !conn_.init() ) {
+    return set_err_msg( conn_.get_err_msg() );
+  }
+  return true;
+}
+
+bool bench_client::get_is_wait()
+{
+  if ( conn_.get_is_wait() ) {
+    conn_.check();
+  }
+  return conn_.get_is_wait();
+}
+
+bool bench_client::get_is_err() const
+{
+  return conn_.get_is_err() || error::get_is_err();
+}
+
+void bench_client::close()
+{
+  conn_.close();
+}
+
+void bench_client::send( json_wtr& jw )
+{
+  ws_wtr msg;
+  msg.commit( ws_wtr::text_id, jw, true );
+  conn_.add_send( msg );
+}
+
+void bench_client::subscribe()
+{
+  for( unsigned i = 0; i != bd_->pvec_.size(); ++i ) {
+    json_wtr jw;
+    jw.add_val( json_wtr::e_obj );
+    jw.add_key( "jsonrpc", "2.0" );
+    jw.add_key( "method",
+        is_pub_ ? "subscribe_price_sched" : "subscribe_price" );
+    jw.add_key( "params", json_wtr::e_obj );
+    jw.add_key( "account", bd_->pvec_[i] );
+    jw.pop();
+    jw.add_key( "id", (uint64_t)i );
+    jw.pop();
+    send( jw );
+    ++npend_;
+  }
+}
+
+unsigned bench_client::get_num_pending() const
+{
+  return npend_;
+}
+
+bool bench_client::get_is_pub() const
+{
+  return is_pub_;
+}
+
+uint64_t bench_client::get_num_notify() const
+{
+  return nnotify_;
+}
+
+uint64_t bench_client::get_num_sent() const
+{
+  return nsent_;
+}
+
+void bench_client::parse_msg( const char *txt, size_t len )
+{
+  int64_t ts = get_now();
+  jp_.parse( txt, len );
+  uint32_t itok = jp_.find_val( 1, "id" );
+  uint32_t rtok = jp_.find_val( 1, "result" );
+  if ( itok && rtok ) {
+    // subscription reply
+    uint64_t sid = jp_.get_uint( jp_.find_val( rtok, "subscription" ) );
+    smap_[sid] = static_cast< unsigned >( jp_.get_uint( itok ) );
+    --npend_;
+    return;
+  }
+  uint32_t ptok = jp_.find_val( 1, "params" );
+  auto it = smap_.find(
+      jp_.get_uint( jp_.find_val( ptok, "subscription" ) ) );
+  if ( !ptok || it == smap_.end() ) {
+    return;
+  }
+  ++nnotify_;
+  if ( !is_pub_ ) {
+    uint64_t slot = jp_.get_uint(
+        jp_.find_val( jp_.find_val( ptok, "result" ), "pub_slot" ) );
+    bd_->add_recv( it->second, slot, ts );
+    return;
+  }
+
+  // price update sent as notification without reply
+  px_ += ( nsent_ & 1UL ) ? 1L : -1L;
+  json_wtr jw;
+  jw.add_val( json_wtr::e_obj );
+  jw.add_key( "jsonrpc", "2.0" );
+  jw.add_key( "method", "update_price" );
+  jw.add_key( "params", json_wtr::e_obj );
+  jw.add_key( "account", bd_->pvec_[it->second] );
+  jw.add_key( "price", px_ );
+  jw.add_key( "conf", 10UL );
+  jw.add_key( "status", "trading" );
+  jw.pop();
+  jw.pop();
+  send( jw );
+  ++nsent_;
+}
+
+struct bench_cfg
+{
+  std::string key_dir_;
+  unsigned    num_user_;
+  unsigned    num_pub_;
+};
+
+typedef std::vector<bench_client*> client_vec_t;
+
+// run one replay of the capture at speed
+static bool run_speed( bench_cfg& cfg, bench_data& bd, int64_t speed )
+{
+  net_loop lp;
+  if ( !lp.init() ) {
+    std::cerr << "bench_replay: " << lp.get_err_msg() << std::endl;
+    return false;
+  }
+  bd.slot_ = bd.slot0_;
+  bd.lat_.clear();
+  bd.disp_.assign( bd.pvec_.size() * PC_BENCH_RING, disp_rec{ 0UL, 0L } );
+  replay_source src( &bd );
+  manager mgr;
+  mgr.set_dir( cfg.key_dir_ );
+
+  // bootstrap requests are answered from the first captured content of
+  // every account at the latest slot dispatched
+  mock_rpc rpc;
+  rpc.set_program( *mgr.get_program_pub_key() );
+  rpc.set_slot( bd.slot_ );
+  for( const auto& it: bd.amap_ ) {
+    pub_key acc;
+    acc.init_from_buf( (const uint8_t*)it.first.data() );
+    rpc.add_account( acc, it.second.data(), it.second.size() );
+  }
+  if ( !rpc.init( &lp, 0 ) ) {
+    std::cerr << "bench_replay: " << rpc.get_err_msg() << std::endl;
+    return false;
+  }
+  int port = mock_rpc::get_free_port();
+  mgr.set_rpc_host( "127.0.0.1:" + std::to_string( rpc.get_port() ) );
+  mgr.set_listen_port( port );
+  mgr.set_do_ws( false );
+  mgr.set_do_tx( false );
+  mgr.set_account_source( &src );
+  mgr.set_spin_budget( PC_BENCH_WAIT / PC_NSECS_IN_USEC );
+  if ( !mgr.init() ) {
+    std::cerr << "bench_replay: " << mgr.get_err_msg() << std::endl;
+    return false;
+  }
+  auto poll = [&]() {
+    lp.poll( 0 );
+    rpc.set_slot( bd.slot_ );
+    rpc.poll();
+    do_count = true;
+    mgr.poll( true );
+    do_count = false;
+  };
+
+  // bootstrap from the mock rpc node
+  int64_t ts = get_now();
+  while( !mgr.get_is_err() && get_now() - ts < PC_BENCH_WAIT &&
+         !( mgr.has_status( PC_PYTH_HAS_MAPPING ) &&
+            mgr.has_status( PC_PYTH_HAS_BLOCK_HASH ) ) ) {
+    poll();
+  }
+  if ( !mgr.has_status( PC_PYTH_HAS_MAPPING ) ) {
+    std::cerr << "bench_replay: failed to bootstrap manager "
+              << mgr.get_err_msg() << std::endl;
+    return false;
+  }
+
+  // connect and subscribe users and publishers
+  client_vec_t cvec;
+  for( unsigned i = 0; i != cfg.num_user_ + cfg.num_pub_; ++i ) {
+    cvec.push_back( new bench_client( &bd, i >= cfg.num_user_ ) );
+    cvec.back()->init( &lp, port );
+  }
+  bool is_ok = true;
+  for( bench_client *cptr: cvec ) {
+    while( is_ok && cptr->get_is_wait() ) {
+      poll();
+      is_ok = get_now() - ts < 2 * PC_BENCH_WAIT;
+    }
+    is_ok = is_ok && !cptr->get_is_err();
+    cptr->subscribe();
+  }
+  for( bench_client *cptr: cvec ) {
+    while( is_ok && cptr->get_num_pending() ) {
+      poll();
+      is_ok = !cptr->get_is_err() && get_now() - ts < 2 * PC_BENCH_WAIT;
+    }
+  }
+  if ( !is_ok ) {
+    std::cerr << "bench_replay: failed to subscribe clients" << std::endl;
+  }
+
+  // replay until drained
+  uint64_t alloc0 = num_alloc.load();
+  upd_alloc = 0UL;
+  int64_t start = get_now();
+  src.start( speed );
+  while( is_ok && !mgr.get_is_err() &&
+         !( src.get_is_done() &&
+            get_now() - src.get_last_time() > PC_BENCH_DRAIN ) ) {
+    poll();
+  }
+  double secs = 1e-9 * (double)( src.get_last_time() - start );
+  uint64_t nalloc = num_alloc.load() - alloc0;
+  uint64_t nnotify = 0UL, nsched = 0UL, nsent = 0UL;
+  for( bench_client *cptr: cvec ) {
+    if ( cptr->get_is_err() ) {
+      std::cerr << "bench_replay: client error "
+                << cptr->get_err_msg() << std::endl;
+    }
+    ( cptr->get_is_pub() ? nsched : nnotify ) += cptr->get_num_notify();
+    nsent += cptr->get_num_sent();
+    cptr->close();
+    delete cptr;
+  }
+  if ( mgr.get_is_err() ) {
+    std::cerr << "bench_replay: " << mgr.get_err_msg() << std::endl;
+  }
+  if ( !is_ok || mgr.get_is_err() ) {
+    return false;
+  }
+
+  // report
+  std::vector<int64_t>& lat = bd.lat_;
+  std::sort( lat.begin(), lat.end() );
+  auto pct = [&lat]( double p ) {
+    if ( lat.empty() ) return 0.;
+    size_t i = std::min( lat.size() - 1, (size_t)( p * (double)lat.size() ) );
+    return 1e-3 * (double)lat[i];
+  };
+  uint64_t num = src.get_num();
+  double div = (double)std::max( num, 1UL );
+  std::cout << "speed: " << ( speed ? std::to_string( speed ) + "x" : "max" )
+            << " events: " << num
+            << " secs: " << secs
+            << " events/sec: " << ( secs > 0. ? (double)num / secs : 0. )
+            << " notify: " << nnotify
+            << " p50: " << pct( .5 ) << "us"
+            << " p99: " << pct( .99 ) << "us"
+            << " p999: " << pct( .999 ) << "us"
+            << " allocs/upd: " << (double)upd_alloc / div
+            << " poll_allocs/upd: " << (double)nalloc / div
+            << " pub_sched: " << nsched
+            << " pub_upd: " << nsent
+            << " txs: " << rpc.get_num_tx()
+            << std::endl;
+  return true;
+}
+
+// synthetic capture of num_px price accounts in as many products
+// updated in every one of num_slot slots. the publish key is
+// a component of every price
+static bool write_capture( const std::string& file, unsigned num_px,
+                           unsigned num_slot, pub_key *pub )
+{
+  gzFile zfd = ::gzopen( file.c_str(), "wb1" );
+  if ( !zfd ) {
+    std::cerr << "bench_replay: failed to create " << file << std::endl;
+    return false;
+  }
+  int64_t ts = get_now();
+  auto add = [&]( const pub_key& acc, const pc_acc_t *aptr ) {
+    ::gzwrite( zfd, &ts, sizeof( ts ) );
+    ::gzwrite( zfd, acc.data(), sizeof( pc_pub_key_t ) );
+    ::gzwrite( zfd, aptr, aptr->size_ );
+  };
+  auto gen = []() {
+    key_pair kp;
+    kp.gen();
+    return pub_key( kp );
+  };
+  std::vector<pub_key> prods, pxs;
+  for( unsigned i = 0; i != num_px; ++i ) {
+    prods.push_back( gen() );
+    pxs.push_back( gen() );
+  }
+
+  // mapping and product accounts
+  std::vector<char> mbuf( sizeof( pc_map_table_t ), 0 );
+  pc_map_table_t *mptr = (pc_map_table_t*)mbuf.data();
+  mptr->magic_ = PC_MAGIC;
+  mptr->ver_   = PC_VERSION;
+  mptr->type_  = PC_ACCTYPE_MAPPING;
+  mptr->num_   = num_px;
+  mptr->size_  = static_cast< uint32_t >( offsetof( pc_map_table_t, prod_ ) +
+                   num_px * sizeof( pc_pub_key_t ) );
+  for( unsigned i = 0; i != num_px; ++i ) {
+    __builtin_memcpy(
+        &mptr->prod_[i], prods[i].data(), sizeof( pc_pub_key_t ) );
+  }
+  add( gen(), (pc_acc_t*)mptr );
+  for( unsigned i = 0; i != num_px; ++i ) {
+    char buf[PC_PROD_ACC_SIZE] = {};
+    pc_prod_t *pptr = (pc_prod_t*)buf;
+    pptr->magic_ = PC_MAGIC;
+    pptr->ver_   = PC_VERSION;
+    pptr->type_  = PC_ACCTYPE_PRODUCT;
+    __builtin_memcpy( &pptr->px_acc_, pxs[i].data(), sizeof( pc_pub_key_t ) );
+    std::string sym = "BENCH" + std::to_string( i ) + "/USD";
+    std::string attr = "\006symbol";
+    attr += (char)sym.size();
+    attr += sym + "\012asset_type\006Crypto";
+    __builtin_memcpy( &buf[sizeof( pc_prod_t )], attr.data(), attr.size() );
+    pptr->size_ = static_cast< uint32_t >( sizeof( pc_prod_t ) + attr.size() );
+    add( prods[i], (pc_acc_t*)pptr );
+  }
+
+  // price accounts once per slot spread over the slot
+  std::mt19937 rnd( 1 );
+  std::vector<pc_price_t> pvec( num_px );
+  for( unsigned i = 0; i != num_px; ++i ) {
+    pc_price_t& px = pvec[i];
+    __builtin_memset( &px, 0, sizeof( px ) );
+    px.magic_  = PC_MAGIC;
+    px.ver_    = PC_VERSION;
+    px.type_   = PC_ACCTYPE_PRICE;
+    px.size_   = sizeof( pc_price_t );
+    px.ptype_  = PC_PTYPE_PRICE;
+    px.expo_   = -5;
+    px.num_    = 1;
+    px.num_qt_ = 1;
+    px.agg_.price_  = 100000L;
+    px.agg_.conf_   = 10UL;
+    px.agg_.status_ = PC_STATUS_TRADING;
+    __builtin_memcpy( &px.prod_, prods[i].data(), sizeof( pc_pub_key_t ) );
+    __builtin_memcpy( &px.comp_[0].pub_, pub->data(), sizeof( pc_pub_key_t ) );
+  }
+  const uint64_t slot0 = 1000UL;
+  const int64_t ts0 = ts;
+  for( unsigned s = 0; s != num_slot + 1; ++s ) {
+    for( unsigned i = 0; i != num_px; ++i ) {
+      pc_price_t& px = pvec[i];
+      ts = ts0 + s * PC_BENCH_SLOT_TIME + i * PC_BENCH_SLOT_TIME / num_px;
+      px.agg_.price_ += (int64_t)( rnd() % 21U ) - 10L;
+      px.agg_.pub_slot_ = slot0 + s;
+      px.valid_slot_ = px.last_slot_ = slot0 + s - 1;
+      px.comp_[0].agg_ = px.comp_[0].latest_ = px.agg_;
+      add( pxs[i], (pc_acc_t*)&px );
+    }
+  }
+  return Z_OK == ::gzclose( zfd );
+}
+
+int usage()
+{
+  std::cerr << "usage: bench_replay [options]" << std::endl;
+  std::cerr << "options include:" << std::endl;
+  std::cerr << "  -c <capture file (default synthetic capture)>"
+            << std::endl;
+  std::cerr << "  -n <number of synthetic prices (default 64)>" << std::endl;
+  std::cerr << "  -s <number of synthetic slots (default 25)>" << std::endl;
+  std::cerr << "  -u <number of users (default 4)>" << std::endl;
+  std::cerr << "  -p <number of publishers (default 1)>" << std::endl;
+  std::cerr << "  -x <replay speed 1, 10 or 0 for max (default all)>"
+            << std::endl;
+  std::cerr << "  -d (print debug logs)" << std::endl;
+  return 1;
+}
+
+int main( int argc, char **argv )
+{
+  std::string cap_file;
+  unsigned num_px = 64, num_slot = 25;
+  bench_cfg cfg;
+  cfg.num_user_ = 4;
+  cfg.num_pub_  = 1;
+  std::vector<int64_t> speeds = { 1L, 10L, 0L };
+  bool do_debug = false;
+  int opt = 0;
+  while( (opt = ::getopt(argc,argv, "c:n:s:u:p:x:dh" )) != -1 ) {
+    switch(opt) {
+      case 'c': cap_file = optarg; break;
+      case 'n': num_px = (unsigned)::atoi( optarg ); break;
+      case 's': num_slot = (unsigned)::atoi( optarg ); break;
+      case 'u': cfg.num_user_ = (unsigned)::atoi( optarg ); break;
+      case 'p': cfg.num_pub_ = (unsigned)::atoi( optarg ); break;
+      case 'x': speeds = { ::atol( optarg ) }; break;
+      case 'd': do_debug = true; break;
+      default: return usage();
+    }
+  }
+  if ( num_px == 0 || num_px > PC_MAP_TABLE_SIZE ) {
+    return usage();
+  }
+  log::set_level( do_debug ? PC_LOG_DBG_LVL : PC_LOG_ERR_LVL );
+
+  // keys of the manager
+  char tmpl[] = "/tmp/bench_replay.XXXXXX";
+  if ( !::mkdtemp( tmpl ) ) {
+    std::cerr << "bench_replay: failed to create key directory" << std::endl;
+    return 1;
+  }
+  cfg.key_dir_ = std::string( tmpl ) + "/";
+  bench_data bd;
+  pub_key pub;
+  if ( !mock_rpc::init_keys( cfg.key_dir_, &pub ) ) {
+    std::cerr << "bench_replay: failed to create keys in " << cfg.key_dir_
+              << std::endl;
+    return 1;
+  }
+  if ( cap_file.empty() ) {
+    cap_file = cfg.key_dir_ + "capture.gz";
+    if ( !write_capture( cap_file, num_px, num_slot, &pub ) ) {
+      return 1;
+    }
+  }
+  if ( !bd.init( cap_file ) ) {
+    return 1;
+  }
+
+  // mapping key is that of the capture
+  pub_key mkey;
+  mkey.init_from_buf( (const uint8_t*)bd.map_key_.data() );
+  if ( !mock_rpc::init_mapping_key( cfg.key_dir_, mkey ) ) {
+    std::cerr << "bench_replay: failed to write mapping key" << std::endl;
+    return 1;
+  }
+  std::cout << "capture: " << cap_file
+            << " records: " << bd.num_rec_
+            << " accounts: " << bd.amap_.size()
+            << " prices: " << bd.pvec_.size()
+            << " users: " << cfg.num_user_
+            << " publishers: " << cfg.num_pub_ << std::endl;
+  int ret = 0;
+  for( int64_t speed: speeds ) {
+    if ( !run_speed( cfg, bd, speed ) ) {
+      ret = 1;
+      break;
+    }
+  }
+  std::string cmd = "rm -rf " + cfg.key_dir_;
+  if ( 0 != ::system( cmd.c_str() ) ) {
+    ret = 1;
+  }
+  return ret;
+}
@@ -0,0 +1,47 @@
+#include <pc/key_pair.hpp>
+#include <pc/misc.hpp>
+#include <iostream>
+#include <vector>
+
+using namespace pc;
+
+// ed25519 signing throughput for a typical upd_price transaction size
+// with and without a cached signing key
+
+static const int num_iter = 20000;
+
+static void report( const char *name, int64_t ns )
+{
+  std::cout << name << ": " << (double)ns/(double)num_iter << "ns/op "
+            << 1e9*(double)num_iter/(double)ns << "sig/s" << std::endl;
+}
+
+int main( int, char** )
+{
+  key_pair kp;
+  kp.gen();
+  pub_key pk( kp );
+  std::vector<uint8_t> msg( 256, 0x5a );
+  signature sig;
+
+  // new ssl key and digest context per signature
+  int64_t ts = get_now();
+  for( int i=0; i != num_iter; ++i ) {
+    sig.sign( &msg[0], (uint32_t)msg.size(), kp );
+  }
+  report( "key_pair", get_now() - ts );
+
+  // cached signing key
+  key_cache kc;
+  kc.set( kp );
+  ts = get_now();
+  for( int i=0; i != num_iter; ++i ) {
+    sig.sign( &msg[0], (uint32_t)msg.size(), kc );
+  }
+  report( key_cache::get_backend(), get_now() - ts );
+  if ( !sig.verify( &msg[0], (uint32_t)msg.size(), pk ) ) {
+    std::cerr << "bench_sign: signature failed to verify" << std::endl;
+    return 1;
+  }
+  return 0;
+}
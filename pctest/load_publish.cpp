@@ -0,0 +1,812 @@
+#include <pc/manager.hpp>
+#include <pc/account_source.hpp>
+#include <pc/jtree.hpp>
+#include <pc/log.hpp>
+#include <pc/misc.hpp>
+#include "mock_rpc.hpp"
+#include <oracle/oracle.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+using namespace pc;
+
+// synthetic publisher load: M websocket connections to pythd send
+// update_price for N symbols in bursts timed against slot boundaries.
+// by default pythd is an in-process manager bootstrapped from a mock rpc
+// node which decodes the transactions it is sent, so that besides the
+// update_price reply latency the time until a price appears in an
+// outgoing transaction is reported. with -H the load is sent to a
+// running pythd instead and slot boundaries are taken from its price
+// schedule notifications
+
+#define PC_LOAD_WAIT    ( 10L * PC_NSECS_IN_SEC )
+#define PC_LOAD_DRAIN   ( 2L * PC_NSECS_IN_SEC )
+#define PC_LOAD_RING    64U     // sent prices remembered per symbol
+#define PC_LOAD_MAX_ID  65536U  // update_price replies tracked per client
+
+static std::string get_key( const void *acc )
+{
+  return std::string( (const char*)acc, sizeof( pc_pub_key_t ) );
+}
+
+// price sent by update_price and its send time
+struct sent_rec
+{
+  int64_t price_;
+  int64_t ts_;
+};
+
+// symbols, slot clock and latencies shared by the mock rpc node and the
+// clients
+struct load_data
+{
+  typedef std::unordered_map<std::string,std::vector<char>> acc_map_t;
+  typedef std::unordered_map<std::string,unsigned>          idx_map_t;
+
+  load_data();
+
+  // mapping, product and price accounts of num_px synthetic symbols
+  // with pub as publisher of every price
+  void init( unsigned num_px, const pub_key& pub );
+
+  // price account of the next symbol
+  void add_price( const pub_key& );
+
+  // start the mock slot clock
+  void start_clock( uint64_t slot );
+
+  // slot and start of slot of the mock clock or as last observed
+  uint64_t get_slot( int64_t ts ) const;
+  int64_t get_slot_start( int64_t ts ) const;
+  void add_slot_start( int64_t ts );
+
+  // next update of price idx and the time it was sent
+  int64_t get_next_price( unsigned idx );
+  void add_sent( unsigned idx, int64_t price, int64_t ts );
+
+  // price of idx found in a transaction
+  void add_tx( unsigned idx, int64_t price, int64_t ts );
+
+  std::string           map_key_;  // mapping account
+  acc_map_t             amap_;     // accounts served by the mock rpc node
+  idx_map_t             pmap_;     // symbol index by price account
+  std::vector<pub_key>  pvec_;     // price accounts
+  std::vector<int64_t>  pxvec_;    // last price sent by symbol
+  std::vector<sent_rec> sent_;     // PC_LOAD_RING per symbol
+  std::vector<int64_t>  rlat_;     // update_price reply latencies
+  std::vector<int64_t>  tlat_;     // update_price to transaction
+  int64_t               slot_dur_;
+  int64_t               slot_ts_;  // observed start of slot
+  int64_t               ts0_;      // start of slot0_ on the mock clock
+  uint64_t              slot0_;
+  uint64_t              num_tx_upd_; // upd_price instructions received
+};
+
+load_data::load_data()
+: slot_dur_( 400L * PC_NSECS_IN_MSEC ),
+  slot_ts_( 0L ),
+  ts0_( 0L ),
+  slot0_( 0UL ),
+  num_tx_upd_( 0UL )
+{
+}
+
+void load_data::init( unsigned num_px, const pub_key& pub )
+{
+  auto gen = []() {
+    key_pair kp;
+    kp.gen();
+    return pub_key( kp );
+  };
+  auto add = [this]( const pub_key& acc, const void *ptr, size_t len ) {
+    std::vector<char>& buf = amap_[get_key( acc.data() )];
+    buf.assign( (const char*)ptr, (const char*)ptr + len );
+  };
+  std::vector<pub_key> prods;
+  for( unsigned i = 0; i != num_px; ++i ) {
+    prods.push_back( gen() );
+    add_price( gen() );
+  }
+
+  // mapping and product accounts
+  std::vector<char> mbuf( sizeof( pc_map_table_t ), 0 );
+  pc_map_table_t *mptr = (pc_map_table_t*)mbuf.data();
+  mptr->magic_ = PC_MAGIC;
+  mptr->ver_   = PC_VERSION;
+  mptr->type_  = PC_ACCTYPE_MAPPING;
+  mptr->num_   = num_px;
+  mptr->size_  = static_cast< uint32_t >( offsetof( pc_map_table_t, prod_ ) +
+                   num_px * sizeof( pc_pub_key_t ) );
+  for( unsigned i = 0; i != num_px; ++i ) {
+    __builtin_memcpy(
+        &mptr->prod_[i], prods[i].data(), sizeof( pc_pub_key_t ) );
+  }
+  pub_key mkey = gen();
+  map_key_ = get_key( mkey.data() );
+  add( mkey, mptr, mbuf.size() );
+  for( unsigned i = 0; i != num_px; ++i ) {
+    char buf[PC_PROD_ACC_SIZE] = {};
+    pc_prod_t *pptr = (pc_prod_t*)buf;
+    pptr->magic_ = PC_MAGIC;
+    pptr->ver_   = PC_VERSION;
+    pptr->type_  = PC_ACCTYPE_PRODUCT;
+    __builtin_memcpy( &pptr->px_acc_, pvec_[i].data(), sizeof( pc_pub_key_t ) );
+    std::string sym = "LOAD" + std::to_string( i ) + "/USD";
+    std::string attr = "\006symbol";
+    attr += (char)sym.size();
+    attr += sym + "\012asset_type\006Crypto";
+    __builtin_memcpy( &buf[sizeof( pc_prod_t )], attr.data(), attr.size() );
+    pptr->size_ = static_cast< uint32_t >( sizeof( pc_prod_t ) + attr.size() );
+    add( prods[i], buf, sizeof( buf ) );
+  }
+
+  // price accounts
+  pc_price_t px;
+  __builtin_memset( &px, 0, sizeof( px ) );
+  px.magic_  = PC_MAGIC;
+  px.ver_    = PC_VERSION;
+  px.type_   = PC_ACCTYPE_PRICE;
+  px.size_   = sizeof( pc_price_t );
+  px.ptype_  = PC_PTYPE_PRICE;
+  px.expo_   = -5;
+  px.num_    = 1;
+  __builtin_memcpy( &px.comp_[0].pub_, pub.data(), sizeof( pc_pub_key_t ) );
+  for( unsigned i = 0; i != num_px; ++i ) {
+    __builtin_memcpy( &px.prod_, prods[i].data(), sizeof( pc_pub_key_t ) );
+    add( pvec_[i], &px, sizeof( px ) );
+  }
+}
+
+void load_data::add_price( const pub_key& acc )
+{
+  pmap_[get_key( acc.data() )] = static_cast< unsigned >( pvec_.size() );
+  pvec_.push_back( acc );
+  pxvec_.push_back( 100000L );
+  sent_.resize( pvec_.size() * PC_LOAD_RING, sent_rec{ 0L, 0L } );
+}
+
+void load_data::start_clock( uint64_t slot )
+{
+  slot0_ = slot;
+  ts0_   = get_now();
+}
+
+uint64_t load_data::get_slot( int64_t ts ) const
+{
+  return slot0_ + static_cast< uint64_t >( ( ts - ts0_ ) / slot_dur_ );
+}
+
+int64_t load_data::get_slot_start( int64_t ts ) const
+{
+  // project observed slot boundaries forward if they stop arriving
+  int64_t start = ts0_ ? ts0_ : slot_ts_;
+  if ( !start || ts < start ) {
+    return start;
+  }
+  return start + ( ( ts - start ) / slot_dur_ ) * slot_dur_;
+}
+
+void load_data::add_slot_start( int64_t ts )
+{
+  // schedules of one slot arrive together
+  if ( ts - slot_ts_ > slot_dur_ / 2 ) {
+    slot_ts_ = ts;
+  }
+}
+
+int64_t load_data::get_next_price( unsigned idx )
+{
+  return ++pxvec_[idx];
+}
+
+void load_data::add_sent( unsigned idx, int64_t price, int64_t ts )
+{
+  sent_rec& rec = sent_[idx*PC_LOAD_RING + (uint64_t)price%PC_LOAD_RING];
+  rec.price_ = price;
+  rec.ts_    = ts;
+}
+
+void load_data::add_tx( unsigned idx, int64_t price, int64_t ts )
+{
+  ++num_tx_upd_;
+  sent_rec& rec = sent_[idx*PC_LOAD_RING + (uint64_t)price%PC_LOAD_RING];
+  if ( rec.price_ == price ) {
+    tlat_.push_back( ts - rec.ts_ );
+    rec.price_ = 0L;
+  }
+}
+
+// the mock rpc node does not stream account updates so that the manager
+// does not poll program accounts
+class idle_source : public account_source
+{
+public:
+  bool init() override { return true; }
+  void poll() override {}
+  void close() override {}
+  bool get_is_connect() const override { return true; }
+};
+
+// mock rpc node. accounts are served from the synthetic symbols, slots
+// advance on the mock clock and upd_price instructions of the
+// transactions sent are matched against the prices sent
+class load_rpc : public mock_rpc
+{
+public:
+  load_rpc( load_data * );
+  void on_upd_price( const pc_pub_key_t *, const pc_pub_key_t *acc,
+                     const cmd_upd_price_t& ) override;
+private:
+  load_data *ld_;
+};
+
+load_rpc::load_rpc( load_data *ld )
+: ld_( ld )
+{
+}
+
+void load_rpc::on_upd_price( const pc_pub_key_t *, const pc_pub_key_t *acc,
+                             const cmd_upd_price_t& cmd )
+{
+  auto it = ld_->pmap_.find( get_key( acc ) );
+  if ( it != ld_->pmap_.end() ) {
+    ld_->add_tx( it->second, cmd.price_, get_now() );
+  }
+}
+
+// publisher connection to pythd. updates its share of the symbols in
+// bursts and times the update_price replies. the price schedule of its
+// first symbol marks slot boundaries when pythd is not in-process
+class load_client : public ws_parser
+{
+public:
+
+  load_client( load_data * );
+
+  bool init( net_loop *, const std::string& host, int port );
+  bool get_is_wait();
+  bool get_is_err() const;
+  void close();
+
+  // request price accounts of the first num symbols
+  void get_product_list( unsigned num );
+  bool get_has_products() const;
+
+  // symbols updated by this connection
+  void add_symbol( unsigned idx );
+
+  // subscribe to schedule of first symbol
+  void subscribe();
+  bool get_has_sched() const;
+
+  // send num updates of every symbol
+  void send_burst( unsigned num, int64_t ts );
+
+  uint64_t get_num_sent() const;
+  uint64_t get_num_reply() const;
+  uint64_t get_num_error() const;
+
+  void parse_msg( const char *, size_t ) override;
+
+private:
+
+  static const uint64_t prod_id = PC_LOAD_MAX_ID;
+  static const uint64_t sub_id  = PC_LOAD_MAX_ID + 1;
+
+  void send( json_wtr& );
+  void on_products( uint32_t rtok );
+
+  load_data            *ld_;
+  ws_connect            conn_;
+  jtree                 jp_;
+  std::vector<unsigned> svec_;    // symbol indices
+  std::vector<int64_t>  ids_;     // send time by request id
+  unsigned              nprod_;   // symbols requested
+  bool                  has_prod_;
+  bool                  has_sub_;
+  bool                  has_sched_;
+  uint64_t              sid_;     // subscription of schedule
+  uint64_t              nsent_;
+  uint64_t              nreply_;
+  uint64_t              nerr_;
+};
+
+load_client::load_client( load_data *ld )
+: ld_( ld ),
+  ids_( PC_LOAD_MAX_ID, 0L ),
+  nprod_( 0U ),
+  has_prod_( false ),
+  has_sub_( false ),
+  has_sched_( false ),
+  sid_( 0UL ),
+  nsent_( 0UL ),
+  nreply_( 0UL ),
+  nerr_( 0UL )
+{
+}
+
+bool load_client::init( net_loop *lp, const std::string& host, int port )
+{
+  conn_.set_host( host );
+  conn_.set_port( port );
+  conn_.set_net_parser( this );
+  conn_.set_net_loop( lp );
+  set_net_connect( &conn_ );
+  if ( !conn_.init() ) {
+    return set_err_msg( conn_.get_err_msg() );
+  }
+  return true;
+}
+
+bool load_client::get_is_wait()
+{
+  if ( conn_.get_is_wait() ) {
+    conn_.check();
+  }
+  return conn_.get_is_wait();
+}
+
+bool load_client::get_is_err() const
+{
+  return conn_.get_is_err() || error::get_is_err();
+}
+
+void load_client::close()
+{
+  conn_.close();
+}
+
+void load_client::send( json_wtr& jw )
+{
+  ws_wtr msg;
+  msg.commit( ws_wtr::text_id, jw, true );
+  conn_.add_send( msg );
+}
+
+void load_client::get_product_list( unsigned num )
+{
+  nprod_ = num;
+  json_wtr jw;
+  jw.add_val( json_wtr::e_obj );
+  jw.add_key( "jsonrpc", "2.0" );
+  jw.add_key( "method", "get_product_list" );
+  jw.add_key( "id", prod_id );
+  jw.pop();
+  send( jw );
+}
+
+bool load_client::get_has_products() const
+{
+  return has_prod_;
+}
+
+void load_client::on_products( uint32_t rtok )
+{
+  for( uint32_t tok = jp_.get_first( rtok );
+       tok && ld_->pvec_.size() != nprod_; tok = jp_.get_next( tok ) ) {
+    uint32_t ptok = jp_.get_first( jp_.find_val( tok, "price" ) );
+    if ( ptok ) {
+      pub_key acc;
+      acc.init_from_text( jp_.get_str( jp_.find_val( ptok, "account" ) ) );
+      ld_->add_price( acc );
+    }
+  }
+  has_prod_ = true;
+}
+
+void load_client::add_symbol( unsigned idx )
+{
+  svec_.push_back( idx );
+}
+
+void load_client::subscribe()
+{
+  if ( svec_.empty() ) {
+    has_sched_ = true;
+    return;
+  }
+  json_wtr jw;
+  jw.add_val( json_wtr::e_obj );
+  jw.add_key( "jsonrpc", "2.0" );
+  jw.add_key( "method", "subscribe_price_sched" );
+  jw.add_key( "params", json_wtr::e_obj );
+  jw.add_key( "account", ld_->pvec_[svec_[0]] );
+  jw.pop();
+  jw.add_key( "id", sub_id );
+  jw.pop();
+  send( jw );
+}
+
+bool load_client::get_has_sched() const
+{
+  return has_sched_;
+}
+
+void load_client::send_burst( unsigned num, int64_t ts )
+{
+  for( unsigned i = 0; i != num; ++i ) {
+    for( unsigned idx: svec_ ) {
+      int64_t px = ld_->get_next_price( idx );
+      uint64_t id = nsent_++ % PC_LOAD_MAX_ID;
+      json_wtr jw;
+      jw.add_val( json_wtr::e_obj );
+      jw.add_key( "jsonrpc", "2.0" );
+      jw.add_key( "method", "update_price" );
+      jw.add_key( "params", json_wtr::e_obj );
+      jw.add_key( "account", ld_->pvec_[idx] );
+      jw.add_key( "price", px );
+      jw.add_key( "conf", 10UL );
+      jw.add_key( "status", "trading" );
+      jw.pop();
+      jw.add_key( "id", id );
+      jw.pop();
+      send( jw );
+      ids_[id] = ts;
+      ld_->add_sent( idx, px, ts );
+    }
+  }
+}
+
+uint64_t load_client::get_num_sent() const
+{
+  return nsent_;
+}
+
+uint64_t load_client::get_num_reply() const
+{
+  return nreply_;
+}
+
+uint64_t load_client::get_num_error() const
+{
+  return nerr_;
+}
+
+void load_client::parse_msg( const char *txt, size_t len )
+{
+  int64_t ts = get_now();
+  jp_.parse( txt, len );
+  uint32_t itok = jp_.find_val( 1, "id" );
+  if ( !itok ) {
+    // schedule notification
+    uint32_t ptok = jp_.find_val( 1, "params" );
+    if ( has_sub_ &&
+         jp_.get_uint( jp_.find_val( ptok, "subscription" ) ) == sid_ ) {
+      has_sched_ = true;
+      ld_->add_slot_start( ts );
+    }
+    return;
+  }
+  uint64_t id = jp_.get_uint( itok );
+  uint32_t rtok = jp_.find_val( 1, "result" );
+  if ( id == prod_id ) {
+    on_products( rtok );
+  } else if ( id == sub_id ) {
+    sid_ = jp_.get_uint( jp_.find_val( rtok, "subscription" ) );
+    has_sub_ = rtok != 0;
+  } else if ( id < PC_LOAD_MAX_ID ) {
+    ++nreply_;
+    if ( !rtok ) {
+      ++nerr_;
+    }
+    ld_->rlat_.push_back( ts - ids_[id] );
+  }
+}
+
+struct load_cfg
+{
+  std::string host_;       // pythd host or empty for in-process
+  int         port_;
+  std::string key_dir_;
+  unsigned    num_conn_;
+  unsigned    num_sym_;
+  unsigned    num_burst_;  // bursts per slot
+  unsigned    burst_sz_;   // updates per symbol and burst
+  int64_t     offset_;     // first burst after start of slot
+  int64_t     secs_;
+};
+
+// percentile of latencies in usecs
+static double get_pct( std::vector<int64_t>& lat, double p )
+{
+  if ( lat.empty() ) {
+    return 0.;
+  }
+  size_t i = std::min( lat.size() - 1, (size_t)( p * (double)lat.size() ) );
+  std::nth_element( lat.begin(), lat.begin() + (long)i, lat.end() );
+  return 1e-3 * (double)lat[i];
+}
+
+typedef std::vector<load_client*> client_vec_t;
+
+static bool run( load_cfg& cfg, load_data& ld )
+{
+  net_loop lp;
+  if ( !lp.init() ) {
+    std::cerr << "load_publish: " << lp.get_err_msg() << std::endl;
+    return false;
+  }
+
+  // in-process manager bootstrapped from the mock rpc node
+  idle_source src;
+  load_rpc rpc( &ld );
+  manager mgr;
+  bool is_mock = cfg.host_.empty();
+  if ( is_mock ) {
+    ld.start_clock( 1000UL );
+    mgr.set_dir( cfg.key_dir_ );
+    rpc.set_program( *mgr.get_program_pub_key() );
+    rpc.set_slot( ld.get_slot( get_now() ) );
+    for( const auto& it: ld.amap_ ) {
+      pub_key acc;
+      acc.init_from_buf( (const uint8_t*)it.first.data() );
+      rpc.add_account( acc, it.second.data(), it.second.size() );
+    }
+    if ( !rpc.init( &lp, 0 ) ) {
+      std::cerr << "load_publish: " << rpc.get_err_msg() << std::endl;
+      return false;
+    }
+    cfg.host_ = "127.0.0.1";
+    cfg.port_ = mock_rpc::get_free_port();
+    mgr.set_rpc_host( "127.0.0.1:" + std::to_string( rpc.get_port() ) );
+    mgr.set_listen_port( cfg.port_ );
+    mgr.set_do_ws( false );
+    mgr.set_do_tx( false );
+    mgr.set_account_source( &src );
+    mgr.set_spin_budget( PC_LOAD_WAIT / PC_NSECS_IN_USEC );
+    if ( !mgr.init() ) {
+      std::cerr << "load_publish: " << mgr.get_err_msg() << std::endl;
+      return false;
+    }
+  }
+  auto poll = [&]() {
+    lp.poll( 0 );
+    if ( is_mock ) {
+      rpc.set_slot( ld.get_slot( get_now() ) );
+      rpc.poll();
+      mgr.poll( true );
+    }
+  };
+  int64_t ts = get_now();
+  auto is_wait = [&]() {
+    return !mgr.get_is_err() && get_now() - ts < PC_LOAD_WAIT;
+  };
+  while( is_mock && is_wait() &&
+         !( mgr.has_status( PC_PYTH_HAS_MAPPING ) &&
+            mgr.has_status( PC_PYTH_HAS_BLOCK_HASH ) &&
+            mgr.get_num_product() == cfg.num_sym_ ) ) {
+    poll();
+  }
+  if ( mgr.get_is_err() || ( is_mock && !is_wait() ) ) {
+    std::cerr << "load_publish: failed to bootstrap manager "
+              << mgr.get_err_msg() << std::endl;
+    return false;
+  }
+
+  // connect publishers, look up symbols and assign them round-robin
+  client_vec_t cvec;
+  bool is_ok = true;
+  for( unsigned i = 0; is_ok && i != cfg.num_conn_; ++i ) {
+    cvec.push_back( new load_client( &ld ) );
+    is_ok = cvec.back()->init( &lp, cfg.host_, cfg.port_ );
+  }
+  for( load_client *cptr: cvec ) {
+    while( is_ok && cptr->get_is_wait() ) {
+      poll();
+      is_ok = is_wait();
+    }
+    is_ok = is_ok && !cptr->get_is_err();
+  }
+  if ( is_ok && !is_mock ) {
+    cvec[0]->get_product_list( cfg.num_sym_ );
+    while( is_ok && !cvec[0]->get_has_products() ) {
+      poll();
+      is_ok = is_wait() && !cvec[0]->get_is_err();
+    }
+  }
+  for( unsigned i = 0; is_ok && i != ld.pvec_.size(); ++i ) {
+    cvec[i%cvec.size()]->add_symbol( i );
+  }
+  for( load_client *cptr: cvec ) {
+    if ( is_ok ) {
+      cptr->subscribe();
+    }
+    while( is_ok && !cptr->get_has_sched() ) {
+      poll();
+      is_ok = is_wait() && !cptr->get_is_err();
+    }
+  }
+  if ( !is_ok ) {
+    std::cerr << "load_publish: failed to connect publishers" << std::endl;
+    for( load_client *cptr: cvec ) {
+      delete cptr;
+    }
+    return false;
+  }
+  std::cout << "pythd: " << cfg.host_ << ":" << cfg.port_
+            << ( is_mock ? " (in-process)" : "" )
+            << " connections: " << cvec.size()
+            << " symbols: " << ld.pvec_.size()
+            << " bursts/slot: " << cfg.num_burst_
+            << " burst: " << cfg.burst_sz_
+            << " offset: " << 1e-6 * (double)cfg.offset_ << "ms"
+            << std::endl;
+
+  // send bursts at offset + k * slot / num_burst into every slot
+  ld.rlat_.clear();
+  ld.tlat_.clear();
+  ld.num_tx_upd_ = 0UL;
+  uint64_t ntx = rpc.get_num_tx();
+  int64_t start = get_now(), end = start + cfg.secs_ * PC_NSECS_IN_SEC;
+  int64_t slot_ts = 0L;
+  unsigned nburst = 0;
+  for( int64_t now = start; is_ok && now < end; now = get_now() ) {
+    poll();
+    int64_t sts = ld.get_slot_start( now );
+    if ( sts != slot_ts ) {
+      slot_ts = sts;
+      nburst = 0;
+    }
+    while( sts && nburst != cfg.num_burst_ &&
+           now >= sts + cfg.offset_ +
+             (int64_t)nburst * ld.slot_dur_ / cfg.num_burst_ ) {
+      for( load_client *cptr: cvec ) {
+        cptr->send_burst( cfg.burst_sz_, now );
+      }
+      ++nburst;
+    }
+    for( load_client *cptr: cvec ) {
+      is_ok = is_ok && !cptr->get_is_err();
+    }
+    is_ok = is_ok && !mgr.get_is_err();
+  }
+
+  // wait for replies and the last transactions
+  uint64_t nsent = 0UL, nreply = 0UL, nerr = 0UL;
+  for( int64_t now = get_now(), ts1 = now;
+       is_ok && now - ts1 < PC_LOAD_DRAIN; now = get_now() ) {
+    poll();
+    nsent = nreply = nerr = 0UL;
+    for( load_client *cptr: cvec ) {
+      nsent  += cptr->get_num_sent();
+      nreply += cptr->get_num_reply();
+      nerr   += cptr->get_num_error();
+    }
+    if ( !is_mock && nreply == nsent ) {
+      break;
+    }
+  }
+  for( load_client *cptr: cvec ) {
+    if ( cptr->get_is_err() ) {
+      std::cerr << "load_publish: client error "
+                << cptr->get_err_msg() << std::endl;
+    }
+    cptr->close();
+    delete cptr;
+  }
+  if ( mgr.get_is_err() ) {
+    std::cerr << "load_publish: " << mgr.get_err_msg() << std::endl;
+  }
+  if ( !is_ok ) {
+    return false;
+  }
+
+  // report
+  double secs = 1e-9 * (double)( end - start );
+  std::cout << "secs: " << secs
+            << " updates: " << nsent
+            << " updates/sec: " << (double)nsent / secs
+            << " replies: " << nreply
+            << " errors: " << nerr
+            << " reply_p50: " << get_pct( ld.rlat_, .5 ) << "us"
+            << " reply_p99: " << get_pct( ld.rlat_, .99 ) << "us"
+            << " reply_p999: " << get_pct( ld.rlat_, .999 ) << "us"
+            << std::endl;
+  if ( is_mock ) {
+    std::cout << "txs: " << rpc.get_num_tx() - ntx
+              << " tx_updates: " << ld.num_tx_upd_
+              << " matched: " << ld.tlat_.size()
+              << " tx_p50: " << 1e-3 * get_pct( ld.tlat_, .5 ) << "ms"
+              << " tx_p99: " << 1e-3 * get_pct( ld.tlat_, .99 ) << "ms"
+              << " tx_max: " << 1e-3 * get_pct( ld.tlat_, 1. ) << "ms"
+              << std::endl;
+  }
+  return true;
+}
+
+int usage()
+{
+  std::cerr << "usage: load_publish [options]" << std::endl;
+  std::cerr << "options include:" << std::endl;
+  std::cerr << "  -H <pythd host:port (default in-process pythd with "
+            << "a mock rpc node)>" << std::endl;
+  std::cerr << "  -m <number of connections (default 4)>" << std::endl;
+  std::cerr << "  -n <number of symbols (default 64)>" << std::endl;
+  std::cerr << "  -r <number of bursts per slot (default 1)>" << std::endl;
+  std::cerr << "  -b <updates per symbol and burst (default 1)>"
+            << std::endl;
+  std::cerr << "  -o <offset of first burst into slot in msecs "
+            << "(default 0)>" << std::endl;
+  std::cerr << "  -s <slot duration in msecs (default 400)>" << std::endl;
+  std::cerr << "  -t <run time in secs (default 10)>" << std::endl;
+  std::cerr << "  -d (print debug logs)" << std::endl;
+  return 1;
+}
+
+int main( int argc, char **argv )
+{
+  load_cfg cfg;
+  cfg.port_      = 8910;
+  cfg.num_conn_  = 4;
+  cfg.num_sym_   = 64;
+  cfg.num_burst_ = 1;
+  cfg.burst_sz_  = 1;
+  cfg.offset_    = 0L;
+  cfg.secs_      = 10L;
+  load_data ld;
+  bool do_debug = false;
+  int opt = 0;
+  while( (opt = ::getopt(argc,argv, "H:m:n:r:b:o:s:t:dh" )) != -1 ) {
+    switch(opt) {
+      case 'H': {
+        std::string host = optarg;
+        size_t pos = host.find( ':' );
+        cfg.host_ = host.substr( 0, pos );
+        if ( pos != std::string::npos ) {
+          cfg.port_ = ::atoi( host.c_str() + pos + 1 );
+        }
+        break;
+      }
+      case 'm': cfg.num_conn_ = (unsigned)::atoi( optarg ); break;
+      case 'n': cfg.num_sym_ = (unsigned)::atoi( optarg ); break;
+      case 'r': cfg.num_burst_ = (unsigned)::atoi( optarg ); break;
+      case 'b': cfg.burst_sz_ = (unsigned)::atoi( optarg ); break;
+      case 'o': cfg.offset_ = ::atol( optarg ) * PC_NSECS_IN_MSEC; break;
+      case 's': ld.slot_dur_ = ::atol( optarg ) * PC_NSECS_IN_MSEC; break;
+      case 't': cfg.secs_ = ::atol( optarg ); break;
+      case 'd': do_debug = true; break;
+      default: return usage();
+    }
+  }
+  if ( !cfg.num_conn_ || !cfg.num_sym_ || cfg.num_sym_ > PC_MAP_TABLE_SIZE ||
+       !cfg.num_burst_ || !cfg.burst_sz_ || cfg.secs_ <= 0L ||
+       ld.slot_dur_ <= 0L || cfg.offset_ < 0L ||
+       cfg.offset_ >= ld.slot_dur_ ) {
+    return usage();
+  }
+  log::set_level( do_debug ? PC_LOG_DBG_LVL : PC_LOG_ERR_LVL );
+  if ( !cfg.host_.empty() ) {
+    return run( cfg, ld ) ? 0 : 1;
+  }
+
+  // keys and synthetic symbols of the in-process manager
+  char tmpl[] = "/tmp/load_publish.XXXXXX";
+  if ( !::mkdtemp( tmpl ) ) {
+    std::cerr << "load_publish: failed to create key directory" << std::endl;
+    return 1;
+  }
+  cfg.key_dir_ = std::string( tmpl ) + "/";
+  pub_key pub;
+  int ret = 1;
+  if ( !mock_rpc::init_keys( cfg.key_dir_, &pub ) ) {
+    std::cerr << "load_publish: failed to create keys in " << cfg.key_dir_
+              << std::endl;
+  } else {
+    ld.init( cfg.num_sym_, pub );
+    pub_key mkey;
+    mkey.init_from_buf( (const uint8_t*)ld.map_key_.data() );
+    if ( mock_rpc::init_mapping_key( cfg.key_dir_, mkey ) && run( cfg, ld ) ) {
+      ret = 0;
+    }
+  }
+  std::string cmd = "rm -rf " + cfg.key_dir_;
+  if ( 0 != ::system( cmd.c_str() ) ) {
+    ret = 1;
+  }
+  return ret;
+}
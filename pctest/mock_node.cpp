@@ -0,0 +1,179 @@
+#include "mock_rpc.hpp"
+#include <pc/log.hpp>
+#include <pc/misc.hpp>
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+
+using namespace pc;
+
+// deterministic mock solana rpc node for performance tests in place of
+// a local validator. serves the mapping, product and price accounts of a
+// capture, a snapshot or synthetic symbols over http (port) and
+// websockets (port+1), advances slots at a fixed cadence with slot
+// notifications and accepts sendTransaction with injected latency and
+// loss. upd_price instructions of accepted transactions are applied to
+// the price accounts which are aggregated at the next slot and sent to
+// account and program subscribers
+
+static bool do_run = true;
+
+static void sig_handle( int )
+{
+  do_run = false;
+}
+
+static bool read_key( const std::string& file, pub_key& pk )
+{
+  // key pair file or base58 text
+  key_pair kp;
+  if ( kp.init_from_file( file ) ) {
+    kp.get_pub_key( pk );
+    return true;
+  }
+  return pk.init_from_file( file );
+}
+
+int usage()
+{
+  std::cerr << "usage: mock_rpc [options]" << std::endl;
+  std::cerr << "options include:" << std::endl;
+  std::cerr << "  -p <http port, websockets on port+1 (default 8899)>"
+            << std::endl;
+  std::cerr << "  -c <capture file>" << std::endl;
+  std::cerr << "  -S <snapshot file>" << std::endl;
+  std::cerr << "  -n <number of synthetic symbols without -c or -S "
+            << "(default 64)>" << std::endl;
+  std::cerr << "  -g <program key file (default first program subscribed "
+            << "to)>" << std::endl;
+  std::cerr << "  -k <publisher key file added to every price>"
+            << std::endl;
+  std::cerr << "  -m <file to write the mapping key to>" << std::endl;
+  std::cerr << "  -s <slot duration in msecs (default 400)>" << std::endl;
+  std::cerr << "  -l <sendTransaction latency in msecs (default 0)>"
+            << std::endl;
+  std::cerr << "  -j <sendTransaction jitter in msecs (default 0)>"
+            << std::endl;
+  std::cerr << "  -x <fraction of transactions dropped (default 0)>"
+            << std::endl;
+  std::cerr << "  -r <random seed (default 1)>" << std::endl;
+  std::cerr << "  -d (print debug logs)" << std::endl;
+  return 1;
+}
+
+int main( int argc, char **argv )
+{
+  int port = 8899;
+  unsigned num_sym = 64;
+  std::string cap_file, snap_file, pgm_file, pub_file, map_file;
+  int64_t slot_ms = 400L, lat_ms = 0L, jit_ms = 0L;
+  double loss = 0.;
+  uint64_t seed = 1UL;
+  bool do_debug = false;
+  int opt = 0;
+  while( (opt = ::getopt(argc,argv, "p:c:S:n:g:k:m:s:l:j:x:r:dh" )) != -1 ) {
+    switch(opt) {
+      case 'p': port = ::atoi( optarg ); break;
+      case 'c': cap_file = optarg; break;
+      case 'S': snap_file = optarg; break;
+      case 'n': num_sym = (unsigned)::atoi( optarg ); break;
+      case 'g': pgm_file = optarg; break;
+      case 'k': pub_file = optarg; break;
+      case 'm': map_file = optarg; break;
+      case 's': slot_ms = ::atol( optarg ); break;
+      case 'l': lat_ms = ::atol( optarg ); break;
+      case 'j': jit_ms = ::atol( optarg ); break;
+      case 'x': loss = ::atof( optarg ); break;
+      case 'r': seed = (uint64_t)::atol( optarg ); break;
+      case 'd': do_debug = true; break;
+      default: return usage();
+    }
+  }
+  if ( slot_ms <= 0L || lat_ms < 0L || jit_ms < 0L || loss < 0. ||
+       loss > 1. || num_sym == 0 || num_sym > PC_MAP_TABLE_SIZE ) {
+    return usage();
+  }
+  log::set_level( do_debug ? PC_LOG_DBG_LVL : PC_LOG_INF_LVL );
+
+  mock_rpc rpc;
+  rpc.set_ws_port( port + 1 );
+  rpc.set_slot_time( slot_ms * PC_NSECS_IN_MSEC );
+  rpc.set_latency( lat_ms * PC_NSECS_IN_MSEC, jit_ms * PC_NSECS_IN_MSEC );
+  rpc.set_loss( loss );
+  rpc.set_seed( seed );
+  pub_key pk;
+  if ( !pgm_file.empty() ) {
+    if ( !read_key( pgm_file, pk ) ) {
+      std::cerr << "mock_rpc: invalid key file " << pgm_file << std::endl;
+      return 1;
+    }
+    rpc.set_program( pk );
+  }
+  if ( !pub_file.empty() ) {
+    if ( !read_key( pub_file, pk ) ) {
+      std::cerr << "mock_rpc: invalid key file " << pub_file << std::endl;
+      return 1;
+    }
+    rpc.set_publisher( pk );
+  }
+  bool is_ok = true;
+  if ( !cap_file.empty() ) {
+    is_ok = rpc.load_capture( cap_file );
+  } else if ( !snap_file.empty() ) {
+    is_ok = rpc.load_snapshot( snap_file );
+  } else {
+    rpc.gen_accounts( num_sym );
+  }
+  if ( !is_ok || !rpc.get_mapping() ) {
+    std::cerr << "mock_rpc: "
+              << ( is_ok ? "no mapping account" : rpc.get_err_msg() )
+              << std::endl;
+    return 1;
+  }
+  std::string mkey;
+  rpc.get_mapping()->enc_base58( mkey );
+  if ( !map_file.empty() ) {
+    std::ofstream ofs( map_file );
+    ofs << mkey;
+    if ( !ofs.good() ) {
+      std::cerr << "mock_rpc: failed to write " << map_file << std::endl;
+      return 1;
+    }
+  }
+  net_loop lp;
+  if ( !lp.init() ) {
+    std::cerr << "mock_rpc: " << lp.get_err_msg() << std::endl;
+    return 1;
+  }
+  if ( !rpc.init( &lp, port ) ) {
+    std::cerr << "mock_rpc: " << rpc.get_err_msg() << std::endl;
+    return 1;
+  }
+  signal( SIGINT, sig_handle );
+  signal( SIGTERM, sig_handle );
+  signal( SIGPIPE, SIG_IGN );
+  PC_LOG_INF( "listening" )
+    .add( "http_port", port )
+    .add( "ws_port", port + 1 )
+    .add( "mapping", mkey )
+    .add( "num_accounts", rpc.get_num_account() )
+    .add( "slot_ms", slot_ms )
+    .add( "latency_ms", lat_ms )
+    .add( "jitter_ms", jit_ms )
+    .add( "loss", loss )
+    .end();
+  while( do_run ) {
+    lp.poll( 1 );
+    rpc.poll();
+  }
+  PC_LOG_INF( "shutdown" )
+    .add( "slot", rpc.get_slot() )
+    .add( "num_tx", rpc.get_num_tx() )
+    .add( "num_dropped", rpc.get_num_drop() )
+    .add( "num_upd_price", rpc.get_num_upd() )
+    .add( "num_rejected", rpc.get_num_reject() )
+    .end();
+  return 0;
+}
@@ -0,0 +1,1029 @@
+#include "mock_rpc.hpp"
+#include <pc/aggregate.hpp>
+#include <pc/key_store.hpp>
+#include <pc/misc.hpp>
+#include <pc/replay.hpp>
+#include <pc/snapshot.hpp>
+#include <zstd.h>
+#include <algorithm>
+#include <fstream>
+
+#define PC_MOCK_SIG_SLOTS   300UL  // slots signature statuses are kept
+#define PC_MOCK_ROOT_DEPTH  32UL   // root slot behind the current slot
+#define PC_MOCK_LEADER_SLOTS 4UL   // consecutive slots of a leader
+
+using namespace pc;
+
+static std::string get_key( const void *acc )
+{
+  return std::string( (const char*)acc, sizeof( pc_pub_key_t ) );
+}
+
+size_t mock_rpc::get_account_size( uint32_t type )
+{
+  switch( type ) {
+    case PC_ACCTYPE_MAPPING: return sizeof( pc_map_table_t );
+    case PC_ACCTYPE_PRODUCT: return PC_PROD_ACC_SIZE;
+    case PC_ACCTYPE_PRICE:   return sizeof( pc_price_t );
+    default:                 return 0UL;
+  }
+}
+
+int mock_rpc::get_free_port()
+{
+  tcp_listen lsvr;
+  lsvr.set_port( 0 );
+  if ( !lsvr.init() ) {
+    return 0;
+  }
+  int port = lsvr.get_port();
+  lsvr.close();
+  return port;
+}
+
+bool mock_rpc::init_keys( const std::string& dir, pub_key *pub )
+{
+  key_store ks;
+  ks.set_dir( dir );
+  key_pair *kp = nullptr;
+  if ( !ks.init() || !ks.create_program_key_pair() ||
+       !( kp = ks.create_publish_key_pair() ) ) {
+    return false;
+  }
+  kp->get_pub_key( *pub );
+  return true;
+}
+
+bool mock_rpc::init_mapping_key( const std::string& dir, const pub_key& mkey )
+{
+  key_store ks;
+  ks.set_dir( dir );
+  std::string txt;
+  mkey.enc_base58( txt );
+  std::ofstream ofs( ks.get_mapping_pub_key_file() );
+  ofs << txt;
+  return ofs.good();
+}
+
+bool mock_filter::init( const jtree& jt, uint32_t otok )
+{
+  size_ = off_ = len_ = 0UL;
+  slice_ = false;
+  zstd_ = jt.get_str( jt.find_val( otok, "encoding" ) ) == "base64+zstd";
+  uint32_t ftok = jt.find_val( otok, "filters" );
+  for( uint32_t tok = jt.get_first( ftok ); tok; tok = jt.get_next( tok ) ) {
+    uint32_t mtok = jt.find_val( tok, "memcmp" );
+    uint32_t stok = jt.find_val( tok, "dataSize" );
+    if ( mtok ) {
+      str txt = jt.get_str( jt.find_val( mtok, "bytes" ) );
+      std::vector<uint8_t> buf( txt.len_ + 1 );
+      int len = dec_base58( (const uint8_t*)txt.str_, (int)txt.len_, &buf[0] );
+      if ( len < 0 ) {
+        return false;
+      }
+      cvec_.push_back( cmp_t( jt.get_uint( jt.find_val( mtok, "offset" ) ),
+                              std::string( (const char*)&buf[0],
+                                           (size_t)len ) ) );
+    } else if ( stok ) {
+      size_ = jt.get_uint( stok );
+    }
+  }
+  uint32_t dtok = jt.find_val( otok, "dataSlice" );
+  if ( dtok ) {
+    slice_ = true;
+    off_ = jt.get_uint( jt.find_val( dtok, "offset" ) );
+    len_ = jt.get_uint( jt.find_val( dtok, "length" ) );
+  }
+  return true;
+}
+
+bool mock_filter::match( const std::vector<char>& data ) const
+{
+  if ( size_ && data.size() != size_ ) {
+    return false;
+  }
+  for( const cmp_t& cmp: cvec_ ) {
+    if ( data.size() < cmp.first + cmp.second.size() ||
+         0 != __builtin_memcmp( &data[cmp.first], cmp.second.data(),
+                                cmp.second.size() ) ) {
+      return false;
+    }
+  }
+  return true;
+}
+
+mock_conn::mock_conn( mock_rpc *rpc )
+: rpc_( rpc )
+{
+  http_.cp_ = this;
+  ws_.cp_ = this;
+  http_.set_net_connect( this );
+  http_.set_ws_parser( &ws_ );
+  ws_.set_net_connect( this );
+  set_net_parser( &http_ );
+}
+
+void mock_conn::send( json_wtr& jw, bool is_ws )
+{
+  if ( is_ws ) {
+    ws_wtr msg;
+    msg.commit( ws_wtr::text_id, jw, false );
+    add_send( msg );
+  } else {
+    http_response msg;
+    msg.init( "200", "OK" );
+    msg.add_hdr( "Content-Type", "application/json" );
+    msg.commit( jw );
+    add_send( msg );
+  }
+}
+
+void mock_conn::mock_http::parse_content( const char *txt, size_t len )
+{
+  cp_->rpc_->reply( cp_, txt, len, false );
+}
+
+void mock_conn::mock_ws::parse_msg( const char *txt, size_t len )
+{
+  cp_->rpc_->reply( cp_, txt, len, true );
+}
+
+mock_rpc::mock_rpc()
+: lp_( nullptr ),
+  has_pgm_( false ),
+  has_pub_( false ),
+  has_map_( false ),
+  log_tx_( false ),
+  wport_( 0 ),
+  slot_dur_( 0L ),
+  lat_( 0L ),
+  jit_( 0L ),
+  loss_( 0. ),
+  rnd_( 1UL ),
+  slot_( 1000UL ),
+  slot_ts_( 0L ),
+  sub_id_( 0UL ),
+  num_tx_( 0UL ),
+  num_drop_( 0UL ),
+  num_upd_( 0UL ),
+  num_rej_( 0UL ),
+  num_fail_( 0UL )
+{
+}
+
+mock_rpc::~mock_rpc()
+{
+  for( mock_conn *cptr: cvec_ ) {
+    cptr->close();
+    delete cptr;
+  }
+  hsvr_.close();
+  wsvr_.close();
+}
+
+void mock_rpc::set_program( const pub_key& pgm )
+{
+  pgm_ = pgm;
+  has_pgm_ = true;
+}
+
+void mock_rpc::set_publisher( const pub_key& pub )
+{
+  pub_ = pub;
+  has_pub_ = true;
+}
+
+void mock_rpc::set_slot_time( int64_t slot_dur )
+{
+  slot_dur_ = slot_dur;
+}
+
+void mock_rpc::set_latency( int64_t lat, int64_t jitter )
+{
+  lat_ = lat;
+  jit_ = jitter;
+}
+
+void mock_rpc::set_loss( double loss )
+{
+  loss_ = loss;
+}
+
+void mock_rpc::set_seed( uint64_t seed )
+{
+  rnd_.seed( seed );
+}
+
+void mock_rpc::set_ws_port( int port )
+{
+  wport_ = port;
+}
+
+const pub_key *mock_rpc::get_mapping() const
+{
+  return has_map_ ? &map_ : nullptr;
+}
+
+unsigned mock_rpc::get_num_account() const
+{
+  return static_cast< unsigned >( avec_.size() );
+}
+
+uint64_t mock_rpc::get_slot() const
+{
+  return slot_;
+}
+
+uint64_t mock_rpc::get_num_tx() const
+{
+  return num_tx_;
+}
+
+uint64_t mock_rpc::get_num_drop() const
+{
+  return num_drop_;
+}
+
+uint64_t mock_rpc::get_num_upd() const
+{
+  return num_upd_;
+}
+
+uint64_t mock_rpc::get_num_reject() const
+{
+  return num_rej_;
+}
+
+void mock_rpc::add_leader( const pub_key& id, const std::string& tpu )
+{
+  lvec_.emplace_back( id, tpu );
+}
+
+unsigned mock_rpc::get_leader( uint64_t slot ) const
+{
+  return static_cast< unsigned >(
+      ( slot / PC_MOCK_LEADER_SLOTS ) % std::max( lvec_.size(), 1UL ) );
+}
+
+void mock_rpc::add_component( const pub_key& acc, const pub_key& pub )
+{
+  auto it = amap_.find( get_key( acc.data() ) );
+  if ( it == amap_.end() ) {
+    return;
+  }
+  mock_acc& ma = avec_[it->second];
+  pc_price_t *pptr = (pc_price_t*)ma.data_.data();
+  if ( pptr->type_ != PC_ACCTYPE_PRICE || pptr->num_ >= PC_NUM_COMP ) {
+    return;
+  }
+  pc_price_comp_t& comp = pptr->comp_[pptr->num_++];
+  __builtin_memset( &comp, 0, sizeof( comp ) );
+  pc_pub_key_assign( &comp.pub_, (pc_pub_key_t*)pub.data() );
+  ma.dirty_ = true;
+}
+
+void mock_rpc::set_log_tx( bool log_tx )
+{
+  log_tx_ = log_tx;
+}
+
+const std::vector<std::vector<pub_key>>& mock_rpc::get_tx_log() const
+{
+  return tlog_;
+}
+
+uint64_t mock_rpc::get_num_fail() const
+{
+  return num_fail_;
+}
+
+void mock_rpc::set_fail( const std::string& method, unsigned num )
+{
+  fail_[method] = num;
+}
+
+void mock_rpc::disconnect()
+{
+  for( mock_conn *cptr: cvec_ ) {
+    cptr->close();
+    delete cptr;
+  }
+  cvec_.clear();
+  smap_.clear();
+}
+
+unsigned mock_rpc::get_num_fetch( const pub_key& acc ) const
+{
+  auto it = amap_.find( get_key( acc.data() ) );
+  return it == amap_.end() ? 0U : avec_[it->second].num_fetch_;
+}
+
+bool mock_rpc::get_is_fail( str method )
+{
+  auto it = fail_.find( std::string( method.str_, method.len_ ) );
+  if ( it == fail_.end() || !it->second ) {
+    return false;
+  }
+  --it->second;
+  ++num_fail_;
+  return true;
+}
+
+void mock_rpc::add_account( const pub_key& acc, const char *ptr, size_t len )
+{
+  // accounts are zero-padded to their size as returned by the rpc node
+  const pc_acc_t *aptr = (const pc_acc_t*)ptr;
+  std::string key = get_key( acc.data() );
+  if ( len < sizeof( pc_acc_t ) || aptr->magic_ != PC_MAGIC ||
+       amap_.find( key ) != amap_.end() ) {
+    return;
+  }
+  amap_[key] = static_cast< unsigned >( avec_.size() );
+  avec_.resize( avec_.size() + 1 );
+  mock_acc& ma = avec_.back();
+  ma.acc_ = acc;
+  ma.data_.assign( ptr, ptr + len );
+  ma.data_.resize( std::max( len, get_account_size( aptr->type_ ) ) );
+  ma.num_fetch_ = 0U;
+  ma.dirty_ = false;
+  if ( aptr->type_ == PC_ACCTYPE_MAPPING && !has_map_ ) {
+    map_ = acc;
+    has_map_ = true;
+  }
+}
+
+bool mock_rpc::load_capture( const std::string& file )
+{
+  replay rep;
+  rep.set_file( file );
+  if ( !rep.init() ) {
+    return set_err_msg( rep.get_err_msg() );
+  }
+  while( rep.get_next() ) {
+    const pc_acc_t *aptr = rep.get_update();
+    pub_key acc;
+    acc.init_from_buf( (const uint8_t*)rep.get_account() );
+    add_account( acc, (const char*)aptr, aptr->size_ );
+  }
+  add_publisher();
+  return true;
+}
+
+bool mock_rpc::load_snapshot( const std::string& file )
+{
+  snapshot snap;
+  snap.set_file( file );
+  if ( !snap.init() ) {
+    return set_err_msg( snap.get_err_msg() );
+  }
+  for( unsigned i = 0; i != snap.get_num(); ++i ) {
+    pub_key acc;
+    size_t len = 0;
+    const pc_acc_t *aptr = snap.get_account( i, acc, len );
+    add_account( acc, (const char*)aptr, len );
+  }
+  add_publisher();
+  return true;
+}
+
+void mock_rpc::gen_accounts( unsigned num )
+{
+  // keys are derived from the symbol index so that runs are repeatable.
+  // the index is repeated in the second word that shards partition on
+  auto gen = []( unsigned type, unsigned i ) {
+    uint8_t buf[pub_key::len] = {};
+    buf[0] = (uint8_t)type;
+    __builtin_memcpy( &buf[1], &i, sizeof( i ) );
+    __builtin_memcpy( &buf[8], &i, sizeof( i ) );
+    pub_key acc;
+    acc.init_from_buf( buf );
+    return acc;
+  };
+  std::vector<char> mbuf( sizeof( pc_map_table_t ), 0 );
+  pc_map_table_t *mptr = (pc_map_table_t*)mbuf.data();
+  mptr->magic_ = PC_MAGIC;
+  mptr->ver_   = PC_VERSION;
+  mptr->type_  = PC_ACCTYPE_MAPPING;
+  mptr->num_   = num;
+  mptr->size_  = static_cast< uint32_t >( offsetof( pc_map_table_t, prod_ ) +
+                   num * sizeof( pc_pub_key_t ) );
+  for( unsigned i = 0; i != num; ++i ) {
+    __builtin_memcpy( &mptr->prod_[i], gen( PC_ACCTYPE_PRODUCT, i ).data(),
+                      sizeof( pc_pub_key_t ) );
+  }
+  add_account( gen( PC_ACCTYPE_MAPPING, 0 ), mbuf.data(), mbuf.size() );
+  pc_price_t px;
+  __builtin_memset( &px, 0, sizeof( px ) );
+  px.magic_  = PC_MAGIC;
+  px.ver_    = PC_VERSION;
+  px.type_   = PC_ACCTYPE_PRICE;
+  px.size_   = sizeof( pc_price_t );
+  px.ptype_  = PC_PTYPE_PRICE;
+  px.expo_   = -5;
+  for( unsigned i = 0; i != num; ++i ) {
+    pub_key prod = gen( PC_ACCTYPE_PRODUCT, i );
+    pub_key price = gen( PC_ACCTYPE_PRICE, i );
+    char buf[PC_PROD_ACC_SIZE] = {};
+    pc_prod_t *pptr = (pc_prod_t*)buf;
+    pptr->magic_ = PC_MAGIC;
+    pptr->ver_   = PC_VERSION;
+    pptr->type_  = PC_ACCTYPE_PRODUCT;
+    __builtin_memcpy( &pptr->px_acc_, price.data(), sizeof( pc_pub_key_t ) );
+    std::string sym = "MOCK" + std::to_string( i ) + "/USD";
+    std::string attr = "\006symbol";
+    attr += (char)sym.size();
+    attr += sym + "\012asset_type\006Crypto";
+    __builtin_memcpy( &buf[sizeof( pc_prod_t )], attr.data(), attr.size() );
+    pptr->size_ = static_cast< uint32_t >( sizeof( pc_prod_t ) + attr.size() );
+    add_account( prod, buf, sizeof( buf ) );
+    __builtin_memcpy( &px.prod_, prod.data(), sizeof( pc_pub_key_t ) );
+    add_account( price, (const char*)&px, sizeof( px ) );
+  }
+  add_publisher();
+}
+
+void mock_rpc::add_publisher()
+{
+  if ( !has_pub_ ) {
+    return;
+  }
+  pc_pub_key_t *pk = (pc_pub_key_t*)pub_.data();
+  for( mock_acc& ma: avec_ ) {
+    pc_price_t *pptr = (pc_price_t*)ma.data_.data();
+    if ( pptr->type_ != PC_ACCTYPE_PRICE || pptr->num_ >= PC_NUM_COMP ) {
+      continue;
+    }
+    bool has_pub = false;
+    for( uint32_t i = 0; !has_pub && i != pptr->num_; ++i ) {
+      has_pub = pc_pub_key_equal( &pptr->comp_[i].pub_, pk );
+    }
+    if ( !has_pub ) {
+      pc_price_comp_t& comp = pptr->comp_[pptr->num_++];
+      __builtin_memset( &comp, 0, sizeof( comp ) );
+      pc_pub_key_assign( &comp.pub_, pk );
+    }
+  }
+}
+
+bool mock_rpc::init( net_loop *lp, int port )
+{
+  lp_ = lp;
+  hsvr_.set_port( port );
+  hsvr_.set_net_accept( this );
+  hsvr_.set_net_loop( lp );
+  if ( !hsvr_.init() ) {
+    return set_err_msg( hsvr_.get_err_msg() );
+  }
+  if ( wport_ ) {
+    wsvr_.set_port( wport_ );
+    wsvr_.set_net_accept( this );
+    wsvr_.set_net_loop( lp );
+    if ( !wsvr_.init() ) {
+      return set_err_msg( wsvr_.get_err_msg() );
+    }
+  }
+  slot_ts_ = get_now() + slot_dur_;
+  return true;
+}
+
+int mock_rpc::get_port() const
+{
+  return hsvr_.get_port();
+}
+
+void mock_rpc::accept( int fd )
+{
+  mock_conn *cptr = new mock_conn( this );
+  cptr->set_net_loop( lp_ );
+  cptr->set_fd( fd );
+  cptr->set_block( false );
+  cptr->init();
+  cvec_.push_back( cptr );
+}
+
+void mock_rpc::poll()
+{
+  int64_t ts = get_now();
+
+  // transactions due
+  while( !txs_.empty() && txs_.begin()->first <= ts ) {
+    apply_tx( txs_.begin()->second );
+    txs_.erase( txs_.begin() );
+  }
+
+  // slots advance on the clock regardless of load
+  while( slot_dur_ && ts >= slot_ts_ ) {
+    next_slot( ts );
+    slot_ts_ += slot_dur_;
+  }
+
+  // drop disconnected clients and their subscriptions
+  for( size_t i = 0; i != cvec_.size(); ) {
+    mock_conn *cptr = cvec_[i];
+    if ( !cptr->get_is_err() ) {
+      ++i;
+      continue;
+    }
+    for( auto it = smap_.begin(); it != smap_.end(); ) {
+      it = it->second.conn_ == cptr ? smap_.erase( it ) : std::next( it );
+    }
+    cptr->close();
+    delete cptr;
+    cvec_[i] = cvec_.back();
+    cvec_.pop_back();
+  }
+}
+
+void mock_rpc::set_slot( uint64_t slot )
+{
+  if ( slot > slot_ ) {
+    slot_ = slot - 1UL;
+    next_slot( get_now() );
+  }
+}
+
+void mock_rpc::next_slot( int64_t ts )
+{
+  // aggregate prices updated in the last slot
+  ++slot_;
+  for( mock_acc& ma: avec_ ) {
+    if ( ma.dirty_ ) {
+      aggregate_price( (pc_price_t*)ma.data_.data(), slot_,
+                       ts / PC_NSECS_IN_SEC );
+      notify( ma );
+      ma.dirty_ = false;
+    }
+  }
+  notify_slot();
+  for( auto it = sigs_.begin(); it != sigs_.end(); ) {
+    it = it->second + PC_MOCK_SIG_SLOTS < slot_ ? sigs_.erase( it )
+                                                : std::next( it );
+  }
+}
+
+void mock_rpc::add_context( json_wtr& jw )
+{
+  jw.add_key( "context", json_wtr::e_obj );
+  jw.add_key( "slot", slot_ );
+  jw.pop();
+}
+
+void mock_rpc::add_data( json_wtr& jw, const mock_acc& ma,
+                         const mock_filter *filt )
+{
+  // account data as [ text, encoding ]
+  const char *ptr = ma.data_.data();
+  size_t len = ma.data_.size();
+  if ( filt && filt->slice_ ) {
+    size_t off = std::min( filt->off_, len );
+    ptr += off;
+    len = std::min( filt->len_, len - off );
+  }
+  jw.add_key( "data", json_wtr::e_arr );
+  if ( !filt || filt->zstd_ ) {
+    zbuf_.resize( ZSTD_compressBound( len ) );
+    size_t zlen = ZSTD_compress( zbuf_.data(), zbuf_.size(), ptr, len, 1 );
+    jw.add_val_enc_base64( str( zbuf_.data(), zlen ) );
+    jw.add_val( str( "base64+zstd" ) );
+  } else {
+    jw.add_val_enc_base64( str( ptr, len ) );
+    jw.add_val( str( "base64" ) );
+  }
+  jw.pop();
+}
+
+void mock_rpc::add_value( json_wtr& jw, const mock_acc& ma,
+                          const mock_filter *filt )
+{
+  // account fields of an open object
+  add_data( jw, ma, filt );
+  jw.add_key( "executable", json_wtr::jfalse() );
+  jw.add_key( "lamports", 1000000000UL );
+  jw.add_key( "owner", pgm_ );
+  jw.add_key( "rentEpoch", 0UL );
+}
+
+void mock_rpc::add_program_accounts( json_wtr& jw, const mock_filter& filt )
+{
+  // matching accounts as values of an open array
+  for( const mock_acc& ma: avec_ ) {
+    if ( filt.match( ma.data_ ) ) {
+      jw.add_val( json_wtr::e_obj );
+      jw.add_key( "pubkey", ma.acc_ );
+      jw.add_key( "account", json_wtr::e_obj );
+      add_value( jw, ma, &filt );
+      jw.pop();
+      jw.pop();
+    }
+  }
+}
+
+void mock_rpc::notify( const mock_acc& ma )
+{
+  for( auto& it: smap_ ) {
+    mock_sub& sub = it.second;
+    bool is_acc = sub.type_ == e_account && &avec_[sub.idx_] == &ma;
+    if ( !is_acc && !( sub.type_ == e_program &&
+                       sub.filt_.match( ma.data_ ) ) ) {
+      continue;
+    }
+    json_wtr jw;
+    jw.add_val( json_wtr::e_obj );
+    jw.add_key( "jsonrpc", "2.0" );
+    jw.add_key( "method",
+        is_acc ? "accountNotification" : "programNotification" );
+    jw.add_key( "params", json_wtr::e_obj );
+    jw.add_key( "result", json_wtr::e_obj );
+    add_context( jw );
+    jw.add_key( "value", json_wtr::e_obj );
+    if ( is_acc ) {
+      add_value( jw, ma, &sub.filt_ );
+    } else {
+      jw.add_key( "pubkey", ma.acc_ );
+      jw.add_key( "account", json_wtr::e_obj );
+      add_value( jw, ma, &sub.filt_ );
+      jw.pop();
+    }
+    jw.pop();
+    jw.pop();
+    jw.add_key( "subscription", it.first );
+    jw.pop();
+    jw.pop();
+    sub.conn_->send( jw, true );
+  }
+}
+
+void mock_rpc::notify_slot()
+{
+  for( auto& it: smap_ ) {
+    if ( it.second.type_ != e_slot ) {
+      continue;
+    }
+    json_wtr jw;
+    jw.add_val( json_wtr::e_obj );
+    jw.add_key( "jsonrpc", "2.0" );
+    jw.add_key( "method", "slotNotification" );
+    jw.add_key( "params", json_wtr::e_obj );
+    jw.add_key( "result", json_wtr::e_obj );
+    jw.add_key( "parent", slot_ - 1UL );
+    jw.add_key( "root", slot_ - PC_MOCK_ROOT_DEPTH );
+    jw.add_key( "slot", slot_ );
+    jw.pop();
+    jw.add_key( "subscription", it.first );
+    jw.pop();
+    jw.pop();
+    it.second.conn_->send( jw, true );
+  }
+}
+
+void mock_rpc::add_sub( json_wtr& jw, mock_conn *conn, mock_sub& sub )
+{
+  sub.conn_ = conn;
+  uint64_t id = ++sub_id_;
+  smap_[id] = sub;
+  jw.add_key( "result", id );
+}
+
+// compact-u16 length of the transaction wire format
+static bool get_len( const uint8_t *&ptr, const uint8_t *end, size_t& len )
+{
+  len = 0UL;
+  for( unsigned sh = 0; ptr != end; sh += 7 ) {
+    uint8_t c = *ptr++;
+    len |= (size_t)( c & 0x7f ) << sh;
+    if ( !( c & 0x80 ) ) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void mock_rpc::add_tx( const jtree& jt, uint32_t ptok, json_wtr& jw )
+{
+  // transaction is acknowledged with its signature and applied after
+  // the injected latency unless dropped
+  uint32_t ttok = jt.get_first( ptok );
+  str txt = jt.get_str( ttok );
+  bool is_b64 = jt.get_str( jt.find_val( jt.get_next( ttok ), "encoding" ) )
+                  == "base64";
+  tbuf_.resize( txt.len_ + 1 );
+  int len = is_b64
+    ? (int)dec_base64( txt.str_, (int)txt.len_, tbuf_.data() )
+    : dec_base58( (const uint8_t*)txt.str_, (int)txt.len_, tbuf_.data() );
+  const uint8_t *ptr = tbuf_.data(), *end = ptr + std::max( len, 0 );
+  size_t num = 0;
+  if ( !get_len( ptr, end, num ) || !num ||
+       (size_t)( end - ptr ) < signature::len ) {
+    jw.add_key( "error", json_wtr::e_obj );
+    jw.add_key( "code", -32602L );
+    jw.add_key( "message", "invalid transaction" );
+    jw.pop();
+    return;
+  }
+  ++num_tx_;
+  jw.add_key_enc_base58( "result", str( (const char*)ptr, signature::len ) );
+  std::uniform_real_distribution<double> ud( 0., 1. );
+  if ( loss_ > 0. && ud( rnd_ ) < loss_ ) {
+    ++num_drop_;
+    return;
+  }
+  int64_t ts = get_now() + lat_;
+  if ( jit_ > 0L ) {
+    ts += (int64_t)( ud( rnd_ ) * (double)jit_ );
+  }
+  txs_.emplace( ts, std::string( (const char*)tbuf_.data(),
+                                 (size_t)std::max( len, 0 ) ) );
+}
+
+void mock_rpc::apply_tx( const std::string& tx )
+{
+  // signatures, message header, accounts, block hash and instructions
+  const uint8_t *ptr = (const uint8_t*)tx.data(), *end = ptr + tx.size();
+  size_t num = 0, nacc = 0;
+  if ( !get_len( ptr, end, num ) ||
+       (size_t)( end - ptr ) < num * signature::len + 3 ) {
+    return;
+  }
+  sigs_[std::string( (const char*)ptr, signature::len )] = slot_;
+  ptr += num * signature::len + 3;
+  if ( !get_len( ptr, end, nacc ) ||
+       (size_t)( end - ptr ) < ( nacc + 1 ) * pub_key::len ) {
+    return;
+  }
+  const uint8_t *acc = ptr;
+  ptr += ( nacc + 1 ) * pub_key::len;
+  if ( !get_len( ptr, end, num ) ) {
+    return;
+  }
+  if ( log_tx_ ) {
+    tlog_.emplace_back();
+  }
+  for( size_t i = 0; i != num && ptr != end; ++i ) {
+    size_t pgm = *ptr++, nidx = 0, dlen = 0;
+    if ( !get_len( ptr, end, nidx ) || (size_t)( end - ptr ) < nidx ) {
+      return;
+    }
+    const uint8_t *idx = ptr;
+    ptr += nidx;
+    if ( !get_len( ptr, end, dlen ) || (size_t)( end - ptr ) < dlen ) {
+      return;
+    }
+    const uint8_t *data = ptr;
+    ptr += dlen;
+    if ( pgm >= nacc || nidx < 2 || idx[0] >= nacc || idx[1] >= nacc ||
+         dlen != sizeof( cmd_upd_price_t ) ||
+         ( has_pgm_ && __builtin_memcmp( &acc[pgm*pub_key::len],
+                                         pgm_.data(), pub_key::len ) ) ) {
+      continue;
+    }
+    cmd_upd_price_t cmd;
+    __builtin_memcpy( &cmd, data, sizeof( cmd ) );
+    if ( cmd.cmd_ != e_cmd_upd_price &&
+         cmd.cmd_ != e_cmd_upd_price_no_fail_on_error ) {
+      continue;
+    }
+    if ( log_tx_ ) {
+      pub_key pkey;
+      pkey.init_from_buf( &acc[idx[1]*pub_key::len] );
+      tlog_.back().push_back( pkey );
+    }
+    on_upd_price( (const pc_pub_key_t*)&acc[idx[0]*pub_key::len],
+                  (const pc_pub_key_t*)&acc[idx[1]*pub_key::len], cmd );
+  }
+}
+
+void mock_rpc::on_upd_price( const pc_pub_key_t *pub,
+                             const pc_pub_key_t *acc,
+                             const cmd_upd_price_t& cmd )
+{
+  // publisher must be a component with a newer publish slot
+  auto it = amap_.find( get_key( acc ) );
+  pc_price_t *pptr = it == amap_.end() ? nullptr
+    : (pc_price_t*)avec_[it->second].data_.data();
+  pc_price_info_t *info = nullptr;
+  for( uint32_t j = 0; pptr && pptr->type_ == PC_ACCTYPE_PRICE &&
+                       j != pptr->num_ && j != PC_NUM_COMP; ++j ) {
+    if ( pc_pub_key_equal( &pptr->comp_[j].pub_, (pc_pub_key_t*)pub ) ) {
+      info = &pptr->comp_[j].latest_;
+      break;
+    }
+  }
+  if ( !info || cmd.pub_slot_ <= info->pub_slot_ ) {
+    ++num_rej_;
+    return;
+  }
+  info->price_    = cmd.price_;
+  info->conf_     = cmd.conf_;
+  info->status_   = cmd.status_;
+  info->pub_slot_ = cmd.pub_slot_;
+  avec_[it->second].dirty_ = true;
+  ++num_upd_;
+}
+
+void mock_rpc::reply( mock_conn *conn, const char *txt, size_t len,
+                      bool is_ws )
+{
+  jtree jt;
+  jt.parse( txt, len );
+  str method = jt.get_str( jt.find_val( 1, "method" ) );
+  uint32_t ptok = jt.find_val( 1, "params" );
+  uint32_t atok = jt.get_first( ptok );
+  uint32_t otok = jt.get_next( atok );
+  json_wtr jw;
+  jw.add_val( json_wtr::e_obj );
+  jw.add_key( "jsonrpc", "2.0" );
+  if ( get_is_fail( method ) ) {
+    jw.add_key( "error", json_wtr::e_obj );
+    jw.add_key( "code", -32005L );
+    jw.add_key( "message", "Node is behind" );
+    jw.pop();
+  } else if ( method == "getSlot" ) {
+    jw.add_key( "result", slot_ );
+  } else if ( method == "getRecentBlockhash" ||
+              method == "getLatestBlockhash" ) {
+    // block hash changes with every slot
+    hash bhash;
+    bhash.zero();
+    __builtin_memcpy( (void*)bhash.data(), &slot_, sizeof( slot_ ) );
+    jw.add_key( "result", json_wtr::e_obj );
+    add_context( jw );
+    jw.add_key( "value", json_wtr::e_obj );
+    jw.add_key( "blockhash", bhash );
+    jw.add_key( "feeCalculator", json_wtr::e_obj );
+    jw.add_key( "lamportsPerSignature", 5000UL );
+    jw.pop();
+    jw.add_key( "lastValidBlockHeight", slot_ + 150UL );
+    jw.pop();
+    jw.pop();
+  } else if ( method == "getRecentPrioritizationFees" ) {
+    jw.add_key( "result", json_wtr::e_arr );
+    jw.pop();
+  } else if ( method == "getAccountInfo" ) {
+    mock_filter filt;
+    filt.init( jt, otok );
+    pub_key acc;
+    acc.init_from_text( jt.get_str( atok ) );
+    auto it = amap_.find( get_key( acc.data() ) );
+    jw.add_key( "result", json_wtr::e_obj );
+    add_context( jw );
+    if ( it == amap_.end() ) {
+      jw.add_key( "value", json_wtr::null() );
+    } else {
+      jw.add_key( "value", json_wtr::e_obj );
+      add_value( jw, avec_[it->second], &filt );
+      jw.pop();
+      ++avec_[it->second].num_fetch_;
+    }
+    jw.pop();
+  } else if ( method == "getMultipleAccounts" &&
+              jt.get_uint( jt.find_val( otok, "minContextSlot" ) ) > slot_ ) {
+    jw.add_key( "error", json_wtr::e_obj );
+    jw.add_key( "code", -32016L );
+    jw.add_key( "message", "Minimum context slot has not been reached" );
+    jw.pop();
+  } else if ( method == "getMultipleAccounts" ) {
+    mock_filter filt;
+    filt.init( jt, otok );
+    jw.add_key( "result", json_wtr::e_obj );
+    add_context( jw );
+    jw.add_key( "value", json_wtr::e_arr );
+    for( uint32_t tok = jt.get_first( atok ); tok;
+         tok = jt.get_next( tok ) ) {
+      pub_key acc;
+      acc.init_from_text( jt.get_str( tok ) );
+      auto it = amap_.find( get_key( acc.data() ) );
+      if ( it == amap_.end() ) {
+        jw.add_verbatim( str( "null" ) );
+      } else {
+        jw.add_val( json_wtr::e_obj );
+        add_value( jw, avec_[it->second], &filt );
+        jw.pop();
+        ++avec_[it->second].num_fetch_;
+      }
+    }
+    jw.pop();
+    jw.pop();
+  } else if ( method == "getProgramAccounts" ) {
+    mock_filter filt;
+    if ( !has_pgm_ ) {
+      pub_key pgm;
+      pgm.init_from_text( jt.get_str( atok ) );
+      set_program( pgm );
+    }
+    filt.init( jt, otok );
+    if ( jt.find_val( otok, "withContext" ) ) {
+      jw.add_key( "result", json_wtr::e_obj );
+      add_context( jw );
+      jw.add_key( "value", json_wtr::e_arr );
+      add_program_accounts( jw, filt );
+      jw.pop();
+      jw.pop();
+    } else {
+      jw.add_key( "result", json_wtr::e_arr );
+      add_program_accounts( jw, filt );
+      jw.pop();
+    }
+  } else if ( method == "getSignatureStatuses" ) {
+    jw.add_key( "result", json_wtr::e_obj );
+    add_context( jw );
+    jw.add_key( "value", json_wtr::e_arr );
+    for( uint32_t tok = jt.get_first( atok ); tok;
+         tok = jt.get_next( tok ) ) {
+      signature sig;
+      str stxt = jt.get_str( tok );
+      sig.init_from_text( std::string( stxt.str_, stxt.len_ ) );
+      auto it = sigs_.find( std::string( (const char*)sig.data(),
+                                         signature::len ) );
+      if ( it == sigs_.end() ) {
+        jw.add_verbatim( str( "null" ) );
+      } else {
+        jw.add_val( json_wtr::e_obj );
+        jw.add_key( "slot", it->second );
+        jw.add_key( "confirmations", json_wtr::null() );
+        jw.add_key( "err", json_wtr::null() );
+        jw.add_key( "confirmationStatus", "processed" );
+        jw.pop();
+      }
+    }
+    jw.pop();
+    jw.pop();
+  } else if ( method == "sendTransaction" ) {
+    add_tx( jt, ptok, jw );
+  } else if ( is_ws && method == "slotSubscribe" ) {
+    mock_sub sub;
+    sub.type_ = e_slot;
+    add_sub( jw, conn, sub );
+  } else if ( is_ws && method == "accountSubscribe" ) {
+    pub_key acc;
+    acc.init_from_text( jt.get_str( atok ) );
+    auto it = amap_.find( get_key( acc.data() ) );
+    mock_sub sub;
+    sub.type_ = e_account;
+    sub.idx_ = it == amap_.end() ? 0U : it->second;
+    if ( it == amap_.end() || !sub.filt_.init( jt, otok ) ) {
+      jw.add_key( "error", json_wtr::e_obj );
+      jw.add_key( "code", -32602L );
+      jw.add_key( "message", "unknown account" );
+      jw.pop();
+    } else {
+      add_sub( jw, conn, sub );
+    }
+  } else if ( is_ws && method == "programSubscribe" ) {
+    if ( !has_pgm_ ) {
+      pub_key pgm;
+      pgm.init_from_text( jt.get_str( atok ) );
+      set_program( pgm );
+    }
+    mock_sub sub;
+    sub.type_ = e_program;
+    if ( !sub.filt_.init( jt, otok ) ) {
+      jw.add_key( "error", json_wtr::e_obj );
+      jw.add_key( "code", -32602L );
+      jw.add_key( "message", "invalid filter" );
+      jw.pop();
+    } else {
+      add_sub( jw, conn, sub );
+    }
+  } else if ( is_ws && ( method == "slotUnsubscribe" ||
+                         method == "accountUnsubscribe" ||
+                         method == "programUnsubscribe" ) ) {
+    auto it = smap_.find( jt.get_uint( atok ) );
+    bool is_sub = it != smap_.end() && it->second.conn_ == conn;
+    if ( is_sub ) {
+      smap_.erase( it );
+    }
+    if ( is_sub ) {
+      jw.add_key( "result", json_wtr::jtrue() );
+    } else {
+      jw.add_key( "result", json_wtr::jfalse() );
+    }
+  } else if ( method == "getHealth" ) {
+    jw.add_key( "result", "ok" );
+  } else if ( method == "getClusterNodes" ) {
+    jw.add_key( "result", json_wtr::e_arr );
+    for( const auto& ldr: lvec_ ) {
+      jw.add_val( json_wtr::e_obj );
+      jw.add_key( "pubkey", ldr.first );
+      jw.add_key( "tpu", ldr.second );
+      jw.pop();
+    }
+    jw.pop();
+  } else if ( method == "getSlotLeaders" ) {
+    // leaders of limit slots from start
+    uint64_t slot = jt.get_uint( atok );
+    uint64_t end = slot + jt.get_uint( otok );
+    jw.add_key( "result", json_wtr::e_arr );
+    for( ; !lvec_.empty() && slot != end; ++slot ) {
+      jw.add_val( lvec_[get_leader( slot )].first );
+    }
+    jw.pop();
+  } else {
+    jw.add_key( "error", json_wtr::e_obj );
+    jw.add_key( "code", -32601L );
+    jw.add_key( "message", "method not found" );
+    jw.pop();
+  }
+  jw.add_key( "id", jt.get_uint( jt.find_val( 1, "id" ) ) );
+  jw.pop();
+  conn->send( jw, is_ws );
+}
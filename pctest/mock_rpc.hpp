@@ -0,0 +1,248 @@
+#pragma once
+
+#include <pc/jtree.hpp>
+#include <pc/key_pair.hpp>
+#include <pc/net_socket.hpp>
+#include <oracle/oracle.h>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pc
+{
+
+  // account filter and data slice of program subscriptions
+  struct mock_filter
+  {
+    bool init( const jtree&, uint32_t otok );
+    bool match( const std::vector<char>& ) const;
+
+    typedef std::pair<size_t,std::string> cmp_t;
+
+    std::vector<cmp_t> cvec_;   // memcmp filters
+    size_t             size_;   // dataSize filter or 0
+    size_t             off_;    // dataSlice
+    size_t             len_;
+    bool               slice_;
+    bool               zstd_;   // base64+zstd encoding
+  };
+
+  class mock_rpc;
+
+  // http or websocket client connection
+  class mock_conn : public net_connect
+  {
+  public:
+    mock_conn( mock_rpc * );
+    void send( json_wtr&, bool is_ws );
+
+  private:
+    struct mock_http : public http_server {
+      void parse_content( const char *, size_t ) override;
+      mock_conn *cp_;
+    };
+    struct mock_ws : public ws_parser {
+      void parse_msg( const char *, size_t ) override;
+      mock_conn *cp_;
+    };
+
+    mock_rpc *rpc_;
+    mock_http http_;
+    mock_ws   ws_;
+  };
+
+  // mock solana rpc node shared by the performance tests. serves
+  // mapping, product and price accounts over http and websockets,
+  // advances slots on a fixed cadence or as told with slot
+  // notifications and accepts sendTransaction with injected latency and
+  // loss. upd_price instructions of accepted transactions are applied to
+  // the price accounts which are aggregated at the next slot and sent to
+  // account and program subscribers
+  class mock_rpc : public net_accept, public error
+  {
+  public:
+
+    mock_rpc();
+    ~mock_rpc();
+
+    // owner of the accounts (default first program subscribed to)
+    void set_program( const pub_key& );
+
+    // publisher added as component to prices that do not have it
+    void set_publisher( const pub_key& );
+
+    // slot duration of the slot clock (default 0 - slots only advance
+    // by set_slot)
+    void set_slot_time( int64_t );
+
+    // delay and uniformly distributed jitter before a transaction is
+    // applied and fraction of transactions dropped
+    void set_latency( int64_t lat, int64_t jitter );
+    void set_loss( double );
+
+    // random seed of jitter and loss
+    void set_seed( uint64_t );
+
+    // websocket listening port (default none)
+    void set_ws_port( int );
+
+    // cluster node with tpu address (host:port) that leads
+    // PC_MOCK_LEADER_SLOTS consecutive slots in the turn it was added in
+    void add_leader( const pub_key&, const std::string& tpu );
+
+    // index in the order added of the leader of slot
+    unsigned get_leader( uint64_t slot ) const;
+
+    // publisher added as component of price account acc, notified at the
+    // next slot
+    void add_component( const pub_key& acc, const pub_key& pub );
+
+    // price accounts updated by each transaction applied, in order of
+    // application, while enabled (default off)
+    void set_log_tx( bool );
+    const std::vector<std::vector<pub_key>>& get_tx_log() const;
+
+    // fail the next num requests of method with an rpc error
+    void set_fail( const std::string& method, unsigned num );
+
+    // close every client connection and drop its subscriptions
+    void disconnect();
+
+    // times account acc was returned by getAccountInfo or
+    // getMultipleAccounts
+    unsigned get_num_fetch( const pub_key& acc ) const;
+
+    // account content zero-padded to the size of its type. the first
+    // mapping account added is the mapping
+    void add_account( const pub_key&, const char *, size_t );
+
+    // accounts of a capture (first content of every account), a snapshot
+    // or num synthetic symbols
+    bool load_capture( const std::string& );
+    bool load_snapshot( const std::string& );
+    void gen_accounts( unsigned num );
+
+    // first mapping account
+    const pub_key *get_mapping() const;
+    unsigned get_num_account() const;
+
+    // listen for http on port (0 - any) and connections on loop
+    bool init( net_loop *, int port );
+    int get_port() const;
+
+    // advance slots, apply transactions and drop disconnected clients.
+    // connections are polled with the loop
+    void poll();
+
+    // advance to slot
+    void set_slot( uint64_t );
+    uint64_t get_slot() const;
+
+    void accept( int fd ) override;
+    void reply( mock_conn *, const char *, size_t, bool is_ws );
+
+    // on applying an upd_price instruction of publisher pub to price
+    // account acc. by default updates its component in the account
+    virtual void on_upd_price( const pc_pub_key_t *pub,
+                               const pc_pub_key_t *acc,
+                               const cmd_upd_price_t& );
+
+    // statistics
+    uint64_t get_num_tx() const;
+    uint64_t get_num_drop() const;
+    uint64_t get_num_upd() const;
+    uint64_t get_num_reject() const;
+    uint64_t get_num_fail() const;
+
+    // size of an account of type as returned by the rpc node
+    static size_t get_account_size( uint32_t type );
+
+    // free tcp port
+    static int get_free_port();
+
+    // program and publish key pairs of a manager key directory
+    static bool init_keys( const std::string& dir, pub_key *pub );
+
+    // mapping key of a manager key directory
+    static bool init_mapping_key( const std::string& dir, const pub_key& );
+
+  private:
+
+    typedef enum { e_slot, e_account, e_program } sub_t;
+
+    struct mock_acc {
+      pub_key           acc_;
+      std::vector<char> data_;
+      unsigned          num_fetch_;
+      bool              dirty_;
+    };
+
+    struct mock_sub {
+      sub_t       type_;
+      mock_conn  *conn_;
+      unsigned    idx_;   // account index of account subscription
+      mock_filter filt_;
+    };
+
+    typedef std::unordered_map<std::string,unsigned> idx_map_t;
+    typedef std::unordered_map<uint64_t,mock_sub>    sub_map_t;
+    typedef std::unordered_map<std::string,uint64_t> sig_map_t;
+    typedef std::unordered_map<std::string,unsigned> fail_map_t;
+    typedef std::multimap<int64_t,std::string>       tx_map_t;
+    typedef std::vector<mock_conn*>                  conn_vec_t;
+    typedef std::vector<mock_acc>                    acc_vec_t;
+    typedef std::vector<std::pair<pub_key,std::string>> ldr_vec_t;
+
+    void add_publisher();
+    void add_data( json_wtr&, const mock_acc&, const mock_filter * );
+    void add_value( json_wtr&, const mock_acc&, const mock_filter * );
+    void add_context( json_wtr& );
+    void add_program_accounts( json_wtr&, const mock_filter& );
+    void add_sub( json_wtr&, mock_conn *, mock_sub& );
+    void add_tx( const jtree&, uint32_t ptok, json_wtr& );
+    void apply_tx( const std::string& );
+    void next_slot( int64_t ts );
+    void notify( const mock_acc& );
+    void notify_slot();
+    bool get_is_fail( str method );
+
+    net_loop       *lp_;
+    tcp_listen      hsvr_;
+    tcp_listen      wsvr_;
+    conn_vec_t      cvec_;
+    acc_vec_t       avec_;
+    ldr_vec_t       lvec_;     // leader identity and tpu address
+    std::vector<std::vector<pub_key>> tlog_; // accounts by applied tx
+    idx_map_t       amap_;
+    sub_map_t       smap_;
+    sig_map_t       sigs_;     // landing slot by signature
+    fail_map_t      fail_;     // failures left by method
+    tx_map_t        txs_;      // transactions by time to apply
+    pub_key         pgm_;
+    pub_key         pub_;
+    pub_key         map_;
+    bool            has_pgm_;
+    bool            has_pub_;
+    bool            has_map_;
+    bool            log_tx_;
+    int             wport_;
+    int64_t         slot_dur_;
+    int64_t         lat_;
+    int64_t         jit_;
+    double          loss_;
+    std::mt19937_64 rnd_;
+    uint64_t        slot_;
+    int64_t         slot_ts_;  // start of the next slot
+    uint64_t        sub_id_;
+    uint64_t        num_tx_;
+    uint64_t        num_drop_;
+    uint64_t        num_upd_;
+    uint64_t        num_rej_;
+    uint64_t        num_fail_;
+    std::vector<char>    zbuf_;
+    std::vector<uint8_t> tbuf_;
+  };
+
+}
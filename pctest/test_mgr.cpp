@@ -0,0 +1,946 @@
+#include <pc/manager.hpp>
+#include <pc/user.hpp>
+#include <pc/log.hpp>
+#include <pc/misc.hpp>
+#include "mock_rpc.hpp"
+#include "test_error.hpp"
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+
+#define PC_TEST_WAIT (10L*PC_NSECS_IN_SEC)
+
+using namespace pc;
+
+// manager bootstrapped from a mock rpc node in a fresh key directory.
+// both are polled on the calling thread
+class test_rig
+{
+public:
+  test_rig();
+  ~test_rig();
+
+  // mock node serving num synthetic symbols and a manager connected to
+  // it but not yet bootstrapped
+  bool init( unsigned num_sym );
+
+  void poll();
+
+  // poll until done returns true or timeout
+  template<class F> bool wait( F done, int64_t timeout = PC_TEST_WAIT );
+
+  net_loop    lp_;
+  mock_rpc    rpc_;
+  manager     mgr_;
+  std::string dir_;
+  pub_key     pub_;  // publisher of the components
+};
+
+test_rig::test_rig()
+{
+  char tmpl[] = "/tmp/test_mgr.XXXXXX";
+  if ( ::mkdtemp( tmpl ) ) {
+    dir_ = std::string( tmpl ) + "/";
+  }
+}
+
+test_rig::~test_rig()
+{
+  mgr_.teardown();
+  DIR *dptr = dir_.empty() ? nullptr : ::opendir( dir_.c_str() );
+  if ( !dptr ) {
+    return;
+  }
+  for( struct dirent *ent; ( ent = ::readdir( dptr ) ); ) {
+    if ( ent->d_name[0] != '.' ) {
+      ::unlink( ( dir_ + ent->d_name ).c_str() );
+    }
+  }
+  ::closedir( dptr );
+  ::rmdir( dir_.c_str() );
+}
+
+bool test_rig::init( unsigned num_sym )
+{
+  if ( dir_.empty() || !lp_.init() ||
+       !mock_rpc::init_keys( dir_, &pub_ ) ) {
+    return false;
+  }
+  mgr_.set_dir( dir_ );
+  rpc_.set_program( *mgr_.get_program_pub_key() );
+  rpc_.set_publisher( pub_ );
+  rpc_.gen_accounts( num_sym );
+  int wport = mock_rpc::get_free_port();
+  rpc_.set_ws_port( wport );
+  if ( !rpc_.init( &lp_, 0 ) ||
+       !mock_rpc::init_mapping_key( dir_, *rpc_.get_mapping() ) ) {
+    return false;
+  }
+  mgr_.set_rpc_host( "127.0.0.1:" + std::to_string( rpc_.get_port() ) +
+                     ":" + std::to_string( wport ) );
+  mgr_.set_listen_port( mock_rpc::get_free_port() );
+  mgr_.set_do_tx( false );
+  return mgr_.init();
+}
+
+void test_rig::poll()
+{
+  lp_.poll( 0 );
+  rpc_.poll();
+  mgr_.poll( true );
+}
+
+template<class F> bool test_rig::wait( F done, int64_t timeout )
+{
+  int64_t ts = get_now();
+  while( !done() ) {
+    if ( mgr_.get_is_err() || get_now() - ts > timeout ) {
+      return false;
+    }
+    poll();
+  }
+  return true;
+}
+
+// websocket client of the manager's user port
+class test_user : public ws_parser
+{
+public:
+  bool init( test_rig& );
+  bool get_is_wait();
+  void close();
+
+  // send json rpc request of method with params built by add
+  template<class F> void send( const char *method, uint64_t id, F add );
+
+  // send binary message
+  void send_binary( const std::string& );
+
+  // messages received
+  void parse_msg( const char *buf, size_t len ) override {
+    msgs_.emplace_back( buf, len );
+  }
+
+  ws_connect               conn_;
+  std::vector<std::string> msgs_;
+};
+
+bool test_user::init( test_rig& rig )
+{
+  conn_.set_host( "127.0.0.1" );
+  conn_.set_port( rig.mgr_.get_listen_port() );
+  conn_.set_net_parser( this );
+  conn_.set_net_loop( &rig.lp_ );
+  set_net_connect( &conn_ );
+  return conn_.init();
+}
+
+bool test_user::get_is_wait()
+{
+  if ( conn_.get_is_wait() ) {
+    conn_.check();
+  }
+  return conn_.get_is_wait();
+}
+
+void test_user::close()
+{
+  conn_.close();
+}
+
+template<class F>
+void test_user::send( const char *method, uint64_t id, F add )
+{
+  json_wtr jw;
+  jw.add_val( json_wtr::e_obj );
+  jw.add_key( "jsonrpc", "2.0" );
+  jw.add_key( "method", method );
+  jw.add_key( "params", json_wtr::e_obj );
+  add( jw );
+  jw.pop();
+  jw.add_key( "id", id );
+  jw.pop();
+  ws_wtr msg;
+  msg.commit( ws_wtr::text_id, jw, true );
+  conn_.add_send( msg );
+}
+
+void test_user::send_binary( const std::string& buf )
+{
+  net_wtr wtr;
+  wtr.add( str( buf ) );
+  ws_wtr msg;
+  msg.commit( ws_wtr::binary_id, wtr, true );
+  conn_.add_send( msg );
+}
+
+void test_fetch_error()
+{
+  // failed batched account requests are retried until every account
+  // has been fetched instead of failing the manager
+  test_rig rig;
+  PC_TEST_CHECK( rig.init( 150 ) );
+  rig.rpc_.set_fail( "getMultipleAccounts", 3 );
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return rig.mgr_.has_status( PC_PYTH_HAS_MAPPING ); } ) );
+  PC_TEST_CHECK( rig.rpc_.get_num_fail() == 3 );
+  PC_TEST_CHECK( rig.mgr_.get_num_product() == 150 );
+  bool is_ok = true;
+  for( unsigned i = 0; i != rig.mgr_.get_num_product(); ++i ) {
+    product *prod = rig.mgr_.get_product( i );
+    is_ok = is_ok && prod->get_num_price() == 1 &&
+      prod->get_price( 0 )->get_price_exponent() == -5;
+  }
+  PC_TEST_CHECK( is_ok );
+}
+
+// aggregate notifications of a price and the thread they arrived on
+class test_price_sub : public request_sub,
+                       public request_sub_i<price>
+{
+public:
+  test_price_sub() : num_( 0 ), price_( 0L ), is_thrd_( true ) {}
+
+  void on_response( price *ptr, uint64_t ) override
+  {
+    ++num_;
+    price_ = ptr->get_price();
+    is_thrd_ = is_thrd_ && std::this_thread::get_id() == thrd_;
+  }
+
+  unsigned        num_;
+  int64_t         price_;
+  bool            is_thrd_; // every notification on thrd_
+  std::thread::id thrd_;
+};
+
+// copies of the price views of each manager_sub::on_prices callback
+class test_view_sub : public manager_sub
+{
+public:
+  struct view {
+    uint64_t     slot_;
+    pub_key      acc_;
+    const price *px_;
+    int64_t      price_;
+    uint32_t     ver_;
+  };
+
+  void on_prices( manager *, const price_view *vw, unsigned num,
+                  uint64_t slot ) override
+  {
+    ++num_;
+    for( unsigned i = 0; i != num; ++i ) {
+      vec_.push_back( view{ slot, *vw[i].px_->get_account(), vw[i].px_,
+                            vw[i].get_price(), vw[i].ver_ } );
+    }
+  }
+
+  unsigned          num_ = 0;
+  std::vector<view> vec_;
+};
+
+void test_shard()
+{
+  // products are partitioned by get_shard and only the front end is
+  // subscribed to the program. notifications reach the owning shard
+  // and its users are notified on the front end's thread
+  test_rig rig;
+  test_view_sub vsub;
+  rig.mgr_.set_num_shard( 3 );
+  rig.mgr_.set_manager_sub( &vsub );
+  rig.mgr_.set_do_price_view( true );
+  PC_TEST_CHECK( rig.init( 60 ) );
+  PC_TEST_CHECK( rig.mgr_.get_num_secondary() == 3 );
+  auto has_mapping = [&]() {
+    bool res = true;
+    for( unsigned i = 0; i != 3; ++i ) {
+      manager *mgr = rig.mgr_.get_secondary( i );
+      mgr->lock();
+      res = res && mgr->has_status( PC_PYTH_HAS_MAPPING );
+      mgr->unlock();
+    }
+    return res;
+  };
+  PC_TEST_CHECK( rig.wait( has_mapping ) );
+
+  // every product and price is routed to its shard only
+  unsigned num_prod = 0;
+  bool is_part = true;
+  price *px = nullptr;
+  for( unsigned i = 0; i != 3; ++i ) {
+    manager *mgr = rig.mgr_.get_secondary( i );
+    mgr->lock();
+    PC_TEST_CHECK( mgr->get_is_shard() );
+    num_prod += mgr->get_num_product();
+    for( unsigned j = 0; j != mgr->get_num_product(); ++j ) {
+      product *prod = mgr->get_product( j );
+      price *ptr = prod->get_price( 0 );
+      is_part = is_part &&
+        rig.mgr_.get_shard( *prod->get_account() ) == i &&
+        rig.mgr_.get_route( *prod->get_account() ) == i &&
+        rig.mgr_.get_route( *ptr->get_account() ) == i;
+      px = i == 1 && !px ? ptr : px;
+    }
+    mgr->unlock();
+  }
+  PC_TEST_CHECK( num_prod == 60 );
+  PC_TEST_CHECK( is_part );
+  PC_TEST_CHECK( rig.mgr_.get_num_product() == 0 );
+  PC_TEST_CHECK( rig.mgr_.get_route( *rig.rpc_.get_mapping() ) == 3 );
+  PC_TEST_CHECK( px != nullptr );
+  if ( !px ) {
+    return;
+  }
+
+  // subscribe to a price of the second shard and publish to it
+  test_price_sub sub;
+  sub.thrd_ = std::this_thread::get_id();
+  request_sub_set sset( &sub );
+  manager *shard = rig.mgr_.get_secondary( 1 );
+  shard->lock();
+  sset.add( px );
+  shard->unlock();
+  cmd_upd_price_t cmd = {};
+  cmd.cmd_ = e_cmd_upd_price;
+  cmd.status_ = PC_STATUS_TRADING;
+  cmd.price_ = 4242L;
+  cmd.conf_ = 1UL;
+  cmd.pub_slot_ = rig.rpc_.get_slot();
+  rig.rpc_.on_upd_price( (const pc_pub_key_t*)rig.pub_.data(),
+                         (const pc_pub_key_t*)px->get_account()->data(),
+                         cmd );
+  rig.rpc_.set_slot( rig.rpc_.get_slot() + 1UL );
+  PC_TEST_CHECK( rig.wait( [&]() { return sub.price_ == 4242L; } ) );
+  PC_TEST_CHECK( sub.is_thrd_ );
+
+  // price views are not reported for the prices of shards
+  PC_TEST_CHECK( vsub.num_ == 0 );
+  shard->lock();
+  sset.teardown();
+  shard->unlock();
+
+  // a user's subscription to a shard's price is removed under the
+  // shard's lock when the user disconnects
+  auto has_sub = [&]() {
+    shard->lock();
+    bool res = px->get_has_sub();
+    shard->unlock();
+    return res;
+  };
+  test_user usr;
+  PC_TEST_CHECK( usr.init( rig ) );
+  PC_TEST_CHECK( rig.wait( [&]() { return !usr.get_is_wait(); } ) );
+  usr.send( "subscribe_price", 1UL, [&]( json_wtr& jw ) {
+    jw.add_key( "account", *px->get_account() ); } );
+  PC_TEST_CHECK( rig.wait( [&]() { return !usr.msgs_.empty(); } ) );
+  PC_TEST_CHECK( usr.msgs_[0].find( "\"subscription\"" ) !=
+                 std::string::npos );
+  PC_TEST_CHECK( has_sub() );
+  usr.close();
+  PC_TEST_CHECK( rig.wait( [&]() { return !has_sub(); } ) );
+}
+
+// predicted aggregates of a price
+class test_predict_sub : public request_sub,
+                         public request_sub_i<price_predict>
+{
+public:
+  test_predict_sub() : num_( 0 ), price_( 0L ), slot_( 0UL ) {}
+
+  void on_response( price_predict *ptr, uint64_t ) override
+  {
+    ++num_;
+    price_ = ptr->get_price_value();
+    slot_ = ptr->get_pub_slot();
+  }
+
+  unsigned num_;
+  int64_t  price_;
+  uint64_t slot_;
+};
+
+void test_predict()
+{
+  // prediction needs the components of full price account updates
+  {
+    test_rig rig;
+    rig.mgr_.set_do_predict( true );
+    rig.mgr_.set_do_agg_only( true );
+    PC_TEST_CHECK( !rig.init( 1 ) );
+    PC_TEST_CHECK( rig.mgr_.get_is_err() );
+  }
+
+  // an update of our component predicts the next aggregate once
+  test_rig rig;
+  rig.mgr_.set_do_predict( true );
+  PC_TEST_CHECK( rig.init( 4 ) );
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return rig.mgr_.has_status( PC_PYTH_HAS_MAPPING ); } ) );
+  price *px = rig.mgr_.get_product( 0 )->get_price( 0 );
+  test_predict_sub sub;
+  request_sub_set sset( &sub );
+  sset.add( px );
+  uint64_t slot = rig.mgr_.get_slot();
+  px->update_no_send( 4242L, 1UL, symbol_status::e_trading, false );
+  PC_TEST_CHECK( sub.num_ == 1 );
+  PC_TEST_CHECK( sub.price_ == 4242L && sub.slot_ == slot + 1UL );
+
+  // the update landing leaves the prediction unchanged
+  cmd_upd_price_t cmd = {};
+  cmd.cmd_ = e_cmd_upd_price;
+  cmd.status_ = PC_STATUS_TRADING;
+  cmd.price_ = 4242L;
+  cmd.conf_ = 1UL;
+  cmd.pub_slot_ = slot;
+  rig.rpc_.on_upd_price( (const pc_pub_key_t*)rig.pub_.data(),
+                         (const pc_pub_key_t*)px->get_account()->data(),
+                         cmd );
+  rig.rpc_.set_slot( rig.rpc_.get_slot() + 1UL );
+  PC_TEST_CHECK( rig.wait( [&]() { return px->get_price() == 4242L; } ) );
+  PC_TEST_CHECK( sub.num_ == 1 );
+  sset.teardown();
+}
+
+// symbols of the prices updated by each transaction the mock applies
+// after queueing updates of syms in one go. waits for num transactions
+static std::vector<std::vector<unsigned>> send_batch(
+    test_rig& rig, const std::vector<unsigned>& syms, size_t num )
+{
+  std::vector<std::vector<unsigned>> res;
+  size_t beg = rig.rpc_.get_tx_log().size();
+  for( unsigned i: syms ) {
+    price *px = rig.mgr_.get_product( i )->get_price( 0 );
+    px->update_no_send( 1000L + i, 1UL, symbol_status::e_trading, false );
+    rig.mgr_.add_dirty_price( px );
+  }
+  if ( !rig.wait( [&]() {
+         return rig.rpc_.get_tx_log().size() >= beg + num; } ) ) {
+    return res;
+  }
+  const auto& tlog = rig.rpc_.get_tx_log();
+  for( size_t i = beg; i != tlog.size(); ++i ) {
+    res.emplace_back();
+    for( const pub_key& acc: tlog[i] ) {
+      unsigned sym = 0;
+      for( ; sym != rig.mgr_.get_num_product() &&
+             *rig.mgr_.get_product( sym )->get_price( 0 )->get_account() !=
+             acc; ++sym );
+      res.back().push_back( sym );
+    }
+  }
+  return res;
+}
+
+// consecutive symbols from beg
+static std::vector<unsigned> get_syms( unsigned beg, unsigned num )
+{
+  std::vector<unsigned> res;
+  for( unsigned i = 0; i != num; ++i ) {
+    res.push_back( beg + i );
+  }
+  return res;
+}
+
+void test_batch()
+{
+  // prices that land in each transaction under every batch strategy
+  typedef std::vector<std::vector<unsigned>> tx_vec_t;
+  auto init = [&]( test_rig& rig, batch_strategy bstrat ) {
+    rig.mgr_.set_batch_strategy( bstrat );
+    rig.mgr_.set_batch_contend_publishers( 2U );
+    rig.mgr_.set_batch_contend_size( 2U );
+    rig.mgr_.set_max_batch_size( 3U );
+    rig.rpc_.set_log_tx( true );
+    return rig.init( 64 ) && rig.wait( [&]() {
+      bool res = rig.mgr_.has_status( PC_PYTH_HAS_MAPPING );
+      for( unsigned i = 0; res && i != rig.mgr_.get_num_product(); ++i ) {
+        res = rig.mgr_.get_product( i )->get_price( 0 )->
+          get_is_ready_publish();
+      }
+      return res; } );
+  };
+  auto next_slot = [&]( test_rig& rig ) {
+    uint64_t slot = rig.rpc_.get_slot() + 1UL;
+    rig.rpc_.set_slot( slot );
+    return rig.wait( [&]() { return rig.mgr_.get_slot() >= slot; } );
+  };
+
+  // fifo sends one batch of the max batch size per poll in arrival order
+  {
+    test_rig rig;
+    PC_TEST_CHECK( init( rig, e_batch_fifo ) );
+    tx_vec_t exp = { { 6, 5, 4 }, { 3, 2, 1 }, { 0 } };
+    PC_TEST_CHECK( send_batch( rig, { 6, 5, 4, 3, 2, 1, 0 }, 3 ) == exp );
+  }
+
+  // fill ignores the max batch size and fills transactions
+  unsigned max_num = 0;
+  {
+    test_rig rig;
+    PC_TEST_CHECK( init( rig, e_batch_fill ) );
+    max_num = rpc::upd_price::get_max_num(
+        rig.mgr_.get_requested_upd_price_cu_units(),
+        rig.mgr_.get_requested_upd_price_cu_price() );
+    PC_TEST_CHECK( max_num > 3U && max_num + 2U < 64U );
+    tx_vec_t exp = { get_syms( 0, max_num ), get_syms( max_num, 2 ) };
+    PC_TEST_CHECK( send_batch( rig, get_syms( 0, max_num + 2 ), 2 ) == exp );
+  }
+
+  // stale sends prices that have not landed before those that have
+  {
+    test_rig rig;
+    PC_TEST_CHECK( init( rig, e_batch_stale ) );
+    tx_vec_t exp1 = { { 0, 1, 2 } };
+    PC_TEST_CHECK( send_batch( rig, { 0, 1, 2 }, 1 ) == exp1 );
+    PC_TEST_CHECK( next_slot( rig ) );
+    PC_TEST_CHECK( rig.wait( [&]() {
+      bool res = true;
+      for( unsigned i = 0; i != 3; ++i ) {
+        res = res &&
+          rig.mgr_.get_product( i )->get_price( 0 )->get_landed_slot();
+      }
+      return res; } ) );
+    std::vector<unsigned> first = get_syms( 3, max_num - 1 );
+    first.push_back( 0 );
+    tx_vec_t exp2 = { first, { 1, 2 } };
+    PC_TEST_CHECK( send_batch( rig, get_syms( 0, max_num + 2 ), 2 ) == exp2 );
+  }
+
+  // contend sends prices with enough publishers first in small batches
+  {
+    test_rig rig;
+    PC_TEST_CHECK( init( rig, e_batch_contend ) );
+    uint8_t buf[pub_key::len];
+    __builtin_memset( buf, 0xff, sizeof( buf ) );
+    pub_key other;
+    other.init_from_buf( buf );
+    for( unsigned i: { 4U, 5U, 6U } ) {
+      rig.rpc_.add_component(
+          *rig.mgr_.get_product( i )->get_price( 0 )->get_account(), other );
+    }
+    PC_TEST_CHECK( next_slot( rig ) );
+    PC_TEST_CHECK( rig.wait( [&]() {
+      return rig.mgr_.get_product( 6 )->get_price( 0 )->
+        get_num_publisher() == 2U; } ) );
+    std::vector<unsigned> rest = get_syms( 0, 4 ),
+                          tail = get_syms( 7, max_num - 4 );
+    rest.insert( rest.end(), tail.begin(), tail.end() );
+    tx_vec_t exp = { { 4, 5 }, { 6 }, rest };
+    PC_TEST_CHECK( send_batch( rig, get_syms( 0, max_num + 3 ), 3 ) == exp );
+  }
+}
+
+// accounts of the notify_prices messages of subscription sid
+static std::set<std::string> get_bulk_accounts(
+    const std::vector<std::string>& msgs, uint64_t sid )
+{
+  std::set<std::string> res;
+  for( const std::string& msg: msgs ) {
+    jtree jt;
+    jt.parse( msg.c_str(), msg.size() );
+    uint32_t ptok = jt.find_val( 1, "params" );
+    if ( jt.get_str( jt.find_val( 1, "method" ) ) != str( "notify_prices" ) ||
+         jt.get_uint( jt.find_val( ptok, "subscription" ) ) != sid ) {
+      continue;
+    }
+    uint32_t rtok = jt.find_val( ptok, "result" );
+    for( uint32_t tok = jt.get_first( rtok ); tok; tok = jt.get_next( tok ) ) {
+      res.insert( jt.get_str( jt.find_val( tok, "account" ) ).as_string() );
+    }
+  }
+  return res;
+}
+
+// subscription id of the reply to request id
+static bool get_bulk_sid(
+    const std::vector<std::string>& msgs, uint64_t id, uint64_t& sid )
+{
+  for( const std::string& msg: msgs ) {
+    jtree jt;
+    jt.parse( msg.c_str(), msg.size() );
+    uint32_t rtok = jt.find_val( 1, "result" );
+    if ( rtok && jt.get_uint( jt.find_val( 1, "id" ) ) == id ) {
+      sid = jt.get_uint( jt.find_val( rtok, "subscription" ) );
+      return true;
+    }
+  }
+  return false;
+}
+
+void test_bulk_sub()
+{
+  // bulk subscriptions by account list, attribute and to all prices are
+  // sent the current prices and then those changed in each slot that
+  // they match. they are removed with their user
+  test_rig rig;
+  PC_TEST_CHECK( rig.init( 40 ) );
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return rig.mgr_.has_status( PC_PYTH_HAS_MAPPING ); } ) );
+  std::vector<price*> pxs;
+  std::set<std::string> all, half;
+  for( unsigned i = 0; i != rig.mgr_.get_num_product(); ++i ) {
+    price *px = rig.mgr_.get_product( i )->get_price( 0 );
+    std::string txt = px->get_account_text().as_string();
+    pxs.push_back( px );
+    all.insert( txt );
+    if ( i % 2 == 0 ) {
+      half.insert( txt );
+    }
+  }
+  PC_TEST_CHECK( pxs.size() == 40 );
+
+  test_user usr1, usr2;
+  PC_TEST_CHECK( usr1.init( rig ) );
+  PC_TEST_CHECK( usr2.init( rig ) );
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return !usr1.get_is_wait() && !usr2.get_is_wait(); } ) );
+  usr1.send( "subscribe_prices", 1UL, [&]( json_wtr& jw ) {
+    jw.add_key( "accounts", json_wtr::e_arr );
+    for( const std::string& txt: half ) {
+      jw.add_val( str( txt ) );
+    }
+    jw.pop(); } );
+  usr1.send( "subscribe_prices", 2UL, [&]( json_wtr& jw ) {
+    jw.add_key( "asset_type", "Crypto" ); } );
+  usr2.send( "subscribe_all_prices", 1UL, []( json_wtr& ) {} );
+  uint64_t sid1 = 0, sid2 = 0, sid3 = 0;
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return get_bulk_sid( usr1.msgs_, 1UL, sid1 ) &&
+           get_bulk_sid( usr1.msgs_, 2UL, sid2 ) &&
+           get_bulk_sid( usr2.msgs_, 1UL, sid3 ) &&
+           get_bulk_accounts( usr1.msgs_, sid1 ) == half &&
+           get_bulk_accounts( usr1.msgs_, sid2 ) == all &&
+           get_bulk_accounts( usr2.msgs_, sid3 ) == all; } ) );
+  PC_TEST_CHECK( sid1 != sid2 );
+  PC_TEST_CHECK( rig.mgr_.get_num_bulk_user() == 2 );
+
+  // publish to the first ten prices in a slot
+  auto publish = [&]( int64_t val ) {
+    cmd_upd_price_t cmd = {};
+    cmd.cmd_ = e_cmd_upd_price;
+    cmd.status_ = PC_STATUS_TRADING;
+    cmd.price_ = val;
+    cmd.conf_ = 1UL;
+    cmd.pub_slot_ = rig.rpc_.get_slot();
+    for( unsigned i = 0; i != 10; ++i ) {
+      rig.rpc_.on_upd_price( (const pc_pub_key_t*)rig.pub_.data(),
+                            (const pc_pub_key_t*)pxs[i]->get_account()->data(),
+                            cmd );
+    }
+    rig.rpc_.set_slot( rig.rpc_.get_slot() + 1UL );
+  };
+  std::set<std::string> upd, upd_half;
+  for( unsigned i = 0; i != 10; ++i ) {
+    std::string txt = pxs[i]->get_account_text().as_string();
+    upd.insert( txt );
+    if ( half.count( txt ) ) {
+      upd_half.insert( txt );
+    }
+  }
+  usr1.msgs_.clear();
+  usr2.msgs_.clear();
+  publish( 100L );
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return get_bulk_accounts( usr1.msgs_, sid1 ) == upd_half &&
+           get_bulk_accounts( usr1.msgs_, sid2 ) == upd &&
+           get_bulk_accounts( usr2.msgs_, sid3 ) == upd; } ) );
+
+  // the remaining user is still notified once the other has gone
+  usr1.close();
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return rig.mgr_.get_num_bulk_user() == 1; } ) );
+  usr2.msgs_.clear();
+  publish( 200L );
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return get_bulk_accounts( usr2.msgs_, sid3 ) == upd; } ) );
+  usr2.close();
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return rig.mgr_.get_num_bulk_user() == 0; } ) );
+}
+
+// binary update message of records of prices at idx. keyed records also
+// carry the account of each index
+static std::string get_bin_msg( uint64_t seq, bool is_key,
+    const std::vector<uint32_t>& idx, const std::vector<pub_key>& accs,
+    int64_t px, uint32_t status = (uint32_t)symbol_status::e_trading )
+{
+  bin_hdr hdr = { bin_version, is_key ? bin_flag_key : (uint16_t)0,
+                  (uint32_t)idx.size(), seq };
+  std::string res( (const char*)&hdr, sizeof( hdr ) );
+  for( size_t i = 0; i != idx.size(); ++i ) {
+    bin_key_upd rec;
+    rec.upd_ = bin_upd{ idx[i], status, px + idx[i], 1UL };
+    __builtin_memcpy( &rec.key_, accs[i].data(), sizeof( rec.key_ ) );
+    res.append( (const char*)&rec,
+                is_key ? sizeof( bin_key_upd ) : sizeof( bin_upd ) );
+  }
+  return res;
+}
+
+// acknowledgements and parse errors received
+static void get_bin_replies( test_user& usr,
+    std::vector<bin_ack>& acks, unsigned& num_err )
+{
+  for( const std::string& msg: usr.msgs_ ) {
+    if ( msg.size() == sizeof( bin_ack ) && msg[0] != '{' ) {
+      acks.emplace_back();
+      __builtin_memcpy( &acks.back(), msg.data(), sizeof( bin_ack ) );
+    } else if ( msg.find( "-32700" ) != std::string::npos ) {
+      ++num_err;
+    }
+  }
+  usr.msgs_.clear();
+}
+
+void test_binary()
+{
+  // binary updates bind indices to accounts, are published like
+  // update_price and acknowledged with their counts. malformed messages
+  // get a parse error and leave the connection usable
+  test_rig rig;
+  PC_TEST_CHECK( rig.init( 8 ) );
+  PC_TEST_CHECK( rig.wait( [&]() {
+    bool res = rig.mgr_.has_status( PC_PYTH_HAS_MAPPING );
+    for( unsigned i = 0; res && i != rig.mgr_.get_num_product(); ++i ) {
+      res = rig.mgr_.get_product( i )->get_price( 0 )->
+        get_is_ready_publish();
+    }
+    return res; } ) );
+  std::vector<price*> pxs;
+  std::vector<pub_key> accs;
+  for( unsigned i = 0; i != 3; ++i ) {
+    pxs.push_back( rig.mgr_.get_product( i )->get_price( 0 ) );
+    accs.push_back( *pxs.back()->get_account() );
+  }
+  test_user usr;
+  PC_TEST_CHECK( usr.init( rig ) );
+  PC_TEST_CHECK( rig.wait( [&]() { return !usr.get_is_wait(); } ) );
+  usr.send( "enable_binary", 1UL, []( json_wtr& jw ) {
+    jw.add_key( "ack", json_wtr::jtrue() ); } );
+  PC_TEST_CHECK( rig.wait( [&]() { return !usr.msgs_.empty(); } ) );
+  PC_TEST_CHECK( usr.msgs_[0].find( "\"version\":1" ) != std::string::npos );
+  usr.msgs_.clear();
+
+  // wait for the updates to be applied and aggregated in the next slot
+  // and for the manager to see that slot as it attempts one update per
+  // price and slot. slots also advance while updates wait to be sent
+  uint64_t num_upd = 0UL;
+  auto has_price = [&]( int64_t px ) {
+    bool is_slot = false;
+    int64_t ts = get_now();
+    num_upd += pxs.size();
+    return rig.wait( [&]() {
+      if ( ( !is_slot && rig.rpc_.get_num_upd() == num_upd ) ||
+           get_now() - ts > PC_NSECS_IN_SEC/10L ) {
+        rig.rpc_.set_slot( rig.rpc_.get_slot() + 1UL );
+        is_slot = rig.rpc_.get_num_upd() == num_upd;
+        ts = get_now();
+      }
+      bool res = is_slot && rig.mgr_.get_slot() == rig.rpc_.get_slot();
+      for( unsigned i = 0; res && i != pxs.size(); ++i ) {
+        res = pxs[i]->get_price() == px + i;
+      }
+      return res; } );
+  };
+  auto wait_ack = [&]( std::vector<bin_ack>& acks, unsigned& num_err,
+                       size_t num ) {
+    return rig.wait( [&]() {
+      get_bin_replies( usr, acks, num_err );
+      return acks.size() + num_err >= num; } );
+  };
+
+  // keyed records bind the indices. an unknown account and an invalid
+  // status are rejected
+  pub_key unk;
+  uint8_t ubuf[pub_key::len];
+  __builtin_memset( ubuf, 0xff, sizeof( ubuf ) );
+  unk.init_from_buf( ubuf );
+  std::string msg = get_bin_msg( 7UL, true, { 0, 1, 2 }, accs, 500L );
+  msg += get_bin_msg( 0UL, true, { 3 }, { unk }, 0L ).substr(
+      sizeof( bin_hdr ) );
+  msg += get_bin_msg( 0UL, true, { 4 }, { accs[0] }, 0L, 99U ).substr(
+      sizeof( bin_hdr ) );
+  ( (bin_hdr*)&msg[0] )->num_ = 5U;
+  usr.send_binary( msg );
+  std::vector<bin_ack> acks;
+  unsigned num_err = 0;
+  PC_TEST_CHECK( wait_ack( acks, num_err, 1 ) );
+  PC_TEST_CHECK( num_err == 0 && acks.size() == 1 );
+  PC_TEST_CHECK( acks[0].seq_ == 7UL );
+  PC_TEST_CHECK( acks[0].num_ == 3U && acks[0].err_ == 2U );
+  PC_TEST_CHECK( has_price( 500L ) );
+
+  // records by index alone update the bound accounts
+  acks.clear();
+  usr.send_binary( get_bin_msg( 8UL, false, { 0, 1, 2 }, accs, 600L ) );
+  PC_TEST_CHECK( wait_ack( acks, num_err, 1 ) );
+  PC_TEST_CHECK( num_err == 0 && acks.size() == 1 );
+  PC_TEST_CHECK( acks[0].seq_ == 8UL );
+  PC_TEST_CHECK( acks[0].num_ == 3U && acks[0].err_ == 0U );
+  PC_TEST_CHECK( has_price( 600L ) );
+
+  // truncated, unversioned and headerless messages are not applied
+  acks.clear();
+  msg = get_bin_msg( 9UL, false, { 0, 1 }, accs, 700L );
+  usr.send_binary( msg.substr( 0, msg.size() - 1 ) );
+  msg = get_bin_msg( 10UL, false, { 0 }, accs, 700L );
+  ( (bin_hdr*)&msg[0] )->ver_ = bin_version + 1U;
+  usr.send_binary( msg );
+  usr.send_binary( msg.substr( 0, sizeof( bin_hdr ) - 1 ) );
+  usr.send_binary( get_bin_msg( 11UL, false, { 0, 1, 2 }, accs, 800L ) );
+  PC_TEST_CHECK( wait_ack( acks, num_err, 4 ) );
+  PC_TEST_CHECK( num_err == 3 && acks.size() == 1 );
+  PC_TEST_CHECK( acks[0].seq_ == 11UL && acks[0].num_ == 3U );
+  PC_TEST_CHECK( has_price( 800L ) );
+  usr.close();
+}
+
+void test_reconnect()
+{
+  // after the rpc node drops every connection the manager reconnects,
+  // fetches every account again and its subscribers keep being notified
+  test_rig rig;
+  PC_TEST_CHECK( rig.init( 20 ) );
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return rig.mgr_.has_status( PC_PYTH_HAS_MAPPING ); } ) );
+  std::vector<pub_key> accs( 1, *rig.rpc_.get_mapping() );
+  for( unsigned i = 0; i != rig.mgr_.get_num_product(); ++i ) {
+    product *prod = rig.mgr_.get_product( i );
+    accs.push_back( *prod->get_account() );
+    accs.push_back( *prod->get_price( 0 )->get_account() );
+  }
+  PC_TEST_CHECK( accs.size() == 41 );
+  price *px1 = rig.mgr_.get_product( 0 )->get_price( 0 );
+  price *px2 = rig.mgr_.get_product( 1 )->get_price( 0 );
+
+  // a request subscriber and a user subscribed to a price each
+  test_price_sub sub;
+  sub.thrd_ = std::this_thread::get_id();
+  request_sub_set sset( &sub );
+  sset.add( px1 );
+  test_user usr;
+  PC_TEST_CHECK( usr.init( rig ) );
+  PC_TEST_CHECK( rig.wait( [&]() { return !usr.get_is_wait(); } ) );
+  usr.send( "subscribe_price", 1UL, [&]( json_wtr& jw ) {
+    jw.add_key( "account", *px2->get_account() ); } );
+  PC_TEST_CHECK( rig.wait( [&]() { return !usr.msgs_.empty(); } ) );
+
+  // drop the connections and wait until every account has been
+  // returned again
+  std::vector<unsigned> num_fetch;
+  for( const pub_key& acc: accs ) {
+    num_fetch.push_back( rig.rpc_.get_num_fetch( acc ) );
+  }
+  rig.rpc_.disconnect();
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return !rig.mgr_.has_status( PC_PYTH_RPC_CONNECTED ); } ) );
+  PC_TEST_CHECK( rig.mgr_.has_status( PC_PYTH_HAS_MAPPING ) );
+  PC_TEST_CHECK( rig.wait( [&]() {
+    bool res = rig.mgr_.has_status( PC_PYTH_RPC_CONNECTED );
+    for( size_t i = 0; res && i != accs.size(); ++i ) {
+      res = rig.rpc_.get_num_fetch( accs[i] ) > num_fetch[i];
+    }
+    return res; } ) );
+  PC_TEST_CHECK( rig.mgr_.get_num_product() == 20 );
+  PC_TEST_CHECK( px1->get_has_sub() );
+  PC_TEST_CHECK( px2->get_has_sub() );
+
+  // updates published after the reconnect reach both subscribers
+  usr.msgs_.clear();
+  cmd_upd_price_t cmd = {};
+  cmd.cmd_ = e_cmd_upd_price;
+  cmd.status_ = PC_STATUS_TRADING;
+  cmd.price_ = 4242L;
+  cmd.conf_ = 1UL;
+  cmd.pub_slot_ = rig.rpc_.get_slot();
+  for( price *px: { px1, px2 } ) {
+    rig.rpc_.on_upd_price( (const pc_pub_key_t*)rig.pub_.data(),
+                           (const pc_pub_key_t*)px->get_account()->data(),
+                           cmd );
+  }
+  rig.rpc_.set_slot( rig.rpc_.get_slot() + 1UL );
+  auto has_notify = [&]() {
+    for( const std::string& msg: usr.msgs_ ) {
+      if ( msg.find( "notify_price" ) != std::string::npos ) {
+        return true;
+      }
+    }
+    return false;
+  };
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return sub.price_ == 4242L && has_notify(); } ) );
+  sset.teardown();
+  usr.close();
+}
+
+void test_price_view()
+{
+  // prices whose aggregate changed in a slot are reported to the
+  // manager_sub in one callback with views of their accounts
+  test_rig rig;
+  test_view_sub vsub;
+  rig.mgr_.set_manager_sub( &vsub );
+  rig.mgr_.set_do_price_view( true );
+  PC_TEST_CHECK( rig.init( 10 ) );
+  PC_TEST_CHECK( rig.wait( [&]() {
+    return rig.mgr_.has_status( PC_PYTH_HAS_MAPPING ); } ) );
+
+  // prices fetched on bootstrap are reported once their slot ends
+  rig.rpc_.set_slot( rig.rpc_.get_slot() + 1UL );
+  PC_TEST_CHECK( rig.wait( [&]() { return vsub.num_ != 0; } ) );
+  PC_TEST_CHECK( vsub.num_ == 1 && vsub.vec_.size() == 10 );
+
+  // then only those updated in a slot
+  cmd_upd_price_t cmd = {};
+  cmd.cmd_ = e_cmd_upd_price;
+  cmd.status_ = PC_STATUS_TRADING;
+  cmd.conf_ = 1UL;
+  cmd.pub_slot_ = rig.rpc_.get_slot();
+  std::vector<price*> pxs;
+  for( unsigned i = 2; i != 5; ++i ) {
+    price *px = rig.mgr_.get_product( i )->get_price( 0 );
+    cmd.price_ = 300L + i;
+    rig.rpc_.on_upd_price( (const pc_pub_key_t*)rig.pub_.data(),
+                           (const pc_pub_key_t*)px->get_account()->data(),
+                           cmd );
+    pxs.push_back( px );
+  }
+  vsub.num_ = 0;
+  vsub.vec_.clear();
+  rig.rpc_.set_slot( rig.rpc_.get_slot() + 1UL );
+  PC_TEST_CHECK( rig.wait( [&]() { return vsub.vec_.size() >= 3; } ) );
+  PC_TEST_CHECK( vsub.num_ == 1 && vsub.vec_.size() == 3 );
+  bool is_ok = true;
+  for( const test_view_sub::view& vw: vsub.vec_ ) {
+    auto it = std::find( pxs.begin(), pxs.end(), vw.px_ );
+    is_ok = is_ok && it != pxs.end() &&
+      vw.ver_ == price_view::version &&
+      vw.acc_ == *(*it)->get_account() &&
+      vw.price_ == (*it)->get_price() &&
+      vw.price_ == 302L + ( it - pxs.begin() ) &&
+      vw.slot_ == vsub.vec_[0].slot_;
+  }
+  PC_TEST_CHECK( is_ok );
+}
+
+int main(int,char**)
+{
+  log::set_level( PC_LOG_ERR_LVL );
+  PC_TEST_START
+  test_fetch_error();
+  test_shard();
+  test_predict();
+  test_batch();
+  test_reconnect();
+  test_bulk_sub();
+  test_binary();
+  test_price_view();
+  PC_TEST_END
+  return 0;
+}
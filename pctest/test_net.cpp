@@ -2,7 +2,12 @@
 #include <pc/net_socket.hpp>
 #include <pc/net_socket.hpp>
 #include <pc/misc.hpp>
+#include <pc/handoff.hpp>
 #include <iostream>
+#include <thread>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
 
 using namespace pc;
 
@@ -56,6 +61,67 @@ void test_net_buf()
     PC_TEST_CHECK( 0 == __builtin_strcmp( "onetwothree", tl->buf_ ) );
     hd->dealloc();
   }
+  {
+    // large messages use larger size classes
+    std::vector<char> buf( 100000, 'x' );
+    net_wtr msg;
+    msg.add( str( buf.data(), buf.size() ) );
+    PC_TEST_CHECK( msg.size() == buf.size() );
+    net_buf *hd, *tl;
+    msg.detach( hd, tl );
+    PC_TEST_CHECK( hd->cls_ == 0 && hd->size_ == net_buf::len );
+    PC_TEST_CHECK( hd->next_->cls_ == net_buf::num_cls-1 );
+    PC_TEST_CHECK( hd->next_->size_ == hd->next_->get_cap() );
+    size_t tot = 0;
+    for( net_buf *ptr = hd; ptr; ) {
+      net_buf *nxt = ptr->next_;
+      tot += ptr->size_;
+      ptr->dealloc();
+      ptr = nxt;
+    }
+    PC_TEST_CHECK( tot == buf.size() );
+    uint64_t num_hit = net_buf::get_num_hit( net_buf::num_cls-1 );
+    net_buf *ptr = net_buf::alloc( 50000 );
+    PC_TEST_CHECK( ptr->get_cap() >= 50000 );
+    PC_TEST_CHECK( net_buf::get_num_hit( net_buf::num_cls-1 ) == 1+num_hit );
+    ptr->dealloc();
+  }
+  {
+    // copies leave the source intact
+    std::string txt( 3000, 'y' );
+    net_wtr src, cpy;
+    src.add( str( txt ) );
+    cpy.add( 'x' );
+    cpy.add_copy( src );
+    PC_TEST_CHECK( src.size() == txt.size() );
+    PC_TEST_CHECK( cpy.size() == txt.size() + 1 );
+  }
+  {
+    // buffers released on another thread are capped in its cache and
+    // reused by the allocating thread through the shared pool
+    std::vector<net_buf*> bufs;
+    for( unsigned i = 0; i != 8192; ++i ) {
+      bufs.push_back( net_buf::alloc() );
+    }
+    unsigned num_free = ~0U;
+    std::thread thr( [&]() {
+      for( net_buf *ptr: bufs ) {
+        ptr->dealloc();
+      }
+      num_free = net_buf::get_num_free( 0 );
+    } );
+    thr.join();
+    PC_TEST_CHECK( num_free <= net_buf::get_max_free( 0 ) );
+    uint64_t num_miss = net_buf::get_num_miss( 0 );
+    for( unsigned i = 0; i != 4096; ++i ) {
+      bufs[i] = net_buf::alloc();
+    }
+    PC_TEST_CHECK( net_buf::get_num_miss( 0 ) == num_miss );
+    for( unsigned i = 0; i != 4096; ++i ) {
+      bufs[i]->dealloc();
+    }
+    PC_TEST_CHECK( net_buf::get_num_free( 0 ) <= net_buf::get_max_free( 0 ) );
+  }
 }
 
 void test_json_wtr()
@@ -112,6 +178,31 @@ void test_json_wtr()
     PC_TEST_CHECK( 0==__builtin_strncmp( kptxt, hd->buf_, hd->size_ ));
     hd->dealloc();
   }
+  {
+    // pre-rendered keys and integer edge cases
+    static const json_key kmin( "min" ), kmax( "max" );
+    json_wtr wtr;
+    wtr.add_val( json_wtr::e_obj );
+    wtr.add_key( kmin, INT64_MIN );
+    wtr.add_key( kmax, UINT64_MAX );
+    wtr.add_key( "zero", 0L );
+    wtr.add_key( "neg", -1000L );
+    wtr.add_key( "ten", 10UL );
+    wtr.add_key( kmin, json_wtr::e_arr );
+    wtr.add_val( 99UL );
+    wtr.add_val( 100UL );
+    wtr.pop();
+    wtr.pop();
+    const char *res = "{\"min\":-9223372036854775808,"
+      "\"max\":18446744073709551615,\"zero\":0,\"neg\":-1000,"
+      "\"ten\":10,\"min\":[99,100]}";
+    size_t rlen = __builtin_strlen( res );
+    net_buf *hd, *tl;
+    wtr.detach(hd,tl);
+    PC_TEST_CHECK( rlen == hd->size_ );
+    PC_TEST_CHECK( 0==__builtin_strncmp(res,hd->buf_,rlen ) );
+    hd->dealloc();
+  }
 }
 
 void test_enc()
@@ -124,12 +215,401 @@ void test_enc()
   PC_TEST_CHECK( -954 == str_to_dec( "-0.000954000", -6 ) );
 }
 
+// websocket message capture
+class test_ws : public ws_parser
+{
+public:
+  void parse_msg( const char *buf, size_t sz ) override {
+    msg_.assign( buf, sz );
+  }
+  std::string msg_;
+};
+
+void test_ws_mask()
+{
+  // masked frames of various lengths survive round-trip
+  for( size_t sz : { 0UL, 1UL, 5UL, 17UL, 125UL, 126UL, 3000UL, 70000UL } ) {
+    std::string txt;
+    for( size_t i=0; i != sz; ++i ) {
+      txt += (char)( 'a' + i%26 );
+    }
+    net_wtr pay;
+    pay.add( str( txt.c_str(), txt.size() ) );
+    ws_wtr msg;
+    msg.commit( ws_wtr::text_id, pay, true );
+    net_buf *hd, *tl;
+    msg.detach( hd, tl );
+    std::string frame;
+    for( net_buf *ptr = hd; ptr; ) {
+      net_buf *nxt = ptr->next_;
+      frame.append( ptr->buf_, ptr->size_ );
+      ptr->dealloc();
+      ptr = nxt;
+    }
+    PC_TEST_CHECK( sz < 8 || frame.find( txt.substr( 0, 8 ) ) == std::string::npos );
+    test_ws wp;
+    size_t len = 0;
+    PC_TEST_CHECK( wp.parse( &frame[0], frame.size(), len ) );
+    PC_TEST_CHECK( len == frame.size() );
+    PC_TEST_CHECK( wp.msg_ == txt );
+  }
+}
+
+void test_ws_deflate()
+{
+  // compressed messages share context across a connection
+  ws_deflate zs;
+  test_ws wp;
+  wp.set_is_deflate( true );
+  for( size_t sz : { 5UL, 200UL, 3000UL, 70000UL, 3000UL } ) {
+    std::string txt;
+    for( size_t i=0; txt.size() < sz; ++i ) {
+      txt += "{\"price\":" + std::to_string( i%97 ) + "},";
+    }
+    txt.resize( sz );
+    net_wtr pay;
+    pay.add( str( txt.c_str(), txt.size() ) );
+    ws_wtr msg;
+    msg.commit( ws_wtr::text_id, pay, true, &zs );
+    net_buf *hd, *tl;
+    msg.detach( hd, tl );
+    std::string frame;
+    for( net_buf *ptr = hd; ptr; ) {
+      net_buf *nxt = ptr->next_;
+      frame.append( ptr->buf_, ptr->size_ );
+      ptr->dealloc();
+      ptr = nxt;
+    }
+    // rsv1 marks compressed frames
+    bool is_comp = (frame[0] & 0x40) != 0;
+    PC_TEST_CHECK( is_comp == ( sz >= 128 ) );
+    PC_TEST_CHECK( !is_comp || frame.size() < sz/2 );
+    size_t len = 0;
+    PC_TEST_CHECK( wp.parse( &frame[0], frame.size(), len ) );
+    PC_TEST_CHECK( len == frame.size() );
+    PC_TEST_CHECK( !wp.get_is_err() );
+    PC_TEST_CHECK( wp.msg_ == txt );
+  }
+
+  // a decompressed message survives compressing a reply with the same
+  // context
+  ws_deflate peer, conn;
+  std::string txt( 4000, 'a' ), rep( 4000, 'b' );
+  net_wtr pay, comp;
+  pay.add( str( txt.c_str(), txt.size() ) );
+  PC_TEST_CHECK( peer.compress( pay, comp ) );
+  std::string zmsg;
+  comp.copy_to( zmsg );
+  const char *res = nullptr;
+  size_t res_len = 0;
+  PC_TEST_CHECK( conn.decompress( zmsg.c_str(), zmsg.size(),
+                                  res, res_len ) );
+  net_wtr rpay, rcomp;
+  rpay.add( str( rep.c_str(), rep.size() ) );
+  PC_TEST_CHECK( conn.compress( rpay, rcomp ) );
+  PC_TEST_CHECK( txt == std::string( res, res_len ) );
+}
+
+// loopback round-trip through net_loop
+class test_echo : public net_parser, public net_accept
+{
+public:
+  bool parse( const char *buf, size_t sz, size_t& len ) override {
+    msg_.append( buf, sz );
+    len = sz;
+    return true;
+  }
+  void accept( int fd ) override {
+    conn_.set_fd( fd );
+    conn_.set_block( false );
+    conn_.set_net_parser( this );
+    conn_.set_net_loop( lp_ );
+    conn_.init();
+  }
+  net_loop   *lp_;
+  net_connect conn_;
+  std::string msg_;
+};
+
+void test_net_loop( bool use_ur )
+{
+  net_loop lp;
+  lp.set_use_uring( use_ur );
+  lp.set_latency( true );
+  PC_TEST_CHECK( lp.init() );
+  test_echo svr, clt;
+  svr.lp_ = &lp;
+  tcp_listen lsvr;
+  lsvr.set_port( 0 );
+  lsvr.set_net_accept( &svr );
+  lsvr.set_net_loop( &lp );
+  PC_TEST_CHECK( lsvr.init() );
+  tcp_connect conn;
+  conn.set_host( "127.0.0.1" );
+  conn.set_port( lsvr.get_port() );
+  conn.set_net_parser( &clt );
+  conn.set_net_loop( &lp );
+  PC_TEST_CHECK( conn.init() );
+  for( unsigned i=0; i != 1000 && conn.get_is_wait(); ++i ) {
+    conn.check();
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( !conn.get_is_err() );
+  net_wtr msg;
+  msg.add( "hello" );
+  conn.add_send( msg );
+  for( unsigned i=0; i != 1000 && svr.msg_.size() < 5; ++i ) {
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( svr.msg_ == "hello" );
+  PC_TEST_CHECK( lp.get_num_latency() > 0 );
+  PC_TEST_CHECK( lp.get_max_latency() >= lp.get_avg_latency() );
+  net_wtr rsp;
+  rsp.add( "world" );
+  svr.conn_.add_send( rsp );
+  for( unsigned i=0; i != 1000 && clt.msg_.size() < 5; ++i ) {
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( clt.msg_ == "world" );
+
+  // multi-buffer message with partial writes
+  std::string big;
+  for( unsigned i=0; i != 400000; ++i ) {
+    big += (char)( 'a' + i%26 );
+  }
+  net_wtr bmsg;
+  bmsg.add( str( big.c_str(), big.size() ) );
+  conn.add_send( bmsg );
+  svr.msg_.clear();
+  for( unsigned i=0; i != 10000 && svr.msg_.size() < big.size(); ++i ) {
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( svr.msg_ == big );
+  conn.close();
+  svr.conn_.close();
+  lsvr.close();
+}
+
+void test_tcp_connect()
+{
+  // numeric hosts resolve inline and names on the resolver thread
+  tcp_connect::addr_vec_t addr;
+  PC_TEST_CHECK( tcp_connect::resolve( "127.0.0.1", addr ) );
+  PC_TEST_CHECK( addr.size() == 1 && addr[0].ss_family == AF_INET );
+  net_loop lp;
+  PC_TEST_CHECK( lp.init() );
+  test_echo svr;
+  svr.lp_ = &lp;
+  tcp_listen lsvr;
+  lsvr.set_port( 0 );
+  lsvr.set_net_accept( &svr );
+  lsvr.set_net_loop( &lp );
+  PC_TEST_CHECK( lsvr.init() );
+  tcp_connect conn;
+  conn.set_host( "localhost" );
+  conn.set_port( lsvr.get_port() );
+  conn.set_net_loop( &lp );
+  PC_TEST_CHECK( conn.init() );
+  for( unsigned i=0; i != 5000 && conn.get_is_wait(); ++i ) {
+    conn.check();
+    lp.poll( 1 );
+  }
+  PC_TEST_CHECK( !conn.get_is_wait() && !conn.get_is_err() );
+  PC_TEST_CHECK( tcp_connect::resolve( "localhost", addr ) );
+  PC_TEST_CHECK( !addr.empty() );
+
+  // refused on every address fails without waiting for the timeout
+  int port = lsvr.get_port();
+  conn.close();
+  lsvr.close();
+  conn.set_port( port );
+  int64_t ts = get_now();
+  if ( conn.init() ) {
+    for( unsigned i=0; i != 5000 && conn.get_is_wait(); ++i ) {
+      conn.check();
+      lp.poll( 1 );
+    }
+  }
+  PC_TEST_CHECK( conn.get_is_err() );
+  PC_TEST_CHECK( get_now() - ts < PC_NSECS_IN_SEC );
+}
+
+void test_udp_batch()
+{
+  // bind loopback receiver on ephemeral port
+  int fd = ::socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+  PC_TEST_CHECK( fd >= 0 );
+  sockaddr_in saddr;
+  __builtin_memset( &saddr, 0, sizeof( saddr ) );
+  saddr.sin_family = AF_INET;
+  saddr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+  socklen_t slen = sizeof( saddr );
+  PC_TEST_CHECK( 0 == ::bind( fd, (sockaddr*)&saddr, slen ) );
+  PC_TEST_CHECK( 0 == ::getsockname( fd, (sockaddr*)&saddr, &slen ) );
+  std::string astr = "127.0.0.1:" + std::to_string( ntohs( saddr.sin_port ) );
+  ip_addr addr( str( astr.c_str(), astr.size() ) );
+
+  // fan out 100 datagrams in two sendmmsg calls
+  udp_socket usock;
+  PC_TEST_CHECK( usock.init() );
+  std::vector<std::string> txt;
+  for( unsigned i=0; i != 100; ++i ) {
+    txt.push_back( "tx" + std::to_string( i ) );
+  }
+  for( std::string& t : txt ) {
+    usock.add_send( &addr, t.c_str(), t.size() );
+  }
+  usock.flush();
+  PC_TEST_CHECK( usock.get_num_sent() == 100 );
+  PC_TEST_CHECK( usock.get_num_calls() == 2 );
+  char buf[64];
+  for( std::string& t : txt ) {
+    ssize_t rc = ::recv( fd, buf, sizeof( buf ), 0 );
+    PC_TEST_CHECK( rc > 0 && t == std::string( buf, (size_t)rc ) );
+  }
+  usock.close();
+  ::close( fd );
+}
+
+class test_http_stream : public http_client
+{
+public:
+  bool parse_stream( size_t len ) override {
+    return len >= 16;
+  }
+  size_t parse_part( const char *buf, size_t len, bool ) override {
+    // consume complete lines only
+    size_t num = 0;
+    for( size_t i=0; i != len; ++i ) {
+      if ( buf[i] == '\n' ) {
+        line_.emplace_back( &buf[num], i - num );
+        num = i + 1;
+      }
+    }
+    return num;
+  }
+  void parse_content( const char *buf, size_t len ) override {
+    cnt_.assign( buf, len );
+  }
+  std::vector<std::string> line_;
+  std::string cnt_;
+};
+
+void test_http_client_stream()
+{
+  std::string body;
+  for( unsigned i=0; i != 50; ++i ) {
+    body += "line" + std::to_string( i ) + "\n";
+  }
+  std::string msg = "HTTP/1.1 200 OK\r\nContent-Length: " +
+    std::to_string( body.size() ) + "\r\n\r\n" + body +
+    "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nsmall";
+
+  // deliver in odd-sized pieces as net_connect would
+  test_http_stream hp;
+  std::string rdr;
+  for( size_t off = 0; off < msg.size(); off += 7 ) {
+    rdr.append( msg, off, 7 );
+    for( size_t idx = 0; !rdr.empty(); ) {
+      size_t rlen = 0;
+      if ( !hp.parse( &rdr[idx], rdr.size() - idx, rlen ) ) {
+        rdr.erase( 0, idx );
+        break;
+      }
+      idx += rlen;
+      if ( idx == rdr.size() ) {
+        rdr.clear();
+      }
+    }
+  }
+  PC_TEST_CHECK( hp.line_.size() == 50 );
+  PC_TEST_CHECK( hp.line_.back() == "line49" );
+  PC_TEST_CHECK( hp.cnt_ == "small" );
+}
+
+void test_handoff()
+{
+  // connection state reads back as written
+  pub_key pkey;
+  pkey.init_from_text( str( "9SGRhKwPRSPKLqoQHBq8mWE6GAkkq2X7zpFcbBaihzeb" ) );
+  handoff_wtr wtr;
+  wtr.add( 42UL );
+  wtr.add( pkey );
+  wtr.add( str( "abc" ) );
+  handoff_rdr rdr( wtr.get() );
+  uint64_t val = 0;
+  pub_key pkey2;
+  std::string txt;
+  PC_TEST_CHECK( rdr.get( val ) && val == 42UL );
+  PC_TEST_CHECK( rdr.get( pkey2 ) && pkey2 == pkey );
+  PC_TEST_CHECK( rdr.get( txt ) && txt == "abc" && rdr.get_is_end() );
+  PC_TEST_CHECK( !rdr.get( val ) && !rdr.get_is_end() );
+
+  // nothing to take over without a running process
+  std::string file = "/tmp/test_handoff." + std::to_string( ::getpid() );
+  handoff succ;
+  succ.set_file( file );
+  PC_TEST_CHECK( succ.recv() && !succ.get_is_recv() );
+
+  // listening socket and a connection with state spanning several
+  // messages move across
+  handoff prev;
+  prev.set_file( file );
+  PC_TEST_CHECK( prev.init() );
+  tcp_listen lsvr;
+  lsvr.set_port( 0 );
+  PC_TEST_CHECK( lsvr.init() );
+  int sp[2];
+  PC_TEST_CHECK( 0 == ::socketpair( AF_UNIX, SOCK_STREAM, 0, sp ) );
+  handoff::conn_vec_t cvec( 1 );
+  cvec[0].fd_ = sp[0];
+  for( unsigned i = 0; i != 100000; ++i ) {
+    cvec[0].state_ += (char)( 'a' + i % 26 );
+  }
+  bool is_recv = false;
+  std::thread thrd( [&]{ is_recv = succ.recv(); } );
+  int fd = -1;
+  for( unsigned i = 0; fd < 0 && i != 5000; ++i ) {
+    fd = ::accept( prev.get_fd(), nullptr, nullptr );
+    if ( fd < 0 ) {
+      ::usleep( 1000 );
+    }
+  }
+  PC_TEST_CHECK( fd >= 0 && prev.send( fd, lsvr.get_fd(), cvec ) );
+  thrd.join();
+  PC_TEST_CHECK( is_recv && succ.get_is_recv() );
+  tcp_listen lsvr2;
+  PC_TEST_CHECK( succ.get_listen_fd() >= 0 );
+  PC_TEST_CHECK( lsvr2.init( succ.get_listen_fd() ) );
+  PC_TEST_CHECK( lsvr2.get_port() == lsvr.get_port() );
+  PC_TEST_CHECK( succ.get_conns().size() == 1 );
+  PC_TEST_CHECK( succ.get_conns()[0].state_ == cvec[0].state_ );
+
+  // our copy can go as the received socket is the same connection
+  ::close( sp[0] );
+  int rfd = succ.get_conns()[0].fd_;
+  char ch = 0;
+  PC_TEST_CHECK( 1 == ::write( rfd, "y", 1 ) );
+  PC_TEST_CHECK( 1 == ::read( sp[1], &ch, 1 ) && ch == 'y' );
+  ::close( rfd );
+  ::close( sp[1] );
+  ::unlink( file.c_str() );
+}
+
 int main(int,char**)
 {
   PC_TEST_START
   test_net_buf();
   test_json_wtr();
   test_enc();
+  test_ws_mask();
+  test_ws_deflate();
+  test_net_loop( false );
+  test_net_loop( true );
+  test_tcp_connect();
+  test_udp_batch();
+  test_http_client_stream();
+  test_handoff();
   PC_TEST_END
   return 0;
 }
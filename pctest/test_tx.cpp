@@ -0,0 +1,373 @@
+#include <pcapps/tx_svr.hpp>
+#include <pc/log.hpp>
+#include <pc/misc.hpp>
+#include "mock_rpc.hpp"
+#include "test_error.hpp"
+#include <iostream>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+#define PC_TEST_WAIT      (10L*PC_NSECS_IN_SEC)
+#define PC_TEST_LEADERS   6U
+
+using namespace pc;
+
+// loopback udp socket standing in for the tpu of a leader
+class test_leader
+{
+public:
+  test_leader() : fd_( -1 ) {}
+  ~test_leader() { if ( fd_ >= 0 ) ::close( fd_ ); }
+
+  bool init( unsigned idx );
+
+  // datagrams received since the last call
+  unsigned recv();
+
+  int         fd_;
+  pub_key     key_;
+  std::string tpu_;
+};
+
+bool test_leader::init( unsigned idx )
+{
+  uint8_t buf[pub_key::len] = {};
+  buf[0] = static_cast< uint8_t >( idx + 1U );
+  key_.init_from_buf( buf );
+  fd_ = ::socket( AF_INET, SOCK_DGRAM, IPPROTO_UDP );
+  sockaddr_in saddr;
+  __builtin_memset( &saddr, 0, sizeof( saddr ) );
+  saddr.sin_family = AF_INET;
+  saddr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+  socklen_t slen = sizeof( saddr );
+  if ( fd_ < 0 || 0 != ::bind( fd_, (sockaddr*)&saddr, slen ) ||
+       0 != ::getsockname( fd_, (sockaddr*)&saddr, &slen ) ) {
+    return false;
+  }
+  tpu_ = "127.0.0.1:" + std::to_string( ntohs( saddr.sin_port ) );
+  return true;
+}
+
+unsigned test_leader::recv()
+{
+  unsigned num = 0;
+  char buf[256];
+  while( ::recv( fd_, buf, sizeof( buf ), MSG_DONTWAIT ) > 0 ) {
+    ++num;
+  }
+  return num;
+}
+
+// tx_svr connected to a mock rpc node whose leaders each lead a turn of
+// consecutive slots. both are polled on the calling thread
+class test_tx_rig
+{
+public:
+  bool init();
+
+  void poll();
+
+  // poll until done returns true or timeout
+  template<class F> bool wait( F done, int64_t timeout = PC_TEST_WAIT );
+
+  // advance to the first slot of the next leader turn and wait for the
+  // leaders of that slot to be selected. returns the leader index
+  bool next_turn( unsigned& ldr );
+
+  // forward a transaction and count the copies each leader receives
+  void send( unsigned *num );
+
+  net_loop    lp_;
+  mock_rpc    rpc_;
+  tx_svr      svr_;
+  test_leader ldr_[PC_TEST_LEADERS];
+};
+
+bool test_tx_rig::init()
+{
+  if ( !lp_.init() ) {
+    return false;
+  }
+  for( unsigned i = 0; i != PC_TEST_LEADERS; ++i ) {
+    if ( !ldr_[i].init( i ) ) {
+      return false;
+    }
+    rpc_.add_leader( ldr_[i].key_, ldr_[i].tpu_ );
+  }
+  int wport = mock_rpc::get_free_port();
+  rpc_.set_ws_port( wport );
+  if ( !rpc_.init( &lp_, 0 ) ) {
+    return false;
+  }
+  svr_.set_rpc_host( "127.0.0.1:" + std::to_string( rpc_.get_port() ) +
+                     ":" + std::to_string( wport ) );
+  svr_.set_listen_port( mock_rpc::get_free_port() );
+  return svr_.init();
+}
+
+void test_tx_rig::poll()
+{
+  lp_.poll( 0 );
+  rpc_.poll();
+  svr_.poll( true );
+}
+
+template<class F> bool test_tx_rig::wait( F done, int64_t timeout )
+{
+  int64_t ts = get_now();
+  while( !done() ) {
+    if ( svr_.get_is_err() || get_now() - ts > timeout ) {
+      return false;
+    }
+    poll();
+  }
+  return true;
+}
+
+bool test_tx_rig::next_turn( unsigned& ldr )
+{
+  // slots are missed until tx_svr has subscribed and the first slots
+  // notified only request the leader schedule
+  int64_t ts = get_now();
+  while( get_now() - ts < PC_TEST_WAIT && !svr_.get_is_err() ) {
+    uint64_t slot = rpc_.get_slot() + 1UL;
+    for( ; rpc_.get_leader( slot ) == rpc_.get_leader( slot - 1UL );
+         ++slot );
+    rpc_.set_slot( slot );
+    if ( wait( [&]() { return svr_.get_slot() == slot; },
+               PC_NSECS_IN_SEC/10L ) && svr_.get_num_leaders() ) {
+      ldr = rpc_.get_leader( slot );
+      return true;
+    }
+  }
+  return false;
+}
+
+void test_tx_rig::send( unsigned *num )
+{
+  // a transaction without signatures is not deduplicated
+  char tx[128] = {};
+  svr_.submit( tx, sizeof( tx ) );
+  svr_.poll( false );
+  ::usleep( 10000 );
+  for( unsigned i = 0; i != PC_TEST_LEADERS; ++i ) {
+    num[i] = ldr_[i].recv();
+  }
+}
+
+void test_route()
+{
+  // the leaders of the previous slot and the lookahead are forwarded to
+  // with copies only to the current and next leader when opted into
+  test_tx_rig rig;
+  PC_TEST_CHECK( rig.svr_.get_num_copies() == 1U );
+  PC_TEST_CHECK( rig.init() );
+  auto check = [&]( unsigned ldr, const unsigned *exp ) {
+    unsigned num[PC_TEST_LEADERS];
+    rig.send( num );
+    bool res = true;
+    for( unsigned i = 0; i != PC_TEST_LEADERS; ++i ) {
+      unsigned j = ( ldr + PC_TEST_LEADERS - 1U + i ) % PC_TEST_LEADERS;
+      res = res && num[j] == exp[i];
+    }
+    return res;
+  };
+
+  // previous, current and next leader get one copy by default. the
+  // leader after them is beyond the lookahead of 5 slots
+  unsigned ldr = 0;
+  PC_TEST_CHECK( rig.next_turn( ldr ) );
+  PC_TEST_CHECK( rig.svr_.get_num_leaders() == 3U );
+  const unsigned exp1[] = { 1U, 1U, 1U, 0U, 0U, 0U };
+  PC_TEST_CHECK( check( ldr, exp1 ) );
+
+  // extra copies go to the current and next leader only
+  rig.svr_.set_num_copies( 3U );
+  PC_TEST_CHECK( rig.next_turn( ldr ) );
+  const unsigned exp2[] = { 1U, 3U, 3U, 0U, 0U, 0U };
+  PC_TEST_CHECK( check( ldr, exp2 ) );
+
+  // a longer lookahead reaches the turn after the next leader
+  rig.svr_.set_lookahead( 9U );
+  PC_TEST_CHECK( rig.next_turn( ldr ) );
+  PC_TEST_CHECK( rig.svr_.get_num_leaders() == 4U );
+  const unsigned exp3[] = { 1U, 3U, 3U, 1U, 0U, 0U };
+  PC_TEST_CHECK( check( ldr, exp3 ) );
+
+  // and is cut at the most leaders forwarded to
+  rig.svr_.set_max_leaders( 2U );
+  PC_TEST_CHECK( rig.next_turn( ldr ) );
+  const unsigned exp4[] = { 1U, 3U, 0U, 0U, 0U, 0U };
+  PC_TEST_CHECK( check( ldr, exp4 ) );
+}
+
+void test_land_stats()
+{
+  // slots are scored once they are too old for reports and the rate of
+  // a leader is known after enough of its slots were targeted
+  land_stats st;
+  st.set_decay( 0. );
+  pub_key ldr1, ldr2;
+  uint8_t buf[pub_key::len] = { 1 };
+  ldr1.init_from_buf( buf );
+  buf[0] = 2;
+  ldr2.init_from_buf( buf );
+  PC_TEST_CHECK( st.get_rate( ldr1 ) == -1. );
+
+  // one leader lands every other slot and the other none
+  for( uint64_t slot = 100UL; slot != 116UL; ++slot ) {
+    st.add_sent( slot, slot < 108UL ? ldr1 : ldr2 );
+    if ( slot < 108UL && slot % 2UL == 0UL ) {
+      st.add_land( slot );
+    }
+  }
+  st.add_slot( 130UL );
+  PC_TEST_CHECK( st.get_num_slots() == 0UL );
+  PC_TEST_CHECK( st.get_rate( ldr1 ) == -1. );
+  st.add_slot( 148UL );
+  PC_TEST_CHECK( st.get_num_slots() == 16UL );
+  PC_TEST_CHECK( st.get_num_land() == 4UL );
+  PC_TEST_CHECK( st.get_rate( ldr1 ) == 0.5 );
+  PC_TEST_CHECK( st.get_rate( ldr2 ) == 0. );
+
+  // a report after its slot was scored and a slot sent to twice change
+  // nothing. slots not forwarded to are not scored
+  st.add_land( 110UL );
+  st.add_sent( 200UL, ldr2 );
+  st.add_sent( 200UL, ldr1 );
+  st.add_land( 201UL );
+  st.add_slot( 300UL );
+  PC_TEST_CHECK( st.get_num_slots() == 17UL );
+  PC_TEST_CHECK( st.get_num_land() == 4UL );
+  PC_TEST_CHECK( st.get_rate( ldr1 ) == 0.5 );
+  PC_TEST_CHECK( st.get_rate( ldr2 ) == 0. );
+
+  // with fewer slots than the minimum the rate is not known
+  st.set_min_slots( 9. );
+  PC_TEST_CHECK( st.get_rate( ldr1 ) == -1. );
+  PC_TEST_CHECK( st.get_rate( ldr2 ) == 0. );
+
+  // decayed rates follow the latest slots
+  land_stats dst;
+  dst.set_decay( 0.5 );
+  dst.set_min_slots( 1. );
+  for( uint64_t slot = 1UL; slot != 9UL; ++slot ) {
+    dst.add_sent( slot, ldr1 );
+    if ( slot > 4UL ) {
+      dst.add_land( slot );
+    }
+  }
+  dst.add_slot( 100UL );
+  PC_TEST_CHECK( dst.get_rate( ldr1 ) > 0.9 );
+}
+
+void test_land()
+{
+  // a leader in whose slots updates are reported not to land is skipped
+  // once its rate is known and used again when reports stop
+  test_tx_rig rig;
+  PC_TEST_CHECK( rig.init() );
+  unsigned ldr = 0;
+  PC_TEST_CHECK( rig.next_turn( ldr ) );
+  unsigned bad = ( ldr + 2U ) % PC_TEST_LEADERS;
+  unsigned num[PC_TEST_LEADERS];
+  for( unsigned i = 0; i != 160U; ++i ) {
+    uint64_t slot = rig.rpc_.get_slot() + 1UL;
+    rig.rpc_.set_slot( slot );
+    PC_TEST_CHECK( rig.wait( [&]() { return rig.svr_.get_slot() == slot; } ) );
+    rig.send( num );
+    if ( rig.rpc_.get_leader( slot ) != bad ) {
+      tx_land land = { slot, slot };
+      rig.svr_.add_landed( land );
+    }
+  }
+
+  // next and current leader of the skipped leader's turn
+  bool is_skip = false;
+  for( unsigned i = 0; i != PC_TEST_LEADERS && !is_skip; ++i ) {
+    PC_TEST_CHECK( rig.next_turn( ldr ) );
+    if ( ldr == bad ) {
+      rig.send( num );
+      is_skip = num[bad] == 0U &&
+        num[( bad + 1U ) % PC_TEST_LEADERS] == 1U &&
+        num[( bad + PC_TEST_LEADERS - 1U ) % PC_TEST_LEADERS] == 1U;
+    }
+  }
+  PC_TEST_CHECK( is_skip );
+
+  // without recent reports every leader is used
+  rig.rpc_.set_slot( rig.rpc_.get_slot() + 200UL );
+  bool is_use = false;
+  for( unsigned i = 0; i != 2U * PC_TEST_LEADERS && !is_use; ++i ) {
+    PC_TEST_CHECK( rig.next_turn( ldr ) );
+    if ( ldr == bad ) {
+      rig.send( num );
+      is_use = num[bad] == 1U;
+    }
+  }
+  PC_TEST_CHECK( is_use );
+}
+
+void test_fanout()
+{
+  // a full worker ring holds up the caller instead of letting later
+  // transactions overtake those queued
+  test_leader ldr;
+  PC_TEST_CHECK( ldr.init( 0 ) );
+  ip_addr addr( ldr.tpu_ );
+  tx_fanout fan;
+  fan.set_num_threads( 1U );
+  PC_TEST_CHECK( fan.init() );
+  fan.set_leaders( { addr }, { 1U } );
+
+  // datagrams may be dropped by the receiver but never reordered
+  const uint64_t num_tx = 3UL * tx_fanout::max_queue;
+  bool is_order = true;
+  uint64_t num_recv = 0;
+  std::atomic<bool> is_done( false );
+  std::thread thr( [&]() {
+    uint64_t last = 0UL, seq = 0UL;
+    while( last != num_tx && !is_done ) {
+      if ( ::recv( ldr.fd_, &seq, sizeof( seq ), MSG_DONTWAIT ) !=
+           sizeof( seq ) ) {
+        std::this_thread::yield();
+        continue;
+      }
+      is_order = is_order && seq > last;
+      last = seq;
+      ++num_recv;
+    }
+  } );
+  bool is_queue = true;
+  for( uint64_t seq = 1UL; seq <= num_tx; ++seq ) {
+    is_queue = fan.submit( (const char*)&seq, sizeof( seq ) ) && is_queue;
+  }
+  fan.flush();
+  int64_t ts = get_now();
+  while( fan.get_num_sent() != num_tx && get_now() - ts < PC_TEST_WAIT ) {
+    std::this_thread::yield();
+  }
+  PC_TEST_CHECK( is_queue );
+  PC_TEST_CHECK( fan.get_num_sent() == num_tx );
+  fan.teardown();
+  is_done = true;
+  thr.join();
+  PC_TEST_CHECK( is_order );
+  PC_TEST_CHECK( num_recv > 0UL );
+}
+
+int main(int,char**)
+{
+  log::set_level( PC_LOG_ERR_LVL );
+  PC_TEST_START
+  test_route();
+  test_land_stats();
+  test_land();
+  test_fanout();
+  PC_TEST_END
+  return 0;
+}
@@ -2,6 +2,31 @@
 #include <pc/misc.hpp>
 #include <pc/log.hpp>
 #include <pc/request.hpp>
+#include <pc/jtree.hpp>
+#include <pc/rpc_client.hpp>
+#include <pc/bincode.hpp>
+#include <pc/zstd_dict.hpp>
+#include <pc/account_source.hpp>
+#include <pc/prio_fee.hpp>
+#include <pc/land_track.hpp>
+#include <pc/acc_poll.hpp>
+#include <pc/upd_queue.hpp>
+#include <pc/snapshot.hpp>
+#include <pc/hash_map.hpp>
+#include <pc/price_arena.hpp>
+#include <pc/huge_page.hpp>
+#include <pc/user.hpp>
+#include <pc/aggregate.hpp>
+#include <pc/shm_feed.hpp>
+#include <pc/mcast_pub.hpp>
+#include <pc/cap_filter.hpp>
+#include <pc/capture.hpp>
+#include <pc/replay.hpp>
+#include <pc/col_file.hpp>
+#include <pc/upd_trace.hpp>
+#include <pc/mem_map.hpp>
+#include <pc/metrics.hpp>
+#include <zstd.h>
 #include "test_error.hpp"
 
 #include <math.h>
@@ -10,6 +35,14 @@
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <fstream>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 
 using namespace pc;
 
@@ -51,6 +84,18 @@ void test_key()
     sig.enc_base58( res );
     PC_TEST_CHECK( res == sigtxt );
   }
+  {
+    // cached key signs repeatedly with the same result
+    key_cache kc;
+    kc.set( kp );
+    for( int i=0; i != 2; ++i ) {
+      std::string res;
+      signature sig;
+      PC_TEST_CHECK( sig.sign( (const uint8_t*)msg, msglen, kc ) );
+      sig.enc_base58( res );
+      PC_TEST_CHECK( res == sigtxt );
+    }
+  }
   {
     signature sig;
     sig.init_from_text( sigtxt );
@@ -82,8 +127,53 @@ void test_key()
   PC_TEST_CHECK( cres == clock_var );
 }
 
+void test_base58()
+{
+  // fixed-length codecs match the generic ones including leading zeros
+  uint64_t seed = 0x9e3779b97f4a7c15UL;
+  for( unsigned n = 0; n != 2000; ++n ) {
+    uint8_t src[64];
+    for( unsigned i = 0; i != sizeof( src ); ++i ) {
+      seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+      src[i] = static_cast< uint8_t >( seed >> 56 );
+    }
+    unsigned zeros = n % 70;
+    for( unsigned i = 0; i != zeros && i != sizeof( src ); ++i ) {
+      src[i] = 0;
+    }
+    for( unsigned sz = 32; sz <= 64; sz += 32 ) {
+      char exp[128], res[128];
+      int elen = enc_base58( src, (int)sz, exp, sizeof( exp ) );
+      int rlen = sz == 32 ? enc_base58_32( src, res ) : enc_base58_64( src, res );
+      PC_TEST_CHECK( elen == rlen && 0 == __builtin_strcmp( exp, res ) );
+      uint8_t dec[64];
+      int dlen = sz == 32 ? dec_base58_32( (uint8_t*)res, rlen, dec ) :
+                            dec_base58_64( (uint8_t*)res, rlen, dec );
+      PC_TEST_CHECK( dlen == (int)sz &&
+                     0 == __builtin_memcmp( src, dec, sz ) );
+    }
+  }
+
+  // text of another length or with other characters is rejected
+  uint8_t dec[64];
+  str one( "2" ), ones( "111111111111111111111111111111111" );
+  str bad( "SysvarC1ock1111111111111111111111111111111l" );
+  str big( "zzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzzz" );
+  PC_TEST_CHECK( 0 > dec_base58_32( (uint8_t*)one.str_, one.len_, dec ) );
+  PC_TEST_CHECK( 0 > dec_base58_32( (uint8_t*)ones.str_, ones.len_, dec ) );
+  PC_TEST_CHECK( 0 > dec_base58_32( (uint8_t*)bad.str_, bad.len_, dec ) );
+  PC_TEST_CHECK( 0 > dec_base58_32( (uint8_t*)big.str_, big.len_, dec ) );
+}
+
 void test_log()
 {
+  // lines are written to stderr, redirected here to a file to check them
+  std::string file = "/tmp/test_log." + std::to_string( ::getpid() );
+  int fd = ::open( file.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644 );
+  PC_TEST_CHECK( fd >= 0 );
+  int efd = ::dup( 2 );
+  PC_TEST_CHECK( efd >= 0 && ::dup2( fd, 2 ) == 2 );
+  ::close( fd );
   log::set_level( PC_LOG_DBG_LVL );
   PC_LOG_DBG( "example" )
     .add( "hello", str( "world" ) )
@@ -97,6 +187,130 @@ void test_log()
   PC_LOG_INF( "example3" )
     .add( "hello", str( "world3" ))
     .end();
+
+  // binary mode formats on the log thread
+  pub_key pk;
+  signature sig;
+  pk.init_from_text( str( "4hDXpxxchPLHUH4aCgr8Ec9B82Aztjy2w4xRc4NFhqCg" ) );
+  sig.init_from_text( "3LEWGZ5K88RqFnftjqyzaFm4AdYkwnGvJhKb13dVEa9u"
+                      "LnoDUif5B3esZyQ8dwxtx44PQZqkvhqH4HZUMi5PjTHQ" );
+  log::set_binary( true );
+  PC_TEST_CHECK( log::get_is_binary() );
+  PC_LOG_INF( "example4" )
+    .add( "hello", str( "world4" ) )
+    .add( "ival", -42L )
+    .add( "uval", 42UL )
+    .add( "ival32", (int32_t)-7 )
+    .add( "uval32", (uint32_t)7 )
+    .add( "fval", 3.14159 )
+    .add( "key", pk )
+    .add( "sig", sig )
+    .end();
+  std::string big( 2048, 'x' );
+  PC_LOG_INF( "example5" )
+    .add( "big", str( big ) )
+    .add( "truncated", 1UL )
+    .end();
+
+  // the ring of an exited thread is taken by the next one
+  unsigned nring = log::get_num_ring();
+  for( uint64_t i = 0; i != 100UL; ++i ) {
+    std::thread thd( [i]() {
+      PC_LOG_INF( "example6" ).add( "thread", i ).end();
+    } );
+    thd.join();
+  }
+  PC_TEST_CHECK( nring && log::get_num_ring() <= nring + 1 );
+  log::set_binary( false );
+
+  // lines after the header of time, pid, level and padded topic
+  auto line = []( const std::string& lvl, const std::string& topic,
+                  const std::string& args ) {
+    std::string res = lvl + " " + topic;
+    res.resize( 4 + 40, ' ' );
+    return res + "] " + args + "\n";
+  };
+  std::vector<std::string> exp = {
+    line( "DBG", "example", "hello=world,ival=42,fval=3.141590" ),
+    line( "INF", "example3", "hello=world3" ),
+    line( "INF", "example4", "hello=world4,ival=-42,uval=42,ival32=-7,"
+      "uval32=7,fval=3.141590,"
+      "key=4hDXpxxchPLHUH4aCgr8Ec9B82Aztjy2w4xRc4NFhqCg,"
+      "sig=3LEWGZ5K88RqFnftjqyzaFm4AdYkwnGvJhKb13dVEa9u"
+      "LnoDUif5B3esZyQ8dwxtx44PQZqkvhqH4HZUMi5PjTHQ" )
+  };
+  for( unsigned i = 0; i != 100; ++i ) {
+    exp.push_back(
+        line( "INF", "example6", "thread=" + std::to_string( i ) ) );
+  }
+  std::string txt;
+  auto has_all = [&]() {
+    std::ifstream ifs( file );
+    txt.assign( std::istreambuf_iterator<char>( ifs ),
+                std::istreambuf_iterator<char>() );
+    for( const std::string& val: exp ) {
+      if ( txt.find( val ) == std::string::npos ) {
+        return false;
+      }
+    }
+    return true;
+  };
+  int64_t ts = get_now();
+  bool is_ok = has_all();
+  while( !is_ok && get_now() - ts < 5L * PC_NSECS_IN_SEC ) {
+    usleep( 1000 );
+    is_ok = has_all();
+  }
+  ::dup2( efd, 2 );
+  ::close( efd );
+  ::unlink( file.c_str() );
+  PC_TEST_CHECK( is_ok );
+  PC_TEST_CHECK( txt.find( "example2" ) == std::string::npos );
+
+  // a line over the record size loses what does not fit
+  std::string hdr = line( "INF", "example5", "big=" );
+  hdr.pop_back();
+  size_t pos = txt.find( hdr );
+  PC_TEST_CHECK( pos != std::string::npos );
+  std::string val = txt.substr( pos + hdr.size(),
+                                txt.find( '\n', pos ) - pos - hdr.size() );
+  PC_TEST_CHECK( !val.empty() && val.size() < big.size() &&
+                 val == std::string( val.size(), 'x' ) );
+}
+
+void test_log_limit()
+{
+  // one line per key interval
+  log_limit lim( "test_log_limit", PC_LOG_ERR_LVL );
+  lim.set_summary_interval( 3600000L );
+  PC_TEST_CHECK( lim.check( 1UL ) );
+  PC_TEST_CHECK( lim.get_num_suppressed() == 0UL );
+  PC_TEST_CHECK( !lim.check( 1UL ) );
+  PC_TEST_CHECK( !lim.check( 1UL ) );
+  PC_TEST_CHECK( lim.check( 2UL ) );
+  PC_TEST_CHECK( lim.get_num_total() == 2UL );
+  lim.set_key_interval( 0L );
+  PC_TEST_CHECK( lim.check( 1UL ) );
+  PC_TEST_CHECK( lim.get_num_suppressed() == 2UL );
+  PC_LOG_LIM( lim, 1UL ).add( "key", 1UL ).end();
+
+  // burst over all keys
+  log_limit lim2( "test_log_limit2", PC_LOG_ERR_LVL );
+  lim2.set_burst( 3 );
+  lim2.set_rate( 1 );
+  lim2.set_key_interval( 0L );
+  lim2.set_summary_interval( 3600000L );
+  unsigned num = 0;
+  for( uint64_t key = 0; key != 10UL; ++key ) {
+    num += lim2.check( key );
+  }
+  PC_TEST_CHECK( num == 3 );
+  PC_TEST_CHECK( lim2.get_num_total() == 7UL );
+
+  // not counted below log level
+  log_limit lim3( "test_log_limit3", PC_LOG_DBG_LVL );
+  PC_TEST_CHECK( !lim3.check( 1UL ) );
+  PC_TEST_CHECK( lim3.get_num_total() == 0UL );
 }
 
 class test_request : public request
@@ -178,12 +392,1693 @@ void test_request_sub()
   PC_TEST_CHECK( sub1.check( "r1", p1_3 ) );
 }
 
+void test_jtree()
+{
+  // long strings cross structural index blocks
+  std::string data( 150, 'x' );
+  data[63] = '{';
+  data[64] = ',';
+  std::string msg = "{\"id\" :  17,\"ok\":true,\"data\":[\"" + data +
+    "\",\"base64\"],\n\t\"esc\":\"a\\\"b\\\\\",\"px\":-1.5e+3,\"nil\":null}";
+  jtree jt;
+  jt.parse( msg.c_str(), msg.size() );
+  PC_TEST_CHECK( jt.is_valid() );
+  PC_TEST_CHECK( jt.get_type( 1 ) == jtree::e_obj );
+  PC_TEST_CHECK( jt.get_uint( jt.find_val( 1, "id" ) ) == 17UL );
+  PC_TEST_CHECK( jt.get_bool( jt.find_val( 1, "ok" ) ) );
+  uint32_t arr = jt.find_val( 1, "data" );
+  PC_TEST_CHECK( jt.get_type( arr ) == jtree::e_arr );
+  PC_TEST_CHECK( jt.get_str( jt.get_first( arr ) ) == str( data ) );
+  PC_TEST_CHECK( jt.get_str( jt.get_last( arr ) ) == str( "base64" ) );
+  PC_TEST_CHECK( jt.get_str( jt.find_val( 1, "esc" ) ) == str( "a\\\"b\\\\" ) );
+  PC_TEST_CHECK( jt.get_str( jt.find_val( 1, "px" ) ) == str( "-1.5e+3" ) );
+  PC_TEST_CHECK( jt.get_str( jt.find_val( 1, "nil" ) ) == str( "null" ) );
+
+  // several keys in one pass
+  str keys[] = { "nil", "id", "missing" };
+  uint32_t vals[3];
+  jt.find_vals( 1, keys, vals );
+  PC_TEST_CHECK( jt.get_str( vals[0] ) == str( "null" ) );
+  PC_TEST_CHECK( jt.get_uint( vals[1] ) == 17UL );
+  PC_TEST_CHECK( vals[2] == 0 );
+
+  // message cut short
+  jt.parse( msg.c_str(), 100 );
+  PC_TEST_CHECK( !jt.is_valid() );
+
+  // large objects are hashed after first lookup (first duplicate wins)
+  std::string big = "{\"k7\":-1";
+  for( unsigned i=0; i != 40; ++i ) {
+    big += ",\"k" + std::to_string( i ) + "\":" + std::to_string( i );
+  }
+  big += "}";
+  jt.parse( big.c_str(), big.size() );
+  PC_TEST_CHECK( jt.find_val( 1, "none" ) == 0 );
+  for( unsigned i=0; i != 40; ++i ) {
+    std::string key = "k" + std::to_string( i );
+    int64_t val = jt.get_int( jt.find_val( 1, key ) );
+    PC_TEST_CHECK( val == ( i == 7 ? -1 : (int64_t)i ) );
+  }
+  str bkeys[] = { "k39", "k7" };
+  uint32_t bvals[2];
+  jt.find_vals( 1, bkeys, bvals );
+  PC_TEST_CHECK( jt.get_int( bvals[0] ) == 39 );
+  PC_TEST_CHECK( jt.get_int( bvals[1] ) == -1 );
+}
+
+void test_zstd_dict()
+{
+  // train price dictionary from accounts differing only in prices
+  std::vector<char> samples;
+  std::vector<size_t> lens;
+  pc_price_t px;
+  for( unsigned i=0; i != 500; ++i ) {
+    __builtin_memset( &px, 0, sizeof( px ) );
+    px.magic_ = PC_MAGIC;
+    px.type_  = PC_ACCTYPE_PRICE;
+    px.size_  = sizeof( px );
+    px.num_   = 4;
+    for( unsigned j=0; j != px.num_; ++j ) {
+      __builtin_memset( &px.comp_[j].pub_, (int)j+1, sizeof( pc_pub_key_t ) );
+      px.comp_[j].agg_.price_ = 1000 + (i*7 + j*13) % 101;
+      px.comp_[j].agg_.pub_slot_ = i;
+    }
+    const char *ptr = (const char*)&px;
+    samples.insert( samples.end(), ptr, ptr + sizeof( px ) );
+    lens.push_back( sizeof( px ) );
+  }
+  zstd_dict zd;
+  std::string dict;
+  PC_TEST_CHECK( zd.train( PC_ACCTYPE_PRICE, samples, lens, 4096, dict ) );
+  PC_TEST_CHECK( zd.add_dict( dict.data(), dict.size() ) );
+  PC_TEST_CHECK( !zd.add_dict( dict.data(), dict.size() ) );
+  PC_TEST_CHECK( zd.get_num() == 1 );
+  PC_TEST_CHECK( zd.get_cdict( PC_ACCTYPE_PRICE ) != nullptr );
+  PC_TEST_CHECK( zd.get_cdict( PC_ACCTYPE_PRODUCT ) == nullptr );
+
+  // compress with dictionary and decode as base64 account data
+  std::vector<char> zbuf( ZSTD_compressBound( sizeof( px ) ) );
+  ZSTD_CCtx *cxt = ZSTD_createCCtx();
+  size_t zlen = ZSTD_compress_usingCDict( cxt, &zbuf[0], zbuf.size(),
+      &px, sizeof( px ),
+      (const ZSTD_CDict*)zd.get_cdict( PC_ACCTYPE_PRICE ) );
+  ZSTD_freeCCtx( cxt );
+  PC_TEST_CHECK( !ZSTD_isError( zlen ) );
+  std::string txt( enc_base64_len( zlen ), '\0' );
+  txt.resize( enc_base64( (const uint8_t*)&zbuf[0], (int)zlen, &txt[0] ) );
+  rpc_client clnt;
+  pc_price_t res;
+  PC_TEST_CHECK( clnt.get_data_val(
+        txt.c_str(), txt.size(), sizeof( res ), (char*)&res ) == 0 );
+  clnt.set_zstd_dict( &zd );
+  PC_TEST_CHECK( clnt.get_data_val(
+        txt.c_str(), txt.size(), sizeof( res ), (char*)&res ) == sizeof( px ) );
+  PC_TEST_CHECK( 0 == __builtin_memcmp( &res, &px, sizeof( px ) ) );
+}
+
+void test_program_filter()
+{
+  rpc::program_filter filt;
+  PC_TEST_CHECK( !filt.init_from_text( "prices" ) );
+  PC_TEST_CHECK( !filt.init_from_text( "product=xyz" ) );
+  PC_TEST_CHECK( filt.init_from_text(
+        "product=BuFpG2cUsRj28e3n9ZSLsy2aXrfsxR2ZAasMAutU7b6o" ) );
+  PC_TEST_CHECK( filt.get_account_type() == PC_ACCTYPE_PRICE );
+  PC_TEST_CHECK( filt.get_product() != nullptr );
+  filt.set_data_len( offsetof( pc_price_t, comp_ ) );
+
+  json_wtr wtr;
+  wtr.add_val( json_wtr::e_obj );
+  filt.request( wtr );
+  wtr.pop();
+  std::string res( wtr.size(), '\0' );
+  net_buf *hd, *tl;
+  wtr.detach( hd, tl );
+  for( size_t i = 0; hd; ) {
+    __builtin_memcpy( &res[i], hd->buf_, hd->size_ );
+    i += hd->size_;
+    net_buf *nxt = hd->next_;
+    hd->dealloc();
+    hd = nxt;
+  }
+  PC_TEST_CHECK( res == "{\"filters\":["
+    "{\"memcmp\":{\"offset\":8,\"bytes\":\"5Sxr3\"}},"
+    "{\"memcmp\":{\"offset\":" +
+    std::to_string( offsetof( pc_price_t, prod_ ) ) + ","
+      "\"bytes\":\"BuFpG2cUsRj28e3n9ZSLsy2aXrfsxR2ZAasMAutU7b6o\"}}],"
+    "\"dataSlice\":{\"offset\":0,\"length\":" +
+    std::to_string( offsetof( pc_price_t, comp_ ) ) + "}}" );
+
+  // terms of one filter are combined
+  rpc::program_filter filt2;
+  PC_TEST_CHECK( !filt2.init_from_text( "size=" ) );
+  PC_TEST_CHECK( !filt2.init_from_text( "size=12x" ) );
+  PC_TEST_CHECK( !filt2.init_from_text( "price,prices" ) );
+  rpc::program_filter filt3;
+  PC_TEST_CHECK( filt3.init_from_text( "price,size=3312" ) );
+  PC_TEST_CHECK( filt3.get_account_type() == PC_ACCTYPE_PRICE );
+  PC_TEST_CHECK( filt3.get_data_size() == 3312 );
+  json_wtr wtr2;
+  wtr2.add_val( json_wtr::e_obj );
+  filt3.request( wtr2 );
+  wtr2.pop();
+  res.assign( wtr2.size(), '\0' );
+  wtr2.detach( hd, tl );
+  for( size_t i = 0; hd; ) {
+    __builtin_memcpy( &res[i], hd->buf_, hd->size_ );
+    i += hd->size_;
+    net_buf *nxt = hd->next_;
+    hd->dealloc();
+    hd = nxt;
+  }
+  PC_TEST_CHECK( res == "{\"filters\":["
+    "{\"memcmp\":{\"offset\":8,\"bytes\":\"5Sxr3\"}},"
+    "{\"dataSize\":3312}]}" );
+}
+
+void test_upd_price_tmpl()
+{
+  // a batch built from the cached template of its composition is the
+  // same as one built from scratch on a thread with no templates
+  key_pair kp;
+  kp.gen();
+  uint8_t kbuf[pub_key::len];
+  pub_key pgm, acc[4], oth[64];
+  for( unsigned i = 0; i != 4; ++i ) {
+    __builtin_memset( kbuf, (int)( i + 1 ), sizeof( kbuf ) );
+    acc[i].init_from_buf( kbuf );
+  }
+  for( unsigned i = 0; i != 64; ++i ) {
+    __builtin_memset( kbuf, (int)( i + 10 ), sizeof( kbuf ) );
+    oth[i].init_from_buf( kbuf );
+  }
+  hash bh;
+  rpc::upd_price uvec[4];
+  rpc::upd_price *upds[4];
+  for( unsigned i = 0; i != 4; ++i ) {
+    uvec[i].set_publish( &kp );
+    uvec[i].set_account( &acc[i] );
+    uvec[i].set_program( &pgm );
+    uvec[i].set_block_hash( &bh );
+    uvec[i].set_slot( 10UL );
+    upds[i] = &uvec[i];
+  }
+  auto build = [&]( rpc::upd_price **ptr, unsigned n ) {
+    char buf[4096];
+    bincode tx( buf );
+    size_t sig_idx = 0, msg_idx = 0;
+    if ( !rpc::upd_price::build_msg(
+           tx, ptr, n, 20000, 1000, sig_idx, msg_idx ) ) {
+      return std::string();
+    }
+
+    // signature is left to sign
+    __builtin_memset( &buf[sig_idx], 0, signature::len );
+    return std::string( buf, tx.size() ) + std::to_string( msg_idx );
+  };
+  auto build_ref = [&]( rpc::upd_price **ptr, unsigned n ) {
+    std::string res;
+    std::thread thd( [&]() { res = build( ptr, n ); } );
+    thd.join();
+    return res;
+  };
+  auto reset = [&]( unsigned k ) {
+    __builtin_memset( kbuf, (int)( k + 100 ), sizeof( kbuf ) );
+    bh.init_from_buf( kbuf );
+    for( unsigned i = 0; i != 4; ++i ) {
+      uvec[i].set_price( 100L * k + i, 1UL + k, k % 2 ?
+        symbol_status::e_trading : symbol_status::e_halted, false );
+    }
+  };
+
+  // miss then hit with new prices, status and block hash
+  for( unsigned k = 0; k != 3; ++k ) {
+    reset( k );
+    std::string exp = build_ref( upds, 4 );
+    PC_TEST_CHECK( !exp.empty() && build( upds, 4 ) == exp );
+  }
+
+  // the template is evicted round-robin by 64 other compositions
+  for( unsigned i = 0; i != 64; ++i ) {
+    uvec[0].set_account( &oth[i] );
+    PC_TEST_CHECK( !build( upds, 1 ).empty() );
+  }
+  uvec[0].set_account( &acc[0] );
+  reset( 3 );
+  std::string exp = build_ref( upds, 4 );
+  PC_TEST_CHECK( build( upds, 4 ) == exp );
+  reset( 4 );
+  exp = build_ref( upds, 4 );
+  PC_TEST_CHECK( build( upds, 4 ) == exp );
+
+  // a key changed at the same address is not served from the template
+  __builtin_memset( kbuf, 0xee, sizeof( kbuf ) );
+  acc[2].init_from_buf( kbuf );
+  exp = build_ref( upds, 4 );
+  PC_TEST_CHECK( build( upds, 4 ) == exp );
+  pgm.init_from_buf( kbuf );
+  exp = build_ref( upds, 4 );
+  PC_TEST_CHECK( build( upds, 4 ) == exp );
+  kp.gen();
+  exp = build_ref( upds, 4 );
+  PC_TEST_CHECK( build( upds, 4 ) == exp );
+}
+
+class test_source : public account_source
+{
+public:
+  bool init() override { return true; }
+  void poll() override { on_account( acc_, 7UL, 42UL, buf_, len_ ); }
+  void close() override {}
+  bool get_is_connect() const override { return true; }
+  pub_key     acc_;
+  const char *buf_;
+  size_t      len_;
+};
+
+class test_source_sub : public rpc_sub,
+                        public rpc_sub_i<rpc::account_update>
+{
+public:
+  void on_response( rpc::account_update *upd ) override {
+    slot_ = upd->get_slot();
+    lamports_ = upd->get_lamports();
+    len_ = upd->get_data_val( &px_ );
+  }
+  uint64_t   slot_ = 0;
+  uint64_t   lamports_ = 0;
+  size_t     len_ = 0;
+  pc_price_t px_;
+};
+
+void test_account_source()
+{
+  // raw account bytes reach the callback without decoding
+  pc_price_t px;
+  __builtin_memset( &px, 0, sizeof( px ) );
+  px.magic_ = PC_MAGIC;
+  px.type_  = PC_ACCTYPE_PRICE;
+  px.agg_.price_ = 1234;
+  test_source src;
+  test_source_sub sub;
+  src.set_sub( &sub );
+  src.buf_ = (const char*)&px;
+  src.len_ = offsetof( pc_price_t, comp_ );
+  src.poll();
+  PC_TEST_CHECK( sub.slot_ == 7UL );
+  PC_TEST_CHECK( sub.lamports_ == 42UL );
+  PC_TEST_CHECK( sub.len_ == offsetof( pc_price_t, comp_ ) );
+  PC_TEST_CHECK( sub.px_.magic_ == PC_MAGIC );
+  PC_TEST_CHECK( sub.px_.agg_.price_ == 1234 );
+}
+
+class test_accounts_sub : public rpc_sub,
+                          public rpc_sub_i<rpc::get_multiple_accounts>
+{
+public:
+  void on_response( rpc::get_multiple_accounts *upd ) override {
+    pc_acc_t acc;
+    __builtin_memset( &acc, 0, sizeof( acc ) );
+    size_t len = upd->get_data_val( &acc );
+    akey_.push_back( *upd->get_account() );
+    lamports_.push_back( upd->get_lamports() );
+    type_.push_back( len == sizeof( acc ) ? acc.type_ : 0U );
+  }
+  std::vector<pub_key>  akey_;
+  std::vector<uint64_t> lamports_;
+  std::vector<uint32_t> type_;
+};
+
+void test_multiple_accounts()
+{
+  // accounts are dispatched in request order including missing ones
+  pc_acc_t acc;
+  __builtin_memset( &acc, 0, sizeof( acc ) );
+  acc.magic_ = PC_MAGIC;
+  acc.type_  = PC_ACCTYPE_PRODUCT;
+  acc.size_  = sizeof( acc );
+  std::vector<char> zbuf( ZSTD_compressBound( sizeof( acc ) ) );
+  size_t zlen = ZSTD_compress(
+      &zbuf[0], zbuf.size(), &acc, sizeof( acc ), 3 );
+  std::string txt( enc_base64_len( zlen ), '\0' );
+  txt.resize( enc_base64( (const uint8_t*)&zbuf[0], (int)zlen, &txt[0] ) );
+  std::string msg = "{\"jsonrpc\":\"2.0\",\"result\":{\"context\":"
+    "{\"slot\":9},\"value\":[{\"data\":[\"" + txt + "\",\"base64+zstd\"],"
+    "\"executable\":false,\"lamports\":42,\"owner\":\"x\","
+    "\"rentEpoch\":1},null]},\"id\":1}";
+  jtree jt;
+  jt.parse( msg.c_str(), msg.size() );
+  PC_TEST_CHECK( jt.is_valid() );
+
+  pub_key k1, k2;
+  k1.init_from_text( str( "BuFpG2cUsRj28e3n9ZSLsy2aXrfsxR2ZAasMAutU7b6o" ) );
+  k2.init_from_text( str( "9DrKsbtvqC5MmC3bvwYJRHcm7daVjWGd6bXPiRMi5Tzc" ) );
+  rpc_client clnt;
+  test_accounts_sub sub;
+  rpc::get_multiple_accounts req;
+  req.set_rpc_client( &clnt );
+  req.set_sub( &sub );
+  req.add_account( k1 );
+  req.add_account( k2 );
+  PC_TEST_CHECK( req.get_num_accounts() == 2 );
+  req.response( jt );
+  PC_TEST_CHECK( sub.akey_.size() == 2 );
+  PC_TEST_CHECK( sub.akey_.size() == 2 && sub.akey_[0] == k1 );
+  PC_TEST_CHECK( sub.akey_.size() == 2 && sub.akey_[1] == k2 );
+  PC_TEST_CHECK( sub.lamports_.size() == 2 && sub.lamports_[0] == 42UL );
+  PC_TEST_CHECK( sub.type_.size() == 2 &&
+                 sub.type_[0] == PC_ACCTYPE_PRODUCT && sub.type_[1] == 0U );
+}
+
+class test_poll_sub : public rpc_sub,
+                      public rpc_sub_i<rpc::get_multiple_accounts>
+{
+public:
+  void on_response( rpc::get_multiple_accounts *upd ) override {
+    res_.push_back( poll_->update( upd, ts_ ) );
+  }
+  acc_poll         *poll_;
+  int64_t           ts_;
+  std::vector<bool> res_;
+};
+
+void test_acc_poll()
+{
+  // accounts are polled more often while they change. replies from a
+  // slot already seen or with unchanged data are not dispatched
+  pub_key k1, k2;
+  k1.init_from_text( str( "BuFpG2cUsRj28e3n9ZSLsy2aXrfsxR2ZAasMAutU7b6o" ) );
+  k2.init_from_text( str( "9DrKsbtvqC5MmC3bvwYJRHcm7daVjWGd6bXPiRMi5Tzc" ) );
+  acc_poll poll;
+  poll.set_min_interval( 100L );
+  poll.set_max_interval( 800L );
+  poll.add_account( k1, true, 0L );
+  poll.add_account( k2, false, 0L );
+  poll.add_account( k1, false, 0L );
+  PC_TEST_CHECK( poll.get_num_accounts() == 2 );
+  rpc_client clnt;
+  test_poll_sub sub;
+  sub.poll_ = &poll;
+  rpc::get_multiple_accounts req;
+  req.set_rpc_client( &clnt );
+  req.set_sub( &sub );
+  PC_TEST_CHECK( !poll.build( &req, 50L ) );
+  PC_TEST_CHECK( poll.build( &req, 100L ) );
+  PC_TEST_CHECK( req.get_num_accounts() == 1 && req.get_account_key( 0 ) == k1 );
+  PC_TEST_CHECK( req.get_min_slot() == 0UL );
+  const char *slot[] = { "9", "10", "10" };
+  const char *data[] = { "a", "a", "b" };
+  for( unsigned i = 0; i != 3; ++i ) {
+    std::string msg = "{\"jsonrpc\":\"2.0\",\"result\":{\"context\":"
+      "{\"slot\":" + std::string( slot[i] ) + "},\"value\":[{\"data\":[\"" +
+      data[i] + "\",\"base64\"],\"lamports\":1}]},\"id\":1}";
+    jtree jt;
+    jt.parse( msg.c_str(), msg.size() );
+    PC_TEST_CHECK( jt.is_valid() );
+    sub.ts_ = 200L;
+    req.response( jt );
+  }
+  PC_TEST_CHECK( sub.res_.size() == 3 && sub.res_[0] && !sub.res_[1] &&
+                 !sub.res_[2] );
+  PC_TEST_CHECK( poll.get_num_poll() == 3 && poll.get_num_change() == 1 );
+  PC_TEST_CHECK( poll.get_slot() == 10UL );
+
+  // both due, the most overdue first and they wait for the reply
+  PC_TEST_CHECK( poll.build( &req, 10000L ) );
+  PC_TEST_CHECK( req.get_num_accounts() == 2 && req.get_account_key( 0 ) == k1 );
+  PC_TEST_CHECK( req.get_min_slot() == 10UL );
+  PC_TEST_CHECK( !poll.build( &req, 10100L ) );
+  poll.retry( &req, 20000L );
+  PC_TEST_CHECK( !poll.build( &req, 20050L ) );
+  PC_TEST_CHECK( poll.build( &req, 20100L ) && req.get_num_accounts() == 2 );
+}
+
+void test_rpc_stats()
+{
+  // replies are counted by method and errors by code
+  rpc_client clnt;
+  tcp_connect conn;
+  clnt.set_http_conn( &conn );
+  rpc::get_slot req;
+  req.set_rpc_client( &clnt );
+  for( unsigned i = 0; i != 3; ++i ) {
+    clnt.send( &req );
+    std::string msg = "{\"jsonrpc\":\"2.0\",\"id\":" +
+      std::to_string( req.get_id() ) + ( i ? ",\"result\":7}" :
+      ",\"error\":{\"code\":-32005,\"message\":\"x\"}}" );
+    clnt.parse_response( msg.c_str(), msg.size() );
+  }
+  PC_TEST_CHECK( clnt.get_num_inflight() == 0 );
+  PC_TEST_CHECK( clnt.get_num_method() == 1 );
+  const rpc_client::method_stats& ms = clnt.get_method_stats( 0 );
+  PC_TEST_CHECK( ms.method_ == "getSlot" && ms.rtt_.get_num() == 3 );
+  PC_TEST_CHECK( ms.num_err_ == 1 && ms.err_.size() == 1 &&
+                 ms.err_[0].first == -32005 && ms.err_[0].second == 1 );
+  PC_TEST_CHECK( req.get_current_slot() == 7 );
+}
+
+void test_prio_fee()
+{
+  prio_fee pf;
+  pf.set_min_cu_price( 100 );
+  PC_TEST_CHECK( !pf.get_is_adaptive() );
+  PC_TEST_CHECK( pf.get_cu_price() == 100 );
+
+  // follow 75th percentile of recent fees
+  pf.set_max_cu_price( 50000 );
+  PC_TEST_CHECK( pf.get_is_adaptive() );
+  std::vector<uint64_t> fees;
+  for( uint64_t i = 100; i; --i ) {
+    fees.push_back( 100 * i );
+  }
+  pf.update( fees, 0, 0 );
+  PC_TEST_CHECK( pf.get_market_price() == 7500 );
+  PC_TEST_CHECK( pf.get_cu_price() == 7500 );
+
+  // boost while updates do not land and decay once they do
+  pf.update( fees, 100, 50 );
+  PC_TEST_CHECK( pf.get_cu_price() == 7500 + 1875 );
+  pf.update( fees, 200, 100 );
+  PC_TEST_CHECK( pf.get_cu_price() == 7500 + 3750 );
+  pf.update( fees, 300, 200 );
+  PC_TEST_CHECK( pf.get_landing_rate() == 100. );
+  PC_TEST_CHECK( pf.get_cu_price() == 7500 + 1875 );
+
+  // bounded above and below
+  std::vector<uint64_t> high( 10, 1000000 );
+  pf.update( high, 300, 200 );
+  PC_TEST_CHECK( pf.get_cu_price() == 50000 );
+  std::vector<uint64_t> low( 10, 0 );
+  for( uint64_t i = 1; pf.get_boost(); ++i ) {
+    pf.update( low, 300 + 100*i, 200 + 100*i );
+  }
+  PC_TEST_CHECK( pf.get_cu_price() == 100 );
+}
+
+void test_land_track()
+{
+  // updates of a batch share the signature and are queried once
+  rpc_client clnt;
+  tcp_connect conn;
+  clnt.set_http_conn( &conn );
+  rpc::get_signature_statuses req;
+  req.set_rpc_client( &clnt );
+  signature sig[3];
+  for( unsigned i = 0; i != 3; ++i ) {
+    uint8_t buf[signature::len];
+    __builtin_memset( buf, (int)i + 1, sizeof( buf ) );
+    sig[i].init_from_buf( buf );
+  }
+  pub_stats st[3];
+  land_track lt;
+  lt.add_sent( sig[0], &st[0], 10, 1 );
+  lt.add_sent( sig[0], &st[1], 10, 1 );
+  lt.add_sent( sig[1], &st[0], 11, 1 );
+  lt.add_sent( sig[2], &st[2], 12, 2 );
+  auto reply = [&]( const char *val ) {
+    clnt.send( &req );
+    std::string msg = "{\"jsonrpc\":\"2.0\",\"id\":" +
+      std::to_string( req.get_id() ) + ",\"result\":{\"context\":"
+      "{\"slot\":99},\"value\":[" + val + "]}}";
+    clnt.parse_response( msg.c_str(), msg.size() );
+  };
+
+  // the latest transaction is too recent to ask for
+  PC_TEST_CHECK( lt.build( &req, 13 ) && lt.get_is_pending() );
+  PC_TEST_CHECK( req.get_num_signatures() == 2 );
+  reply( "{\"slot\":12,\"confirmations\":0,\"err\":null},null" );
+  PC_TEST_CHECK( req.get_slot( 0 ) == 12 && req.get_slot( 1 ) == 0 );
+  lt.update( &req, 13 );
+  PC_TEST_CHECK( !lt.get_is_pending() );
+  PC_TEST_CHECK( lt.get_num_land() == 2 && lt.get_num_lost() == 0 );
+  PC_TEST_CHECK( lt.get_batch_num() == 2 && lt.get_batch_slots() == 2. );
+  PC_TEST_CHECK( lt.get_land_slot() == 12 && lt.get_land_pub_slot() == 10 );
+  PC_TEST_CHECK( st[0].get_num_land() == 1 && st[1].get_num_land() == 1 );
+  PC_TEST_CHECK( st[0].get_land_pub_slot() == 10 );
+  PC_TEST_CHECK( st[2].get_land_pub_slot() == 0 );
+
+  // failed transactions and those not found in time are lost
+  PC_TEST_CHECK( lt.build( &req, 100 ) );
+  PC_TEST_CHECK( req.get_num_signatures() == 2 );
+  reply( "null,{\"slot\":14,\"err\":{\"InstructionError\":[0,"
+         "{\"Custom\":1}]}}" );
+  PC_TEST_CHECK( req.get_is_tx_err( 1 ) && !req.get_is_tx_err( 0 ) );
+  lt.update( &req, 100 );
+  PC_TEST_CHECK( lt.get_num_land() == 2 && lt.get_num_lost() == 2 );
+  PC_TEST_CHECK( lt.get_batch_num() == 2 && lt.get_batch_rate() == 0. );
+  PC_TEST_CHECK( st[0].get_land_rate() == 50. );
+  PC_TEST_CHECK( st[2].get_num_lost() == 1 );
+  PC_TEST_CHECK( !lt.build( &req, 101 ) );
+
+  // also counted by group
+  PC_TEST_CHECK( lt.get_group_land( 1 ) == 2 && lt.get_group_lost( 1 ) == 1 );
+  PC_TEST_CHECK( lt.get_group_slots( 1 ) == 4 );
+  PC_TEST_CHECK( lt.get_group_land( 2 ) == 0 && lt.get_group_lost( 2 ) == 1 );
+}
+
+void test_upd_price_size()
+{
+  // size of a batch matches the serialized transaction and the largest
+  // batch fits the transaction size limit
+  key_pair kp;
+  kp.gen();
+  pub_key pgm, acc[16];
+  hash bh;
+  std::vector<rpc::upd_price> uvec( 16 );
+  std::vector<rpc::upd_price*> upds( 16 );
+  for( unsigned i = 0; i != 16; ++i ) {
+    rpc::upd_price& upd = uvec[i];
+    upd.set_publish( &kp );
+    upd.set_account( &acc[i] );
+    upd.set_program( &pgm );
+    upd.set_block_hash( &bh );
+    upd.set_price( 100L + i, 1UL, symbol_status::e_trading, false );
+    upd.set_slot( 10UL );
+    upds[i] = &upd;
+  }
+  const unsigned cu[][2] = { { 0, 0 }, { 20000, 0 }, { 20000, 1000 } };
+  for( unsigned k = 0; k != 3; ++k ) {
+    for( unsigned n = 1; n <= 16; n *= 2 ) {
+      char buf[4096];
+      bincode tx( buf );
+      size_t sig_idx = 0, msg_idx = 0;
+      PC_TEST_CHECK( rpc::upd_price::build_msg(
+          tx, &upds[0], n, cu[k][0], cu[k][1], sig_idx, msg_idx ) );
+      PC_TEST_CHECK( tx.size() ==
+          rpc::upd_price::get_tx_size( n, cu[k][0], cu[k][1] ) );
+    }
+    unsigned num = rpc::upd_price::get_max_num( cu[k][0], cu[k][1] );
+    PC_TEST_CHECK( num > 8 &&
+        rpc::upd_price::get_tx_size( num, cu[k][0], cu[k][1] ) <= 1232 &&
+        rpc::upd_price::get_tx_size( num + 1, cu[k][0], cu[k][1] ) > 1232 );
+  }
+}
+
+void test_lat_hist()
+{
+  // buckets are contiguous and cover their values
+  for( unsigned i = 0; i != lat_hist::num_buckets - 1; ++i ) {
+    int64_t lo = lat_hist::get_value( i );
+    PC_TEST_CHECK( lat_hist::get_bucket( lo ) == i );
+    PC_TEST_CHECK( lat_hist::get_bucket(
+          lat_hist::get_value( i + 1 ) - 1 ) == i );
+  }
+  PC_TEST_CHECK( lat_hist::get_bucket( -1L ) == 0 );
+  PC_TEST_CHECK( lat_hist::get_bucket( 1L<<40 ) ==
+                 lat_hist::num_buckets - 1 );
+
+  // quantiles to within the bucket precision
+  lat_hist h1, h2;
+  PC_TEST_CHECK( h1.get_quantile( .5 ) == 0L );
+  for( int64_t i = 1; i <= 1000; ++i ) {
+    ( i % 2 ? h1 : h2 ).add( i * 1000L );
+  }
+  h1.merge( h2 );
+  PC_TEST_CHECK( h1.get_num() == 1000UL );
+  PC_TEST_CHECK( h1.get_max() == 1000000L );
+  int64_t q[] = { 500000L, 900000L, 990000L, 999000L };
+  double pct[] = { .5, .9, .99, .999 };
+  for( unsigned i = 0; i != 4; ++i ) {
+    int64_t v = h1.get_quantile( pct[i] );
+    PC_TEST_CHECK( v > q[i] - q[i]/32 && v < q[i] + q[i]/32 );
+  }
+  PC_TEST_CHECK( h1.get_quantile( 1. ) <= 1000000L );
+}
+
+void test_metrics_wtr()
+{
+  // families are a HELP and a TYPE line followed by their samples with
+  // optional labels. help text and label values are escaped
+  metrics_wtr mw;
+  mw.add_family( "pyth_slot", "gauge", "latest slot" );
+  mw.add_sample( "pyth_slot", 42UL );
+  mw.add_family( "pyth_errors_total", "counter", "errors by \\ code\nand sym" );
+  std::string lbl;
+  metrics_wtr::add_label( lbl, "code", "-32005" );
+  PC_TEST_CHECK( lbl == "code=\"-32005\"" );
+  metrics_wtr::add_label( lbl, "symbol", "A\"B\\C\nD" );
+  mw.add_sample( "pyth_errors_total", lbl, (int64_t)-3L );
+  mw.add_sample( "pyth_landing_rate", str(), 0.25 );
+  std::string txt;
+  mw.copy_to( txt );
+  PC_TEST_CHECK( txt ==
+    "# HELP pyth_slot latest slot\n"
+    "# TYPE pyth_slot gauge\n"
+    "pyth_slot 42\n"
+    "# HELP pyth_errors_total errors by \\\\ code\\nand sym\n"
+    "# TYPE pyth_errors_total counter\n"
+    "pyth_errors_total{code=\"-32005\",symbol=\"A\\\"B\\\\C\\nD\"} -3\n"
+    "pyth_landing_rate 0.25\n" );
+
+  // summaries have a sample per quantile and the sum and count in
+  // seconds with the labels of the summary
+  lat_hist h;
+  h.add( 2000000L );
+  h.add( 4000000L );
+  metrics_wtr sw;
+  sw.add_summary( "pyth_rtt_seconds", "method=\"getSlot\"", h );
+  sw.add_summary( "pyth_gap_seconds", str(), h );
+  txt.clear();
+  sw.copy_to( txt );
+  std::vector<std::string> lines;
+  for( size_t i = 0, j; ( j = txt.find( '\n', i ) ) != std::string::npos;
+       i = j + 1 ) {
+    lines.push_back( txt.substr( i, j - i ) );
+  }
+  PC_TEST_CHECK( lines.size() == 12 );
+  static const char *const qtxt[] = { "0.5", "0.9", "0.99", "0.999" };
+  bool is_ok = lines.size() == 12;
+  for( unsigned i = 0; is_ok && i != 4; ++i ) {
+    is_ok = lines[i].find( std::string( "pyth_rtt_seconds{method=\"getSlot\","
+        "quantile=\"" ) + qtxt[i] + "\"} " ) == 0 &&
+      lines[6+i].find( std::string( "pyth_gap_seconds{quantile=\"" ) +
+        qtxt[i] + "\"} " ) == 0;
+  }
+  PC_TEST_CHECK( is_ok );
+  PC_TEST_CHECK( lines[4] == "pyth_rtt_seconds_sum{method=\"getSlot\"} 0.006" );
+  PC_TEST_CHECK( lines[5] == "pyth_rtt_seconds_count{method=\"getSlot\"} 2" );
+  PC_TEST_CHECK( lines[10] == "pyth_gap_seconds_sum 0.006" );
+  PC_TEST_CHECK( lines[11] == "pyth_gap_seconds_count 2" );
+}
+
+void test_upd_queue()
+{
+  // updates cross threads in order per price. a slow consumer pops the
+  // latest update of every price
+  static upd_queue q;
+  const int64_t num_upd = 102400;
+  const unsigned num_px = 64;
+  auto get_acc = []( unsigned i ) {
+    pub_key acc;
+    acc.zero();
+    __builtin_memcpy( (void*)acc.data(), &i, sizeof( i ) );
+    return acc;
+  };
+  std::thread thrd( [&]() {
+    for( int64_t i = 0; i != num_upd; ++i ) {
+      q.push( get_acc( (unsigned)i % num_px ), i, (uint64_t)i,
+              symbol_status::e_trading );
+    }
+  } );
+  std::vector<int64_t> last( num_px, -1L );
+  upd_queue::upd upd;
+  bool is_ok = true;
+  auto check = [&]() {
+    unsigned idx;
+    __builtin_memcpy( &idx, upd.acc_.data(), sizeof( idx ) );
+    if ( idx >= num_px ) {
+      is_ok = false;
+      return;
+    }
+    is_ok = is_ok && upd.price_ > last[idx] &&
+      upd.conf_ == (uint64_t)upd.price_ &&
+      (unsigned)upd.price_ % num_px == idx;
+    last[idx] = upd.price_;
+  };
+  while( last[( num_upd - 1 ) % num_px] != num_upd - 1 ) {
+    if ( q.pop( upd ) ) {
+      check();
+    }
+  }
+  thrd.join();
+  while( q.pop( upd ) ) {
+    check();
+  }
+  PC_TEST_CHECK( is_ok );
+  for( unsigned i = 0; i != num_px; ++i ) {
+    is_ok = is_ok && last[i] == num_upd - num_px + i;
+  }
+  PC_TEST_CHECK( is_ok );
+  PC_TEST_CHECK( q.get_num_drop() == 0 );
+  PC_TEST_CHECK( q.size() == 0 );
+}
+
+void test_upd_queue_full()
+{
+  // a producer pushing many times the queue length is conflated to the
+  // latest update of each price instead of losing the newest updates
+  static upd_queue q;
+  const unsigned num_round = 10;
+  auto get_acc = []( unsigned i ) {
+    pub_key acc;
+    acc.zero();
+    __builtin_memcpy( (void*)acc.data(), &i, sizeof( i ) );
+    return acc;
+  };
+  bool is_push = true;
+  std::thread thrd( [&]() {
+    for( unsigned r = 0; r != num_round; ++r ) {
+      for( unsigned i = 0; i != upd_queue::max_upd; ++i ) {
+        int64_t px = (int64_t)( r * upd_queue::max_upd + i );
+        is_push = q.push( get_acc( i ), px, 1UL, symbol_status::e_trading )
+          && is_push;
+      }
+    }
+  } );
+  thrd.join();
+  PC_TEST_CHECK( is_push );
+  PC_TEST_CHECK( q.size() == upd_queue::max_upd );
+  upd_queue::upd upd;
+  bool is_ok = true;
+  unsigned num = 0;
+  for( ; q.pop( upd ); ++num ) {
+    is_ok = is_ok && upd.acc_ == get_acc( num ) &&
+      upd.price_ == (int64_t)( ( num_round - 1 ) * upd_queue::max_upd + num );
+  }
+  PC_TEST_CHECK( is_ok );
+  PC_TEST_CHECK( num == upd_queue::max_upd );
+
+  // a known price is queued again. one too many is dropped
+  PC_TEST_CHECK( q.push( get_acc( 7 ), 1L, 1UL, symbol_status::e_trading ) );
+  PC_TEST_CHECK( !q.push( get_acc( upd_queue::max_upd ), 1L, 1UL,
+                          symbol_status::e_trading ) );
+  PC_TEST_CHECK( q.get_num_drop() == 1 );
+  PC_TEST_CHECK( q.pop( upd ) && upd.acc_ == get_acc( 7 ) );
+  PC_TEST_CHECK( !q.pop( upd ) );
+}
+
+void test_snapshot()
+{
+  // accounts saved are mapped back on the next start
+  std::string file = "/tmp/test_unit." + std::to_string( getpid() ) + ".snap";
+  std::vector<uint64_t> buf( sizeof( pc_price_t ) / sizeof( uint64_t ) );
+  pc_price_t *pptr = (pc_price_t*)buf.data();
+  pptr->magic_ = PC_MAGIC;
+  pptr->type_ = PC_ACCTYPE_PRICE;
+  pptr->size_ = sizeof( pc_price_t ) - 3;
+  pptr->agg_.price_ = 42L;
+  pub_key acc, acc2;
+  acc.init_from_text( str( "9DrKsbtvqC5MmC3bvwYJRHcm7daVjWGd6bXPiRMi5Tzc" ) );
+  {
+    snapshot snap;
+    snap.set_file( file );
+    PC_TEST_CHECK( snap.init() );
+    PC_TEST_CHECK( snap.get_num() == 0 );
+    snap.add( (pc_pub_key_t*)acc.data(), (pc_acc_t*)pptr );
+    PC_TEST_CHECK( snap.save() );
+  }
+  snapshot snap;
+  snap.set_file( file );
+  PC_TEST_CHECK( snap.init() );
+  PC_TEST_CHECK( snap.get_num() == 1 );
+  size_t len = 0;
+  const pc_price_t *res = (const pc_price_t*)snap.get_account( acc, len );
+  PC_TEST_CHECK( res && len == pptr->size_ );
+  PC_TEST_CHECK( res && 0 == ( (uintptr_t)res & 7UL ) );
+  PC_TEST_CHECK( res && res->agg_.price_ == 42L );
+  PC_TEST_CHECK( !snap.get_account( acc2, len ) );
+  PC_TEST_CHECK( snap.get_account( 0U, acc2, len ) == (const pc_acc_t*)res );
+  PC_TEST_CHECK( acc2 == acc && len == pptr->size_ );
+  PC_TEST_CHECK( !snap.get_account( 1U, acc2, len ) );
+  ::unlink( file.c_str() );
+}
+
+struct test_trait
+{
+  static const size_t hsize_ = 307UL;
+  typedef uint32_t idx_t;
+  typedef uint64_t key_t;
+  typedef uint64_t keyref_t;
+  typedef uint64_t val_t;
+  struct hash_t {
+    idx_t operator() ( keyref_t k ) { return (idx_t)k; }
+  };
+};
+
+void test_open_hash_map()
+{
+  // entries survive growth and backward-shift deletion
+  open_hash_map<test_trait> hmap;
+  const uint64_t num = 10000;
+  for( uint64_t i = 0; i != num; ++i ) {
+    hmap.ref( hmap.add( i << 32 | i ) ) = i;
+  }
+  PC_TEST_CHECK( hmap.size() == num );
+  PC_TEST_CHECK( hmap.capacity() >= num );
+  bool is_ok = true;
+  for( uint64_t i = 0; i != num; ++i ) {
+    open_hash_map<test_trait>::iter_t it = hmap.find( i << 32 | i );
+    is_ok = is_ok && it && hmap.obj( it ) == i;
+  }
+  PC_TEST_CHECK( is_ok );
+  for( uint64_t i = 0; i < num; i += 2 ) {
+    hmap.del( hmap.find( i << 32 | i ) );
+  }
+  PC_TEST_CHECK( hmap.size() == num / 2 );
+  for( uint64_t i = 0; i != num; ++i ) {
+    open_hash_map<test_trait>::iter_t it = hmap.find( i << 32 | i );
+    is_ok = is_ok && ( i % 2 ? it && hmap.obj( it ) == i : !it );
+  }
+  PC_TEST_CHECK( is_ok );
+  hmap.clear();
+  PC_TEST_CHECK( hmap.size() == 0 );
+  PC_TEST_CHECK( !hmap.find( 1UL << 32 | 1UL ) );
+}
+
+void test_pythnet_account()
+{
+  // a pythnet price account is larger than pc_price_t and is kept,
+  // captured and saved whole without reading its neighbour's slot
+  const size_t len = ZSTD_UPPER_BOUND;
+  PC_TEST_CHECK( price_arena::slot_len >= len );
+  price_arena arena;
+  unsigned idx = arena.add();
+  char *nptr = (char*)arena.get_account( arena.add() );
+  __builtin_memset( nptr, 0x5a, price_arena::slot_len );
+  pc_price_t *pptr = arena.get_account( idx );
+  char *aptr = (char*)pptr;
+  for( size_t i = 0; i != len; ++i ) {
+    aptr[i] = (char)( i * 7 );
+  }
+  pptr->magic_ = PC_MAGIC;
+  pptr->type_  = PC_ACCTYPE_PRICE;
+  pptr->size_  = (uint32_t)len;
+  std::vector<char> exp[3];
+  pc_pub_key_t key[1];
+  __builtin_memset( key, 3, sizeof( key ) );
+  std::string pid = std::to_string( ::getpid() );
+  const char *sfx[] = { ".gz", ".zst" };
+  for( unsigned k = 0; k != 2; ++k ) {
+    std::string file = "/tmp/test_pythnet." + pid + sfx[k];
+    {
+      // the last two records are deltas of the first
+      capture cap;
+      cap.set_file( file );
+      cap.set_delta_interval( 10U );
+      PC_TEST_CHECK( cap.init() );
+      for( unsigned i = 0; i != 3; ++i ) {
+        aptr[len - 1 - i] = (char)i;
+        exp[i].assign( aptr, aptr + len );
+        cap.write( key, (pc_acc_t*)pptr );
+      }
+    }
+    replay rep;
+    rep.set_file( file );
+    PC_TEST_CHECK( rep.init() );
+    unsigned num = 0;
+    bool is_ok = true;
+    for( ; num != 3 && rep.get_next(); ++num ) {
+      const pc_acc_t *ptr = rep.get_update();
+      is_ok = is_ok && ptr->size_ == len &&
+        0 == __builtin_memcmp( ptr, exp[num].data(), len );
+    }
+    PC_TEST_CHECK( is_ok && num == 3 && !rep.get_next() );
+    PC_TEST_CHECK( !rep.get_is_err() );
+    ::unlink( file.c_str() );
+  }
+  std::string file = "/tmp/test_pythnet." + pid + ".snap";
+  {
+    snapshot snap;
+    snap.set_file( file );
+    PC_TEST_CHECK( snap.init() );
+    snap.add( key, (pc_acc_t*)pptr );
+    PC_TEST_CHECK( snap.save() );
+  }
+  snapshot snap;
+  snap.set_file( file );
+  PC_TEST_CHECK( snap.init() );
+  pub_key acc;
+  acc.init_from_buf( key->k1_ );
+  size_t slen = 0;
+  const pc_acc_t *res = snap.get_account( acc, slen );
+  PC_TEST_CHECK( res && slen == len &&
+                 0 == __builtin_memcmp( res, aptr, len ) );
+  ::unlink( file.c_str() );
+}
+
+void test_price_arena()
+{
+  // slots are aligned, zeroed and keep their address across blocks
+  price_arena arena;
+  const unsigned num = 3 * price_arena::block_num + 1;
+  std::vector<pc_price_t*> pvec;
+  for( unsigned i = 0; i != num; ++i ) {
+    PC_TEST_CHECK( arena.add() == i );
+    pvec.push_back( arena.get_account( i ) );
+    pvec.back()->agg_.price_ = (int64_t)i;
+    pvec.back()->agg_.pub_slot_ = i + 1UL;
+  }
+  PC_TEST_CHECK( arena.size() == num );
+  bool is_ok = true;
+  for( unsigned i = 0; i != num; ++i ) {
+    is_ok = is_ok && pvec[i] == arena.get_account( i );
+    is_ok = is_ok && 0 == ( (uintptr_t)pvec[i] & 63UL );
+    is_ok = is_ok && pvec[i]->num_ == 0U;
+    is_ok = is_ok && arena.get_price( i ) == 0L;
+    arena.update_agg( i );
+    is_ok = is_ok && arena.get_price( i ) == (int64_t)i;
+    is_ok = is_ok && arena.get_pub_slot( i ) == i + 1UL;
+  }
+  PC_TEST_CHECK( is_ok );
+}
+
+void test_huge_page()
+{
+  // small requests and all requests while disabled come from the heap
+  huge_page::set_enabled( false );
+  char *ptr = static_cast< char* >( huge_page::alloc( huge_page::fit_len ) );
+  PC_TEST_CHECK( 0 == ( (uintptr_t)ptr & 63UL ) );
+  PC_TEST_CHECK( huge_page::get_huge_len() + huge_page::get_thp_len() == 0UL );
+  ptr[0] = ptr[huge_page::fit_len-1] = 'x';
+  huge_page::dealloc( ptr );
+
+  // enabled requests map whole huge pages until released
+  huge_page::set_enabled( true );
+  ptr = static_cast< char* >( huge_page::alloc( huge_page::fit_len ) );
+  PC_TEST_CHECK( 0 == ( (uintptr_t)ptr & 63UL ) );
+  PC_TEST_CHECK( huge_page::get_huge_len() + huge_page::get_thp_len() ==
+                 huge_page::page_len );
+  ptr[0] = ptr[huge_page::fit_len-1] = 'x';
+  char *sml = static_cast< char* >( huge_page::alloc( 100 ) );
+  PC_TEST_CHECK( huge_page::get_huge_len() + huge_page::get_thp_len() ==
+                 huge_page::page_len );
+  huge_page::dealloc( sml );
+  huge_page::dealloc( ptr );
+  PC_TEST_CHECK( huge_page::get_huge_len() + huge_page::get_thp_len() == 0UL );
+
+  // containers grow across the threshold
+  std::vector<uint64_t, huge_allocator<uint64_t>> vec;
+  for( uint64_t i = 0; i != 1UL<<18; ++i ) {
+    vec.push_back( i );
+  }
+  PC_TEST_CHECK( vec[12345] == 12345UL && vec.back() == (1UL<<18) - 1UL );
+  huge_page::set_enabled( false );
+}
+
+void test_price_view()
+{
+  // views read the decoded account in place
+  pub_key acc;
+  product prod( acc );
+  price_arena arena;
+  price px( acc, &prod, &arena );
+  pc_price_t *aptr = arena.get_account( px.get_arena_index() );
+  aptr->expo_ = -5;
+  aptr->agg_.price_ = 12345L;
+  aptr->agg_.conf_ = 7UL;
+  aptr->agg_.status_ = PC_STATUS_TRADING;
+  aptr->twap_.val_ = 12000L;
+  aptr->num_ = 2;
+  aptr->comp_[1].agg_.price_ = 12346L;
+  price_view vw = px.get_view();
+  PC_TEST_CHECK( vw.ver_ == price_view::version && vw.px_ == &px );
+  PC_TEST_CHECK( vw.get_price_exponent() == px.get_price_exponent() );
+  PC_TEST_CHECK( vw.get_price() == px.get_price() &&
+                 vw.get_conf() == px.get_conf() );
+  PC_TEST_CHECK( vw.get_status() == symbol_status::e_trading );
+  PC_TEST_CHECK( vw.get_twap() == px.get_twap() );
+  PC_TEST_CHECK( vw.get_num_publisher() == 2 &&
+                 vw.get_publisher_price( 1 ) == px.get_publisher_price( 1 ) );
+  aptr->agg_.price_ = 12347L;
+  PC_TEST_CHECK( vw.get_price() == 12347L );
+}
+
+void test_aggregate()
+{
+  // local aggregation matches the on-chain median of the components and
+  // drops quotes that are too old for the slot
+  pc_price_t *px = new pc_price_t;
+  __builtin_memset( (void*)px, 0, sizeof( pc_price_t ) );
+  px->expo_ = -2;
+  px->num_  = 3;
+  for( unsigned i = 0; i != px->num_; ++i ) {
+    pc_price_info_t& lt = px->comp_[i].latest_;
+    lt.price_    = 100L + 10L * (int64_t)i;
+    lt.conf_     = 2UL;
+    lt.status_   = PC_STATUS_TRADING;
+    lt.pub_slot_ = 10UL + i;
+  }
+  PC_TEST_CHECK( aggregate_price( px, 13UL, 0L ) );
+  PC_TEST_CHECK( px->agg_.price_ == 110L );
+  PC_TEST_CHECK( px->agg_.status_ == PC_STATUS_TRADING );
+  PC_TEST_CHECK( px->agg_.pub_slot_ == 13UL );
+  PC_TEST_CHECK( px->num_qt_ == 3U );
+  PC_TEST_CHECK( aggregate_price( px, 11UL + PC_MAX_SEND_LATENCY, 0L ) );
+  PC_TEST_CHECK( px->num_qt_ == 2U );
+  px->min_pub_ = 3;
+  PC_TEST_CHECK( !aggregate_price( px, 11UL + PC_MAX_SEND_LATENCY, 0L ) );
+  PC_TEST_CHECK( px->agg_.status_ == PC_STATUS_UNKNOWN );
+  delete px;
+}
+
+void test_send_ref()
+{
+  // buffers shared by two send queues outlive their owner and both
+  // connections receive the same bytes
+  net_wtr body;
+  std::string txt( 3000, 'x' );
+  body.add( str( txt ) );
+  net_buf *hd, *tl;
+  body.detach( hd, tl );
+  int fd[2][2];
+  net_connect conn[2];
+  for( unsigned i = 0; i != 2; ++i ) {
+    PC_TEST_CHECK( 0 == ::socketpair( AF_UNIX, SOCK_STREAM, 0, fd[i] ) );
+    conn[i].set_fd( fd[i][0] );
+    conn[i].add_send_ref( hd );
+  }
+  while( hd ) {
+    net_buf *nxt = hd->next_;
+    hd->dealloc();
+    hd = nxt;
+  }
+  for( unsigned i = 0; i != 2; ++i ) {
+    PC_TEST_CHECK( conn[i].get_send_size() == txt.size() );
+    conn[i].poll_send();
+    PC_TEST_CHECK( !conn[i].get_is_send() );
+    PC_TEST_CHECK( conn[i].get_send_size() == 0 );
+    std::string res( txt.size() + 1, '\0' );
+    size_t len = 0;
+    while( len < txt.size() ) {
+      ssize_t rc = ::read( fd[i][1], &res[len], res.size() - len );
+      if ( rc <= 0 ) break;
+      len += static_cast< size_t >( rc );
+    }
+    res.resize( len );
+    PC_TEST_CHECK( res == txt );
+    conn[i].close();
+    ::close( fd[i][1] );
+  }
+}
+
+void test_shm_feed()
+{
+  // reader sees the populated region of every written slot
+  std::string file = "/tmp/test_shm_feed." + std::to_string( ::getpid() );
+  shm_feed feed;
+  feed.set_file( file );
+  feed.set_max_num( 4 );
+  PC_TEST_CHECK( feed.init() );
+  shm_reader rdr;
+  PC_TEST_CHECK( rdr.init( file.c_str() ) );
+  PC_TEST_CHECK( rdr.get_num() == 0 );
+  pub_key acc[2];
+  std::string ktxt[2] = {
+    "9u1ku8tu4zPCXHPHFdFDWPqBkY3bAsNv4A84j9eM1BbA",
+    "CrZGAfykHsVi9Sca31ChqUkoxMPeXH8c8vJMhBoFo8D1" };
+  acc[0].init_from_text( ktxt[0] );
+  acc[1].init_from_text( ktxt[1] );
+  pc_price_t px[1];
+  __builtin_memset( px, 0, sizeof( px ) );
+  px->num_ = 2;
+  px->agg_.price_ = 12345L;
+  px->comp_[1].agg_.conf_ = 7UL;
+  feed.update( 1, acc[1], px );
+  px->agg_.price_ = 678L;
+  feed.update( 0, acc[0], px );
+  feed.update( 4, acc[0], px );
+  PC_TEST_CHECK( rdr.get_num() == 2 );
+  PC_TEST_CHECK( rdr.find( *(pc_pub_key_t*)acc[1].data() ) == 1 );
+  pc_pub_key_t key[1];
+  pc_price_t res[1];
+  PC_TEST_CHECK( rdr.get( 1, *key, *res ) );
+  PC_TEST_CHECK( pc_pub_key_equal( key, (pc_pub_key_t*)acc[1].data() ) );
+  PC_TEST_CHECK( res->agg_.price_ == 12345L );
+  PC_TEST_CHECK( res->num_ == 2 && res->comp_[1].agg_.conf_ == 7UL );
+  PC_TEST_CHECK( rdr.get_seq( 0 ) == 2UL );
+  ::unlink( file.c_str() );
+}
+
+void test_mcast_pub()
+{
+  // changed prices are split across sequenced packets that are kept for
+  // retransmission. heartbeats repeat the last sequence number
+  int fd = ::socket( AF_INET, SOCK_DGRAM, 0 );
+  sockaddr_in sa[1];
+  socklen_t slen = sizeof( sa );
+  __builtin_memset( sa, 0, sizeof( sa ) );
+  sa->sin_family = AF_INET;
+  sa->sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+  PC_TEST_CHECK( 0 == ::bind( fd, (sockaddr*)sa, sizeof( sa ) ) );
+  PC_TEST_CHECK( 0 == ::getsockname( fd, (sockaddr*)sa, &slen ) );
+  mcast_pub pub;
+  pub.set_addr( "127.0.0.1:" + std::to_string( ntohs( sa->sin_port ) ) );
+  pub.set_hist( 2 );
+  PC_TEST_CHECK( pub.init() );
+  pub_key acc;
+  product prod( acc );
+  price_arena arena;
+  std::vector<price*> pvec;
+  for( unsigned i = 0; i != mcast_max_rec + 4; ++i ) {
+    pvec.push_back( new price( acc, &prod, &arena ) );
+    arena.get_account( i )->agg_.price_ = (int64_t)i;
+  }
+  pub.publish( pvec, 42UL );
+  pub.publish( pvec, 43UL );
+  PC_TEST_CHECK( pub.get_seq() == 4UL );
+  PC_TEST_CHECK( pub.get_packet( 2UL ) == nullptr );
+  const mcast_hdr *hdr = pub.get_packet( 3UL );
+  PC_TEST_CHECK( hdr && hdr->slot_ == 43UL && hdr->num_ == mcast_max_rec );
+  PC_TEST_CHECK( hdr && hdr->flags_ == 0 );
+  hdr = pub.get_packet( 4UL );
+  PC_TEST_CHECK( hdr && hdr->num_ == 4 && hdr->flags_ == mcast_flag_last );
+  char buf[mcast_max_pkt];
+  uint64_t seq = 0;
+  bool is_ok = true;
+  for( unsigned i = 0; i != 4; ++i ) {
+    ssize_t len = ::recv( fd, buf, sizeof( buf ), 0 );
+    const mcast_hdr *rhdr = (const mcast_hdr*)buf;
+    is_ok = is_ok && len == (ssize_t)( sizeof( mcast_hdr ) +
+                                       rhdr->num_ * sizeof( mcast_rec ) );
+    is_ok = is_ok && rhdr->magic_ == mcast_magic && rhdr->seq_ == ++seq;
+    const mcast_rec *rec = mcast_pub::get_recs( rhdr );
+    int64_t px;
+    __builtin_memcpy( &px, &rec[rhdr->num_ - 1].price_, sizeof( px ) );
+    is_ok = is_ok && px == ( i & 1 ? (int64_t)mcast_max_rec + 3 :
+                                     (int64_t)mcast_max_rec - 1 );
+  }
+  PC_TEST_CHECK( is_ok );
+  pub.poll( 1L );
+  pub.poll( 2L );
+  pub.poll( 2L + PC_NSECS_IN_SEC );
+  mcast_hdr hb;
+  PC_TEST_CHECK( ::recv( fd, &hb, sizeof( hb ), 0 ) == sizeof( hb ) );
+  PC_TEST_CHECK( hb.seq_ == 4UL && hb.num_ == 0 && hb.slot_ == 43UL );
+  for( price *ptr: pvec ) {
+    delete ptr;
+  }
+  ::close( fd );
+}
+
+void test_product_json()
+{
+  // cached product list entries match the entries rendered in full and
+  // follow changes to the price accounts
+  pub_key acc;
+  product prod( acc );
+  char buf[256];
+  pc_prod_t *aptr = (pc_prod_t*)buf;
+  __builtin_memset( buf, 0, sizeof( buf ) );
+  char *ptr = &buf[sizeof( pc_prod_t )];
+  const char attr[] = "\006symbol\007BTC/USD\012asset_type\006Crypto";
+  __builtin_memcpy( ptr, attr, sizeof( attr ) - 1 );
+  aptr->size_ = (uint32_t)( sizeof( pc_prod_t ) + sizeof( attr ) - 1 );
+  PC_TEST_CHECK( prod.init_from_account( aptr ) );
+  price_arena arena;
+  prod.add_price( new price( acc, &prod, &arena ) );
+  prod.add_price( new price( acc, &prod, &arena ) );
+  std::string res;
+  for( unsigned k = 0; k != 2; ++k ) {
+    json_wtr wtr;
+    wtr.add_val( json_wtr::e_obj );
+    wtr.add_key( "account", prod.get_account_text() );
+    wtr.add_key( "attr_dict", json_wtr::e_obj );
+    prod.write_json( wtr );
+    wtr.pop();
+    wtr.add_key( "price", json_wtr::e_arr );
+    for( unsigned j = 0; j != prod.get_num_price(); ++j ) {
+      price *px = prod.get_price( j );
+      wtr.add_val( json_wtr::e_obj );
+      wtr.add_key( "account", px->get_account_text() );
+      wtr.add_key( "price_exponent", px->get_price_exponent() );
+      wtr.add_key( "price_type", price_type_to_str( px->get_price_type() ) );
+      wtr.pop();
+    }
+    wtr.pop();
+    wtr.pop();
+    res.clear();
+    wtr.copy_to( res );
+    PC_TEST_CHECK( prod.get_list_json() == str( res ) );
+    arena.get_account( 1 )->expo_ = -8;
+  }
+  PC_TEST_CHECK( res.find( "-8" ) != std::string::npos );
+}
+
+void test_attr_dict()
+{
+  // values shared across dictionaries are stored once and read back
+  // unchanged through iteration and account serialization
+  char buf[2][256];
+  attr_dict dict[2];
+  const char attr[] = "\006symbol\007BTC/USD\012asset_type\006Crypto";
+  for( unsigned k = 0; k != 2; ++k ) {
+    pc_prod_t *aptr = (pc_prod_t*)buf[k];
+    __builtin_memset( buf[k], 0, sizeof( buf[k] ) );
+    __builtin_memcpy( &buf[k][sizeof( pc_prod_t )], attr, sizeof( attr ) - 1 );
+    aptr->size_ = (uint32_t)( sizeof( pc_prod_t ) + sizeof( attr ) - 1 );
+    PC_TEST_CHECK( dict[k].init_from_account( aptr ) );
+  }
+  unsigned num_val = attr_val_set::inst().get_num_val();
+  str v0, v1;
+  PC_TEST_CHECK( dict[0].get_attr( attr_id( "symbol" ), v0 ) );
+  PC_TEST_CHECK( dict[1].get_attr( attr_id( "symbol" ), v1 ) );
+  PC_TEST_CHECK( v0 == str( "BTC/USD" ) && v0.str_ == v1.str_ );
+  PC_TEST_CHECK( !dict[0].get_attr( attr_id( "quote_currency" ), v0 ) );
+  unsigned num = 0;
+  for( attr_id id; dict[1].get_next_attr( id, v1 ); ++num );
+  PC_TEST_CHECK( num == 2 && dict[1].get_num_attr() == 2 );
+  net_wtr wtr;
+  dict[0].write_account( wtr );
+  std::string res;
+  wtr.copy_to( res );
+  PC_TEST_CHECK( res == std::string( attr, sizeof( attr ) - 1 ) );
+  PC_TEST_CHECK( attr_val_set::inst().get_num_val() == num_val );
+}
+
+void test_dash_notify()
+{
+  // the first delta of a price carries its account and all fields and
+  // later ones only the fields that changed
+  pub_key acc;
+  product prod( acc );
+  price_arena arena;
+  price *px = new price( acc, &prod, &arena );
+  prod.add_price( px );
+  dash_notify dnot;
+  dash_notify::price_vec_t pvec( 1, px );
+  std::string res;
+  size_t len = 0;
+  for( unsigned k = 0; k != 3; ++k ) {
+    bool is_chg = dnot.update( pvec, 10UL + k );
+    net_buf *body = dnot.get( len );
+    PC_TEST_CHECK( is_chg == ( k != 1 ) && is_chg == ( body != nullptr ) );
+    res.clear();
+    for( net_buf *ptr = body; ptr; ptr = ptr->next_ ) {
+      res.append( ptr->get_data(), ptr->size_ );
+    }
+    PC_TEST_CHECK( res.size() == len );
+    if ( k == 0 ) {
+      PC_TEST_CHECK( res.find( "\"account\"" ) != std::string::npos );
+      PC_TEST_CHECK( res.find( "\"pub_slot\"" ) != std::string::npos );
+    }
+    arena.get_account( px->get_arena_index() )->agg_.price_ = (int64_t)k;
+  }
+  PC_TEST_CHECK( res.find( "\"account\"" ) == std::string::npos );
+  PC_TEST_CHECK( res.find( "\"price\":1}" ) != std::string::npos );
+  PC_TEST_CHECK( res.find( "\"conf\"" ) == std::string::npos );
+  PC_TEST_CHECK( res.find( "\"subscription\":" ) == res.size() - 15 );
+  json_wtr wtr;
+  wtr.add_val( json_wtr::e_obj );
+  dnot.write_snapshot( wtr );
+  wtr.pop();
+  res.clear();
+  wtr.copy_to( res );
+  PC_TEST_CHECK( res.find( "\"conf\":0" ) != std::string::npos );
+  PC_TEST_CHECK( res.find( "\"slot\":12" ) != std::string::npos );
+}
+
+void test_cap_filter()
+{
+  // first matching term sets the sample rate of a price and prices
+  // matching none are not captured
+  pub_key acc;
+  product prod( acc );
+  char buf[256];
+  pc_prod_t *aptr = (pc_prod_t*)buf;
+  __builtin_memset( buf, 0, sizeof( buf ) );
+  const char attr[] = "\006symbol\007BTC/USD";
+  __builtin_memcpy( &buf[sizeof( pc_prod_t )], attr, sizeof( attr ) - 1 );
+  aptr->size_ = (uint32_t)( sizeof( pc_prod_t ) + sizeof( attr ) - 1 );
+  PC_TEST_CHECK( prod.init_from_account( aptr ) );
+  key_pair kp;
+  kp.gen();
+  pub_key acc2( kp );
+  std::string acc2_txt;
+  acc2.enc_base58( acc2_txt );
+  price_arena arena;
+  price *p1 = new price( acc, &prod, &arena );
+  price *p2 = new price( acc2, &prod, &arena );
+  prod.add_price( p1 );
+  prod.add_price( p2 );
+  cap_filter flt;
+  PC_TEST_CHECK( flt.get_is_capture( p1 ) && flt.get_is_capture( p2 ) );
+  PC_TEST_CHECK( !flt.add_term( "symbol=BTC/USD@" ) );
+  PC_TEST_CHECK( !flt.add_term( "=BTC/USD" ) );
+  PC_TEST_CHECK( !flt.add_term( "not_an_account" ) );
+  PC_TEST_CHECK( flt.add_term( acc2_txt + "@0" ) );
+  PC_TEST_CHECK( flt.add_term( "symbol=BTC/USD@3" ) );
+  PC_TEST_CHECK( flt.add_term( "symbol=ETH/USD" ) );
+  PC_TEST_CHECK( flt.get_num_term() == 3 );
+  unsigned num1 = 0, num2 = 0;
+  for( unsigned k = 0; k != 6; ++k ) {
+    num1 += flt.get_is_capture( p1 );
+    num2 += flt.get_is_capture( p2 );
+  }
+  PC_TEST_CHECK( num1 == 2 && num2 == 0 );
+  PC_TEST_CHECK( flt.get_num_skip() == 10 );
+  flt.set_is_full( true );
+  PC_TEST_CHECK( flt.get_is_capture( p1 ) && flt.get_is_capture( p2 ) );
+  flt.set_is_paused( true );
+  PC_TEST_CHECK( !flt.get_is_capture( p1 ) && !flt.get_is_capture( p2 ) );
+  flt.set_is_paused( false );
+  flt.set_is_full( false );
+  flt.clear();
+  PC_TEST_CHECK( flt.get_is_capture( p2 ) );
+}
+
+void test_capture()
+{
+  // captures read back in the format they were written in. the last
+  // two are written as deltas with 10 records between full accounts
+  const char *sfx[] = { ".gz", ".zst", ".zst", ".gz", ".zst" };
+  for( unsigned k = 0; k != 5; ++k ) {
+    std::string file = "/tmp/test_capture." +
+      std::to_string( ::getpid() ) + sfx[k];
+    pc_price_t px[1];
+    __builtin_memset( px, 0, sizeof( px ) );
+    px->magic_ = PC_MAGIC;
+    px->type_  = PC_ACCTYPE_PRICE;
+    px->size_  = sizeof( pc_price_t );
+    pc_pub_key_t key[1];
+    __builtin_memset( key, 7, sizeof( key ) );
+    {
+      capture cap;
+      cap.set_file( file );
+      cap.set_zstd_threads( k == 2 ? 2U : 0U );
+      cap.set_delta_interval( k > 2 ? 10U : 0U );
+      PC_TEST_CHECK( cap.init() );
+      for( int64_t i = 0; i != 10000; ++i ) {
+        px->agg_.price_ = i;
+        px->comp_[i % PC_NUM_COMP].agg_.conf_ = (uint64_t)i;
+        key->k1_[0] = (uint8_t)( i % 3 );
+        cap.write( key, (pc_acc_t*)px );
+        if ( i % 100 == 0 ) {
+          cap.flush();
+        }
+      }
+    }
+    replay rep;
+    rep.set_file( file );
+    PC_TEST_CHECK( rep.init() );
+    int64_t num = 0;
+    bool is_ok = true;
+    __builtin_memset( px->comp_, 0, sizeof( px->comp_ ) );
+    while( rep.get_next() ) {
+      pc_price_t *ptr = (pc_price_t*)rep.get_update();
+      px->agg_.price_ = num;
+      px->comp_[num % PC_NUM_COMP].agg_.conf_ = (uint64_t)num;
+      key->k1_[0] = (uint8_t)( num++ % 3 );
+      is_ok = is_ok && rep.get_update()->size_ == sizeof( pc_price_t );
+      is_ok = is_ok && 0 == __builtin_memcmp( ptr, px, sizeof( pc_price_t ) );
+      is_ok = is_ok && pc_pub_key_equal( rep.get_account(), key );
+    }
+    PC_TEST_CHECK( is_ok && num == 10000 && !rep.get_is_err() );
+    ::unlink( file.c_str() );
+  }
+}
+
+void test_capture_blocks()
+{
+  // block capture of 100 records per slot with a rare fourth account
+  std::string file = "/tmp/test_capture." +
+    std::to_string( ::getpid() ) + ".pcb";
+  pc_price_t px[1];
+  __builtin_memset( px, 0, sizeof( px ) );
+  px->magic_ = PC_MAGIC;
+  px->type_  = PC_ACCTYPE_PRICE;
+  px->size_  = sizeof( pc_price_t );
+  pc_pub_key_t key[1];
+  __builtin_memset( key, 7, sizeof( key ) );
+  {
+    capture cap;
+    cap.set_file( file );
+    cap.set_block_size( 64*1024 );
+    cap.set_delta_interval( 10U );
+    PC_TEST_CHECK( cap.init() );
+    for( int64_t i = 0; i != 10000; ++i ) {
+      if ( i % 100 == 0 ) {
+        cap.flush();
+        cap.set_slot( (uint64_t)( i / 100 ) );
+      }
+      px->agg_.price_ = i;
+      key->k1_[0] = (uint8_t)( i % 1000 == 0 ? 3 : i % 3 );
+      cap.write( key, (pc_acc_t*)px );
+    }
+  }
+  replay rep;
+  rep.set_file( file );
+  PC_TEST_CHECK( rep.init() );
+  std::vector<int64_t> tvec;
+  bool is_ok = true;
+  while( rep.get_next() ) {
+    int64_t num = (int64_t)tvec.size();
+    pc_price_t *ptr = (pc_price_t*)rep.get_update();
+    is_ok = is_ok && ptr->agg_.price_ == num;
+    is_ok = is_ok && rep.get_slot() == (uint64_t)( num / 100 );
+    tvec.push_back( rep.get_time() );
+  }
+  PC_TEST_CHECK( is_ok && tvec.size() == 10000 && !rep.get_is_err() );
+
+  // seek by slot and time
+  PC_TEST_CHECK( rep.seek_slot( 50UL ) );
+  PC_TEST_CHECK( rep.get_next() );
+  PC_TEST_CHECK( rep.get_slot() == 50UL &&
+                 ((pc_price_t*)rep.get_update())->agg_.price_ == 5000 );
+  PC_TEST_CHECK( rep.seek_time( tvec[7000] ) );
+  PC_TEST_CHECK( rep.get_next() );
+  int64_t pos = ((pc_price_t*)rep.get_update())->agg_.price_;
+  PC_TEST_CHECK( tvec[(size_t)pos] == tvec[7000] && pos <= 7000 );
+
+  // single account
+  key->k1_[0] = 3;
+  rep.set_account( key );
+  int64_t num = 0;
+  while( rep.get_next() ) {
+    is_ok = is_ok && pc_pub_key_equal( rep.get_account(), key ) &&
+      ((pc_price_t*)rep.get_update())->agg_.price_ == 1000 * num++;
+  }
+  PC_TEST_CHECK( is_ok && num == 10 );
+  rep.set_account( key );
+  PC_TEST_CHECK( rep.seek_slot( 42UL ) );
+  PC_TEST_CHECK( rep.get_next() );
+  PC_TEST_CHECK( ((pc_price_t*)rep.get_update())->agg_.price_ == 5000 );
+
+  // same captures decompressed ahead on threads
+  replay trep;
+  trep.set_file( file );
+  trep.set_threads( 3U );
+  PC_TEST_CHECK( trep.init() );
+  num = 0;
+  while( trep.get_next() ) {
+    is_ok = is_ok && tvec[(size_t)num] == trep.get_time() &&
+      ((pc_price_t*)trep.get_update())->agg_.price_ == num;
+    ++num;
+  }
+  PC_TEST_CHECK( is_ok && num == 10000 && !trep.get_is_err() );
+  trep.set_account( key );
+  PC_TEST_CHECK( trep.seek_slot( 42UL ) );
+  num = 0;
+  while( trep.get_next() ) {
+    is_ok = is_ok &&
+      ((pc_price_t*)trep.get_update())->agg_.price_ == 5000 + 1000 * num++;
+  }
+  PC_TEST_CHECK( is_ok && num == 5 );
+  ::unlink( file.c_str() );
+}
+
+void test_capture_rotate()
+{
+  // size rotation of delta captures, the first with a queue short enough
+  // to drop. every rotated file replays on its own and no record is lost
+  // without being counted
+  const char *sfx[] = { ".gz", ".zst", ".pcb" };
+  for( unsigned k = 0; k != 3; ++k ) {
+    std::string dir = "/tmp/test_rotate." + std::to_string( ::getpid() );
+    PC_TEST_CHECK( 0 == ::mkdir( dir.c_str(), 0755 ) );
+    pc_price_t px[1];
+    __builtin_memset( px, 0, sizeof( px ) );
+    px->magic_ = PC_MAGIC;
+    px->type_  = PC_ACCTYPE_PRICE;
+    px->size_  = sizeof( pc_price_t );
+    pc_pub_key_t key[1];
+    __builtin_memset( key, 7, sizeof( key ) );
+    uint64_t num_drop = 0;
+    {
+      capture cap;
+      cap.set_file( dir + "/cap" + sfx[k] );
+      cap.set_delta_interval( 10U );
+      cap.set_rotate_size( 16*1024 );
+      cap.set_sync_interval( 1U );
+      cap.set_max_pending( k == 0 ? 2U : 0U );
+      PC_TEST_CHECK( cap.init() );
+      for( int64_t i = 0; i != 20000; ++i ) {
+        px->agg_.price_ = i;
+        px->comp_[i % PC_NUM_COMP].agg_.conf_ = (uint64_t)i;
+        key->k1_[0] = (uint8_t)( i % 3 );
+        cap.write( key, (pc_acc_t*)px );
+        if ( i % 100 == 0 ) {
+          cap.flush();
+        }
+      }
+      cap.flush();
+      num_drop = cap.get_num_dropped();
+    }
+    DIR *dptr = ::opendir( dir.c_str() );
+    PC_TEST_CHECK( dptr );
+    std::vector<std::string> files;
+    for( struct dirent *ent; ( ent = ::readdir( dptr ) ); ) {
+      if ( ent->d_name[0] != '.' ) {
+        files.push_back( dir + "/" + ent->d_name );
+      }
+    }
+    ::closedir( dptr );
+    int64_t num = 0;
+    bool is_ok = files.size() > ( k == 0 ? 0U : 1U );
+    for( const std::string& file: files ) {
+      replay rep;
+      rep.set_file( file );
+      is_ok = is_ok && rep.init();
+      while( rep.get_next() ) {
+        pc_price_t *ptr = (pc_price_t*)rep.get_update();
+        is_ok = is_ok && ptr->comp_[ptr->agg_.price_ % PC_NUM_COMP].agg_.conf_
+          == (uint64_t)ptr->agg_.price_;
+        ++num;
+      }
+      is_ok = is_ok && !rep.get_is_err();
+      ::unlink( file.c_str() );
+    }
+    PC_TEST_CHECK( is_ok && (uint64_t)num + num_drop == 20000 );
+    ::rmdir( dir.c_str() );
+  }
+}
+
+void test_col_file()
+{
+  std::string file = "/tmp/test_col." + std::to_string( ::getpid() );
+  const char *sym[] = { "BTC/USD", "ETH/USD", "SOL/USD" };
+  {
+    col_writer wtr;
+    wtr.set_file( file );
+    wtr.set_group_rows( 1000 );
+    unsigned tbl = wtr.add_table( "price" );
+    wtr.add_column( tbl, "time", e_col_delta );
+    wtr.add_column( tbl, "symbol", e_col_dict );
+    unsigned etbl = wtr.add_table( "empty" );
+    wtr.add_column( etbl, "val", e_col_delta );
+    PC_TEST_CHECK( wtr.init() );
+    for( int64_t i = 0; i != 2500; ++i ) {
+      wtr.set( tbl, 0, i % 7 == 0 ? -i * 1000 : i * 1000 );
+      wtr.set( tbl, 1, wtr.get_dict_id( tbl, 1, str( sym[i % 3] ) ) );
+      wtr.add_row( tbl );
+    }
+    PC_TEST_CHECK( wtr.close() );
+  }
+  col_reader rdr;
+  rdr.set_file( file );
+  PC_TEST_CHECK( rdr.init() );
+  PC_TEST_CHECK( rdr.get_num_tables() == 2 );
+  unsigned tbl = rdr.get_table( "price" );
+  PC_TEST_CHECK( tbl == 0 && rdr.get_num_rows( tbl ) == 2500 );
+  PC_TEST_CHECK( rdr.get_column( tbl, "symbol" ) == 1 );
+  PC_TEST_CHECK( rdr.get_num_rows( rdr.get_table( "empty" ) ) == 0 );
+  std::vector<int64_t> tvec, svec;
+  PC_TEST_CHECK( rdr.get_values( tbl, 0, tvec ) );
+  PC_TEST_CHECK( rdr.get_values( tbl, 1, svec ) );
+  const std::vector<std::string>& dict = rdr.get_dict( tbl, 1 );
+  bool is_ok = tvec.size() == 2500 && svec.size() == 2500 && dict.size() == 3;
+  for( int64_t i = 0; is_ok && i != 2500; ++i ) {
+    is_ok = tvec[(size_t)i] == ( i % 7 == 0 ? -i * 1000 : i * 1000 ) &&
+            dict[(size_t)svec[(size_t)i]] == sym[i % 3];
+  }
+  PC_TEST_CHECK( is_ok );
+  ::unlink( file.c_str() );
+}
+
+void test_upd_trace()
+{
+  std::string file = "/tmp/test_trace." + std::to_string( ::getpid() );
+  uint8_t raw[signature::len];
+  __builtin_memset( raw, 7, sizeof( raw ) );
+  signature sig;
+  sig.init_from_buf( raw );
+  {
+    upd_trace trc;
+    trc.set_file( file );
+    trc.set_sample( 2 );
+    PC_TEST_CHECK( trc.init() );
+
+    // every other update is sampled
+    PC_TEST_CHECK( trc.add_recv( "BTC/USD", 100L, 200L ) == 0UL );
+    uint64_t id = trc.add_recv( "BTC/USD", 100L, 200L );
+    PC_TEST_CHECK( id != 0UL && trc.get_is_live( id ) );
+    trc.add_send( id, 300L );
+    trc.add_sent( id, &sig, 10UL, 400L );
+    trc.add_ack( raw, 500L );
+
+    // complete once the aggregate of the publish slot is seen
+    trc.add_agg( id, 9UL, 600L );
+    PC_TEST_CHECK( trc.get_is_live( id ) );
+    trc.add_agg( id, 10UL, 700L );
+    PC_TEST_CHECK( !trc.get_is_live( id ) && trc.get_num_spans() == 1 );
+
+    // in-flight spans are written incomplete on close
+    trc.add_recv( "ETH/USD", 0L, 800L );
+    uint64_t id2 = trc.add_recv( "ETH/USD", 0L, 800L );
+    PC_TEST_CHECK( trc.close() && trc.get_num_spans() == 2 );
+    PC_TEST_CHECK( !trc.get_is_live( id2 ) );
+  }
+
+  // process name, update with four stages and ack, update with parse
+  mem_map mf;
+  mf.set_file( file );
+  PC_TEST_CHECK( mf.init() );
+  jtree jt;
+  jt.parse( mf.data(), mf.size() );
+  PC_TEST_CHECK( jt.is_valid() && jt.get_type( 1 ) == jtree::e_arr );
+  unsigned num = 0;
+  bool is_ok = true;
+  for( uint32_t tok = jt.get_first( 1 ); tok; tok = jt.get_next( tok ) ) {
+    str name = jt.get_str( jt.find_val( tok, "name" ) );
+    uint32_t args = jt.find_val( tok, "args" );
+    if ( num == 1 ) {
+      is_ok = is_ok && name == "update" &&
+        jt.get_str( jt.find_val( args, "symbol" ) ) == "BTC/USD" &&
+        jt.get_bool( jt.find_val( args, "complete" ) );
+    } else if ( num == 5 ) {
+      is_ok = is_ok && name == "confirm" &&
+        jt.get_str( jt.find_val( tok, "dur" ) ) == "0.300";
+    } else if ( num == 7 ) {
+      is_ok = is_ok && name == "update" &&
+        !jt.get_bool( jt.find_val( args, "complete" ) );
+    }
+    ++num;
+  }
+  PC_TEST_CHECK( is_ok && num == 9 );
+  ::unlink( file.c_str() );
+}
+
 int main(int,char**)
 {
   PC_TEST_START
   test_key();
+  test_base58();
   test_log();
+  test_log_limit();
   test_request_sub();
+  test_jtree();
+  test_zstd_dict();
+  test_program_filter();
+  test_upd_price_tmpl();
+  test_account_source();
+  test_multiple_accounts();
+  test_acc_poll();
+  test_rpc_stats();
+  test_prio_fee();
+  test_land_track();
+  test_upd_price_size();
+  test_lat_hist();
+  test_metrics_wtr();
+  test_upd_queue();
+  test_upd_queue_full();
+  test_snapshot();
+  test_open_hash_map();
+  test_pythnet_account();
+  test_price_arena();
+  test_huge_page();
+  test_price_view();
+  test_aggregate();
+  test_send_ref();
+  test_shm_feed();
+  test_mcast_pub();
+  test_product_json();
+  test_attr_dict();
+  test_dash_notify();
+  test_cap_filter();
+  test_capture();
+  test_capture_blocks();
+  test_capture_rotate();
+  test_col_file();
+  test_upd_trace();
   PC_TEST_END
   return 0;
 }
@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Comparators of a Batcher odd-even merge sorting network for a power
+   of two size.  A network for any smaller n is the same network with
+   the comparators that touch an index at or beyond n removed (think of
+   the missing keys as +inf, which never move). */
+
+static int  ce_cnt;
+static int  ce_i[ 1024 ];
+static int  ce_j[ 1024 ];
+
+static void
+ce_add( int i,
+        int j ) {
+  ce_i[ ce_cnt ] = i;
+  ce_j[ ce_cnt ] = j;
+  ce_cnt++;
+}
+
+/* Merge the keys lo, lo+r, lo+2r, ... of the two sorted halves of
+   [lo,lo+n) */
+
+static void
+merge_gen( int lo,
+           int n,
+           int r ) {
+  int m = r*2;
+  if( m<n ) {
+    merge_gen( lo,   n, m );
+    merge_gen( lo+r, n, m );
+    for( int i=lo+r; i+r<lo+n; i+=m ) ce_add( i, i+r );
+  } else {
+    ce_add( lo, lo+r );
+  }
+}
+
+static void
+sort_gen( int lo,
+          int n ) {
+  if( n>1 ) {
+    int m = n/2;
+    sort_gen( lo,   m );
+    sort_gen( lo+m, m );
+    merge_gen( lo, n, 1 );
+  }
+}
+
+void
+network_gen( int n ) {
+
+  /* Comparators for sizes [0,n] are laid out back to back such that
+     the network for size k is entries [off[k],off[k+1]).  Size k uses
+     the network for the smallest power of two at least k (larger ones
+     would only add redundant comparators). */
+
+  static int out_i[ 32768 ];
+  static int out_j[ 32768 ];
+  int off[ 66 ];
+  int tot = 0;
+  for( int k=0; k<=n; k++ ) {
+    int p = 1; while( p<k ) p *= 2;
+    ce_cnt = 0;
+    sort_gen( 0, p );
+    off[ k ] = tot;
+    for( int c=0; c<ce_cnt; c++ )
+      if( ce_j[ c ]<k ) { out_i[ tot ] = ce_i[ c ]; out_j[ tot ] = ce_j[ c ]; tot++; }
+  }
+  off[ n+1 ] = tot;
+
+  printf( "/* BEGIN AUTOGENERATED CODE (n=%2i) ***********************************/\n", n );
+  printf( "/* Batcher odd-even merge sorting networks for sizes [0,%i] (%i\n", n, tot );
+  printf( "   comparators total).  The network for size k is the comparators\n" );
+  printf( "   (sort_network_ce[2*c],sort_network_ce[2*c+1]) for c in\n" );
+  printf( "   [sort_network_off[k],sort_network_off[k+1]).  These do not depend\n" );
+  printf( "   on the key type and are shared by all sort instantiations. */\n" );
+  printf( "#ifndef SORT_NETWORK_MAX\n" );
+  printf( "#define SORT_NETWORK_MAX %i\n", n );
+  printf( "static uint16_t const sort_network_off[ %i ] = {", n+2 );
+  for( int k=0; k<=n+1; k++ ) printf( "%s%4i", !k ? "\n  " : (k%12) ? "," : ",\n  ", off[ k ] );
+  printf( "\n};\n" );
+  printf( "static uint8_t const sort_network_ce[ %i ] = {", 2*tot );
+  for( int c=0; c<tot; c++ ) printf( "%s%2i,%2i", !c ? "\n  " : (c%12) ? ", " : ",\n  ", out_i[ c ], out_j[ c ] );
+  printf( "\n};\n" );
+  printf( "#endif\n" );
+  printf( "/* END AUTOGENERATED CODE *********************************************/\n" );
+}
+
+int
+main( int     argc,
+      char ** argv ) {
+  if( argc!=2 ) { fprintf( stderr, "Usage: %s [max_network]\n", argv[0] ); return 1; }
+  int n = atoi( argv[1] );
+  if( n<1 || n>64 ) { fprintf( stderr, "n (%i) must be in [1,64]\n", n ); return 1; }
+  network_gen( n );
+  return 0;
+}
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include "../util/util.h"
+
+#define SORT_NAME  net
+#define SORT_KEY_T int
+#define SORT_IDX_T int
+#include "tmpl/sort_network.c"
+
+#define SORT_NAME         net
+#define SORT_KEY_T        int
+#define SORT_IDX_T        int
+#define SORT_NETWORK_BASE 1
+#include "tmpl/sort_stable.c"
+
+#define SORT_NAME  ref
+#define SORT_KEY_T int
+#define SORT_IDX_T int
+#include "tmpl/sort_stable.c"
+
+int test_sort_network() {
+
+# define N 192 /* 3*PC_NUM_COMP, the most quotes upd_aggregate sorts */
+  int x[N];
+  int y[N];
+  int t[N];
+  int s[N];
+
+  if( !net_network_cnt_valid( SORT_NETWORK_MAX ) || net_network_cnt_valid( SORT_NETWORK_MAX+1 ) ) {
+    printf( "FAIL (cnt_valid)\n" );
+    return 1;
+  }
+
+  /* Brute force validate the networks for small sizes via the 0-1
+     principle */
+
+  for( int n=0; n<=20; n++ ) {
+    for( long b=0L; b<(1L<<n); b++ ) {
+      int ones = 0;
+      for( int i=0; i<n; i++ ) { x[i] = (int)((b>>i) & 1L); ones += x[i]; }
+      if( net_network( x,n )!=x ) { printf( "FAIL (network return)\n" ); return 1; }
+      for( int i=0; i<n; i++ )
+        if( x[i]!=(i>=n-ones) ) { printf( "FAIL (network 0-1, n=%i, b=%lx)\n", n, b ); return 1; }
+    }
+  }
+
+  /* Randomized validation against sort_stable for all network sizes
+     and for network based cases over the sizes the price model sees.
+     Keys have a small range to exercise ties. */
+
+  prng_t _prng[1];
+  prng_t * prng = prng_join( prng_new( _prng, (uint32_t)0, (uint64_t)0 ) );
+
+  for( int iter=0; iter<1000000; iter++ ) {
+
+    int n = (int)(prng_uint32( prng ) % (uint32_t)(N+1)); /* In [0,N], approx uniform IID */
+    int m = (int)(prng_uint32( prng ) & (uint32_t)0xff) + 1;
+    for( int i=0; i<n; i++ ) x[i] = (int)(prng_uint32( prng ) % (uint32_t)m) - m/2;
+    for( int i=0; i<n; i++ ) y[i] = x[i];
+
+    int * z = ref_stable( y,n, s );
+
+    if( n<=SORT_NETWORK_MAX ) {
+      for( int i=0; i<n; i++ ) t[i] = x[i];
+      net_network( t,n );
+      for( int i=0; i<n; i++ ) if( t[i]!=z[i] ) { printf( "FAIL (network, n=%i)\n", n ); return 1; }
+    }
+
+    int * w = net_stable( x,n, t );
+    for( int i=0; i<n; i++ ) if( w[i]!=z[i] ) { printf( "FAIL (hybrid, n=%i)\n", n ); return 1; }
+  }
+
+# undef N
+
+  prng_delete( prng_leave( prng ) );
+  return 0;
+}
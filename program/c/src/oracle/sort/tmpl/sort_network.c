@@ -0,0 +1,97 @@
+/* Usage:
+
+     #define SORT_NAME  mysort
+     #define SORT_KEY_T mykey_t
+     #include "sort_network.c"
+
+   This will instantiate the following APIs:
+
+      // Returns non-zero if cnt is a size the networks handle (i.e. at
+      // most SORT_NETWORK_MAX) and zero if not.
+
+      static inline int
+      mysort_network_cnt_valid( uint64_t cnt );
+
+      // Sort elements of keys into an ascending order in place with a
+      // Batcher odd-even merge sorting network.  The sequence of
+      // compares and (conditional) moves only depends on cnt such that
+      // the cost is deterministic and branch free in the keys.  This is
+      // faster than mysort_stable (see sort_stable.c) for the small cnt
+      // it supports.  The sort is NOT stable (this only matters if keys
+      // that compare equal can be told apart).  Returns key.
+
+      static mykey_t *
+      mysort_network( mykey_t * key,   // Indexed [0,n)
+                      uint64_t  cnt ); // Assumes mysort_network_cnt_valid( cnt ) is true
+
+   The comparator tables are in sort_network_base.c (generated by
+   ../sort_network_gen.c) and shared between instantiations.  Other
+   defines are as for sort_stable.c. */
+
+#include "../../util/compat_stdint.h" /* For uint64_t */
+
+#ifndef SORT_NAME
+#error "Define SORT_NAME"
+#endif
+
+#ifndef SORT_KEY_T
+#error "Define SORT_KEY_T; nominally a POD (plain-old-data) type"
+#endif
+
+#ifndef SORT_IDX_T
+#define SORT_IDX_T uint64_t
+#endif
+
+#ifndef SORT_BEFORE
+#define SORT_BEFORE(u,v) ((u)<(v))
+#endif
+
+#ifndef SORT_STATIC
+#define SORT_STATIC static
+#endif
+
+#ifndef SORT_STATIC_INLINE
+#define SORT_STATIC_INLINE static inline
+#endif
+
+#include "sort_network_base.c"
+
+/* Some macro preprocessor helpers */
+
+#define SORT_C3(a,b,c)a##b##c
+#define SORT_XC3(a,b,c)SORT_C3(a,b,c)
+#define SORT_IMPL(impl)SORT_XC3(SORT_NAME,_,impl)
+
+SORT_STATIC_INLINE int
+SORT_IMPL(network_cnt_valid)( SORT_IDX_T cnt ) {
+  /* See stable_cnt_valid for why this is written this way */
+  return !cnt || (((SORT_IDX_T)0)<cnt && ((uint64_t)cnt)<=(uint64_t)SORT_NETWORK_MAX);
+}
+
+SORT_STATIC SORT_KEY_T *
+SORT_IMPL(network)( SORT_KEY_T * x,
+                    SORT_IDX_T   n ) {
+  uint8_t const * ce     = sort_network_ce + 2*sort_network_off[ n ];
+  uint8_t const * ce_end = sort_network_ce + 2*sort_network_off[ n+(SORT_IDX_T)1 ];
+  for( ; ce<ce_end; ce+=2 ) {
+    SORT_IDX_T i = (SORT_IDX_T)ce[0];
+    SORT_IDX_T j = (SORT_IDX_T)ce[1];
+    SORT_KEY_T u = x[i];
+    SORT_KEY_T v = x[j];
+    int        c = SORT_BEFORE( v, u );
+    x[i] = c ? v : u;
+    x[j] = c ? u : v;
+  }
+  return x;
+}
+
+#undef SORT_IMPL
+#undef SORT_XC3
+#undef SORT_C3
+
+#undef SORT_STATIC_INLINE
+#undef SORT_STATIC
+#undef SORT_BEFORE
+#undef SORT_IDX_T
+#undef SORT_KEY_T
+#undef SORT_NAME
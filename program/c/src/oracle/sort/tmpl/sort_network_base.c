@@ -0,0 +1,236 @@
+/* BEGIN AUTOGENERATED CODE (n=32) ***********************************/
+/* Batcher odd-even merge sorting networks for sizes [0,32] (2625
+   comparators total).  The network for size k is the comparators
+   (sort_network_ce[2*c],sort_network_ce[2*c+1]) for c in
+   [sort_network_off[k],sort_network_off[k+1]).  These do not depend
+   on the key type and are shared by all sort instantiations. */
+#ifndef SORT_NETWORK_MAX
+#define SORT_NETWORK_MAX 32
+static uint16_t const sort_network_off[ 34 ] = {
+     0,   0,   0,   1,   4,   9,  18,  30,  46,  65,  93, 125,
+   163, 205, 253, 306, 365, 428, 513, 603, 701, 804, 916,1035,
+  1162,1294,1434,1581,1737,1899,2070,2248,2434,2625
+};
+static uint8_t const sort_network_ce[ 5250 ] = {
+   0, 1,  0, 1,  0, 2,  1, 2,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  0, 1,  2, 3,  0, 2,
+   1, 3,  1, 2,  0, 4,  2, 4,  1, 2,  3, 4,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,
+   0, 4,  2, 4,  1, 5,  3, 5,  1, 2,  3, 4,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,
+   4, 6,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 5,  1, 2,  3, 4,  5, 6,  0, 1,  2, 3,
+   0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,
+   3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,
+   4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,
+   0, 8,  4, 8,  2, 4,  6, 8,  3, 5,  1, 2,  3, 4,  5, 6,  7, 8,  0, 1,  2, 3,  0, 2,
+   1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,
+   3, 5,  1, 2,  3, 4,  5, 6,  8, 9,  0, 8,  4, 8,  2, 4,  6, 8,  1, 9,  5, 9,  3, 5,
+   7, 9,  1, 2,  3, 4,  5, 6,  7, 8,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,
+   4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,
+   8, 9,  8,10,  9,10,  9,10,  0, 8,  4, 8,  2,10,  6,10,  2, 4,  6, 8,  1, 9,  5, 9,
+   3, 5,  7, 9,  1, 2,  3, 4,  5, 6,  7, 8,  9,10,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,
+   4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,
+   3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10,  9,10,  0, 8,  4, 8,  2,10,  6,10,
+   2, 4,  6, 8,  1, 9,  5, 9,  3,11,  7,11,  3, 5,  7, 9,  1, 2,  3, 4,  5, 6,  7, 8,
+   9,10,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,
+   2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,
+   9,10,  8,12, 10,12,  9,10, 11,12,  0, 8,  4,12,  4, 8,  2,10,  6,10,  2, 4,  6, 8,
+  10,12,  1, 9,  5, 9,  3,11,  7,11,  3, 5,  7, 9,  1, 2,  3, 4,  5, 6,  7, 8,  9,10,
+  11,12,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,
+   2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,
+   9,10, 12,13,  8,12, 10,12,  9,13, 11,13,  9,10, 11,12,  0, 8,  4,12,  4, 8,  2,10,
+   6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,11,  3, 5,  7, 9, 11,13,
+   1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,
+   6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,
+   5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 12,14, 13,14,  8,12, 10,14, 10,12,
+   9,13, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,
+   6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,11,  3, 5,  7, 9, 11,13,  1, 2,  3, 4,
+   5, 6,  7, 8,  9,10, 11,12, 13,14,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,
+   4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,
+   8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15, 12,14, 13,15, 13,14,  8,12, 10,14,
+  10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,  6,14,
+   6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,15,  7,11,  3, 5,  7, 9,
+  11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14,  0, 1,  2, 3,  0, 2,  1, 3,
+   1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,
+   1, 2,  3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15, 12,14, 13,15,
+  13,14,  8,12, 10,14, 10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,
+   4, 8,  2,10,  6,14,  6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,15,
+   7,11,  3, 5,  7, 9, 11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14,  0,16,
+   8,16,  4, 8, 12,16,  6,10,  2, 4,  6, 8, 10,12, 14,16,  5, 9,  7,11,  3, 5,  7, 9,
+  11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 15,16,  0, 1,  2, 3,  0, 2,
+   1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,
+   3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15, 12,14,
+  13,15, 13,14,  8,12, 10,14, 10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,
+   4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,
+   7,15,  7,11,  3, 5,  7, 9, 11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14,
+  16,17,  0,16,  8,16,  4, 8, 12,16,  6,10,  2, 4,  6, 8, 10,12, 14,16,  1,17,  9,17,
+   5, 9, 13,17,  7,11,  3, 5,  7, 9, 11,13, 15,17,  1, 2,  3, 4,  5, 6,  7, 8,  9,10,
+  11,12, 13,14, 15,16,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,
+   5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,
+   8,10,  9,11,  9,10, 12,13, 14,15, 12,14, 13,15, 13,14,  8,12, 10,14, 10,12,  9,13,
+  11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,
+   6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,15,  7,11,  3, 5,  7, 9, 11,13,  1, 2,
+   3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 16,17, 16,18, 17,18, 17,18, 17,18,  0,16,
+   8,16,  4, 8, 12,16,  2,18, 10,18,  6,10, 14,18,  2, 4,  6, 8, 10,12, 14,16,  1,17,
+   9,17,  5, 9, 13,17,  7,11,  3, 5,  7, 9, 11,13, 15,17,  1, 2,  3, 4,  5, 6,  7, 8,
+   9,10, 11,12, 13,14, 15,16, 17,18,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,
+   4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,
+   8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15, 12,14, 13,15, 13,14,  8,12, 10,14,
+  10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,  6,14,
+   6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,15,  7,11,  3, 5,  7, 9,
+  11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 16,17, 18,19, 16,18, 17,19,
+  17,18, 17,18, 17,18,  0,16,  8,16,  4, 8, 12,16,  2,18, 10,18,  6,10, 14,18,  2, 4,
+   6, 8, 10,12, 14,16,  1,17,  9,17,  5, 9, 13,17,  3,19, 11,19,  7,11, 15,19,  3, 5,
+   7, 9, 11,13, 15,17,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 15,16, 17,18,
+   0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,
+   2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10,
+  12,13, 14,15, 12,14, 13,15, 13,14,  8,12, 10,14, 10,12,  9,13, 11,15, 11,13,  9,10,
+  11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,  6, 8, 10,12,  1, 9,
+   5,13,  5, 9,  3,11,  7,15,  7,11,  3, 5,  7, 9, 11,13,  1, 2,  3, 4,  5, 6,  7, 8,
+   9,10, 11,12, 13,14, 16,17, 18,19, 16,18, 17,19, 17,18, 16,20, 18,20, 17,18, 19,20,
+  18,20, 17,18, 19,20,  0,16,  8,16,  4,20, 12,20,  4, 8, 12,16,  2,18, 10,18,  6,10,
+  14,18,  2, 4,  6, 8, 10,12, 14,16, 18,20,  1,17,  9,17,  5, 9, 13,17,  3,19, 11,19,
+   7,11, 15,19,  3, 5,  7, 9, 11,13, 15,17,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12,
+  13,14, 15,16, 17,18, 19,20,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,
+   5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9,
+  10,11,  8,10,  9,11,  9,10, 12,13, 14,15, 12,14, 13,15, 13,14,  8,12, 10,14, 10,12,
+   9,13, 11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,  6,14,  6,10,
+   2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,15,  7,11,  3, 5,  7, 9, 11,13,
+   1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 16,17, 18,19, 16,18, 17,19, 17,18,
+  20,21, 16,20, 18,20, 17,21, 19,21, 17,18, 19,20, 18,20, 19,21, 17,18, 19,20,  0,16,
+   8,16,  4,20, 12,20,  4, 8, 12,16,  2,18, 10,18,  6,10, 14,18,  2, 4,  6, 8, 10,12,
+  14,16, 18,20,  1,17,  9,17,  5,21, 13,21,  5, 9, 13,17,  3,19, 11,19,  7,11, 15,19,
+   3, 5,  7, 9, 11,13, 15,17, 19,21,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14,
+  15,16, 17,18, 19,20,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,
+   5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,
+   8,10,  9,11,  9,10, 12,13, 14,15, 12,14, 13,15, 13,14,  8,12, 10,14, 10,12,  9,13,
+  11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,
+   6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,15,  7,11,  3, 5,  7, 9, 11,13,  1, 2,
+   3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 16,17, 18,19, 16,18, 17,19, 17,18, 20,21,
+  20,22, 21,22, 16,20, 18,22, 18,20, 17,21, 19,21, 17,18, 19,20, 21,22, 18,20, 19,21,
+  17,18, 19,20, 21,22,  0,16,  8,16,  4,20, 12,20,  4, 8, 12,16,  2,18, 10,18,  6,22,
+  14,22,  6,10, 14,18,  2, 4,  6, 8, 10,12, 14,16, 18,20,  1,17,  9,17,  5,21, 13,21,
+   5, 9, 13,17,  3,19, 11,19,  7,11, 15,19,  3, 5,  7, 9, 11,13, 15,17, 19,21,  1, 2,
+   3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 15,16, 17,18, 19,20, 21,22,  0, 1,  2, 3,
+   0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,
+   3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15,
+  12,14, 13,15, 13,14,  8,12, 10,14, 10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,
+   0, 8,  4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,
+   3,11,  7,15,  7,11,  3, 5,  7, 9, 11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12,
+  13,14, 16,17, 18,19, 16,18, 17,19, 17,18, 20,21, 22,23, 20,22, 21,23, 21,22, 16,20,
+  18,22, 18,20, 17,21, 19,23, 19,21, 17,18, 19,20, 21,22, 18,20, 19,21, 17,18, 19,20,
+  21,22,  0,16,  8,16,  4,20, 12,20,  4, 8, 12,16,  2,18, 10,18,  6,22, 14,22,  6,10,
+  14,18,  2, 4,  6, 8, 10,12, 14,16, 18,20,  1,17,  9,17,  5,21, 13,21,  5, 9, 13,17,
+   3,19, 11,19,  7,23, 15,23,  7,11, 15,19,  3, 5,  7, 9, 11,13, 15,17, 19,21,  1, 2,
+   3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 15,16, 17,18, 19,20, 21,22,  0, 1,  2, 3,
+   0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,
+   3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15,
+  12,14, 13,15, 13,14,  8,12, 10,14, 10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,
+   0, 8,  4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,
+   3,11,  7,15,  7,11,  3, 5,  7, 9, 11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12,
+  13,14, 16,17, 18,19, 16,18, 17,19, 17,18, 20,21, 22,23, 20,22, 21,23, 21,22, 16,20,
+  18,22, 18,20, 17,21, 19,23, 19,21, 17,18, 19,20, 21,22, 16,24, 20,24, 18,20, 22,24,
+  19,21, 17,18, 19,20, 21,22, 23,24,  0,16,  8,24,  8,16,  4,20, 12,20,  4, 8, 12,16,
+  20,24,  2,18, 10,18,  6,22, 14,22,  6,10, 14,18,  2, 4,  6, 8, 10,12, 14,16, 18,20,
+  22,24,  1,17,  9,17,  5,21, 13,21,  5, 9, 13,17,  3,19, 11,19,  7,23, 15,23,  7,11,
+  15,19,  3, 5,  7, 9, 11,13, 15,17, 19,21,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12,
+  13,14, 15,16, 17,18, 19,20, 21,22, 23,24,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,
+   6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,
+   5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15, 12,14, 13,15, 13,14,  8,12,
+  10,14, 10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,
+   6,14,  6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,15,  7,11,  3, 5,
+   7, 9, 11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 16,17, 18,19, 16,18,
+  17,19, 17,18, 20,21, 22,23, 20,22, 21,23, 21,22, 16,20, 18,22, 18,20, 17,21, 19,23,
+  19,21, 17,18, 19,20, 21,22, 24,25, 16,24, 20,24, 18,20, 22,24, 17,25, 21,25, 19,21,
+  23,25, 17,18, 19,20, 21,22, 23,24,  0,16,  8,24,  8,16,  4,20, 12,20,  4, 8, 12,16,
+  20,24,  2,18, 10,18,  6,22, 14,22,  6,10, 14,18,  2, 4,  6, 8, 10,12, 14,16, 18,20,
+  22,24,  1,17,  9,25,  9,17,  5,21, 13,21,  5, 9, 13,17, 21,25,  3,19, 11,19,  7,23,
+  15,23,  7,11, 15,19,  3, 5,  7, 9, 11,13, 15,17, 19,21, 23,25,  1, 2,  3, 4,  5, 6,
+   7, 8,  9,10, 11,12, 13,14, 15,16, 17,18, 19,20, 21,22, 23,24,  0, 1,  2, 3,  0, 2,
+   1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,
+   3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15, 12,14,
+  13,15, 13,14,  8,12, 10,14, 10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,
+   4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,
+   7,15,  7,11,  3, 5,  7, 9, 11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14,
+  16,17, 18,19, 16,18, 17,19, 17,18, 20,21, 22,23, 20,22, 21,23, 21,22, 16,20, 18,22,
+  18,20, 17,21, 19,23, 19,21, 17,18, 19,20, 21,22, 24,25, 24,26, 25,26, 25,26, 16,24,
+  20,24, 18,26, 22,26, 18,20, 22,24, 17,25, 21,25, 19,21, 23,25, 17,18, 19,20, 21,22,
+  23,24, 25,26,  0,16,  8,24,  8,16,  4,20, 12,20,  4, 8, 12,16, 20,24,  2,18, 10,26,
+  10,18,  6,22, 14,22,  6,10, 14,18, 22,26,  2, 4,  6, 8, 10,12, 14,16, 18,20, 22,24,
+   1,17,  9,25,  9,17,  5,21, 13,21,  5, 9, 13,17, 21,25,  3,19, 11,19,  7,23, 15,23,
+   7,11, 15,19,  3, 5,  7, 9, 11,13, 15,17, 19,21, 23,25,  1, 2,  3, 4,  5, 6,  7, 8,
+   9,10, 11,12, 13,14, 15,16, 17,18, 19,20, 21,22, 23,24, 25,26,  0, 1,  2, 3,  0, 2,
+   1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,
+   3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15, 12,14,
+  13,15, 13,14,  8,12, 10,14, 10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,
+   4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,
+   7,15,  7,11,  3, 5,  7, 9, 11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14,
+  16,17, 18,19, 16,18, 17,19, 17,18, 20,21, 22,23, 20,22, 21,23, 21,22, 16,20, 18,22,
+  18,20, 17,21, 19,23, 19,21, 17,18, 19,20, 21,22, 24,25, 26,27, 24,26, 25,27, 25,26,
+  25,26, 16,24, 20,24, 18,26, 22,26, 18,20, 22,24, 17,25, 21,25, 19,27, 23,27, 19,21,
+  23,25, 17,18, 19,20, 21,22, 23,24, 25,26,  0,16,  8,24,  8,16,  4,20, 12,20,  4, 8,
+  12,16, 20,24,  2,18, 10,26, 10,18,  6,22, 14,22,  6,10, 14,18, 22,26,  2, 4,  6, 8,
+  10,12, 14,16, 18,20, 22,24,  1,17,  9,25,  9,17,  5,21, 13,21,  5, 9, 13,17, 21,25,
+   3,19, 11,27, 11,19,  7,23, 15,23,  7,11, 15,19, 23,27,  3, 5,  7, 9, 11,13, 15,17,
+  19,21, 23,25,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 15,16, 17,18, 19,20,
+  21,22, 23,24, 25,26,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,
+   5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,
+   8,10,  9,11,  9,10, 12,13, 14,15, 12,14, 13,15, 13,14,  8,12, 10,14, 10,12,  9,13,
+  11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,
+   6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,15,  7,11,  3, 5,  7, 9, 11,13,  1, 2,
+   3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 16,17, 18,19, 16,18, 17,19, 17,18, 20,21,
+  22,23, 20,22, 21,23, 21,22, 16,20, 18,22, 18,20, 17,21, 19,23, 19,21, 17,18, 19,20,
+  21,22, 24,25, 26,27, 24,26, 25,27, 25,26, 24,28, 26,28, 25,26, 27,28, 16,24, 20,28,
+  20,24, 18,26, 22,26, 18,20, 22,24, 26,28, 17,25, 21,25, 19,27, 23,27, 19,21, 23,25,
+  17,18, 19,20, 21,22, 23,24, 25,26, 27,28,  0,16,  8,24,  8,16,  4,20, 12,28, 12,20,
+   4, 8, 12,16, 20,24,  2,18, 10,26, 10,18,  6,22, 14,22,  6,10, 14,18, 22,26,  2, 4,
+   6, 8, 10,12, 14,16, 18,20, 22,24, 26,28,  1,17,  9,25,  9,17,  5,21, 13,21,  5, 9,
+  13,17, 21,25,  3,19, 11,27, 11,19,  7,23, 15,23,  7,11, 15,19, 23,27,  3, 5,  7, 9,
+  11,13, 15,17, 19,21, 23,25,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 15,16,
+  17,18, 19,20, 21,22, 23,24, 25,26, 27,28,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,
+   6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,
+   5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15, 12,14, 13,15, 13,14,  8,12,
+  10,14, 10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,
+   6,14,  6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,15,  7,11,  3, 5,
+   7, 9, 11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 16,17, 18,19, 16,18,
+  17,19, 17,18, 20,21, 22,23, 20,22, 21,23, 21,22, 16,20, 18,22, 18,20, 17,21, 19,23,
+  19,21, 17,18, 19,20, 21,22, 24,25, 26,27, 24,26, 25,27, 25,26, 28,29, 24,28, 26,28,
+  25,29, 27,29, 25,26, 27,28, 16,24, 20,28, 20,24, 18,26, 22,26, 18,20, 22,24, 26,28,
+  17,25, 21,29, 21,25, 19,27, 23,27, 19,21, 23,25, 27,29, 17,18, 19,20, 21,22, 23,24,
+  25,26, 27,28,  0,16,  8,24,  8,16,  4,20, 12,28, 12,20,  4, 8, 12,16, 20,24,  2,18,
+  10,26, 10,18,  6,22, 14,22,  6,10, 14,18, 22,26,  2, 4,  6, 8, 10,12, 14,16, 18,20,
+  22,24, 26,28,  1,17,  9,25,  9,17,  5,21, 13,29, 13,21,  5, 9, 13,17, 21,25,  3,19,
+  11,27, 11,19,  7,23, 15,23,  7,11, 15,19, 23,27,  3, 5,  7, 9, 11,13, 15,17, 19,21,
+  23,25, 27,29,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 15,16, 17,18, 19,20,
+  21,22, 23,24, 25,26, 27,28,  0, 1,  2, 3,  0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,
+   5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,  3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9,
+  10,11,  8,10,  9,11,  9,10, 12,13, 14,15, 12,14, 13,15, 13,14,  8,12, 10,14, 10,12,
+   9,13, 11,15, 11,13,  9,10, 11,12, 13,14,  0, 8,  4,12,  4, 8,  2,10,  6,14,  6,10,
+   2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,  3,11,  7,15,  7,11,  3, 5,  7, 9, 11,13,
+   1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12, 13,14, 16,17, 18,19, 16,18, 17,19, 17,18,
+  20,21, 22,23, 20,22, 21,23, 21,22, 16,20, 18,22, 18,20, 17,21, 19,23, 19,21, 17,18,
+  19,20, 21,22, 24,25, 26,27, 24,26, 25,27, 25,26, 28,29, 28,30, 29,30, 24,28, 26,30,
+  26,28, 25,29, 27,29, 25,26, 27,28, 29,30, 16,24, 20,28, 20,24, 18,26, 22,30, 22,26,
+  18,20, 22,24, 26,28, 17,25, 21,29, 21,25, 19,27, 23,27, 19,21, 23,25, 27,29, 17,18,
+  19,20, 21,22, 23,24, 25,26, 27,28, 29,30,  0,16,  8,24,  8,16,  4,20, 12,28, 12,20,
+   4, 8, 12,16, 20,24,  2,18, 10,26, 10,18,  6,22, 14,30, 14,22,  6,10, 14,18, 22,26,
+   2, 4,  6, 8, 10,12, 14,16, 18,20, 22,24, 26,28,  1,17,  9,25,  9,17,  5,21, 13,29,
+  13,21,  5, 9, 13,17, 21,25,  3,19, 11,27, 11,19,  7,23, 15,23,  7,11, 15,19, 23,27,
+   3, 5,  7, 9, 11,13, 15,17, 19,21, 23,25, 27,29,  1, 2,  3, 4,  5, 6,  7, 8,  9,10,
+  11,12, 13,14, 15,16, 17,18, 19,20, 21,22, 23,24, 25,26, 27,28, 29,30,  0, 1,  2, 3,
+   0, 2,  1, 3,  1, 2,  4, 5,  6, 7,  4, 6,  5, 7,  5, 6,  0, 4,  2, 6,  2, 4,  1, 5,
+   3, 7,  3, 5,  1, 2,  3, 4,  5, 6,  8, 9, 10,11,  8,10,  9,11,  9,10, 12,13, 14,15,
+  12,14, 13,15, 13,14,  8,12, 10,14, 10,12,  9,13, 11,15, 11,13,  9,10, 11,12, 13,14,
+   0, 8,  4,12,  4, 8,  2,10,  6,14,  6,10,  2, 4,  6, 8, 10,12,  1, 9,  5,13,  5, 9,
+   3,11,  7,15,  7,11,  3, 5,  7, 9, 11,13,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12,
+  13,14, 16,17, 18,19, 16,18, 17,19, 17,18, 20,21, 22,23, 20,22, 21,23, 21,22, 16,20,
+  18,22, 18,20, 17,21, 19,23, 19,21, 17,18, 19,20, 21,22, 24,25, 26,27, 24,26, 25,27,
+  25,26, 28,29, 30,31, 28,30, 29,31, 29,30, 24,28, 26,30, 26,28, 25,29, 27,31, 27,29,
+  25,26, 27,28, 29,30, 16,24, 20,28, 20,24, 18,26, 22,30, 22,26, 18,20, 22,24, 26,28,
+  17,25, 21,29, 21,25, 19,27, 23,31, 23,27, 19,21, 23,25, 27,29, 17,18, 19,20, 21,22,
+  23,24, 25,26, 27,28, 29,30,  0,16,  8,24,  8,16,  4,20, 12,28, 12,20,  4, 8, 12,16,
+  20,24,  2,18, 10,26, 10,18,  6,22, 14,30, 14,22,  6,10, 14,18, 22,26,  2, 4,  6, 8,
+  10,12, 14,16, 18,20, 22,24, 26,28,  1,17,  9,25,  9,17,  5,21, 13,29, 13,21,  5, 9,
+  13,17, 21,25,  3,19, 11,27, 11,19,  7,23, 15,31, 15,23,  7,11, 15,19, 23,27,  3, 5,
+   7, 9, 11,13, 15,17, 19,21, 23,25, 27,29,  1, 2,  3, 4,  5, 6,  7, 8,  9,10, 11,12,
+  13,14, 15,16, 17,18, 19,20, 21,22, 23,24, 25,26, 27,28, 29,30
+};
+#endif
+/* END AUTOGENERATED CODE *********************************************/
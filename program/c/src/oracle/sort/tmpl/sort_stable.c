@@ -100,6 +100,18 @@
 #define SORT_STATIC_INLINE static inline
 #endif
 
+/* Define SORT_NETWORK_BASE to non-zero to sort nodes of at most
+   SORT_NETWORK_MAX keys (beyond the unrolled base cases) with
+   mysort_network (include sort_network.c with the same SORT_NAME
+   beforehand).  This is faster for moderate n but gives up stability,
+   so it is only suitable when keys that compare equal are
+   indistinguishable (e.g. plain integer keys with the default
+   SORT_BEFORE).  Default is 0. */
+
+#ifndef SORT_NETWORK_BASE
+#define SORT_NETWORK_BASE 0
+#endif
+
 /* Some macro preprocessor helpers */
 
 #define SORT_C3(a,b,c)a##b##c
@@ -133,6 +145,13 @@ SORT_IMPL(stable_node)( SORT_KEY_T * x,
 
 # include "sort_stable_base.c"
 
+  /* The unrolled base cases above are cheaper than a network for the
+     smallest n */
+
+# if SORT_NETWORK_BASE
+  if( ((uint64_t)n)<=(uint64_t)SORT_NETWORK_MAX ) return SORT_IMPL(network)( x, n );
+# endif
+
   /* Note that n is at least 2 at this point */
   /* Break input into approximately equal halves and sort them */
 
@@ -187,6 +206,7 @@ SORT_IMPL(stable)( SORT_KEY_T * key,
 #undef SORT_XC3
 #undef SORT_C3
 
+#undef SORT_NETWORK_BASE
 #undef SORT_STATIC_INLINE
 #undef SORT_STATIC
 #undef SORT_BEFORE
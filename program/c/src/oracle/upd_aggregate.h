@@ -155,26 +155,31 @@ static inline bool upd_aggregate( pc_price_t *ptr, uint64_t slot, int64_t timest
     uint32_t numv  = 0;
     uint32_t nprcs = (uint32_t)0;
     int64_t  prcs[ PC_NUM_COMP * 3 ]; // ~0.75KiB for current PC_NUM_COMP (FIXME: DOUBLE CHECK THIS FITS INTO STACK FRAME LIMIT)
+    int64_t max_latency = ptr->max_latency_ ? ptr->max_latency_ : PC_MAX_SEND_LATENCY;
     for ( uint32_t i = 0; i != ptr->num_; ++i ) {
       pc_price_comp_t *iptr = &ptr->comp_[i];
       // copy contributing price to aggregate snapshot
       iptr->agg_ = iptr->latest_;
-      // add quote to sorted permutation array if it is valid
+      // add quote to sorted permutation array if it is valid. this is
+      // branch free: the quote is always written and only kept if valid.
+      // conf is clamped and price -/+ conf wraps so that invalid quotes
+      // cannot overflow while valid ones get the same values as before
       int64_t slot_diff = ( int64_t )slot - ( int64_t )( iptr->agg_.pub_slot_ );
       int64_t price     = iptr->agg_.price_;
       int64_t conf      = ( int64_t )( iptr->agg_.conf_ );
-      int64_t max_latency = ptr->max_latency_ ? ptr->max_latency_ : PC_MAX_SEND_LATENCY;
-      if ( iptr->agg_.status_ == PC_STATUS_TRADING &&
-           // No overflow for INT64_MIN+conf or INT64_MAX-conf as 0 < conf < INT64_MAX
-           // These checks ensure that price - conf and price + conf do not overflow.
-           (int64_t)0 < conf && (INT64_MIN + conf) <= price && price <= (INT64_MAX-conf) &&
-           // slot_diff is implicitly >= 0 due to the check in Rust code ensuring publishing_slot is always less than or equal to the current slot.
-           slot_diff <= max_latency ) {
-        numv += 1;
-        prcs[ nprcs++ ] = price - conf;
-        prcs[ nprcs++ ] = price;
-        prcs[ nprcs++ ] = price + conf;
-      }
+      int64_t cconf     = conf > 0 ? conf : 0;
+      uint32_t is_valid = (uint32_t)( iptr->agg_.status_ == PC_STATUS_TRADING ) &
+                          (uint32_t)( (int64_t)0 < conf ) &
+                          // No overflow for INT64_MIN+cconf or INT64_MAX-cconf as 0 <= cconf <= INT64_MAX
+                          (uint32_t)( (INT64_MIN + cconf) <= price ) &
+                          (uint32_t)( price <= (INT64_MAX - cconf) ) &
+                          // slot_diff is implicitly >= 0 due to the check in Rust code ensuring publishing_slot is always less than or equal to the current slot.
+                          (uint32_t)( slot_diff <= max_latency );
+      prcs[ nprcs   ] = (int64_t)( (uint64_t)price - (uint64_t)cconf );
+      prcs[ nprcs+1 ] = price;
+      prcs[ nprcs+2 ] = (int64_t)( (uint64_t)price + (uint64_t)cconf );
+      numv  += is_valid;
+      nprcs += is_valid * (uint32_t)3;
     }
 
     // too few valid quotes
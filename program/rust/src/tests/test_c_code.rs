@@ -6,6 +6,7 @@ mod c {
     extern "C" {
         pub fn test_price_model() -> i32;
         pub fn test_sort_stable() -> i32;
+        pub fn test_sort_network() -> i32;
         pub fn test_align() -> i32;
         pub fn test_avg() -> i32;
         pub fn test_hash() -> i32;
@@ -29,6 +30,13 @@ fn test_sort_stable() {
     }
 }
 
+#[test]
+fn test_sort_network() {
+    unsafe {
+        assert_eq!(c::test_sort_network(), 0);
+    }
+}
+
 #[test]
 fn test_align() {
     unsafe {